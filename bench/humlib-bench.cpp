@@ -0,0 +1,769 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 05:25:10 UTC 2026
+// Last Modified: Sat Oct 17 05:25:10 UTC 2026
+// Filename:      bench/humlib-bench.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/bench/humlib-bench.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab nowrap
+//
+// Description:   Benchmarks for humlib, printed as JSON so that results
+//                can be compared between releases.  A synthetic corpus of
+//                four-voice **kern scores with beams, slurs, ties and
+//                chords is generated, then:
+//                   micro benchmarks time parts of the library (reading,
+//                      rhythm/slur/tie/beam analysis, Convert, HumRegex,
+//                      HumNum) over all tokens or files of the corpus;
+//                   macro benchmarks time end-to-end runs of common tools
+//                      (read, run the tool, write the output) on each file.
+//                Each benchmark runs once to warm up and then --repeat
+//                times; the minimum, median and mean times are reported.
+//
+// Usage:         humlib-bench [-n files] [-m measures] [-r repeat]
+//                   [--micro | --macro] [-b regex] [-t "tool opts;..."]
+//                   [--label text] [-o output.json] [--corpus dir]
+//
+
+#include "humlib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace hum;
+using namespace std;
+
+// BenchResult: timings of one benchmark.
+class BenchResult {
+	public:
+		string         name;
+		string         group;      // "micro" or "macro"
+		string         unit;       // what items counts
+		long long      items = 0;  // items processed in each run
+		vector<double> times;      // milliseconds for each run
+		double         checksum = 0.0;
+		string         error;
+};
+
+// Default list of tools for the macro benchmarks:
+static const vector<string> DefaultTools = {
+	"extract -k 1",
+	"transpose -t P5",
+	"autobeam",
+	"autostem",
+	"recip",
+	"mint",
+	"cint",
+	"deg",
+	"metlev",
+	"msearch -p cde",
+	"myank -m 2-8",
+	"barnum",
+	"tie",
+	"timebase -t 16",
+	"composite",
+	"dissonant",
+	"rid -l",
+	"chord",
+	"meter",
+	"synco"
+};
+
+// Rhythms for one beat (four sixteenth notes) of a voice: recip values,
+// durations in sixteenths, and beam markers.
+class BeatPattern {
+	public:
+		vector<string> recip;
+		vector<int>    length;
+		vector<string> beam;
+};
+
+static vector<BeatPattern> BeatPatterns = {
+	{{"4"},                   {4},          {""}},
+	{{"8", "8"},              {2, 2},       {"L", "J"}},
+	{{"8.", "16"},            {3, 1},       {"L", "Jk"}},
+	{{"16", "16", "8"},       {1, 1, 2},    {"LL", "J", "J"}},
+	{{"16", "16", "16", "16"}, {1, 1, 1, 1}, {"LL", "", "", "JJ"}}
+};
+
+// Lowest and highest base-7 pitch of each voice (soprano to bass):
+static const int VoiceRange[4][2] = {{28, 38}, {25, 33}, {21, 30}, {14, 25}};
+
+// Functions:
+string      generateScore      (mt19937& random, int number, int measures);
+string      getKernPitch       (int base7, bool flatb);
+void        runBenchmark       (vector<BenchResult>& results, const string& name,
+                                const string& group, const string& unit,
+                                function<void(void)> setup,
+                                function<long long(double&)> run);
+bool        isSelected         (const string& name);
+void        addMicroBenchmarks (vector<BenchResult>& results, vector<string>& corpus);
+void        addMacroBenchmarks (vector<BenchResult>& results, vector<string>& corpus,
+                                const vector<string>& tools);
+void        printJson          (ostream& out, vector<BenchResult>& results,
+                                vector<string>& corpus);
+string      jsonString         (const string& input);
+double      getMedian          (vector<double> values);
+
+// Options:
+Options options;
+int     Repeat = 5;
+HumRegex Select;
+bool    SelectQ = false;
+
+
+///////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+	options.define("n|files=i:20",      "number of files in synthetic corpus");
+	options.define("m|measures=i:200",  "number of measures in each file");
+	options.define("r|repeat=i:5",      "number of timed runs of each benchmark");
+	options.define("s|seed=i:1",        "random seed for the corpus");
+	options.define("micro=b",           "run only the micro benchmarks");
+	options.define("macro=b",           "run only the macro benchmarks");
+	options.define("b|bench=s",         "regular expression for benchmarks to run");
+	options.define("t|tools=s",         "semicolon-separated tool commands for macro benchmarks");
+	options.define("l|label=s",         "label for the results (such as a version)");
+	options.define("o|output=s",        "file for the JSON results (default stdout)");
+	options.define("corpus=s",          "directory to write the corpus files to");
+	options.process(argc, argv);
+
+	Repeat = max(1, options.getInteger("repeat"));
+	if (options.getBoolean("bench")) {
+		SelectQ = true;
+	}
+
+	mt19937 random(options.getInteger("seed"));
+	vector<string> corpus;
+	for (int i=0; i<options.getInteger("files"); i++) {
+		corpus.push_back(generateScore(random, i + 1, options.getInteger("measures")));
+	}
+	if (options.getBoolean("corpus")) {
+		for (int i=0; i<(int)corpus.size(); i++) {
+			string filename = options.getString("corpus") + "/bench" + to_string(i + 1) + ".krn";
+			ofstream output(filename);
+			output << corpus[i];
+		}
+	}
+
+	vector<string> tools = DefaultTools;
+	if (options.getBoolean("tools")) {
+		tools.clear();
+		stringstream list(options.getString("tools"));
+		string command;
+		while (getline(list, command, ';')) {
+			if (!command.empty()) {
+				tools.push_back(command);
+			}
+		}
+	}
+
+	vector<BenchResult> results;
+	if (!options.getBoolean("macro")) {
+		addMicroBenchmarks(results, corpus);
+	}
+	if (!options.getBoolean("micro")) {
+		addMacroBenchmarks(results, corpus, tools);
+	}
+
+	if (options.getBoolean("output")) {
+		ofstream output(options.getString("output"));
+		printJson(output, results, corpus);
+	} else {
+		printJson(cout, results, corpus);
+	}
+
+	for (int i=0; i<(int)results.size(); i++) {
+		if (!results[i].error.empty()) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////
+//
+// isSelected -- Return true if a benchmark was selected with -b.
+//
+
+bool isSelected(const string& name) {
+	if (!SelectQ) {
+		return true;
+	}
+	return Select.search(name, options.getString("bench"));
+}
+
+
+
+//////////////////////////////
+//
+// runBenchmark -- Run a benchmark once to warm up, then Repeat times,
+//     timing only the run function.  The setup function is called before
+//     each run (such as to read files which the run function analyzes).
+//     The run function returns the number of items that it processed,
+//     and adds to a checksum so that the work cannot be optimized away.
+//
+
+void runBenchmark(vector<BenchResult>& results, const string& name,
+		const string& group, const string& unit, function<void(void)> setup,
+		function<long long(double&)> run) {
+	if (!isSelected(name)) {
+		return;
+	}
+	BenchResult result;
+	result.name = name;
+	result.group = group;
+	result.unit = unit;
+	try {
+		for (int i=0; i<=Repeat; i++) {
+			if (setup) {
+				setup();
+			}
+			double checksum = 0.0;
+			auto start = chrono::steady_clock::now();
+			long long items = run(checksum);
+			auto stop = chrono::steady_clock::now();
+			if (i == 0) {
+				// warm-up run
+				result.items = items;
+				result.checksum = checksum;
+				continue;
+			}
+			result.times.push_back(chrono::duration<double, milli>(stop - start).count());
+		}
+	} catch (const exception& error) {
+		result.error = error.what();
+	}
+	cerr << name << "\t" << (result.times.empty() ? 0.0 : getMedian(result.times))
+	     << " ms" << endl;
+	results.push_back(result);
+}
+
+
+
+//////////////////////////////
+//
+// addMicroBenchmarks -- Time parts of the library over the whole corpus.
+//
+
+void addMicroBenchmarks(vector<BenchResult>& results, vector<string>& corpus) {
+	long long lines = 0;
+	for (int i=0; i<(int)corpus.size(); i++) {
+		lines += count(corpus[i].begin(), corpus[i].end(), '\n');
+	}
+
+	runBenchmark(results, "read", "micro", "lines", nullptr, [&](double& checksum) {
+		for (int i=0; i<(int)corpus.size(); i++) {
+			HumdrumFile infile;
+			infile.readString(corpus[i]);
+			checksum += infile.getScoreDuration().getFloat();
+		}
+		return lines;
+	});
+
+	runBenchmark(results, "readNoRhythm", "micro", "lines", nullptr, [&](double& checksum) {
+		for (int i=0; i<(int)corpus.size(); i++) {
+			HumdrumFile infile;
+			infile.readStringNoRhythm(corpus[i]);
+			checksum += infile.getLineCount();
+		}
+		return lines;
+	});
+
+	// The analyses are timed on files which are read in the setup step:
+	vector<unique_ptr<HumdrumFile>> infiles;
+	auto readNoRhythm = [&](void) {
+		infiles.clear();
+		for (int i=0; i<(int)corpus.size(); i++) {
+			infiles.emplace_back(new HumdrumFile);
+			infiles.back()->readStringNoRhythm(corpus[i]);
+		}
+	};
+	auto readCorpus = [&](void) {
+		infiles.clear();
+		for (int i=0; i<(int)corpus.size(); i++) {
+			infiles.emplace_back(new HumdrumFile);
+			infiles.back()->readString(corpus[i]);
+		}
+	};
+
+	runBenchmark(results, "analyzeRhythmStructure", "micro", "lines", readNoRhythm,
+			[&](double& checksum) {
+		for (int i=0; i<(int)infiles.size(); i++) {
+			infiles[i]->analyzeRhythmStructure();
+			checksum += infiles[i]->getScoreDuration().getFloat();
+		}
+		return lines;
+	});
+
+	runBenchmark(results, "analyzeSlurs", "micro", "lines", readCorpus, [&](double& checksum) {
+		for (int i=0; i<(int)infiles.size(); i++) {
+			checksum += infiles[i]->analyzeSlurs();
+		}
+		return lines;
+	});
+
+	runBenchmark(results, "analyzeKernTies", "micro", "lines", readCorpus, [&](double& checksum) {
+		for (int i=0; i<(int)infiles.size(); i++) {
+			checksum += infiles[i]->analyzeKernTies();
+		}
+		return lines;
+	});
+
+	runBenchmark(results, "analyzeBeams", "micro", "lines", readCorpus, [&](double& checksum) {
+		for (int i=0; i<(int)infiles.size(); i++) {
+			checksum += infiles[i]->analyzeBeams();
+		}
+		return lines;
+	});
+
+	// tied durations of all notes (which follow the ties in each voice):
+	runBenchmark(results, "HumdrumToken::getTiedDuration", "micro", "lines", readCorpus,
+			[&](double& checksum) {
+		for (int i=0; i<(int)infiles.size(); i++) {
+			HumdrumFile& infile = *infiles[i];
+			for (int j=0; j<infile.getLineCount(); j++) {
+				if (!infile[j].isData()) {
+					continue;
+				}
+				for (int k=0; k<infile[j].getFieldCount(); k++) {
+					HTp token = infile.token(j, k);
+					if (token->isKern() && token->isNoteAttack()) {
+						checksum += token->getTiedDuration().getFloat();
+					}
+				}
+			}
+		}
+		return lines;
+	});
+
+	// Token-level benchmarks use the **kern notes of the corpus:
+	readCorpus();
+	vector<string> notes;
+	for (int i=0; i<(int)infiles.size(); i++) {
+		HumdrumFile& infile = *infiles[i];
+		for (int j=0; j<infile.getLineCount(); j++) {
+			if (!infile[j].isData()) {
+				continue;
+			}
+			for (int k=0; k<infile[j].getFieldCount(); k++) {
+				HTp token = infile.token(j, k);
+				if (token->isKern() && !token->isNull()) {
+					for (int m=0; m<token->getSubtokenCount(); m++) {
+						notes.push_back(token->getSubtoken(m));
+					}
+				}
+			}
+		}
+	}
+	infiles.clear();
+	long long notecount = (long long)notes.size();
+
+	runBenchmark(results, "Convert::recipToDuration", "micro", "notes", nullptr,
+			[&](double& checksum) {
+		for (int i=0; i<(int)notes.size(); i++) {
+			checksum += Convert::recipToDuration(notes[i]).getFloat();
+		}
+		return notecount;
+	});
+
+	runBenchmark(results, "Convert::kernToBase40", "micro", "notes", nullptr,
+			[&](double& checksum) {
+		for (int i=0; i<(int)notes.size(); i++) {
+			checksum += Convert::kernToBase40(notes[i]);
+		}
+		return notecount;
+	});
+
+	runBenchmark(results, "HumRegex::search", "micro", "notes", nullptr,
+			[&](double& checksum) {
+		HumRegex hre;
+		for (int i=0; i<(int)notes.size(); i++) {
+			if (hre.search(notes[i], "^(\\d+)(\\.*)([a-gA-G]+)")) {
+				checksum += hre.getMatchInt(1);
+			}
+		}
+		return notecount;
+	});
+
+	runBenchmark(results, "HumRegex::replaceCopy", "micro", "notes", nullptr,
+			[&](double& checksum) {
+		HumRegex hre;
+		for (int i=0; i<(int)notes.size(); i++) {
+			checksum += hre.replaceCopy(notes[i], "", "[LJkK]+", "g").size();
+		}
+		return notecount;
+	});
+
+	runBenchmark(results, "HumNum", "micro", "operations", nullptr,
+			[&](double& checksum) {
+		// add, scale and compare fractions with small denominators
+		HumNum sum = 0;
+		HumNum largest = 0;
+		for (int i=0; i<(int)notes.size(); i++) {
+			HumNum duration(1, 1 + (int)(notes[i].size() % 12));
+			sum += duration;
+			HumNum scaled = duration * HumNum(3, 2) - HumNum(1, 8);
+			if (scaled > largest) {
+				largest = scaled;
+			}
+			if (sum > 64) {
+				sum -= 64;
+			}
+		}
+		checksum += sum.getFloat() + largest.getFloat();
+		return 6 * notecount;
+	});
+}
+
+
+
+//////////////////////////////
+//
+// addMacroBenchmarks -- Time each tool on each file of the corpus,
+//     including reading the file and creating the output text.
+//
+
+void addMacroBenchmarks(vector<BenchResult>& results, vector<string>& corpus,
+		const vector<string>& tools) {
+	for (int t=0; t<(int)tools.size(); t++) {
+		string command = tools[t];
+		string name = command.substr(0, command.find(' '));
+		const HumToolRegistry::Entry* entry = HumToolRegistry::getEntry(name);
+		if (!entry) {
+			BenchResult result;
+			result.name = "tool " + command;
+			result.group = "macro";
+			result.error = "unknown tool";
+			results.push_back(result);
+			continue;
+		}
+		runBenchmark(results, "tool " + command, "macro", "files", nullptr,
+				[&](double& checksum) {
+			unique_ptr<HumTool> tool(entry->create());
+			for (int i=0; i<(int)corpus.size(); i++) {
+				if (!entry->reset(tool.get())) {
+					tool.reset(entry->create());
+				}
+				HumdrumFile infile;
+				infile.readString(corpus[i]);
+				tool->process(command);
+				entry->run(tool.get(), infile);
+				stringstream output;
+				if (tool->hasAnyText()) {
+					tool->getAllText(output);
+				} else {
+					output << infile;
+				}
+				checksum += output.str().size();
+			}
+			return (long long)corpus.size();
+		});
+	}
+}
+
+
+
+//////////////////////////////
+//
+// printJson -- Print the benchmark results.
+//
+
+void printJson(ostream& out, vector<BenchResult>& results, vector<string>& corpus) {
+	long long bytes = 0;
+	long long lines = 0;
+	for (int i=0; i<(int)corpus.size(); i++) {
+		bytes += corpus[i].size();
+		lines += count(corpus[i].begin(), corpus[i].end(), '\n');
+	}
+
+	out << "{\n";
+	out << "\t\"label\": " << jsonString(options.getString("label")) << ",\n";
+#ifdef __VERSION__
+	out << "\t\"compiler\": " << jsonString(__VERSION__) << ",\n";
+#endif
+	out << "\t\"repeat\": " << Repeat << ",\n";
+	out << "\t\"corpus\": {\n";
+	out << "\t\t\"files\": " << corpus.size() << ",\n";
+	out << "\t\t\"measures\": " << options.getInteger("measures") << ",\n";
+	out << "\t\t\"seed\": " << options.getInteger("seed") << ",\n";
+	out << "\t\t\"lines\": " << lines << ",\n";
+	out << "\t\t\"bytes\": " << bytes << "\n";
+	out << "\t},\n";
+	out << "\t\"benchmarks\": [";
+	for (int i=0; i<(int)results.size(); i++) {
+		BenchResult& result = results[i];
+		out << (i ? ",\n" : "\n") << "\t\t{\n";
+		out << "\t\t\t\"name\": " << jsonString(result.name) << ",\n";
+		out << "\t\t\t\"group\": " << jsonString(result.group) << ",\n";
+		if (!result.error.empty()) {
+			out << "\t\t\t\"error\": " << jsonString(result.error) << "\n";
+			out << "\t\t}";
+			continue;
+		}
+		double minimum = *min_element(result.times.begin(), result.times.end());
+		double median = getMedian(result.times);
+		double mean = 0.0;
+		for (int j=0; j<(int)result.times.size(); j++) {
+			mean += result.times[j];
+		}
+		mean /= result.times.size();
+		out << "\t\t\t\"unit\": " << jsonString(result.unit) << ",\n";
+		out << "\t\t\t\"items\": " << result.items << ",\n";
+		out << "\t\t\t\"min_ms\": " << minimum << ",\n";
+		out << "\t\t\t\"median_ms\": " << median << ",\n";
+		out << "\t\t\t\"mean_ms\": " << mean << ",\n";
+		out << "\t\t\t\"items_per_second\": "
+		    << (median > 0.0 ? result.items / median * 1000.0 : 0.0) << ",\n";
+		out << "\t\t\t\"checksum\": " << result.checksum << ",\n";
+		out << "\t\t\t\"times_ms\": [";
+		for (int j=0; j<(int)result.times.size(); j++) {
+			out << (j ? ", " : "") << result.times[j];
+		}
+		out << "]\n";
+		out << "\t\t}";
+	}
+	out << "\n\t]\n";
+	out << "}\n";
+}
+
+
+
+//////////////////////////////
+//
+// jsonString -- Return a string as a quoted JSON string.
+//
+
+string jsonString(const string& input) {
+	string output = "\"";
+	for (int i=0; i<(int)input.size(); i++) {
+		char ch = input[i];
+		switch (ch) {
+			case '"':  output += "\\\""; break;
+			case '\\': output += "\\\\"; break;
+			case '\n': output += "\\n";  break;
+			case '\t': output += "\\t";  break;
+			default:
+				if ((unsigned char)ch < 0x20) {
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+					output += buffer;
+				} else {
+					output += ch;
+				}
+		}
+	}
+	output += "\"";
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// getMedian --
+//
+
+double getMedian(vector<double> values) {
+	if (values.empty()) {
+		return 0.0;
+	}
+	sort(values.begin(), values.end());
+	int size = (int)values.size();
+	if (size % 2) {
+		return values[size / 2];
+	}
+	return (values[size / 2 - 1] + values[size / 2]) / 2.0;
+}
+
+
+
+//////////////////////////////
+//
+// getKernPitch -- Convert a base-7 pitch (octave * 7 + diatonic) to
+//     **kern, with B-flat for the key of F major.
+//
+
+string getKernPitch(int base7, bool flatb) {
+	int octave = base7 / 7;
+	int diatonic = base7 % 7;
+	char letter = "cdefgab"[diatonic];
+	string output;
+	if (octave >= 4) {
+		output.append(octave - 3, letter);
+	} else {
+		output.append(4 - octave, (char)toupper(letter));
+	}
+	if (flatb && (diatonic == 6)) {
+		output += "-";
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// generateScore -- Generate a four-voice score in F major with beamed
+//     rhythms, slurs, ties, chords and rests.
+//
+
+string generateScore(mt19937& random, int number, int measures) {
+	const int voices = 4;
+	stringstream output;
+	output << "!!!COM: humlib-bench\n";
+	output << "!!!OTL: Synthetic score " << number << "\n";
+	for (int v=0; v<voices; v++) {
+		output << (v ? "\t" : "") << "**kern";
+	}
+	output << "\n";
+	vector<string> headers = {"*I\"Voice", "*clefG2", "*k[b-]", "*F:", "*M4/4"};
+	for (int h=0; h<(int)headers.size(); h++) {
+		for (int v=voices-1; v>=0; v--) {
+			output << (v < voices - 1 ? "\t" : "");
+			if (h == 1) {
+				output << (v >= 2 ? "*clefF4" : "*clefG2");
+			} else {
+				output << headers[h];
+			}
+		}
+		output << "\n";
+	}
+
+	vector<int> pitch(voices);
+	vector<bool> slur(voices, false);
+	vector<bool> tie(voices, false);
+	for (int v=0; v<voices; v++) {
+		pitch[v] = (VoiceRange[v][0] + VoiceRange[v][1]) / 2;
+	}
+
+	for (int m=1; m<=measures; m++) {
+		// tokens of each voice (spines are printed bass first) at each
+		// sixteenth-note position in the measure:
+		vector<vector<string>> grid(16, vector<string>(voices));
+		for (int v=0; v<voices; v++) {
+			int position = 0;
+			while (position < 16) {
+				if ((position % 8 == 0) && (random() % 8 == 0)) {
+					// half note (never beamed)
+					grid[position][v] = "2";
+					position += 8;
+					continue;
+				}
+				const BeatPattern& pattern = BeatPatterns[random() % BeatPatterns.size()];
+				for (int k=0; k<(int)pattern.recip.size(); k++) {
+					grid[position][v] = pattern.recip[k] + "|" + pattern.beam[k];
+					position += pattern.length[k];
+				}
+			}
+		}
+		output << "=" << m;
+		for (int v=1; v<voices; v++) {
+			output << "\t=" << m;
+		}
+		output << "\n";
+		if ((m > 1) && (m % 32 == 1)) {
+			// meter stays the same, but adds interpretation lines
+			for (int v=0; v<voices; v++) {
+				output << (v ? "\t" : "") << "*M4/4";
+			}
+			output << "\n";
+		}
+
+		for (int p=0; p<16; p++) {
+			bool attack = false;
+			for (int v=0; v<voices; v++) {
+				if (!grid[p][v].empty()) {
+					attack = true;
+				}
+			}
+			if (!attack) {
+				continue;
+			}
+			for (int v=voices-1; v>=0; v--) {
+				output << (v < voices - 1 ? "\t" : "");
+				string& cell = grid[p][v];
+				if (cell.empty()) {
+					output << ".";
+					continue;
+				}
+				string recip = cell.substr(0, cell.find('|'));
+				string beam = cell.find('|') == string::npos ? "" : cell.substr(cell.find('|') + 1);
+				string token;
+				if (tie[v]) {
+					// end the tie started on the previous note
+					token = recip + getKernPitch(pitch[v], true) + "]";
+					tie[v] = false;
+				} else if (beam.empty() && (recip.size() == 1) && (random() % 8 == 0)) {
+					// rests on quarter and half notes (outside of beams)
+					token = recip + "r";
+				} else {
+					int step = (int)(random() % 5) - 2;
+					pitch[v] = max(VoiceRange[v][0], min(VoiceRange[v][1], pitch[v] + step));
+					token = recip + getKernPitch(pitch[v], true);
+					if ((v == 0) && (random() % 6 == 0)) {
+						token += " " + recip + getKernPitch(pitch[v] - 2, true);
+					} else if (random() % 12 == 0) {
+						token += "[";
+						tie[v] = true;
+					}
+					if (!slur[v] && (random() % 10 == 0)) {
+						token = "(" + token;
+						slur[v] = true;
+					} else if (slur[v] && (random() % 4 == 0)) {
+						token += ")";
+						slur[v] = false;
+					}
+				}
+				if (!beam.empty()) {
+					// beam markers go on the last subtoken of a chord
+					token += beam;
+				}
+				output << token;
+			}
+			output << "\n";
+		}
+	}
+	// close slurs and ties left open at the end:
+	output << "=" << measures + 1;
+	for (int v=1; v<voices; v++) {
+		output << "\t=" << measures + 1;
+	}
+	output << "\n";
+	for (int v=voices-1; v>=0; v--) {
+		output << (v < voices - 1 ? "\t" : "");
+		string token = "4" + getKernPitch(pitch[v], true);
+		if (tie[v]) {
+			token += "]";
+		}
+		if (slur[v]) {
+			token += ")";
+		}
+		output << token;
+	}
+	output << "\n";
+	output << "==";
+	for (int v=1; v<voices; v++) {
+		output << "\t==";
+	}
+	output << "\n";
+	output << "*-";
+	for (int v=1; v<voices; v++) {
+		output << "\t*-";
+	}
+	output << "\n";
+	return output.str();
+}
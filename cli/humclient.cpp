@@ -0,0 +1,98 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:44:01 UTC 2026
+// Last Modified: Sat Oct 17 02:44:01 UTC 2026
+// Filename:      cli/humclient.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/cli/humclient.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab nowrap
+//
+// Description:   Send requests to humserver.  Each input file is processed
+//                by the server with the given tool pipeline (files are
+//                given to the server by name, so that it can cache them).
+//                If there are no input files, data is read from standard
+//                input and sent with the request.
+//
+// Usage:         humclient [-s socket] -t "autobeam | autostem" [file ...]
+//                humclient [-s socket] --stats
+//                humclient [-s socket] --stop
+//
+
+#include "humlib.h"
+
+#include <climits>
+#include <cstdlib>
+
+using namespace std;
+using namespace hum;
+
+static bool sendRequest(const string& socketpath,
+		const HumToolServer::Request& request);
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("s|socket=s", "socket of the server");
+	options.define("t|tools=s:", "tool pipeline to run, such as \"autobeam | autostem\"");
+	options.define("f|filter-options=s:", "options for the filter tool");
+	options.define("stats=b", "print the statistics of the server");
+	options.define("stop=b", "stop the server");
+	options.process(argc, argv);
+
+	string socketpath = HumToolServer::getDefaultSocket();
+	if (options.getBoolean("socket")) {
+		socketpath = options.getString("socket");
+	}
+
+	HumToolServer::Request request;
+	if (options.getBoolean("stats")) {
+		request.command = "stats";
+		return !sendRequest(socketpath, request);
+	}
+	if (options.getBoolean("stop")) {
+		request.command = "stop";
+		return !sendRequest(socketpath, request);
+	}
+
+	request.tools = options.getString("tools");
+	request.options = options.getString("filter-options");
+	if (options.getArgCount() == 0) {
+		stringstream data;
+		data << cin.rdbuf();
+		request.data = data.str();
+		return !sendRequest(socketpath, request);
+	}
+
+	bool status = true;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		request.filename = options.getArg(i);
+#ifdef HUMLIB_SOCKETS
+		// The server may have a different working directory:
+		char path[PATH_MAX];
+		if (realpath(options.getArg(i).c_str(), path)) {
+			request.filename = path;
+		}
+#endif
+		status &= sendRequest(socketpath, request);
+	}
+	return !status;
+}
+
+
+
+//////////////////////////////
+//
+// sendRequest -- Send a request to the server and print the response.
+//
+
+static bool sendRequest(const string& socketpath,
+		const HumToolServer::Request& request) {
+	HumToolServer::Response response;
+	bool status = HumToolServer::sendRequest(socketpath, request, response);
+	cout << response.humdrum << response.json << response.text;
+	cerr << response.warning << response.error;
+	return status;
+}
+
+
+
@@ -1,18 +1,32 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Wed Dec 14 22:16:19 PST 2016
-// Last Modified: Wed Dec 14 22:16:21 PST 2016
+// Last Modified: Sat Oct 17 02:31:18 UTC 2026
 // Filename:      cli/humfilter.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/cli/humfilter.cpp
 // Syntax:        C++11
 // vim:           ts=3 noexpandtab nowrap
 //
-// Description:   Run embedded humib tools.
+// Description:   Run embedded humib tools.  Use --jobs to filter several
+//                input files/segments in parallel.
 //
 
 #include "humlib.h"
 
-STREAM_INTERFACE(Tool_filter)
+using namespace std;
+using namespace hum;
+
+int main(int argc, char** argv) {
+	Tool_filter interface;
+	if (!interface.process(argc, argv)) {
+		interface.getError(cerr);
+		return -1;
+	}
+	HumdrumFileStream instream(static_cast<Options&>(interface));
+	instream.setReadAnalyses(interface.getRequiredAnalyses());
+	bool status = interface.runBatch(instream, cout, interface.getInteger("jobs"));
+	return !status;
+}
 
 
 
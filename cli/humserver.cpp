@@ -0,0 +1,60 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:44:01 UTC 2026
+// Last Modified: Sat Oct 17 02:44:01 UTC 2026
+// Filename:      cli/humserver.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/cli/humserver.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab nowrap
+//
+// Description:   Run humlib tool pipelines for other programs, which send
+//                requests on a Unix domain socket (see humclient and
+//                HumToolServer).  The server keeps running until it
+//                receives SIGINT or SIGTERM, or a "stop" command.
+//
+// Usage:         humserver [-s socket] [-j jobs] [-c cache-size]
+//
+
+#include "humlib.h"
+
+#include <csignal>
+
+using namespace std;
+using namespace hum;
+
+static HumToolServer* server = NULL;
+
+
+// stopServer: Stop the server when the program is interrupted.
+static void stopServer(int signum) {
+	if (server) {
+		server->stop();
+	}
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("s|socket=s", "socket to listen on");
+	options.define("j|jobs=i:0", "number of worker threads (0 = all cores)");
+	options.define("c|cache=i:100", "maximum number of files in the cache");
+	options.process(argc, argv);
+
+	string socketpath = HumToolServer::getDefaultSocket();
+	if (options.getBoolean("socket")) {
+		socketpath = options.getString("socket");
+	}
+
+	HumToolServer toolserver(options.getInteger("cache"));
+	server = &toolserver;
+	signal(SIGINT, stopServer);
+	signal(SIGTERM, stopServer);
+	cerr << "humserver: listening on " << socketpath << endl;
+	bool status = toolserver.serve(socketpath, options.getInteger("jobs"));
+	server = NULL;
+	cerr << "humserver: " << toolserver.getStatistics();
+	return !status;
+}
+
+
+
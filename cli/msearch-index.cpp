@@ -0,0 +1,61 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:53:46 UTC 2026
+// Last Modified: Sat Oct 17 02:53:46 UTC 2026
+// Filename:      cli/msearch-index.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/cli/msearch-index.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab nowrap
+//
+// Description:   Build an index of the melodic n-grams in a set of files,
+//                which msearch can use to search the same files without
+//                checking every note (msearch --index file).  Files which
+//                are not in the index, or which have been changed since
+//                the index was built, are still searched in full.
+//
+// Usage:         msearch-index [-n length] -o index-file file.krn ...
+//
+
+#include "humlib.h"
+
+using namespace std;
+using namespace hum;
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("o|output=s:msearch.index", "index file to write");
+	options.define("n|length=i:3", "number of notes in each n-gram");
+	options.define("q|quiet=b", "do not print the number of files indexed");
+	options.process(argc, argv);
+
+	MSearchIndex index(options.getInteger("length"));
+	HumdrumFileStream instream(options);
+	int count = 0;
+	int skipped = 0;
+	while (true) {
+		HumdrumFile infile;
+		if (!instream.read(infile)) {
+			break;
+		}
+		count++;
+		if (!index.addFile(infile)) {
+			skipped++;
+		}
+	}
+
+	string filename = options.getString("output");
+	if (!index.write(filename)) {
+		cerr << "Error: cannot write index file " << filename << endl;
+		return 1;
+	}
+	if (!options.getBoolean("quiet")) {
+		cerr << "msearch-index: " << count << " files, " << skipped
+		     << " not indexed, " << index.getFileCount() << " distinct, "
+		     << index.getGramCount() << " n-grams" << endl;
+	}
+	return 0;
+}
+
+
+
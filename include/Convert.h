@@ -15,6 +15,7 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 
 #include "HumNum.h"
 #include "HumdrumToken.h"
@@ -27,18 +28,18 @@ class Convert {
 	public:
 
 		// Rhythm processing, defined in Convert-rhythm.cpp
-		static HumNum  recipToDuration      (const std::string& recip,
+		static HumNum  recipToDuration      (std::string_view recip,
 		                                     HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		                                     std::string_view separator = " ");
 		static HumNum  recipToDuration      (std::string* recip,
 		                                     HumNum scale = 4,
-		                                     const std::string& separator = " ");
-		static HumNum  recipToDurationIgnoreGrace(const std::string& recip,
+		                                     std::string_view separator = " ");
+		static HumNum  recipToDurationIgnoreGrace(std::string_view recip,
 		                                     HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		                                     std::string_view separator = " ");
 		static HumNum  recipToDurationIgnoreGrace(std::string* recip,
 		                                     HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		                                     std::string_view separator = " ");
 		static HumNum  recipToDurationNoDots(const std::string& recip,
 		                                     HumNum scale = 4,
 		                                     const std::string& separator = " ");
@@ -60,42 +61,42 @@ class Convert {
 		static int     base40ToDiatonic     (int b40);
 		static int     base40ToMidiNoteNumber(int b40);
 		static std::string  base40ToIntervalAbbr (int b40);
-		static int     kernToOctaveNumber   (const std::string& kerndata);
+		static int     kernToOctaveNumber   (std::string_view kerndata);
 		static int     kernToOctaveNumber   (HTp token)
-				{ return kernToOctaveNumber((std::string)*token); }
-		static int     kernToAccidentalCount(const std::string& kerndata);
+				{ return kernToOctaveNumber(std::string_view(*token)); }
+		static int     kernToAccidentalCount(std::string_view kerndata);
 		static int     kernToAccidentalCount(HTp token)
-				{ return kernToAccidentalCount((std::string)*token); }
+				{ return kernToAccidentalCount(std::string_view(*token)); }
 
       static int     kernToStaffLocation  (HTp token, HTp clef = NULL);
       static int     kernToStaffLocation  (HTp token, const std::string& clef);
       static int     kernToStaffLocation  (const std::string& token, const std::string& clef = "");
 
-		static int     kernToDiatonicPC     (const std::string& kerndata);
+		static int     kernToDiatonicPC     (std::string_view kerndata);
 		static int     kernToDiatonicPC     (HTp token)
-				{ return kernToDiatonicPC     ((std::string)*token); }
+				{ return kernToDiatonicPC     (std::string_view(*token)); }
 		static char    kernToDiatonicUC     (const std::string& kerndata);
 		static int     kernToDiatonicUC     (HTp token)
 				{ return kernToDiatonicUC     ((std::string)*token); }
 		static char    kernToDiatonicLC     (const std::string& kerndata);
 		static int     kernToDiatonicLC     (HTp token)
 				{ return kernToDiatonicLC     ((std::string)*token); }
-		static int     kernToBase40PC       (const std::string& kerndata);
+		static int     kernToBase40PC       (std::string_view kerndata);
 		static int     kernToBase40PC       (HTp token)
-				{ return kernToBase40PC       ((std::string)*token); }
-		static int     kernToBase12PC       (const std::string& kerndata);
+				{ return kernToBase40PC       (std::string_view(*token)); }
+		static int     kernToBase12PC       (std::string_view kerndata);
 		static int     kernToBase12PC       (HTp token)
-				{ return kernToBase12PC       ((std::string)*token); }
+				{ return kernToBase12PC       (std::string_view(*token)); }
 		static int     kernToBase7PC        (const std::string& kerndata) {
 		                                     return kernToDiatonicPC(kerndata); }
 		static int     kernToBase7PC        (HTp token)
 				{ return kernToBase7PC        ((std::string)*token); }
-		static int     kernToBase40         (const std::string& kerndata);
+		static int     kernToBase40         (std::string_view kerndata);
 		static int     kernToBase40         (HTp token)
-				{ return kernToBase40         ((std::string)*token); }
-		static int     kernToBase12         (const std::string& kerndata);
+				{ return kernToBase40         (std::string_view(*token)); }
+		static int     kernToBase12         (std::string_view kerndata);
 		static int     kernToBase12         (HTp token)
-				{ return kernToBase12         ((std::string)*token); }
+				{ return kernToBase12         (std::string_view(*token)); }
 		static int     kernToBase7          (const std::string& kerndata);
 		static int     kernToBase7          (HTp token)
 				{ return kernToBase7          ((std::string)*token); }
@@ -167,12 +168,12 @@ class Convert {
 		static HumNum mensToDuration        (HTp menstok);
 
 		// older functions to enhance or remove:
-		static HumNum  mensToDuration       (const std::string& mensdata, HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		static HumNum  mensToDuration       (std::string_view mensdata, HumNum scale = 4,
+		                                     std::string_view separator = " ");
 		static std::string  mensToRecip     (const std::string& mensdata, HumNum scale = 4,
 		                                     const std::string& separator = " ");
-		static HumNum  mensToDurationNoDots (const std::string& mensdata, HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		static HumNum  mensToDurationNoDots (std::string_view mensdata, HumNum scale = 4,
+		                                     std::string_view separator = " ");
 
 		// MuseData conversions in Convert-musedata.cpp
       static int         museToBase40                    (const std::string& pitchString);
@@ -36,6 +36,7 @@ class HumAddress {
 		int                 getLineNumber     (void) const;
 		int                 getFieldIndex     (void) const;
 		const HumdrumToken& getDataType       (void) const;
+		int                 getDataTypeId     (void) const;
 		HTp                 getExclusiveInterpretation(void);
 		const std::string&  getSpineInfo      (void) const;
 		int                 getTrack          (void) const;
@@ -54,6 +55,7 @@ class HumAddress {
 		void                setTrack          (int aTrack);
 		void                setSubtrack       (int aSubtrack);
 		void                setSubtrackCount  (int aSubtrack);
+		void                setDataTypeId     (int id);
 
 	private:
 
@@ -91,12 +93,18 @@ class HumAddress {
 		// no tokens in the track (such as for global comments).
 		int m_subtrackcount;
 
+		// datatype: The HumDataType id of the exclusive interpretation for
+		// the track.  This is set when the tracks of the file are analyzed,
+		// and is HumDataType::Unknown (-1) before then.
+		int m_datatype;
+
 		// owner: This is the line which manages the given token.
 		HLp          m_owner;
 
 	friend class HumdrumToken;
 	friend class HumdrumLine;
 	friend class HumdrumFile;
+	friend class HumSnapshot;
 };
 
 
@@ -0,0 +1,140 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 06:21:30 UTC 2026
+// Last Modified: Sat Oct 17 06:21:30 UTC 2026
+// Filename:      HumAnalysisStore.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumAnalysisStore.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Typed storage for the results of the built-in analyses
+//                (the "auto" namespace of HumHash parameters).  There is
+//                one store for each file.  Each token, line or file that
+//                has analysis values is given a row in the store, and each
+//                analysis key is a column.  Columns are flat arrays of
+//                values indexed by row, and the values are stored as
+//                native integers, fractions, booleans, token pointers or
+//                floats rather than as strings.  HumHash presents the
+//                values as strings in the "auto" namespace, so existing
+//                code which reads or writes them does not need to change.
+//
+
+#ifndef _HUMANALYSISSTORE_H_INCLUDED
+#define _HUMANALYSISSTORE_H_INCLUDED
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hum {
+
+class HumNum;
+class HumdrumToken;
+typedef HumdrumToken* HTp;
+
+// START_MERGE
+
+class HumAnalysisValue {
+	public:
+		enum Type {
+			Undefined = 0,
+			String,
+			Integer,
+			Fraction,
+			Boolean,
+			Token,
+			Float
+		};
+
+		              HumAnalysisValue (void);
+
+		bool          isDefined        (void) const { return type != Undefined; }
+
+		unsigned char type;
+		union {
+			int        ints[2];  // Integer, Boolean, String index, Fraction
+			HTp        token;
+			double     number;
+		} value;
+};
+
+
+class HumAnalysisStore {
+	public:
+		                 HumAnalysisStore    (void);
+		                ~HumAnalysisStore    ();
+
+		void             clear               (void);
+		int              addRow              (void);
+		int              copyRow             (int row);
+		void             releaseRow          (int row);
+		int              getRowCount         (void) const;
+
+		int              getKeyIndex         (const std::string& ns1,
+		                                      const std::string& ns2,
+		                                      const std::string& key);
+		int              findKeyIndex        (const std::string& ns1,
+		                                      const std::string& ns2,
+		                                      const std::string& key) const;
+		int              getKeyCount         (void) const;
+		const std::string& getNamespace1     (int keyindex) const;
+		const std::string& getNamespace2     (int keyindex) const;
+		const std::string& getKey            (int keyindex) const;
+
+		const HumAnalysisValue* getValue     (int row, int keyindex) const;
+		std::string      getString           (const HumAnalysisValue& value) const;
+
+		void             setValue            (int row, int keyindex,
+		                                      const std::string& value);
+		void             setValue            (int row, int keyindex, int value);
+		void             setValue            (int row, int keyindex,
+		                                      const HumNum& value);
+		void             setValue            (int row, int keyindex, HTp value);
+		void             setValue            (int row, int keyindex, double value);
+		void             setBool             (int row, int keyindex, bool value);
+		void             deleteValue         (int row, int keyindex);
+
+		int              getValueCount       (int row) const;
+		size_t           getMemoryUsage      (void) const;
+
+		static bool      isAnalysisNamespace (const std::string& ns1,
+		                                      const std::string& ns2);
+
+	protected:
+		HumAnalysisValue& getCell            (int row, int keyindex);
+
+	private:
+		// HumAnalysisKey: the namespaces and name of a column.
+		struct HumAnalysisKey {
+			std::string ns1;
+			std::string ns2;
+			std::string key;
+		};
+
+		std::vector<HumAnalysisKey>                 m_keys;
+		std::vector<std::vector<HumAnalysisValue>>  m_columns;
+
+		// m_autoIndex: column index of keys in the "":"auto" namespace.
+		std::unordered_map<std::string, int>        m_autoIndex;
+
+		// m_subIndex: column index of keys in "auto":ns2 namespaces,
+		// stored as "ns2:key".
+		std::unordered_map<std::string, int>        m_subIndex;
+
+		// m_strings: text of values which are not one of the other types.
+		std::vector<std::string>                    m_strings;
+
+		// m_freeRows: rows of deleted tokens which can be reused.
+		std::vector<int>                            m_freeRows;
+		int                                         m_rows;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMANALYSISSTORE_H_INCLUDED */
+
+
+
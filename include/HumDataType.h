@@ -0,0 +1,60 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 20:42:46 UTC 2026
+// Last Modified: Fri Oct 16 20:42:46 UTC 2026
+// Filename:      HumDataType.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumDataType.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Symbol table for exclusive interpretations.  Each data
+//                type string such as "**kern" is given a small integer id
+//                which is stored in the HumAddress of every token in the
+//                spine when the spines of a file are analyzed, so that
+//                data type tests on tokens are integer comparisons.  The
+//                table is shared by all files and is safe to use from
+//                multiple threads.
+//
+
+#ifndef _HUMDATATYPE_H_INCLUDED
+#define _HUMDATATYPE_H_INCLUDED
+
+#include <string>
+
+namespace hum {
+
+// START_MERGE
+
+class HumDataType {
+	public:
+		static int                getId        (const std::string& datatype);
+		static const std::string& getName      (int id);
+		static int                getCount     (void);
+		static bool               isKernLike   (int id);
+		static bool               isMensLike   (int id);
+		static bool               isStaffLike  (int id);
+
+		// Ids of data types which are entered into the table first:
+		static const int None     = 0;   // ""
+		static const int Kern     = 1;   // "**kern"
+		static const int Mens     = 2;   // "**mens"
+		static const int Recip    = 3;   // "**recip"
+		static const int Text     = 4;   // "**text"
+		static const int Silbe    = 5;   // "**silbe"
+		static const int Dynam    = 6;   // "**dynam"
+		static const int Harm     = 7;   // "**harm"
+		static const int Fing     = 8;   // "**fing"
+
+		// Returned by getId() if the table is full:
+		static const int Unknown  = -1;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMDATATYPE_H_INCLUDED */
+
+
+
@@ -0,0 +1,60 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 07:51:57 UTC 2026
+// Last Modified: Sat Oct 17 07:51:57 UTC 2026
+// Filename:      HumFieldScanner.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumFieldScanner.h
+// Syntax:        C++17; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Find field separators (tabs, commas), quotes and newlines
+//                in blocks of text.  On x86 processors the text is compared
+//                16 bytes at a time with SSE2 instructions (or 32 bytes at a
+//                time with AVX2 if the library is compiled with -mavx2), and
+//                one byte at a time on other processors.  Used to split TSV
+//                lines into tokens and to convert CSV records into TSV lines.
+//
+
+#ifndef _HUMFIELDSCANNER_H_INCLUDED
+#define _HUMFIELDSCANNER_H_INCLUDED
+
+#include <string>
+
+// HUMLIB_SSE2 is defined when compiling for x86 processors with SSE2
+// (all 64-bit x86 processors), and HUMLIB_AVX2 when compiling with
+// AVX2 enabled (such as with -mavx2 or -march=native).  Define
+// HUMLIB_NO_SIMD before including this file to scan one byte at a time.
+#if !defined(HUMLIB_NO_SIMD) && defined(__SSE2__)
+	#define HUMLIB_SSE2
+	#if defined(__AVX2__)
+		#define HUMLIB_AVX2
+	#endif
+#endif
+
+namespace hum {
+
+// START_MERGE
+
+class HumFieldScanner {
+	public:
+		static const char*  find              (const char* start, const char* end,
+		                                       char c1);
+		static const char*  find              (const char* start, const char* end,
+		                                       char c1, char c2);
+		static const char*  find              (const char* start, const char* end,
+		                                       char c1, char c2, char c3);
+		static const char*  csvToTsv          (const char* start, const char* end,
+		                                       const std::string& separator,
+		                                       std::string& output);
+		static const char*  getInstructionSet (void);
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMFIELDSCANNER_H_INCLUDED */
+
+
+
@@ -0,0 +1,86 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 23:15:41 UTC 2026
+// Last Modified: Fri Oct 16 23:15:41 UTC 2026
+// Filename:      HumFileAnalysis.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumFileAnalysis.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Analysis states for a Humdrum file.  Each analysis
+//                which can be done on a HumdrumFile after the basic
+//                spine structure is read has an id, and a list of the
+//                other analyses that must be done before it.
+//                HumdrumFileBase::requireAnalysis() runs an analysis
+//                (and the analyses that it depends on) the first time
+//                that it is needed, and HumdrumFileBase::setReadAnalyses()
+//                selects which analyses are done by read().
+//
+
+#ifndef _HUMFILEANALYSIS_H_INCLUDED
+#define _HUMFILEANALYSIS_H_INCLUDED
+
+namespace hum {
+
+// START_MERGE
+
+class HumFileAnalysis {
+	public:
+		HumFileAnalysis(void) {}
+		~HumFileAnalysis() { clear(); }
+		void clear(void) {
+			m_analyzed           = 0;
+			m_barlines_different = false;
+		}
+
+		bool isAnalyzed  (int type) const { return m_analyzed & getMask(type); }
+		void setAnalyzed (int type, bool state = true) {
+			if (state) {
+				m_analyzed |= getMask(type);
+			} else {
+				m_analyzed &= ~getMask(type);
+			}
+		}
+
+		static unsigned    getMask         (int type) { return 1u << type; }
+		static unsigned    getDependencies (int type);
+		static const char* getName         (int type);
+
+		// Analysis ids, listed in an order in which each one comes after
+		// the analyses that it depends on:
+		static const int Strands     = 0;   // spine strands
+		static const int Nulls       = 1;   // null token resolution
+		static const int Strophes    = 2;   // *S/ and *strophe markers
+		static const int Structure   = 3;   // parameters, token durations, signifiers
+		static const int Rhythm      = 4;   // line durations and timings
+		static const int Barlines    = 5;   // barline style comparisons
+		static const int Slurs       = 6;
+		static const int Phrases     = 7;
+		static const int Beams       = 8;
+		static const int Ties        = 9;
+		static const int Accidentals = 10;
+		static const int Count       = 11;
+
+		// ReadDefault: Analyses done by HumdrumFileStructure::read() unless
+		// the file has been given a different list with setReadAnalyses().
+		static const unsigned ReadDefault = (1u << Strands) | (1u << Nulls) |
+				(1u << Strophes) | (1u << Structure) | (1u << Rhythm);
+
+		// m_analyzed: bit mask of the analyses which have been done.
+		unsigned m_analyzed = 0;
+
+		// m_barlines_different: Set to true when the file contains
+		// any barlines that are not all of the same at the same
+		// times.
+		bool m_barlines_different = false;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMFILEANALYSIS_H_INCLUDED */
+
+
+
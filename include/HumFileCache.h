@@ -0,0 +1,91 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:44:01 UTC 2026
+// Last Modified: Sat Oct 17 10:21:28 UTC 2026
+// Filename:      HumFileCache.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumFileCache.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Least-recently-used cache of analyzed Humdrum files,
+//                for programs which read the same files many times (such
+//                as HumToolServer).  The cache stores the contents of each
+//                file together with a snapshot of its analyses (see
+//                HumSnapshot), keyed by the filename and the modification
+//                time and size of the file.  Reading a file from the cache
+//                gives the reader its own copy of the file, which can be
+//                changed by tools, without parsing and analyzing the file
+//                again.  The cache can be used by several threads at once.
+//
+
+#ifndef _HUMFILECACHE_H_INCLUDED
+#define _HUMFILECACHE_H_INCLUDED
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace hum {
+
+// START_MERGE
+
+class HumdrumFile;
+
+class HumFileCache {
+	public:
+		                HumFileCache     (int capacity = 100);
+		               ~HumFileCache     ();
+
+		bool            read             (HumdrumFile& infile,
+		                                  const std::string& filename);
+		void            clear            (void);
+		void            setCapacity      (int capacity);
+		int             getCapacity      (void);
+		int             getSize          (void);
+		std::uint64_t   getHitCount      (void);
+		std::uint64_t   getMissCount     (void);
+
+	protected:
+		class Entry {
+			public:
+				std::string   filename;
+				std::int64_t  mtime    = 0; // modification time in nanoseconds
+				std::int64_t  size     = 0; // size of the file in bytes
+				unsigned      analyses = 0; // read analyses of the snapshot
+				std::string   contents;     // text of the file
+				std::string   snapshot;     // analyses of the file
+		};
+
+		static bool     getFileStatus    (const std::string& filename,
+		                                  std::int64_t& mtime, std::int64_t& size);
+		static bool     readContents     (const std::string& filename,
+		                                  std::string& contents);
+		int             trim             (void);
+
+	private:
+		typedef std::list<std::shared_ptr<Entry>> EntryList;
+
+		// m_entries: cached files, with the most recently used file first.
+		EntryList m_entries;
+
+		// m_index: position of each file in m_entries, by filename.
+		std::unordered_map<std::string, EntryList::iterator> m_index;
+
+		int           m_capacity;
+		std::uint64_t m_hits   = 0;
+		std::uint64_t m_misses = 0;
+		std::mutex    m_mutex;   // protects all of the above
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMFILECACHE_H_INCLUDED */
+
+
+
@@ -98,14 +98,29 @@
 //                  full score (or part if it is extracted from the full
 //                  score).
 //
+//                  Parameters are stored in a small array sorted by
+//                  namespace and key, with the namespaces and key of each
+//                  parameter given as ids in the HumParameterName table
+//                  rather than as strings.
+//
+//                  Parameters in the "auto" namespace are the results of
+//                  the built-in analyses (slur, tie and beam links, stem
+//                  lengths and so on).  For tokens and lines in a file,
+//                  they are stored as typed values in a HumAnalysisStore
+//                  owned by the file, but are read and written in the same
+//                  way as other parameters.
+//
 
 #ifndef _HUMHASH_H_INCLUDED
 #define _HUMHASH_H_INCLUDED
 
+#include "HumAnalysisStore.h"
+#include "HumParameterName.h"
+
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
-#include <map>
 
 namespace hum {
 
@@ -126,11 +141,26 @@ typedef std::map<std::string, std::map<std::string, std::map<std::string, HumPar
 typedef std::map<std::string, std::map<std::string, HumParameter> > MapNKV;
 typedef std::map<std::string, HumParameter> MapKV;
 
+// HumHashEntry: A parameter with its namespaces and key given as
+// HumParameterName ids.
+class HumHashEntry {
+	public:
+		int          ns1;
+		int          ns2;
+		int          key;
+		HumParameter value;
+};
+
+typedef std::vector<HumHashEntry> HumHashEntries;
+
 class HumHash {
 	public:
 		               HumHash             (void);
+		               HumHash             (const HumHash& hash);
 		              ~HumHash             ();
 
+		HumHash&       operator=           (const HumHash& hash);
+
 		std::string    getValue            (const std::string& key) const;
 		std::string    getValue            (const std::string& ns2,
 		                                    const std::string& key) const;
@@ -227,6 +257,7 @@ class HumHash {
 		int            getParameterCount   (const std::string& ns) const;
 		int            getParameterCount   (const std::string& ns1,
 		                                    const std::string& ns2) const;
+		void           clearParameters     (void);
 		void           setPrefix           (const std::string& value);
 		std::string    getPrefix           (void) const;
 		std::ostream&  printXml            (std::ostream& out = std::cout, int level = 0,
@@ -257,15 +288,55 @@ class HumHash {
 		                                    const std::string& parameter) const;
 
 	protected:
+		// Types of objects which contain a HumHash (see m_analysisOwner):
+		enum AnalysisOwnerType {
+			NoAnalysisOwner,
+			TokenAnalysisOwner,
+			LineAnalysisOwner,
+			FileAnalysisOwner
+		};
+
 		void                     initializeParameters  (void);
+		void                     setAnalysisOwner      (int type);
+		HumAnalysisStore*        findAnalysisStore     (bool create) const;
+		void                     detachAnalysisValues  (void);
 		std::vector<std::string> getKeyList            (const std::string& keys) const;
+		const HumAnalysisValue*  getAnalysisValue      (const std::string& ns1,
+		                                                const std::string& ns2,
+		                                                const std::string& key) const;
+		HumAnalysisStore*        prepareAnalysisValue  (const std::string& ns1,
+		                                                const std::string& ns2,
+		                                                const std::string& key,
+		                                                int& keyindex);
+		void                     deleteAnalysisValues  (void);
+		const HumHashEntries*    getParameterView      (HumHashEntries& storage) const;
+		int                      findParameter         (const std::string& ns1,
+		                                                const std::string& ns2,
+		                                                const std::string& key) const;
+		HumParameter&            insertParameter       (const std::string& ns1,
+		                                                const std::string& ns2,
+		                                                const std::string& key);
 
 	private:
-		MapNNKV*    parameters;
+		// parameters: Entries sorted by the names of the namespaces
+		// and key (the same order as a map of the names), or NULL if no
+		// parameters have been set.
+		HumHashEntries* parameters;
 		std::string prefix;
 
+		// m_analysisRow: The row for the values of this object in the
+		// "auto" namespace in the analysis store of the file (see
+		// findAnalysisStore()), or -1 if none have been stored.
+		int         m_analysisRow;
+
+		// m_analysisOwner: The type of the object which contains this
+		// HumHash (an AnalysisOwnerType), used to find the file with the
+		// analysis store without storing a pointer to it.
+		int         m_analysisOwner;
+
 	friend std::ostream& operator<<(std::ostream& out, const HumHash& hash);
 	friend std::ostream& operator<<(std::ostream& out, HumHash* hash);
+	friend class HumSnapshot;
 };
 
 
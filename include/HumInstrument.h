@@ -15,6 +15,7 @@
 #define _HUMINSTRUMENT_H_INCLUDED
 
 #include <stdlib.h>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -50,7 +51,7 @@ class HumInstrument {
 	private:
 		int                            m_index;
 		static std::vector<_HumInstrument>  m_data;
-		static int                     m_classcount;
+		static std::once_flag          m_initialized;
 
 	protected:
 		void       initialize          (void);
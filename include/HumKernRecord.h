@@ -0,0 +1,138 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 22:43:53 UTC 2026
+// Last Modified: Sat Oct 17 11:47:12 UTC 2026
+// Filename:      HumKernRecord.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumKernRecord.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Decoded contents of a **kern token.  The token text is
+//                scanned once and the pitch, rhythm, tie, slur, phrase
+//                and beam information of each note in the token is
+//                stored, so that repeated queries on a token (such as
+//                HumdrumToken::getBase40Pitch() or HumdrumToken::isRest())
+//                do not need to parse the text again.  HumdrumToken
+//                creates a record when one of these functions is first
+//                called.  The record keeps the length and a hash of the
+//                text that it was made from, so that HumdrumToken can
+//                replace it if the text has been changed in any way.
+//
+
+#ifndef _HUMKERNRECORD_H_INCLUDED
+#define _HUMKERNRECORD_H_INCLUDED
+
+#include "HumNum.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+class HumKernNote {
+	public:
+		// Flags which describe the contents of a note (or of the
+		// whole token in HumKernRecord):
+		static const unsigned Rest          = 0x0001;  // 'r'
+		static const unsigned Unpitched     = 0x0002;  // 'R'
+		static const unsigned Grace         = 0x0004;  // 'q'
+		static const unsigned Invisible     = 0x0008;  // "yy"
+		static const unsigned TieStart      = 0x0010;  // '['
+		static const unsigned TieContinue   = 0x0020;  // '_'
+		static const unsigned TieEnd        = 0x0040;  // ']'
+		static const unsigned PitchLetter   = 0x0080;  // a-g or A-G
+		static const unsigned PartialBeam   = 0x0100;  // 'k' or 'K'
+
+		bool     isRest          (void) const { return flags & Rest; }
+		bool     isGrace         (void) const { return flags & Grace; }
+		bool     isInvisible     (void) const { return flags & Invisible; }
+		bool     isUnpitched     (void) const { return flags & Unpitched; }
+		bool     isTieStart      (void) const { return flags & TieStart; }
+		bool     isTieContinue   (void) const { return flags & TieContinue; }
+		bool     isTieEnd        (void) const { return flags & TieEnd; }
+		bool     isSecondaryTie  (void) const
+		                            { return flags & (TieContinue | TieEnd); }
+		int      getBase40Pitch  (void) const;
+		int      getMidiPitch    (void) const;
+
+		int           base40       = 0;  // 0 for rests
+		int           midi         = 0;  // 0 for rests
+		HumNum        duration;          // 0 for grace notes
+		unsigned      flags        = 0;
+		unsigned char dots         = 0;
+		unsigned char slurStarts   = 0;
+		unsigned char slurEnds     = 0;
+		unsigned char phraseStarts = 0;
+		unsigned char phraseEnds   = 0;
+		unsigned char beamStarts   = 0;
+		unsigned char beamEnds     = 0;
+};
+
+
+class HumKernRecord {
+	public:
+		                   HumKernRecord       (const std::string& text);
+
+		int                getNoteCount        (void) const
+		                                          { return (int)m_notes.size(); }
+		const HumKernNote& getNote             (int index) const
+		                                          { return m_notes.at(index); }
+
+		// Information about the token as a whole:
+		bool               isChord             (void) const { return m_chord; }
+		bool               hasFlag             (unsigned flag) const
+		                                          { return m_flags & flag; }
+		bool               isNote              (void) const;
+		bool               isSecondaryTiedNote (void) const;
+		int                getSlurStartCount   (void) const { return m_slurStarts; }
+		int                getSlurEndCount     (void) const { return m_slurEnds; }
+		int                getPhraseStartCount (void) const { return m_phraseStarts; }
+		int                getPhraseEndCount   (void) const { return m_phraseEnds; }
+		int                getBeamStartCount   (void) const { return m_beamStarts; }
+		int                getBeamEndCount     (void) const { return m_beamEnds; }
+		bool               hasBeam             (void) const;
+
+		void               getBase40Pitches    (std::vector<int>& output) const;
+		void               getMidiPitches      (std::vector<int>& output) const;
+
+		bool               isRecordOf          (const std::string& text) const;
+
+	protected:
+		static void        parseNote           (HumKernNote& note,
+		                                        const std::string& text);
+		static uint64_t    getTextHash         (const std::string& text);
+
+	private:
+		// m_notes: The subtokens of the token (one for a single note
+		// or rest, more for a chord).
+		std::vector<HumKernNote> m_notes;
+
+		// m_flags: HumKernNote flags for all characters in the token.
+		unsigned m_flags = 0;
+
+		// m_size, m_hash: Length and hash of the text of the token, used
+		// by isRecordOf() to check that the text has not changed.
+		size_t   m_size = 0;
+		uint64_t m_hash = 0;
+
+		bool m_chord        = false;
+		int  m_slurStarts   = 0;
+		int  m_slurEnds     = 0;
+		int  m_phraseStarts = 0;
+		int  m_phraseEnds   = 0;
+		int  m_beamStarts   = 0;
+		int  m_beamEnds     = 0;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMKERNRECORD_H_INCLUDED */
+
+
+
@@ -7,12 +7,17 @@
 // Syntax:        C++11; humlib
 // vim:           syntax=cpp ts=3 noexpandtab nowrap
 //
-// Description:   Rational number class for durations.
+// Description:   Rational number class for durations.  Arithmetic is
+//                done with 64-bit intermediate values.  A result which
+//                cannot be stored in the 32-bit numerator and denominator
+//                is approximated, and sets an overflow flag for the
+//                calling thread (see hasOverflow()).
 //
 
 #ifndef _HUMNUM_H_INCLUDED
 #define _HUMNUM_H_INCLUDED
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -100,14 +105,23 @@ class HumNum {
 		std::ostream& printList          (std::ostream& out) const;
 		std::ostream& printTwoPart  (std::ostream& out, const std::string& spacer = "+") const;
 
+		static bool hasOverflow     (void);
+		static void clearOverflow   (void);
+
 	protected:
 		void     reduce             (void);
+		void     setReduced         (int64_t numerator, int64_t denominator);
 		int      gcdIterative       (int a, int b);
 		int      gcdRecursive       (int a, int b);
+		static int64_t gcd64        (int64_t a, int64_t b);
 
 	private:
 		int top;
 		int bot;
+
+		// m_overflow: Set to true in a thread when a result in that thread
+		// did not fit into 32-bit integers.
+		static thread_local bool m_overflow;
 };
 
 
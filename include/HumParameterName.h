@@ -0,0 +1,52 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 07:03:47 UTC 2026
+// Last Modified: Sat Oct 17 11:47:16 UTC 2026
+// Filename:      HumParameterName.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumParameterName.h
+// Syntax:        C++17; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Symbol table for the namespaces and keys of HumHash
+//                parameters.  Each name such as "LO", "N" or "vis" is
+//                given a small integer id, and HumHash stores the three
+//                ids of a parameter rather than three strings.  Names
+//                are never removed from the table, which grows as
+//                needed.  The table is shared by all files and is safe
+//                to use from multiple threads: names which are already
+//                in the table are looked up without locking.
+//
+
+#ifndef _HUMPARAMETERNAME_H_INCLUDED
+#define _HUMPARAMETERNAME_H_INCLUDED
+
+#include <string>
+#include <string_view>
+
+namespace hum {
+
+// START_MERGE
+
+class HumParameterName {
+	public:
+		static int                getId        (std::string_view name);
+		static int                findId       (std::string_view name);
+		static const std::string& getName      (int id);
+		static int                getCount     (void);
+
+		// Id of the empty name (no namespace):
+		static const int Empty    = 0;
+
+		// Returned by findId() if the name is not in the table:
+		static const int Unknown  = -1;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMPARAMETERNAME_H_INCLUDED */
+
+
+
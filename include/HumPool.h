@@ -0,0 +1,94 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 20:11:46 UTC 2026
+// Last Modified: Sat Oct 17 10:21:28 UTC 2026
+// Filename:      HumPool.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumPool.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Slab allocator for small, frequently created objects
+//                such as HumdrumToken, HumdrumLine and the spine link
+//                lists of tokens.  Memory is requested from the system in
+//                large slabs which are cut into fixed-size blocks. Deleted
+//                blocks are kept on free lists for reuse by the next file
+//                that is read, so loading and clearing a file costs only
+//                a few system allocations once the pool has warmed up.
+//                Each thread keeps a private cache of free blocks, so the
+//                pool can be used while files are read in parallel.
+//                Slabs are kept until HumPool::trim() finds that all of
+//                their blocks are free and gives them back to the system.
+//                Compile src/HumPool.cpp with HUMLIB_NO_POOL defined to
+//                pass all requests directly to the system allocator.
+//
+
+#ifndef _HUMPOOL_H_INCLUDED
+#define _HUMPOOL_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+class HumPool {
+	public:
+		static void*  allocate         (size_t size);
+		static void   deallocate       (void* ptr, size_t size);
+		static size_t trim             (void);
+
+		// statistics:
+		static size_t getSlabCount     (void);
+		static size_t getReservedBytes (void);
+
+		// Requests larger than this are passed on to the system allocator:
+		static const size_t MaxBlockSize = 512;
+
+		// Blocks sizes are rounded up to a multiple of this value:
+		static const size_t Granularity = 16;
+
+		// Size of slabs requested from the system allocator:
+		static const size_t SlabSize = 64 * 1024;
+};
+
+
+// HumPoolAllocator: STL allocator which takes its memory from HumPool.
+
+template <class TYPE>
+class HumPoolAllocator {
+	public:
+		typedef TYPE value_type;
+
+		HumPoolAllocator(void) noexcept {}
+		template <class OTHER>
+		HumPoolAllocator(const HumPoolAllocator<OTHER>& other) noexcept {}
+
+		TYPE* allocate(size_t count) {
+			return static_cast<TYPE*>(HumPool::allocate(count * sizeof(TYPE)));
+		}
+
+		void deallocate(TYPE* ptr, size_t count) noexcept {
+			HumPool::deallocate(ptr, count * sizeof(TYPE));
+		}
+};
+
+template <class TYPE1, class TYPE2>
+bool operator==(const HumPoolAllocator<TYPE1>& a, const HumPoolAllocator<TYPE2>& b) {
+	return true;
+}
+
+template <class TYPE1, class TYPE2>
+bool operator!=(const HumPoolAllocator<TYPE1>& a, const HumPoolAllocator<TYPE2>& b) {
+	return false;
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMPOOL_H_INCLUDED */
+
+
+
@@ -8,12 +8,16 @@
 // vim:           syntax=cpp ts=3 noexpandtab nowrap
 // note:          Requires GCC v4.9 or higher
 //
-// Description:   Interface to C++11 regular expressions.
+// Description:   Interface to C++11 regular expressions.  Compiled
+//                expressions are kept in a cache shared by all HumRegex
+//                objects, and simple literal expressions are searched
+//                without using std::regex.
 //
 
 #ifndef _HUMREGEX_H_INCLUDED
 #define _HUMREGEX_H_INCLUDED
 
+#include <memory>
 #include <regex>
 #include <string>
 #include <vector>
@@ -22,6 +26,37 @@ namespace hum {
 
 // START_MERGE
 
+class HumRegexPattern {
+	public:
+		HumRegexPattern(const std::string& exp,
+		                std::regex_constants::syntax_option_type flags);
+
+		// m_exp, m_flags: the expression and syntax options used to
+		// construct m_regex (the key for the pattern cache).
+		std::string m_exp;
+		std::regex_constants::syntax_option_type m_flags;
+		std::regex m_regex;
+
+		// m_literal: text which must occur at the start of any match
+		// (empty if unknown).  If m_anchorStart is true, the text must
+		// occur at the start of the searched string.
+		std::string m_literal;
+		bool m_anchorStart = false;
+
+		// m_literalOnly: true if the expression only matches m_literal
+		// (optionally inside of one capture group, and optionally
+		// anchored to the start and/or end of the searched string), so
+		// that std::regex does not need to be used at all.
+		bool m_literalOnly = false;
+		bool m_anchorEnd   = false;
+		bool m_group       = false;
+
+	protected:
+		void analyzeLiteral(void);
+};
+
+
+
 class HumRegex {
 	public:
 		            HumRegex           (void);
@@ -112,22 +147,39 @@ class HumRegex {
 		                                const std::string& buffer,
 		                                const std::string& separator);
 
+		// compiled expression cache (shared by all HumRegex objects):
+		static void setCacheSize       (int size);
+		static int  getCacheSize       (void);
+		static void clearCache         (void);
+		static void setLiteralMatching (bool state);
+		static bool getLiteralMatching (void);
+
 	protected:
 		std::regex_constants::syntax_option_type
 				getTemporaryRegexFlags(const std::string& sflags);
 		std::regex_constants::match_flag_type
 				getTemporarySearchFlags(const std::string& sflags);
 
+		const std::regex& compile      (const std::string& exp,
+		                                std::regex_constants::syntax_option_type flags);
+		int         searchLiteral      (const std::string& input, int startindex);
+		bool        replaceLiteral     (std::string& output, const std::string& input,
+		                                const std::string& replacement,
+		                                std::regex_constants::match_flag_type flags);
+
+		static std::shared_ptr<const HumRegexPattern> getPattern(
+				const std::string& exp,
+				std::regex_constants::syntax_option_type flags);
+
 
 	private:
 
-		// m_regex: stores the regular expression to use as a default.
+		// m_pattern: stores the regular expression which was last used,
+		// which is shared with the pattern cache.
 		//
 		// http://en.cppreference.com/w/cpp/regex/basic_regex
-		// .assign(string) == set the regular expression.
-		// operator=       == set the regular expression.
 		// .flags()        == return syntax_option_type used to construct.
-		std::regex m_regex;
+		std::shared_ptr<const HumRegexPattern> m_pattern;
 
 		// m_matches: stores the matches from a search:
 		//
@@ -144,6 +196,17 @@ class HumRegex {
 		// .end()       == end of submatch list.
 		std::smatch m_matches;
 
+		// m_literal*: stores the result of the last search if it was done
+		// without std::regex (when m_literalSearch is true).  Match
+		// positions are relative to m_literalBase in m_literalInput,
+		// like the positions in m_matches.
+		bool               m_literalSearch = false;
+		const std::string* m_literalInput  = NULL;
+		int                m_literalBase   = 0;
+		int                m_literalStart  = 0;
+		int                m_literalLength = 0;
+		int                m_literalCount  = 0;
+
 		// m_regexflags: store default settings for regex processing
 		// http://en.cppreference.com/w/cpp/regex/syntax_option_type
 		// http://en.cppreference.com/w/cpp/regex/basic_regex
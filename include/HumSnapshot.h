@@ -0,0 +1,125 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 01:26:47 UTC 2026
+// Last Modified: Sat Oct 17 06:21:30 UTC 2026
+// Filename:      HumSnapshot.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumSnapshot.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Binary snapshots of the analyses of a HumdrumFile.
+//                A snapshot stores the spine structure, token links,
+//                tracks, strands, strophes, durations and parameters
+//                (including slur/tie/beam endpoints) of an analyzed file,
+//                with token and line pointers stored as indexes.  The
+//                text of the file is not stored: when the same contents
+//                are read again, the lines are split into tokens and the
+//                analyses are copied from the snapshot rather than being
+//                recalculated.  Snapshots are saved in a cache directory
+//                (set with setCacheDirectory() or the HUMLIB_SNAPSHOT_DIR
+//                environment variable) with filenames based on a hash of
+//                the file contents and the list of read analyses.
+//
+
+#ifndef _HUMSNAPSHOT_H_INCLUDED
+#define _HUMSNAPSHOT_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+class HumdrumFileBase;
+class HumdrumToken;
+class HumdrumLine;
+class HumHash;
+class HumNum;
+
+class HumSnapshot {
+	public:
+		                   HumSnapshot       (void);
+		                  ~HumSnapshot       ();
+
+		bool               write             (HumdrumFileBase& infile,
+		                                      const std::string& filename,
+		                                      std::uint64_t key = 0);
+		bool               read              (HumdrumFileBase& infile,
+		                                      const std::string& filename,
+		                                      std::uint64_t key = 0);
+		bool               writeString       (HumdrumFileBase& infile,
+		                                      std::string& data);
+		bool               readString        (HumdrumFileBase& infile,
+		                                      const std::string& data);
+
+		static bool        writeCache        (HumdrumFileBase& infile,
+		                                      std::uint64_t key);
+		static bool        readCache         (HumdrumFileBase& infile,
+		                                      std::uint64_t key);
+		static void        setCacheDirectory (const std::string& directory);
+		static std::string getCacheDirectory (void);
+		static bool        isCacheEnabled    (void);
+		static std::string getCacheFilename  (std::uint64_t key, unsigned analyses);
+		static std::uint64_t getContentKey   (const char* contents, size_t size);
+		static std::uint64_t getContentKey   (const std::vector<std::pair<const char*,
+		                                      size_t>>& lines);
+
+	protected:
+		void               clear             (void);
+		bool               encode            (HumdrumFileBase& infile, std::uint64_t key);
+		bool               decode            (HumdrumFileBase& infile, std::uint64_t key,
+		                                      const char* data, size_t size);
+		bool               applyRecords      (HumdrumFileBase& infile);
+		bool               checkTokens       (HumdrumLine& line);
+		void               resetLines        (HumdrumFileBase& infile);
+
+		void               putInt            (std::int32_t value);
+		void               putString         (const std::string& value);
+		bool               putToken          (HumdrumToken* token);
+		bool               putHash           (HumHash& hash);
+		bool               putAnalysisValues (HumHash& hash);
+		void               putNum            (const HumNum& value);
+
+		bool               getInt            (std::int32_t& value);
+		bool               getString         (std::string& value);
+		bool               getToken          (HumdrumToken*& token);
+		bool               getHash           (HumHash& hash);
+		bool               getAnalysisValues (HumHash& hash);
+		bool               getNum            (HumNum& value);
+
+		static std::string& cacheDirectory   (void);
+
+	private:
+		// m_data: encoded snapshot (when writing).
+		std::string m_data;
+
+		// m_strings: string table (when writing).
+		std::vector<std::string> m_strings;
+		std::unordered_map<std::string, std::int32_t> m_stringIndex;
+
+		// m_tokenIndex: file-order index of each token (when writing).
+		std::unordered_map<HumdrumToken*, std::int32_t> m_tokenIndex;
+
+		// m_readpos, m_readend: position in the encoded records and the
+		// string table entries (when reading).
+		const char* m_readpos = NULL;
+		const char* m_readend = NULL;
+		std::vector<std::pair<const char*, std::int32_t>> m_table;
+
+		// m_tokens: list of tokens in file order (when reading).
+		std::vector<HumdrumToken*> m_tokens;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMSNAPSHOT_H_INCLUDED */
+
+
+
@@ -0,0 +1,83 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 07:33:05 UTC 2026
+// Last Modified: Sat Oct 17 07:33:05 UTC 2026
+// Filename:      HumSubtokens.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumSubtokens.h
+// Syntax:        C++17; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Iterate over the sub-tokens of a token (such as the
+//                notes of a **kern chord) without copying them.  Each
+//                sub-token is given as a std::string_view into the
+//                original text, so the text and the separator must stay
+//                in memory while the sub-tokens are used.  Empty
+//                sub-tokens are included in the same way as
+//                HumdrumToken::getSubtokenCount() counts them.
+//
+//                for (std::string_view note : HumSubtokens(*token)) { }
+//
+
+#ifndef _HUMSUBTOKENS_H_INCLUDED
+#define _HUMSUBTOKENS_H_INCLUDED
+
+#include <iterator>
+#include <string_view>
+
+namespace hum {
+
+// START_MERGE
+
+class HumSubtokens {
+	public:
+		class iterator {
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef std::string_view          value_type;
+				typedef std::ptrdiff_t            difference_type;
+				typedef const std::string_view*   pointer;
+				typedef const std::string_view&   reference;
+
+				                  iterator    (void);
+				                  iterator    (std::string_view text,
+				                               std::string_view separator);
+				std::string_view  operator*   (void) const { return m_current; }
+				iterator&         operator++  (void);
+				iterator          operator++  (int);
+				bool              operator==  (const iterator& other) const;
+				bool              operator!=  (const iterator& other) const
+				                                 { return !(*this == other); }
+
+			private:
+				void              findEnd     (void);
+
+				std::string_view m_text;
+				std::string_view m_separator;
+				std::string_view m_current;
+				// Offset of the current sub-token in m_text, or npos at end:
+				std::string_view::size_type m_start;
+		};
+
+		                  HumSubtokens  (std::string_view text,
+		                                 std::string_view separator = " ");
+
+		iterator          begin         (void) const;
+		iterator          end           (void) const;
+		int               getCount      (void) const;
+		std::string_view  getSubtoken   (int index) const;
+		std::string_view  front         (void) const;
+
+	private:
+		std::string_view m_text;
+		std::string_view m_separator;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMSUBTOKENS_H_INCLUDED */
+
+
+
@@ -0,0 +1,81 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 20:32:53 UTC 2026
+// Last Modified: Fri Oct 16 20:32:53 UTC 2026
+// Filename:      HumThreadPool.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumThreadPool.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Work-stealing thread pool.  Each worker thread has its
+//                own task queue.  A worker takes tasks from the back of its
+//                own queue, and when the queue is empty it steals tasks from
+//                the front of the other queues, so long tasks on one worker
+//                do not leave the other workers idle.  If threads cannot
+//                be created (such as in single-threaded WebAssembly builds),
+//                tasks are run immediately in the calling thread.
+//
+
+#ifndef _HUMTHREADPOOL_H_INCLUDED
+#define _HUMTHREADPOOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+class HumThreadPool {
+	public:
+		            HumThreadPool          (int threads = 0);
+		           ~HumThreadPool          ();
+
+		void        submit                 (std::function<void(void)> task);
+		void        wait                   (void);
+		int         getThreadCount         (void) const;
+		int         getWorkerIndex         (void) const;
+
+		static int  getHardwareThreadCount (void);
+
+	protected:
+		void        runWorker              (int index);
+		bool        takeTask               (int index, std::function<void(void)>& task);
+		void        runTask                (std::function<void(void)>& task);
+
+	private:
+		// HumThreadPoolQueue: task queue owned by one worker thread.
+		struct HumThreadPoolQueue {
+			std::mutex                              mutex;
+			std::deque<std::function<void(void)>>   tasks;
+		};
+
+		std::vector<std::thread>                         m_threads;
+		std::vector<std::unique_ptr<HumThreadPoolQueue>> m_queues;
+
+		std::mutex                m_mutex;   // protects m_stop and m_exception
+		std::condition_variable   m_wakeup;  // signals new tasks or shutdown
+		std::condition_variable   m_idle;    // signals that m_pending is zero
+		std::atomic<int>          m_queued;  // tasks waiting in queues
+		std::atomic<int>          m_pending; // tasks queued or running
+		std::atomic<unsigned>     m_next;    // queue for next outside submit
+		bool                      m_stop;
+		std::exception_ptr        m_exception;
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMTHREADPOOL_H_INCLUDED */
+
+
+
@@ -28,6 +28,8 @@ class HumTool : public Options {
 		              HumTool         (void);
 		virtual      ~HumTool         ();
 
+		HumTool&      operator=       (const HumTool& tool);
+
 		void          clearOutput     (void);
 
 		bool          hasAnyText      (void);
@@ -58,7 +60,17 @@ class HumTool : public Options {
 
 		virtual void  finally         (void) { };
 
+		unsigned      getRequiredAnalyses(void) const { return m_analyses; }
+		void          setRequiredAnalyses(unsigned mask) { m_analyses = mask;
+		                                                   m_analysesQ = true; }
+		bool          hasRequiredAnalyses(void) const { return m_analysesQ; }
+
+		void          setInPlaceOutput(bool state);
+		bool          hasInPlaceOutput(void);
+
 	protected:
+		void          printEditedFile (HumdrumFile& infile);
+
 		std::stringstream m_humdrum_text;  // output text in Humdrum syntax.
 		std::stringstream m_json_text;     // output text in JSON syntax.
 		std::stringstream m_free_text;     // output for plain text content.
@@ -67,6 +79,24 @@ class HumTool : public Options {
 
 		bool m_suppress = false;
 
+		// m_analyses: bit mask of HumFileAnalysis types that the tool
+		// uses, so that they can be done when the input files are read.
+		unsigned m_analyses = 0;
+
+		// m_analysesQ: true if the tool has declared the analyses that it
+		// uses with setRequiredAnalyses() (so m_analyses = 0 means that
+		// only the spine structure is needed, rather than unknown).
+		bool m_analysesQ = false;
+
+		// m_inplace: true if the caller of the tool (such as the filter
+		// tool) uses the input file after it is edited by the tool, so
+		// printEditedFile() does not print the file to m_humdrum_text.
+		bool m_inplace = false;
+
+		// m_edited: true if printEditedFile() was called while m_inplace
+		// was set, so the edited input file is the Humdrum output.
+		bool m_edited = false;
+
 };
 
 
@@ -175,6 +205,7 @@ int main(int argc, char** argv) {                                          \
 		return -1;                                                           \
 	}                                                                       \
 	hum::HumdrumFileStream instream(static_cast<hum::Options&>(interface)); \
+	instream.setReadAnalyses(interface.getRequiredAnalyses());              \
 	hum::HumdrumFileSet infiles;                                            \
 	bool status = true;                                                     \
 	while (instream.readSingleSegment(infiles)) {                           \
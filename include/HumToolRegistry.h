@@ -0,0 +1,87 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:36:03 UTC 2026
+// Last Modified: Sat Oct 17 09:42:15 UTC 2026
+// Filename:      HumToolRegistry.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumToolRegistry.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Table of the tools which can be run by name (such as
+//                by the filter tool), with their aliases.  Each entry
+//                stores functions to create, reset and run the tool.
+//                Resetting a tool constructs it again in place, so the
+//                same tool object can be used for many files without
+//                allocating a new one for each file.
+//                Tools which edit files in place are marked so that their
+//                output does not have to be parsed again.
+//
+
+#ifndef _HUMTOOLREGISTRY_H_INCLUDED
+#define _HUMTOOLREGISTRY_H_INCLUDED
+
+#include "HumTool.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hum {
+
+// START_MERGE
+
+class HumdrumFile;
+
+class HumToolRegistry {
+	public:
+		class Entry {
+			public:
+				std::string  name;  // name of the tool or alias
+				std::string  tool;  // name of the tool (Tool_ class name suffix)
+
+				// create: allocate a new instance of the tool.
+				HumTool*     (*create)(void);
+
+				// reset: set a tool to its state after construction.
+				void         (*reset)(HumTool* tool);
+
+				// run: run the tool on a file.
+				bool         (*run)(HumTool* tool, HumdrumFile& infile);
+
+				// inplace: true if the tool only edits tokens of the file
+				// and its Humdrum output is the file itself, printed after
+				// createLinesFromTokens().  The filter tool then does not
+				// need to parse the output (unless the tool changed the
+				// spine structure of the file).
+				bool         inplace;
+		};
+
+		static const Entry*             getEntry     (const std::string& name);
+		static bool                     isTool       (const std::string& name);
+		static HumTool*                 createTool   (const std::string& name);
+		static std::vector<std::string> getToolNames (bool aliases = false);
+		static std::vector<std::string> getAliases   (const std::string& tool);
+
+	protected:
+		static const std::vector<Entry>& getEntries  (void);
+		static const std::unordered_map<std::string, const Entry*>& getIndex(void);
+
+		template <class TOOL>
+		static HumTool* newTool       (void);
+		template <class TOOL>
+		static void     resetTool     (HumTool* tool);
+		template <class TOOL>
+		static bool     runTool       (HumTool* tool, HumdrumFile& infile);
+		template <class TOOL>
+		static bool     runToolOnPair (HumTool* tool, HumdrumFile& infile);
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMTOOLREGISTRY_H_INCLUDED */
+
+
+
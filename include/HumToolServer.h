@@ -0,0 +1,170 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:44:01 UTC 2026
+// Last Modified: Sat Oct 17 09:40:08 UTC 2026
+// Filename:      HumToolServer.h
+// URL:           https://github.com/craigsapp/humlib/blob/master/include/HumToolServer.h
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Server which runs pipelines of humlib tools on Humdrum
+//                data for other programs, so that the tools do not have to
+//                be started, and the same files parsed, for each request.
+//                Requests give a tool pipeline (as in !!!filter: lines),
+//                and either a filename or the Humdrum data to process.
+//                Files are read through a HumFileCache, and requests are
+//                processed in parallel on a HumThreadPool.  The Humdrum,
+//                JSON, free text, warning and error outputs of the tools
+//                are returned separately.  On POSIX systems, the server
+//                can listen for requests on a Unix domain socket (see
+//                serve(), sendRequest() and HumToolServer::Client).
+//
+//                Messages on the socket are a list of fields, each
+//                consisting of a line with the field name and the length
+//                of its value in bytes, followed by the bytes of the value.
+//                A line containing "end 0" ends the message.  Request
+//                fields are "command" ("stats" or "stop", or empty to run
+//                the tools), "tools", "options", "file" and "data".
+//                Response fields are "status" (1 if the tools succeeded,
+//                otherwise 0), "humdrum", "json", "text", "warning" and
+//                "error".
+//
+
+#ifndef _HUMTOOLSERVER_H_INCLUDED
+#define _HUMTOOLSERVER_H_INCLUDED
+
+#include "HumFileCache.h"
+#include "tool-filter.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// HUMLIB_SOCKETS is defined on POSIX systems, where HumToolServer can
+// listen for requests on a Unix domain socket.  Define HUMLIB_NO_SOCKETS
+// before including this file to disable sockets.
+#if !defined(HUMLIB_NO_SOCKETS) && !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+	#define HUMLIB_SOCKETS
+#endif
+
+namespace hum {
+
+// START_MERGE
+
+class HumToolServer {
+	public:
+		class Request {
+			public:
+				std::string command;  // "stats", "stop" or empty to run tools
+				std::string tools;    // tool pipeline, such as "autobeam | autostem"
+				std::string options;  // options for the filter tool, such as "-R"
+				std::string filename; // file to process (read through the cache)
+				std::string data;     // Humdrum data to process if no filename
+		};
+
+		class Response {
+			public:
+				bool        status = false;
+				std::string humdrum;
+				std::string json;
+				std::string text;
+				std::string warning;
+				std::string error;
+		};
+
+		// Client: a connection to a server which is kept open for any
+		// number of requests (sendRequest() opens a new connection for
+		// each request).
+		class Client {
+			public:
+				               Client      (void);
+				              ~Client      ();
+				               Client      (const Client&) = delete;
+				Client&        operator=   (const Client&) = delete;
+
+				bool           connect     (const std::string& socketpath,
+				                            std::string& error);
+				bool           isConnected (void) const;
+				void           close       (void);
+				bool           send        (const Request& request, Response& response);
+
+			private:
+				int            m_fd;
+				std::string    m_buffer;   // data read but not used yet
+		};
+
+		               HumToolServer    (int cachesize = 100);
+		              ~HumToolServer    ();
+
+		bool           processRequest   (const Request& request, Response& response);
+		HumFileCache&  getFileCache     (void);
+		std::string    getStatistics    (void);
+
+		bool           serve            (const std::string& socketpath, int jobs = 0);
+		void           stop             (void);
+
+		static bool    sendRequest      (const std::string& socketpath,
+		                                 const Request& request, Response& response);
+		static std::string getDefaultSocket(void);
+
+	protected:
+		// Connection: an open connection to the server, with the data
+		// read from it but not used yet.
+		class Connection {
+			public:
+				int         fd = -1;
+				std::string buffer;
+		};
+
+		std::unique_ptr<Tool_filter> takeFilter(void);
+		void           returnFilter     (std::unique_ptr<Tool_filter> filter);
+		void           serveRequests    (std::shared_ptr<Connection> connection);
+		void           closeConnection  (Connection& connection);
+		void           handleRequest    (const Request& request, Response& response);
+
+		static bool    readMessage      (int fd, std::string& buffer,
+		                                 std::map<std::string, std::string>& fields);
+		static bool    writeMessage     (int fd, const std::vector<std::pair<std::string,
+		                                 std::string>>& fields);
+		static bool    writeData        (int fd, const char* data, size_t size);
+
+	private:
+		// m_cache: files read for requests with a filename.
+		HumFileCache m_cache;
+
+		// m_filters: filters which are not in use by a request.  Each
+		// request takes one and then returns it, so the filters and the
+		// tools that they have created are reused for later requests.
+		std::vector<std::unique_ptr<Tool_filter>> m_filters;
+
+		// m_connections: sockets of open connections, which are shut
+		// down when the server stops.
+		std::set<int> m_connections;
+
+		// m_returned: connections which have been answered and are waiting
+		// for their next request.  The worker threads add them here and
+		// write to m_wakeup so that serve() polls them again.
+		std::vector<std::shared_ptr<Connection>> m_returned;
+		int m_wakeup[2];
+
+		std::mutex             m_mutex;    // protects m_filters, m_connections
+		                                   // and m_returned
+		std::atomic<bool>      m_stop;     // true when serve() should return
+		std::atomic<long long> m_requests; // number of requests processed
+		std::atomic<long long> m_errors;   // number of requests with errors
+};
+
+
+// END_MERGE
+
+} // end namespace hum
+
+#endif /* _HUMTOOLSERVER_H_INCLUDED */
+
+
+
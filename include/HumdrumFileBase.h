@@ -18,12 +18,17 @@
 #ifndef _HUMDRUMFILEBASE_H_INCLUDED
 #define _HUMDRUMFILEBASE_H_INCLUDED
 
+#include "HumFileAnalysis.h"
 #include "HumSignifiers.h"
+#include "HumSnapshot.h"
 #include "HumdrumLine.h"
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 // USING_URI is defined if you want to be able to download Humdrum data
@@ -41,6 +46,14 @@
 	#include <sstream>
 #endif
 
+// HUMLIB_MMAP is defined on POSIX systems, where HumdrumFileBase::read()
+// will memory-map regular files rather than reading them line-by-line
+// through an input stream.  Define HUMLIB_NO_MMAP before including
+// this file to disable memory mapping.
+#if !defined(HUMLIB_NO_MMAP) && !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+	#define HUMLIB_MMAP
+#endif
+
 namespace hum {
 
 // START_MERGE
@@ -93,67 +106,6 @@ class TokenPair {
 };
 
 
-// HumFileAnalysis: class used to manage analysis states for a Humdrum file.
-
-class HumFileAnalysis {
-	public:
-		HumFileAnalysis(void) {}
-		~HumFileAnalysis() { clear(); }
-		void clear(void) {
-			m_structure_analyzed = false;
-			m_rhythm_analyzed    = false;
-			m_strands_analyzed   = false;
-			m_slurs_analyzed     = false;
-			m_beams_analyzed     = false;
-			m_phrases_analyzed   = false;
-			m_nulls_analyzed     = false;
-			m_strophes_analyzed  = false;
-
-			m_barlines_analyzed  = false;
-			m_barlines_different = false;
-		}
-
-		// m_structure_analyzed: Used to keep track of whether or not
-		// file structure has been analyzed.
-		bool m_structure_analyzed = false;
-
-		// m_rhythm_analyzed: Used to keep track of whether or not
-		// rhythm structure has been analyzed.
-		bool m_rhythm_analyzed = false;
-
-		// m_strands_analyzed: Used to keep track of whether or not
-		// file strands have been analyzed.
-		bool m_strands_analyzed = false;
-
-		// m_strophes_analyzed: Used to keep track of whether or not
-		// file strands have been analyzed.
-		bool m_strophes_analyzed = false;
-
-		// m_slurs_analyzed: Used to keep track of whether or not
-		// slur endpoints have been linked or not.
-		bool m_slurs_analyzed = false;
-
-		// m_phrases_analyzed: Used to keep track of whether or not
-		// phrase endpoints have been linked or not.
-		bool m_phrases_analyzed = false;
-
-		// m_beams_analyzed: Used to keep track of whether or not
-		// beam endpoints have been linked or not.
-		bool m_beams_analyzed = false;
-
-		// m_nulls_analyzed: Used to keep track of wheter or not
-		// null tokens have been analyzed yet.
-		bool m_nulls_analyzed = false;
-
-		// m_barlines_analyzed: Used to keep track of wheter or not
-		// barlines have beena analyzed yet.
-		bool m_barlines_analyzed = false;
-		// m_barlines_different: Set to true when the file contains
-		// any barlines that are not all of the same at the same
-		// times.
-		bool m_barlines_different = false;
-};
-
 bool sortTokenPairsByLineIndex(const TokenPair& a, const TokenPair& b);
 
 
@@ -163,7 +115,7 @@ class HumdrumFileBase : public HumHash {
 		              HumdrumFileBase          (HumdrumFileBase& infile);
 		              HumdrumFileBase          (const std::string& contents);
 		              HumdrumFileBase          (std::istream& contents);
-		             ~HumdrumFileBase          ();
+		virtual      ~HumdrumFileBase          ();
 
 		HumdrumFileBase& operator=             (HumdrumFileBase& infile);
 		bool          read                     (std::istream& contents);
@@ -178,6 +130,13 @@ class HumdrumFileBase : public HumHash {
 
 		bool          readString               (const char* contents);
 		bool          readString               (const std::string& contents);
+		bool          readBuffer               (const char* contents,
+		                                        size_t size);
+		bool          readLines                (const std::vector<std::pair<const char*,
+		                                        size_t>>& lines);
+		bool          readSnapshot             (const std::string& contents,
+		                                        const std::string& snapshot);
+		bool          writeSnapshot            (std::string& snapshot);
 		bool          readStringCsv            (const char* contents,
 		                                        const std::string& separator=",");
 		bool          readStringCsv            (const std::string& contents,
@@ -192,6 +151,15 @@ class HumdrumFileBase : public HumHash {
 		bool          isRhythmAnalyzed         (void);
 		bool          areStrandsAnalyzed       (void);
 		bool          areStrophesAnalyzed      (void);
+		bool          isAnalyzed               (int type) const;
+		bool          requireAnalysis          (int type);
+		bool          requireAnalyses          (unsigned mask);
+		void          setReadAnalyses          (unsigned mask);
+		unsigned      getReadAnalyses          (void) const;
+		bool          reanalyzeTokens          (void);
+		bool          hasEditedTokens          (void) const;
+		void          setEditedTokens          (bool state = true);
+		HumAnalysisStore* getAnalysisStore     (bool create = true);
 		void          setFilenameFromSegment   (void);
 
     	template <class TYPE>
@@ -354,6 +322,7 @@ class HumdrumFileBase : public HumHash {
 		bool          analyzeSpines             (void);
 		bool          analyzeLinks              (void);
 		bool          analyzeTracks             (void);
+		void          analyzeDataTypes          (void);
 		bool          analyzeLines              (void);
 
 	protected:
@@ -379,7 +348,7 @@ class HumdrumFileBase : public HumHash {
 		bool          stitchLinesTogether       (HumdrumLine& previous,
 		                                         HumdrumLine& next);
 		void          addToTrackStarts          (HTp token);
-		void          addUniqueTokens           (std::vector<HTp>& target,
+		void          addUniqueTokens           (HumTokenLinks& target,
 		                                         std::vector<HTp>& source);
 		bool          processNonNullDataTokensForTrackForward(HTp starttoken,
 		                                         std::vector<HTp> ptokens);
@@ -388,6 +357,14 @@ class HumdrumFileBase : public HumHash {
 		bool          setParseError             (std::stringstream& err);
 		bool          setParseError             (const std::string& err);
 		bool          setParseError             (const char* format, ...);
+		bool          readMappedFile            (const char* filename);
+		void          splitBuffer               (const char* contents, size_t size);
+		void          splitCsvBuffer            (const char* contents, size_t size,
+		                                         const std::string& separator);
+		bool          analyzeBaseFromCache      (std::uint64_t key);
+		bool          analyzeForRead            (void);
+		virtual bool  runAnalysis               (int type);
+		void          clearAnalysisInfo         (void);
 //		void          fixMerges                 (int linei);
 
 	protected:
@@ -456,6 +433,25 @@ class HumdrumFileBase : public HumHash {
 		// m_analysis: Used to keep track of analysis states for the file.
 		HumFileAnalysis m_analyses;
 
+		// m_analysisValues: Typed storage for the "auto" parameters of
+		// the tokens and lines in the file (see getAnalysisStore()).
+		std::unique_ptr<HumAnalysisStore> m_analysisValues;
+
+		// m_readAnalyses: Analyses which are done when reading the file
+		// (others are done later by requireAnalysis() when needed).
+		unsigned m_readAnalyses = HumFileAnalysis::ReadDefault;
+
+		// m_snapshotKey: content key of the file when it was read
+		// while a snapshot cache directory is set, and the file was not
+		// found in the cache.  A snapshot of the file is saved after the
+		// read analyses are done (see HumSnapshot).
+		std::uint64_t m_snapshotKey = 0;
+		bool m_snapshotPending = false;
+
+		// m_editedTokens: true if the text of a token was changed with
+		// HumdrumToken::setText() since the file was read or reanalyzed.
+		bool m_editedTokens = false;
+
 	public:
 		// Dummy functions to allow the HumdrumFile class's inheritance
 		// to be shifted between HumdrumFileContent (the top-level default),
@@ -482,6 +478,8 @@ class HumdrumFileBase : public HumHash {
 		// HumdrumFileContent public functions:
 		// to be added later
 
+	friend class HumSnapshot;
+	friend class HumdrumFileStream;
 };
 
 std::ostream& operator<<(std::ostream& out, HumdrumFileBase& infile);
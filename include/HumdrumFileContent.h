@@ -111,6 +111,7 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		bool   hasDataStraddle            (int line);
 
 	protected:
+		virtual bool runAnalysis      (int type);
 
 		bool   analyzeKernPhrasings       (HTp spinestart,
 		                                   std::vector<HTp>& linkstarts,
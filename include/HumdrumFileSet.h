@@ -17,6 +17,7 @@
 
 #include "HumdrumFile.h"
 #include "HumdrumFileStream.h"
+#include "HumThreadPool.h"
 #include "Options.h"
 
 #include <iostream>
@@ -64,9 +65,29 @@ class HumdrumFileSet {
       int                   readAppendHumdrum(HumdrumFile& infile);
 		int                   appendHumdrumPointer(HumdrumFile* infile);
 
+      int                   readParallel     (const std::vector<std::string>& filenames);
+      int                   readAppendParallel(const std::vector<std::string>& filenames);
+      void                  setThreadCount   (int count);
+      int                   getThreadCount   (void);
+      void                  setReadAnalyses  (unsigned mask);
+      unsigned              getReadAnalyses  (void) const;
+      std::vector<std::string> getParseErrors(void);
+
    protected:
       std::vector<HumdrumFile*>  m_data;
 
+      // m_threads: number of threads for reading files in parallel.
+      // 1 = read files one at a time; 0 = one thread per hardware thread.
+      int                        m_threads;
+
+      // m_readAnalyses: analyses done on each file after it is read (a bit
+      // mask of HumFileAnalysis types), the same for serial and parallel
+      // reading.
+      unsigned                   m_readAnalyses = 0;
+
+      // m_parseErrors: problems found while reading files in parallel.
+      std::vector<std::string>   m_parseErrors;
+
       void                  appendHumdrumFileContent(const std::string& filename,
                                                std::stringstream& inbuffer);
 };
@@ -25,6 +25,7 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace hum {
@@ -54,6 +55,9 @@ class HumdrumFileStream {
 		int             read               (HumdrumFileSet& infiles);
 		int             readSingleSegment  (HumdrumFileSet& infiles);
 
+		void            setReadAnalyses    (unsigned mask);
+		unsigned        getReadAnalyses    (void) const;
+
 	protected:
 		std::stringstream m_stringbuffer;   // used to read files from a string
 		std::ifstream     m_instream;       // used to read from list of files
@@ -66,10 +70,35 @@ class HumdrumFileStream {
 
 		std::vector<std::string>  m_universals;     // storage for universal comments
 
+		unsigned                  m_readAnalyses = 0; // HumFileAnalysis mask
+
+		// Input buffer: data is read from the current input stream in
+		// chunks, and the lines of the segment being read are parsed
+		// directly from this buffer.  The buffer keeps the current segment
+		// plus one chunk of read-ahead, so it grows only to the size of the
+		// largest segment in the input.
+		std::string               m_input;          // input buffer
+		std::istream*             m_inputstream = NULL; // stream feeding m_input
+		size_t                    m_inputstart = 0; // start of current segment
+		size_t                    m_inputpos = 0;   // next line to read
+		size_t                    m_inputend = 0;   // end of data in m_input
+		bool                      m_inputeof = false; // all lines read
+		std::string               m_carry;          // line carried from last segment
+		std::vector<std::pair<size_t, size_t>> m_lineranges; // segment lines
+
+		// Chunk size for reading from the input stream:
+		static const size_t       InputChunkSize = 64 * 1024;
+
 		// Automatic URL downloading of data from internet in read():
 		void     fillUrlBuffer            (std::stringstream& uribuffer,
 		                                   const std::string& uriname);
 
+		void     resetInput               (void);
+		bool     isInputEof               (std::istream& input);
+		bool     fillInput                (std::istream& input);
+		void     readInputLine            (std::istream& input, size_t& start,
+		                                   size_t& length);
+
 };
 
 
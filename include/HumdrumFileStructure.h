@@ -136,8 +136,19 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		std::string   getKernBelowSignifier        (void);
 		std::string   getPartName                  (HTp sstart);
 
+		// incremental editing (located in src/HumdrumFileStructure-edit.cpp)
+		bool          editLines                    (int index, int count,
+		                                            const std::vector<std::string>& lines);
+		bool          editInsertLine               (int index, const std::string& line);
+		bool          editDeleteLine               (int index);
+		bool          editReplaceLine              (int index, const std::string& line);
+		bool          isLastEditIncremental        (void) const;
+		bool          checkAnalysis                (std::ostream& out = std::cerr);
+		bool          compareAnalysis              (HumdrumFileStructure& reference,
+		                                            std::ostream& out = std::cerr);
 
 	protected:
+		virtual bool  runAnalysis                  (int type);
 		bool          analyzeRhythm                (void);
 		bool          assignRhythmFromRecip        (HTp spinestart);
 		bool          analyzeMeter                 (void);
@@ -146,6 +157,7 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		bool          analyzeLocalParameters       (void);
 		// bool          analyzeParameters            (void);
 		bool          analyzeDurationsOfNonRhythmicSpines(void);
+		bool          checkDurationOverflow        (void);
 		HumNum        getMinDur                    (std::vector<HumNum>& durs,
 		                                            std::vector<HumNum>& durstate);
 		bool          getTokenDurations            (std::vector<HumNum>& durs,
@@ -175,6 +187,42 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		void          analyzeSignifiers            (void);
 		void          setLineRhythmAnalyzed        (void);
 		bool          prepareMensurationInformation(void);
+
+		// incremental editing:
+		bool          editLinesLocally             (int index, int count,
+		                                            std::vector<HLp>& newlines);
+		bool          isLocalEditLine              (HumdrumLine& line);
+		bool          hasLayoutParameterAbove      (int index);
+		bool          reanalyzeEditedFile          (unsigned analyses);
+		HTp           getStrandPredecessor         (HTp token);
+		bool          updateEditedNulls            (HLp next, std::vector<HLp>& newlines);
+		bool          updateEditedStrophes         (HLp next, std::vector<HLp>& newlines,
+		                                            bool interpretations);
+		void          reanalyzeEditedStrophes      (void);
+		bool          getNonNullEditContext        (HTp first, HLp next, int field,
+		                                            std::vector<HLp>& oldlines,
+		                                            std::vector<HLp>& newlines,
+		                                            std::vector<HTp>& before,
+		                                            std::vector<HTp>& after,
+		                                            HTp& previous, HTp& following,
+		                                            bool& reach);
+		void          linkNonNullDataTokens        (std::vector<HTp>& tokens,
+		                                            HTp previous, HTp following,
+		                                            bool reach);
+		bool          isTimedLine                  (HumdrumLine& line);
+		bool          getEditStartTime             (HTp token, HumNum& time);
+		bool          updateEditedRhythm           (int index, int count,
+		                                            HLp next, std::vector<HLp>& newlines,
+		                                            bool spined, bool barlines);
+		void          analyzeMeterRegion           (int first, int last);
+		bool          updateNonRhythmicDurations   (int first, int last);
+		bool          setNonRhythmicDuration       (HTp token);
+		bool          reanalyzeEditedRhythm        (void);
+		std::string   getEditPosition              (HTp token);
+
+		// m_lastEditIncremental: true if the last edit with editLines() was
+		// analyzed without re-analyzing the entire file.
+		bool          m_lastEditIncremental = false;
 };
 
 
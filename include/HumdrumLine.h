@@ -39,6 +39,11 @@ class HumdrumLine : public std::string, public HumHash {
 		            HumdrumLine            (HumdrumLine& line, void* owner);
 		           ~HumdrumLine            ();
 
+		static void* operator new          (size_t size)
+		                                  { return HumPool::allocate(size); }
+		static void  operator delete       (void* ptr, size_t size)
+		                                  { HumPool::deallocate(ptr, size); }
+
 		HumdrumLine& operator=             (HumdrumLine& line);
 		bool        isComment              (void) const;
 		bool        isCommentLocal         (void) const;
@@ -275,6 +280,7 @@ class HumdrumLine : public std::string, public HumHash {
 	friend class HumdrumFileStructure;
 	friend class HumdrumFileContent;
 	friend class HumdrumFile;
+	friend class HumSnapshot;
 };
 
 std::ostream& operator<< (std::ostream& out, HumdrumLine& line);
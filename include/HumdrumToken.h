@@ -14,16 +14,22 @@
 #define _HUMDRUMTOKEN_H_INCLUDED
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class HumParamSet;
 
 #include "HumNum.h"
 #include "HumAddress.h"
+#include "HumDataType.h"
 #include "HumHash.h"
+#include "HumKernRecord.h"
 #include "HumParamSet.h"
+#include "HumPool.h"
+#include "HumSubtokens.h"
 
 namespace hum {
 
@@ -32,6 +38,11 @@ namespace hum {
 
 typedef HumdrumToken* HTp;
 
+// HumTokenLinks: list type for the spine links between tokens.  These
+// lists are usually only one or two entries long, so their storage is
+// taken from HumPool rather than the system allocator.
+typedef std::vector<HTp, HumPoolAllocator<HTp>> HumTokenLinks;
+
 class HumdrumToken : public std::string, public HumHash {
 	public:
 		         HumdrumToken              (void);
@@ -41,8 +52,14 @@ class HumdrumToken : public std::string, public HumHash {
 		         HumdrumToken              (HumdrumToken* token, HLp owner);
 		         HumdrumToken              (const char* token);
 		         HumdrumToken              (const std::string& token);
+		         HumdrumToken              (const char* token, size_t length);
 		        ~HumdrumToken              ();
 
+		static void* operator new          (size_t size)
+		                                  { return HumPool::allocate(size); }
+		static void  operator delete       (void* ptr, size_t size)
+		                                  { HumPool::deallocate(ptr, size); }
+
 		bool     isNull                    (void) const;
 		bool     isNullToken               (void) const { return isNull(); }
 		bool     isManipulator             (void) const;
@@ -151,6 +168,8 @@ class HumdrumToken : public std::string, public HumHash {
 		bool     hasObliquaLigatureEnd     (void);
 		char     hasStemDirection          (void);
 		bool     allSameBarlineStyle       (void);
+		const HumKernRecord& getKernRecord (void) const;
+		void     clearKernRecord           (void);
 
 
 		// pitch-related functions (in HumdrumToken-midi.cpp):
@@ -235,13 +254,15 @@ class HumdrumToken : public std::string, public HumHash {
 		int      getTokenNumber            (void) const;
 		const std::string& getDataType     (void) const;
 		const std::string& getExInterp     (void) { return getDataType(); }
+		int      getDataTypeId             (void) const;
 		bool     isDataType                (const std::string& dtype) const;
+		bool     isDataType                (int id) const;
 		bool     isDataTypeLike            (const std::string& dtype) const;
 		bool     isKern                    (void) const;
 		bool     isKernLike                (void) const;
 		bool     isMens                    (void) const;
 		bool     isMensLike                (void) const;
-		bool     isStaffLike               (void) const { return isKernLike() || isMensLike(); }
+		bool     isStaffLike               (void) const { return HumDataType::isStaffLike(getDataTypeId()); }
 		std::string   getSpineInfo         (void) const;
 		int      getTrack                  (void) const;
 		int      getSpineIndex             (void) const;
@@ -252,6 +273,7 @@ class HumdrumToken : public std::string, public HumHash {
 		std::string   getSubtoken          (int index,
 		                                    const std::string& separator = " ") const;
 		std::vector<std::string> getSubtokens (const std::string& separator = " ") const;
+		HumSubtokens getSubtokenViews      (std::string_view separator = " ") const;
 		void     replaceSubtoken           (int index, const std::string& newsubtok,
 		                                    const std::string& separator = " ");
 		void     setParameters             (HTp ptok);
@@ -366,6 +388,8 @@ class HumdrumToken : public std::string, public HumHash {
 		void     makeForwardLink           (HumdrumToken& nextToken);
 		void     makeBackwardLink          (HumdrumToken& previousToken);
 		void     setOwner                  (HLp aLine);
+		void     requireFileAnalysis       (int type);
+		void     setDataTypeId             (int id);
 		int      getState                  (void) const;
 		void     incrementState            (void);
 		void     setDuration               (const HumNum& dur);
@@ -400,22 +424,22 @@ class HumdrumToken : public std::string, public HumHash {
 		// following token, but there can be two tokens if the current
 		// token is *^, and there will be zero following tokens after a
 		// spine terminating token (*-).
-		std::vector<HTp> m_nextTokens;     // link to next token(s) in spine
+		HumTokenLinks m_nextTokens;     // link to next token(s) in spine
 
 		// previousTokens: Simiar to nextTokens, but for the immediately
 		// follow token(s) in the data.  Typically there will be one
 		// preceding token, but there can be multiple tokens when the previous
 		// line has *v merge tokens for the spine.  Exclusive interpretations
 		// have no tokens preceding them.
-		std::vector<HTp> m_previousTokens; // link to last token(s) in spine
+		HumTokenLinks m_previousTokens; // link to last token(s) in spine
 
 		// nextNonNullTokens: This is a list of non-tokens in the spine
 		// that follow this one.
-		std::vector<HTp> m_nextNonNullTokens;
+		HumTokenLinks m_nextNonNullTokens;
 
 		// previousNonNullTokens: This is a list of non-tokens in the spine
 		// that preced this one.
-		std::vector<HTp> m_previousNonNullTokens;
+		HumTokenLinks m_previousNonNullTokens;
 
 		// rhycheck: Used to perfrom HumdrumFileStructure::analyzeRhythm
 		// recursively.
@@ -446,11 +470,18 @@ class HumdrumToken : public std::string, public HumHash {
 		// NULL means that it is not in a strophe.
 		HTp m_strophe = NULL;
 
+		// m_kernRecord: Decoded **kern note information, created the
+		// first time it is needed by getKernRecord(), and replaced there
+		// if the text of the token has changed.  The pointer is atomic so
+		// that several threads can read the same token at once.
+		mutable std::atomic<HumKernRecord*> m_kernRecord{NULL};
+
 	friend class HumdrumLine;
 	friend class HumdrumFileBase;
 	friend class HumdrumFileStructure;
 	friend class HumdrumFileContent;
 	friend class HumdrumFile;
+	friend class HumSnapshot;
 };
 
 
@@ -27,19 +27,20 @@ namespace hum {
 // START_MERGE
 
 #define GRIDREST NAN
+#define GRIDREST40 (-32768)
 
 class NoteGrid;
 
 
 class NoteCell {
 	public:
-		       NoteCell             (NoteGrid* owner, HTp token);
+		       NoteCell             (NoteGrid* owner, int voice, int slice);
 		      ~NoteCell             (void) { clear();                    }
 
-		double getSgnDiatonicPitch  (void) { return m_b7;                }
-		double getSgnMidiPitch      (void) { return m_b12;               }
-		double getSgnBase40Pitch    (void) { return m_b40;               }
-		double getSgnAccidental     (void) { return m_accidental;        }
+		double getSgnDiatonicPitch  (void);
+		double getSgnMidiPitch      (void);
+		double getSgnBase40Pitch    (void);
+		double getSgnAccidental     (void);
 
 		double getSgnDiatonicPitchClass(void);
 		double getAbsDiatonicPitchClass(void);
@@ -47,15 +48,15 @@ class NoteCell {
 		double getSgnBase40PitchClass(void);
 		double getAbsBase40PitchClass(void);
 
-		double getAbsDiatonicPitch  (void) { return fabs(m_b7);          }
-		double getAbsMidiPitch      (void) { return fabs(m_b12);         }
-		double getAbsBase40Pitch    (void) { return fabs(m_b40);         }
-		double getAbsAccidental     (void) { return fabs(m_accidental);  }
+		double getAbsDiatonicPitch  (void) { return fabs(getSgnDiatonicPitch()); }
+		double getAbsMidiPitch      (void) { return fabs(getSgnMidiPitch());     }
+		double getAbsBase40Pitch    (void) { return fabs(getSgnBase40Pitch());   }
+		double getAbsAccidental     (void) { return fabs(getSgnAccidental());    }
 
-		HTp    getToken             (void) { return m_token;             }
-		int    getNextAttackIndex   (void) { return m_nextAttackIndex;   }
-		int    getPrevAttackIndex   (void) { return m_prevAttackIndex;   }
-		int    getCurrAttackIndex   (void) { return m_currAttackIndex;   }
+		HTp    getToken             (void);
+		int    getNextAttackIndex   (void);
+		int    getPrevAttackIndex   (void);
+		int    getCurrAttackIndex   (void);
 		int    getSliceIndex        (void) { return m_timeslice;         }
 		int    getVoiceIndex        (void) { return m_voice;             }
 
@@ -77,42 +78,22 @@ class NoteCell {
 		double getMetricLevel       (void);
 		HumNum getDurationFromStart (void);
 		HumNum getDuration          (void);
-		void   setMeter             (int topval, HumNum botval);
 		int    getMeterTop          (void);
 		HumNum getMeterBottom       (void);
-
-		std::vector<HTp> m_tiedtokens;  // list of tied notes/rests after note attack
+		std::vector<HTp> getTiedTokens(void);
 
 	protected:
 		void clear                  (void);
-		void calculateNumericPitches(void);
-		void setVoiceIndex          (int index) { m_voice = index;           }
-		void setSliceIndex          (int index) { m_timeslice = index;       }
-		void setNextAttackIndex     (int index) { m_nextAttackIndex = index; }
-		void setPrevAttackIndex     (int index) { m_prevAttackIndex = index; }
-		void setCurrAttackIndex     (int index) { m_currAttackIndex = index; }
 
 	private:
+		// The note data is stored in the arrays of the owning NoteGrid,
+		// so a cell is only a view of one position in the grid.
 		NoteGrid* m_owner; // the NoteGrid to which this cell belongs.
-		HTp m_token;       // pointer to the note in the origina Humdrum file.
 		int m_voice;       // index of the voice in the score the note belongs
 		                   // 0=bottom voice (HumdrumFile ordering of parts)
 		                   // column in NoteGrid.
 		int m_timeslice;   // index for the row in NoteGrid.
 
-		double m_b7;         // diatonic note number; NaN=rest; negative=sustain.
-		double m_b12;        // MIDI note number; NaN=rest; negative=sustain.
-		double m_b40;        // base-40 note number; NaN=rest; negative=sustain.
-		double m_accidental; // chromatic alteration of a diatonic pitch.
-		                     // NaN=no accidental.
-		int m_nextAttackIndex; // index to next note attack (or rest),
-		                       // -1 for undefined (interpred as rest).
-		int m_prevAttackIndex; // index to previous note attack.
-		int m_currAttackIndex; // index to current note attack (useful for
-		                       // finding the start of a sustained note.
-		int m_metertop = 0;    // top number of prevailing meter signature
-		HumNum m_meterbot = 0; // bottom number of prevailing meter signature
-
 	friend NoteGrid;
 };
 
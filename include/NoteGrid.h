@@ -67,16 +67,36 @@ class NoteGrid {
 		void       getNoteAndRestAttacks (vector<NoteCell*>& attacks, int vindex);
 		double     getMetricLevel        (int sindex);
 		HumNum     getNoteDuration       (int vindex, int sindex);
+		size_t     getStorageSize        (void);
 
 	protected:
-		void       buildAttackIndexes    (void);
-		void       buildAttackIndex      (int vindex);
+		void       buildAttackIndexes    (bool indexes = true);
+		void       buildAttackIndex      (int vindex, bool indexes = true);
+		void       buildCellViews        (void);
+		int        getMeterIndex         (int top, HumNum bot);
+		void       addCell               (int vindex, HTp token, int meter);
+		vector<HTp> getTiedTokens        (int vindex, int sindex);
+
+		// Bits in m_flags:
+		enum { CellAttack = 1, CellRest = 2, CellSustain = 4 };
 
 	private:
-		vector<vector<NoteCell*> > m_grid;
+		// Per-voice arrays with one entry for each slice:
+		vector<vector<NoteCell> >  m_grid;      // views of the cells
+		vector<vector<HTp> >       m_tokens;    // note/rest/null token of cell
+		vector<vector<short> >     m_base40;    // GRIDREST40=rest, negative=sustain
+		vector<vector<char> >      m_flags;     // CellAttack|CellRest|CellSustain
+		vector<vector<int> >       m_prevattack;
+		vector<vector<int> >       m_currattack;
+		vector<vector<int> >       m_nextattack;
+		vector<vector<short> >     m_meter;     // index into m_meters
+
+		vector<pair<int, HumNum> > m_meters;    // distinct meter signatures
 		vector<HTp>                m_kernspines;
 		vector<double>             m_metriclevels;
-		HumdrumFile*               m_infile;
+		HumdrumFile*               m_infile = NULL;
+
+	friend NoteCell;
 };
 
 
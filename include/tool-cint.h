@@ -70,7 +70,7 @@ class Tool_cint : public HumTool {
 
 	protected:
 
-		void      initialize           (void);
+		bool      initialize           (void);
 		void      example              (void);
 		void      usage                (const std::string& command);
 		int       processFile          (HumdrumFile& infile);
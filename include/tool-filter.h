@@ -14,8 +14,13 @@
 #define _TOOL_FILTER_H_INCLUDED
 
 #include "HumTool.h"
+#include "HumToolRegistry.h"
 #include "HumdrumFileSet.h"
+#include "HumdrumFileStream.h"
 
+#include <map>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -29,11 +34,19 @@ class Tool_filter : public HumTool {
 		         Tool_filter        (void);
 		        ~Tool_filter        () {};
 
+		// Filters own the tools that they run, so they are not copied:
+		Tool_filter&  operator=     (const Tool_filter& filter) = delete;
+
 		bool     run                (HumdrumFileSet& infiles);
 		bool     run                (HumdrumFile& infile);
 		bool     run                (const std::string& indata);
 
 		bool     runUniversal       (HumdrumFileSet& infiles);
+		bool     runPipeline        (HumdrumFile& infile, const std::string& pipeline);
+
+		bool     runBatch           (HumdrumFileStream& instream, std::ostream& out,
+		                             int jobs = 0, int window = 0);
+		const std::vector<std::string>& getBatchErrors(void) const;
 
 	protected:
 		void     getCommandList     (std::vector<std::pair<std::string, std::string> >& commands,
@@ -44,10 +57,57 @@ class Tool_filter : public HumTool {
 		void     removeGlobalFilterLines    (HumdrumFile& infile);
 		void     removeUniversalFilterLines (HumdrumFileSet& infiles);
 		void     splitPipeline      (std::vector<std::string>& clist, const std::string& command);
+		bool     runStage           (const HumToolRegistry::Entry& entry,
+		                             HumdrumFile& infile, const std::string& command);
+		HumTool* getStageTool       (const HumToolRegistry::Entry& entry);
+		void     startAnalyses      (HumdrumFile& infile);
+		void     finishAnalyses     (HumdrumFile& infile, bool analyze);
+		void     startStage         (HumdrumFile& infile);
+		void     startStage         (HumdrumFileSet& infiles);
+		void     finishStage        (HumdrumFile& infile, const std::string& output);
+		void     finishStage        (HumdrumFile& infile);
+		void     finishStage        (HumdrumFileSet& infiles, const std::string& output);
+		bool     isStageInPlace     (HumdrumFile& infile);
+		std::string getTokenText    (HLp line);
+		std::ostream& getStageErrorStream(void);
 
 	private:
 		std::string   m_variant;        // used with -v option.
 		bool     m_debugQ = false; // used with --debug option
+		bool     m_reparseQ = false; // used with -R option
+
+		// m_tools: tools used by the filter stages, by tool name.
+		std::map<std::string, std::unique_ptr<HumTool>> m_tools;
+
+		// m_batchQ: true when filtering one file of runBatch() or running
+		// runPipeline(), so that error messages are stored with the file
+		// rather than printed, and bad tool options do not end the program.
+		bool     m_batchQ = false;
+
+		// m_batchErrors: error messages for the files of runBatch(),
+		// in file order.
+		std::vector<std::string> m_batchErrors;
+
+		// m_stageLines: lines of the file before the current filter stage.
+		std::vector<HLp> m_stageLines;
+
+		// m_stageTokens: tokens of the file before the current filter stage.
+		std::vector<HTp> m_stageTokens;
+
+		// m_stageSpines: text of manipulator and exclusive interpretation
+		// lines before the current filter stage.
+		std::vector<std::string> m_stageSpines;
+
+		// m_fileAnalyses: read analyses of the file being filtered, which
+		// are not done when the file is read again after a stage (see
+		// startAnalyses()).
+		unsigned m_fileAnalyses = 0;
+
+		// m_stageAnalyses: analyses which the next stage does for tools
+		// that have not declared the analyses that they use: none for the
+		// first stage, and m_fileAnalyses after the file has been read
+		// again or re-analyzed.
+		unsigned m_stageAnalyses = 0;
 
 };
 
@@ -19,6 +19,7 @@
 
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace hum {
@@ -90,6 +91,56 @@ class NotePoint {
 };
 
 
+// TimePointAlignment aligns the time points of two files by comparing the
+// notes which start at each time point.  Gaps have an affine cost (open +
+// extend * length), and the alignment is calculated in linear memory with
+// the divide-and-conquer method of Myers and Miller (1988), only visiting
+// cells within a band around the diagonal between the two sequences.
+class TimePointAlignment {
+	public:
+		            TimePointAlignment    (void);
+
+		void        setBand               (int band);
+		void        setGapCosts           (int open, int extend);
+		void        setSequences          (std::vector<std::vector<NotePoint>>& notes1,
+		                                   std::vector<std::vector<NotePoint>>& notes2);
+		int         align                 (std::vector<std::pair<int, int>>& path);
+		int         getSubstitutionCost   (int index1, int index2);
+		int         getPathCost           (std::vector<std::pair<int, int>>& path);
+
+	protected:
+		void        prepareKeys           (std::vector<std::vector<NotePoint>>& notes,
+		                                   std::vector<std::vector<long long>>& keys,
+		                                   std::vector<unsigned long long>& hashes);
+		int         alignRange            (int start1, int start2, int size1,
+		                                   int size2, int gapstart, int gapend);
+		int         getGapCost            (int length);
+		int         getBandStart          (int index1);
+		int         getBandEnd            (int index1);
+
+	private:
+		// Sorted pitch/duration keys of the notes at each time point,
+		// and a hash of the keys for quickly finding identical time points:
+		std::vector<std::vector<long long>> m_keys1;
+		std::vector<std::vector<long long>> m_keys2;
+		std::vector<unsigned long long>     m_hashes1;
+		std::vector<unsigned long long>     m_hashes2;
+
+		int m_band      = 0;   // half-width of band (0 = automatic)
+		int m_width     = 0;   // half-width of band used in alignment
+		int m_gapopen   = 6;
+		int m_gapextend = 2;
+
+		// Rows of the forward (m_cc, m_dd) and reverse (m_rr, m_ss) passes:
+		std::vector<int> m_cc;
+		std::vector<int> m_dd;
+		std::vector<int> m_rr;
+		std::vector<int> m_ss;
+
+		std::vector<std::pair<int, int>>* m_path = NULL;
+};
+
+
 // Function declarations:
 
 class Tool_humdiff : public HumTool {
@@ -104,7 +155,9 @@ class Tool_humdiff : public HumTool {
 		void     compareTimePoints  (std::vector<std::vector<TimePoint>>& timepoints, HumdrumFile& reference, HumdrumFile& alternate);
 		void     extractTimePoints  (std::vector<TimePoint>& points, HumdrumFile& infile);
 		void     printTimePoints    (std::vector<TimePoint>& timepoints);
-		void     compareLines       (HumNum minval, std::vector<int>& indexes, std::vector<std::vector<TimePoint>>& timepoints, std::vector<HumdrumFile*> infiles);
+		void     compareLines       (std::vector<std::vector<NotePoint>>& notelist, std::vector<HumdrumFile*>& infiles, int altline);
+		void     printEdit          (const std::string& operation, int refline, int altline, std::vector<NotePoint>* refnotes, std::vector<NotePoint>* altnotes);
+		std::string getUnmatchedNotes (std::vector<NotePoint>* notes, bool reference);
 		void     getNoteList        (std::vector<NotePoint>& notelist, HumdrumFile& infile, int line, int measure, int sourceindex, int tpindex);
 		int      findNoteInList     (NotePoint& np, std::vector<NotePoint>& nps);
 		void     printNotePoints    (std::vector<NotePoint>& notelist);
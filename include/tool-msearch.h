@@ -18,6 +18,14 @@
 #include "NoteGrid.h"
 #include "Convert.h"
 
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace hum {
 
 // START_MERGE
@@ -318,6 +326,132 @@ class TextInfo {
 };
 
 
+//////////////////////////////
+//
+// MSearchIndex -- Inverted index of the melodic n-grams in a set of
+//    files, used by msearch to find the voices and positions where a
+//    query may match, rather than checking every note of every file.
+//    For each voice of a file, the n-grams of consecutive note/rest
+//    attacks are indexed by pitch class (base-40, base-12 and base-7),
+//    by diatonic and chromatic interval to the next attack, and by
+//    duration.  The index only gives candidates: matches must still be
+//    checked, and files which are not in the index must be searched in
+//    full.  Files are identified by a hash of their tokens.
+//
+
+class MSearchIndex {
+	public:
+		                 MSearchIndex      (int gramlength = 3);
+		                ~MSearchIndex      ();
+
+		void             clear             (void);
+		int              getGramLength     (void);
+		int              getFileCount      (void);
+		size_t           getGramCount      (void);
+
+		bool             addFile           (HumdrumFile& infile);
+		bool             write             (const std::string& filename);
+
+		bool             read              (const std::string& filename);
+		bool             getCandidates     (HumdrumFile& infile,
+		                                    std::vector<MSearchQueryToken>& query,
+		                                    std::vector<std::pair<int, int>>& candidates);
+
+		static std::uint64_t getFileKey    (HumdrumFile& infile);
+
+		// Features of notes and query tokens (also used by MSearchAutomaton):
+		typedef std::pair<std::int64_t, std::int64_t> Feature;
+		static int       getFeatureKinds   (void);
+		static bool      getNoteFeatures   (std::vector<NoteCell*>& notes,
+		                                    std::vector<std::vector<Feature>>& features);
+		static bool      getQueryFeature   (MSearchQueryToken& token, int kind,
+		                                    Feature& feature);
+
+	protected:
+		std::uint64_t    getGramKey        (int kind, const Feature* features);
+		bool             findGram          (std::uint64_t key, std::uint64_t& offset,
+		                                    std::uint32_t& count);
+		void             loadCandidates    (std::uint64_t offset, std::uint32_t count,
+		                                    int shift);
+		void             unmap             (void);
+
+		static void      appendInt         (std::string& output, std::uint64_t value,
+		                                    int bytes);
+		static std::uint64_t readInt       (const char* data, int bytes);
+
+	private:
+		int m_gramlength;
+
+		// Index being built: file keys (in order of file number), and
+		// the list of file/voice/position entries for each n-gram key.
+		std::unordered_map<std::uint64_t, std::uint32_t> m_files;
+		std::unordered_map<std::uint64_t, std::vector<std::uint64_t>> m_grams;
+
+		// Index which has been read: the n-gram table and entry lists
+		// are used directly from the (memory-mapped) file contents.
+		std::string  m_buffer;
+		const char*  m_data = NULL;
+		size_t       m_size = 0;
+		void*        m_map  = NULL;
+		std::uint64_t m_gramcount = 0;
+		const char*  m_table = NULL;
+		const char*  m_entries = NULL;
+
+		// Candidates for the last n-gram looked up, for each file number,
+		// since the query is usually the same for each file that is searched.
+		std::uint64_t m_lastoffset = 0;
+		int           m_lastshift = -1;
+		std::unordered_map<std::uint32_t, std::vector<std::pair<int, int>>> m_candidates;
+};
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton -- Find candidate matches for many queries in one
+//    pass over each voice.  For each query, the longest run of tokens
+//    which require specific values of one kind of feature (pitch class,
+//    interval or duration, as in MSearchIndex) is added as a pattern to
+//    an Aho-Corasick automaton for that kind of feature.  The automata
+//    are run together over the notes of a voice, and each pattern found
+//    gives a position where its query may match.  Queries without such
+//    a run (or with a harmonic search) must be checked at all positions.
+//
+
+class MSearchAutomaton {
+	public:
+		                 MSearchAutomaton  (void);
+		                ~MSearchAutomaton  () {}
+
+		void             clear             (void);
+		int              addQuery          (std::vector<MSearchQueryToken>& query);
+		int              getQueryCount     (void);
+		bool             hasPattern        (int query);
+		bool             search            (std::vector<std::vector<NoteCell*>>& attacks,
+		                                    std::vector<std::vector<std::pair<int, int>>>& candidates);
+
+	protected:
+		class Trie {
+			public:
+				std::map<MSearchIndex::Feature, int> symbols;
+				std::vector<std::map<int, int>> next;    // child states for each symbol
+				std::vector<int>                fail;    // longest proper suffix state
+				std::vector<std::vector<int>>   output;  // queries ending at each state
+		};
+
+		void             build             (void);
+		int              advance           (Trie& trie, int state, const MSearchIndex::Feature& feature);
+
+	private:
+		std::vector<Trie> m_tries;     // automaton for each kind of feature
+		std::vector<int>  m_kind;      // kind of feature of each query's pattern (-1 for none)
+		std::vector<int>  m_length;    // number of tokens in each query's pattern
+		std::vector<int>  m_shift;     // index of the pattern in each query
+		bool              m_built = false;
+};
+
+
+
 class Tool_msearch : public HumTool {
 	public:
 		         Tool_msearch      (void);
@@ -329,12 +463,22 @@ class Tool_msearch : public HumTool {
 		bool     run               (HumdrumFile& infile, ostream& out);
 
 	protected:
-		void    initialize         (void);
+		void    initialize         (HumdrumFile& infile);
 		void    doMusicSearch      (HumdrumFile& infile, NoteGrid& grid,
 		                            vector<MSearchQueryToken>& query);
+		int     markMusicMatches   (HumdrumFile& infile,
+		                            vector<vector<NoteCell*>>& attacks,
+		                            vector<MSearchQueryToken>& query,
+		                            vector<pair<int, int>>* candidates);
+		void    addMusicSearchResults(HumdrumFile& infile, int mcount);
+		bool    doQueryListSearch  (HumdrumFile& infile);
+		bool    loadQueryList      (const std::string& filename);
 		bool    doHarmonicPitchSearch(MSearchQueryToken& query, HTp token);
 		void    doTextSearch       (HumdrumFile& infile, NoteGrid& grid,
 		                            vector<MSearchTextQuery>& query);
+		int     markTextMatches    (HumdrumFile& infile,
+		                            vector<MSearchTextQuery>& query);
+		void    addTextSearchResults(HumdrumFile& infile, int tcount);
 		void    fillMusicQuery     (vector<MSearchQueryToken>& query);
 		void    fillMusicQueryInterleaved(vector<MSearchQueryToken>& query,
 		                            const std::string& input, bool rhythmQ = false);
@@ -367,6 +511,9 @@ class Tool_msearch : public HumTool {
 		int     checkHarmonicPitchMatch (SonorityNoteData& query,
 		                           SonorityDatabase& sonorities, bool suppressQ);
 		bool    checkVerticalOnly  (const std::string& input);
+		bool    getIndexCandidates (HumdrumFile& infile,
+		                            vector<MSearchQueryToken>& query,
+		                            vector<pair<int, int>>& candidates);
 		void    makeLowerCase      (std::string& inout);
 
 	private:
@@ -383,6 +530,19 @@ class Tool_msearch : public HumTool {
 		std::vector<SonorityDatabase> m_sonorities;
 		std::vector<bool> m_sonoritiesChecked;
 		std::vector<pair<HTp, int>> m_tomark;
+
+		// m_index: n-gram index given with the --index option, which is
+		// kept for later files searched by the tool.
+		std::shared_ptr<MSearchIndex> m_index;
+		std::string m_indexfile;
+
+		// m_querytools: a tool for the options of each query in the list
+		// given with the --queries option, with the parsed music query in
+		// m_queries, and the patterns of the queries in m_automaton.
+		std::vector<std::shared_ptr<Tool_msearch>> m_querytools;
+		std::vector<std::vector<MSearchQueryToken>> m_queries;
+		MSearchAutomaton m_automaton;
+		std::string      m_queryfile;
 };
 
 // END_MERGE
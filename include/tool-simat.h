@@ -64,8 +64,13 @@ class MeasureDataSet {
 	public:
 		             MeasureDataSet   (void);
 		             MeasureDataSet   (HumdrumFile& infile);
+		             MeasureDataSet   (const MeasureDataSet& set) = delete;
 		            ~MeasureDataSet   ();
 
+		// The measures are owned by the set, so it cannot be copied (this
+		// also keeps HumToolRegistry from resetting Tool_simat by copying):
+		MeasureDataSet& operator=     (const MeasureDataSet& set) = delete;
+
 		void         clear            (void);
 		int          parse            (HumdrumFile& infile);
 		MeasureData& operator[]       (int index);
@@ -97,16 +102,81 @@ class MeasureComparison {
 
 
 
+class MeasureCorrelationMatrix {
+	public:
+		             MeasureCorrelationMatrix  (void);
+		             MeasureCorrelationMatrix  (const MeasureCorrelationMatrix& matrix) = delete;
+		            ~MeasureCorrelationMatrix  ();
+
+		// m_rows and m_columns point into the storage of the matrix:
+		MeasureCorrelationMatrix& operator=    (const MeasureCorrelationMatrix& matrix) = delete;
+
+		void         clear                     (void);
+		void         setRows                   (MeasureDataSet& set);
+		int          addColumns                (MeasureDataSet& set);
+		void         clearColumns              (void);
+		void         analyze                   (int threads = 1);
+		int          getRowCount               (void) { return (int)m_rowsums.size(); }
+		int          getColumnCount            (void) { return (int)m_columnsums.size(); }
+		double       getCorrelation            (int row, int column);
+
+		std::ostream& printGrid                (std::ostream& out, int column1,
+		                                        int column2);
+		std::ostream& printDiagonal            (std::ostream& out, int column1,
+		                                        int column2);
+
+	protected:
+		static void  addHistograms             (MeasureDataSet& set,
+		                                        std::vector<double>& values,
+		                                        std::vector<double>& scales,
+		                                        std::vector<double>& sums);
+		static double* alignValues             (std::vector<double>& storage,
+		                                        int count);
+		void         analyzeTile               (int row1, int row2, int column1,
+		                                        int column2);
+		static std::ostream& printCorrelation  (std::ostream& out, double correl);
+
+	private:
+		// Histograms centered on their mean, m_stride values for each
+		// measure (padded with zeros):
+		std::vector<double> m_rowvalues;
+		std::vector<double> m_columnvalues;
+		// One over the length of each centered histogram:
+		std::vector<double> m_rowscales;
+		std::vector<double> m_columnscales;
+		// Sum of each histogram (0.0 for measures without notes):
+		std::vector<double> m_rowsums;
+		std::vector<double> m_columnsums;
+
+		// Aligned copies of the row histograms, and of the column
+		// histograms with the values for each pitch class contiguous:
+		std::vector<double> m_rowstorage;
+		std::vector<double> m_columnstorage;
+		double*             m_rows    = NULL;
+		double*             m_columns = NULL;
+
+		// Correlations, m_columnsums.size() values for each row:
+		std::vector<double> m_matrix;
+};
+
+
+
 class MeasureComparisonGrid {
 	public:
 		             MeasureComparisonGrid     (void);
 		             MeasureComparisonGrid     (MeasureDataSet& set1, MeasureDataSet& set2);
 		             MeasureComparisonGrid     (MeasureDataSet* set1, MeasureDataSet* set2);
+		             MeasureComparisonGrid     (const MeasureComparisonGrid& grid) = delete;
 		            ~MeasureComparisonGrid     ();
 
+		// m_set1 and m_set2 point to the data sets of the owner:
+		MeasureComparisonGrid& operator=       (const MeasureComparisonGrid& grid) = delete;
+
 		void         clear                     (void);
 		void         analyze                   (MeasureDataSet& set1, MeasureDataSet& set2);
 		void         analyze                   (MeasureDataSet* set1, MeasureDataSet* set2);
+		void         setThreadCount            (int threads);
+		double       getCorrelation7pc         (int index1, int index2);
 
 		double       getStartTime1             (int index);
 		double       getStopTime1              (int index);
@@ -130,7 +200,8 @@ class MeasureComparisonGrid {
 				 double& lightness);
 
 	private:
-		std::vector<std::vector<MeasureComparison>> m_grid;
+		MeasureCorrelationMatrix m_matrix;
+		int             m_threads = 1;
 		MeasureDataSet* m_set1 = NULL;
 		MeasureDataSet* m_set2 = NULL;
 };
@@ -150,11 +221,13 @@ class Tool_simat : public HumTool {
 	protected:
 		void     initialize         (HumdrumFile& infile1, HumdrumFile& infile2);
 		void     processFile        (HumdrumFile& infile1, HumdrumFile& infile2);
+		bool     processManyFiles   (HumdrumFileSet& infiles);
 
 	private:
-		MeasureDataSet        m_data1;
-		MeasureDataSet        m_data2;
-		MeasureComparisonGrid m_grid;
+		MeasureDataSet           m_data1;
+		MeasureDataSet           m_data2;
+		MeasureComparisonGrid    m_grid;
+		MeasureCorrelationMatrix m_many;  // first file against many files
 
 };
 
@@ -38,7 +38,7 @@ class Tool_transpose : public HumTool {
 	protected:
 
 		// auto transpose functions:
-		void     initialize             (HumdrumFile& infile);
+		bool     initialize             (HumdrumFile& infile);
 		void     convertScore           (HumdrumFile& infile, int style);
 		void     processFile            (HumdrumFile& infile,
 		                                 std::vector<bool>& spineprocess);
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Sat Jul 25 17:02:33 CEST 2026
+// Last Modified: Sat Oct 17 13:07:51 UTC 2026
 // Filename:      min/humlib.cpp
 // URL:           https://github.com/craigsapp/humlib/blob/master/min/humlib.cpp
 // Syntax:        C++11
@@ -38,6 +38,27 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "humlib.h"
 
+#ifdef HUMLIB_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#ifdef HUMLIB_AVX2
+	#include <immintrin.h>
+#elif defined(HUMLIB_SSE2)
+	#include <emmintrin.h>
+#endif
+
+#ifdef HUMLIB_SOCKETS
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <sys/stat.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+#endif
+
 namespace hum {
 
 
@@ -1315,7 +1336,7 @@ HumNum Convert::kernTimeSignatureBottomToDuration (const string& aKernString) {
 	size_t loc = aKernString.find('/');
 	if (loc == std::string::npos) {
 		cerr << "Error: poorly formed time signature: " << aKernString << endl;
-		exit(1);
+		return 0;
 	}
 	string afterslash = aKernString.substr(loc+1);
 	return Convert::kernToDuration(afterslash);
@@ -1334,7 +1355,7 @@ int Convert::kernTimeSignatureTop (const string& aKernString) {
 	if (aKernString.find('+') != std::string::npos) {
 		cerr << "Error: cannot handle time signature: " << aKernString
 			  << " yet." << endl;
-		exit(1);
+		return 0;
 	} else {
 		int len = (int)aKernString.size();
 		if (len > 2) {
@@ -1832,8 +1853,8 @@ bool Convert::getMensStemDirection(const string& mensdata) {
 //                separator = " " (space between chord notes)
 //
 
-HumNum Convert::mensToDuration(const string& mensdata, HumNum scale,
-		const string& separator) {
+HumNum Convert::mensToDuration(std::string_view mensdata, HumNum scale,
+		std::string_view separator) {
 	HumNum output(0);
    bool perfect = false;
    // bool imperfect = true;
@@ -1881,8 +1902,8 @@ HumNum Convert::mensToDuration(const string& mensdata, HumNum scale,
 // Convert::mensToDurationNoDots -- The imperfect duration of the **mens rhythm.
 //
 
-HumNum Convert::mensToDurationNoDots(const string& mensdata, HumNum scale,
-		const string& separator) {
+HumNum Convert::mensToDurationNoDots(std::string_view mensdata, HumNum scale,
+		std::string_view separator) {
 	HumNum output(0);
 
 	for (int i=0; i<(int)mensdata.size(); i++) {
@@ -2678,7 +2699,7 @@ string Convert::kernToScientificPitch(const string& kerndata,
 //    input string. Only the first subtoken in the string is considered.
 //
 
-int Convert::kernToDiatonicPC(const string& kerndata) {
+int Convert::kernToDiatonicPC(std::string_view kerndata) {
 	for (int i=0; i<(int)kerndata.size(); i++) {
 		if (kerndata[i] == ' ') {
 			break;
@@ -2751,7 +2772,7 @@ char Convert::kernToDiatonicLC(const string& kerndata) {
 //    value will be 0.
 //
 
-int Convert::kernToAccidentalCount(const string& kerndata) {
+int Convert::kernToAccidentalCount(std::string_view kerndata) {
 	int output = 0;
 	for (int i=0; i<(int)kerndata.size(); i++) {
 		if (kerndata[i] == ' ') {
@@ -2777,7 +2798,7 @@ int Convert::kernToAccidentalCount(const string& kerndata) {
 //    considered.
 //
 
-int Convert::kernToOctaveNumber(const string& kerndata) {
+int Convert::kernToOctaveNumber(std::string_view kerndata) {
 	int uc = 0;
 	int lc = 0;
 	if (kerndata == ".") {
@@ -2814,7 +2835,7 @@ int Convert::kernToOctaveNumber(const string& kerndata) {
 //    Will ignore subsequent pitches in a chord.
 //
 
-int Convert::kernToBase40PC(const string& kerndata) {
+int Convert::kernToBase40PC(std::string_view kerndata) {
 	int diatonic = Convert::kernToDiatonicPC(kerndata);
 	if (diatonic < 0) {
 		return diatonic;
@@ -2842,8 +2863,15 @@ int Convert::kernToBase40PC(const string& kerndata) {
 //    Will ignore subsequent pitches in a chord.
 //
 
-int Convert::kernToBase40(const string& kerndata) {
-	string trimmed = Convert::trimWhiteSpace(kerndata);
+int Convert::kernToBase40(std::string_view kerndata) {
+	// Trim whitespace by narrowing the view rather than copying the text:
+	std::string_view trimmed = kerndata;
+	while (!trimmed.empty() && isspace((unsigned char)trimmed.front())) {
+		trimmed.remove_prefix(1);
+	}
+	while (!trimmed.empty() && isspace((unsigned char)trimmed.back())) {
+		trimmed.remove_suffix(1);
+	}
 	int pc = Convert::kernToBase40PC(trimmed);
 	if (pc < 0) {
 		return pc;
@@ -2861,7 +2889,7 @@ int Convert::kernToBase40(const string& kerndata) {
 //   will return 12 instead of 0 for B#.
 //
 
-int Convert::kernToBase12PC(const string& kerndata) {
+int Convert::kernToBase12PC(std::string_view kerndata) {
 	int diatonic = Convert::kernToDiatonicPC(kerndata);
 	if (diatonic < 0) {
 		return diatonic;
@@ -2889,7 +2917,7 @@ int Convert::kernToBase12PC(const string& kerndata) {
 //     (middle C = 48).
 //
 
-int Convert::kernToBase12(const string& kerndata) {
+int Convert::kernToBase12(std::string_view kerndata) {
 	int pc = Convert::kernToBase12PC(kerndata);
 	int octave = Convert::kernToOctaveNumber(kerndata);
 	return pc + 12 * octave;
@@ -2928,7 +2956,7 @@ string Convert::base40ToKern(int b40) {
 	}
 	if (repeat > 12) {
 		cerr << "Error: unreasonable octave value: " << octave << " for " << b40 << endl;
-		exit(1);
+		return "";
 	}
 	string output;
 	output += base;
@@ -5038,16 +5066,16 @@ string Convert::getLanguageName(const string& abbreviation) {
 //
 
 HumNum Convert::recipToDuration(string* recip, HumNum scale,
-		const string& separator) {
+		std::string_view separator) {
 	return Convert::recipToDuration(*recip, scale, separator);
 }
 
 
-HumNum Convert::recipToDuration(const string& recip, HumNum scale,
-		const string& separator) {
+HumNum Convert::recipToDuration(std::string_view recip, HumNum scale,
+		std::string_view separator) {
 	size_t loc;
 	loc = recip.find(separator);
-	string subtok;
+	std::string_view subtok;
 	if (loc != string::npos) {
 		subtok = recip.substr(0, loc);
 	} else {
@@ -5138,16 +5166,16 @@ HumNum Convert::recipToDuration(const string& recip, HumNum scale,
 //
 
 HumNum Convert::recipToDurationIgnoreGrace(string* recip, HumNum scale,
-		const string& separator) {
+		std::string_view separator) {
 	return Convert::recipToDurationIgnoreGrace(*recip, scale, separator);
 }
 
 
-HumNum Convert::recipToDurationIgnoreGrace(const string& recip, HumNum scale,
-		const string& separator) {
+HumNum Convert::recipToDurationIgnoreGrace(std::string_view recip, HumNum scale,
+		std::string_view separator) {
 	size_t loc;
 	loc = recip.find(separator);
-	string subtok;
+	std::string_view subtok;
 	if (loc != string::npos) {
 		subtok = recip.substr(0, loc);
 	} else {
@@ -12021,6 +12049,7 @@ HumAddress::HumAddress(void) {
 	m_subtrack      = -1;
 	m_subtrackcount = 0;
 	m_fieldindex    = -1;
+	m_datatype      = HumDataType::Unknown;
 	m_owner         = NULL;
 }
 
@@ -12031,6 +12060,7 @@ HumAddress::HumAddress(HumAddress& address) {
 	m_subtrack      = address.m_subtrack;
 	m_subtrackcount = address.m_subtrackcount;
 	m_spining       = address.m_spining;
+	m_datatype      = address.m_datatype;
 	m_owner         = address.m_owner;
 }
 
@@ -12062,6 +12092,7 @@ HumAddress& HumAddress::operator=(const HumAddress& address) {
 	m_subtrack      = address.m_subtrack;
 	m_subtrackcount = address.m_subtrackcount;
 	m_spining       = address.m_spining;
+	m_datatype      = address.m_datatype;
 	m_owner         = address.m_owner;
 	return *this;
 }
@@ -12128,6 +12159,24 @@ const HumdrumToken& HumAddress::getDataType(void) const {
 
 
 
+//////////////////////////////
+//
+// HumAddress::getDataTypeId -- Return the HumDataType id of the exclusive
+//     interpretation for the token associated with the address.  Returns
+//     HumDataType::None if the token is not owned by a HumdrumLine, or
+//     HumDataType::Unknown if the tracks of the owning file have not been
+//     analyzed since the token was added.
+//
+
+int HumAddress::getDataTypeId(void) const {
+	if (m_owner == NULL) {
+		return HumDataType::None;
+	}
+	return m_datatype;
+}
+
+
+
 //////////////////////////////
 //
 // HumAddress::getExclusiveInterpretation -- Return the exclusive
@@ -12306,6 +12355,19 @@ void HumAddress::setSpineInfo(const string& spineinfo) {
 
 
 
+//////////////////////////////
+//
+// HumAddress::setDataTypeId -- Store the HumDataType id of the exclusive
+//     interpretation for the associated token.  This function is used by
+//     the HumdrumFileBase class when analyzing tracks.
+//
+
+void HumAddress::setDataTypeId(int id) {
+	m_datatype = id;
+}
+
+
+
 //////////////////////////////
 //
 // HumAddress::setTrack -- Set the track number of the associated token.
@@ -12368,6 +12430,1181 @@ void HumAddress::setSubtrackCount(int count) {
 
 
 
+
+//////////////////////////////
+//
+// HumAnalysisValue::HumAnalysisValue --
+//
+
+HumAnalysisValue::HumAnalysisValue(void) {
+	type = Undefined;
+	value.number = 0.0;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::HumAnalysisStore --
+//
+
+HumAnalysisStore::HumAnalysisStore(void) {
+	m_rows = 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::~HumAnalysisStore --
+//
+
+HumAnalysisStore::~HumAnalysisStore() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::clear -- Remove all rows, keys and values.
+//
+
+void HumAnalysisStore::clear(void) {
+	m_keys.clear();
+	m_columns.clear();
+	m_autoIndex.clear();
+	m_subIndex.clear();
+	m_strings.clear();
+	m_freeRows.clear();
+	m_rows = 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::addRow -- Return a row for a new token, line or file.
+//     Rows released by deleted tokens are reused.  Columns are not
+//     resized until a value is stored in the row.
+//
+
+int HumAnalysisStore::addRow(void) {
+	if (!m_freeRows.empty()) {
+		int row = m_freeRows.back();
+		m_freeRows.pop_back();
+		return row;
+	}
+	return m_rows++;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::copyRow -- Return a new row with the same values as
+//     the given row (used when a token is copied).
+//
+
+int HumAnalysisStore::copyRow(int row) {
+	int output = addRow();
+	for (int i=0; i<(int)m_columns.size(); i++) {
+		const HumAnalysisValue* value = getValue(row, i);
+		if (value == NULL) {
+			continue;
+		}
+		// Copy the value before the column is resized for the new row.
+		HumAnalysisValue copy = *value;
+		if (copy.type == HumAnalysisValue::String) {
+			string text = m_strings.at(copy.value.ints[0]);
+			setValue(output, i, text);
+		} else {
+			getCell(output, i) = copy;
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::releaseRow -- Delete the values in a row, and allow
+//     the row to be reused.
+//
+
+void HumAnalysisStore::releaseRow(int row) {
+	if ((row < 0) || (row >= m_rows)) {
+		return;
+	}
+	for (int i=0; i<(int)m_columns.size(); i++) {
+		deleteValue(row, i);
+	}
+	m_freeRows.push_back(row);
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getRowCount --
+//
+
+int HumAnalysisStore::getRowCount(void) const {
+	return m_rows;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::isAnalysisNamespace -- Returns true if the
+//     namespaces are for analysis values: either "":"auto" (the usual
+//     namespace) or "auto":ns2 (used for values of chord notes, such as
+//     "auto:2:visualAccidental").
+//
+
+bool HumAnalysisStore::isAnalysisNamespace(const string& ns1, const string& ns2) {
+	if (ns1.empty()) {
+		return ns2 == "auto";
+	}
+	return ns1 == "auto";
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::findKeyIndex -- Return the column index of a key, or
+//     -1 if no values have been stored for the key.
+//
+
+int HumAnalysisStore::findKeyIndex(const string& ns1, const string& ns2,
+		const string& key) const {
+	if (ns1.empty()) {
+		auto it = m_autoIndex.find(key);
+		return (it == m_autoIndex.end()) ? -1 : it->second;
+	}
+	if (m_subIndex.empty()) {
+		return -1;
+	}
+	auto it = m_subIndex.find(ns2 + ":" + key);
+	return (it == m_subIndex.end()) ? -1 : it->second;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getKeyIndex -- Return the column index of a key,
+//     adding a column for the key if it is new.  The namespaces must be
+//     analysis namespaces (see isAnalysisNamespace()).
+//
+
+int HumAnalysisStore::getKeyIndex(const string& ns1, const string& ns2,
+		const string& key) {
+	int index = findKeyIndex(ns1, ns2, key);
+	if (index >= 0) {
+		return index;
+	}
+	index = (int)m_keys.size();
+	if (ns1.empty()) {
+		m_autoIndex[key] = index;
+	} else {
+		m_subIndex[ns2 + ":" + key] = index;
+	}
+	m_keys.push_back({ns1, ns2, key});
+	m_columns.resize(m_keys.size());
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getKeyCount --
+//
+
+int HumAnalysisStore::getKeyCount(void) const {
+	return (int)m_keys.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getNamespace1 --
+//
+
+const string& HumAnalysisStore::getNamespace1(int keyindex) const {
+	return m_keys.at(keyindex).ns1;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getNamespace2 --
+//
+
+const string& HumAnalysisStore::getNamespace2(int keyindex) const {
+	return m_keys.at(keyindex).ns2;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getKey --
+//
+
+const string& HumAnalysisStore::getKey(int keyindex) const {
+	return m_keys.at(keyindex).key;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getValue -- Return the value of a key for a row, or
+//     NULL if the value is not defined.
+//
+
+const HumAnalysisValue* HumAnalysisStore::getValue(int row, int keyindex) const {
+	if ((row < 0) || (keyindex < 0) || (keyindex >= (int)m_columns.size())) {
+		return NULL;
+	}
+	const vector<HumAnalysisValue>& column = m_columns[keyindex];
+	if (row >= (int)column.size()) {
+		return NULL;
+	}
+	if (!column[row].isDefined()) {
+		return NULL;
+	}
+	return &column[row];
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getString -- Return the text form of a value, which
+//     is the same as the string stored by HumHash::setValue() for
+//     the type of the value.
+//
+
+string HumAnalysisStore::getString(const HumAnalysisValue& value) const {
+	switch (value.type) {
+		case HumAnalysisValue::String:
+			return m_strings.at(value.value.ints[0]);
+		case HumAnalysisValue::Integer:
+			return to_string(value.value.ints[0]);
+		case HumAnalysisValue::Boolean:
+			return value.value.ints[0] ? "true" : "false";
+		case HumAnalysisValue::Token:
+			return "HT_" + to_string((long long)value.value.token);
+		case HumAnalysisValue::Fraction:
+			if (value.value.ints[1] == 1) {
+				return to_string(value.value.ints[0]);
+			}
+			return to_string(value.value.ints[0]) + "/" + to_string(value.value.ints[1]);
+		case HumAnalysisValue::Float:
+			{
+				stringstream ss;
+				ss << value.value.number;
+				return ss.str();
+			}
+	}
+	return "";
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getCell -- Return the storage for a value, resizing
+//     the column if necessary.
+//
+
+HumAnalysisValue& HumAnalysisStore::getCell(int row, int keyindex) {
+	vector<HumAnalysisValue>& column = m_columns.at(keyindex);
+	if (row >= (int)column.size()) {
+		column.resize(row + 1);
+	}
+	return column[row];
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::setValue -- Store a value.  The strings "true" and
+//     "false" are stored as booleans.
+//
+
+void HumAnalysisStore::setValue(int row, int keyindex, const string& value) {
+	if (value == "true") {
+		setBool(row, keyindex, true);
+		return;
+	} else if (value == "false") {
+		setBool(row, keyindex, false);
+		return;
+	}
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	if (cell.type == HumAnalysisValue::String) {
+		m_strings[cell.value.ints[0]] = value;
+		return;
+	}
+	cell.type = HumAnalysisValue::String;
+	cell.value.ints[0] = (int)m_strings.size();
+	m_strings.push_back(value);
+}
+
+
+void HumAnalysisStore::setValue(int row, int keyindex, int value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Integer;
+	cell.value.ints[0] = value;
+}
+
+
+void HumAnalysisStore::setValue(int row, int keyindex, const HumNum& value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Fraction;
+	cell.value.ints[0] = value.getNumerator();
+	cell.value.ints[1] = value.getDenominator();
+}
+
+
+void HumAnalysisStore::setValue(int row, int keyindex, HTp value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Token;
+	cell.value.token = value;
+}
+
+
+void HumAnalysisStore::setValue(int row, int keyindex, double value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Float;
+	cell.value.number = value;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::setBool --
+//
+
+void HumAnalysisStore::setBool(int row, int keyindex, bool value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Boolean;
+	cell.value.ints[0] = value ? 1 : 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::deleteValue -- Remove a value.  The text of string
+//     values is cleared, but its slot is not reused.
+//
+
+void HumAnalysisStore::deleteValue(int row, int keyindex) {
+	if ((row < 0) || (keyindex < 0) || (keyindex >= (int)m_columns.size())) {
+		return;
+	}
+	vector<HumAnalysisValue>& column = m_columns[keyindex];
+	if (row >= (int)column.size()) {
+		return;
+	}
+	HumAnalysisValue& cell = column[row];
+	if (cell.type == HumAnalysisValue::String) {
+		string().swap(m_strings[cell.value.ints[0]]);
+	}
+	cell.type = HumAnalysisValue::Undefined;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getValueCount -- Return the number of values which
+//     are defined for a row.
+//
+
+int HumAnalysisStore::getValueCount(int row) const {
+	int output = 0;
+	for (int i=0; i<(int)m_columns.size(); i++) {
+		if (getValue(row, i)) {
+			output++;
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getMemoryUsage -- Return the approximate number of
+//     bytes allocated for the store.
+//
+
+size_t HumAnalysisStore::getMemoryUsage(void) const {
+	size_t output = sizeof(*this);
+	for (int i=0; i<(int)m_columns.size(); i++) {
+		output += m_columns[i].capacity() * sizeof(HumAnalysisValue);
+		output += sizeof(m_columns[i]) + sizeof(m_keys[i]);
+		output += m_keys[i].ns1.capacity() + m_keys[i].ns2.capacity()
+				+ m_keys[i].key.capacity();
+	}
+	for (int i=0; i<(int)m_strings.size(); i++) {
+		output += sizeof(string);
+		if (m_strings[i].capacity() > 15) {
+			output += m_strings[i].capacity();
+		}
+	}
+	output += m_freeRows.capacity() * sizeof(int);
+	output += (m_autoIndex.size() + m_subIndex.size()) * (sizeof(string) + 32);
+	return output;
+}
+
+
+
+// Definitions of the fixed ids, so that they can be passed by reference:
+const int HumDataType::None;
+const int HumDataType::Kern;
+const int HumDataType::Mens;
+const int HumDataType::Recip;
+const int HumDataType::Text;
+const int HumDataType::Silbe;
+const int HumDataType::Dynam;
+const int HumDataType::Harm;
+const int HumDataType::Fing;
+const int HumDataType::Unknown;
+
+// Entries are stored in fixed-size blocks which are never moved or
+// deleted, so names can be read without locking while other threads
+// add new data types.
+static const int HumDataTypeBlockSize = 256;
+static const int HumDataTypeMaxBlocks = 1024;
+
+static const unsigned HumDataTypeKernLike = 1;
+static const unsigned HumDataTypeMensLike = 2;
+
+struct HumDataTypeEntry {
+	std::string name;
+	unsigned    flags = 0;
+};
+
+struct HumDataTypeTable {
+	std::mutex                         mutex;
+	std::unordered_map<std::string, int> ids;
+	std::atomic<HumDataTypeEntry*>     blocks[HumDataTypeMaxBlocks];
+	std::atomic<int>                   count;
+	HumDataTypeTable(void);
+	int add(const std::string& name);
+};
+
+
+//////////////////////////////
+//
+// HumDataTypeTable::HumDataTypeTable -- Enter the data types which have
+//     fixed ids (see HumDataType.h).
+//
+
+HumDataTypeTable::HumDataTypeTable(void) : count(0) {
+	for (int i=0; i<HumDataTypeMaxBlocks; i++) {
+		blocks[i] = NULL;
+	}
+	add("");
+	add("**kern");
+	add("**mens");
+	add("**recip");
+	add("**text");
+	add("**silbe");
+	add("**dynam");
+	add("**harm");
+	add("**fing");
+}
+
+
+
+//////////////////////////////
+//
+// HumDataTypeTable::add -- Append a new data type to the table.  The
+//     mutex must be held by the caller (except in the constructor).
+//
+
+int HumDataTypeTable::add(const std::string& name) {
+	int id = count;
+	int block = id / HumDataTypeBlockSize;
+	if (block >= HumDataTypeMaxBlocks) {
+		return HumDataType::Unknown;
+	}
+	if (blocks[block] == NULL) {
+		blocks[block] = new HumDataTypeEntry[HumDataTypeBlockSize];
+	}
+	HumDataTypeEntry& entry = blocks[block][id % HumDataTypeBlockSize];
+	entry.name = name;
+	if ((name == "**kern") || (name == "**kernyy") ||
+			(name.compare(0, 7, "**kern-") == 0)) {
+		entry.flags |= HumDataTypeKernLike;
+	}
+	if ((name == "**mens") || (name.compare(0, 7, "**mens-") == 0)) {
+		entry.flags |= HumDataTypeMensLike;
+	}
+	ids[name] = id;
+	count = id + 1;
+	return id;
+}
+
+
+
+//////////////////////////////
+//
+// getHumDataTypeTable -- The table is allocated once and never deleted
+//     so that it can be used during program shutdown.
+//
+
+static HumDataTypeTable& getHumDataTypeTable(void) {
+	static HumDataTypeTable* table = new HumDataTypeTable;
+	return *table;
+}
+
+
+
+//////////////////////////////
+//
+// getHumDataTypeEntry -- Return the entry for an id, or NULL if the
+//     id is not in the table.
+//
+
+static const HumDataTypeEntry* getHumDataTypeEntry(int id) {
+	HumDataTypeTable& table = getHumDataTypeTable();
+	if ((id < 0) || (id >= table.count)) {
+		return NULL;
+	}
+	return &table.blocks[id / HumDataTypeBlockSize][id % HumDataTypeBlockSize];
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getId -- Return the id for a data type string, adding it
+//     to the table if it has not been seen before.  Returns
+//     HumDataType::Unknown if the table is full.
+//
+
+int HumDataType::getId(const std::string& datatype) {
+	HumDataTypeTable& table = getHumDataTypeTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	auto it = table.ids.find(datatype);
+	if (it != table.ids.end()) {
+		return it->second;
+	}
+	return table.add(datatype);
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getName -- Return the data type string for an id, or
+//     an empty string if the id is not in the table.
+//
+
+const std::string& HumDataType::getName(int id) {
+	const HumDataTypeEntry* entry = getHumDataTypeEntry(id);
+	if (entry) {
+		return entry->name;
+	}
+	return getHumDataTypeEntry(None)->name;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getCount -- Return the number of data types in the table.
+//
+
+int HumDataType::getCount(void) {
+	return getHumDataTypeTable().count;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::isKernLike -- Returns true if the id is for **kern,
+//     **kern- plus a tag, or **kernyy.
+//
+
+bool HumDataType::isKernLike(int id) {
+	if (id == Kern) {
+		return true;
+	}
+	const HumDataTypeEntry* entry = getHumDataTypeEntry(id);
+	return entry && (entry->flags & HumDataTypeKernLike);
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::isMensLike -- Returns true if the id is for **mens or
+//     **mens- plus a tag.
+//
+
+bool HumDataType::isMensLike(int id) {
+	if (id == Mens) {
+		return true;
+	}
+	const HumDataTypeEntry* entry = getHumDataTypeEntry(id);
+	return entry && (entry->flags & HumDataTypeMensLike);
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::isStaffLike -- Returns true if the id is for a data type
+//     which is displayed as a staff (kern-like or mens-like).
+//
+
+bool HumDataType::isStaffLike(int id) {
+	if ((id == Kern) || (id == Mens)) {
+		return true;
+	}
+	const HumDataTypeEntry* entry = getHumDataTypeEntry(id);
+	return entry && (entry->flags & (HumDataTypeKernLike | HumDataTypeMensLike));
+}
+
+
+
+
+//////////////////////////////
+//
+// HumFieldScanner::find -- Return a pointer to the first character
+//     between start and end which is one of the given characters, or
+//     end if there is no such character.
+//
+
+const char* HumFieldScanner::find(const char* start, const char* end, char c1) {
+	return HumFieldScanner::find(start, end, c1, c1, c1);
+}
+
+
+const char* HumFieldScanner::find(const char* start, const char* end, char c1,
+		char c2) {
+	return HumFieldScanner::find(start, end, c1, c2, c2);
+}
+
+
+const char* HumFieldScanner::find(const char* start, const char* end, char c1,
+		char c2, char c3) {
+	const char* p = start;
+
+#ifdef HUMLIB_AVX2
+	__m256i v1 = _mm256_set1_epi8(c1);
+	__m256i v2 = _mm256_set1_epi8(c2);
+	__m256i v3 = _mm256_set1_epi8(c3);
+	while (end - p >= 32) {
+		__m256i text = _mm256_loadu_si256((const __m256i*)p);
+		__m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(text, v1),
+				_mm256_or_si256(_mm256_cmpeq_epi8(text, v2), _mm256_cmpeq_epi8(text, v3)));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+		if (mask) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 32;
+	}
+#endif
+
+#ifdef HUMLIB_SSE2
+	__m128i w1 = _mm_set1_epi8(c1);
+	__m128i w2 = _mm_set1_epi8(c2);
+	__m128i w3 = _mm_set1_epi8(c3);
+	while (end - p >= 16) {
+		__m128i text = _mm_loadu_si128((const __m128i*)p);
+		__m128i hits = _mm_or_si128(_mm_cmpeq_epi8(text, w1),
+				_mm_or_si128(_mm_cmpeq_epi8(text, w2), _mm_cmpeq_epi8(text, w3)));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+		if (mask) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 16;
+	}
+#endif
+
+	while (p < end) {
+		if ((*p == c1) || (*p == c2) || (*p == c3)) {
+			return p;
+		}
+		p++;
+	}
+	return end;
+}
+
+
+
+//////////////////////////////
+//
+// HumFieldScanner::csvToTsv -- Convert the CSV record which starts at
+//     start into a tab-delimited line, and return a pointer to the start
+//     of the next record (or end).  Records end at a newline, and a
+//     carriage return before the newline is removed.  Quotes around
+//     text remove the special meaning of separators, and two quotes in
+//     a row inside of quotes give a single quote.  If a field starts
+//     with a quote, the quoted text can also contain newlines, which are
+//     changed into spaces since tokens cannot contain newlines.  Global
+//     comments and reference records (starting with "!!") are copied
+//     literally.  There is no limit to the length of a record.
+// default value: separator = "," (if the separator is empty)
+//
+
+const char* HumFieldScanner::csvToTsv(const char* start, const char* end,
+		const std::string& separator, std::string& output) {
+	output.clear();
+	if ((end - start >= 2) && (start[0] == '!') && (start[1] == '!')) {
+		const char* newline = HumFieldScanner::find(start, end, '\n');
+		output.assign(start, newline - start);
+		if (!output.empty() && (output.back() == 0x0d)) {
+			output.pop_back();
+		}
+		return newline < end ? newline + 1 : end;
+	}
+
+	static const std::string comma = ",";
+	const std::string& sep = separator.empty() ? comma : separator;
+	bool inquote    = false;   // inside of quoted text
+	bool fieldquote = false;   // quoted text started at the start of a field
+	bool fieldstart = true;    // no text in the current field yet
+	const char* p = start;
+	const char* stop = end;  // end of the record text
+	while (p < end) {
+		const char* q = HumFieldScanner::find(p, end, sep[0], '"', '\n');
+		if (q > p) {
+			output.append(p, q - p);
+			fieldstart = false;
+		}
+		if (q == end) {
+			p = end;
+			break;
+		}
+		if (*q == '\n') {
+			p = q + 1;
+			if (!(inquote && fieldquote)) {
+				stop = q;
+				break;
+			}
+			if ((q > start) && (q[-1] == 0x0d) && !output.empty()) {
+				output.pop_back();
+			}
+			output += ' ';
+		} else if (*q == '"') {
+			if (!inquote) {
+				inquote = true;
+				fieldquote = fieldstart;
+				p = q + 1;
+			} else if ((q + 1 < end) && (q[1] == '"')) {
+				output += '"';
+				fieldstart = false;
+				p = q + 2;
+			} else {
+				inquote = false;
+				fieldquote = false;
+				p = q + 1;
+			}
+		} else if (!inquote && ((size_t)(end - q) >= sep.size())
+				&& (sep.compare(0, sep.size(), q, sep.size()) == 0)) {
+			output += '\t';
+			fieldstart = true;
+			p = q + sep.size();
+		} else {
+			output += *q;
+			fieldstart = false;
+			p = q + 1;
+		}
+	}
+	// The carriage return is the last character added to the output,
+	// since it is not a special character:
+	if ((stop > start) && (stop[-1] == 0x0d) && !output.empty()) {
+		output.pop_back();
+	}
+	return p;
+}
+
+
+
+//////////////////////////////
+//
+// HumFieldScanner::getInstructionSet -- Return the name of the
+//     instructions used to scan text: "avx2", "sse2" or "scalar".
+//
+
+const char* HumFieldScanner::getInstructionSet(void) {
+#if defined(HUMLIB_AVX2)
+	return "avx2";
+#elif defined(HUMLIB_SSE2)
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+
+
+
+//////////////////////////////
+//
+// HumFileAnalysis::getDependencies -- Return a bit mask of the analyses
+//     which have to be done before the given one.  Only the direct
+//     dependencies are listed: HumdrumFileBase::requireAnalysis() follows
+//     them recursively.
+//
+
+unsigned HumFileAnalysis::getDependencies(int type) {
+	switch (type) {
+		case Nulls:       return getMask(Strands);
+		case Strophes:    return getMask(Strands);
+		case Structure:   return getMask(Strands);
+		case Rhythm:      return getMask(Structure);
+		case Slurs:       return getMask(Rhythm);
+		case Phrases:     return getMask(Rhythm);
+		case Beams:       return getMask(Rhythm);
+		case Ties:        return getMask(Rhythm);
+		case Accidentals: return getMask(Rhythm);
+	}
+	return 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileAnalysis::getName -- Return the name of an analysis (for
+//     debugging and error messages).
+//
+
+const char* HumFileAnalysis::getName(int type) {
+	switch (type) {
+		case Strands:     return "strands";
+		case Nulls:       return "nulls";
+		case Strophes:    return "strophes";
+		case Structure:   return "structure";
+		case Rhythm:      return "rhythm";
+		case Barlines:    return "barlines";
+		case Slurs:       return "slurs";
+		case Phrases:     return "phrases";
+		case Beams:       return "beams";
+		case Ties:        return "ties";
+		case Accidentals: return "accidentals";
+	}
+	return "";
+}
+
+
+
+
+//////////////////////////////
+//
+// HumFileCache::HumFileCache -- Set the maximum number of files in the
+//     cache.
+//
+
+HumFileCache::HumFileCache(int capacity) {
+	m_capacity = capacity < 0 ? 0 : capacity;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::~HumFileCache --
+//
+
+HumFileCache::~HumFileCache() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::read -- Read a file into infile, using the cached copy
+//     of the file if the file has not changed since it was cached.  The
+//     read analyses of infile (see HumdrumFileBase::setReadAnalyses()) are
+//     done on the file, and files in the cache which were read with other
+//     analyses are read again.  Returns false if the file cannot be read
+//     (or is not a regular file) or is not valid Humdrum data.
+//
+
+bool HumFileCache::read(HumdrumFile& infile, const string& filename) {
+	std::int64_t mtime;
+	std::int64_t size;
+	if (!getFileStatus(filename, mtime, size)) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_misses++;
+		}
+#ifdef HUMLIB_MMAP
+		// The file does not exist or is not a regular file:
+		infile.clear();
+		return false;
+#else
+		// The modification time cannot be checked, so do not cache the file:
+		infile.read(filename);
+		infile.setFilename(filename);
+		return infile.isValid();
+#endif
+	}
+
+	unsigned analyses = infile.getReadAnalyses();
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_index.find(filename);
+		if (it != m_index.end()) {
+			Entry& cached = **it->second;
+			if ((cached.mtime == mtime) && (cached.size == size) &&
+					(cached.analyses == analyses)) {
+				m_entries.splice(m_entries.begin(), m_entries, it->second);
+				entry = m_entries.front();
+			}
+		}
+		if (entry) {
+			m_hits++;
+		} else {
+			m_misses++;
+		}
+	}
+
+	if (entry) {
+		// The entry cannot change once it is in the cache, so it can be
+		// read without locking the cache.
+		infile.readSnapshot(entry->contents, entry->snapshot);
+		infile.setFilename(filename);
+		return infile.isValid();
+	}
+
+	entry = std::make_shared<Entry>();
+	entry->filename = filename;
+	entry->mtime    = mtime;
+	entry->size     = size;
+	entry->analyses = analyses;
+	if (!readContents(filename, entry->contents)) {
+		infile.clear();
+		return false;
+	}
+	infile.readString(entry->contents);
+	infile.setFilename(filename);
+	if (!infile.isValid()) {
+		return false;
+	}
+
+	// Do not cache the file if it changed while it was being read:
+	std::int64_t newmtime;
+	std::int64_t newsize;
+	if (!getFileStatus(filename, newmtime, newsize) || (newmtime != mtime) ||
+			(newsize != size) || (newsize != (std::int64_t)entry->contents.size())) {
+		return true;
+	}
+	if (!infile.writeSnapshot(entry->snapshot)) {
+		// The file will be analyzed each time that it is read from the cache.
+		entry->snapshot.clear();
+	}
+
+	int removed = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_capacity == 0) {
+			return true;
+		}
+		auto it = m_index.find(filename);
+		if (it != m_index.end()) {
+			m_entries.erase(it->second);
+		}
+		m_entries.push_front(entry);
+		m_index[filename] = m_entries.begin();
+		removed = trim();
+	}
+	if (removed) {
+		// The set of files being read is changing, so give the memory of
+		// files which have been deleted back to the system:
+		HumPool::trim();
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::clear -- Remove all files from the cache.
+//
+
+void HumFileCache::clear(void) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_entries.clear();
+		m_index.clear();
+	}
+	HumPool::trim();
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::setCapacity -- Set the maximum number of files in the
+//     cache, removing the least recently used files if there are too
+//     many.  A capacity of zero disables the cache.
+//
+
+void HumFileCache::setCapacity(int capacity) {
+	int removed = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_capacity = capacity < 0 ? 0 : capacity;
+		removed = trim();
+	}
+	if (removed) {
+		HumPool::trim();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getCapacity -- Return the maximum number of files in the
+//     cache.
+//
+
+int HumFileCache::getCapacity(void) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_capacity;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getSize -- Return the number of files in the cache.
+//
+
+int HumFileCache::getSize(void) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_entries.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getHitCount -- Return the number of reads which used a
+//     cached file.
+//
+
+std::uint64_t HumFileCache::getHitCount(void) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_hits;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getMissCount -- Return the number of reads which had to
+//     parse the file.
+//
+
+std::uint64_t HumFileCache::getMissCount(void) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_misses;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::trim -- Remove the least recently used files until the
+//     cache is not larger than its capacity.  The cache must be locked.
+//     Returns the number of files removed.
+//
+
+int HumFileCache::trim(void) {
+	int removed = 0;
+	while ((int)m_entries.size() > m_capacity) {
+		m_index.erase(m_entries.back()->filename);
+		m_entries.pop_back();
+		removed++;
+	}
+	return removed;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getFileStatus -- Get the modification time (in
+//     nanoseconds) and size of a regular file.  Returns false if the file
+//     does not exist, is not a regular file, or the status of files cannot
+//     be checked on this system.
+//
+
+bool HumFileCache::getFileStatus(const string& filename, std::int64_t& mtime,
+		std::int64_t& size) {
+	mtime = 0;
+	size = 0;
+#ifdef HUMLIB_MMAP
+	struct stat info;
+	if ((stat(filename.c_str(), &info) != 0) || !S_ISREG(info.st_mode)) {
+		return false;
+	}
+	mtime = (std::int64_t)info.st_mtime * 1000000000;
+	#if defined(__APPLE__)
+		mtime += info.st_mtimespec.tv_nsec;
+	#elif defined(__linux__)
+		mtime += info.st_mtim.tv_nsec;
+	#endif
+	size = (std::int64_t)info.st_size;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::readContents -- Read the contents of a file into a string.
+//
+
+bool HumFileCache::readContents(const string& filename, string& contents) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		return false;
+	}
+	stringstream buffer;
+	buffer << input.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+
+
+
 //////////////////////////////
 //
 // HumGrid::HumGrid -- Constructor.
@@ -15732,6 +16969,16 @@ HumParameter::HumParameter(const string& str) : string(str) {
 
 HumHash::HumHash(void) {
 	parameters = NULL;
+	m_analysisRow = -1;
+	m_analysisOwner = NoAnalysisOwner;
+}
+
+
+HumHash::HumHash(const HumHash& hash) {
+	parameters = NULL;
+	m_analysisRow = -1;
+	m_analysisOwner = NoAnalysisOwner;
+	*this = hash;
 }
 
 
@@ -15739,7 +16986,9 @@ HumHash::HumHash(void) {
 //////////////////////////////
 //
 // HumHash::~HumHash -- The HumHash deconstructor, which removed any
-//    allocated storage before the object dies.
+//    allocated storage before the object dies.  Analysis values have to
+//    be removed by the deconstructor of the containing object, while
+//    the file which stores them can still be found.
 //
 
 HumHash::~HumHash() {
@@ -15751,6 +17000,322 @@ HumHash::~HumHash() {
 
 
 
+//////////////////////////////
+//
+// HumHash::operator= -- Copy the parameters of another HumHash.  Analysis
+//    values are copied to a new row if both objects are in the same
+//    file, and otherwise are copied as strings like other parameters.
+//
+
+HumHash& HumHash::operator=(const HumHash& hash) {
+	if (this == &hash) {
+		return *this;
+	}
+	clearParameters();
+	prefix = hash.prefix;
+	if (hash.m_analysisRow < 0) {
+		if (hash.parameters != NULL) {
+			parameters = new HumHashEntries(*hash.parameters);
+		}
+		return *this;
+	}
+	HumAnalysisStore* store = hash.findAnalysisStore(false);
+	if (store == findAnalysisStore(false)) {
+		if (hash.parameters != NULL) {
+			parameters = new HumHashEntries(*hash.parameters);
+		}
+		m_analysisRow = store->copyRow(hash.m_analysisRow);
+	} else {
+		HumHashEntries storage;
+		const HumHashEntries* view = hash.getParameterView(storage);
+		if (view != NULL) {
+			parameters = new HumHashEntries(*view);
+		}
+	}
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::clearParameters -- Remove all parameters (in all namespaces).
+//
+
+void HumHash::clearParameters(void) {
+	if (parameters != NULL) {
+		delete parameters;
+		parameters = NULL;
+	}
+	deleteAnalysisValues();
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::deleteAnalysisValues -- Remove the values in the "auto"
+//    namespace which are stored in the analysis store.
+//
+
+void HumHash::deleteAnalysisValues(void) {
+	if (m_analysisRow >= 0) {
+		findAnalysisStore(false)->releaseRow(m_analysisRow);
+		m_analysisRow = -1;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::detachAnalysisValues -- Move the values in the analysis store
+//    into the parameter list as strings.  This is done before a token or
+//    line is moved out of its file, since the values can only be found
+//    in the store of the file.
+//
+
+void HumHash::detachAnalysisValues(void) {
+	if (m_analysisRow < 0) {
+		return;
+	}
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view != parameters) {
+		if (parameters == NULL) {
+			parameters = new HumHashEntries;
+		}
+		parameters->swap(storage);
+	}
+	deleteAnalysisValues();
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::setAnalysisOwner -- Set the type of the object which contains
+//    the HumHash (see AnalysisOwnerType).  Called by the constructors of
+//    HumdrumToken, HumdrumLine and HumdrumFileBase.
+//
+
+void HumHash::setAnalysisOwner(int type) {
+	m_analysisOwner = type;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::findAnalysisStore -- Return the store for values in the "auto"
+//    namespace, which belongs to the file that the token, line or file
+//    containing the HumHash is part of.  The store is created if it does
+//    not exist yet and create is true.  Returns NULL for HumHash objects
+//    which are not part of a file: their analysis values are stored as
+//    strings like other parameters.
+//
+
+HumAnalysisStore* HumHash::findAnalysisStore(bool create) const {
+	HumdrumFileBase* infile = NULL;
+	switch (m_analysisOwner) {
+		case TokenAnalysisOwner:
+			{
+				HLp line = static_cast<const HumdrumToken*>(this)->getOwner();
+				if (line != NULL) {
+					infile = line->getOwner();
+				}
+			}
+			break;
+		case LineAnalysisOwner:
+			infile = const_cast<HumdrumLine*>(static_cast<const HumdrumLine*>(this))->getOwner();
+			break;
+		case FileAnalysisOwner:
+			infile = const_cast<HumdrumFileBase*>(static_cast<const HumdrumFileBase*>(this));
+			break;
+	}
+	if (infile == NULL) {
+		return NULL;
+	}
+	return infile->getAnalysisStore(create);
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::getAnalysisValue -- Return a value from the analysis store,
+//    or NULL if the parameter is not stored there.
+//
+
+const HumAnalysisValue* HumHash::getAnalysisValue(const string& ns1,
+		const string& ns2, const string& key) const {
+	if (m_analysisRow < 0) {
+		return NULL;
+	}
+	if (!HumAnalysisStore::isAnalysisNamespace(ns1, ns2)) {
+		return NULL;
+	}
+	const HumAnalysisStore* store = findAnalysisStore(false);
+	int keyindex = store->findKeyIndex(ns1, ns2, key);
+	return store->getValue(m_analysisRow, keyindex);
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::prepareAnalysisValue -- Returns the analysis store if the
+//    parameter should be stored there (or NULL if not), and sets the
+//    column index for the key.  A row is added to the store for the
+//    first analysis value.
+//
+
+HumAnalysisStore* HumHash::prepareAnalysisValue(const string& ns1, const string& ns2,
+		const string& key, int& keyindex) {
+	if (!HumAnalysisStore::isAnalysisNamespace(ns1, ns2)) {
+		return NULL;
+	}
+	HumAnalysisStore* store = findAnalysisStore(true);
+	if (store == NULL) {
+		return NULL;
+	}
+	if (m_analysisRow < 0) {
+		m_analysisRow = store->addRow();
+	}
+	keyindex = store->getKeyIndex(ns1, ns2, key);
+	return store;
+}
+
+
+
+//////////////////////////////
+//
+// isHumHashEntryLess -- Sort parameters by the names of their namespaces
+//    and key.
+//
+
+static bool isHumHashEntryLess(const HumHashEntry& a, const HumHashEntry& b) {
+	if (a.ns1 != b.ns1) {
+		return HumParameterName::getName(a.ns1) < HumParameterName::getName(b.ns1);
+	}
+	if (a.ns2 != b.ns2) {
+		return HumParameterName::getName(a.ns2) < HumParameterName::getName(b.ns2);
+	}
+	if (a.key != b.key) {
+		return HumParameterName::getName(a.key) < HumParameterName::getName(b.key);
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::getParameterView -- Return the parameters including the values
+//    in the analysis store.  If there are analysis values, the parameters
+//    are copied into the storage list in sorted order; otherwise the
+//    parameter list is returned directly (which may be NULL).
+//
+
+const HumHashEntries* HumHash::getParameterView(HumHashEntries& storage) const {
+	if (m_analysisRow < 0) {
+		return parameters;
+	}
+	const HumAnalysisStore& store = *findAnalysisStore(false);
+	if (store.getValueCount(m_analysisRow) == 0) {
+		return parameters;
+	}
+	if (parameters != NULL) {
+		storage = *parameters;
+	}
+	for (int i=0; i<store.getKeyCount(); i++) {
+		const HumAnalysisValue* value = store.getValue(m_analysisRow, i);
+		if (value == NULL) {
+			continue;
+		}
+		HumHashEntry entry;
+		entry.ns1 = HumParameterName::getId(store.getNamespace1(i));
+		entry.ns2 = HumParameterName::getId(store.getNamespace2(i));
+		entry.key = HumParameterName::getId(store.getKey(i));
+		entry.value = store.getString(*value);
+		bool found = false;
+		for (auto& item : storage) {
+			if ((item.key == entry.key) && (item.ns2 == entry.ns2) && (item.ns1 == entry.ns1)) {
+				item.value = entry.value;
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			storage.push_back(entry);
+		}
+	}
+	std::stable_sort(storage.begin(), storage.end(), isHumHashEntryLess);
+	return &storage;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::findParameter -- Return the index of a parameter in the
+//    parameter list, or -1 if it is not defined.  Analysis values are
+//    not searched.
+//
+
+int HumHash::findParameter(const string& ns1, const string& ns2,
+		const string& key) const {
+	if ((parameters == NULL) || parameters->empty()) {
+		return -1;
+	}
+	int keyid = HumParameterName::findId(key);
+	if (keyid == HumParameterName::Unknown) {
+		return -1;
+	}
+	int ns2id = HumParameterName::findId(ns2);
+	if (ns2id == HumParameterName::Unknown) {
+		return -1;
+	}
+	int ns1id = HumParameterName::findId(ns1);
+	if (ns1id == HumParameterName::Unknown) {
+		return -1;
+	}
+	const HumHashEntries& entries = *parameters;
+	for (int i=0; i<(int)entries.size(); i++) {
+		if ((entries[i].key == keyid) && (entries[i].ns2 == ns2id) && (entries[i].ns1 == ns1id)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::insertParameter -- Return a parameter, adding an empty
+//    parameter in sorted order if it is not defined.
+//
+
+HumParameter& HumHash::insertParameter(const string& ns1, const string& ns2,
+		const string& key) {
+	int index = findParameter(ns1, ns2, key);
+	if (index >= 0) {
+		return (*parameters)[index].value;
+	}
+	initializeParameters();
+	HumHashEntry entry;
+	entry.ns1 = HumParameterName::getId(ns1);
+	entry.ns2 = HumParameterName::getId(ns2);
+	entry.key = HumParameterName::getId(key);
+	auto it = std::upper_bound(parameters->begin(), parameters->end(), entry,
+			isHumHashEntryLess);
+	it = parameters->insert(it, entry);
+	return it->value;
+}
+
+
+
 //////////////////////////////
 //
 // HumHash::getValue -- Returns the value specified by the given key.
@@ -15765,7 +17330,7 @@ HumHash::~HumHash() {
 //
 
 string HumHash::getValue(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return "";
 	} else {
 		vector<string> keys = getKeyList(key);
@@ -15781,7 +17346,7 @@ string HumHash::getValue(const string& key) const {
 
 
 string HumHash::getValue(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return "";
 	} else {
 		return getValue("", ns2, key);
@@ -15791,23 +17356,15 @@ string HumHash::getValue(const string& ns2, const string& key) const {
 
 string HumHash::getValue(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
-		return "";
+	const HumAnalysisValue* value = getAnalysisValue(ns1, ns2, key);
+	if (value != NULL) {
+		return findAnalysisStore(false)->getString(*value);
 	}
-	MapNNKV& p = *parameters;
-	auto it1 = p.find(ns1);
-	if (it1 == p.end()) {
-		return "";
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return "";
-	}
-	auto it3 = it2->second.find(key);
-	if (it3 == it2->second.end()) {
+	int index = findParameter(ns1, ns2, key);
+	if (index < 0) {
 		return "";
 	}
-	return it3->second;
+	return (*parameters)[index].value;
 }
 
 
@@ -15819,12 +17376,12 @@ string HumHash::getValue(const string& ns1, const string& ns2,
 //
 
 HTp HumHash::getValueHTp(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return NULL;
 	}
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return getValueHTp("", "", keys[2]);
+		return getValueHTp("", "", keys[0]);
 	} else if (keys.size() == 2) {
 		return getValueHTp(keys[0], keys[1]);
 	} else {
@@ -15834,7 +17391,7 @@ HTp HumHash::getValueHTp(const string& key) const {
 
 
 HTp HumHash::getValueHTp(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return NULL;
 	}
 	return getValueHTp("", ns2, key);
@@ -15843,7 +17400,11 @@ HTp HumHash::getValueHTp(const string& ns2, const string& key) const {
 
 HTp HumHash::getValueHTp(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if ((stored != NULL) && (stored->type == HumAnalysisValue::Token)) {
+		return stored->value.token;
+	}
+	if ((parameters == NULL) && (stored == NULL)) {
 		return NULL;
 	}
 	string value = getValue(ns1, ns2, key);
@@ -15875,12 +17436,12 @@ HTp HumHash::getValueHTp(const string& ns1, const string& ns2,
 //
 
 int HumHash::getValueInt(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0;
 	}
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return getValueInt("", "", keys[2]);
+		return getValueInt("", "", keys[0]);
 	} else if (keys.size() == 2) {
 		return getValueInt(keys[0], keys[1]);
 	} else {
@@ -15890,7 +17451,7 @@ int HumHash::getValueInt(const string& key) const {
 
 
 int HumHash::getValueInt(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0;
 	}
 	return getValueInt("", ns2, key);
@@ -15899,7 +17460,14 @@ int HumHash::getValueInt(const string& ns2, const string& key) const {
 
 int HumHash::getValueInt(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if (stored != NULL) {
+		if (stored->type == HumAnalysisValue::Integer) {
+			return stored->value.ints[0];
+		} else if (stored->type == HumAnalysisValue::Fraction) {
+			return HumNum(stored->value.ints[0], stored->value.ints[1]).getInteger();
+		}
+	} else if (parameters == NULL) {
 		return 0;
 	}
 	string value = getValue(ns1, ns2, key);
@@ -15934,7 +17502,7 @@ int HumHash::getValueInt(const string& ns1, const string& ns2,
 //
 
 HumNum HumHash::getValueFraction(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0;
 	}
 	vector<string> keys = getKeyList(key);
@@ -15949,7 +17517,7 @@ HumNum HumHash::getValueFraction(const string& key) const {
 
 
 HumNum HumHash::getValueFraction(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0;
 	}
 	return getValueFraction("", ns2, key);
@@ -15958,8 +17526,19 @@ HumNum HumHash::getValueFraction(const string& ns2, const string& key) const {
 
 HumNum HumHash::getValueFraction(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (!isDefined(ns1, ns2, key)) {
-		return 0;
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if (stored == NULL) {
+		if (!isDefined(ns1, ns2, key)) {
+			return 0;
+		}
+	} else if ((stored->type == HumAnalysisValue::Fraction)
+			|| (stored->type == HumAnalysisValue::Integer)) {
+		// Negative values are parsed from the text below, since the
+		// string parser for HumNum does not read a minus sign.
+		if (stored->value.ints[0] >= 0) {
+			int bot = (stored->type == HumAnalysisValue::Fraction) ? stored->value.ints[1] : 1;
+			return HumNum(stored->value.ints[0], bot);
+		}
 	}
 	string value = getValue(ns1, ns2, key);
 	HumNum fractionvalue(value);
@@ -15980,12 +17559,12 @@ HumNum HumHash::getValueFraction(const string& ns1, const string& ns2,
 //
 
 double HumHash::getValueFloat(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0.0;
 	}
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return getValueFloat("", "", keys[2]);
+		return getValueFloat("", "", keys[0]);
 	} else if (keys.size() == 2) {
 		return getValueFloat(keys[0], keys[1]);
 	} else {
@@ -15995,16 +17574,25 @@ double HumHash::getValueFloat(const string& key) const {
 
 
 double HumHash::getValueFloat(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0.0;
 	}
-	return getValueInt("", ns2, key);
+	return getValueFloat("", ns2, key);
 }
 
 
 double HumHash::getValueFloat(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if (stored != NULL) {
+		if (stored->type == HumAnalysisValue::Float) {
+			return stored->value.number;
+		} else if (stored->type == HumAnalysisValue::Integer) {
+			return stored->value.ints[0];
+		} else if (stored->type == HumAnalysisValue::Fraction) {
+			return (double)stored->value.ints[0] / stored->value.ints[1];
+		}
+	} else if (parameters == NULL) {
 		return 0.0;
 	}
 	string value = getValue(ns1, ns2, key);
@@ -16039,7 +17627,7 @@ double HumHash::getValueFloat(const string& ns1, const string& ns2,
 bool HumHash::getValueBool(const string& key) const {
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return getValueBool("", "", keys[2]);
+		return getValueBool("", "", keys[0]);
 	} else if (keys.size() == 2) {
 		return getValueBool(keys[0], keys[1]);
 	} else {
@@ -16055,15 +17643,23 @@ bool HumHash::getValueBool(const string& ns2, const string& key) const {
 
 bool HumHash::getValueBool(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if (stored != NULL) {
+		if ((stored->type == HumAnalysisValue::Boolean) ||
+				(stored->type == HumAnalysisValue::Integer)) {
+			return stored->value.ints[0] != 0;
+		} else if (stored->type == HumAnalysisValue::Token) {
+			return true;
+		}
+	} else if (parameters == NULL) {
 		return false;
-	}
-	if (!isDefined(ns1, ns2, key)) {
+	} else if (!isDefined(ns1, ns2, key)) {
 		return false;
 	}
-	if ((*parameters)[ns1][ns2][key] == "false") {
+	string value = getValue(ns1, ns2, key);
+	if (value == "false") {
 		return false;
-	} else if ((*parameters)[ns1][ns2][key] == "0") {
+	} else if (value == "0") {
 		return false;
 	} else {
 		return true;
@@ -16104,8 +17700,13 @@ void HumHash::setValue(const string& ns2, const string& key,
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, const string& value) {
-	initializeParameters();
-	(*parameters)[ns1][ns2][key] = value;
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
+	insertParameter(ns1, ns2, key) = value;
 }
 
 
@@ -16145,10 +17746,15 @@ void HumHash::setValue(const string& ns2, const string& key, int value) {
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, int value) {
-	initializeParameters();
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
 	stringstream ss;
 	ss << value;
-	(*parameters)[ns1][ns2][key] = ss.str();
+	insertParameter(ns1, ns2, key) = ss.str();
 }
 
 
@@ -16171,10 +17777,15 @@ void HumHash::setValue(const string& ns2, const string& key, HTp value) {
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, HTp value) {
-	initializeParameters();
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
 	stringstream ss;
 	ss << "HT_" << ((long long)value);
-	(*parameters)[ns1][ns2][key] = ss.str();
+	insertParameter(ns1, ns2, key) = ss.str();
 }
 
 
@@ -16197,10 +17808,15 @@ void HumHash::setValue(const string& ns2, const string& key, HumNum value) {
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, HumNum value) {
-	initializeParameters();
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
 	stringstream ss;
 	ss << value;
-	(*parameters)[ns1][ns2][key] = ss.str();
+	insertParameter(ns1, ns2, key) = ss.str();
 }
 
 
@@ -16223,10 +17839,15 @@ void HumHash::setValue(const string& ns2, const string& key, double value) {
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, double value) {
-	initializeParameters();
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
 	stringstream ss;
 	ss << value;
-	(*parameters)[ns1][ns2][key] = ss.str();
+	insertParameter(ns1, ns2, key) = ss.str();
 }
 
 
@@ -16240,11 +17861,17 @@ void HumHash::setValue(const string& ns1, const string& ns2,
 
 map<string, string> HumHash::getParameters(const string& ns1, const string& ns2) {
 	map<string, string> output;
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return output;
 	}
-	for (auto& it : (*parameters)[ns1][ns2]) {
-		output[it.first] = it.second;
+	int ns1id = HumParameterName::findId(ns1);
+	int ns2id = HumParameterName::findId(ns2);
+	for (auto& entry : *view) {
+		if ((entry.ns1 == ns1id) && (entry.ns2 == ns2id)) {
+			output[HumParameterName::getName(entry.key)] = entry.value;
+		}
 	}
 	return output;
 }
@@ -16252,7 +17879,7 @@ map<string, string> HumHash::getParameters(const string& ns1, const string& ns2)
 
 map<string, string> HumHash::getParameters(string& ns) {
 	map<string, string> output;
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return output;
 	}
 	auto loc = ns.find(":");
@@ -16281,11 +17908,17 @@ map<string, string> HumHash::getParameters(string& ns) {
 
 vector<string> HumHash::getKeys(const string& ns1, const string& ns2) const {
 	vector<string> output;
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return output;
 	}
-	for (auto& it : (*parameters)[ns1][ns2]) {
-		output.push_back(it.first);
+	int ns1id = HumParameterName::findId(ns1);
+	int ns2id = HumParameterName::findId(ns2);
+	for (auto& entry : *view) {
+		if ((entry.ns1 == ns1id) && (entry.ns2 == ns2id)) {
+			output.push_back(HumParameterName::getName(entry.key));
+		}
 	}
 	return output;
 }
@@ -16293,19 +17926,22 @@ vector<string> HumHash::getKeys(const string& ns1, const string& ns2) const {
 
 vector<string> HumHash::getKeys(const string& ns) const {
 	vector<string> output;
-	if (parameters == NULL) {
-		return output;
-	}
 	auto loc = ns.find(":");
 	if (loc != string::npos) {
 		string ns1 = ns.substr(0, loc);
 		string ns2 = ns.substr(loc+1);
 		return getKeys(ns1, ns2);
 	}
-
-	for (auto& it1 : (*parameters)[ns]) {
-		for (auto& it2 : it1.second) {
-			output.push_back(it1.first + ":" + it2.first);
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
+		return output;
+	}
+	int nsid = HumParameterName::findId(ns);
+	for (auto& entry : *view) {
+		if (entry.ns1 == nsid) {
+			output.push_back(HumParameterName::getName(entry.ns2) + ":"
+					+ HumParameterName::getName(entry.key));
 		}
 	}
 	return output;
@@ -16314,15 +17950,15 @@ vector<string> HumHash::getKeys(const string& ns) const {
 
 vector<string> HumHash::getKeys(void) const {
 	vector<string> output;
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return output;
 	}
-	for (auto& it1 : (*parameters)) {
-		for (auto& it2 : it1.second) {
-			for (auto it3 : it2.second) {
-				output.push_back(it1.first + ":" + it2.first + ":" + it3.first);
-			}
-		}
+	for (auto& entry : *view) {
+		output.push_back(HumParameterName::getName(entry.ns1) + ":"
+				+ HumParameterName::getName(entry.ns2) + ":"
+				+ HumParameterName::getName(entry.key));
 	}
 	return output;
 }
@@ -16340,62 +17976,23 @@ vector<string> HumHash::getKeys(void) const {
 //
 
 bool HumHash::hasParameters(const string& ns1, const string& ns2) const {
-	if (parameters == NULL) {
-		return false;
-	}
-	if (parameters->size() == 0) {
-		return false;
-	}
-	auto it1 = parameters->find(ns1);
-	if (it1 == parameters->end()) {
-		return false;
-	}
-	auto it2 = (*parameters)[ns1].find(ns2);
-	if (it2 == (*parameters)[ns1].end()) {
-		return false;
-	} else {
-		return true;
-	}
+	return getParameterCount(ns1, ns2) > 0;
 }
 
 
 bool HumHash::hasParameters(const string& ns) const {
-	if (parameters == NULL) {
-		return false;
-	}
-	auto loc = ns.find(":");
-	if (loc != string::npos) {
-		string ns1 = ns.substr(0, loc);
-		string ns2 = ns.substr(loc+1);
-		return hasParameters(ns1, ns2);
-	}
-
-	auto it = parameters->find(ns);
-	if (it == parameters->end()) {
-		return false;
-	} else {
-		return true;
-	}
+	return getParameterCount(ns) > 0;
 }
 
 
 bool HumHash::hasParameters(void) const {
-	if (parameters == NULL) {
-		return false;
+	if ((m_analysisRow >= 0) && (findAnalysisStore(false)->getValueCount(m_analysisRow) > 0)) {
+		return true;
 	}
-	if (parameters->size() == 0) {
+	if (parameters == NULL) {
 		return false;
 	}
-	for (auto& it1 : *parameters) {
-		for (auto& it2 : it1.second) {
-			if (it2.second.size() == 0) {
-				continue;
-			} else {
-				return true;
-			}
-		}
-	}
-	return false;
+	return !parameters->empty();
 }
 
 
@@ -16412,61 +18009,53 @@ bool HumHash::hasParameters(void) const {
 //
 
 int HumHash::getParameterCount(const string& ns1, const string& ns2) const {
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return 0;
 	}
-	if (parameters->size() == 0) {
-		return 0;
-	}
-	auto it1 = parameters->find(ns1);
-	if (it1 == parameters->end()) {
-		return 0;
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return 0;
+	int ns1id = HumParameterName::findId(ns1);
+	int ns2id = HumParameterName::findId(ns2);
+	int sum = 0;
+	for (auto& entry : *view) {
+		if ((entry.ns1 == ns1id) && (entry.ns2 == ns2id)) {
+			sum++;
+		}
 	}
-	return (int)it2->second.size();
+	return sum;
 }
 
 
 int HumHash::getParameterCount(const string& ns) const {
-	if (parameters == NULL) {
-		return false;
-	}
 	auto loc = ns.find(":");
 	if (loc != string::npos) {
 		string ns1 = ns.substr(0, loc);
 		string ns2 = ns.substr(loc+1);
 		return getParameterCount(ns1, ns2);
 	}
-
-	auto it1 = parameters->find(ns);
-	if (it1 == parameters->end()) {
-		return false;
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
+		return 0;
 	}
+	int nsid = HumParameterName::findId(ns);
 	int sum = 0;
-	for (auto& it2 : it1->second) {
-		sum += (int)it2.second.size();
+	for (auto& entry : *view) {
+		if (entry.ns1 == nsid) {
+			sum++;
+		}
 	}
 	return sum;
 }
 
 
 int HumHash::getParameterCount(void) const {
-	if (parameters == NULL) {
-		return 0;
-	}
-	if (parameters->size() == 0) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return 0;
 	}
-	int sum = 0;
-	for (auto& it1 : (*parameters)) {
-		for (auto& it2 : it1.second) {
-			sum += (int)it2.second.size();
-		}
-	}
-	return sum;
+	return (int)view->size();
 }
 
 
@@ -16480,34 +18069,31 @@ int HumHash::getParameterCount(void) const {
 //
 
 bool HumHash::isDefined(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return false;
 	}
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return (*parameters)[""][""].count(keys[0]) ? true : false;
+		return isDefined("", "", keys[0]);
 	} else if (keys.size() == 2) {
-		return (*parameters)[""][keys[0]].count(keys[1]) ? true : false;
+		return isDefined("", keys[0], keys[1]);
 	} else {
-		return (*parameters)[keys[0]][keys[1]].count(keys[2]) ? true : false;
+		return isDefined(keys[0], keys[1], keys[2]);
 	}
 }
 
 
 bool HumHash::isDefined(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
-		return false;
-	}
-	return (*parameters)[""][ns2].count(key) ? true : false;
+	return isDefined("", ns2, key);
 }
 
 
 bool HumHash::isDefined(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
-		return false;
+	if (getAnalysisValue(ns1, ns2, key) != NULL) {
+		return true;
 	}
-	return (*parameters)[ns1][ns2].count(key) ? true : false;
+	return findParameter(ns1, ns2, key) >= 0;
 }
 
 
@@ -16520,7 +18106,7 @@ bool HumHash::isDefined(const string& ns1, const string& ns2,
 //
 
 void HumHash::deleteValue(const string& key) {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return;
 	}
 	vector<string> keys = getKeyList(key);
@@ -16535,47 +18121,34 @@ void HumHash::deleteValue(const string& key) {
 
 
 void HumHash::deleteValue(const string& ns2, const string& key) {
-	if (parameters == NULL) {
-		return;
-	}
 	deleteValue("", ns2, key);
 }
 
 
 void HumHash::deleteValue(const string& ns1, const string& ns2,
 		const string& key) {
-	if (parameters == NULL) {
-		return;
+	if ((m_analysisRow >= 0) && HumAnalysisStore::isAnalysisNamespace(ns1, ns2)) {
+		HumAnalysisStore* store = findAnalysisStore(false);
+		int keyindex = store->findKeyIndex(ns1, ns2, key);
+		store->deleteValue(m_analysisRow, keyindex);
 	}
-	(*parameters)[ns1][ns2].erase(key);
-
-	MapNNKV& p = *parameters;
-	auto it1 = p.find(ns1);
-	if (it1 == p.end()) {
-		return;
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return;
-	}
-	auto it3 = it2->second.find(key);
-	if (it3 == it2->second.end()) {
-		return;
+	int index = findParameter(ns1, ns2, key);
+	if (index >= 0) {
+		parameters->erase(parameters->begin() + index);
 	}
-	it2->second.erase(key);
 }
 
 
 
 //////////////////////////////
 //
-// HumHash::initializeParameters -- Create the map structure if it does not
-//     already exist.
+// HumHash::initializeParameters -- Create the parameter list if it does
+//     not already exist.
 //
 
 void HumHash::initializeParameters(void) {
 	if (parameters == NULL) {
-		parameters = new MapNNKV;
+		parameters = new HumHashEntries;
 	}
 }
 
@@ -16672,23 +18245,10 @@ void HumHash::setOrigin(const string& ns2, const string& key,
 
 void HumHash::setOrigin(const string& ns1, const string& ns2,
 		const string& key, HumdrumToken* tok) {
-	if (parameters == NULL) {
-		return;
+	int index = findParameter(ns1, ns2, key);
+	if (index >= 0) {
+		(*parameters)[index].value.origin = tok;
 	}
-	MapNNKV& p = *parameters;
-	auto it1 = p.find(ns1);
-	if (it1 == p.end()) {
-		return;
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return;
-	}
-	auto it3 = it2->second.find(key);
-	if (it3 == it2->second.end()) {
-		return;
-	}
-	it3->second.origin = tok;
 }
 
 
@@ -16732,23 +18292,11 @@ HumdrumToken* HumHash::getOrigin(const string& ns2, const string& key) const {
 
 HumdrumToken* HumHash::getOrigin(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
-		return NULL;
-	}
-	MapNNKV& p = *parameters;
-	auto it1 = p.find(ns1);
-	if (it1 == p.end()) {
-		return NULL;
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return NULL;
-	}
-	auto it3 = it2->second.find(key);
-	if (it3 == it2->second.end()) {
+	int index = findParameter(ns1, ns2, key);
+	if (index < 0) {
 		return NULL;
 	}
-	return it3->second.origin;
+	return (*parameters)[index].value.origin;
 }
 
 
@@ -16761,41 +18309,42 @@ HumdrumToken* HumHash::getOrigin(const string& ns1, const string& ns2,
 
 ostream& HumHash::printXml(ostream& out, int level, const string& indent) {
 
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return out;
 	}
-	if (parameters->size() == 0) {
+	if (view->size() == 0) {
 		return out;
 	}
+	const HumHashEntries& entries = *view;
 
 	stringstream str;
 	bool found = 0;
 
 	HumdrumToken* ref = NULL;
 	level++;
-	for (auto& it1 : *(parameters)) {
-		if (it1.second.size() == 0) {
-			continue;
-		}
+	int i = 0;
+	while (i < (int)entries.size()) {
+		int ns1 = entries[i].ns1;
 		if (!found) {
 			found = 1;
 		}
 		str << Convert::repeatString(indent, level++);
-		str << "<namespace n=\"1\" name=\"" << it1.first << "\">\n";
-		for (auto& it2 : it1.second) {
-			if (it2.second.size() == 0) {
-				continue;
-			}
+		str << "<namespace n=\"1\" name=\"" << HumParameterName::getName(ns1) << "\">\n";
+		while ((i < (int)entries.size()) && (entries[i].ns1 == ns1)) {
+			int ns2 = entries[i].ns2;
 
 			str << Convert::repeatString(indent, level++);
-			str << "<namespace n=\"2\" name=\"" << it2.first << "\">\n";
+			str << "<namespace n=\"2\" name=\"" << HumParameterName::getName(ns2) << "\">\n";
 
-			for (auto& it3 : it2.second) {
+			for (; (i < (int)entries.size()) && (entries[i].ns1 == ns1) &&
+					(entries[i].ns2 == ns2); i++) {
 				str << Convert::repeatString(indent, level);
-				str << "<parameter key=\"" << it3.first << "\"";
+				str << "<parameter key=\"" << HumParameterName::getName(entries[i].key) << "\"";
 				str << " value=\"";
-				str << Convert::encodeXml(it3.second) << "\"";
-				ref = it3.second.origin;
+				str << Convert::encodeXml(entries[i].value) << "\"";
+				ref = entries[i].value.origin;
 				if (ref != NULL) {
 					str << " idref=\"";
 					str << ref->getXmlId();
@@ -16827,12 +18376,15 @@ ostream& HumHash::printXml(ostream& out, int level, const string& indent) {
 ostream& HumHash::printXmlAsGlobal(ostream& out, int level,
 		const string& indent) {
 
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return out;
 	}
-	if (parameters->size() == 0) {
+	if (view->size() == 0) {
 		return out;
 	}
+	const HumHashEntries& entries = *view;
 
 	stringstream str;
 	stringstream str2;
@@ -16843,48 +18395,48 @@ ostream& HumHash::printXmlAsGlobal(ostream& out, int level,
 
 	HumdrumToken* ref = NULL;
 	level++;
-	for (auto& it1 : *(parameters)) {
-		if (it1.second.size() == 0) {
-			continue;
-		}
+	int i = 0;
+	while (i < (int)entries.size()) {
+		int ns1 = entries[i].ns1;
 		str2.str("");
-		it1str = it1.first;
+		it1str = HumParameterName::getName(ns1);
 		if (!found) {
 			found = 1;
 		}
-		if (it1.first == "") {
+		if (it1str == "") {
 			str2 << Convert::repeatString(indent, level++);
-			str2 << "<namespace n=\"1\" name=\"" << it1.first << "\">\n";
+			str2 << "<namespace n=\"1\" name=\"" << it1str << "\">\n";
 		} else {
 			str << Convert::repeatString(indent, level++);
-			str << "<namespace n=\"1\" name=\"" << it1.first << "\">\n";
+			str << "<namespace n=\"1\" name=\"" << it1str << "\">\n";
 		}
-		for (auto& it2 : it1.second) {
-			if (it2.second.size() == 0) {
-				continue;
-			}
-			it2str = it2.first;
+		while ((i < (int)entries.size()) && (entries[i].ns1 == ns1)) {
+			int ns2 = entries[i].ns2;
+			it2str = HumParameterName::getName(ns2);
 
-			if ((it2.first == "") && (it2.first == "")) {
+			if (it2str == "") {
 				str2 << Convert::repeatString(indent, level++);
-				str2 << "<namespace n=\"2\" name=\"" << it2.first << "\">\n";
+				str2 << "<namespace n=\"2\" name=\"" << it2str << "\">\n";
 			} else {
 				str << Convert::repeatString(indent, level++);
-				str << "<namespace n=\"2\" name=\"" << it2.first << "\">\n";
+				str << "<namespace n=\"2\" name=\"" << it2str << "\">\n";
 			}
 
-			for (auto& it3 : it2.second) {
-				if ((it2.first == "") && (it2.first == "")) {
+			for (; (i < (int)entries.size()) && (entries[i].ns1 == ns1) &&
+					(entries[i].ns2 == ns2); i++) {
+				const string& key = HumParameterName::getName(entries[i].key);
+				const HumParameter& value = entries[i].value;
+				if (it2str == "") {
 
-					if ((it3.first == "global") && (it3.second == "true")) {
+					if ((key == "global") && (value == "true")) {
 						// don't do anything because parameter should be removed
 					} else {
 						str2count++;
 						str2 << Convert::repeatString(indent, level);
-						str2 << "<parameter key=\"" << it3.first << "\"";
+						str2 << "<parameter key=\"" << key << "\"";
 						str2 << " value=\"";
-						str2 << Convert::encodeXml(it3.second) << "\"";
-						ref = it3.second.origin;
+						str2 << Convert::encodeXml(value) << "\"";
+						ref = value.origin;
 						if (ref != NULL) {
 							str2 << " idref=\"";
 							str2 << ref->getXmlId();
@@ -16894,10 +18446,10 @@ ostream& HumHash::printXmlAsGlobal(ostream& out, int level,
 					}
 				} else {
 					str << Convert::repeatString(indent, level);
-					str << "<parameter key=\"" << it3.first << "\"";
+					str << "<parameter key=\"" << key << "\"";
 					str << " value=\"";
-					str << Convert::encodeXml(it3.second) << "\"";
-					ref = it3.second.origin;
+					str << Convert::encodeXml(value) << "\"";
+					ref = value.origin;
 					if (ref != NULL) {
 						str << " idref=\"";
 						str << ref->getXmlId();
@@ -16940,35 +18492,34 @@ ostream& HumHash::printXmlAsGlobal(ostream& out, int level,
 //
 
 ostream& operator<<(ostream& out, const HumHash& hash) {
-	if (hash.parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = hash.getParameterView(storage);
+	if (view == NULL) {
 		return out;
 	}
-	if (hash.parameters->size() == 0) {
+	if (view->size() == 0) {
 		return out;
 	}
+	const HumHashEntries& entries = *view;
 
 	string cleaned;
 
-	for (auto& it1 : *(hash.parameters)) {
-		if (it1.second.size() == 0) {
-			continue;
-		}
-		for (auto& it2 : it1.second) {
-			if (it2.second.size() == 0) {
-				continue;
-			}
-			out << hash.prefix;
-			out << it1.first << ":" << it2.first;
-			for (auto& it3 : it2.second) {
-				out << ":" << it3.first;
-				if (it3.second != "true") {
-					cleaned = it3.second;
-					Convert::replaceOccurrences(cleaned, ":", "&colon;");
-					out << "=" << cleaned;
-				}
+	int i = 0;
+	while (i < (int)entries.size()) {
+		int ns1 = entries[i].ns1;
+		int ns2 = entries[i].ns2;
+		out << hash.prefix;
+		out << HumParameterName::getName(ns1) << ":" << HumParameterName::getName(ns2);
+		for (; (i < (int)entries.size()) && (entries[i].ns1 == ns1) &&
+				(entries[i].ns2 == ns2); i++) {
+			out << ":" << HumParameterName::getName(entries[i].key);
+			if (entries[i].value != "true") {
+				cleaned = entries[i].value;
+				Convert::replaceOccurrences(cleaned, ":", "&colon;");
+				out << "=" << cleaned;
 			}
-			out << endl;
 		}
+		out << endl;
 	}
 
 	return out;
@@ -16985,7 +18536,7 @@ typedef unsigned long long TEMP64BITFIX;
 
 // declare static variables
 vector<_HumInstrument> HumInstrument::m_data;
-int HumInstrument::m_classcount = 0;
+std::once_flag HumInstrument::m_initialized;
 
 
 //////////////////////////////
@@ -16994,10 +18545,9 @@ int HumInstrument::m_classcount = 0;
 //
 
 HumInstrument::HumInstrument(void) {
-	if (m_classcount == 0) {
-		initialize();
-	}
-	m_classcount++;
+	// The instrument table is shared by all objects, which may be created
+	// in different threads:
+	std::call_once(m_initialized, &HumInstrument::initialize, this);
 	m_index = -1;
 }
 
@@ -17009,9 +18559,7 @@ HumInstrument::HumInstrument(void) {
 //
 
 HumInstrument::HumInstrument(const string& Hname) {
-	if (m_classcount == 0) {
-		initialize();
-	}
+	std::call_once(m_initialized, &HumInstrument::initialize, this);
 
 	m_index = find(Hname);
 }
@@ -17452,6 +19000,314 @@ void HumInstrument::sortData(void) {
 
 
 
+
+//////////////////////////////
+//
+// incrementKernCount -- Add one to a marker count, stopping at the
+//     largest value which can be stored.
+//
+
+static void incrementKernCount(unsigned char& count) {
+	if (count < 255) {
+		count++;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKernNote::getBase40Pitch -- Return the base-40 pitch of the note,
+//     0 for a rest, or a negative value for a secondary tied note.
+//
+
+int HumKernNote::getBase40Pitch(void) const {
+	if (isRest()) {
+		return 0;
+	}
+	return isSecondaryTie() ? -base40 : base40;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernNote::getMidiPitch -- Return the MIDI note number of the note,
+//     0 for a rest, or a negative value for a secondary tied note.
+//
+
+int HumKernNote::getMidiPitch(void) const {
+	if (isRest()) {
+		return 0;
+	}
+	return isSecondaryTie() ? -midi : midi;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::HumKernRecord -- Decode the text of a token.  Notes
+//     in a chord are separated by spaces (empty subtokens are ignored
+//     in the same way as HumdrumToken::getSubtokens()).
+//
+
+HumKernRecord::HumKernRecord(const std::string& text) {
+	HumKernNote total;
+	parseNote(total, text);
+	m_flags        = total.flags;
+	m_slurStarts   = total.slurStarts;
+	m_slurEnds     = total.slurEnds;
+	m_phraseStarts = total.phraseStarts;
+	m_phraseEnds   = total.phraseEnds;
+	m_beamStarts   = total.beamStarts;
+	m_beamEnds     = total.beamEnds;
+	m_chord        = text.find(' ') != std::string::npos;
+	m_size         = text.size();
+	m_hash         = getTextHash(text);
+
+	if (!m_chord) {
+		if (!text.empty()) {
+			m_notes.push_back(total);
+			m_notes.back().duration = Convert::recipToDuration(text);
+		}
+		return;
+	}
+
+	std::string::size_type start = 0;
+	while (start < text.size()) {
+		std::string::size_type pos = text.find(' ', start);
+		if (pos == std::string::npos) {
+			pos = text.size();
+		}
+		if (pos > start) {
+			std::string subtoken = text.substr(start, pos - start);
+			m_notes.emplace_back();
+			HumKernNote& note = m_notes.back();
+			parseNote(note, subtoken);
+			note.duration = Convert::recipToDuration(subtoken);
+		}
+		start = pos + 1;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::isRecordOf -- Returns true if the record was made from
+//     the given text (compared by length and hash).
+//
+
+bool HumKernRecord::isRecordOf(const std::string& text) const {
+	return (text.size() == m_size) && (getTextHash(text) == m_hash);
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::getTextHash -- Return the 64-bit FNV-1a hash of a text.
+//
+
+uint64_t HumKernRecord::getTextHash(const std::string& text) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char ch : text) {
+		hash = (hash ^ ch) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::parseNote -- Set the pitch, flags and marker counts of
+//     a note from its text.  The pitch is calculated in the same way
+//     as Convert::kernToBase40() and Convert::kernToMidiNoteNumber(),
+//     but in a single pass.  Duration is filled in by the caller.
+//
+
+void HumKernRecord::parseNote(HumKernNote& note, const std::string& text) {
+	static const int base40pc[7] = { 2, 8, 14, 19, 25, 31, 37 };
+	static const int base12pc[7] = { 0, 2,  4,  5,  7,  9, 11 };
+	int diatonic = -2000;
+	int accid    = 0;
+	int upper    = 0;
+	int lower    = 0;
+	char lastch  = '\0';
+	for (int i=0; i<(int)text.size(); i++) {
+		char ch = text[i];
+		if ((ch >= 'a') && (ch <= 'g')) {
+			lower++;
+			if (diatonic == -2000) {
+				diatonic = (ch - 'a' + 5) % 7;
+			}
+		} else if ((ch >= 'A') && (ch <= 'G')) {
+			upper++;
+			if (diatonic == -2000) {
+				diatonic = (ch - 'A' + 5) % 7;
+			}
+		}
+		switch (ch) {
+			case '#': accid++;                                 break;
+			case '-': accid--;                                 break;
+			case 'r': note.flags |= HumKernNote::Rest;        break;
+			case 'R': note.flags |= HumKernNote::Unpitched;   break;
+			case 'q': note.flags |= HumKernNote::Grace;       break;
+			case '[': note.flags |= HumKernNote::TieStart;    break;
+			case '_': note.flags |= HumKernNote::TieContinue; break;
+			case ']': note.flags |= HumKernNote::TieEnd;      break;
+			case 'k':
+			case 'K': note.flags |= HumKernNote::PartialBeam; break;
+			case '.': incrementKernCount(note.dots);          break;
+			case '(': incrementKernCount(note.slurStarts);    break;
+			case ')': incrementKernCount(note.slurEnds);      break;
+			case '{': incrementKernCount(note.phraseStarts);  break;
+			case '}': incrementKernCount(note.phraseEnds);    break;
+			case 'L': incrementKernCount(note.beamStarts);    break;
+			case 'J': incrementKernCount(note.beamEnds);      break;
+			case 'y':
+				if (lastch == 'y') {
+					note.flags |= HumKernNote::Invisible;
+				}
+				break;
+		}
+		lastch = ch;
+	}
+
+	if (upper || lower) {
+		note.flags |= HumKernNote::PitchLetter;
+	}
+	if (note.isRest()) {
+		return;
+	}
+	int octave = -1000;
+	if (upper && !lower) {
+		octave = 4 - upper;
+	} else if (lower && !upper) {
+		octave = 3 + lower;
+	}
+	if (diatonic < 0) {
+		note.base40 = diatonic;
+		note.midi   = diatonic + 12 * (octave + 1);
+	} else {
+		note.base40 = base40pc[diatonic] + accid + 40 * octave;
+		note.midi   = base12pc[diatonic] + accid + 12 * (octave + 1);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::isNote -- True if the token has a pitch and is not a
+//     rest (same as Convert::isKernNote()).
+//
+
+bool HumKernRecord::isNote(void) const {
+	if (m_flags & HumKernNote::Rest) {
+		return false;
+	}
+	return m_flags & HumKernNote::PitchLetter;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::isSecondaryTiedNote -- True if the token is a note
+//     with a '_' or ']' (same as Convert::isKernSecondaryTiedNote()).
+//
+
+bool HumKernRecord::isSecondaryTiedNote(void) const {
+	if (!isNote()) {
+		return false;
+	}
+	return m_flags & (HumKernNote::TieContinue | HumKernNote::TieEnd);
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::hasBeam -- True if the token has L, J, K, or k.
+//
+
+bool HumKernRecord::hasBeam(void) const {
+	if (m_beamStarts || m_beamEnds) {
+		return true;
+	}
+	return m_flags & HumKernNote::PartialBeam;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::getBase40Pitches -- Return the base-40 pitch of each
+//     note, with 0 for rests and negative values for secondary tied notes.
+//
+
+void HumKernRecord::getBase40Pitches(std::vector<int>& output) const {
+	output.resize(m_notes.size());
+	for (int i=0; i<(int)m_notes.size(); i++) {
+		output[i] = m_notes[i].getBase40Pitch();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::getMidiPitches -- Return the MIDI note number of each
+//     note, with 0 for rests and negative values for secondary tied notes.
+//
+
+void HumKernRecord::getMidiPitches(std::vector<int>& output) const {
+	output.resize(m_notes.size());
+	for (int i=0; i<(int)m_notes.size(); i++) {
+		output[i] = m_notes[i].getMidiPitch();
+	}
+}
+
+
+
+thread_local bool HumNum::m_overflow = false;
+
+
+//////////////////////////////
+//
+// isHumNumPowerOfTwo -- Returns true if the value is a positive power
+//     of two (including 1).
+//
+
+static inline bool isHumNumPowerOfTwo(int64_t value) {
+	return (value > 0) && !(value & (value - 1));
+}
+
+
+
+//////////////////////////////
+//
+// getHumNumTrailingZeros -- Returns the number of trailing zero bits
+//     in a non-zero value.
+//
+
+static inline int getHumNumTrailingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(value);
+#else
+	int count = 0;
+	while (!(value & 1)) {
+		value >>= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+
 //////////////////////////////
 //
 // HumNum::HumNum -- HumNum Constructor.  Set the default value
@@ -17652,9 +19508,7 @@ void HumNum::setValue(int numerator) {
 
 
 void HumNum::setValue(int numerator, int denominator) {
-	top = numerator;
-	bot = denominator;
-	reduce();
+	setReduced(numerator, denominator);
 }
 
 
@@ -17735,24 +19589,105 @@ HumNum& HumNum::makeAbs(void) {
 //
 
 void HumNum::reduce(void) {
-	int a = getNumerator();
-	int b = getDenominator();
-	if (a == 1 || b == 1) {
-		return;
+	setReduced(top, bot);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum::setReduced -- Store the reduced form of a fraction which was
+//    calculated with 64-bit integers.  Denominators which are powers of
+//    two (the usual case for durations) are reduced by removing common
+//    factors of two rather than calculating a GCD.  If the reduced
+//    fraction does not fit into 32-bit integers, it is approximated by
+//    dropping low bits of both numbers, and the overflow flag is set
+//    (see hasOverflow()).
+//
+
+void HumNum::setReduced(int64_t a, int64_t b) {
+	if ((a == 1) || (b == 1) || (b == 0)) {
+		// nothing to reduce (infinite values are not reduced)
+	} else if (a == 0) {
+		b = 1;
+	} else if (isHumNumPowerOfTwo(b)) {
+		int shift = getHumNumTrailingZeros((uint64_t)a);
+		int bshift = getHumNumTrailingZeros((uint64_t)b);
+		if (bshift < shift) {
+			shift = bshift;
+		}
+		a >>= shift;
+		b >>= shift;
+	} else {
+		int64_t gcdval = gcd64(a, b);
+		if (gcdval > 1) {
+			a /= gcdval;
+			b /= gcdval;
+		}
 	}
-	if (a == 0) {
-		bot = 1;
-		return;
+	if ((a < INT_MIN) || (a > INT_MAX) || (b < INT_MIN) || (b > INT_MAX)) {
+		m_overflow = true;
+		while ((a < INT_MIN) || (a > INT_MAX) || (b < INT_MIN) || (b > INT_MAX)) {
+			a /= 2;
+			b /= 2;
+		}
 	}
-	if (b == 0) {
-		a = 0;
-		b = 0;
+	top = (int)a;
+	bot = (int)b;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum::hasOverflow -- Returns true if a calculation in the current
+//    thread gave a result which did not fit into 32-bit integers since
+//    the last call to clearOverflow().  File analyses which calculate
+//    durations check this and report overflows as parse errors.
+//
+
+bool HumNum::hasOverflow(void) {
+	return m_overflow;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum::clearOverflow -- Clear the overflow flag of the current thread.
+//
+
+void HumNum::clearOverflow(void) {
+	m_overflow = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum::gcd64 -- Returns the (non-negative) greatest common divisor of
+//      two 64-bit numbers, using 32-bit division when both fit.
+//
+
+int64_t HumNum::gcd64(int64_t a, int64_t b) {
+	uint64_t x = a < 0 ? -(uint64_t)a : (uint64_t)a;
+	uint64_t y = b < 0 ? -(uint64_t)b : (uint64_t)b;
+	if ((x | y) <= UINT_MAX) {
+		uint32_t x32 = (uint32_t)x;
+		uint32_t y32 = (uint32_t)y;
+		while (y32) {
+			uint32_t c = x32 % y32;
+			x32 = y32;
+			y32 = c;
+		}
+		return x32;
 	}
-	int gcdval = gcdIterative(a, b);
-	if (gcdval > 1) {
-		top /= gcdval;
-		bot /= gcdval;
+	while (y) {
+		uint64_t c = x % y;
+		x = y;
+		y = c;
 	}
+	return (int64_t)x;
 }
 
 
@@ -17866,19 +19801,29 @@ bool HumNum::isPowerOfTwo(void) const {
 //
 
 HumNum HumNum::operator+(const HumNum& value) const {
-	int a1  = getNumerator();
-	int b1  = getDenominator();
-	int a2  = value.getNumerator();
-	int b2  = value.getDenominator();
-	int ao = a1*b2 + a2 * b1;
-	int bo = b1*b2;
-	HumNum output(ao, bo);
+	int64_t a1 = top;
+	int64_t b1 = bot;
+	int64_t a2 = value.top;
+	int64_t b2 = value.bot;
+	HumNum output;
+	if ((b1 == b2) && (b1 > 0)) {
+		output.setReduced(a1 + a2, b1);
+	} else if (isHumNumPowerOfTwo(b1) && isHumNumPowerOfTwo(b2)) {
+		if (b1 > b2) {
+			output.setReduced(a1 + a2 * (b1 / b2), b1);
+		} else {
+			output.setReduced(a1 * (b2 / b1) + a2, b2);
+		}
+	} else {
+		output.setReduced(a1 * b2 + a2 * b1, b1 * b2);
+	}
 	return output;
 }
 
 
 HumNum HumNum::operator+(int value) const {
-	HumNum output(value * bot + top, bot);
+	HumNum output;
+	output.setReduced((int64_t)value * bot + top, bot);
 	return output;
 }
 
@@ -17892,19 +19837,29 @@ HumNum HumNum::operator+(int value) const {
 //
 
 HumNum HumNum::operator-(const HumNum& value) const {
-	int a1  = getNumerator();
-	int b1  = getDenominator();
-	int a2  = value.getNumerator();
-	int b2  = value.getDenominator();
-	int ao = a1*b2 - a2*b1;
-	int bo = b1*b2;
-	HumNum output(ao, bo);
+	int64_t a1 = top;
+	int64_t b1 = bot;
+	int64_t a2 = value.top;
+	int64_t b2 = value.bot;
+	HumNum output;
+	if ((b1 == b2) && (b1 > 0)) {
+		output.setReduced(a1 - a2, b1);
+	} else if (isHumNumPowerOfTwo(b1) && isHumNumPowerOfTwo(b2)) {
+		if (b1 > b2) {
+			output.setReduced(a1 - a2 * (b1 / b2), b1);
+		} else {
+			output.setReduced(a1 * (b2 / b1) - a2, b2);
+		}
+	} else {
+		output.setReduced(a1 * b2 - a2 * b1, b1 * b2);
+	}
 	return output;
 }
 
 
 HumNum HumNum::operator-(int value) const {
-	HumNum output(top - value * bot, bot);
+	HumNum output;
+	output.setReduced(top - (int64_t)value * bot, bot);
 	return output;
 }
 
@@ -17917,7 +19872,8 @@ HumNum HumNum::operator-(int value) const {
 //
 
 HumNum HumNum::operator-(void) const {
-	HumNum output(-top, bot);
+	HumNum output;
+	output.setReduced(-(int64_t)top, bot);
 	return output;
 }
 
@@ -17930,19 +19886,15 @@ HumNum HumNum::operator-(void) const {
 //
 
 HumNum HumNum::operator*(const HumNum& value) const {
-	int a1  = getNumerator();
-	int b1  = getDenominator();
-	int a2  = value.getNumerator();
-	int b2  = value.getDenominator();
-	int ao = a1*a2;
-	int bo = b1*b2;
-	HumNum output(ao, bo);
+	HumNum output;
+	output.setReduced((int64_t)top * value.top, (int64_t)bot * value.bot);
 	return output;
 }
 
 
 HumNum HumNum::operator*(int value) const {
-	HumNum output(top * value, bot);
+	HumNum output;
+	output.setReduced((int64_t)top * value, bot);
 	return output;
 }
 
@@ -17955,27 +19907,23 @@ HumNum HumNum::operator*(int value) const {
 //
 
 HumNum HumNum::operator/(const HumNum& value) const {
-	int a1  = getNumerator();
-	int b1  = getDenominator();
-	int a2  = value.getNumerator();
-	int b2  = value.getDenominator();
-	int ao = a1*b2;
-	int bo = b1*a2;
-	HumNum output(ao, bo);
+	HumNum output;
+	output.setReduced((int64_t)top * value.bot, (int64_t)bot * value.top);
 	return output;
 }
 
 
 HumNum HumNum::operator/(int value) const {
-	int a  = getNumerator();
-	int b  = getDenominator();
+	int64_t a = top;
+	int64_t b = bot;
 	if (value < 0) {
 		a = -a;
-		b *= -value;
+		b *= -(int64_t)value;
 	} else {
 		b *= value;
 	}
-	HumNum output(a, b);
+	HumNum output;
+	output.setReduced(a, b);
 	return output;
 }
 
@@ -17988,10 +19936,9 @@ HumNum HumNum::operator/(int value) const {
 //
 
 HumNum& HumNum::operator=(const HumNum& value) {
-	if (this == &value) {
-		return *this;
-	}
-	setValue(value.top, value.bot);
+	// HumNums are always stored in reduced form.
+	top = value.top;
+	bot = value.bot;
 	return *this;
 }
 
@@ -18085,11 +20032,17 @@ bool HumNum::operator<(const HumNum& value) const {
 	if (this == &value) {
 		return false;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot < (int64_t)value.top * bot;
+	}
 	return getFloat() < value.getFloat();
 }
 
 
 bool HumNum::operator<(int value) const {
+	if (bot > 0) {
+		return top < (int64_t)value * bot;
+	}
 	return getFloat() < value;
 }
 
@@ -18110,11 +20063,17 @@ bool HumNum::operator<=(const HumNum& value) const {
 	if (this == &value) {
 		return true;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot <= (int64_t)value.top * bot;
+	}
 	return getFloat() <= value.getFloat();
 }
 
 
 bool HumNum::operator<=(int value) const {
+	if (bot > 0) {
+		return top <= (int64_t)value * bot;
+	}
 	return getFloat() <= value;
 }
 
@@ -18135,11 +20094,17 @@ bool HumNum::operator>(const HumNum& value) const {
 	if (this == &value) {
 		return false;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot > (int64_t)value.top * bot;
+	}
 	return getFloat() > value.getFloat();
 }
 
 
 bool HumNum::operator>(int value) const {
+	if (bot > 0) {
+		return top > (int64_t)value * bot;
+	}
 	return getFloat() > value;
 }
 
@@ -18160,11 +20125,17 @@ bool HumNum::operator>=(const HumNum& value) const {
 	if (this == &value) {
 		return true;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot >= (int64_t)value.top * bot;
+	}
 	return getFloat() >= value.getFloat();
 }
 
 
 bool HumNum::operator>=(int value) const {
+	if (bot > 0) {
+		return top >= (int64_t)value * bot;
+	}
 	return getFloat() >= value;
 }
 
@@ -18185,11 +20156,17 @@ bool HumNum::operator==(const HumNum& value) const {
 	if (this == &value) {
 		return true;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot == (int64_t)value.top * bot;
+	}
 	return getFloat() == value.getFloat();
 }
 
 
 bool HumNum::operator==(int value) const {
+	if (bot > 0) {
+		return top == (int64_t)value * bot;
+	}
 	return getFloat() == value;
 }
 
@@ -18210,11 +20187,17 @@ bool HumNum::operator!=(const HumNum& value) const {
 	if (this == &value) {
 		return false;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot != (int64_t)value.top * bot;
+	}
 	return getFloat() != value.getFloat();
 }
 
 
 bool HumNum::operator!=(int value) const {
+	if (bot > 0) {
+		return top != (int64_t)value * bot;
+	}
 	return getFloat() != value;
 }
 
@@ -18648,6 +20631,239 @@ ostream& operator<<(ostream& out, HumParamSet& hps) {
 
 
 
+// Names are stored in blocks which are never moved or deleted, so names
+// can be read without locking while other threads add new names.  Each
+// block is twice the size of the previous one, so the blocks can hold
+// any id which fits into an int.
+static const int HumParameterNameBlockSize = 256;  // size of the first block
+static const int HumParameterNameMaxBlocks = 23;
+
+// HumParameterNameIndex: Open-addressing hash table from names to ids.
+// Each slot holds an id plus one, or 0 if the slot is empty.  Slots are
+// only filled (never changed afterwards) while the mutex of the table is
+// held, so they can be searched without locking.  When the index is half
+// full, a larger copy replaces it.  Replaced indexes are not deleted,
+// since other threads may still be searching them.
+struct HumParameterNameIndex {
+	size_t            capacity;   // power of two
+	std::atomic<int>* slots;
+	explicit HumParameterNameIndex(size_t size) : capacity(size),
+			slots(new std::atomic<int>[size]) {
+		for (size_t i=0; i<size; i++) {
+			slots[i] = 0;
+		}
+	}
+};
+
+struct HumParameterNameTable {
+	std::mutex                          mutex;
+	std::atomic<std::string*>           blocks[HumParameterNameMaxBlocks];
+	std::atomic<HumParameterNameIndex*> index;
+	std::atomic<int>                    count;
+	HumParameterNameTable(void);
+	int                add(std::string_view name);
+	int                find(std::string_view name);
+	const std::string& getEntry(int id);
+	void               insert(HumParameterNameIndex* target, int id);
+};
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::HumParameterNameTable -- Enter the empty name
+//     so that it has the id HumParameterName::Empty.
+//
+
+HumParameterNameTable::HumParameterNameTable(void) : count(0) {
+	for (int i=0; i<HumParameterNameMaxBlocks; i++) {
+		blocks[i] = NULL;
+	}
+	index = new HumParameterNameIndex(1024);
+	add("");
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::getEntry -- Return the stored name for an id
+//     which is in the table.
+//
+
+const std::string& HumParameterNameTable::getEntry(int id) {
+	int block = 0;
+	int offset = id;
+	while (offset >= (HumParameterNameBlockSize << block)) {
+		offset -= HumParameterNameBlockSize << block;
+		block++;
+	}
+	return blocks[block].load(std::memory_order_acquire)[offset];
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::find -- Return the id of a name, or
+//     HumParameterName::Unknown if it is not in the table.  No lock is
+//     needed.
+//
+
+int HumParameterNameTable::find(std::string_view name) {
+	HumParameterNameIndex* current = index.load(std::memory_order_acquire);
+	size_t mask = current->capacity - 1;
+	for (size_t i=std::hash<std::string_view>()(name) & mask; ; i=(i+1) & mask) {
+		int slot = current->slots[i].load(std::memory_order_acquire);
+		if (slot == 0) {
+			return HumParameterName::Unknown;
+		}
+		if (getEntry(slot - 1) == name) {
+			return slot - 1;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::insert -- Store an id in the first empty slot
+//     for its name.  The mutex must be held by the caller.
+//
+
+void HumParameterNameTable::insert(HumParameterNameIndex* target, int id) {
+	size_t mask = target->capacity - 1;
+	size_t i = std::hash<std::string_view>()(getEntry(id)) & mask;
+	while (target->slots[i].load(std::memory_order_relaxed) != 0) {
+		i = (i + 1) & mask;
+	}
+	target->slots[i].store(id + 1, std::memory_order_release);
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::add -- Append a new name to the table.  The
+//     mutex must be held by the caller (except in the constructor).
+//
+
+int HumParameterNameTable::add(std::string_view name) {
+	int id = count;
+	int block = 0;
+	int offset = id;
+	while ((block < HumParameterNameMaxBlocks) &&
+			(offset >= (HumParameterNameBlockSize << block))) {
+		offset -= HumParameterNameBlockSize << block;
+		block++;
+	}
+	if ((block >= HumParameterNameMaxBlocks) || (id == INT_MAX)) {
+		throw std::length_error("HumParameterName: too many parameter names");
+	}
+	if (blocks[block] == NULL) {
+		blocks[block] = new std::string[HumParameterNameBlockSize << block];
+	}
+	blocks[block].load()[offset].assign(name.data(), name.size());
+
+	HumParameterNameIndex* current = index;
+	if ((size_t)(id + 1) * 2 > current->capacity) {
+		HumParameterNameIndex* larger = new HumParameterNameIndex(current->capacity * 2);
+		for (int i=0; i<=id; i++) {
+			insert(larger, i);
+		}
+		index.store(larger, std::memory_order_release);
+	} else {
+		insert(current, id);
+	}
+	count = id + 1;
+	return id;
+}
+
+
+
+//////////////////////////////
+//
+// getHumParameterNameTable -- The table is allocated once and never
+//     deleted so that it can be used during program shutdown.
+//
+
+static HumParameterNameTable& getHumParameterNameTable(void) {
+	static HumParameterNameTable* table = new HumParameterNameTable;
+	return *table;
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterName::getId -- Return the id for a name, adding it to the
+//     table if it has not been seen before.  Names which are already in
+//     the table are found without locking.
+//
+
+int HumParameterName::getId(std::string_view name) {
+	if (name.empty()) {
+		return Empty;
+	}
+	HumParameterNameTable& table = getHumParameterNameTable();
+	int id = table.find(name);
+	if (id != Unknown) {
+		return id;
+	}
+	std::lock_guard<std::mutex> lock(table.mutex);
+	id = table.find(name);
+	if (id != Unknown) {
+		return id;
+	}
+	return table.add(name);
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterName::findId -- Return the id for a name, or
+//     HumParameterName::Unknown if the name is not in the table.  Use
+//     this function for lookups, since a parameter cannot have a name
+//     which is not in the table.  No lock is needed.
+//
+
+int HumParameterName::findId(std::string_view name) {
+	if (name.empty()) {
+		return Empty;
+	}
+	return getHumParameterNameTable().find(name);
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterName::getName -- Return the name for an id, or an empty
+//     string if the id is not in the table.
+//
+
+const std::string& HumParameterName::getName(int id) {
+	HumParameterNameTable& table = getHumParameterNameTable();
+	if ((id < 0) || (id >= table.count)) {
+		id = Empty;
+	}
+	return table.getEntry(id);
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterName::getCount -- Return the number of names in the table.
+//
+
+int HumParameterName::getCount(void) {
+	return getHumParameterNameTable().count;
+}
+
+
+
 
 const std::vector<char> HumPitch::m_diatonicPC2letterLC({ 'c', 'd', 'e', 'f', 'g', 'a', 'b' });
 const std::vector<char> HumPitch::m_diatonicPC2letterUC({ 'C', 'D', 'E', 'F', 'G', 'A', 'B' });
@@ -19031,6 +21247,303 @@ bool HumPitch::setScientificPitch(const std::string& pitch) {
 
 
 
+// HumPoolBlock: Link for a free block on a free list.
+struct HumPoolBlock {
+	HumPoolBlock* next;
+};
+
+// HumPoolSizeClass: Shared free list for one block size.  Blocks
+// are moved between this list and the thread caches in batches.
+// The slabs which have been cut into blocks of this size are kept
+// so that HumPool::trim() can release the slabs which are unused.
+struct HumPoolSizeClass {
+	std::mutex          mutex;
+	HumPoolBlock*       freelist = NULL;
+	std::vector<char*>  slabs;
+};
+
+// HumPoolThreadCache: Free blocks which are private to one thread.
+// When the thread exits, its blocks are returned to the shared lists.
+struct HumPoolThreadCache {
+	HumPoolBlock* freelist[HumPool::MaxBlockSize / HumPool::Granularity] = {};
+	size_t        count[HumPool::MaxBlockSize / HumPool::Granularity] = {};
+	void flush(void);
+	~HumPoolThreadCache();
+};
+
+static const int HumPoolClassCount = HumPool::MaxBlockSize / HumPool::Granularity;
+
+// Number of blocks moved between a thread cache and a shared list at once:
+static const size_t HumPoolBatch = 64;
+
+static std::atomic<size_t> HumPoolSlabCount(0);
+static std::atomic<size_t> HumPoolReservedBytes(0);
+
+
+//////////////////////////////
+//
+// getHumPoolSizeClasses -- The shared lists are allocated once and never
+//    deleted so that threads exiting during program shutdown can still
+//    return their cached blocks.
+//
+
+static HumPoolSizeClass* getHumPoolSizeClasses(void) {
+	static HumPoolSizeClass* classes = new HumPoolSizeClass[HumPoolClassCount];
+	return classes;
+}
+
+static thread_local HumPoolThreadCache HumPoolCache;
+
+
+
+//////////////////////////////
+//
+// HumPoolThreadCache::~HumPoolThreadCache --
+//
+
+HumPoolThreadCache::~HumPoolThreadCache() {
+	flush();
+}
+
+
+
+//////////////////////////////
+//
+// HumPoolThreadCache::flush -- Give all cached blocks back to the shared
+//    free lists.
+//
+
+void HumPoolThreadCache::flush(void) {
+	HumPoolSizeClass* classes = getHumPoolSizeClasses();
+	for (int i=0; i<HumPoolClassCount; i++) {
+		if (freelist[i] == NULL) {
+			continue;
+		}
+		HumPoolBlock* last = freelist[i];
+		while (last->next) {
+			last = last->next;
+		}
+		std::lock_guard<std::mutex> lock(classes[i].mutex);
+		last->next = classes[i].freelist;
+		classes[i].freelist = freelist[i];
+		freelist[i] = NULL;
+		count[i] = 0;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// refillHumPoolCache -- Take a batch of blocks from the shared list for
+//    the given size class, or cut up a new slab if the shared list is empty.
+//
+
+static void refillHumPoolCache(HumPoolThreadCache& cache, int index) {
+	HumPoolSizeClass& sizeclass = getHumPoolSizeClasses()[index];
+	{
+		std::lock_guard<std::mutex> lock(sizeclass.mutex);
+		HumPoolBlock* block = sizeclass.freelist;
+		size_t count = 0;
+		while (block && (count < HumPoolBatch)) {
+			HumPoolBlock* next = block->next;
+			block->next = cache.freelist[index];
+			cache.freelist[index] = block;
+			block = next;
+			count++;
+		}
+		sizeclass.freelist = block;
+		cache.count[index] += count;
+		if (count) {
+			return;
+		}
+	}
+
+	size_t blocksize = (index + 1) * HumPool::Granularity;
+	char* slab = static_cast<char*>(::operator new(HumPool::SlabSize));
+	{
+		std::lock_guard<std::mutex> lock(sizeclass.mutex);
+		sizeclass.slabs.push_back(slab);
+	}
+	HumPoolSlabCount++;
+	HumPoolReservedBytes += HumPool::SlabSize;
+	size_t blocks = HumPool::SlabSize / blocksize;
+	// Link the blocks in reverse order so that they are handed out
+	// in increasing address order:
+	for (size_t i=blocks; i-- > 0; ) {
+		HumPoolBlock* block = reinterpret_cast<HumPoolBlock*>(slab + i * blocksize);
+		block->next = cache.freelist[index];
+		cache.freelist[index] = block;
+	}
+	cache.count[index] += blocks;
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::allocate -- Return a block of memory that can hold at
+//     least the given number of bytes.
+//
+
+void* HumPool::allocate(size_t size) {
+#ifdef HUMLIB_NO_POOL
+	return ::operator new(size);
+#else
+	if ((size == 0) || (size > MaxBlockSize)) {
+		return ::operator new(size);
+	}
+	int index = (int)((size - 1) / Granularity);
+	HumPoolThreadCache& cache = HumPoolCache;
+	if (cache.freelist[index] == NULL) {
+		refillHumPoolCache(cache, index);
+	}
+	HumPoolBlock* block = cache.freelist[index];
+	cache.freelist[index] = block->next;
+	cache.count[index]--;
+	return block;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::deallocate -- Return a block to the pool.  The size must be
+//     the same as the one given to HumPool::allocate() for the block.
+//
+
+void HumPool::deallocate(void* ptr, size_t size) {
+	if (ptr == NULL) {
+		return;
+	}
+#ifdef HUMLIB_NO_POOL
+	::operator delete(ptr);
+#else
+	if ((size == 0) || (size > MaxBlockSize)) {
+		::operator delete(ptr);
+		return;
+	}
+	int index = (int)((size - 1) / Granularity);
+	HumPoolThreadCache& cache = HumPoolCache;
+	HumPoolBlock* block = static_cast<HumPoolBlock*>(ptr);
+	block->next = cache.freelist[index];
+	cache.freelist[index] = block;
+	cache.count[index]++;
+
+	if (cache.count[index] < 2 * HumPoolBatch) {
+		return;
+	}
+
+	// Too many cached blocks for this thread: move a batch to the
+	// shared list so that other threads can use them.
+	HumPoolBlock* first = cache.freelist[index];
+	HumPoolBlock* last = first;
+	for (size_t i=1; i<HumPoolBatch; i++) {
+		last = last->next;
+	}
+	cache.freelist[index] = last->next;
+	cache.count[index] -= HumPoolBatch;
+	HumPoolSizeClass& sizeclass = getHumPoolSizeClasses()[index];
+	std::lock_guard<std::mutex> lock(sizeclass.mutex);
+	last->next = sizeclass.freelist;
+	sizeclass.freelist = first;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::trim -- Give the slabs in which all blocks are free back to
+//     the system allocator, after moving the free blocks cached by the
+//     calling thread to the shared lists.  Blocks cached by other threads
+//     are treated as being in use.  Returns the number of slabs released.
+//     This takes time in proportion to the number of free blocks, so it
+//     should be called after large files have been deleted (or when a
+//     program is idle) rather than after each file.
+//
+
+size_t HumPool::trim(void) {
+#ifdef HUMLIB_NO_POOL
+	return 0;
+#else
+	HumPoolCache.flush();
+	size_t released = 0;
+	HumPoolSizeClass* classes = getHumPoolSizeClasses();
+	for (int i=0; i<HumPoolClassCount; i++) {
+		HumPoolSizeClass& sizeclass = classes[i];
+		std::lock_guard<std::mutex> lock(sizeclass.mutex);
+		if ((sizeclass.freelist == NULL) || sizeclass.slabs.empty()) {
+			continue;
+		}
+		vector<char*>& slabs = sizeclass.slabs;
+		std::sort(slabs.begin(), slabs.end(), std::less<char*>());
+		auto getSlab = [&slabs](HumPoolBlock* block) {
+			char* address = reinterpret_cast<char*>(block);
+			auto it = std::upper_bound(slabs.begin(), slabs.end(), address, std::less<char*>());
+			return (size_t)(it - slabs.begin()) - 1;
+		};
+
+		// Count the free blocks in each slab:
+		size_t blocks = SlabSize / ((i + 1) * Granularity);
+		vector<size_t> freecount(slabs.size(), 0);
+		for (HumPoolBlock* block = sizeclass.freelist; block; block = block->next) {
+			freecount[getSlab(block)]++;
+		}
+
+		// Remove the blocks of unused slabs from the free list, then
+		// release the slabs:
+		HumPoolBlock** link = &sizeclass.freelist;
+		while (*link) {
+			if (freecount[getSlab(*link)] == blocks) {
+				*link = (*link)->next;
+			} else {
+				link = &(*link)->next;
+			}
+		}
+		size_t kept = 0;
+		for (size_t j=0; j<slabs.size(); j++) {
+			if (freecount[j] == blocks) {
+				::operator delete(slabs[j]);
+				released++;
+			} else {
+				slabs[kept++] = slabs[j];
+			}
+		}
+		slabs.resize(kept);
+	}
+	HumPoolSlabCount -= released;
+	HumPoolReservedBytes -= released * SlabSize;
+	return released;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::getSlabCount -- Return the number of slabs requested from
+//     the system allocator which have not been released by trim().
+//
+
+size_t HumPool::getSlabCount(void) {
+	return HumPoolSlabCount;
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::getReservedBytes -- Return the total size of all slabs.
+//
+
+size_t HumPool::getReservedBytes(void) {
+	return HumPoolReservedBytes;
+}
+
+
+
 
 //////////////////////////////
 //
@@ -19053,7 +21566,7 @@ HumRegex::HumRegex(const string& exp, const string& options) {
 		// explicitly set the default syntax
 		m_regexflags = std::regex_constants::ECMAScript;
 	}
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
+	compile(exp, getTemporaryRegexFlags(options));
 	m_searchflags = (std::regex_constants::match_flag_type)0;
 	m_searchflags = getTemporarySearchFlags(options);
 }
@@ -19160,8 +21673,12 @@ void HumRegex::unsetGlobal(void) {
 //
 
 int HumRegex::search(const string& input, const string& exp) {
-	m_regex = regex(exp, m_regexflags);
-	bool result = regex_search(input, m_matches, m_regex, m_searchflags);
+	const regex& re = compile(exp, m_regexflags);
+	int status = searchLiteral(input, 0);
+	if (status >= 0) {
+		return status;
+	}
+	bool result = regex_search(input, m_matches, re, m_searchflags);
 	if (!result) {
 		return 0;
 	} else if (m_matches.size() < 1) {
@@ -19175,10 +21692,14 @@ int HumRegex::search(const string& input, const string& exp) {
 
 int HumRegex::search(const string& input, int startindex,
 		const string& exp) {
-	m_regex = regex(exp, m_regexflags);
+	const regex& re = compile(exp, m_regexflags);
+	int status = searchLiteral(input, startindex);
+	if (status >= 0) {
+		return status;
+	}
 	auto startit = input.begin() + startindex;
 	auto endit   = input.end();
-	bool result = regex_search(startit, endit, m_matches, m_regex, m_searchflags);
+	bool result = regex_search(startit, endit, m_matches, re, m_searchflags);
 	if (!result) {
 		return 0;
 	} else if (m_matches.size() < 1) {
@@ -19204,8 +21725,12 @@ int HumRegex::search(string* input, int startindex, const string& exp) {
 
 int HumRegex::search(const string& input, const string& exp,
 		const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
-	bool result = regex_search(input, m_matches, m_regex, getTemporarySearchFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
+	int status = searchLiteral(input, 0);
+	if (status >= 0) {
+		return status;
+	}
+	bool result = regex_search(input, m_matches, re, getTemporarySearchFlags(options));
 	if (!result) {
 		return 0;
 	} else if (m_matches.size() < 1) {
@@ -19218,10 +21743,14 @@ int HumRegex::search(const string& input, const string& exp,
 
 int HumRegex::search(const string& input, int startindex, const string& exp,
 		const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
+	int status = searchLiteral(input, startindex);
+	if (status >= 0) {
+		return status;
+	}
 	auto startit = input.begin() + startindex;
 	auto endit   = input.end();
-	bool result = regex_search(startit, endit, m_matches, m_regex, getTemporarySearchFlags(options));
+	bool result = regex_search(startit, endit, m_matches, re, getTemporarySearchFlags(options));
 	if (!result) {
 		return 0;
 	} else if (m_matches.size() < 1) {
@@ -19256,6 +21785,9 @@ int HumRegex::search(string* input, int startindex, const string& exp,
 //
 
 int HumRegex::getMatchCount(void) {
+	if (m_literalSearch) {
+		return m_literalCount;
+	}
 	return (int)m_matches.size();
 }
 
@@ -19271,9 +21803,12 @@ int HumRegex::getMatchCount(void) {
 string HumRegex::getMatch(int index) {
 	if (index < 0) {
 		return "";
-	} if (index >= (int)m_matches.size()) {
+	} if (index >= getMatchCount()) {
 		return "";
 	}
+	if (m_literalSearch) {
+		return m_literalInput->substr(m_literalBase + m_literalStart, m_literalLength);
+	}
 	string output = m_matches.str(index);
 	return output;
 }
@@ -19287,7 +21822,7 @@ string HumRegex::getMatch(int index) {
 //
 
 int HumRegex::getMatchInt(int index) {
-	string value = m_matches.str(index);
+	string value = m_literalSearch ? getMatch(index) : m_matches.str(index);
 	int output = 0;
 	if (value.size() > 0) {
 		if (isdigit(value[0])) {
@@ -19309,7 +21844,7 @@ int HumRegex::getMatchInt(int index) {
 //
 
 double HumRegex::getMatchDouble(int index) {
-	string value = m_matches.str(index);
+	string value = m_literalSearch ? getMatch(index) : m_matches.str(index);
 	if (value.size() > 0) {
 		return stod(value);
 	} else {
@@ -19326,6 +21861,12 @@ double HumRegex::getMatchDouble(int index) {
 //
 
 string HumRegex::getPrefix(void) {
+	if (m_literalSearch) {
+		if (m_literalCount == 0) {
+			return "";
+		}
+		return m_literalInput->substr(m_literalBase, m_literalStart);
+	}
 	return m_matches.prefix().str();
 }
 
@@ -19338,6 +21879,12 @@ string HumRegex::getPrefix(void) {
 //
 
 string HumRegex::getSuffix(void) {
+	if (m_literalSearch) {
+		if (m_literalCount == 0) {
+			return "";
+		}
+		return m_literalInput->substr(m_literalBase + m_literalStart + m_literalLength);
+	}
 	return m_matches.suffix().str();
 }
 
@@ -19350,6 +21897,9 @@ string HumRegex::getSuffix(void) {
 //
 
 int HumRegex::getMatchStartIndex(int index) {
+	if (m_literalSearch) {
+		return m_literalStart;
+	}
 	return (int)m_matches.position(index);
 }
 
@@ -19374,6 +21924,9 @@ int HumRegex::getMatchEndIndex(int index) {
 //
 
 int HumRegex::getMatchLength(int index) {
+	if (m_literalSearch) {
+		return ((index >= 0) && (index < m_literalCount)) ? m_literalLength : 0;
+	}
 	return (int)m_matches.length(index);
 }
 
@@ -19390,15 +21943,21 @@ int HumRegex::getMatchLength(int index) {
 //
 
 bool HumRegex::match(const string& input, const string& exp) {
-	m_regex = regex(exp, m_regexflags);
-	return regex_match(input, m_regex, m_searchflags);
+	const regex& re = compile(exp, m_regexflags);
+	if (m_pattern->m_literalOnly && getLiteralMatching()) {
+		return input == m_pattern->m_literal;
+	}
+	return regex_match(input, re, m_searchflags);
 }
 
 
 bool HumRegex::match(const string& input, const string& exp,
 		const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
-	return regex_match(input, m_regex, getTemporarySearchFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
+	if (m_pattern->m_literalOnly && getLiteralMatching()) {
+		return input == m_pattern->m_literal;
+	}
+	return regex_match(input, re, getTemporarySearchFlags(options));
 }
 
 
@@ -19429,8 +21988,13 @@ bool HumRegex::match(const string* input, const string& exp,
 
 string& HumRegex::replaceDestructive(string& input, const string& replacement,
 		const string& exp) {
-	m_regex = regex(exp, m_regexflags);
-	input = regex_replace(input, m_regex, replacement, m_searchflags);
+	const regex& re = compile(exp, m_regexflags);
+	string output;
+	if (replaceLiteral(output, input, replacement, m_searchflags)) {
+		input.swap(output);
+		return input;
+	}
+	input = regex_replace(input, re, replacement, m_searchflags);
 	return input;
 }
 
@@ -19446,8 +22010,13 @@ string& HumRegex::replaceDestructive(string* input, const string& replacement,
 
 string& HumRegex::replaceDestructive(string& input, const string& replacement,
 		const string& exp, const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
-	input = regex_replace(input, m_regex, replacement, getTemporarySearchFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
+	string output;
+	if (replaceLiteral(output, input, replacement, getTemporarySearchFlags(options))) {
+		input.swap(output);
+		return input;
+	}
+	input = regex_replace(input, re, replacement, getTemporarySearchFlags(options));
 	return input;
 }
 
@@ -19467,10 +22036,14 @@ string& HumRegex::replaceDestructive (string* input, const string& replacement,
 
 string HumRegex::replaceCopy(const string& input, const string& replacement,
 		const string& exp) {
-	m_regex = regex(exp, m_regexflags);
+	const regex& re = compile(exp, m_regexflags);
 	string output;
+	if (replaceLiteral(output, input, replacement,
+			std::regex_constants::match_default)) {
+		return output;
+	}
 	regex_replace(std::back_inserter(output), input.begin(),
-			input.end(), m_regex, replacement);
+			input.end(), re, replacement);
 	return output;
 }
 
@@ -19486,10 +22059,13 @@ string HumRegex::replaceCopy(string* input, const string& replacement,
 
 string HumRegex::replaceCopy(const string& input, const string& exp,
 		const string& replacement, const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
 	string output;
+	if (replaceLiteral(output, input, replacement, getTemporarySearchFlags(options))) {
+		return output;
+	}
 	regex_replace(std::back_inserter(output), input.begin(),
-			input.end(), m_regex, replacement, getTemporarySearchFlags(options));
+			input.end(), re, replacement, getTemporarySearchFlags(options));
 	return output;
 }
 
@@ -19644,6 +22220,398 @@ std::regex_constants::match_flag_type HumRegex::getTemporarySearchFlags(
 }
 
 
+///////////////////////////////////////////////////////////////////////////
+//
+// Compiled expression cache.
+//
+
+//////////////////////////////
+//
+// HumRegexCache -- Compiled expressions shared by all HumRegex objects,
+//     in least-recently-used order (most recent first).  m_index maps
+//     the syntax options and expression to an entry in m_entries.
+//
+
+struct HumRegexCache {
+	std::mutex m_mutex;
+	std::list<std::shared_ptr<const HumRegexPattern>> m_entries;
+	std::unordered_map<std::string,
+			std::list<std::shared_ptr<const HumRegexPattern>>::iterator> m_index;
+	int m_size = 512;
+	std::atomic<bool> m_literal{true};
+};
+
+static HumRegexCache& getHumRegexCache(void) {
+	static HumRegexCache cache;
+	return cache;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::getPattern -- Return the compiled expression for the given
+//     syntax options, compiling it if it is not in the cache.  This can
+//     be called from multiple threads.
+//
+
+std::shared_ptr<const HumRegexPattern> HumRegex::getPattern(const std::string& exp,
+		std::regex_constants::syntax_option_type flags) {
+	HumRegexCache& cache = getHumRegexCache();
+	std::string key = std::to_string((unsigned)flags);
+	key += ':';
+	key += exp;
+	{
+		std::lock_guard<std::mutex> lock(cache.m_mutex);
+		if (cache.m_size <= 0) {
+			// Cache is disabled.
+		} else {
+			auto found = cache.m_index.find(key);
+			if (found != cache.m_index.end()) {
+				cache.m_entries.splice(cache.m_entries.begin(), cache.m_entries,
+						found->second);
+				return *found->second;
+			}
+		}
+	}
+
+	// Compile outside of the lock (an invalid expression throws
+	// std::regex_error here, as before).
+	auto pattern = std::make_shared<const HumRegexPattern>(exp, flags);
+
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+	if (cache.m_size <= 0) {
+		return pattern;
+	}
+	auto found = cache.m_index.find(key);
+	if (found != cache.m_index.end()) {
+		// Compiled by another thread in the meantime.
+		return *found->second;
+	}
+	cache.m_entries.push_front(pattern);
+	cache.m_index[key] = cache.m_entries.begin();
+	while ((int)cache.m_entries.size() > cache.m_size) {
+		const HumRegexPattern& last = *cache.m_entries.back();
+		std::string lastkey = std::to_string((unsigned)last.m_flags);
+		lastkey += ':';
+		lastkey += last.m_exp;
+		cache.m_index.erase(lastkey);
+		cache.m_entries.pop_back();
+	}
+	return pattern;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::compile -- Set the current expression, reusing the previous
+//     one if it is the same.
+//
+
+const std::regex& HumRegex::compile(const std::string& exp,
+		std::regex_constants::syntax_option_type flags) {
+	if (!m_pattern || (m_pattern->m_flags != flags) || (m_pattern->m_exp != exp)
+			|| (getCacheSize() <= 0)) {
+		m_pattern = getPattern(exp, flags);
+	}
+	return m_pattern->m_regex;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::setCacheSize -- Set the maximum number of compiled expressions
+//     to keep in the cache (default 512).  A size of 0 disables the cache,
+//     so that expressions are compiled for every search.
+//
+
+void HumRegex::setCacheSize(int size) {
+	HumRegexCache& cache = getHumRegexCache();
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+	cache.m_size = size;
+	while ((int)cache.m_entries.size() > std::max(size, 0)) {
+		const HumRegexPattern& last = *cache.m_entries.back();
+		std::string lastkey = std::to_string((unsigned)last.m_flags);
+		lastkey += ':';
+		lastkey += last.m_exp;
+		cache.m_index.erase(lastkey);
+		cache.m_entries.pop_back();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::getCacheSize --
+//
+
+int HumRegex::getCacheSize(void) {
+	HumRegexCache& cache = getHumRegexCache();
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+	return cache.m_size;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::clearCache -- Remove all compiled expressions from the cache.
+//
+
+void HumRegex::clearCache(void) {
+	HumRegexCache& cache = getHumRegexCache();
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+	cache.m_entries.clear();
+	cache.m_index.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::setLiteralMatching -- Turn on/off searching, matching and
+//     replacing of literal expressions without std::regex (default on).
+//     The results are the same either way.
+//
+
+void HumRegex::setLiteralMatching(bool state) {
+	getHumRegexCache().m_literal = state;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::getLiteralMatching --
+//
+
+bool HumRegex::getLiteralMatching(void) {
+	return getHumRegexCache().m_literal;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::searchLiteral -- Search for the current expression without
+//     using std::regex.  Returns -1 if std::regex is needed; otherwise
+//     returns 0 if there is no match, or the character position + 1 of
+//     the match (relative to startindex), like search().  A search which
+//     fails here is known to fail since m_literal must occur at the start
+//     of any match.
+//
+
+int HumRegex::searchLiteral(const std::string& input, int startindex) {
+	m_literalSearch = false;
+	const HumRegexPattern& pattern = *m_pattern;
+	if (pattern.m_literal.empty() || !getLiteralMatching()) {
+		return -1;
+	}
+	const std::string& literal = pattern.m_literal;
+	size_t length = literal.size();
+	size_t size = input.size() - startindex;
+	const char* text = input.data() + startindex;
+	size_t found = std::string::npos;
+	if (pattern.m_anchorStart) {
+		if ((size >= length) && (memcmp(text, literal.data(), length) == 0)) {
+			found = 0;
+		}
+	} else {
+		found = input.find(literal, startindex);
+		if (found != std::string::npos) {
+			found -= startindex;
+		}
+	}
+	if (pattern.m_literalOnly && pattern.m_anchorEnd && (found != std::string::npos)
+			&& (found + length != size)) {
+		// The match can only be at the end of the input.
+		found = std::string::npos;
+		if (!pattern.m_anchorStart && (size >= length) &&
+				(memcmp(text + size - length, literal.data(), length) == 0)) {
+			found = size - length;
+		}
+	}
+	if ((found != std::string::npos) && !pattern.m_literalOnly) {
+		return -1;
+	}
+
+	m_literalSearch = true;
+	m_literalInput  = &input;
+	m_literalBase   = startindex;
+	if (found == std::string::npos) {
+		m_literalCount  = 0;
+		m_literalStart  = 0;
+		m_literalLength = 0;
+		return 0;
+	}
+	m_literalCount  = pattern.m_group ? 2 : 1;
+	m_literalStart  = (int)found;
+	m_literalLength = (int)length;
+	return (int)found + 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::replaceLiteral -- Replace the current expression in the input
+//     without using std::regex, storing the result in output.  Returns
+//     false if std::regex is needed (when the expression is not literal,
+//     or the replacement contains $ substitutions).
+//
+
+bool HumRegex::replaceLiteral(std::string& output, const std::string& input,
+		const std::string& replacement,
+		std::regex_constants::match_flag_type flags) {
+	const HumRegexPattern& pattern = *m_pattern;
+	if (!pattern.m_literalOnly || pattern.m_literal.empty() || !getLiteralMatching()) {
+		return false;
+	}
+	if (replacement.find('$') != std::string::npos) {
+		return false;
+	}
+	const std::string& literal = pattern.m_literal;
+	size_t length = literal.size();
+	bool atstart = (input.size() >= length) &&
+			(input.compare(0, length, literal) == 0);
+	bool atend = (input.size() >= length) &&
+			(input.compare(input.size() - length, length, literal) == 0);
+	if (pattern.m_anchorStart && pattern.m_anchorEnd) {
+		output = (atstart && (input.size() == length)) ? replacement : input;
+	} else if (pattern.m_anchorStart) {
+		output = atstart ? replacement + input.substr(length) : input;
+	} else if (pattern.m_anchorEnd) {
+		output = atend ? input.substr(0, input.size() - length) + replacement : input;
+	} else {
+		bool global = !(flags & std::regex_constants::format_first_only);
+		output.clear();
+		output.reserve(input.size());
+		size_t start = 0;
+		size_t found = input.find(literal);
+		while (found != std::string::npos) {
+			output.append(input, start, found - start);
+			output += replacement;
+			start = found + length;
+			if (!global) {
+				break;
+			}
+			found = input.find(literal, start);
+		}
+		output.append(input, start, std::string::npos);
+	}
+	return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// HumRegexPattern -- A compiled expression in the HumRegex cache.
+//
+
+//////////////////////////////
+//
+// HumRegexPattern::HumRegexPattern --
+//
+
+HumRegexPattern::HumRegexPattern(const std::string& exp,
+		std::regex_constants::syntax_option_type flags) :
+		m_exp(exp), m_flags(flags), m_regex(exp, flags) {
+	analyzeLiteral();
+}
+
+
+
+//////////////////////////////
+//
+// HumRegexPattern::analyzeLiteral -- Find the literal text at the start
+//     of the expression, and check if the expression is only that text.
+//     Only plain characters and escaped punctuation are literal (such as
+//     "^\*I" or "\]$").  Expressions containing "|" and anything other
+//     than ECMAScript syntax are not analyzed.
+//
+
+void HumRegexPattern::analyzeLiteral(void) {
+	using namespace std::regex_constants;
+	if (m_flags & (icase | nosubs | basic | extended | awk | grep | egrep)) {
+		return;
+	}
+	const std::string& exp = m_exp;
+	if (exp.find('|') != std::string::npos) {
+		return;
+	}
+	size_t n = exp.size();
+	size_t i = 0;
+	bool anchorStart = false;
+	bool group = false;
+	if ((i < n) && (exp[i] == '^')) {
+		anchorStart = true;
+		i++;
+	}
+	if ((i < n) && (exp[i] == '(') && ((i + 1 >= n) || (exp[i+1] != '?'))) {
+		group = true;
+		i++;
+	}
+	std::string literal;
+	while (i < n) {
+		char ch = exp[i];
+		size_t next = i + 1;
+		if (ch == '\\') {
+			if (i + 1 >= n) {
+				break;
+			}
+			unsigned char escaped = (unsigned char)exp[i+1];
+			if (isalnum(escaped) || (escaped == '_') || (escaped >= 0x80)) {
+				// character class, backreference or special character
+				break;
+			}
+			ch = (char)escaped;
+			next = i + 2;
+		} else if ((ch == '\0') || strchr(".^$|?*+()[]{}", ch)) {
+			break;
+		}
+		if ((next < n) && ((exp[next] == '?') || (exp[next] == '*') ||
+				(exp[next] == '{'))) {
+			// optional character
+			break;
+		}
+		literal += ch;
+		i = next;
+		if ((next < n) && (exp[next] == '+')) {
+			break;
+		}
+	}
+
+	size_t j = i;
+	bool complete = true;
+	if (group) {
+		if ((j < n) && (exp[j] == ')')) {
+			j++;
+		} else {
+			complete = false;
+		}
+	}
+	bool anchorEnd = false;
+	if (complete && (j < n) && (exp[j] == '$')) {
+		anchorEnd = true;
+		j++;
+	}
+	if (complete && (j == n)) {
+		m_literalOnly = true;
+		m_anchorEnd   = anchorEnd;
+		m_group       = group;
+	} else if (group) {
+		// The group may be optional or repeated.
+		return;
+	}
+	m_literal     = literal;
+	m_anchorStart = anchorStart;
+}
+
+
 
 //////////////////////////////
 //
@@ -19966,6 +22934,1568 @@ HumSignifier* HumSignifiers::getSignifier(int index) {
 
 
 
+// Increase HumSnapshotVersion when the snapshot layout or the results
+// of any saved analysis change, so that old snapshots are not used.
+static const char         HumSnapshotMagic[8]  = "HUMSNAP";
+static const std::int32_t HumSnapshotVersion   = 3;
+
+// Flags for token records:
+static const std::int32_t HumSnapshotRhythm    = 1;
+static const std::int32_t HumSnapshotParamSet  = 2;
+
+// Marker in hash records for values which are token pointers:
+static const std::int32_t HumSnapshotTokenValue = -2;
+
+
+//////////////////////////////
+//
+// HumSnapshot::HumSnapshot --
+//
+
+HumSnapshot::HumSnapshot(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::~HumSnapshot --
+//
+
+HumSnapshot::~HumSnapshot() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::clear -- Remove any encoding or decoding state.
+//
+
+void HumSnapshot::clear(void) {
+	m_data.clear();
+	m_strings.clear();
+	m_stringIndex.clear();
+	m_tokenIndex.clear();
+	m_readpos = NULL;
+	m_readend = NULL;
+	m_table.clear();
+	m_tokens.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::cacheDirectory -- Storage for the cache directory, which
+//     is initialized from the HUMLIB_SNAPSHOT_DIR environment variable.
+//
+
+string& HumSnapshot::cacheDirectory(void) {
+	static string directory = []() {
+		const char* value = getenv("HUMLIB_SNAPSHOT_DIR");
+		return string(value ? value : "");
+	}();
+	return directory;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::setCacheDirectory -- Set the directory in which snapshots
+//     are saved when reading files.  An empty string disables the cache.
+//     The directory must already exist.  This should be set before files
+//     are read in other threads.
+//
+
+void HumSnapshot::setCacheDirectory(const string& directory) {
+	cacheDirectory() = directory;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getCacheDirectory --
+//
+
+string HumSnapshot::getCacheDirectory(void) {
+	return cacheDirectory();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::isCacheEnabled -- True if a cache directory is set.
+//
+
+bool HumSnapshot::isCacheEnabled(void) {
+	return !cacheDirectory().empty();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getCacheFilename -- Return the name of the snapshot file
+//     in the cache directory for the given content key and list of
+//     analyses done when reading the file.
+//
+
+string HumSnapshot::getCacheFilename(std::uint64_t key, unsigned analyses) {
+	char name[64];
+	snprintf(name, sizeof(name), "%016llx-%x.hsnap", (unsigned long long)key,
+			analyses);
+	string output = cacheDirectory();
+	if (!output.empty() && (output.back() != '/')) {
+		output += '/';
+	}
+	output += name;
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getContentKey -- Return a 64-bit FNV-1a hash of the
+//     contents of a file.  For a list of lines, a newline is added to
+//     the end of each line.
+//
+
+std::uint64_t HumSnapshot::getContentKey(const char* contents, size_t size) {
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	const unsigned char* ptr = (const unsigned char*)contents;
+	for (size_t i=0; i<size; i++) {
+		hash ^= ptr[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+std::uint64_t HumSnapshot::getContentKey(const vector<pair<const char*,
+		size_t>>& lines) {
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	for (int i=0; i<(int)lines.size(); i++) {
+		const unsigned char* ptr = (const unsigned char*)lines[i].first;
+		for (size_t j=0; j<lines[i].second; j++) {
+			hash ^= ptr[j];
+			hash *= 0x100000001b3ULL;
+		}
+		hash ^= '\n';
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::writeCache -- Save a snapshot of the file in the cache
+//     directory.  Returns false if there is no cache directory or the
+//     snapshot could not be saved.
+//
+
+bool HumSnapshot::writeCache(HumdrumFileBase& infile, std::uint64_t key) {
+	if (!isCacheEnabled()) {
+		return false;
+	}
+	HumSnapshot snapshot;
+	return snapshot.write(infile, getCacheFilename(key, infile.m_readAnalyses), key);
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::readCache -- Load the analyses of a file from the cache
+//     directory.  The lines of the file must have been read, but not
+//     split into tokens.  Returns false if there is no snapshot for the
+//     file, in which case the file still has to be analyzed.
+//
+
+bool HumSnapshot::readCache(HumdrumFileBase& infile, std::uint64_t key) {
+	if (!isCacheEnabled()) {
+		return false;
+	}
+	HumSnapshot snapshot;
+	return snapshot.read(infile, getCacheFilename(key, infile.m_readAnalyses), key);
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::write -- Save a snapshot of an analyzed file.  The
+//     snapshot is written to a temporary file which is then renamed, so
+//     that other processes reading the same cache never see a partial
+//     snapshot.  Returns false if the file cannot be stored in a
+//     snapshot (such as when its tokens no longer match the text of the
+//     lines, or parameters point to tokens in another file).
+//
+
+bool HumSnapshot::write(HumdrumFileBase& infile, const string& filename,
+		std::uint64_t key) {
+	if (!infile.isValid() || !encode(infile, key)) {
+		clear();
+		return false;
+	}
+	static std::atomic<int> counter(0);
+	stringstream tempname;
+	tempname << filename << ".tmp";
+#ifdef HUMLIB_MMAP
+	tempname << getpid() << "-";
+#endif
+	tempname << std::hash<std::thread::id>()(std::this_thread::get_id())
+	         << "-" << counter++;
+	std::ofstream output(tempname.str(), std::ios::binary);
+	if (!output.is_open()) {
+		clear();
+		return false;
+	}
+	output.write(m_data.data(), m_data.size());
+	output.close();
+	clear();
+	if (!output) {
+		remove(tempname.str().c_str());
+		return false;
+	}
+	if (rename(tempname.str().c_str(), filename.c_str()) != 0) {
+		remove(tempname.str().c_str());
+		return false;
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::read -- Load the analyses of a file from a snapshot.  The
+//     lines of the file must have been read, but not split into tokens.
+//     The snapshot is memory-mapped if possible.  If the key is not zero,
+//     it must match the key in the snapshot.  Returns false if the
+//     snapshot cannot be used, in which case the lines of the file are
+//     left unanalyzed.
+//
+
+bool HumSnapshot::read(HumdrumFileBase& infile, const string& filename,
+		std::uint64_t key) {
+	bool status = false;
+#ifdef HUMLIB_MMAP
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode) || (info.st_size == 0)) {
+		::close(fd);
+		return false;
+	}
+	size_t size = (size_t)info.st_size;
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	status = decode(infile, key, (const char*)data, size);
+	munmap(data, size);
+#else
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		return false;
+	}
+	stringstream contents;
+	contents << input.rdbuf();
+	string data = contents.str();
+	status = decode(infile, key, data.data(), data.size());
+#endif
+	clear();
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::writeString -- Store a snapshot of an analyzed file in a
+//     string rather than in a file, such as for keeping analyzed files
+//     in memory.  Returns false if the file cannot be stored in a
+//     snapshot.
+//
+
+bool HumSnapshot::writeString(HumdrumFileBase& infile, string& data) {
+	data.clear();
+	if (!infile.isValid() || !encode(infile, 0)) {
+		clear();
+		return false;
+	}
+	data.swap(m_data);
+	clear();
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::readString -- Load the analyses of a file from a snapshot
+//     stored with writeString().  The lines of the file must have been
+//     read, but not split into tokens.
+//
+
+bool HumSnapshot::readString(HumdrumFileBase& infile, const string& data) {
+	bool status = decode(infile, 0, data.data(), data.size());
+	clear();
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::encode -- Store the analyses of a file in m_data.
+//
+
+bool HumSnapshot::encode(HumdrumFileBase& infile, std::uint64_t key) {
+	clear();
+	int tokencount = 0;
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		HumdrumLine& line = *infile.m_lines[i];
+		if ((line.m_lineindex != i) || !checkTokens(line)) {
+			return false;
+		}
+		for (int j=0; j<(int)line.m_tokens.size(); j++) {
+			m_tokenIndex[line.m_tokens[j]] = tokencount++;
+		}
+	}
+
+	// File records:
+	putInt(infile.m_segmentlevel);
+	putInt(infile.m_ticksperquarternote);
+	putString(infile.m_idprefix);
+	putInt((int)infile.m_trackstarts.size());
+	for (int i=0; i<(int)infile.m_trackstarts.size(); i++) {
+		if (!putToken(infile.m_trackstarts[i])) { return false; }
+	}
+	putInt((int)infile.m_trackends.size());
+	for (int i=0; i<(int)infile.m_trackends.size(); i++) {
+		putInt((int)infile.m_trackends[i].size());
+		for (int j=0; j<(int)infile.m_trackends[i].size(); j++) {
+			if (!putToken(infile.m_trackends[i][j])) { return false; }
+		}
+	}
+	putInt((int)infile.m_barlines.size());
+	for (int i=0; i<(int)infile.m_barlines.size(); i++) {
+		HLp barline = infile.m_barlines[i];
+		if ((barline == NULL) || (barline->m_lineindex < 0) ||
+				(barline->m_lineindex >= (int)infile.m_lines.size()) ||
+				(infile.m_lines[barline->m_lineindex] != barline)) {
+			return false;
+		}
+		putInt(barline->m_lineindex);
+	}
+	for (auto pairs : {&infile.m_strand1d, &infile.m_strophes1d}) {
+		putInt((int)pairs->size());
+		for (int i=0; i<(int)pairs->size(); i++) {
+			if (!putToken(pairs->at(i).first)) { return false; }
+			if (!putToken(pairs->at(i).last))  { return false; }
+		}
+	}
+	for (auto pairs : {&infile.m_strand2d, &infile.m_strophes2d}) {
+		putInt((int)pairs->size());
+		for (int i=0; i<(int)pairs->size(); i++) {
+			putInt((int)pairs->at(i).size());
+			for (int j=0; j<(int)pairs->at(i).size(); j++) {
+				if (!putToken(pairs->at(i)[j].first)) { return false; }
+				if (!putToken(pairs->at(i)[j].last))  { return false; }
+			}
+		}
+	}
+	vector<int> signifiers;
+	if (infile.m_analyses.isAnalyzed(HumFileAnalysis::Structure)) {
+		for (int i=0; i<(int)infile.m_lines.size(); i++) {
+			if (infile.m_lines[i]->isSignifier()) {
+				signifiers.push_back(i);
+			}
+		}
+	}
+	putInt((int)signifiers.size());
+	for (int i=0; i<(int)signifiers.size(); i++) {
+		putInt(signifiers[i]);
+	}
+	if (!putHash(infile)) {
+		return false;
+	}
+
+	// Line and token records:
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		HumdrumLine& line = *infile.m_lines[i];
+		putInt((int)line.m_tokens.size());
+		putNum(line.m_duration);
+		putNum(line.m_durationFromStart);
+		putNum(line.m_durationFromBarline);
+		putNum(line.m_durationToBarline);
+		putInt(line.m_rhythm_analyzed);
+		putInt((int)line.m_linkedParameters.size());
+		for (int j=0; j<(int)line.m_linkedParameters.size(); j++) {
+			if (!putToken(line.m_linkedParameters[j])) { return false; }
+		}
+		if (!putHash(line)) {
+			return false;
+		}
+		for (int j=0; j<(int)line.m_tokens.size(); j++) {
+			HumdrumToken& token = *line.m_tokens[j];
+			HumAddress& address = token.m_address;
+			putString(address.m_spining);
+			putInt(address.m_fieldindex);
+			putInt(address.m_track);
+			putInt(address.m_subtrack);
+			putInt(address.m_subtrackcount);
+			if (address.m_datatype < 0) {
+				putInt(-1);
+			} else {
+				putString(HumDataType::getName(address.m_datatype));
+			}
+			putNum(token.m_duration);
+			for (auto links : {&token.m_nextTokens, &token.m_previousTokens,
+					&token.m_nextNonNullTokens, &token.m_previousNonNullTokens}) {
+				putInt((int)links->size());
+				for (int k=0; k<(int)links->size(); k++) {
+					if (!putToken(links->at(k))) { return false; }
+				}
+			}
+			putInt(token.m_rhycheck);
+			putInt(token.m_strand);
+			if (!putToken(token.m_nullresolve)) { return false; }
+			if (!putToken(token.m_strophe))     { return false; }
+			putInt((int)token.m_linkedParameterTokens.size());
+			for (int k=0; k<(int)token.m_linkedParameterTokens.size(); k++) {
+				if (!putToken(token.m_linkedParameterTokens[k])) { return false; }
+			}
+			std::int32_t flags = 0;
+			if (token.m_rhythm_analyzed) {
+				flags |= HumSnapshotRhythm;
+			}
+			if (token.m_parameterSet) {
+				flags |= HumSnapshotParamSet;
+			}
+			putInt(flags);
+			if (!putHash(token)) {
+				return false;
+			}
+		}
+	}
+
+	// Place the header and string table before the records:
+	string records;
+	records.swap(m_data);
+	m_data.reserve(records.size() + 1024);
+	m_data.append(HumSnapshotMagic, sizeof(HumSnapshotMagic));
+	putInt(HumSnapshotVersion);
+	putInt((std::int32_t)(key & 0xffffffffULL));
+	putInt((std::int32_t)(key >> 32));
+	putInt((std::int32_t)infile.m_analyses.m_analyzed);
+	putInt(infile.m_analyses.m_barlines_different);
+	putInt((int)infile.m_lines.size());
+	putInt(tokencount);
+	putInt((int)m_strings.size());
+	for (int i=0; i<(int)m_strings.size(); i++) {
+		putInt((int)m_strings[i].size());
+		m_data += m_strings[i];
+	}
+	m_data += records;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::checkTokens -- Return true if the tokens of a line are
+//     the same as the tokens that are created from the text of the line,
+//     since only the line text is used to create tokens when loading a
+//     snapshot.
+//
+
+bool HumSnapshot::checkTokens(HumdrumLine& line) {
+	if (line.m_tokens.empty() || (line.m_tokens.size() != line.m_tabs.size())) {
+		return false;
+	}
+	if (line.empty() || (line.compare(0, 2, "!!") == 0)) {
+		return (line.m_tokens.size() == 1) &&
+				(line.m_tabs[0] == 0) &&
+				(line.m_tokens[0]->compare(line) == 0);
+	}
+	size_t position = 0;
+	for (int i=0; i<(int)line.m_tokens.size(); i++) {
+		HumdrumToken* token = line.m_tokens[i];
+		if ((token == NULL) || (token->find('\t') != string::npos) ||
+				(line.compare(position, token->size(), *token) != 0)) {
+			return false;
+		}
+		position += token->size();
+		int tabs = line.m_tabs[i];
+		bool last = (i == (int)line.m_tokens.size() - 1);
+		if ((tabs < 0) || (!last && (tabs == 0))) {
+			return false;
+		}
+		for (int j=0; j<tabs; j++) {
+			if ((position >= line.size()) || (line[position] != '\t')) {
+				return false;
+			}
+			position++;
+		}
+		if ((position < line.size()) && (line[position] == '\t')) {
+			return false;
+		}
+	}
+	return position == line.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::decode -- Load the analyses of a file from snapshot data.
+//
+
+bool HumSnapshot::decode(HumdrumFileBase& infile, std::uint64_t key,
+		const char* data, size_t size) {
+	clear();
+	if ((size < sizeof(HumSnapshotMagic)) ||
+			(memcmp(data, HumSnapshotMagic, sizeof(HumSnapshotMagic)) != 0)) {
+		return false;
+	}
+	m_readpos = data + sizeof(HumSnapshotMagic);
+	m_readend = data + size;
+	std::int32_t version;
+	std::int32_t keylow;
+	std::int32_t keyhigh;
+	std::int32_t analyzed;
+	std::int32_t different;
+	std::int32_t linecount;
+	std::int32_t tokencount;
+	std::int32_t stringcount;
+	if (!getInt(version)    || (version != HumSnapshotVersion))    { return false; }
+	if (!getInt(keylow)     || !getInt(keyhigh))                   { return false; }
+	std::uint64_t filekey = ((std::uint64_t)(std::uint32_t)keyhigh << 32) |
+			(std::uint32_t)keylow;
+	if ((key != 0) && (filekey != key)) {
+		return false;
+	}
+	if (!getInt(analyzed)   || !getInt(different))                 { return false; }
+	if (!getInt(linecount)  || (linecount != (int)infile.m_lines.size())) { return false; }
+	if (!getInt(tokencount) || (tokencount < 0))                   { return false; }
+	if (!getInt(stringcount) || (stringcount < 0))                 { return false; }
+	m_table.reserve(stringcount);
+	for (int i=0; i<stringcount; i++) {
+		std::int32_t length;
+		if (!getInt(length) || (length < 0) || (length > m_readend - m_readpos)) {
+			return false;
+		}
+		m_table.emplace_back(m_readpos, length);
+		m_readpos += length;
+	}
+
+	// Split the lines into tokens, then fill in the analyses.  Tokens can
+	// refer to later tokens, so they all have to exist first.
+	m_tokens.reserve(tokencount);
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		HumdrumLine& line = *infile.m_lines[i];
+		line.createTokensFromLine();
+		line.m_lineindex = i;
+		m_tokens.insert(m_tokens.end(), line.m_tokens.begin(), line.m_tokens.end());
+	}
+	if (((int)m_tokens.size() != tokencount) || !applyRecords(infile)) {
+		resetLines(infile);
+		return false;
+	}
+	infile.m_analyses.m_analyzed = (unsigned)analyzed;
+	infile.m_analyses.m_barlines_different = different;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::applyRecords -- Read the file, line and token records
+//     of a snapshot.  Token pointers are restored from the token
+//     indexes stored in the records.
+//
+
+bool HumSnapshot::applyRecords(HumdrumFileBase& infile) {
+	std::int32_t count;
+	std::int32_t subcount;
+	HTp token;
+	HTp other;
+
+	if (!getInt(infile.m_segmentlevel))        { return false; }
+	if (!getInt(infile.m_ticksperquarternote)) { return false; }
+	if (!getString(infile.m_idprefix))         { return false; }
+	if (!getInt(count) || (count < 0))         { return false; }
+	infile.m_trackstarts.resize(count);
+	for (int i=0; i<count; i++) {
+		if (!getToken(infile.m_trackstarts[i])) { return false; }
+	}
+	if (!getInt(count) || (count < 0))         { return false; }
+	infile.m_trackends.resize(count);
+	for (int i=0; i<count; i++) {
+		if (!getInt(subcount) || (subcount < 0)) { return false; }
+		infile.m_trackends[i].resize(subcount);
+		for (int j=0; j<subcount; j++) {
+			if (!getToken(infile.m_trackends[i][j])) { return false; }
+		}
+	}
+	if (!getInt(count) || (count < 0))         { return false; }
+	infile.m_barlines.resize(count);
+	for (int i=0; i<count; i++) {
+		std::int32_t index;
+		if (!getInt(index) || (index < 0) || (index >= (int)infile.m_lines.size())) {
+			return false;
+		}
+		infile.m_barlines[i] = infile.m_lines[index];
+	}
+	for (auto pairs : {&infile.m_strand1d, &infile.m_strophes1d}) {
+		if (!getInt(count) || (count < 0))      { return false; }
+		pairs->resize(count);
+		for (int i=0; i<count; i++) {
+			if (!getToken(pairs->at(i).first))   { return false; }
+			if (!getToken(pairs->at(i).last))    { return false; }
+		}
+	}
+	for (auto pairs : {&infile.m_strand2d, &infile.m_strophes2d}) {
+		if (!getInt(count) || (count < 0))      { return false; }
+		pairs->resize(count);
+		for (int i=0; i<count; i++) {
+			if (!getInt(subcount) || (subcount < 0)) { return false; }
+			pairs->at(i).resize(subcount);
+			for (int j=0; j<subcount; j++) {
+				if (!getToken(pairs->at(i)[j].first)) { return false; }
+				if (!getToken(pairs->at(i)[j].last))  { return false; }
+			}
+		}
+	}
+	vector<int> signifiers;
+	if (!getInt(count) || (count < 0))         { return false; }
+	for (int i=0; i<count; i++) {
+		std::int32_t index;
+		if (!getInt(index) || (index < 0) || (index >= (int)infile.m_lines.size())) {
+			return false;
+		}
+		signifiers.push_back(index);
+	}
+	// Parameters of the file are added after all records are read, since
+	// the file can have parameters from before the snapshot was loaded:
+	HumHash fileparameters;
+	if (!getHash(fileparameters)) {
+		return false;
+	}
+
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		HumdrumLine& line = *infile.m_lines[i];
+		std::int32_t value;
+		if (!getInt(count) || (count != (int)line.m_tokens.size())) { return false; }
+		if (!getNum(line.m_duration))            { return false; }
+		if (!getNum(line.m_durationFromStart))   { return false; }
+		if (!getNum(line.m_durationFromBarline)) { return false; }
+		if (!getNum(line.m_durationToBarline))   { return false; }
+		if (!getInt(value))                      { return false; }
+		line.m_rhythm_analyzed = value;
+		if (!getInt(count) || (count < 0))       { return false; }
+		line.m_linkedParameters.resize(count);
+		for (int j=0; j<count; j++) {
+			if (!getToken(line.m_linkedParameters[j])) { return false; }
+		}
+		if (!getHash(line)) {
+			return false;
+		}
+		for (int j=0; j<(int)line.m_tokens.size(); j++) {
+			token = line.m_tokens[j];
+			HumAddress& address = token->m_address;
+			if (!getString(address.m_spining))    { return false; }
+			if (!getInt(address.m_fieldindex))    { return false; }
+			if (!getInt(address.m_track))         { return false; }
+			if (!getInt(address.m_subtrack))      { return false; }
+			if (!getInt(address.m_subtrackcount)) { return false; }
+			if (!getInt(value) || (value < -1) || (value >= (int)m_table.size())) {
+				return false;
+			}
+			if (value < 0) {
+				address.m_datatype = HumDataType::Unknown;
+			} else {
+				address.m_datatype = HumDataType::getId(string(m_table[value].first,
+						m_table[value].second));
+			}
+			if (!getNum(token->m_duration))       { return false; }
+			for (auto links : {&token->m_nextTokens, &token->m_previousTokens,
+					&token->m_nextNonNullTokens, &token->m_previousNonNullTokens}) {
+				if (!getInt(count) || (count < 0)) { return false; }
+				links->clear();
+				links->reserve(count);
+				for (int k=0; k<count; k++) {
+					if (!getToken(other))           { return false; }
+					links->push_back(other);
+				}
+			}
+			if (!getInt(token->m_rhycheck))       { return false; }
+			if (!getInt(token->m_strand))         { return false; }
+			if (!getToken(token->m_nullresolve))  { return false; }
+			if (!getToken(token->m_strophe))      { return false; }
+			if (!getInt(count) || (count < 0))    { return false; }
+			token->m_linkedParameterTokens.resize(count);
+			for (int k=0; k<count; k++) {
+				if (!getToken(token->m_linkedParameterTokens[k])) { return false; }
+			}
+			if (!getInt(value))                   { return false; }
+			token->m_rhythm_analyzed = value & HumSnapshotRhythm;
+			if (value & HumSnapshotParamSet) {
+				token->storeParameterSet();
+			}
+			if (!getHash(*token)) {
+				return false;
+			}
+		}
+	}
+	if (m_readpos != m_readend) {
+		return false;
+	}
+
+	for (int i=0; i<(int)signifiers.size(); i++) {
+		infile.m_signifiers.addSignifier(infile.m_lines[signifiers[i]]->getText());
+	}
+	infile.prefix = fileparameters.prefix;
+	if (fileparameters.parameters) {
+		for (auto& entry : *fileparameters.parameters) {
+			infile.insertParameter(HumParameterName::getName(entry.ns1),
+					HumParameterName::getName(entry.ns2),
+					HumParameterName::getName(entry.key)) = entry.value;
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::resetLines -- Remove any partially loaded analyses after
+//     an invalid snapshot, leaving the lines of the file as they were
+//     before reading the snapshot.
+//
+
+void HumSnapshot::resetLines(HumdrumFileBase& infile) {
+	vector<string> text(infile.m_lines.size());
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		text[i].swap(*infile.m_lines[i]);
+	}
+	string filename = infile.m_filename;
+	infile.clear();
+	infile.m_filename = filename;
+	infile.m_lines.reserve(text.size());
+	for (int i=0; i<(int)text.size(); i++) {
+		HLp line = new HumdrumLine;
+		line->swap(text[i]);
+		line->setOwner(&infile);
+		infile.m_lines.push_back(line);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putInt -- Append an integer to the snapshot data.  The
+//     sign is moved to the lowest bit, then the number is stored seven
+//     bits at a time, with the high bit of each byte set if more bytes
+//     follow.  Most numbers in a snapshot are stored in one or two bytes.
+//
+
+void HumSnapshot::putInt(std::int32_t value) {
+	std::uint32_t number = ((std::uint32_t)value << 1) ^ (std::uint32_t)(value >> 31);
+	while (number >= 0x80) {
+		m_data += (char)((number & 0x7f) | 0x80);
+		number >>= 7;
+	}
+	m_data += (char)number;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putString -- Append the index of a string in the string
+//     table to the snapshot data, adding the string to the table if
+//     needed.
+//
+
+void HumSnapshot::putString(const string& value) {
+	auto found = m_stringIndex.find(value);
+	if (found != m_stringIndex.end()) {
+		putInt(found->second);
+		return;
+	}
+	std::int32_t index = (std::int32_t)m_strings.size();
+	m_strings.push_back(value);
+	m_stringIndex[value] = index;
+	putInt(index);
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putToken -- Append the index of a token to the snapshot
+//     data (-1 for NULL).  Returns false if the token is not in the file.
+//
+
+bool HumSnapshot::putToken(HumdrumToken* token) {
+	if (token == NULL) {
+		putInt(-1);
+		return true;
+	}
+	auto found = m_tokenIndex.find(token);
+	if (found == m_tokenIndex.end()) {
+		return false;
+	}
+	putInt(found->second);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putNum -- Append a rational number to the snapshot data.
+//
+
+void HumSnapshot::putNum(const HumNum& value) {
+	putInt(value.getNumerator());
+	putInt(value.getDenominator());
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putHash -- Append the parameters of a HumHash to the
+//     snapshot data.  Values which are token pointers (such as slur
+//     and tie endpoints) are stored as token indexes.
+//
+
+bool HumSnapshot::putHash(HumHash& hash) {
+	putString(hash.prefix);
+	if (hash.parameters == NULL) {
+		putInt(-1);
+		return putAnalysisValues(hash);
+	}
+	putInt((int)hash.parameters->size());
+	for (auto& entry : *hash.parameters) {
+		putString(HumParameterName::getName(entry.ns1));
+		putString(HumParameterName::getName(entry.ns2));
+		putString(HumParameterName::getName(entry.key));
+		const HumParameter& value = entry.value;
+		if ((value.compare(0, 3, "HT_") == 0) && (value != "HT_0")) {
+			HumdrumToken* pointer = NULL;
+			try {
+				pointer = (HumdrumToken*)(stoll(value.substr(3)));
+			} catch (std::exception& e) {
+				return false;
+			}
+			putInt(HumSnapshotTokenValue);
+			if (!putToken(pointer)) {
+				return false;
+			}
+		} else {
+			putString(value);
+		}
+		if (!putToken(value.origin)) {
+			return false;
+		}
+	}
+	return putAnalysisValues(hash);
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putAnalysisValues -- Append the typed "auto" parameters of
+//     a HumHash to the snapshot data.
+//
+
+bool HumSnapshot::putAnalysisValues(HumHash& hash) {
+	if (hash.m_analysisRow < 0) {
+		putInt(0);
+		return true;
+	}
+	const HumAnalysisStore& store = *hash.findAnalysisStore(false);
+	int row = hash.m_analysisRow;
+	putInt(store.getValueCount(row));
+	for (int i=0; i<store.getKeyCount(); i++) {
+		const HumAnalysisValue* value = store.getValue(row, i);
+		if (value == NULL) {
+			continue;
+		}
+		putString(store.getNamespace1(i));
+		putString(store.getNamespace2(i));
+		putString(store.getKey(i));
+		putInt(value->type);
+		switch (value->type) {
+			case HumAnalysisValue::Integer:
+			case HumAnalysisValue::Boolean:
+				putInt(value->value.ints[0]);
+				break;
+			case HumAnalysisValue::Fraction:
+				putInt(value->value.ints[0]);
+				putInt(value->value.ints[1]);
+				break;
+			case HumAnalysisValue::Token:
+				if (!putToken(value->value.token)) {
+					return false;
+				}
+				break;
+			case HumAnalysisValue::Float:
+				{
+					char buffer[32];
+					snprintf(buffer, sizeof(buffer), "%.17g", value->value.number);
+					putString(buffer);
+				}
+				break;
+			default:
+				putString(store.getString(*value));
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getInt -- Read an integer from the snapshot data.
+//
+
+bool HumSnapshot::getInt(std::int32_t& value) {
+	std::uint32_t number = 0;
+	for (int shift=0; shift<35; shift+=7) {
+		if (m_readpos >= m_readend) {
+			return false;
+		}
+		std::uint32_t byte = (unsigned char)*m_readpos++;
+		number |= (byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			value = (std::int32_t)((number >> 1) ^ (0u - (number & 1)));
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getString -- Read a string index from the snapshot data
+//     and return the string.
+//
+
+bool HumSnapshot::getString(string& value) {
+	std::int32_t index;
+	if (!getInt(index) || (index < 0) || (index >= (int)m_table.size())) {
+		return false;
+	}
+	value.assign(m_table[index].first, m_table[index].second);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getToken -- Read a token index from the snapshot data
+//     and return the token.
+//
+
+bool HumSnapshot::getToken(HumdrumToken*& token) {
+	std::int32_t index;
+	if (!getInt(index) || (index < -1) || (index >= (int)m_tokens.size())) {
+		return false;
+	}
+	token = (index < 0) ? NULL : m_tokens[index];
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getNum -- Read a rational number from the snapshot data.
+//
+
+bool HumSnapshot::getNum(HumNum& value) {
+	std::int32_t top;
+	std::int32_t bot;
+	if (!getInt(top) || !getInt(bot) || (bot == 0)) {
+		return false;
+	}
+	value.setValue(top, bot);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getHash -- Read the parameters of a HumHash from the
+//     snapshot data.
+//
+
+bool HumSnapshot::getHash(HumHash& hash) {
+	if (!getString(hash.prefix)) {
+		return false;
+	}
+	std::int32_t count;
+	std::int32_t index;
+	string ns1;
+	string ns2;
+	string key;
+	if (!getInt(count) || (count < -1)) {
+		return false;
+	}
+	if (count < 0) {
+		return getAnalysisValues(hash);
+	}
+	hash.initializeParameters();
+	hash.parameters->reserve(count);
+	for (int i=0; i<count; i++) {
+		if (!getString(ns1) || !getString(ns2) || !getString(key)) {
+			return false;
+		}
+		HumParameter& value = hash.insertParameter(ns1, ns2, key);
+		if (!getInt(index) || (index < HumSnapshotTokenValue) ||
+				(index >= (int)m_table.size())) {
+			return false;
+		}
+		if (index == HumSnapshotTokenValue) {
+			HumdrumToken* pointer;
+			if (!getToken(pointer) || (pointer == NULL)) {
+				return false;
+			}
+			value.assign("HT_" + to_string((long long)pointer));
+		} else if (index >= 0) {
+			value.assign(m_table[index].first, m_table[index].second);
+		} else {
+			return false;
+		}
+		if (!getToken(value.origin)) {
+			return false;
+		}
+	}
+	return getAnalysisValues(hash);
+}
+
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getAnalysisValues -- Read the typed "auto" parameters of
+//     a HumHash from the snapshot data.
+//
+
+bool HumSnapshot::getAnalysisValues(HumHash& hash) {
+	std::int32_t count;
+	std::int32_t type;
+	std::int32_t number;
+	std::int32_t denominator;
+	string ns1;
+	string ns2;
+	string key;
+	string text;
+	HumdrumToken* pointer;
+	HumNum fraction;
+	if (!getInt(count) || (count < 0)) {
+		return false;
+	}
+	for (int i=0; i<count; i++) {
+		if (!getString(ns1) || !getString(ns2) || !getString(key) || !getInt(type)) {
+			return false;
+		}
+		if (!HumAnalysisStore::isAnalysisNamespace(ns1, ns2)) {
+			return false;
+		}
+		switch (type) {
+			case HumAnalysisValue::Integer:
+				if (!getInt(number)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, (int)number);
+				break;
+			case HumAnalysisValue::Boolean:
+				if (!getInt(number)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, number ? "true" : "false");
+				break;
+			case HumAnalysisValue::Fraction:
+				if (!getInt(number) || !getInt(denominator) || (denominator == 0)) {
+					return false;
+				}
+				fraction.setValue(number, denominator);
+				hash.setValue(ns1, ns2, key, fraction);
+				break;
+			case HumAnalysisValue::Token:
+				if (!getToken(pointer)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, pointer);
+				break;
+			case HumAnalysisValue::Float:
+				if (!getString(text)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, strtod(text.c_str(), NULL));
+				break;
+			case HumAnalysisValue::String:
+				if (!getString(text)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, text);
+				break;
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::HumSubtokens -- An empty separator gives the whole
+//     text as a single sub-token.
+// default value: separator = " "
+//
+
+HumSubtokens::HumSubtokens(std::string_view text, std::string_view separator) {
+	m_text = text;
+	m_separator = separator;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::begin -- Return an iterator at the first sub-token.
+//
+
+HumSubtokens::iterator HumSubtokens::begin(void) const {
+	return iterator(m_text, m_separator);
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::end -- Return an iterator after the last sub-token.
+//
+
+HumSubtokens::iterator HumSubtokens::end(void) const {
+	return iterator();
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::getCount -- Return the number of sub-tokens.  Separators
+//     at the start or end of the text give empty sub-tokens which are
+//     included in the count.
+//
+
+int HumSubtokens::getCount(void) const {
+	if (m_separator.empty()) {
+		return 1;
+	}
+	int count = 1;
+	std::string_view::size_type start = 0;
+	while ((start = m_text.find(m_separator, start)) != std::string_view::npos) {
+		count++;
+		start += m_separator.size();
+	}
+	return count;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::getSubtoken -- Return the sub-token at the given index,
+//     or an empty view if there is no such sub-token.
+//
+
+std::string_view HumSubtokens::getSubtoken(int index) const {
+	if (index < 0) {
+		return std::string_view();
+	}
+	for (std::string_view subtoken : *this) {
+		if (index-- == 0) {
+			return subtoken;
+		}
+	}
+	return std::string_view();
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::front -- Return the first sub-token.
+//
+
+std::string_view HumSubtokens::front(void) const {
+	return *begin();
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::iterator::iterator -- The default constructor makes an
+//     end iterator.
+//
+
+HumSubtokens::iterator::iterator(void) {
+	m_start = std::string_view::npos;
+}
+
+
+HumSubtokens::iterator::iterator(std::string_view text,
+		std::string_view separator) {
+	m_text = text;
+	m_separator = separator;
+	m_start = 0;
+	findEnd();
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::iterator::findEnd -- Set the current sub-token to the
+//     text from m_start to the next separator.
+//
+
+void HumSubtokens::iterator::findEnd(void) {
+	std::string_view::size_type stop = std::string_view::npos;
+	if (!m_separator.empty()) {
+		stop = m_text.find(m_separator, m_start);
+	}
+	if (stop == std::string_view::npos) {
+		m_current = m_text.substr(m_start);
+	} else {
+		m_current = m_text.substr(m_start, stop - m_start);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::iterator::operator++ -- Move to the next sub-token.
+//
+
+HumSubtokens::iterator& HumSubtokens::iterator::operator++(void) {
+	std::string_view::size_type next = m_start + m_current.size();
+	if (next >= m_text.size()) {
+		m_start = std::string_view::npos;
+		m_current = std::string_view();
+		return *this;
+	}
+	// m_current is followed by a separator:
+	m_start = next + m_separator.size();
+	findEnd();
+	return *this;
+}
+
+
+HumSubtokens::iterator HumSubtokens::iterator::operator++(int) {
+	iterator output = *this;
+	++(*this);
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::iterator::operator== -- Iterators are equal if they
+//     are both at the end, or at the same place in the same text.
+//
+
+bool HumSubtokens::iterator::operator==(const iterator& other) const {
+	if (m_start == std::string_view::npos) {
+		return other.m_start == std::string_view::npos;
+	}
+	if (other.m_start == std::string_view::npos) {
+		return false;
+	}
+	return (m_text.data() == other.m_text.data()) && (m_start == other.m_start);
+}
+
+
+
+// The pool and queue index of the worker running in the current thread,
+// so that tasks submitted from inside a task go to the worker's own queue.
+static thread_local HumThreadPool* HumThreadPoolOwner = NULL;
+static thread_local int            HumThreadPoolIndex = -1;
+
+
+//////////////////////////////
+//
+// HumThreadPool::HumThreadPool -- Start the given number of worker
+//     threads.  If the count is zero or less, one thread is started for
+//     each hardware thread.
+//
+
+HumThreadPool::HumThreadPool(int threads) : m_queued(0), m_pending(0),
+		m_next(0), m_stop(false) {
+	if (threads <= 0) {
+		threads = getHardwareThreadCount();
+	}
+	m_queues.reserve(threads);
+	for (int i=0; i<threads; i++) {
+		m_queues.emplace_back(new HumThreadPoolQueue);
+	}
+	m_threads.reserve(threads);
+	for (int i=0; i<threads; i++) {
+		try {
+			m_threads.emplace_back(&HumThreadPool::runWorker, this, i);
+		} catch (const std::system_error&) {
+			// Threads are not available: tasks in queues without a
+			// worker are stolen by the others, or run in submit() if
+			// no workers were started.
+			break;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::~HumThreadPool -- Finish all submitted tasks and then
+//     stop the worker threads.
+//
+
+HumThreadPool::~HumThreadPool() {
+	try {
+		wait();
+	} catch (...) {
+		// Exceptions from tasks are discarded if not collected with wait().
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wakeup.notify_all();
+	for (int i=0; i<(int)m_threads.size(); i++) {
+		m_threads[i].join();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getHardwareThreadCount -- Return the number of threads
+//     that the system can run concurrently (at least one).
+//
+
+int HumThreadPool::getHardwareThreadCount(void) {
+	int count = (int)std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getThreadCount -- Return the number of worker threads.
+//     This will be zero if threads could not be created.
+//
+
+int HumThreadPool::getThreadCount(void) const {
+	return (int)m_threads.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getWorkerIndex -- Return the index of the worker thread
+//     of the pool which is calling the function (from 0 to one less than
+//     getThreadCount()), or -1 if it is not called from a worker thread
+//     of the pool (such as for tasks run in submit() when no threads
+//     could be created).
+//
+
+int HumThreadPool::getWorkerIndex(void) const {
+	if (HumThreadPoolOwner == this) {
+		return HumThreadPoolIndex;
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::submit -- Add a task to the pool.  Tasks submitted from
+//     a worker thread go to the end of that worker's queue; otherwise the
+//     queues are filled in rotation.
+//
+
+void HumThreadPool::submit(std::function<void(void)> task) {
+	if (m_threads.empty()) {
+		m_pending++;
+		runTask(task);
+		return;
+	}
+
+	int index;
+	if (HumThreadPoolOwner == this) {
+		index = HumThreadPoolIndex;
+	} else {
+		index = (int)(m_next++ % (unsigned)m_queues.size());
+	}
+
+	m_pending++;
+	{
+		std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+		m_queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queued++;
+	}
+	m_wakeup.notify_one();
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::wait -- Wait until all submitted tasks have finished.
+//     If any task threw an exception, the first one is thrown again here.
+//     Do not call from inside of a task.
+//
+
+void HumThreadPool::wait(void) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock, [this]() { return m_pending == 0; });
+	if (m_exception) {
+		std::exception_ptr error = m_exception;
+		m_exception = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::takeTask -- Take the newest task from the worker's own
+//     queue, or else the oldest task from another worker's queue.
+//
+
+bool HumThreadPool::takeTask(int index, std::function<void(void)>& task) {
+	{
+		HumThreadPoolQueue& queue = *m_queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			m_queued--;
+			return true;
+		}
+	}
+	int count = (int)m_queues.size();
+	for (int i=1; i<count; i++) {
+		HumThreadPoolQueue& queue = *m_queues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			m_queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::runTask -- Run a task, storing any exception that it
+//     throws for wait(), and signal if it was the last pending task.
+//
+
+void HumThreadPool::runTask(std::function<void(void)>& task) {
+	try {
+		task();
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_exception) {
+			m_exception = std::current_exception();
+		}
+	}
+	task = nullptr;
+	if (--m_pending == 0) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_idle.notify_all();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::runWorker -- Main loop of a worker thread.
+//
+
+void HumThreadPool::runWorker(int index) {
+	HumThreadPoolOwner = this;
+	HumThreadPoolIndex = index;
+	std::function<void(void)> task;
+	while (true) {
+		if (takeTask(index, task)) {
+			runTask(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_wakeup.wait(lock, [this]() { return m_stop || (m_queued > 0); });
+		if (m_stop && (m_queued <= 0)) {
+			break;
+		}
+	}
+	HumThreadPoolOwner = NULL;
+	HumThreadPoolIndex = -1;
+}
+
+
+
 
 //////////////////////////////
 //
@@ -19989,6 +24519,29 @@ HumTool::~HumTool() {
 
 
 
+//////////////////////////////
+//
+// HumTool::operator= -- Copy the option definitions and settings of
+//     another tool, and clear the output.  This is used to reset a tool
+//     to its initial state from an unused copy of the tool (see
+//     HumToolRegistry).
+//
+
+HumTool& HumTool::operator=(const HumTool& tool) {
+	if (this == &tool) {
+		return *this;
+	}
+	Options::operator=(tool);
+	clearOutput();
+	m_suppress = tool.m_suppress;
+	m_analyses = tool.m_analyses;
+	m_analysesQ = tool.m_analysesQ;
+	m_inplace = tool.m_inplace;
+	return *this;
+}
+
+
+
 //////////////////////////////
 //
 // HumTool::hasAnyText -- Returns true if the output contains
@@ -20222,6 +24775,52 @@ void HumTool::clearOutput(void) {
 	m_free_text.str("");
   	m_warning_text.str("");
   	m_error_text.str("");
+	m_edited = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumTool::setInPlaceOutput -- Do not print files edited in place by
+//     the tool (see printEditedFile()), since the caller will use the
+//     edited input file as the output of the tool.
+//
+
+void HumTool::setInPlaceOutput(bool state) {
+	m_inplace = state;
+}
+
+
+
+//////////////////////////////
+//
+// HumTool::hasInPlaceOutput -- Returns true if the output of the tool
+//     is the edited input file, which was not printed to the Humdrum text
+//     because of setInPlaceOutput().
+//
+
+bool HumTool::hasInPlaceOutput(void) {
+	return m_edited;
+}
+
+
+
+//////////////////////////////
+//
+// HumTool::printEditedFile -- Store a file which the tool edited in
+//     place as its Humdrum output.  The text of the lines is updated from
+//     the tokens, and the file is printed unless setInPlaceOutput() was
+//     used.
+//
+
+void HumTool::printEditedFile(HumdrumFile& infile) {
+	infile.createLinesFromTokens();
+	if (m_inplace) {
+		m_edited = true;
+	} else {
+		m_humdrum_text << infile;
+	}
 }
 
 
@@ -20240,6 +24839,1022 @@ void HumTool::setError(const string& message) {
 
 
 
+//////////////////////////////
+//
+// HumToolRegistry::newTool -- Allocate a tool.
+//
+
+template <class TOOL>
+HumTool* HumToolRegistry::newTool(void) {
+	return new TOOL;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::resetTool -- Reset a tool by deleting its contents and
+//     constructing a new instance of the tool in the same memory, so that
+//     anything owned by the tool (including memory owned through raw
+//     pointers) is released in the same way as when the tool is deleted.
+//
+
+template <class TOOL>
+void HumToolRegistry::resetTool(HumTool* tool) {
+	TOOL* instance = static_cast<TOOL*>(tool);
+	instance->~TOOL();
+	new (instance) TOOL;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::runTool -- Run a tool on a file.
+//
+
+template <class TOOL>
+bool HumToolRegistry::runTool(HumTool* tool, HumdrumFile& infile) {
+	return static_cast<TOOL*>(tool)->run(infile);
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::runToolOnPair -- Run a tool which compares two files,
+//     giving it the same file twice.
+//
+
+template <class TOOL>
+bool HumToolRegistry::runToolOnPair(HumTool* tool, HumdrumFile& infile) {
+	return static_cast<TOOL*>(tool)->run(infile, infile);
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getEntries -- The list of tools, sorted by tool name
+//     with the primary name of each tool before its aliases.  Add new
+//     tools here to make them available to the filter tool.  Tools which
+//     only edit tokens and print the edited file as their Humdrum output
+//     are listed with HUMTOOL_INPLACE (see Entry::inplace).
+//
+
+#define HUMTOOL(NAME, CLASS) \
+	{ NAME, #CLASS, &newTool<Tool_##CLASS>, &resetTool<Tool_##CLASS>, &runTool<Tool_##CLASS>, false }
+#define HUMTOOL_INPLACE(NAME, CLASS) \
+	{ NAME, #CLASS, &newTool<Tool_##CLASS>, &resetTool<Tool_##CLASS>, &runTool<Tool_##CLASS>, true }
+#define HUMTOOL_PAIR(NAME, CLASS) \
+	{ NAME, #CLASS, &newTool<Tool_##CLASS>, &resetTool<Tool_##CLASS>, &runToolOnPair<Tool_##CLASS>, false }
+
+const vector<HumToolRegistry::Entry>& HumToolRegistry::getEntries(void) {
+	static const vector<Entry> entries = {
+		HUMTOOL("1520ify",       1520ify),
+		HUMTOOL("addic",         addic),
+		HUMTOOL("addkey",        addkey),
+		HUMTOOL("addlabels",     addlabels),
+		HUMTOOL("addtempo",      addtempo),
+		HUMTOOL("autoaccid",     autoaccid),
+		HUMTOOL_INPLACE("autobeam", autobeam),
+		HUMTOOL("autocadence",   autocadence),
+		HUMTOOL("autostem",      autostem),
+		HUMTOOL("barnum",        barnum),
+		HUMTOOL("binroll",       binroll),
+		HUMTOOL("bstyle",        bstyle),
+		HUMTOOL("chantize",      chantize),
+		HUMTOOL("chint",         chint),
+		HUMTOOL_INPLACE("chord", chord),
+		HUMTOOL("cint",          cint),
+		HUMTOOL("cmr",           cmr),
+		HUMTOOL("colorgroups",   colorgroups),
+		HUMTOOL("colourgroups",  colorgroups),
+		HUMTOOL("colortriads",   colortriads),
+		HUMTOOL("colourtriads",  colortriads),
+		HUMTOOL("composite",     composite),
+		HUMTOOL("deg",           deg),
+		HUMTOOL("degx",          deg),
+		HUMTOOL("dissonant",     dissonant),
+		HUMTOOL_INPLACE("double", double),
+		HUMTOOL("extract",       extract),
+		HUMTOOL("extractx",      extract),
+		HUMTOOL("extremis",      extremis),
+		HUMTOOL("fb",            fb),
+		HUMTOOL("filter",        filter),
+		HUMTOOL("flipper",       flipper),
+		HUMTOOL("gasparize",     gasparize),
+		HUMTOOL("grep",          grep),
+		HUMTOOL("humgrep",       grep),
+		HUMTOOL_INPLACE("half",  half),
+		HUMTOOL("hands",         hands),
+		HUMTOOL("homorhythm",    homorhythm),
+		HUMTOOL("homorhythm2",   homorhythm2),
+		HUMTOOL("hproof",        hproof),
+		HUMTOOL("humbreak",      humbreak),
+		HUMTOOL("humsheet",      humsheet),
+		HUMTOOL_INPLACE("humtr", humtr),
+		HUMTOOL("imitation",     imitation),
+		HUMTOOL("instinfo",      instinfo),
+		HUMTOOL("kern2mens",     kern2mens),
+		HUMTOOL("kernify",       kernify),
+		HUMTOOL("kernview",      kernview),
+		HUMTOOL("melisma",       melisma),
+		HUMTOOL("mens2kern",     mens2kern),
+		HUMTOOL("meter",         meter),
+		HUMTOOL("metlev",        metlev),
+		HUMTOOL("mint",          mint),
+		HUMTOOL("mintx",         mint),
+		HUMTOOL("modori",        modori),
+		HUMTOOL("msearch",       msearch),
+		HUMTOOL("myank",         myank),
+		HUMTOOL("myankx",        myank),
+		HUMTOOL("nproof",        nproof),
+		HUMTOOL("ordergps",      ordergps),
+		HUMTOOL("pbar",          pbar),
+		HUMTOOL("phrase",        phrase),
+		HUMTOOL("pline",         pline),
+		HUMTOOL("prange",        prange),
+		HUMTOOL("recip",         recip),
+		HUMTOOL("restfill",      restfill),
+		HUMTOOL("rid",           rid),
+		HUMTOOL("ridx",          rid),
+		HUMTOOL("ridxx",         rid),
+		HUMTOOL("rmask",         rmask),
+		HUMTOOL("rphrase",       rphrase),
+		HUMTOOL("sab2gs",        sab2gs),
+		HUMTOOL("satb2gs",       satb2gs),
+		HUMTOOL("satb2gsx",      satb2gs),
+		HUMTOOL("scordatura",    scordatura),
+		HUMTOOL("semitones",     semitones),
+		HUMTOOL("shed",          shed),
+		HUMTOOL("sic",           sic),
+		HUMTOOL_PAIR("simat",         simat),
+		HUMTOOL("slurcheck",     slurcheck),
+		HUMTOOL("slur",          slurcheck),
+		HUMTOOL("spinetrace",    spinetrace),
+		HUMTOOL("strophe",       strophe),
+		HUMTOOL("synco",         synco),
+		HUMTOOL("tabber",        tabber),
+		HUMTOOL("tandeminfo",    tandeminfo),
+		HUMTOOL("tassoize",      tassoize),
+		HUMTOOL("tasso",         tassoize),
+		HUMTOOL("tassoise",      tassoize),
+		HUMTOOL("text",          text),
+		HUMTOOL("textdur",       textdur),
+		HUMTOOL("thru",          thru),
+		HUMTOOL("thrux",         thru),
+		HUMTOOL("thruxx",        thru),
+		HUMTOOL_INPLACE("tie",   tie),
+		HUMTOOL("timebase",      timebase),
+		HUMTOOL("timebasex",     timebase),
+		HUMTOOL("transpose",     transpose),
+		HUMTOOL("tremolo",       tremolo),
+		HUMTOOL("triad",         triad),
+		HUMTOOL("trillspell",    trillspell),
+		HUMTOOL("tspos",         tspos),
+		HUMTOOL("colorthirds",   tspos),
+		HUMTOOL("colourthirds",  tspos),
+		HUMTOOL("vcross",        vcross),
+	};
+	return entries;
+}
+
+#undef HUMTOOL
+#undef HUMTOOL_INPLACE
+#undef HUMTOOL_PAIR
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getIndex -- Map of tool names and aliases to their
+//     entries in the list of tools.
+//
+
+const std::unordered_map<string, const HumToolRegistry::Entry*>& HumToolRegistry::getIndex(void) {
+	static const std::unordered_map<string, const Entry*> index = []() {
+		std::unordered_map<string, const Entry*> output;
+		const vector<Entry>& entries = getEntries();
+		for (int i=0; i<(int)entries.size(); i++) {
+			output[entries[i].name] = &entries[i];
+		}
+		return output;
+	}();
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getEntry -- Return the entry for a tool name or alias,
+//     or NULL if there is no tool with that name.
+//
+
+const HumToolRegistry::Entry* HumToolRegistry::getEntry(const string& name) {
+	const std::unordered_map<string, const Entry*>& index = getIndex();
+	auto it = index.find(name);
+	if (it == index.end()) {
+		return NULL;
+	}
+	return it->second;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::isTool -- Returns true if the name is a tool name or
+//     alias.
+//
+
+bool HumToolRegistry::isTool(const string& name) {
+	return getEntry(name) != NULL;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::createTool -- Return a new instance of the tool with the
+//     given name or alias, or NULL if there is no tool with that name.
+//     The caller is responsible for deleting the tool.
+//
+
+HumTool* HumToolRegistry::createTool(const string& name) {
+	const Entry* entry = getEntry(name);
+	if (!entry) {
+		return NULL;
+	}
+	return entry->create();
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getToolNames -- Return a sorted list of the tool names,
+//     and also their aliases if the input is true.
+//
+
+vector<string> HumToolRegistry::getToolNames(bool aliases) {
+	vector<string> output;
+	const vector<Entry>& entries = getEntries();
+	for (int i=0; i<(int)entries.size(); i++) {
+		if (aliases || (entries[i].name == entries[i].tool)) {
+			output.push_back(entries[i].name);
+		}
+	}
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getAliases -- Return the other names for the given
+//     tool name or alias.
+//
+
+vector<string> HumToolRegistry::getAliases(const string& tool) {
+	vector<string> output;
+	const Entry* entry = getEntry(tool);
+	if (!entry) {
+		return output;
+	}
+	const vector<Entry>& entries = getEntries();
+	for (int i=0; i<(int)entries.size(); i++) {
+		if ((entries[i].tool == entry->tool) && (entries[i].name != tool)) {
+			output.push_back(entries[i].name);
+		}
+	}
+	return output;
+}
+
+
+
+
+// Flag for send() so that writing to a closed connection returns an
+// error rather than raising SIGPIPE:
+#if defined(HUMLIB_SOCKETS) && defined(MSG_NOSIGNAL)
+	#define HUMTOOLSERVER_SEND_FLAGS MSG_NOSIGNAL
+#else
+	#define HUMTOOLSERVER_SEND_FLAGS 0
+#endif
+
+
+//////////////////////////////
+//
+// HumToolServer::HumToolServer -- Set the maximum number of files in the
+//     file cache.
+//
+
+HumToolServer::HumToolServer(int cachesize) : m_cache(cachesize),
+		m_stop(false), m_requests(0), m_errors(0) {
+	m_wakeup[0] = -1;
+	m_wakeup[1] = -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::~HumToolServer --
+//
+
+HumToolServer::~HumToolServer() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::getFileCache -- Return the cache of files read for
+//     requests.
+//
+
+HumFileCache& HumToolServer::getFileCache(void) {
+	return m_cache;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::getStatistics -- Return the number of requests and
+//     the state of the file cache.
+//
+
+string HumToolServer::getStatistics(void) {
+	stringstream output;
+	output << "requests=" << m_requests.load()
+	       << "\terrors=" << m_errors.load()
+	       << "\tfiles=" << m_cache.getSize()
+	       << "\thits=" << m_cache.getHitCount()
+	       << "\tmisses=" << m_cache.getMissCount()
+	       << endl;
+	return output.str();
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::processRequest -- Run the tool pipeline of a request on
+//     its file or data.  This function can be called by several threads
+//     at once.  Returns false if the input cannot be read or the tools
+//     had an error.
+//
+
+bool HumToolServer::processRequest(const Request& request, Response& response) {
+	response = Response();
+	m_requests++;
+	HumdrumFile infile;
+	if (!request.filename.empty()) {
+		if (!m_cache.read(infile, request.filename)) {
+			string message = infile.getParseError();
+			if (message.empty()) {
+				message = "cannot read file";
+			}
+			response.error = request.filename + ": " + message + "\n";
+			m_errors++;
+			return false;
+		}
+	} else if (!infile.readString(request.data)) {
+		response.error = "invalid Humdrum data: " + infile.getParseError() + "\n";
+		m_errors++;
+		return false;
+	}
+
+	std::unique_ptr<Tool_filter> filter = takeFilter();
+	filter->process("filter " + request.options, 0, 1);
+	filter->clearOutput();
+	try {
+		response.status = filter->runPipeline(infile, request.tools);
+	} catch (const std::exception& e) {
+		response.status = false;
+		filter->setError(e.what());
+	}
+	response.humdrum = filter->getHumdrumText();
+	response.json    = filter->getJsonText();
+	response.text    = filter->getFreeText();
+	response.warning = filter->getWarning();
+	response.error   = filter->getError();
+	filter->clearOutput();
+	returnFilter(std::move(filter));
+
+	if (!response.error.empty()) {
+		response.status = false;
+	}
+	if (!response.status) {
+		m_errors++;
+	}
+	return response.status;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::takeFilter -- Take an unused filter (or create one if
+//     all filters are in use).
+//
+
+std::unique_ptr<Tool_filter> HumToolServer::takeFilter(void) {
+	std::unique_ptr<Tool_filter> filter;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_filters.empty()) {
+			filter = std::move(m_filters.back());
+			m_filters.pop_back();
+		}
+	}
+	if (!filter) {
+		filter.reset(new Tool_filter);
+	}
+	return filter;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::returnFilter -- Return a filter after use so that it
+//     can be used by another request.
+//
+
+void HumToolServer::returnFilter(std::unique_ptr<Tool_filter> filter) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_filters.push_back(std::move(filter));
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::handleRequest -- Process a request received from a
+//     connection, including the server commands.
+//
+
+void HumToolServer::handleRequest(const Request& request, Response& response) {
+	if (request.command.empty()) {
+		processRequest(request, response);
+	} else if (request.command == "stats") {
+		response = Response();
+		response.status = true;
+		response.text = getStatistics();
+	} else if (request.command == "stop") {
+		response = Response();
+		response.status = true;
+		stop();
+	} else {
+		response = Response();
+		response.error = "unknown command: " + request.command + "\n";
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::serve -- Listen for requests on a Unix domain socket
+//     until stop() is called (or a "stop" command is received).  Each
+//     connection can send any number of requests.  The requests are
+//     answered by the given number of worker threads (one per hardware
+//     thread if jobs is zero or less), which are only used while a
+//     request is being processed, so that open connections waiting for
+//     their next request do not keep other connections from being
+//     answered.  The socket can only be used by the owner of the server
+//     process.  Returns false if the socket cannot be created.
+//
+
+bool HumToolServer::serve(const string& socketpath, int jobs) {
+#ifdef HUMLIB_SOCKETS
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketpath.empty() || (socketpath.size() >= sizeof(address.sun_path))) {
+		cerr << "Error: invalid socket path: " << socketpath << endl;
+		return false;
+	}
+	strncpy(address.sun_path, socketpath.c_str(), sizeof(address.sun_path) - 1);
+
+	// Remove a socket left by a previous server:
+	struct stat info;
+	if ((lstat(socketpath.c_str(), &info) == 0) && S_ISSOCK(info.st_mode)) {
+		unlink(socketpath.c_str());
+	}
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		cerr << "Error: cannot create socket: " << strerror(errno) << endl;
+		return false;
+	}
+	if ((::bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+			(chmod(socketpath.c_str(), 0600) != 0) ||
+			(listen(listener, 64) != 0)) {
+		cerr << "Error: cannot listen on " << socketpath << ": "
+		     << strerror(errno) << endl;
+		::close(listener);
+		return false;
+	}
+
+	// The worker threads write to this pipe when they return a connection,
+	// so that the poll() below includes it without waiting for the timeout:
+	if (pipe(m_wakeup) != 0) {
+		cerr << "Error: cannot create pipe: " << strerror(errno) << endl;
+		::close(listener);
+		unlink(socketpath.c_str());
+		return false;
+	}
+	fcntl(m_wakeup[1], F_SETFL, fcntl(m_wakeup[1], F_GETFL) | O_NONBLOCK);
+
+	m_stop = false;
+	HumThreadPool pool(jobs);
+	// waiting: connections which are waiting for their next request.
+	vector<std::shared_ptr<Connection>> waiting;
+	vector<struct pollfd> polled;
+	// trimmed: the number of requests when the memory pool was last trimmed.
+	long long trimmed = 0;
+	while (!m_stop) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			waiting.insert(waiting.end(), m_returned.begin(), m_returned.end());
+			m_returned.clear();
+		}
+
+		// Check for stop() at least five times a second:
+		polled.resize(waiting.size() + 2);
+		polled[0].fd = listener;
+		polled[1].fd = m_wakeup[0];
+		for (int i=0; i<(int)waiting.size(); i++) {
+			polled[i+2].fd = waiting[i]->fd;
+		}
+		for (auto& item : polled) {
+			item.events = POLLIN;
+			item.revents = 0;
+		}
+		int ready = poll(polled.data(), polled.size(), 200);
+		if ((ready == 0) && (m_requests != trimmed)) {
+			// No requests have arrived for a while, so give the memory of
+			// the files used by earlier requests back to the system:
+			trimmed = m_requests;
+			HumPool::trim();
+		}
+		if (ready <= 0) {
+			continue;
+		}
+		if (polled[1].revents) {
+			char bytes[256];
+			if (read(m_wakeup[0], bytes, sizeof(bytes)) < 0) {
+				// nothing to do: the returned connections are checked anyway
+			}
+		}
+
+		// Answer the connections with a request (or which have been closed)
+		// on a worker thread, and stop polling them until they are returned:
+		int kept = 0;
+		for (int i=0; i<(int)waiting.size(); i++) {
+			if (polled[i+2].revents) {
+				std::shared_ptr<Connection> connection = waiting[i];
+				pool.submit([this, connection]() { serveRequests(connection); });
+			} else {
+				waiting[kept++] = waiting[i];
+			}
+		}
+		waiting.resize(kept);
+
+		if (!polled[0].revents) {
+			continue;
+		}
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0) {
+			continue;
+		}
+		#ifdef SO_NOSIGPIPE
+			int on = 1;
+			setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+		#endif
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_connections.insert(fd);
+		}
+		waiting.push_back(std::make_shared<Connection>());
+		waiting.back()->fd = fd;
+	}
+	::close(listener);
+	unlink(socketpath.c_str());
+
+	// Stop reading requests from open connections, then wait for the
+	// requests in progress to finish:
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (int fd : m_connections) {
+			shutdown(fd, SHUT_RD);
+		}
+	}
+	pool.wait();
+
+	// Close the connections which are waiting for a request:
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		waiting.insert(waiting.end(), m_returned.begin(), m_returned.end());
+		m_returned.clear();
+	}
+	for (auto& connection : waiting) {
+		closeConnection(*connection);
+	}
+	::close(m_wakeup[0]);
+	::close(m_wakeup[1]);
+	m_wakeup[0] = -1;
+	m_wakeup[1] = -1;
+	return true;
+#else
+	cerr << "Error: sockets are not available on this system" << endl;
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::stop -- Make serve() return.  This can be called from
+//     a signal handler.
+//
+
+void HumToolServer::stop(void) {
+	m_stop = true;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::serveRequests -- Answer the request on a connection
+//     which has data to read (and any further requests which have
+//     already been received with it), then return the connection to
+//     serve() to wait for its next request.  The connection is closed
+//     if the client has closed it or the server is stopping.
+//
+
+void HumToolServer::serveRequests(std::shared_ptr<Connection> connection) {
+#ifdef HUMLIB_SOCKETS
+	bool open = true;
+	std::map<string, string> fields;
+	do {
+		open = readMessage(connection->fd, connection->buffer, fields);
+		if (!open) {
+			break;
+		}
+		Request request;
+		request.command  = fields["command"];
+		request.tools    = fields["tools"];
+		request.options  = fields["options"];
+		request.filename = fields["file"];
+		request.data     = fields["data"];
+		Response response;
+		try {
+			handleRequest(request, response);
+		} catch (const std::exception& e) {
+			response = Response();
+			response.error = string(e.what()) + "\n";
+		}
+		vector<pair<string, string>> output = {
+			{ "status",  response.status ? "1" : "0" },
+			{ "humdrum", response.humdrum },
+			{ "json",    response.json },
+			{ "text",    response.text },
+			{ "warning", response.warning },
+			{ "error",   response.error }
+		};
+		open = writeMessage(connection->fd, output);
+	} while (open && !m_stop && !connection->buffer.empty());
+
+	if (!open || m_stop) {
+		closeConnection(*connection);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_returned.push_back(connection);
+	char byte = 0;
+	if (write(m_wakeup[1], &byte, 1) < 0) {
+		// The pipe is full, so serve() will be woken up anyway.
+	}
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::closeConnection -- Close a connection to the server.
+//
+
+void HumToolServer::closeConnection(Connection& connection) {
+#ifdef HUMLIB_SOCKETS
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_connections.erase(connection.fd);
+	}
+	::close(connection.fd);
+	connection.fd = -1;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::sendRequest -- Send a request to a server listening on
+//     the given socket, and wait for the response.  Returns false if the
+//     server cannot be reached, or if the request failed.  Use a Client
+//     to send several requests on the same connection.
+//
+
+bool HumToolServer::sendRequest(const string& socketpath,
+		const Request& request, Response& response) {
+	response = Response();
+	Client client;
+	if (!client.connect(socketpath, response.error)) {
+		return false;
+	}
+	return client.send(request, response);
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::Client --
+//
+
+HumToolServer::Client::Client(void) : m_fd(-1) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::~Client -- Close the connection.
+//
+
+HumToolServer::Client::~Client() {
+	close();
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::connect -- Connect to a server listening on
+//     the given socket (closing any previous connection).  Returns false
+//     and sets the error message if the server cannot be reached.
+//
+
+bool HumToolServer::Client::connect(const string& socketpath, string& error) {
+	close();
+#ifdef HUMLIB_SOCKETS
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketpath.empty() || (socketpath.size() >= sizeof(address.sun_path))) {
+		error = "invalid socket path: " + socketpath + "\n";
+		return false;
+	}
+	strncpy(address.sun_path, socketpath.c_str(), sizeof(address.sun_path) - 1);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		error = string("cannot create socket: ") + strerror(errno) + "\n";
+		return false;
+	}
+	#ifdef SO_NOSIGPIPE
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	#endif
+	if (::connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		error = "cannot connect to " + socketpath + ": " + strerror(errno) + "\n";
+		::close(fd);
+		return false;
+	}
+	m_fd = fd;
+	return true;
+#else
+	error = "sockets are not available on this system\n";
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::isConnected -- Return true if the client has
+//     an open connection.
+//
+
+bool HumToolServer::Client::isConnected(void) const {
+	return m_fd >= 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::close -- Close the connection to the server.
+//
+
+void HumToolServer::Client::close(void) {
+#ifdef HUMLIB_SOCKETS
+	if (m_fd >= 0) {
+		::close(m_fd);
+	}
+#endif
+	m_fd = -1;
+	m_buffer.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::send -- Send a request on the connection, and
+//     wait for the response.  Returns false if the request failed.  The
+//     connection is closed if the server does not answer.
+//
+
+bool HumToolServer::Client::send(const Request& request, Response& response) {
+	response = Response();
+	if (m_fd < 0) {
+		response.error = "not connected to a server\n";
+		return false;
+	}
+	vector<pair<string, string>> input = {
+		{ "command", request.command },
+		{ "tools",   request.tools },
+		{ "options", request.options },
+		{ "file",    request.filename },
+		{ "data",    request.data }
+	};
+	std::map<string, string> fields;
+	if (!writeMessage(m_fd, input) || !readMessage(m_fd, m_buffer, fields)) {
+		response.error = "no response from server\n";
+		close();
+		return false;
+	}
+	response.status  = fields["status"] == "1";
+	response.humdrum = fields["humdrum"];
+	response.json    = fields["json"];
+	response.text    = fields["text"];
+	response.warning = fields["warning"];
+	response.error   = fields["error"];
+	return response.status;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::getDefaultSocket -- Return the socket used by the
+//     server and client programs if no socket is given:
+//     $XDG_RUNTIME_DIR/humserver.sock, or else /tmp/humserver-<uid>.sock.
+//
+
+string HumToolServer::getDefaultSocket(void) {
+	const char* directory = getenv("XDG_RUNTIME_DIR");
+	if (directory && directory[0]) {
+		return string(directory) + "/humserver.sock";
+	}
+#ifdef HUMLIB_SOCKETS
+	return "/tmp/humserver-" + to_string((long long)getuid()) + ".sock";
+#else
+	return "humserver.sock";
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::readMessage -- Read the fields of a message.  The
+//     buffer stores data which has been read from the socket but not yet
+//     used, and should be kept between messages on the same connection.
+//     Returns false if the connection was closed or the message is
+//     malformed.
+//
+
+bool HumToolServer::readMessage(int fd, string& buffer,
+		std::map<string, string>& fields) {
+	fields.clear();
+#ifdef HUMLIB_SOCKETS
+	size_t position = 0;
+	char chunk[65536];
+
+	// Make sure that the buffer has "size" bytes after position:
+	auto fill = [&](size_t size) {
+		while (buffer.size() - position < size) {
+			ssize_t count = recv(fd, chunk, sizeof(chunk), 0);
+			if ((count < 0) && (errno == EINTR)) {
+				continue;
+			}
+			if (count <= 0) {
+				return false;
+			}
+			buffer.append(chunk, (size_t)count);
+		}
+		return true;
+	};
+
+	while (true) {
+		// Read the field header:
+		size_t newline;
+		while ((newline = buffer.find('\n', position)) == string::npos) {
+			if ((buffer.size() - position > 1024) || !fill(buffer.size() - position + 1)) {
+				return false;
+			}
+		}
+		string header = buffer.substr(position, newline - position);
+		position = newline + 1;
+		size_t space = header.find(' ');
+		if ((space == string::npos) || (space == 0)) {
+			return false;
+		}
+		string name = header.substr(0, space);
+		char* end = NULL;
+		unsigned long long length = strtoull(header.c_str() + space + 1, &end, 10);
+		if ((end == header.c_str() + space + 1) || (*end != '\0')) {
+			return false;
+		}
+		if (name == "end") {
+			break;
+		}
+		if (!fill((size_t)length)) {
+			return false;
+		}
+		fields[name] = buffer.substr(position, (size_t)length);
+		position += (size_t)length;
+	}
+	buffer.erase(0, position);
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::writeMessage -- Send the fields of a message.
+//
+
+bool HumToolServer::writeMessage(int fd, const vector<pair<string, string>>& fields) {
+	string output;
+	for (auto& field : fields) {
+		output += field.first;
+		output += ' ';
+		output += to_string(field.second.size());
+		output += '\n';
+		output += field.second;
+	}
+	output += "end 0\n";
+	return writeData(fd, output.data(), output.size());
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::writeData -- Write all of the data to a socket.
+//
+
+bool HumToolServer::writeData(int fd, const char* data, size_t size) {
+#ifdef HUMLIB_SOCKETS
+	while (size > 0) {
+		ssize_t count = send(fd, data, size, HUMTOOLSERVER_SEND_FLAGS);
+		if ((count < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (count <= 0) {
+			return false;
+		}
+		data += count;
+		size -= (size_t)count;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+
+
 const std::vector<int> HumTransposer::m_diatonic2semitone({ 0, 2, 4, 5, 7, 9, 11 });
 
 
@@ -22708,6 +28323,7 @@ int HumdrumFileBase::open_network_socket(const string& hostname,
 //
 
 HumdrumFileBase::HumdrumFileBase(void) : HumHash() {
+	setAnalysisOwner(FileAnalysisOwner);
 	addToTrackStarts(NULL);
 	m_ticksperquarternote = -1;
 	m_quietParse = false;
@@ -22715,6 +28331,7 @@ HumdrumFileBase::HumdrumFileBase(void) : HumHash() {
 }
 
 HumdrumFileBase::HumdrumFileBase(const string& filename) : HumHash() {
+	setAnalysisOwner(FileAnalysisOwner);
 	addToTrackStarts(NULL);
 	m_ticksperquarternote = -1;
 	m_quietParse = false;
@@ -22723,6 +28340,7 @@ HumdrumFileBase::HumdrumFileBase(const string& filename) : HumHash() {
 }
 
 HumdrumFileBase::HumdrumFileBase(istream& contents) : HumHash() {
+	setAnalysisOwner(FileAnalysisOwner);
 	addToTrackStarts(NULL);
 	m_ticksperquarternote = -1;
 	m_quietParse = false;
@@ -22736,7 +28354,8 @@ HumdrumFileBase::HumdrumFileBase(istream& contents) : HumHash() {
 // using the following constructor:
 //
 
-HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) {
+HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) : HumHash() {
+	setAnalysisOwner(FileAnalysisOwner);
 
 	m_filename = infile.m_filename;
 	m_segmentlevel = infile.m_segmentlevel;
@@ -22752,6 +28371,7 @@ HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) {
 	m_quietParse = infile.m_quietParse;
 	m_parseError = infile.m_parseError;
 	m_displayError = infile.m_displayError;
+	m_readAnalyses = infile.m_readAnalyses;
 
 	m_lines.resize(infile.m_lines.size());
 	for (int i=0; i<(int)m_lines.size(); i++) {
@@ -22790,6 +28410,7 @@ HumdrumFileBase& HumdrumFileBase::operator=(HumdrumFileBase& infile) {
 	m_quietParse = infile.m_quietParse;
 	m_parseError = infile.m_parseError;
 	m_displayError = infile.m_displayError;
+	m_readAnalyses = infile.m_readAnalyses;
 
 	m_lines.resize(infile.m_lines.size());
 	for (int i=0; i<(int)m_lines.size(); i++) {
@@ -22840,8 +28461,31 @@ void HumdrumFileBase::clear(void) {
 	m_strophes1d.clear();
 	m_strophes2d.clear();
 	m_filename.clear();
+	m_parseError.clear();
 	m_segmentlevel = 0;
 	m_analyses.clear();
+	detachAnalysisValues();
+	m_analysisValues.reset();
+	m_snapshotPending = false;
+	m_editedTokens = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getAnalysisStore -- Return the store for "auto"
+//     parameters of the file and of its lines and tokens.  The store is
+//     created when the first value is stored (or returned as NULL before
+//     then if create is false), and deleted when the file is cleared.
+// default value: create = true
+//
+
+HumAnalysisStore* HumdrumFileBase::getAnalysisStore(bool create) {
+	if (!m_analysisValues && create) {
+		m_analysisValues.reset(new HumAnalysisStore);
+	}
+	return m_analysisValues.get();
 }
 
 
@@ -22852,7 +28496,7 @@ void HumdrumFileBase::clear(void) {
 //
 
 bool HumdrumFileBase::isStructureAnalyzed(void) {
-	return m_analyses.m_structure_analyzed;
+	return m_analyses.isAnalyzed(HumFileAnalysis::Structure);
 }
 
 
@@ -22863,7 +28507,7 @@ bool HumdrumFileBase::isStructureAnalyzed(void) {
 //
 
 bool HumdrumFileBase::isRhythmAnalyzed(void) {
-	return m_analyses.m_rhythm_analyzed;
+	return m_analyses.isAnalyzed(HumFileAnalysis::Rhythm);
 }
 
 
@@ -22874,18 +28518,238 @@ bool HumdrumFileBase::isRhythmAnalyzed(void) {
 //
 
 bool HumdrumFileBase::areStrandsAnalyzed(void) {
-	return m_analyses.m_strands_analyzed;
+	return m_analyses.isAnalyzed(HumFileAnalysis::Strands);
 }
 
 
 
 //////////////////////////////
 //
-// HumdrumFileBase::areStrandsAnalyzed --
+// HumdrumFileBase::areStrophesAnalyzed --
 //
 
 bool HumdrumFileBase::areStrophesAnalyzed(void) {
-	return m_analyses.m_strophes_analyzed;
+	return m_analyses.isAnalyzed(HumFileAnalysis::Strophes);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::isAnalyzed -- Returns true if the given analysis
+//     (such as HumFileAnalysis::Slurs) has been done on the file.
+//
+
+bool HumdrumFileBase::isAnalyzed(int type) const {
+	return m_analyses.isAnalyzed(type);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::requireAnalysis -- Run an analysis on the file if it
+//     has not been done yet.  Any analyses that it depends on are run
+//     first.  Files with parse errors are not analyzed, as when they are
+//     read.  Returns false if the file is not valid after the analysis.
+//
+
+bool HumdrumFileBase::requireAnalysis(int type) {
+	if ((type < 0) || (type >= HumFileAnalysis::Count) || !isValid()) {
+		return isValid();
+	}
+	if (m_analyses.isAnalyzed(type)) {
+		return isValid();
+	}
+	unsigned dependencies = HumFileAnalysis::getDependencies(type);
+	for (int i=0; i<HumFileAnalysis::Count; i++) {
+		if (dependencies & HumFileAnalysis::getMask(i)) {
+			if (!requireAnalysis(i)) {
+				return false;
+			}
+		}
+	}
+	if (m_analyses.isAnalyzed(type)) {
+		// done as a side effect of one of the dependencies.
+		return isValid();
+	}
+	bool status = runAnalysis(type);
+	m_analyses.setAnalyzed(type);
+	return status && isValid();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::requireAnalyses -- Run each analysis in a bit mask of
+//     analysis types (see requireAnalysis()).
+//
+
+bool HumdrumFileBase::requireAnalyses(unsigned mask) {
+	for (int i=0; i<HumFileAnalysis::Count; i++) {
+		if (mask & HumFileAnalysis::getMask(i)) {
+			if (!requireAnalysis(i)) {
+				return isValid();
+			}
+		}
+	}
+	return isValid();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::setReadAnalyses -- Set the analyses which are done
+//     when reading data with HumdrumFileStructure::read() and the
+//     similar functions.  The input is a bit mask of analysis types, such
+//     as HumFileAnalysis::getMask(HumFileAnalysis::Rhythm).  Analyses which
+//     are not done when reading are done later, the first time that
+//     they are needed.  The default is HumFileAnalysis::ReadDefault.
+//
+
+void HumdrumFileBase::setReadAnalyses(unsigned mask) {
+	m_readAnalyses = mask;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getReadAnalyses -- Return the bit mask of analyses
+//     which are done when reading data.
+//
+
+unsigned HumdrumFileBase::getReadAnalyses(void) const {
+	return m_readAnalyses;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::reanalyzeTokens -- Redo the analyses which depend on
+//     the text of the tokens (null resolution, strophes, parameters,
+//     durations, rhythm and any content analyses), keeping the lines,
+//     tokens, spine links, tracks and strands of the file.  This is
+//     for tokens which were changed in place by setText(), with no lines
+//     or tokens added or removed, and no changes to spine manipulators
+//     or exclusive interpretations.  The results are the same as reading
+//     the text of the file again with the analyses in getReadAnalyses().
+//
+
+bool HumdrumFileBase::reanalyzeTokens(void) {
+	clearAnalysisInfo();
+	bool strands = m_analyses.isAnalyzed(HumFileAnalysis::Strands);
+	m_analyses.clear();
+	m_analyses.setAnalyzed(HumFileAnalysis::Strands, strands);
+	m_editedTokens = false;
+	return requireAnalyses(m_readAnalyses);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::hasEditedTokens -- Returns true if the text of any
+//     token was changed with HumdrumToken::setText() since the file was
+//     read, or since the last call to reanalyzeTokens() or
+//     setEditedTokens(false).  The analyses of the file may then be out
+//     of date.
+//
+
+bool HumdrumFileBase::hasEditedTokens(void) const {
+	return m_editedTokens;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::setEditedTokens -- Mark the tokens of the file as
+//     edited (called by HumdrumToken::setText()), or clear the mark.
+//
+
+void HumdrumFileBase::setEditedTokens(bool state) {
+	m_editedTokens = state;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::clearAnalysisInfo -- Remove the results of the analyses
+//     from the lines and tokens of the file (but not the spine links and
+//     tracks), and the lists of barlines, strophes and signifiers.
+//
+
+void HumdrumFileBase::clearAnalysisInfo(void) {
+	for (int i=0; i<(int)m_lines.size(); i++) {
+		HumdrumLine& line = *m_lines[i];
+		line.clearParameters();
+		line.m_linkedParameters.clear();
+		line.m_duration = -1;
+		line.m_durationFromStart = -1;
+		line.m_durationFromBarline = 0;
+		line.m_durationToBarline = 0;
+		line.m_rhythm_analyzed = false;
+		for (int j=0; j<(int)line.m_tokens.size(); j++) {
+			HumdrumToken& token = *line.m_tokens[j];
+			token.clearParameters();
+			token.m_linkedParameterTokens.clear();
+			if (token.m_parameterSet) {
+				delete token.m_parameterSet;
+				token.m_parameterSet = NULL;
+			}
+			token.m_nextNonNullTokens.clear();
+			token.m_previousNonNullTokens.clear();
+			token.m_duration = 0;
+			token.m_rhycheck = 0;
+			token.m_rhythm_analyzed = false;
+			token.m_nullresolve = NULL;
+			token.m_strophe = NULL;
+			token.clearKernRecord();
+		}
+	}
+	m_barlines.clear();
+	m_strophes1d.clear();
+	m_strophes2d.clear();
+	m_signifiers.clear();
+	m_ticksperquarternote = -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::analyzeForRead -- Run the analyses which were selected
+//     with setReadAnalyses().  If the file was not found in the snapshot
+//     cache when it was read, a snapshot is saved after the analyses.
+//
+
+bool HumdrumFileBase::analyzeForRead(void) {
+	bool status = requireAnalyses(m_readAnalyses);
+	if (m_snapshotPending) {
+		m_snapshotPending = false;
+		if (status) {
+			HumSnapshot::writeCache(*this, m_snapshotKey);
+		}
+	}
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::runAnalysis -- Do a single analysis on the file.  No
+//     analyses are done at this level: HumdrumFileStructure and
+//     HumdrumFileContent handle the analyses of their data.
+//
+
+bool HumdrumFileBase::runAnalysis(int type) {
+	return true;
 }
 
 
@@ -23004,6 +28868,8 @@ bool HumdrumFileBase::read(const char* filename) {
 	ifstream infile;
 	if (fname.empty() || (fname ==  "-")) {
 		return HumdrumFileBase::read(cin);
+	} else if (readMappedFile(filename)) {
+		return isValid();
 	} else {
 		infile.open(filename);
 		if (!infile.is_open()) {
@@ -23031,6 +28897,184 @@ bool HumdrumFileBase::read(istream& contents) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::readBuffer -- Read Humdrum content from a block of
+//    memory, such as a memory-mapped file.  Line boundaries are located
+//    in a single pass over the buffer, and each line's text is copied
+//    only once (directly into the HumdrumLine, which then splits it into
+//    tokens).  Line splitting is identical to std::getline(): a final
+//    line without a trailing newline is kept, and a trailing newline
+//    does not generate an extra empty line.  If a snapshot cache is set,
+//    the analyses may be loaded from the cache (see analyzeBaseFromCache()).
+//
+
+bool HumdrumFileBase::readBuffer(const char* contents, size_t size) {
+	clear();
+	m_displayError = true;
+	if ((contents == NULL) || (size == 0)) {
+		return analyzeBaseFromLines();
+	}
+	std::uint64_t key = 0;
+	if (HumSnapshot::isCacheEnabled()) {
+		key = HumSnapshot::getContentKey(contents, size);
+	}
+	splitBuffer(contents, size);
+	return analyzeBaseFromCache(key);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::splitBuffer -- Add the lines in a block of memory to
+//    the file, without splitting them into tokens (see readBuffer()).
+//
+
+void HumdrumFileBase::splitBuffer(const char* contents, size_t size) {
+	// Rough guess at the line count to avoid repeated reallocation
+	// of the line list:
+	m_lines.reserve(m_lines.size() + size / 40 + 1);
+	const char* start = contents;
+	const char* end = contents + size;
+	HLp s;
+	while (start < end) {
+		const char* newline = (const char*)memchr(start, '\n', end - start);
+		const char* stop = newline ? newline : end;
+		size_t length = stop - start;
+		if ((length > 0) && (start[length-1] == 0x0d)) {
+			length--;
+		}
+		s = new HumdrumLine;
+		s->assign(start, length);
+		s->setOwner(this);
+		m_lines.push_back(s);
+		if (newline == NULL) {
+			break;
+		}
+		start = newline + 1;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readSnapshot -- Read Humdrum content from a string,
+//    loading the analyses from a snapshot of the same content which was
+//    stored with writeSnapshot().  This is faster than reading the
+//    content with readString(), so it is used to keep analyzed files in
+//    memory (such as in HumFileCache) while giving each reader its own
+//    copy of the file which can be changed.  If the snapshot cannot be
+//    used, the content is analyzed as in readString().
+//
+
+bool HumdrumFileBase::readSnapshot(const string& contents,
+		const string& snapshot) {
+	clear();
+	m_displayError = false;
+	m_snapshotPending = false;
+	splitBuffer(contents.data(), contents.size());
+	HumSnapshot reader;
+	if (snapshot.empty() || !reader.readString(*this, snapshot)) {
+		if (!analyzeBaseFromLines()) {
+			return isValid();
+		}
+	}
+	return analyzeForRead();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::writeSnapshot -- Store the analyses of the file in a
+//    string for use with readSnapshot().  Returns false if the file
+//    cannot be stored in a snapshot.
+//
+
+bool HumdrumFileBase::writeSnapshot(string& snapshot) {
+	HumSnapshot writer;
+	return writer.writeString(*this, snapshot);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readLines -- Read Humdrum content from a list of
+//    lines, each given as a pointer to its text and the length of the
+//    text (not including a newline).  This allows a file to be parsed
+//    from pieces of a larger buffer without first copying them into a
+//    single string.
+//
+
+bool HumdrumFileBase::readLines(const vector<pair<const char*, size_t>>& lines) {
+	clear();
+	m_displayError = true;
+	m_lines.reserve(lines.size());
+	HLp s;
+	for (int i=0; i<(int)lines.size(); i++) {
+		size_t length = lines[i].second;
+		if ((length > 0) && (lines[i].first[length-1] == 0x0d)) {
+			length--;
+		}
+		s = new HumdrumLine;
+		s->assign(lines[i].first, length);
+		s->setOwner(this);
+		m_lines.push_back(s);
+	}
+	std::uint64_t key = 0;
+	if (HumSnapshot::isCacheEnabled()) {
+		key = HumSnapshot::getContentKey(lines);
+	}
+	return analyzeBaseFromCache(key);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readMappedFile -- Memory-map a regular file and
+//    read its contents with readBuffer().  Returns false without
+//    changing the file contents if the file cannot be mapped (such as
+//    for pipes or on systems without mmap), in which case the caller
+//    should fall back to reading the file through an input stream.
+//
+
+bool HumdrumFileBase::readMappedFile(const char* filename) {
+#ifdef HUMLIB_MMAP
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode)) {
+		::close(fd);
+		return false;
+	}
+	size_t size = (size_t)info.st_size;
+	if (size == 0) {
+		::close(fd);
+		readBuffer(NULL, 0);
+		return true;
+	}
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	madvise(data, size, MADV_SEQUENTIAL);
+	readBuffer((const char*)data, size);
+	munmap(data, size);
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::readCsv -- Read a Humdrum file in CSV format
@@ -23039,7 +29083,7 @@ bool HumdrumFileBase::read(istream& contents) {
 //
 
 bool HumdrumFileBase::readCsv(const string& filename, const string& separator) {
-	return HumdrumFileBase::readCsv(filename.c_str());
+	return HumdrumFileBase::readCsv(filename.c_str(), separator);
 }
 
 
@@ -23061,15 +29105,33 @@ bool HumdrumFileBase::readCsv(const char* filename, const string& separator) {
 
 bool HumdrumFileBase::readCsv(istream& contents, const string& separator) {
 	m_displayError = true;
-	char buffer[123123] = {0};
+	string buffer((istreambuf_iterator<char>(contents)), istreambuf_iterator<char>());
+	splitCsvBuffer(buffer.data(), buffer.size(), separator);
+	return analyzeBaseFromLines();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::splitCsvBuffer -- Convert the CSV records in a block of
+//    memory into lines of the file (see HumFieldScanner::csvToTsv()).  As
+//    with splitBuffer(), a trailing newline does not generate an extra
+//    empty line.
+//
+
+void HumdrumFileBase::splitCsvBuffer(const char* contents, size_t size,
+		const string& separator) {
+	m_lines.reserve(m_lines.size() + size / 40 + 1);
+	const char* start = contents;
+	const char* end = contents + size;
 	HLp s;
-	while (contents.getline(buffer, sizeof(buffer), '\n')) {
+	while (start < end) {
 		s = new HumdrumLine;
-		s->setLineFromCsv(buffer);
+		start = HumFieldScanner::csvToTsv(start, end, separator, *s);
 		s->setOwner(this);
 		m_lines.push_back(s);
 	}
-	return analyzeBaseFromLines();
 }
 
 
@@ -23090,6 +29152,31 @@ bool HumdrumFileBase::analyzeBaseFromLines(void)  {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::analyzeBaseFromCache -- Analyze the lines which were
+//     read from contents with the given key.  If a snapshot cache
+//     directory is set (see HumSnapshot::setCacheDirectory()), the
+//     analyses are loaded from the cache when possible, which includes
+//     the read analyses selected with setReadAnalyses().  Otherwise the
+//     lines are analyzed, and analyzeForRead() will save a snapshot.
+//
+
+bool HumdrumFileBase::analyzeBaseFromCache(std::uint64_t key) {
+	m_snapshotPending = false;
+	if (!HumSnapshot::isCacheEnabled()) {
+		return analyzeBaseFromLines();
+	}
+	if (HumSnapshot::readCache(*this, key)) {
+		return isValid();
+	}
+	m_snapshotKey = key;
+	m_snapshotPending = true;
+	return analyzeBaseFromLines();
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::setFilenameFromSegment -- Update filename based on any
@@ -23146,17 +29233,15 @@ bool HumdrumFileBase::analyzeBaseFromTokens(void) {
 //
 
 bool HumdrumFileBase::readString(const string& contents) {
-	stringstream infile;
-	infile << contents;
-	bool status = read(infile);
-	return status;
+	return readBuffer(contents.data(), contents.size());
 }
 
 
 bool HumdrumFileBase::readString(const char* contents) {
-	stringstream infile;
-	infile << contents;
-	return read(infile);
+	if (contents == NULL) {
+		return readBuffer(NULL, 0);
+	}
+	return readBuffer(contents, strlen(contents));
 }
 
 
@@ -23168,17 +29253,17 @@ bool HumdrumFileBase::readString(const char* contents) {
 
 bool HumdrumFileBase::readStringCsv(const char* contents,
 		const string& separator) {
-	stringstream infile;
-	infile << contents;
-	return readCsv(infile, separator);
+	m_displayError = true;
+	splitCsvBuffer(contents, strlen(contents), separator);
+	return analyzeBaseFromLines();
 }
 
 
 bool HumdrumFileBase::readStringCsv(const string& contents,
 		const string& separator) {
-	stringstream infile;
-	infile << contents;
-	return readCsv(infile, separator);
+	m_displayError = true;
+	splitCsvBuffer(contents.data(), contents.size(), separator);
+	return analyzeBaseFromLines();
 }
 
 
@@ -23570,7 +29655,9 @@ void HumdrumFileBase::insertLine(int index, HLp line) {
 // HumdrumFileBase::deleteLine -- remove a line from the Humdrum file.
 //    Is best used for global comments and reference records for now.
 //    Other line types will cause parsing problems untill further
-//    generalized to stitch previous next lines together.
+//    generalized to stitch previous next lines together (use
+//    HumdrumFileStructure::editDeleteLine() to delete other lines).
+//    The line indexes of the following lines are updated.
 //
 
 void HumdrumFileBase::deleteLine(int index) {
@@ -23583,6 +29670,7 @@ void HumdrumFileBase::deleteLine(int index) {
 	delete m_lines[index];
 	for (int i=index+1; i<(int)m_lines.size(); i++) {
 		m_lines[i-1] = m_lines[i];
+		m_lines[i-1]->setLineIndex(i-1);
 	}
 	m_lines.resize(m_lines.size() - 1);
 }
@@ -24204,11 +30292,43 @@ bool HumdrumFileBase::analyzeTracks(void) {
 			return false;
 		}
 	}
+	analyzeDataTypes();
 	return isValid();
 }
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::analyzeDataTypes -- Store the HumDataType id of the
+//    exclusive interpretation for each track in the tokens of the track.
+//    Tokens not in a track are given HumDataType::None.
+//
+
+void HumdrumFileBase::analyzeDataTypes(void) {
+	vector<int> ids(m_trackstarts.size(), HumDataType::None);
+	for (int i=1; i<(int)m_trackstarts.size(); i++) {
+		if (m_trackstarts[i]) {
+			ids[i] = HumDataType::getId(*m_trackstarts[i]);
+		}
+	}
+	int trackcount = (int)ids.size();
+	for (int i=0; i<(int)m_lines.size(); i++) {
+		HumdrumLine& line = *m_lines[i];
+		for (int j=0; j<line.getTokenCount(); j++) {
+			HTp token = line.token(j);
+			int track = token->getTrack();
+			if ((track > 0) && (track < trackcount)) {
+				token->setDataTypeId(ids[track]);
+			} else {
+				token->setDataTypeId(HumDataType::None);
+			}
+		}
+	}
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::analyzeLinks -- Generate forward and backwards spine links
@@ -24721,12 +30841,15 @@ bool HumdrumFileBase::analyzeNonNullDataTokens(void) {
 
 	vector<HTp> stops;
 	getSpineStopList(stops);
-	HTp nexts = NULL;
 
 	for (int i=0; i<(int)stops.size(); i++) {
 		if (stops[i] == NULL) {
 			continue;
 		}
+		// Tokens after the last non-null data token in a spine do not
+		// have a next non-null data token (rather than the first one
+		// in the previous spine):
+		HTp nexts = NULL;
 		HTp token = stops[i];
 		if (token->isData() && !token->isNull()) {
 			nexts = token;
@@ -24851,7 +30974,7 @@ bool HumdrumFileBase::processNonNullDataTokensForTrackForward(HTp starttoken,
 //    variable in HumdrumTokens)
 //
 
-void HumdrumFileBase::addUniqueTokens(vector<HTp>& target,
+void HumdrumFileBase::addUniqueTokens(HumTokenLinks& target,
 		vector<HTp>& source) {
 	int i, j;
 	bool found;
@@ -25557,6 +31680,7 @@ void HumdrumFileBase::clearTokenLinkInfo(void) {
 //
 
 bool HumdrumFileContent::analyzeAccidentals(void) {
+	m_analyses.setAnalyzed(HumFileAnalysis::Accidentals);
 	bool status = true;
 	status &= analyzeKernAccidentals();
 	status &= analyzeMensAccidentals();
@@ -26076,11 +32200,11 @@ void HumdrumFileContent::resetDiatonicStatesWithKeySignature(vector<int>&
 //
 
 void HumdrumFileContent::analyzeBarlines(void) {
-	if (m_analyses.m_barlines_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Barlines)) {
 		// Maybe allow forcing reanalysis.
 		return;
 	}
-	m_analyses.m_barlines_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Barlines);
 	m_analyses.m_barlines_different = false;
 
 	string baseline;
@@ -26213,9 +32337,7 @@ bool HumdrumFileContent::hasDataStraddle(int line) {
 //
 
 bool HumdrumFileContent::hasDifferentBarlines(void) {
-	if (!m_analyses.m_barlines_analyzed) {
-		analyzeBarlines();
-	}
+	requireAnalysis(HumFileAnalysis::Barlines);
 	return m_analyses.m_barlines_different;
 }
 
@@ -26232,10 +32354,10 @@ bool HumdrumFileContent::hasDifferentBarlines(void) {
 //
 
 bool HumdrumFileContent::analyzeBeams(void) {
-	if (m_analyses.m_beams_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Beams)) {
 		return false;
 	}
-	m_analyses.m_beams_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Beams);
 	bool output = true;
 	output &= analyzeKernBeams();
 	output &= analyzeMensBeams();
@@ -26482,7 +32604,7 @@ bool HumdrumFileContent::analyzeKernBeams(HTp spinestart,
 							// This is a beam closing that does not have a matching opening.
 							token->setValue("auto", "hangingBeam", "true");
 							token->setValue("auto", "beamSide", "stop");
-							token->setValue("auto", "beamOpenIndex", to_string(i));
+							token->setValue("auto", "beamOpenIndex", i);
 							token->setValue("auto", "beamDuration",
 								token->getDurationToEnd());
 						}
@@ -27464,7 +33586,7 @@ void HumdrumFileContent::analyzeOttavas(void) {
 					// do not exclude rests, since the vertical placement
 					// of the staff may need to be updated by the ottava mark.
 				}
-				token->setValue("auto", "ottava", to_string(octavestate[track]));
+				token->setValue("auto", "ottava", octavestate[track]);
 			}
 		}
 	}
@@ -27481,10 +33603,10 @@ void HumdrumFileContent::analyzeOttavas(void) {
 //
 
 bool HumdrumFileContent::analyzePhrasings(void) {
-	if (m_analyses.m_phrases_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Phrases)) {
 		return false;
 	}
-	m_analyses.m_phrases_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Phrases);
 	bool output = true;
 	output &= analyzeKernPhrasings();
 	return output;
@@ -27658,7 +33780,7 @@ bool HumdrumFileContent::analyzeKernPhrasings(HTp spinestart,
 							// This is a phrase closing that does not have a matching opening.
 							token->setValue("auto", "hangingPhrase", "true");
 							token->setValue("auto", "phraseSide", "stop");
-							token->setValue("auto", "phraseOpenIndex", to_string(i));
+							token->setValue("auto", "phraseOpenIndex", i);
 							token->setValue("auto", "phraseDuration",
 								token->getDurationToEnd());
 						}
@@ -27814,8 +33936,8 @@ void HumdrumFileContent::linkPhraseEndpoints(HTp phrasestart, HTp phraseend) {
 	HumNum duration = phraseend->getDurationFromStart()
 			- phrasestart->getDurationFromStart();
 	phrasestart->setValue("auto", durtag, duration);
-	phrasestart->setValue("auto", "phraseEndCount", to_string(phraseEndCount));
-	phraseend->setValue("auto", "phraseStartCount", to_string(phraseStartCount));
+	phrasestart->setValue("auto", "phraseEndCount", phraseEndCount);
+	phraseend->setValue("auto", "phraseStartCount", phraseStartCount);
 }
 
 
@@ -28545,10 +34667,10 @@ int HumdrumFileContent::getRestPositionAboveNotes(HTp rest, vector<int>& vpos) {
 //
 
 bool HumdrumFileContent::analyzeSlurs(void) {
-	if (m_analyses.m_slurs_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Slurs)) {
 		return false;
 	}
-	m_analyses.m_slurs_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Slurs);
 	bool output = true;
 	output &= analyzeKernSlurs();
 	output &= analyzeMensSlurs();
@@ -28795,7 +34917,7 @@ bool HumdrumFileContent::analyzeKernSlurs(HTp spinestart,
 							// This is a slur closing that does not have a matching opening.
 							token->setValue("auto", "hangingSlur", "true");
 							token->setValue("auto", "slurSide", "stop");
-							token->setValue("auto", "slurOpenIndex", to_string(i));
+							token->setValue("auto", "slurOpenIndex", i);
 							token->setValue("auto", "slurDuration",
 								token->getDurationToEnd());
 						}
@@ -29046,19 +35168,19 @@ bool HumdrumFileContent::analyzeKernStemLengths(HTp stok, HTp etok, vector<vecto
 		int diff = b7 - centerlines[track][tok->getLineIndex()];
 		if (subtrack == 1) {
 			if (diff == 1) { // 0.5 stem length adjustment
-				tok->setValue("auto", "stemlen", "6.5");
+				tok->setValue("auto", "stemlen", 6.5);
 			} else if (diff == 2) { // 1.0 stem length adjustment
-				tok->setValue("auto", "stemlen", "6");
+				tok->setValue("auto", "stemlen", 6.0);
 			} else if (diff >= 3) { // 1.5 stem length adjustment
-				tok->setValue("auto", "stemlen", "5.5");
+				tok->setValue("auto", "stemlen", 5.5);
 			}
 		} else if (subtrack == 2) {
 			if (diff == -1) { // 0.5 stem length adjustment
-				tok->setValue("auto", "stemlen", "6.5");
+				tok->setValue("auto", "stemlen", 6.5);
 			} else if (diff == -2) { // 1.0 stem length adjustment
-				tok->setValue("auto", "stemlen", "6");
+				tok->setValue("auto", "stemlen", 6.0);
 			} else if (diff <= -3) { // 1.5 stem length adjustment
-				tok->setValue("auto", "stemlen", "5.5");
+				tok->setValue("auto", "stemlen", 5.5);
 			}
 
 		}
@@ -29194,6 +35316,7 @@ bool HumdrumFileContent::analyzeTextRepetition(void) {
 //
 
 bool HumdrumFileContent::analyzeKernTies(void) {
+	m_analyses.setAnalyzed(HumFileAnalysis::Ties);
 	vector<pair<HTp, int>> linkedtiestarts;
 	vector<pair<HTp, int>> linkedtieends;
 
@@ -29258,14 +35381,12 @@ bool HumdrumFileContent::analyzeKernTies(
 			if (tok->isRest()) {
 				continue;
 			}
-			int scount = tok->getSubtokenCount();
+			bool chord = tok->isChord();
 			int b40;
-			for (int k=0; k<scount; k++) {
-				int index = k;
-				if (scount == 1) {
-					index = -1;
-				}
-				std::string tstring = tok->getSubtoken(k);
+			int k = 0;
+			for (std::string_view tstring : tok->getSubtokenViews()) {
+				int index = chord ? k : -1;
+				k++;
 				if (tstring.find(lstart) != std::string::npos) {
 					b40 = Convert::kernToBase40(tstring);
 					startdatabase[b40].first  = tok;
@@ -29359,13 +35480,13 @@ void HumdrumFileContent::linkTieEndpoints(HTp tiestart,
    tiestart->setValue("auto", endtag, tieend);
    tiestart->setValue("auto", "id", tiestart);
 	if (endnumber > 0) {
-		tiestart->setValue("auto", endnum, to_string(endnumber));
+		tiestart->setValue("auto", endnum, endnumber);
 	}
 
    tieend->setValue("auto", starttag, tiestart);
    tieend->setValue("auto", "id", tieend);
 	if (startnumber > 0) {
-		tieend->setValue("auto", startnum, to_string(startnumber));
+		tieend->setValue("auto", startnum, startnumber);
 	}
 
    HumNum duration = tieend->getDurationFromStart()
@@ -29505,6 +35626,27 @@ HumdrumFileContent::~HumdrumFileContent() {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileContent::runAnalysis -- Do one of the content analyses
+//    for HumdrumFileBase::requireAnalysis().  The analyses that it
+//    depends on have already been done.
+//
+
+bool HumdrumFileContent::runAnalysis(int type) {
+	switch (type) {
+		case HumFileAnalysis::Barlines:    analyzeBarlines(); return true;
+		case HumFileAnalysis::Slurs:       return analyzeSlurs();
+		case HumFileAnalysis::Phrases:     return analyzePhrasings();
+		case HumFileAnalysis::Beams:       return analyzeBeams();
+		case HumFileAnalysis::Ties:        return analyzeKernTies();
+		case HumFileAnalysis::Accidentals: return analyzeAccidentals();
+	}
+	return HumdrumFileStructure::runAnalysis(type);
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileContent::analyzeRScale --
@@ -29652,14 +35794,16 @@ int HumdrumFileContent::hasPickup(void) {
 //
 
 HumdrumFileSet::HumdrumFileSet(void) {
-	// do nothing
+	m_threads = 1;
 }
 
 HumdrumFileSet::HumdrumFileSet(Options& options) {
+	m_threads = 1;
 	read(options);
 }
 
 HumdrumFileSet::HumdrumFileSet(const string& contents) {
+	m_threads = 1;
 	readString(contents);
 }
 
@@ -29687,6 +35831,7 @@ void HumdrumFileSet::clear(void) {
 		m_data[i] = NULL;
 	}
 	m_data.resize(0);
+	m_parseErrors.clear();
 }
 
 
@@ -29702,6 +35847,7 @@ void HumdrumFileSet::clearNoFree(void) {
 		m_data[i] = NULL;
 	}
 	m_data.resize(0);
+	m_parseErrors.clear();
 }
 
 
@@ -29784,6 +35930,11 @@ int HumdrumFileSet::read(HumdrumFileStream& instream) {
 	return readAppend(instream);
 }
 
+int HumdrumFileSet::readParallel(const vector<string>& filenames) {
+	clear();
+	return readAppendParallel(filenames);
+}
+
 
 
 
@@ -29798,12 +35949,14 @@ int HumdrumFileSet::readAppendFile(const string& filename) {
 	indata.open(filename);
 	string contents((istreambuf_iterator<char>(indata)), istreambuf_iterator<char>());
 	HumdrumFileStream instream(contents);
+	instream.setReadAnalyses(m_readAnalyses);
 	return readAppend(instream);
 }
 
 
 int HumdrumFileSet::readAppendString(const string& contents) {
 	HumdrumFileStream instream(contents);
+	instream.setReadAnalyses(m_readAnalyses);
 	return readAppend(instream);
 }
 
@@ -29816,12 +35969,19 @@ int HumdrumFileSet::readAppendStringCsv(const string& contents) {
 int HumdrumFileSet::readAppend(istream& inStream) {
 	string contents((istreambuf_iterator<char>(inStream)), istreambuf_iterator<char>());
 	HumdrumFileStream instream(contents);
+	instream.setReadAnalyses(m_readAnalyses);
 	return readAppend(instream);
 }
 
 
 int HumdrumFileSet::readAppend(Options& options) {
+	if ((m_threads != 1) && (options.getArgCount() > 1)) {
+		vector<string> filenames;
+		options.getArgList(filenames);
+		return readAppendParallel(filenames);
+	}
 	HumdrumFileStream instream(options);
+	instream.setReadAnalyses(m_readAnalyses);
 	return readAppend(instream);
 }
 
@@ -29859,6 +36019,160 @@ int HumdrumFileSet::appendHumdrumPointer(HumdrumFile* infile) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileSet::readAppendParallel -- Read and analyze a list of files
+//    using a pool of threads (see setThreadCount()), and then add their
+//    segments to the end of the set in the order of the filenames.
+//    Returns the total number of segments in the set.  Each file is read
+//    with its own HumdrumFileStream, so universal comments in one file are
+//    not applied to the next file as they are when reading sequentially.
+//    A file that cannot be opened or that fails to parse does not stop
+//    the other files from being read: parse errors are printed in file
+//    order after all files have been read, and all problems are stored
+//    for getParseErrors().  Each file is given the analyses selected with
+//    setReadAnalyses(), as when the files are read one at a time.
+//
+
+int HumdrumFileSet::readAppendParallel(const vector<string>& filenames) {
+	int count = (int)filenames.size();
+	vector<vector<HumdrumFile*>> segments(count);
+	vector<string> errors(count);
+
+	unsigned analyses = m_readAnalyses;
+	auto readFile = [&filenames, &segments, &errors, analyses](int index) {
+		vector<HumdrumFile*>& output = segments[index];
+		HumdrumFile* pfile = NULL;
+		try {
+			HumdrumFileStream instream(vector<string>(1, filenames[index]));
+			instream.setReadAnalyses(analyses);
+			pfile = new HumdrumFile;
+			pfile->setQuietParsing();
+			while (instream.read(*pfile)) {
+				output.push_back(pfile);
+				pfile = new HumdrumFile;
+				pfile->setQuietParsing();
+			}
+			delete pfile;
+			if (output.empty()) {
+				errors[index] = filenames[index] + ": cannot read file";
+			}
+		} catch (const std::exception& e) {
+			delete pfile;
+			for (int i=0; i<(int)output.size(); i++) {
+				delete output[i];
+			}
+			output.clear();
+			errors[index] = filenames[index] + ": " + e.what();
+		}
+	};
+
+	int threads = m_threads;
+	if (threads <= 0) {
+		threads = HumThreadPool::getHardwareThreadCount();
+	}
+	if (threads > count) {
+		threads = count;
+	}
+	if (threads <= 1) {
+		for (int i=0; i<count; i++) {
+			readFile(i);
+		}
+	} else {
+		HumThreadPool pool(threads);
+		for (int i=0; i<count; i++) {
+			pool.submit([&readFile, i]() { readFile(i); });
+		}
+		pool.wait();
+	}
+
+	for (int i=0; i<count; i++) {
+		for (int j=0; j<(int)segments[i].size(); j++) {
+			HumdrumFile* pfile = segments[i][j];
+			pfile->setNoisyParsing();
+			if (!pfile->isValid()) {
+				m_parseErrors.push_back(pfile->getFilename() + ": "
+						+ pfile->getParseError());
+			}
+			m_data.push_back(pfile);
+		}
+		if (!errors[i].empty()) {
+			cerr << errors[i] << endl;
+			m_parseErrors.push_back(errors[i]);
+		}
+	}
+	return (int)m_data.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::setThreadCount -- Set the number of threads used to
+//    read files with readParallel() and readAppendParallel().  This also
+//    applies to read(Options&) when more than one filename is given.
+//    A count of 1 (the default) reads the files one at a time, and a
+//    count of 0 uses one thread for each hardware thread.
+//
+
+void HumdrumFileSet::setThreadCount(int count) {
+	m_threads = count < 0 ? 0 : count;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::getThreadCount -- Return the number of threads used to
+//    read files in parallel.
+//
+
+int HumdrumFileSet::getThreadCount(void) {
+	return m_threads;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::setReadAnalyses -- Set the analyses (a bit mask of
+//    HumFileAnalysis types) which are done on each file read by the set,
+//    whether the files are read one at a time or in parallel.  The
+//    default is 0, which only reads the spine structure; any other
+//    analysis is then done when it is first needed.  Streams given to
+//    readAppend(HumdrumFileStream&) use their own read analyses.
+//
+
+void HumdrumFileSet::setReadAnalyses(unsigned mask) {
+	m_readAnalyses = mask;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::getReadAnalyses -- Return the analyses which are done
+//    on each file read by the set.
+//
+
+unsigned HumdrumFileSet::getReadAnalyses(void) const {
+	return m_readAnalyses;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::getParseErrors -- Return the problems found in files
+//    read by readParallel() or readAppendParallel(), in file order.
+//
+
+vector<string> HumdrumFileSet::getParseErrors(void) {
+	return m_parseErrors;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileSet::hasFilters -- Returns true if has any
@@ -30011,6 +36325,7 @@ void HumdrumFileStream::clear(void) {
 	m_newfilebuffer.resize(0);
 	// m_stringbuffer.clear(0);
 	m_stringbuffer.str("");
+	resetInput();
 }
 
 
@@ -30093,6 +36408,32 @@ int HumdrumFileStream::readSingleSegment(HumdrumFileSet& infiles) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStream::setReadAnalyses -- Set the analyses (a bit mask of
+//     HumFileAnalysis types) which are done on each file after it is
+//     read.  The default is 0, which only reads the spine structure;
+//     any other analysis is then done when it is first needed.
+//
+
+void HumdrumFileStream::setReadAnalyses(unsigned mask) {
+	m_readAnalyses = mask;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::getReadAnalyses -- Return the analyses which are
+//     done on each file after it is read.
+//
+
+unsigned HumdrumFileStream::getReadAnalyses(void) const {
+	return m_readAnalyses;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStream::eof -- returns true if there is no more segements
@@ -30108,7 +36449,7 @@ int HumdrumFileStream::eof(void) {
 	// (3) cin if no ifstream open and no filenames
 
 	// (1) Is an ifstream open?, then yes, there is more data to read.
-	if (m_instream.is_open() && !m_instream.eof()) {
+	if (m_instream.is_open() && !isInputEof(m_instream)) {
 		return 0;
 	}
 
@@ -30128,7 +36469,7 @@ int HumdrumFileStream::eof(void) {
 			// but only read from cin if no files have previously been read
 			newinput = &cin;
 		}
-		if ((newinput != NULL) && newinput->eof()) {
+		if ((newinput != NULL) && isInputEof(*newinput)) {
 			return 1;
 		}
 	}
@@ -30152,16 +36493,14 @@ int HumdrumFileStream::getFile(HumdrumFile& infile) {
 
 restarting:
 
-	stringstream buffer;
-	string templine;
-	if (!m_newfilebuffer.empty()) {
-		buffer << m_newfilebuffer << endl;
-		m_newfilebuffer = "";
-	}
+	// A line that ended the previous segment and which starts this one:
+	m_carry = m_newfilebuffer;
+	m_newfilebuffer.clear();
+	m_lineranges.clear();
 
 	newinput = NULL;
 
-	if (m_urlbuffer.eof()) {
+	if (isInputEof(m_urlbuffer)) {
 		// If the URL buffer is at its end, clear the buffer.
 		m_urlbuffer.str("");
 	}
@@ -30178,7 +36517,7 @@ restarting:
 	}
 
 	// (2) Is an ifstream open?
-	else if (m_instream.is_open() && !m_instream.eof()) {
+	else if (m_instream.is_open() && !isInputEof(m_instream)) {
 		newinput = &m_instream;
 	}
 
@@ -30196,6 +36535,9 @@ restarting:
 		if (m_instream.is_open()) {
 			m_instream.close();
 		}
+		if (m_inputstream == &m_instream) {
+			resetInput();
+		}
 		if (m_filelist[m_curfile].find("://") != string::npos) {
 			// The next file to read is a URL/URI, so buffer the
 			// data from the internet and start reading that instead
@@ -30224,29 +36566,6 @@ restarting:
 		}
 	}
 
-	// At this point the newinput istream is set to read from the given
-	// file or from standard input, so start reading Humdrum content.
-	// If there is "m_newfilebuffer" content, then set the filename of the
-	// HumdrumFile to that value.
-
-	if (m_newfilebuffer.size() > 0) {
-		// store the filename for the current HumdrumFile being read:
-		HumRegex hre;
-		if (hre.search(m_newfilebuffer, R"(^!!!!SEGMENT\s*([+-]?\d+)?\s*:\s*(.*)\s*$)")) {
-			if (hre.getMatchLength(1) > 0) {
-				infile.setSegmentLevel(hre.getMatchInt(1));
-			} else {
-				infile.setSegmentLevel(0);
-			}
-			infile.setFilename(hre.getMatch(2));
-		} else if ((m_curfile >=0) && (m_curfile < (int)m_filelist.size())
-		      && (m_filelist.size() > 0)) {
-			infile.setFilename(m_filelist[m_curfile]);
-		} else {
-			// reading from standard input, but no name.
-		}
-	}
-
 	if (newinput == NULL) {
 		// something strange happened, or no more files to read.
 		return 0;
@@ -30263,11 +36582,8 @@ restarting:
 	int dataFoundQ = 0;
 	int starstarFoundQ = 0;
 	int starminusFoundQ = 0;
-	if (m_newfilebuffer.size() < 4) {
-		//searchName = 1;
-	}
 
-	if (newinput->eof()) {
+	if (isInputEof(*newinput)) {
 		if (m_curfile < (int)m_filelist.size()-1) {
 			m_curfile++;
 			goto restarting;
@@ -30278,28 +36594,32 @@ restarting:
 
 	istream& input = *newinput;
 
-	// if the previous line from the last read starts with "**"
-	// then treat it as part of the current file.
-	if ((m_newfilebuffer.size() > 1) && (m_newfilebuffer.compare(0, 2, "**") == 0)) {
-		buffer << m_newfilebuffer << "\n";
-		m_newfilebuffer = "";
-		starstarFoundQ = 1;
-	}
-
-	while (!input.eof()) {
-		getline(input, templine);
-		if (templine.compare(0, strlen("!!!!SEGMENT"), "!!!!SEGMENT") == 0) {
+	// Lines of the segment are stored as offsets from the start of the
+	// segment in m_input, which keeps them until the segment has been
+	// parsed (the segment may be moved to the start of the buffer when
+	// more data is read):
+	if (m_inputstream == &input) {
+		m_inputstart = m_inputpos;
+	}
+
+	size_t linestart;
+	size_t len;
+	const char* templine;
+	while (!isInputEof(input)) {
+		readInputLine(input, linestart, len);
+		templine = m_input.data() + linestart;
+		if ((len >= 11) && (strncmp(templine, "!!!!SEGMENT", 11) == 0)) {
 			// Store the current segment line in the buffer before breaking.
-			if (!buffer.str().empty()) {
-				m_newfilebuffer = templine;
+			if (!m_carry.empty() || !m_lineranges.empty()) {
+				m_newfilebuffer.assign(templine, len);
 				break;
 			}
-			m_newfilebuffer = templine;
+			m_newfilebuffer.assign(templine, len);
 		}
 
-		if (templine.compare(0, 2, "**") == 0) {
+		if ((len >= 2) && (templine[0] == '*') && (templine[1] == '*')) {
 			if (starstarFoundQ == 1) {
-				m_newfilebuffer = templine;
+				m_newfilebuffer.assign(templine, len);
 				// already found a **, so this one is defined as a file
 				// segment.  Exit from the loop and process the previous
 				// content, waiting until the next read to start with
@@ -30309,7 +36629,7 @@ restarting:
 			starstarFoundQ = 1;
 		}
 
-		if (input.eof() && templine.empty()) {
+		if (isInputEof(input) && (len == 0)) {
 			// No more data coming from current stream, so this is
 			// the end of the HumdrumFile.  Break from the while loop
 			// and then store the read contents of the stream in the
@@ -30317,43 +36637,44 @@ restarting:
 			break;
 		}
 
-		int len = (int)templine.length();
-		if ((len > 4) && (templine.compare(0, 4, "!!!!") == 0) &&
+		if ((len > 4) && (strncmp(templine, "!!!!", 4) == 0) &&
 		    (templine[4] != '!') &&
 		    (dataFoundQ == 0) &&
-		    (templine.compare(0, strlen("!!!!filter:"), "!!!!filter:") != 0) &&
-		    (templine.compare(0, strlen("!!!!SEGMENT:"), "!!!!SEGMENT:") != 0)) {
+		    !((len >= 11) && (strncmp(templine, "!!!!filter:", 11) == 0)) &&
+		    !((len >= 12) && (strncmp(templine, "!!!!SEGMENT:", 12) == 0))) {
 			// This is a universal comment.  Should it be appended
 			// to the list or should the current list be erased and
 			// this record placed into the first entry?
 			if (foundUniversalQ) {
 				// already found a previous universal, so append.
-				m_universals.push_back(templine);
+				m_universals.emplace_back(templine, len);
 			} else {
 				// new universal comment, to delete all previous
 				// universal comments and store this one.
 				m_universals.reserve(1000);
 				m_universals.resize(1);
-				m_universals[0] = templine;
+				m_universals[0].assign(templine, len);
 				foundUniversalQ = 1;
 			}
 			continue;
 		}
 
-		if (templine.compare(0, 2, "*-") == 0) {
+		if ((len >= 2) && (templine[0] == '*') && (templine[1] == '-')) {
 			starminusFoundQ = 1;
 		}
 
-		if (((starminusFoundQ == 1) || (starstarFoundQ == 0)) && (templine[0] != '*') && (templine[0] != '!')) {
-			if ((!templine.empty()) && (templine[0] != ' ')) {
+		char first = len ? templine[0] : '\0';
+		if (((starminusFoundQ == 1) || (starstarFoundQ == 0)) && (first != '*') && (first != '!')) {
+			if ((len > 0) && (first != ' ')) {
+				string filename(templine, len);
 				int found = 0;
 				for (int mm = 0; mm < (int)m_filelist.size(); mm++) {
-					if (m_filelist[mm] == templine) {
+					if (m_filelist[mm] == filename) {
 						found = 1;
 					}
 				}
 				if (!found) {
-					m_filelist.push_back(templine);
+					m_filelist.push_back(filename);
 					// addedFilename = 1;
 				}
 				continue;
@@ -30363,39 +36684,38 @@ restarting:
 		dataFoundQ = 1; // found something other than universal comments
 
 		// store the data line for later parsing into HumdrumFile record:
-		buffer << templine << "\n";
+		m_lineranges.emplace_back(linestart - m_inputstart, len);
 	}
 
-/*
-	if (dataFoundQ == 0) {
-		// never found anything for some strange reason.
-		if (addedFilename) {
-			goto restarting;
-		}
-		return 0;
-	}
-*/
-
 	// Arriving here means that reading of the data stream is complete.
-	// The string stream variable "buffer" contains the HumdrumFile
-	// content, so send it to the HumdrumFile variable.  Also, prepend
-	// Universal comments (demoted into Global comments) at the start
-	// of the data stream (maybe allow for postpending Universal comments
-	// in the future).
-	stringstream contents;
-	contents.str(""); // empty any contents in buffer
-	contents.clear(); // reset error flags in buffer
-
+	// The lines of the segment are parsed directly from the input
+	// buffer into the HumdrumFile.  Universal comments (demoted into
+	// Global comments) are placed at the start of the data (maybe allow
+	// for postpending Universal comments in the future), followed by any
+	// line carried over from the previous segment.
+	vector<pair<const char*, size_t>> lines;
+	lines.reserve(m_universals.size() + 1 + m_lineranges.size());
 	for (int i=0; i < (int)m_universals.size(); i++) {
 		if (m_universals[i].compare(0, 11, "!!!!filter:") == 0) {
 			continue;
 		}
-		contents << &(m_universals[i][1]) << "\n";
+		lines.emplace_back(m_universals[i].data() + 1, m_universals[i].size() - 1);
+	}
+	if (!m_carry.empty()) {
+		lines.emplace_back(m_carry.data(), m_carry.size());
+	}
+	const char* segment = m_input.data() + m_inputstart;
+	for (int i=0; i<(int)m_lineranges.size(); i++) {
+		lines.emplace_back(segment + m_lineranges[i].first,
+				m_lineranges[i].second);
 	}
 
-	contents << buffer.str();
 	string oldfilename = infile.getFilename();
-	infile.readNoRhythm(contents);
+	unsigned analyses = infile.getReadAnalyses();
+	infile.setReadAnalyses(m_readAnalyses);
+	infile.readLines(lines);
+	infile.analyzeForRead();
+	infile.setReadAnalyses(analyses);
 	string newfilename = infile.getFilename();
 	if (newfilename.empty() && !oldfilename.empty()) {
 		infile.setFilename(oldfilename);
@@ -30407,6 +36727,111 @@ restarting:
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStream::resetInput -- Empty the input buffer, such as when
+//    the input stream is switched to a new file.
+//
+
+void HumdrumFileStream::resetInput(void) {
+	m_inputstream = NULL;
+	m_inputstart  = 0;
+	m_inputpos    = 0;
+	m_inputend    = 0;
+	m_inputeof    = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::isInputEof -- Returns true if all lines have been
+//    read from the input stream.  The stream itself may reach its end
+//    before then, since data is read from it ahead of the lines which
+//    are parsed.
+//
+
+bool HumdrumFileStream::isInputEof(istream& input) {
+	if (m_inputstream == &input) {
+		return m_inputeof;
+	}
+	return input.eof();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::fillInput -- Read the next chunk of data from the
+//    input stream into the input buffer.  Data before the start of the
+//    current segment is discarded to make room.  Returns false if there is
+//    no more data in the stream.
+//
+
+bool HumdrumFileStream::fillInput(istream& input) {
+	if (!input.good()) {
+		return false;
+	}
+	if (m_inputstart > 0) {
+		size_t count = m_inputend - m_inputstart;
+		if (count > 0) {
+			memmove(&m_input[0], &m_input[m_inputstart], count);
+		}
+		m_inputpos   -= m_inputstart;
+		m_inputend   -= m_inputstart;
+		m_inputstart  = 0;
+	}
+	if (m_input.size() < m_inputend + InputChunkSize) {
+		m_input.resize(std::max(m_inputend + InputChunkSize, 2 * m_input.size()));
+	}
+	input.read(&m_input[m_inputend], InputChunkSize);
+	size_t count = (size_t)input.gcount();
+	m_inputend += count;
+	return count > 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::readInputLine -- Read the next line from the input
+//    buffer, refilling it from the input stream when needed.  The line
+//    is returned as an offset into m_input and a length which does not
+//    include the newline.  Line splitting and the end-of-input state
+//    follow std::getline(), where a final line without a newline is
+//    returned and marks the end of the input.
+//
+
+void HumdrumFileStream::readInputLine(istream& input, size_t& start,
+		size_t& length) {
+	if (m_inputstream != &input) {
+		resetInput();
+		m_inputstream = &input;
+	}
+	size_t searchpos = m_inputpos;
+	while (true) {
+		const char* data = m_input.data();
+		const char* newline = (const char*)memchr(data + searchpos, '\n',
+				m_inputend - searchpos);
+		if (newline) {
+			start = m_inputpos;
+			length = (newline - data) - start;
+			m_inputpos = start + length + 1;
+			return;
+		}
+		searchpos = m_inputend - m_inputpos;
+		if (!fillInput(input)) {
+			start = m_inputpos;
+			length = m_inputend - m_inputpos;
+			m_inputpos = m_inputend;
+			m_inputeof = true;
+			return;
+		}
+		searchpos += m_inputpos;
+	}
+}
+
+
 
 //////////////////////////////
 //
@@ -30418,6 +36843,9 @@ void HumdrumFileStream::fillUrlBuffer(stringstream& uribuffer,
 	#ifdef USING_URI
 		uribuffer.str(""); // empty any contents in buffer
 		uribuffer.clear(); // reset error flags in buffer
+		if (m_inputstream == &uribuffer) {
+			resetInput();
+		}
 		string webaddress = HumdrumFileBase::getUriToUrlMapping(uriname);
 		HumdrumFileBase::readStringFromHttpUri(uribuffer, webaddress);
 	#endif
@@ -30427,6 +36855,1376 @@ void HumdrumFileStream::fillUrlBuffer(stringstream& uribuffer,
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStructure::editLines -- Replace count lines starting at
+//     index with the given lines (a count of 0 inserts lines, and an
+//     empty list of lines deletes them), and update the analyses of the
+//     file.  When the edit does not change the spine structure of the
+//     file, the tokens of the new lines are linked to the lines around
+//     them, and the strand, null-token, strophe, duration, timing and
+//     measure information is updated only around the edit, with the
+//     times of the following lines moved if the edit changes the
+//     duration of the music.  Edits that add or remove exclusive
+//     interpretations or spine manipulators, change the number of
+//     fields on a line, add or remove strophe markers, layout parameters
+//     or RDF signifiers, or are done on files with analyses from
+//     HumdrumFileContent (such as slurs or ties) cause the entire file
+//     to be re-analyzed.  Returns false if the file is not valid after
+//     the edit.
+//
+
+bool HumdrumFileStructure::editLines(int index, int count,
+		const vector<string>& lines) {
+	m_lastEditIncremental = false;
+	if ((index < 0) || (index > getLineCount())) {
+		return isValid();
+	}
+	if (count < 0) {
+		count = 0;
+	}
+	if (index + count > getLineCount()) {
+		count = getLineCount() - index;
+	}
+
+	vector<HLp> newlines(lines.size());
+	for (int i=0; i<(int)lines.size(); i++) {
+		newlines[i] = new HumdrumLine(lines[i]);
+		newlines[i]->setOwner(this);
+	}
+
+	if (editLinesLocally(index, count, newlines)) {
+		m_lastEditIncremental = true;
+		return isValid();
+	}
+
+	// Files with parse errors are analyzed again as when they were read:
+	unsigned analyses = isValid() ? m_analyses.m_analyzed : m_readAnalyses;
+	for (int i=index; i<index+count; i++) {
+		delete m_lines[i];
+	}
+	m_lines.erase(m_lines.begin() + index, m_lines.begin() + index + count);
+	m_lines.insert(m_lines.begin() + index, newlines.begin(), newlines.end());
+	return reanalyzeEditedFile(analyses);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editInsertLine -- Insert a line before the given
+//     line index (or at the end of the file if the index is the line
+//     count) and update the analyses.
+//
+
+bool HumdrumFileStructure::editInsertLine(int index, const string& line) {
+	return editLines(index, 0, vector<string>(1, line));
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editDeleteLine -- Delete a line and update the
+//     analyses.
+//
+
+bool HumdrumFileStructure::editDeleteLine(int index) {
+	if ((index < 0) || (index >= getLineCount())) {
+		m_lastEditIncremental = false;
+		return isValid();
+	}
+	return editLines(index, 1, vector<string>());
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editReplaceLine -- Replace the text of a line
+//     and update the analyses.
+//
+
+bool HumdrumFileStructure::editReplaceLine(int index, const string& line) {
+	if ((index < 0) || (index >= getLineCount())) {
+		m_lastEditIncremental = false;
+		return isValid();
+	}
+	return editLines(index, 1, vector<string>(1, line));
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::isLastEditIncremental -- Returns true if the last
+//     edit was analyzed around the edited lines, or false if the entire
+//     file was re-analyzed.
+//
+
+bool HumdrumFileStructure::isLastEditIncremental(void) const {
+	return m_lastEditIncremental;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::reanalyzeEditedFile -- Analyze the spine structure
+//     of the file from the text of its lines, and then redo the given
+//     analyses.
+//
+
+bool HumdrumFileStructure::reanalyzeEditedFile(unsigned analyses) {
+	clearAnalysisInfo();
+	m_strand1d.clear();
+	m_strand2d.clear();
+	m_parseError.clear();
+	m_analyses.clear();
+	if (!analyzeBaseFromLines()) {
+		return isValid();
+	}
+	return requireAnalyses(analyses);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::isLocalEditLine -- Returns true if the line can
+//     be added to or removed from the file without a full re-analysis.
+//
+
+bool HumdrumFileStructure::isLocalEditLine(HumdrumLine& line) {
+	if (line.isSignifier()) {
+		return false;
+	}
+	if (!line.hasSpines()) {
+		return line.find("!!LO:") == string::npos;
+	}
+	if (line.isManipulator()) {
+		return false;
+	}
+	for (int i=0; i<line.getTokenCount(); i++) {
+		HTp token = line.token(i);
+		if (token->isInterpretation()) {
+			if ((*token == "*strophe") || (*token == "*Xstrophe") ||
+					(*token == "*S-") || (token->compare(0, 3, "*S/") == 0)) {
+				return false;
+			}
+		} else if (token->isCommentLocal()) {
+			if (token->find("!LO:") == 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::hasLayoutParameterAbove -- Returns true if there
+//     is a layout parameter before the given line which applies to the
+//     line (or to a line after it if the line is removed).
+//
+
+bool HumdrumFileStructure::hasLayoutParameterAbove(int index) {
+	for (int i=index-1; i>=0; i--) {
+		HumdrumLine& line = *m_lines[i];
+		if (line.isCommentGlobal()) {
+			if (line.find("!!LO:") != string::npos) {
+				return true;
+			}
+			continue;
+		}
+		if (!line.hasSpines()) {
+			continue;
+		}
+		if (line.isCommentLocal()) {
+			for (int j=0; j<line.getTokenCount(); j++) {
+				if (line.token(j)->find("!LO:") == 0) {
+					return true;
+				}
+			}
+			continue;
+		}
+		if (line.isAllNull()) {
+			continue;
+		}
+		break;
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editLinesLocally -- Replace lines in the file
+//     without re-analyzing the entire file.  Returns false without
+//     changing the file if the edit cannot be analyzed locally.
+//
+
+bool HumdrumFileStructure::editLinesLocally(int index, int count,
+		vector<HLp>& newlines) {
+	if (m_lines.empty() || !isValid()) {
+		return false;
+	}
+	if (m_analyses.m_analyzed & ~HumFileAnalysis::ReadDefault) {
+		return false;
+	}
+	bool nulls     = m_analyses.isAnalyzed(HumFileAnalysis::Nulls);
+	bool strophes  = m_analyses.isAnalyzed(HumFileAnalysis::Strophes);
+	bool structure = m_analyses.isAnalyzed(HumFileAnalysis::Structure);
+	bool rhythm    = m_analyses.isAnalyzed(HumFileAnalysis::Rhythm);
+
+	// Mensural durations, **recip timings and the timings of spines which
+	// start after the start of the music are not updated locally:
+	if (structure || rhythm) {
+		for (int i=1; i<(int)m_trackstarts.size(); i++) {
+			if (!m_trackstarts[i] || (*m_trackstarts[i] == "**mens")) {
+				return false;
+			}
+			if (rhythm && (m_trackstarts[i]->getLineIndex() !=
+					m_trackstarts[1]->getLineIndex())) {
+				return false;
+			}
+		}
+	}
+	if (rhythm && (m_trackstarts.size() > 1) && m_trackstarts[1] &&
+			(*m_trackstarts[1] == "**recip")) {
+		return false;
+	}
+
+	vector<HLp> oldspined;
+	vector<HLp> newspined;
+	bool barlines = (index == 0);
+	bool data = false;
+	for (int i=index; i<index+count; i++) {
+		if (!isLocalEditLine(*m_lines[i])) {
+			return false;
+		}
+		if (m_lines[i]->hasSpines()) {
+			oldspined.push_back(m_lines[i]);
+		}
+		barlines |= m_lines[i]->isBarline();
+		data |= m_lines[i]->isData();
+	}
+	for (int i=0; i<(int)newlines.size(); i++) {
+		if (!isLocalEditLine(*newlines[i])) {
+			return false;
+		}
+		if (newlines[i]->hasSpines()) {
+			newspined.push_back(newlines[i]);
+		}
+		barlines |= newlines[i]->isBarline();
+		data |= newlines[i]->isData();
+	}
+	if (hasLayoutParameterAbove(index)) {
+		return false;
+	}
+
+	// Data added or removed before the first barline can change the
+	// pickup measure:
+	if (data && !barlines && rhythm) {
+		int firstbar = -1;
+		for (int i=0; i<(int)m_barlines.size(); i++) {
+			if (m_barlines[i]->isBarline()) {
+				firstbar = m_barlines[i]->getLineIndex();
+				break;
+			}
+		}
+		barlines = (firstbar < 0) || (index <= firstbar);
+	}
+
+	bool spined = !(oldspined.empty() && newspined.empty());
+	int pindex = index - 1;
+	while ((pindex >= 0) && !m_lines[pindex]->hasSpines()) {
+		pindex--;
+	}
+	int nindex = index + count;
+	while ((nindex < (int)m_lines.size()) && !m_lines[nindex]->hasSpines()) {
+		nindex++;
+	}
+	HLp next = nindex < (int)m_lines.size() ? m_lines[nindex] : NULL;
+	int width = 0;
+	if (spined) {
+		if ((pindex < 0) || !next) {
+			return false;
+		}
+		width = next->getTokenCount();
+		for (int i=0; i<(int)newspined.size(); i++) {
+			if (newspined[i]->getTokenCount() != width) {
+				return false;
+			}
+		}
+	}
+
+	// Collect the links to the edited lines, and the tokens between the
+	// non-null data tokens before and after the edit in each spine:
+	vector<HTp> oldfirst(width);
+	vector<HTp> newfirst(width);
+	vector<vector<HTp>> previous(width);
+	for (int j=0; j<width; j++) {
+		oldfirst[j] = oldspined.empty() ? next->token(j) : oldspined[0]->token(j);
+		newfirst[j] = newspined.empty() ? next->token(j) : newspined[0]->token(j);
+		previous[j].assign(oldfirst[j]->m_previousTokens.begin(),
+				oldfirst[j]->m_previousTokens.end());
+	}
+	bool fullnonnull = false;
+	vector<vector<HTp>> before(width);
+	vector<vector<HTp>> after(width);
+	vector<HTp> prevnonnull(width, NULL);
+	vector<HTp> nextnonnull(width, NULL);
+	vector<bool> reach(width, false);
+	if (rhythm) {
+		for (int j=0; j<width; j++) {
+			bool state = false;
+			if (!getNonNullEditContext(oldfirst[j], next, j, oldspined, newspined,
+					before[j], after[j], prevnonnull[j], nextnonnull[j], state)) {
+				fullnonnull = true;
+				break;
+			}
+			reach[j] = state;
+		}
+	}
+
+	// Link the new lines into the spines:
+	for (int j=0; j<width; j++) {
+		for (HTp token : previous[j]) {
+			for (int k=0; k<(int)token->m_nextTokens.size(); k++) {
+				if (token->m_nextTokens[k] == oldfirst[j]) {
+					token->m_nextTokens[k] = newfirst[j];
+				}
+			}
+		}
+		newfirst[j]->m_previousTokens.assign(previous[j].begin(), previous[j].end());
+		for (int i=1; i<(int)newspined.size(); i++) {
+			HTp first = newspined[i-1]->token(j);
+			HTp second = newspined[i]->token(j);
+			first->m_nextTokens.assign(1, second);
+			second->m_previousTokens.assign(1, first);
+		}
+		if (!newspined.empty()) {
+			HTp last = newspined.back()->token(j);
+			last->m_nextTokens.assign(1, next->token(j));
+			next->token(j)->m_previousTokens.assign(1, last);
+		}
+		for (int k=0; k<(int)m_strand1d.size(); k++) {
+			if (m_strand1d[k].first == oldfirst[j]) {
+				m_strand1d[k].first = newfirst[j];
+			}
+		}
+		for (int t=0; t<(int)m_strand2d.size(); t++) {
+			for (int k=0; k<(int)m_strand2d[t].size(); k++) {
+				if (m_strand2d[t][k].first == oldfirst[j]) {
+					m_strand2d[t][k].first = newfirst[j];
+				}
+			}
+		}
+	}
+
+	for (int i=index; i<index+count; i++) {
+		delete m_lines[i];
+	}
+	m_lines.erase(m_lines.begin() + index, m_lines.begin() + index + count);
+	m_lines.insert(m_lines.begin() + index, newlines.begin(), newlines.end());
+	int last = (count == (int)newlines.size()) ? index + count : (int)m_lines.size();
+	for (int i=index; i<last; i++) {
+		m_lines[i]->setLineIndex(i);
+	}
+
+	// The new tokens are in the same track, subspine and strand as the
+	// tokens on the next line:
+	for (int i=0; i<(int)newlines.size(); i++) {
+		HumdrumLine& line = *newlines[i];
+		line.m_rhythm_analyzed = rhythm;
+		if (!line.hasSpines()) {
+			line.token(0)->setFieldIndex(0);
+			line.token(0)->setDataTypeId(HumDataType::None);
+			continue;
+		}
+		for (int j=0; j<width; j++) {
+			line.token(j)->copyStructure(next->token(j));
+			line.token(j)->m_rhycheck = next->token(j)->m_rhycheck;
+		}
+		if (structure) {
+			line.analyzeTokenDurations(m_parseError);
+		}
+	}
+
+	if (spined && strophes) {
+		bool interpretations = true;
+		for (HLp line : oldspined) {
+			interpretations &= line->isInterpretation();
+		}
+		for (HLp line : newspined) {
+			interpretations &= line->isInterpretation();
+		}
+		if (!updateEditedStrophes(next, newspined, interpretations)) {
+			reanalyzeEditedStrophes();
+		}
+	}
+
+	if (spined && nulls) {
+		if (!updateEditedNulls(next, newspined)) {
+			for (int i=0; i<(int)m_lines.size(); i++) {
+				for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+					m_lines[i]->token(j)->m_nullresolve = NULL;
+				}
+			}
+			m_analyses.setAnalyzed(HumFileAnalysis::Nulls, false);
+			resolveNullTokens();
+		}
+	}
+
+	if (!rhythm) {
+		return true;
+	}
+	if (!updateEditedRhythm(index, (int)newlines.size(), next, newspined,
+			spined, barlines)) {
+		reanalyzeEditedRhythm();
+		return true;
+	}
+
+	if (fullnonnull) {
+		for (int i=0; i<(int)m_lines.size(); i++) {
+			for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+				m_lines[i]->token(j)->m_previousNonNullTokens.clear();
+				m_lines[i]->token(j)->m_nextNonNullTokens.clear();
+			}
+		}
+		analyzeNonNullDataTokens();
+	} else {
+		for (int j=0; j<width; j++) {
+			vector<HTp> tokens(before[j].rbegin(), before[j].rend());
+			for (HLp line : newspined) {
+				tokens.push_back(line->token(j));
+			}
+			tokens.insert(tokens.end(), after[j].begin(), after[j].end());
+			linkNonNullDataTokens(tokens, prevnonnull[j], nextnonnull[j], reach[j]);
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::getNonNullEditContext -- Find the non-null data
+//     tokens before and after the edited lines in a spine (first is the
+//     first token of the edit, or the token on the next line if lines
+//     are only deleted), and the tokens between them and the edit.
+//     Also find if the non-data tokens between them are linked to the
+//     following non-null data token (reach).  Returns false if the
+//     tokens cannot be found without crossing spine manipulators.
+//
+
+bool HumdrumFileStructure::getNonNullEditContext(HTp first, HLp next,
+		int field, vector<HLp>& oldlines, vector<HLp>& newlines,
+		vector<HTp>& before, vector<HTp>& after, HTp& previous,
+		HTp& following, bool& reach) {
+	before.clear();
+	after.clear();
+	previous = NULL;
+	following = NULL;
+	reach = false;
+	bool known = false;
+
+	if (first->m_previousTokens.size() != 1) {
+		return false;
+	}
+	HTp token = first->m_previousTokens[0];
+	while (token) {
+		if (token->isData() && !token->isNull()) {
+			// After a spine merge the token before a merged spine can also
+			// be linked to the next non-null data token:
+			if (token->m_previousTokens.size() > 1) {
+				return false;
+			}
+			// The tokens before a spine split are also linked to the first
+			// non-null data token after the split and to the token after it:
+			HTp up = token;
+			while (up->m_previousTokens.size() == 1) {
+				up = up->m_previousTokens[0];
+				if (up->isData() && !up->isNull()) {
+					break;
+				}
+				if (up->isManipulator() && !up->isExclusiveInterpretation()) {
+					return false;
+				}
+			}
+			previous = token;
+			break;
+		}
+		if (token->isManipulator()) {
+			if (!token->isExclusiveInterpretation() || !token->m_previousTokens.empty()) {
+				return false;
+			}
+			before.push_back(token);
+			break;
+		}
+		before.push_back(token);
+		if (token->m_previousTokens.size() != 1) {
+			return false;
+		}
+		token = token->m_previousTokens[0];
+	}
+
+	token = next->token(field);
+	while (token) {
+		if (token->isData() && !token->isNull()) {
+			following = token;
+			break;
+		}
+		if (token->isManipulator() || (token->m_nextTokens.size() != 1)) {
+			return false;
+		}
+		after.push_back(token);
+		token = token->m_nextTokens[0];
+	}
+	if (!following) {
+		return false;
+	}
+
+	vector<HTp> tokens(before);
+	tokens.insert(tokens.end(), after.begin(), after.end());
+	for (HLp line : oldlines) {
+		tokens.push_back(line->token(field));
+	}
+	for (HTp tok : tokens) {
+		if (!tok->isData()) {
+			reach = !tok->m_nextNonNullTokens.empty();
+			known = true;
+			break;
+		}
+	}
+	if (!known) {
+		for (HLp line : newlines) {
+			if (!line->token(field)->isData()) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::linkNonNullDataTokens -- Set the previous and
+//     next non-null data tokens of a list of tokens in a spine which
+//     are between two non-null data tokens (previous is NULL if the
+//     list starts with the exclusive interpretation of the spine).
+//     Non-data tokens are linked to the next non-null data token only if
+//     the spine can be followed backwards to them from its end (reach).
+//
+
+void HumdrumFileStructure::linkNonNullDataTokens(vector<HTp>& tokens,
+		HTp previous, HTp following, bool reach) {
+	HTp current = previous;
+	for (HTp token : tokens) {
+		token->m_previousNonNullTokens.clear();
+		if (current) {
+			token->m_previousNonNullTokens.push_back(current);
+		}
+		if (token->isData() && !token->isNull()) {
+			current = token;
+		}
+	}
+	following->m_previousNonNullTokens.clear();
+	if (current) {
+		following->m_previousNonNullTokens.push_back(current);
+	}
+
+	current = following;
+	for (int i=(int)tokens.size()-1; i>=0; i--) {
+		HTp token = tokens[i];
+		token->m_nextNonNullTokens.clear();
+		if (token->isData() || reach) {
+			token->m_nextNonNullTokens.push_back(current);
+		}
+		if (token->isData() && !token->isNull()) {
+			current = token;
+		}
+	}
+	if (previous) {
+		previous->m_nextNonNullTokens.clear();
+		previous->m_nextNonNullTokens.push_back(current);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::getStrandPredecessor -- Return the token before
+//     the given one in its strand, or NULL if the token starts a strand.
+//
+
+HTp HumdrumFileStructure::getStrandPredecessor(HTp token) {
+	int strand = token->getStrandIndex();
+	if ((strand >= 0) && (strand < (int)m_strand1d.size()) &&
+			(m_strand1d[strand].first == token)) {
+		return NULL;
+	}
+	for (HTp previous : token->m_previousTokens) {
+		if (!previous->m_nextTokens.empty() && (previous->m_nextTokens[0] == token)) {
+			return previous;
+		}
+	}
+	return NULL;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::updateEditedNulls -- Resolve the null data tokens
+//     on the new lines and the null tokens after them which resolved to
+//     tokens on the old lines.  Returns false if a full resolution of
+//     null tokens is needed.
+//
+
+bool HumdrumFileStructure::updateEditedNulls(HLp next, vector<HLp>& newlines) {
+	for (int j=0; j<next->getTokenCount(); j++) {
+		HTp first = newlines.empty() ? next->token(j) : newlines[0]->token(j);
+		HTp data = NULL;
+		HTp token = getStrandPredecessor(first);
+		while (token) {
+			if (token->isData()) {
+				data = token->isNull() ? token->m_nullresolve : token;
+				break;
+			}
+			token = getStrandPredecessor(token);
+		}
+		if (!data) {
+			return false;
+		}
+		for (HLp line : newlines) {
+			token = line->token(j);
+			if (!token->isData()) {
+				continue;
+			}
+			if (token->isNull()) {
+				token->setNullResolution(data);
+			} else {
+				data = token;
+			}
+		}
+		token = next->token(j);
+		while (token) {
+			if (token->isManipulator()) {
+				return false;
+			}
+			if (token->isData()) {
+				if (!token->isNull()) {
+					break;
+				}
+				token->setNullResolution(data);
+			}
+			token = token->getNextToken();
+		}
+		if (!token) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::updateEditedStrophes -- Assign the strophes of the
+//     tokens on the new lines.  Returns false if the edit can change
+//     which strophe starts are found at the starts of strands, in which
+//     case the strophes need to be analyzed again.  The interpretations
+//     parameter is true if all of the old and new spined lines are
+//     interpretations.
+//
+
+bool HumdrumFileStructure::updateEditedStrophes(HLp next,
+		vector<HLp>& newlines, bool interpretations) {
+	for (int j=0; j<next->getTokenCount(); j++) {
+		HTp first = newlines.empty() ? next->token(j) : newlines[0]->token(j);
+		if (first->m_previousTokens.empty()) {
+			return false;
+		}
+		if (!interpretations) {
+			HTp token = getStrandPredecessor(first);
+			while (token && token->isInterpretation()) {
+				token = getStrandPredecessor(token);
+			}
+			if (!token) {
+				return false;
+			}
+		}
+		HTp strophe = NULL;
+		bool found = false;
+		for (HTp previous : first->m_previousTokens) {
+			if (previous->m_nextTokens.empty() || (previous->m_nextTokens[0] != first)) {
+				continue;
+			}
+			if ((*previous == "*Xstrophe") || (*previous == "*S-")) {
+				continue;
+			}
+			if (found && (previous->m_strophe != strophe)) {
+				return false;
+			}
+			strophe = previous->m_strophe;
+			found = true;
+		}
+		for (HLp line : newlines) {
+			line->token(j)->setStrophe(strophe);
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::reanalyzeEditedStrophes -- Analyze the strophes
+//     of the file again.
+//
+
+void HumdrumFileStructure::reanalyzeEditedStrophes(void) {
+	for (int i=0; i<(int)m_lines.size(); i++) {
+		for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+			m_lines[i]->token(j)->setStrophe(NULL);
+		}
+	}
+	m_strophes1d.clear();
+	m_strophes2d.clear();
+	m_analyses.setAnalyzed(HumFileAnalysis::Strophes, false);
+	requireAnalysis(HumFileAnalysis::Strophes);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::isTimedLine -- Returns true if the start time of
+//     the line is set by the rhythm of its tokens rather than by the
+//     lines around it.
+//
+
+bool HumdrumFileStructure::isTimedLine(HumdrumLine& line) {
+	if (!line.hasSpines() || line.isAllRhythmicNull()) {
+		return false;
+	}
+	for (int i=0; i<line.getTokenCount(); i++) {
+		HTp token = line.token(i);
+		if (!token->hasRhythm()) {
+			continue;
+		}
+		if (token->getDuration().isNonNegative()) {
+			return true;
+		}
+		if (token->isTerminateInterpretation() && token->m_nextTokens.empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::getEditStartTime -- Find the start time of a
+//     token in a rhythmic spine from the token with a duration before it.
+//     Returns false if there is no such token, and the spine does not
+//     start at the start of the music.
+//
+
+bool HumdrumFileStructure::getEditStartTime(HTp token, HumNum& time) {
+	HTp current = token;
+	HTp previous = token->m_previousTokens.empty() ? NULL : token->m_previousTokens[0];
+	while (previous) {
+		HumNum duration = previous->getDuration();
+		if (duration.isNonNegative()) {
+			time = previous->getDurationFromStart();
+			if (duration.isPositive()) {
+				time += duration;
+			}
+			return true;
+		}
+		current = previous;
+		previous = current->m_previousTokens.empty() ? NULL : current->m_previousTokens[0];
+	}
+	if ((m_trackstarts.size() > 1) && m_trackstarts[1] &&
+			(current->getLineIndex() == m_trackstarts[1]->getLineIndex())) {
+		time = 0;
+		return true;
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::updateEditedRhythm -- Update the start times and
+//     durations of the lines around the new lines at index (count is the
+//     number of new lines), move the following lines in time if the
+//     duration of the music changed, and update the measure positions of
+//     the lines and the durations of tokens in non-rhythmic spines.
+//     Returns false if the rhythm of the file needs to be analyzed again.
+//
+
+bool HumdrumFileStructure::updateEditedRhythm(int index, int count, HLp next,
+		vector<HLp>& newlines, bool spined, bool barlines) {
+	HumNum delta = 0;
+	vector<HumNum> times(newlines.size(), -1);
+	if (spined) {
+		bool first = true;
+		for (int j=0; j<next->getTokenCount(); j++) {
+			HTp token = next->token(j);
+			if (!token->hasRhythm()) {
+				continue;
+			}
+			HumNum sum;
+			if (!getEditStartTime(newlines.empty() ? token : newlines[0]->token(j), sum)) {
+				return false;
+			}
+			for (int i=0; i<(int)newlines.size(); i++) {
+				HumNum duration = newlines[i]->token(j)->getDuration();
+				if (duration.isNegative()) {
+					continue;
+				}
+				if (times[i].isNegative()) {
+					times[i] = sum;
+				} else if (times[i] != sum) {
+					return false;
+				}
+				if (duration.isPositive()) {
+					sum += duration;
+				}
+			}
+			// Find the next token with a time to measure the change in duration:
+			while (token->getDuration().isNegative()) {
+				if (token->m_nextTokens.empty()) {
+					if (!token->isTerminateInterpretation()) {
+						return false;
+					}
+					break;
+				}
+				token = token->m_nextTokens[0];
+			}
+			HumNum difference = sum - token->getDurationFromStart();
+			if (first) {
+				delta = difference;
+				first = false;
+			} else if (difference != delta) {
+				return false;
+			}
+		}
+		for (int i=0; i<(int)newlines.size(); i++) {
+			if (times[i].isNegative() && newlines[i]->isData() &&
+					!newlines[i]->isAllRhythmicNull()) {
+				return false;
+			}
+		}
+	}
+
+	// The lines with times before and after the new lines:
+	int lo = index - 1;
+	while ((lo >= 0) && !isTimedLine(*m_lines[lo])) {
+		lo--;
+	}
+	bool hasfirst = lo >= 0;
+	if (!hasfirst) {
+		lo = 0;
+	}
+	int hi = index + count;
+	while ((hi < (int)m_lines.size()) && !isTimedLine(*m_lines[hi])) {
+		hi++;
+	}
+	bool haslast = hi < (int)m_lines.size();
+	if (!haslast) {
+		hi = (int)m_lines.size() - 1;
+	}
+
+	vector<HumNum> starts(hi - lo + 1, -1);
+	if (hasfirst) {
+		starts[0] = m_lines[lo]->getDurationFromStart();
+	}
+	for (int i=0; i<(int)newlines.size(); i++) {
+		if (times[i].isNonNegative()) {
+			starts[newlines[i]->getLineIndex() - lo] = times[i];
+		}
+	}
+	if (haslast) {
+		starts.back() = m_lines[hi]->getDurationFromStart() + delta;
+	}
+
+	// Times of null data lines between the lines with times (as in
+	// analyzeNullLineRhythms()):
+	int previous = -1;
+	vector<int> nulllines;
+	for (int i=lo; i<=hi; i++) {
+		HumdrumLine& line = *m_lines[i];
+		if (!line.hasSpines()) {
+			continue;
+		}
+		if (line.isAllRhythmicNull()) {
+			if (line.isData()) {
+				nulllines.push_back(i);
+			}
+			continue;
+		}
+		HumNum start = starts[i - lo];
+		if (start.isNegative()) {
+			if (line.isData()) {
+				return false;
+			}
+			continue;
+		}
+		if (previous >= 0) {
+			HumNum startdur = starts[previous - lo];
+			HumNum nulldur = (start - startdur) / ((int)nulllines.size() + 1);
+			for (int k=0; k<(int)nulllines.size(); k++) {
+				starts[nulllines[k] - lo] = startdur + nulldur * (k+1);
+			}
+		}
+		previous = i;
+		nulllines.clear();
+	}
+
+	// Times of other lines (as in fillInNegativeStartTimes()):
+	HumNum lastdur = -1;
+	for (int i=hi; i>=lo; i--) {
+		HumNum& start = starts[i - lo];
+		if (start.isNegative() && lastdur.isNonNegative()) {
+			start = lastdur;
+		}
+		if (start.isNonNegative()) {
+			lastdur = start;
+		}
+	}
+	lastdur = (lo > 0) ? m_lines[lo-1]->getDurationFromStart() : HumNum(-1);
+	for (int i=lo; i<=hi; i++) {
+		if (starts[i - lo].isNonNegative()) {
+			lastdur = starts[i - lo];
+		} else {
+			starts[i - lo] = lastdur;
+		}
+	}
+
+	for (int i=lo; i<=hi; i++) {
+		m_lines[i]->setDurationFromStart(starts[i - lo]);
+	}
+	if (delta != 0) {
+		for (int i=hi+1; i<(int)m_lines.size(); i++) {
+			m_lines[i]->setDurationFromStart(m_lines[i]->getDurationFromStart() + delta);
+		}
+	}
+	for (int i=(lo > 0 ? lo-1 : 0); i<=hi; i++) {
+		if (i == (int)m_lines.size() - 1) {
+			m_lines[i]->setDuration(0);
+		} else {
+			m_lines[i]->setDuration(m_lines[i+1]->getDurationFromStart() -
+					m_lines[i]->getDurationFromStart());
+		}
+	}
+
+	if (barlines) {
+		m_barlines.clear();
+		bool foundbarline = false;
+		for (int i=0; i<(int)m_lines.size(); i++) {
+			if (m_lines[i]->isBarline()) {
+				foundbarline = true;
+				m_barlines.push_back(m_lines[i]);
+			}
+			if (m_lines[i]->isData() && !foundbarline) {
+				// pickup measure
+				m_barlines.push_back(m_lines[0]);
+				foundbarline = true;
+			}
+		}
+	}
+	analyzeMeterRegion(lo > 0 ? lo-1 : 0, hi);
+
+	if (!updateNonRhythmicDurations(lo, hi)) {
+		analyzeDurationsOfNonRhythmicSpines();
+	}
+	m_ticksperquarternote = -1;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::analyzeMeterRegion -- Set the durations from and
+//     to the barlines for the measures containing the lines from first
+//     to last (as in analyzeMeter()).
+//
+
+void HumdrumFileStructure::analyzeMeterRegion(int first, int last) {
+	int start = first - 1;
+	while ((start >= 0) && !m_lines[start]->isBarline()) {
+		start--;
+	}
+	int stop = last + 1;
+	while ((stop < (int)m_lines.size()) && !m_lines[stop]->isBarline()) {
+		stop++;
+	}
+
+	HumNum sum = 0;
+	for (int i=start+1; i<(int)m_lines.size(); i++) {
+		m_lines[i]->setDurationFromBarline(sum);
+		sum += m_lines[i]->getDuration();
+		if (m_lines[i]->isBarline()) {
+			sum = 0;
+			if (i >= stop) {
+				break;
+			}
+		}
+	}
+
+	sum = 0;
+	for (int i=stop-1; i>=(start > 0 ? start : 0); i--) {
+		sum += m_lines[i]->getDuration();
+		m_lines[i]->setDurationToBarline(sum);
+		if (m_lines[i]->isBarline()) {
+			sum = 0;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::updateNonRhythmicDurations -- Set the durations of
+//     the non-null data tokens in non-rhythmic spines on the lines from
+//     first to last, and of the last such tokens before them.  Returns
+//     false if the durations of the non-rhythmic spines need to be
+//     analyzed again.
+//
+
+bool HumdrumFileStructure::updateNonRhythmicDurations(int first, int last) {
+	for (int i=first; i<=last; i++) {
+		HumdrumLine& line = *m_lines[i];
+		if (!line.hasSpines()) {
+			continue;
+		}
+		for (int j=0; j<line.getTokenCount(); j++) {
+			HTp token = line.token(j);
+			if (token->hasRhythm()) {
+				continue;
+			}
+			if (token->getSpineInfo().find('(') != string::npos) {
+				return false;
+			}
+			if (token->isData() && !token->isNull()) {
+				if (!setNonRhythmicDuration(token)) {
+					return false;
+				}
+			}
+		}
+	}
+
+	int index = first;
+	while ((index <= last) && !m_lines[index]->hasSpines()) {
+		index++;
+	}
+	if (index > last) {
+		return true;
+	}
+	HumdrumLine& line = *m_lines[index];
+	for (int j=0; j<line.getTokenCount(); j++) {
+		HTp token = line.token(j);
+		if (token->hasRhythm()) {
+			continue;
+		}
+		while (!token->m_previousTokens.empty()) {
+			if (token->m_previousTokens.size() != 1) {
+				return false;
+			}
+			token = token->m_previousTokens[0];
+			if (token->isData() && !token->isNull()) {
+				if (!setNonRhythmicDuration(token)) {
+					return false;
+				}
+				break;
+			}
+			if (token->isManipulator() && !token->isExclusiveInterpretation()) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::setNonRhythmicDuration -- Set the duration of a
+//     non-null data token in a non-rhythmic spine to the time until the
+//     next non-null data token or the end of the spine.
+//
+
+bool HumdrumFileStructure::setNonRhythmicDuration(HTp token) {
+	HTp current = token->getNextToken();
+	while (current) {
+		if (current->isData() && !current->isNull()) {
+			break;
+		}
+		if (current->m_nextTokens.empty()) {
+			break;
+		}
+		if (current->isManipulator()) {
+			return false;
+		}
+		current = current->m_nextTokens[0];
+	}
+	if (!current) {
+		return false;
+	}
+	token->setDuration(current->getDurationFromStart() - token->getDurationFromStart());
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::reanalyzeEditedRhythm -- Analyze the rhythm of the
+//     file again.
+//
+
+bool HumdrumFileStructure::reanalyzeEditedRhythm(void) {
+	for (int i=0; i<(int)m_lines.size(); i++) {
+		HumdrumLine& line = *m_lines[i];
+		line.m_duration            = -1;
+		line.m_durationFromStart   = -1;
+		line.m_durationFromBarline = 0;
+		line.m_durationToBarline   = 0;
+		for (int j=0; j<line.getTokenCount(); j++) {
+			line.token(j)->m_rhycheck = 0;
+			line.token(j)->m_previousNonNullTokens.clear();
+			line.token(j)->m_nextNonNullTokens.clear();
+		}
+	}
+	m_barlines.clear();
+	m_ticksperquarternote = -1;
+	m_analyses.setAnalyzed(HumFileAnalysis::Rhythm, false);
+	return requireAnalysis(HumFileAnalysis::Rhythm);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::checkAnalysis -- Compare the analyses of the file
+//     with a full analysis of its text, and print the differences.
+//     Returns true if there are no differences.  Used to test editLines().
+// default value: out = std::cerr
+//
+
+bool HumdrumFileStructure::checkAnalysis(ostream& out) {
+	stringstream text;
+	for (int i=0; i<getLineCount(); i++) {
+		text << (string)*m_lines[i] << '\n';
+	}
+	HumdrumFileStructure reference;
+	reference.setQuietParsing();
+	reference.setReadAnalyses(m_analyses.m_analyzed & HumFileAnalysis::ReadDefault);
+	reference.readString(text.str());
+	return compareAnalysis(reference, out);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::compareAnalysis -- Compare the spine structure
+//     and the analyses done on both files, and print the first
+//     differences.  Tokens are compared by their positions in the files.
+//     Returns true if there are no differences.
+// default value: out = std::cerr
+//
+
+bool HumdrumFileStructure::compareAnalysis(HumdrumFileStructure& reference,
+		ostream& out) {
+	int differences = 0;
+	auto report = [&](int line, int field, const string& message) {
+		if (differences++ < 10) {
+			out << "(" << line + 1 << "," << field + 1 << "): " << message << endl;
+		}
+	};
+	auto positions = [&](const HumTokenLinks& tokens) {
+		string output;
+		for (int i=0; i<(int)tokens.size(); i++) {
+			output += (i ? " " : "") + getEditPosition(tokens[i]);
+		}
+		return output;
+	};
+	auto compare = [&](int line, int field, const string& name,
+			const string& value, const string& expected) {
+		if (value != expected) {
+			report(line, field, name + " \"" + value + "\" instead of \"" + expected + "\"");
+		}
+	};
+	auto number = [](const HumNum& value) {
+		stringstream output;
+		value.printFraction(output);
+		return output.str();
+	};
+
+	if (isValid() != reference.isValid()) {
+		report(-1, -1, string("file is ") + (isValid() ? "" : "not ") + "valid");
+		return false;
+	}
+	if (!isValid()) {
+		return true;
+	}
+	if (getLineCount() != reference.getLineCount()) {
+		compare(-1, -1, "line count", to_string(getLineCount()),
+				to_string(reference.getLineCount()));
+		return false;
+	}
+	unsigned both = m_analyses.m_analyzed & reference.m_analyses.m_analyzed;
+	bool nulls    = both & HumFileAnalysis::getMask(HumFileAnalysis::Nulls);
+	bool strophes = both & HumFileAnalysis::getMask(HumFileAnalysis::Strophes);
+	bool strands  = both & HumFileAnalysis::getMask(HumFileAnalysis::Strands);
+	bool durs     = both & HumFileAnalysis::getMask(HumFileAnalysis::Structure);
+	bool rhythm   = both & HumFileAnalysis::getMask(HumFileAnalysis::Rhythm);
+
+	for (int i=0; i<getLineCount(); i++) {
+		HumdrumLine& line = *m_lines[i];
+		HumdrumLine& refline = *reference.m_lines[i];
+		if ((string)line != (string)refline) {
+			compare(i, -1, "line", line, refline);
+			continue;
+		}
+		compare(i, -1, "line index", to_string(line.getLineIndex()), to_string(i));
+		if (rhythm) {
+			compare(i, -1, "start time", number(line.m_durationFromStart),
+					number(refline.m_durationFromStart));
+			compare(i, -1, "duration", number(line.m_duration),
+					number(refline.m_duration));
+			compare(i, -1, "duration from barline", number(line.m_durationFromBarline),
+					number(refline.m_durationFromBarline));
+			compare(i, -1, "duration to barline", number(line.m_durationToBarline),
+					number(refline.m_durationToBarline));
+		}
+		if (line.getTokenCount() != refline.getTokenCount()) {
+			compare(i, -1, "token count", to_string(line.getTokenCount()),
+					to_string(refline.getTokenCount()));
+			continue;
+		}
+		for (int j=0; j<line.getTokenCount(); j++) {
+			HTp token = line.token(j);
+			HTp reftoken = refline.token(j);
+			compare(i, j, "track", to_string(token->getTrack()) + "." +
+					to_string(token->getSubtrack()), to_string(reftoken->getTrack()) +
+					"." + to_string(reftoken->getSubtrack()));
+			compare(i, j, "spine info", token->getSpineInfo(), reftoken->getSpineInfo());
+			compare(i, j, "field index", to_string(token->getFieldIndex()),
+					to_string(reftoken->getFieldIndex()));
+			compare(i, j, "data type", to_string(token->getDataTypeId()),
+					to_string(reftoken->getDataTypeId()));
+			compare(i, j, "next tokens", positions(token->m_nextTokens),
+					positions(reftoken->m_nextTokens));
+			compare(i, j, "previous tokens", positions(token->m_previousTokens),
+					positions(reftoken->m_previousTokens));
+			if (strands) {
+				compare(i, j, "strand", to_string(token->getStrandIndex()),
+						to_string(reftoken->getStrandIndex()));
+			}
+			if (nulls) {
+				compare(i, j, "null resolution", getEditPosition(token->m_nullresolve),
+						getEditPosition(reftoken->m_nullresolve));
+			}
+			if (strophes) {
+				compare(i, j, "strophe", getEditPosition(token->m_strophe),
+						getEditPosition(reftoken->m_strophe));
+			}
+			if (durs) {
+				compare(i, j, "token duration", number(token->m_duration),
+						number(reftoken->m_duration));
+			}
+			if (rhythm) {
+				compare(i, j, "next non-null tokens",
+						positions(token->m_nextNonNullTokens),
+						positions(reftoken->m_nextNonNullTokens));
+				compare(i, j, "previous non-null tokens",
+						positions(token->m_previousNonNullTokens),
+						positions(reftoken->m_previousNonNullTokens));
+			}
+		}
+	}
+
+	HumTokenLinks tokens;
+	HumTokenLinks reftokens;
+	tokens.assign(m_trackstarts.begin(), m_trackstarts.end());
+	reftokens.assign(reference.m_trackstarts.begin(), reference.m_trackstarts.end());
+	compare(-1, -1, "track starts", positions(tokens), positions(reftokens));
+	tokens.clear();
+	reftokens.clear();
+	for (auto& ends : m_trackends) {
+		tokens.insert(tokens.end(), ends.begin(), ends.end());
+	}
+	for (auto& ends : reference.m_trackends) {
+		reftokens.insert(reftokens.end(), ends.begin(), ends.end());
+	}
+	compare(-1, -1, "track ends", positions(tokens), positions(reftokens));
+	if (strands) {
+		tokens.clear();
+		reftokens.clear();
+		for (auto& strand : m_strand1d) {
+			tokens.push_back(strand.first);
+			tokens.push_back(strand.last);
+		}
+		for (auto& strand : reference.m_strand1d) {
+			reftokens.push_back(strand.first);
+			reftokens.push_back(strand.last);
+		}
+		compare(-1, -1, "strands", positions(tokens), positions(reftokens));
+	}
+	if (rhythm) {
+		string lines;
+		string reflines;
+		for (HLp line : m_barlines) {
+			lines += " " + to_string(line->getLineIndex());
+		}
+		for (HLp line : reference.m_barlines) {
+			reflines += " " + to_string(line->getLineIndex());
+		}
+		compare(-1, -1, "barlines", lines, reflines);
+	}
+	return differences == 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::getEditPosition -- Return the line and field
+//     number of a token, or "-" for NULL.
+//
+
+string HumdrumFileStructure::getEditPosition(HTp token) {
+	if (!token) {
+		return "-";
+	}
+	return to_string(token->getLineIndex() + 1) + ":" + to_string(token->getFieldIndex() + 1);
+}
+
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStructure::analyzeStropheMarkers -- Merge this
@@ -30434,7 +38232,7 @@ void HumdrumFileStream::fillUrlBuffer(stringstream& uribuffer,
 //
 
 void HumdrumFileStructure::analyzeStropheMarkers(void) {
-	m_analyses.m_strophes_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Strophes);
 
 	m_strophes1d.clear();
 	m_strophes2d.clear();
@@ -30504,9 +38302,7 @@ void HumdrumFileStructure::analyzeStropheMarkers(void) {
 //
 
 bool HumdrumFileStructure::analyzeStrophes(void) {
-	if (!m_analyses.m_strands_analyzed) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	analyzeStropheMarkers();
 
 	int scount = (int)m_strand1d.size();
@@ -30601,11 +38397,13 @@ bool HumdrumFileStructure::analyzeStrophes(void) {
 //
 
 int HumdrumFileStructure::getStropheCount(void) {
+	requireAnalysis(HumFileAnalysis::Strophes);
 	return (int)m_strophes1d.size();
 }
 
 
 int HumdrumFileStructure::getStropheCount(int spineindex) {
+	requireAnalysis(HumFileAnalysis::Strophes);
 	if ((spineindex < 0) || (spineindex >= (int)m_strophes2d.size())) {
 		return 0;
 	}
@@ -30620,6 +38418,7 @@ int HumdrumFileStructure::getStropheCount(int spineindex) {
 //
 
 HTp HumdrumFileStructure::getStropheStart(int index) {
+	requireAnalysis(HumFileAnalysis::Strophes);
 	if ((index < 0) || (index >= (int)m_strophes1d.size())) {
 		return NULL;
 	}
@@ -30627,6 +38426,7 @@ HTp HumdrumFileStructure::getStropheStart(int index) {
 }
 
 HTp HumdrumFileStructure::getStropheStart(int spine, int index) {
+		requireAnalysis(HumFileAnalysis::Strophes);
 		if ((spine < 0) || (index < 0)) {
 			return NULL;
 		}
@@ -30647,6 +38447,7 @@ HTp HumdrumFileStructure::getStropheStart(int spine, int index) {
 //
 
 HTp HumdrumFileStructure::getStropheEnd(int index) {
+	requireAnalysis(HumFileAnalysis::Strophes);
 	if ((index < 0) || (index >= (int)m_strophes1d.size())) {
 		return NULL;
 	}
@@ -30655,6 +38456,7 @@ HTp HumdrumFileStructure::getStropheEnd(int index) {
 
 
 HTp HumdrumFileStructure::getStropheEnd(int spine, int index) {
+		requireAnalysis(HumFileAnalysis::Strophes);
 		if ((spine < 0) || (index < 0)) {
 			return NULL;
 		}
@@ -30717,7 +38519,7 @@ bool HumdrumFileStructure::read(istream& contents) {
 	if (!readNoRhythm(contents)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30726,7 +38528,7 @@ bool HumdrumFileStructure::read(const char* filename) {
 	if (!readNoRhythm(filename)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30735,7 +38537,7 @@ bool HumdrumFileStructure::read(const string& filename) {
 	if (!readNoRhythm(filename)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30755,7 +38557,7 @@ bool HumdrumFileStructure::readCsv(istream& contents,
 	if (!readNoRhythmCsv(contents, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30765,7 +38567,7 @@ bool HumdrumFileStructure::readCsv(const char* filename,
 	if (!readNoRhythmCsv(filename, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30775,7 +38577,7 @@ bool HumdrumFileStructure::readCsv(const string& filename,
 	if (!readNoRhythmCsv(filename, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30791,7 +38593,7 @@ bool HumdrumFileStructure::readString(const char* contents) {
 	if (!HumdrumFileBase::readString(contents)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30800,7 +38602,7 @@ bool HumdrumFileStructure::readString(const string& contents) {
 	if (!HumdrumFileBase::readString(contents)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30818,7 +38620,7 @@ bool HumdrumFileStructure::readStringCsv(const char* contents,
 	if (!HumdrumFileBase::readStringCsv(contents, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -30828,7 +38630,27 @@ bool HumdrumFileStructure::readStringCsv(const string& contents,
 	if (!HumdrumFileBase::readStringCsv(contents, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::runAnalysis -- Do one of the structural analyses
+//    for HumdrumFileBase::requireAnalysis().  The analyses that it
+//    depends on have already been done.
+//
+
+bool HumdrumFileStructure::runAnalysis(int type) {
+	switch (type) {
+		case HumFileAnalysis::Strands:   return analyzeStrands();
+		case HumFileAnalysis::Nulls:     resolveNullTokens(); return isValid();
+		case HumFileAnalysis::Strophes:  return analyzeStrophes();
+		case HumFileAnalysis::Structure: return analyzeStructureNoRhythm();
+		case HumFileAnalysis::Rhythm:    return analyzeRhythmStructure();
+	}
+	return HumdrumFileBase::runAnalysis(type);
 }
 
 
@@ -30840,17 +38662,8 @@ bool HumdrumFileStructure::readStringCsv(const string& contents,
 //
 
 bool HumdrumFileStructure::analyzeStructure(void) {
-	m_analyses.m_structure_analyzed = false;
-	if (!m_analyses.m_strands_analyzed) {
-		if (!analyzeStrands()       ) { return isValid(); }
-	}
-	if (!analyzeGlobalParameters() ) { return isValid(); }
-	if (!analyzeLocalParameters()  ) { return isValid(); }
-	if (!analyzeTokenDurations()   ) { return isValid(); }
-	if (!analyzeTokenDurations()   ) { return isValid(); }
-	m_analyses.m_structure_analyzed = true;
+	if (!analyzeStructureNoRhythm()) { return isValid(); }
 	if (!analyzeRhythmStructure()  ) { return isValid(); }
-	analyzeSignifiers();
 	return isValid();
 }
 
@@ -30863,15 +38676,14 @@ bool HumdrumFileStructure::analyzeStructure(void) {
 //
 
 bool HumdrumFileStructure::analyzeStructureNoRhythm(void) {
-	m_analyses.m_structure_analyzed = true;
-	if (!m_analyses.m_strands_analyzed) {
-		if (!analyzeStrands()          ) { return isValid(); }
-	}
+	m_analyses.setAnalyzed(HumFileAnalysis::Structure);
+	if (!requireAnalysis(HumFileAnalysis::Strands)) { return isValid(); }
 	if (!analyzeGlobalParameters() ) { return isValid(); }
 	if (!analyzeLocalParameters()  ) { return isValid(); }
-	if (!analyzeTokenDurations()   ) { return isValid(); }
+	HumNum::clearOverflow();
+	if (!analyzeTokenDurations()   ) { return checkDurationOverflow(); }
 	analyzeSignifiers();
-	return isValid();
+	return checkDurationOverflow();
 }
 
 
@@ -30882,18 +38694,36 @@ bool HumdrumFileStructure::analyzeStructureNoRhythm(void) {
 //
 
 bool HumdrumFileStructure::analyzeRhythmStructure(void) {
-	m_analyses.m_rhythm_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Rhythm);
 	setLineRhythmAnalyzed();
-	if (!isStructureAnalyzed()) {
-		if (!analyzeStructureNoRhythm()) { return isValid(); }
-	}
+	if (!requireAnalysis(HumFileAnalysis::Structure)) { return isValid(); }
 
+	HumNum::clearOverflow();
 	HTp firstspine = getSpineStart(0);
 	if (firstspine && firstspine->isDataType("**recip")) {
 		assignRhythmFromRecip(firstspine);
 	} else {
-		if (!analyzeRhythm()           ) { return isValid(); }
-		if (!analyzeDurationsOfNonRhythmicSpines()) { return isValid(); }
+		if (!analyzeRhythm()           ) { return checkDurationOverflow(); }
+		if (!analyzeDurationsOfNonRhythmicSpines()) { return checkDurationOverflow(); }
+	}
+	return checkDurationOverflow();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::checkDurationOverflow -- Set a parse error if
+//    a duration calculated since HumNum::clearOverflow() was called did
+//    not fit into a HumNum.  Returns false if the file is not valid.
+//
+
+bool HumdrumFileStructure::checkDurationOverflow(void) {
+	if (HumNum::hasOverflow()) {
+		HumNum::clearOverflow();
+		if (isValid()) {
+			return setParseError("Error: durations in file are too large or too small to be calculated.");
+		}
 	}
 	return isValid();
 }
@@ -30981,19 +38811,19 @@ bool HumdrumFileStructure::readNoRhythm(const string& filename) {
 
 bool HumdrumFileStructure::readNoRhythmCsv(istream& infile,
 		const string& seperator) {
-	return HumdrumFileBase::readCsv(infile);
+	return HumdrumFileBase::readCsv(infile, seperator);
 }
 
 
 bool HumdrumFileStructure::readNoRhythmCsv(const char* filename,
 		const string& seperator) {
-	return HumdrumFileBase::readCsv(filename);
+	return HumdrumFileBase::readCsv(filename, seperator);
 }
 
 
 bool HumdrumFileStructure::readNoRhythmCsv(const string& filename,
 		const string& seperator) {
-	return HumdrumFileBase::readCsv(filename);
+	return HumdrumFileBase::readCsv(filename, seperator);
 }
 
 
@@ -31026,13 +38856,13 @@ bool HumdrumFileStructure::readStringNoRhythm(const string& contents) {
 
 bool HumdrumFileStructure::readStringNoRhythmCsv(const char* contents,
 		const string& separator) {
-	return HumdrumFileBase::readStringCsv(contents);
+	return HumdrumFileBase::readStringCsv(contents, separator);
 }
 
 
 bool HumdrumFileStructure::readStringNoRhythmCsv(const string& contents,
 		const string& separator) {
-	return HumdrumFileBase::readStringCsv(contents);
+	return HumdrumFileBase::readStringCsv(contents, separator);
 }
 
 
@@ -32102,7 +39932,7 @@ void HumdrumFileStructure::checkForLocalParameters(HTp token,
 //
 
 bool HumdrumFileStructure::analyzeStrands(void) {
-	m_analyses.m_strands_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Strands);
 	int spines = getSpineCount();
 	m_strand1d.clear();
 	m_strand2d.clear();
@@ -32123,12 +39953,6 @@ bool HumdrumFileStructure::analyzeStrands(void) {
 
 	assignStrandsToTokens();
 
-	resolveNullTokens();
-
-	analyzeLocalParameters();
-
-	analyzeStrophes();
-
 	return isValid();
 }
 
@@ -32140,13 +39964,11 @@ bool HumdrumFileStructure::analyzeStrands(void) {
 //
 
 void HumdrumFileStructure::resolveNullTokens(void) {
-	if (m_analyses.m_nulls_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Nulls)) {
 		return;
 	}
-	m_analyses.m_nulls_analyzed = true;
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	m_analyses.setAnalyzed(HumFileAnalysis::Nulls);
+	requireAnalysis(HumFileAnalysis::Strands);
 
 	HTp token;
 	HTp data = NULL;
@@ -32251,17 +40073,13 @@ void HumdrumFileStructure::analyzeSpineStrands(vector<TokenPair>& ends,
 //
 
 int HumdrumFileStructure::getStrandCount(void) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return (int)m_strand1d.size();
 }
 
 
 int HumdrumFileStructure::getStrandCount(int spineindex) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	if (spineindex < 0) {
 		return 0;
 	}
@@ -32280,34 +40098,26 @@ int HumdrumFileStructure::getStrandCount(int spineindex) {
 //
 
 HTp HumdrumFileStructure::getStrandStart(int index) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return m_strand1d[index].first;
 }
 
 
 HTp HumdrumFileStructure::getStrandEnd(int index) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return m_strand1d[index].last;
 }
 
 
 HTp HumdrumFileStructure::getStrandStart(int sindex,
 		int index) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return m_strand2d[sindex][index].first;
 }
 
 
 HTp HumdrumFileStructure::getStrandEnd(int sindex, int index) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return m_strand2d[sindex][index].last;
 }
 
@@ -33065,6 +40875,7 @@ std::vector<int> HumdrumLine::getMidiPitchesResolveNullSortLH (void) {
 //
 
 HumdrumLine::HumdrumLine(void) : string() {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_owner = NULL;
 	m_duration = -1;
 	m_durationFromStart = -1;
@@ -33073,6 +40884,7 @@ HumdrumLine::HumdrumLine(void) : string() {
 
 
 HumdrumLine::HumdrumLine(const string& aString) : string(aString) {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_owner = NULL;
 	if ((this->size() > 0) && (this->back() == 0x0d)) {
 		this->resize(this->size() - 1);
@@ -33085,6 +40897,7 @@ HumdrumLine::HumdrumLine(const string& aString) : string(aString) {
 
 
 HumdrumLine::HumdrumLine(const char* aString) : string(aString) {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_owner = NULL;
 	if ((this->size() > 0) && (this->back() == 0x0d)) {
 		this->resize(this->size() - 1);
@@ -33096,7 +40909,8 @@ HumdrumLine::HumdrumLine(const char* aString) : string(aString) {
 }
 
 
-HumdrumLine::HumdrumLine(HumdrumLine& line)  : string((string)line) {
+HumdrumLine::HumdrumLine(HumdrumLine& line) : string((string)line), HumHash() {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_lineindex           = line.m_lineindex;
 	m_duration            = line.m_duration;
 	m_durationFromStart   = line.m_durationFromStart;
@@ -33114,7 +40928,8 @@ HumdrumLine::HumdrumLine(HumdrumLine& line)  : string((string)line) {
 }
 
 
-HumdrumLine::HumdrumLine(HumdrumLine& line, void* owner) : string((string)line) {
+HumdrumLine::HumdrumLine(HumdrumLine& line, void* owner) : string((string)line), HumHash() {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_lineindex           = line.m_lineindex;
 	m_duration            = line.m_duration;
 	m_durationFromStart   = line.m_durationFromStart;
@@ -33171,6 +40986,7 @@ HumdrumLine::~HumdrumLine() {
 			m_tokens[i] = NULL;
 		}
 	}
+	deleteAnalysisValues();
 }
 
 
@@ -33182,8 +40998,11 @@ HumdrumLine::~HumdrumLine() {
 //
 
 void HumdrumLine::setLineFromCsv(const char* csv, const string& separator) {
-	string temp = csv;
-	setLineFromCsv(temp);
+	size_t length = strlen(csv);
+	if (length < 1) {
+		return;
+	}
+	HumFieldScanner::csvToTsv(csv, csv + length, separator, *this);
 }
 
 
@@ -33192,45 +41011,8 @@ void HumdrumLine::setLineFromCsv(const string& csv, const string& separator) {
 	if (csv.size() < 1) {
 		return;
 	}
-	string newcsv = csv;
-	if ((newcsv.size() > 0) && (newcsv.back() == 0x0d)) {
-		newcsv.resize(newcsv.size() - 1);
-	}
-	// construct tab-delimited string
-	string output;
-	bool inquote = false;
-
-	if ((newcsv.size() >= 2) && (newcsv[0] == '!') && (newcsv[1] == '!')) {
-		// Global commands and reference records which do not start with a
-		// quote are considered to be literal.
-		this->setText(newcsv);
-		return;
-	}
-
-	for (int i=0; i<(int)newcsv.size(); i++) {
-		if ((newcsv[i] == '"') && !inquote) {
-			inquote = true;
-			continue;
-		}
-		if (inquote && (newcsv[i] == '"') && (newcsv[i+1] == '"')
-				&& (i < (int)newcsv.length()-1)) {
-			output += '"';
-			i++;
-			continue;
-		}
-		if (newcsv[i] == '"') {
-			inquote = false;
-			continue;
-		}
-		if ((!inquote) && (newcsv.substr(i, separator.size()) == separator)) {
-			output += '\t';
-			i += (int)separator.size() - 1;
-			continue;
-		}
-		output += newcsv[i];
-	}
-	string& value = *this;
-	value = output;
+	const char* start = csv.data();
+	HumFieldScanner::csvToTsv(start, start + csv.size(), separator, *this);
 }
 
 
@@ -34313,7 +42095,9 @@ string HumdrumLine::getTokenString(int index) const {
 //////////////////////////////
 //
 // HumdrumLine::createTokensFromLine -- Chop up a HumdrumLine string into
-//     individual tokens.
+//     individual tokens.  Fields are copied directly from the line text
+//     between tab boundaries (found with HumFieldScanner) rather than
+//     being built up one character at a time.
 //
 
 int HumdrumLine::createTokensFromLine(void) {
@@ -34326,9 +42110,6 @@ int HumdrumLine::createTokensFromLine(void) {
 	m_tokens.clear();
 	m_tabs.clear();
 	HTp token;
-	char ch = 0;
-	char lastch = 0;
-	string tstring;
 
 	if (this->size() == 0) {
 		token = new HumdrumToken();
@@ -34341,35 +42122,30 @@ int HumdrumLine::createTokensFromLine(void) {
 		m_tokens.push_back(token);
 		m_tabs.push_back(0);
 	} else {
-		for (int i=0; i<(int)size(); i++) {
-			lastch = ch;
-			ch = getChar(i);
-			if (ch == '\t') {
-				// Parser now allows multiple tab characters in a
-				// row to represent a single tab.
-				if (lastch != '\t') {
-					token = new HumdrumToken(tstring);
-					token->setOwner(this);
-					m_tokens.push_back(token);
-					m_tabs.push_back(1);
-					tstring.clear();
-				} else {
-					if (m_tabs.size() > 0) {
-						m_tabs.back()++;
-					}
-				}
-			} else {
-				tstring += ch;
+		const char* field = this->data();
+		const char* end = field + this->size();
+		while (field < end) {
+			const char* tab = HumFieldScanner::find(field, end, '\t');
+			if (tab == end) {
+				token = new HumdrumToken(field, end - field);
+				token->setOwner(this);
+				m_tokens.push_back(token);
+				m_tabs.push_back(0);
+				break;
+			}
+			token = new HumdrumToken(field, tab - field);
+			token->setOwner(this);
+			m_tokens.push_back(token);
+			m_tabs.push_back(1);
+			field = tab + 1;
+			// Parser now allows multiple tab characters in a
+			// row to represent a single tab.
+			while ((field < end) && (*field == '\t')) {
+				m_tabs.back()++;
+				field++;
 			}
 		}
 	}
-	if (tstring.size() > 0) {
-		token = new HumdrumToken(tstring);
-		token->setOwner(this);
-		m_tokens.push_back(token);
-		m_tabs.push_back(0);
-		tstring.clear();
-	}
 
 	return (int)m_tokens.size();
 }
@@ -34982,10 +42758,18 @@ ostream& HumdrumLine::printTrackInfo(ostream& out) {
 //////////////////////////////
 //
 // HumdrumLine::setOwner -- store a pointer to the HumdrumFile which
-//    manages (owns) this object.
+//    manages (owns) this object.  Analysis values of the line and its
+//    tokens are stored by the file, so they are changed into text
+//    parameters when the line is moved out of a file.
 //
 
 void HumdrumLine::setOwner(void* hfile) {
+	if ((m_owner != NULL) && (m_owner != hfile)) {
+		detachAnalysisValues();
+		for (int i=0; i<(int)m_tokens.size(); i++) {
+			m_tokens[i]->detachAnalysisValues();
+		}
+	}
 	m_owner = hfile;
 }
 
@@ -35522,21 +43306,7 @@ void HumdrumToken::getBase40Pitches(vector<int>& output) {
 		output.clear();
 		return;
 	}
-	vector<string> pieces = this->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
-		} else {
-			output[i] = Convert::kernToBase40(pieces[i]);
-			// sustained notes are negative values:
-			if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
-			}
-		}
-	}
+	getKernRecord().getBase40Pitches(output);
 }
 
 
@@ -35548,12 +43318,14 @@ vector<int> HumdrumToken::getBase40Pitches(void) {
 
 
 int HumdrumToken::getBase40Pitch(void) {
-	vector<int> pitches = getBase40Pitches();
-	if (pitches.size() > 0) {
-		return pitches[0];
-	} else {
+	if (*this == ".") {
+		return 0;
+	}
+	const HumKernRecord& record = getKernRecord();
+	if (record.getNoteCount() == 0) {
 		return 0;
 	}
+	return record.getNote(0).getBase40Pitch();
 }
 
 
@@ -35731,21 +43503,7 @@ void HumdrumToken::getMidiPitches(vector<int>& output) {
 		output.clear();
 		return;
 	}
-	vector<string> pieces = this->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
-		} else {
-			output[i] = Convert::kernToMidiNoteNumber(pieces[i]);
-			// sustained notes are negative values:
-			if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
-			}
-		}
-	}
+	getKernRecord().getMidiPitches(output);
 }
 
 
@@ -35757,12 +43515,14 @@ vector<int> HumdrumToken::getMidiPitches(void) {
 
 
 int HumdrumToken::getMidiPitch(void) {
-	vector<int> pitches = getMidiPitches();
-	if (pitches.size() > 0) {
-		return pitches[0];
-	} else {
+	if (*this == ".") {
+		return 0;
+	}
+	const HumKernRecord& record = getKernRecord();
+	if (record.getNoteCount() == 0) {
 		return 0;
 	}
+	return record.getNote(0).getMidiPitch();
 }
 
 
@@ -35947,6 +43707,7 @@ vector<int> HumdrumToken::getMidiPitchesResolveNullSortLH (void) {
 //
 
 HumdrumToken::HumdrumToken(void) : string() {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_rhycheck = 0;
 	setPrefix("!");
 	m_strand = -1;
@@ -35956,6 +43717,7 @@ HumdrumToken::HumdrumToken(void) : string() {
 
 
 HumdrumToken::HumdrumToken(const string& aString) : string(aString) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_rhycheck = 0;
 	setPrefix("!");
 	m_strand = -1;
@@ -35965,6 +43727,18 @@ HumdrumToken::HumdrumToken(const string& aString) : string(aString) {
 
 
 HumdrumToken::HumdrumToken(const char* aString) : string(aString) {
+	setAnalysisOwner(TokenAnalysisOwner);
+	m_rhycheck = 0;
+	setPrefix("!");
+	m_strand = -1;
+	m_nullresolve = NULL;
+	m_strophe     = NULL;
+}
+
+
+HumdrumToken::HumdrumToken(const char* aString, size_t length) :
+		string(aString, length) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_rhycheck = 0;
 	setPrefix("!");
 	m_strand = -1;
@@ -35974,7 +43748,8 @@ HumdrumToken::HumdrumToken(const char* aString) : string(aString) {
 
 
 HumdrumToken::HumdrumToken(const HumdrumToken& token) :
-		string((string)token), HumHash((HumHash)token) {
+		string((string)token), HumHash(token) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_address         = token.m_address;
 	m_address.m_owner = NULL;
 	m_duration        = token.m_duration;
@@ -35991,7 +43766,8 @@ HumdrumToken::HumdrumToken(const HumdrumToken& token) :
 
 
 HumdrumToken::HumdrumToken(HumdrumToken* token) :
-		string((string)(*token)), HumHash((HumHash)(*token)) {
+		string((string)(*token)), HumHash(*token) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_address         = token->m_address;
 	m_address.m_owner = NULL;
 	m_duration        = token->m_duration;
@@ -36009,7 +43785,8 @@ HumdrumToken::HumdrumToken(HumdrumToken* token) :
 
 
 HumdrumToken::HumdrumToken(const HumdrumToken& token, HLp owner) :
-		string((string)token), HumHash((HumHash)token) {
+		string((string)token), HumHash(token) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_address         = token.m_address;
 	m_address.m_owner = owner;
 	m_duration        = token.m_duration;
@@ -36026,7 +43803,8 @@ HumdrumToken::HumdrumToken(const HumdrumToken& token, HLp owner) :
 
 
 HumdrumToken::HumdrumToken(HumdrumToken* token, HLp owner) :
-		string((string)(*token)), HumHash((HumHash)(*token)) {
+		string((string)(*token)), HumHash(*token) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_address         = token->m_address;
 	m_address.m_owner = owner;
 	m_duration        = token->m_duration;
@@ -36053,10 +43831,12 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 		return *this;
 	}
 	(string)(*this)   = (string)token;
-	(HumHash)(*this)  = (HumHash)token;
 
+	// Remove analysis values while the file which stores them is known:
+	clearParameters();
 	m_address         = token.m_address;
 	m_address.m_owner = NULL;
+	HumHash::operator=(token);
 	m_duration        = token.m_duration;
 	m_nextTokens      = token.m_nextTokens;
 	m_previousTokens.clear();
@@ -36067,6 +43847,7 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 	m_nullresolve     = NULL;
 	m_strophe         = NULL;
 	setPrefix(token.getPrefix());
+	clearKernRecord();
 
 	return *this;
 }
@@ -36075,6 +43856,7 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 HumdrumToken& HumdrumToken::operator=(const string& token) {
 	(string)(*this) = token;
 
+	detachAnalysisValues();
 	m_address.m_owner = NULL;
 	m_duration        = 0;
 	m_nextTokens.clear();
@@ -36086,6 +43868,7 @@ HumdrumToken& HumdrumToken::operator=(const string& token) {
 	m_nullresolve     = NULL;
 	m_strophe         = NULL;
 	setPrefix("!");
+	clearKernRecord();
 
 	return *this;
 }
@@ -36094,6 +43877,7 @@ HumdrumToken& HumdrumToken::operator=(const string& token) {
 HumdrumToken& HumdrumToken::operator=(const char* token) {
 	(string)(*this) = token;
 
+	detachAnalysisValues();
 	m_address.m_owner = NULL;
 	m_duration        = 0;
 	m_nextTokens.clear();
@@ -36105,6 +43889,7 @@ HumdrumToken& HumdrumToken::operator=(const char* token) {
 	m_nullresolve     = NULL;
 	m_strophe         = NULL;
 	setPrefix("!");
+	clearKernRecord();
 
 	return *this;
 }
@@ -36121,6 +43906,8 @@ HumdrumToken::~HumdrumToken() {
 		delete m_parameterSet;
 		m_parameterSet = NULL;
 	}
+	clearKernRecord();
+	deleteAnalysisValues();
 }
 
 
@@ -36286,6 +44073,41 @@ const string& HumdrumToken::getDataType(void) const {
 }
 
 
+
+//////////////////////////////
+//
+// HumdrumToken::getDataTypeId -- Get the HumDataType id of the exclusive
+//     interpretation for the token.  The id is stored for each token when
+//     the tracks of the file are analyzed, and is used if it is still the
+//     id of the text of the exclusive interpretation.  Otherwise (for
+//     tokens added to the file after the analysis, or in tracks whose
+//     exclusive interpretation has been changed since then), the data
+//     type is looked up in the symbol table.
+// @SEEALSO: getDataType isDataType
+//
+
+int HumdrumToken::getDataTypeId(void) const {
+	int id = m_address.getDataTypeId();
+	const string& datatype = m_address.getDataType();
+	if ((id != HumDataType::Unknown) && (HumDataType::getName(id) == datatype)) {
+		return id;
+	}
+	return HumDataType::getId(datatype);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumToken::setDataTypeId -- Store the HumDataType id of the
+//     exclusive interpretation for the token (used by HumdrumFileBase).
+//
+
+void HumdrumToken::setDataTypeId(int id) {
+	m_address.setDataTypeId(id);
+}
+
+
 /////////////////////////////
 //
 // HumdrumToken::getExclusiveInterpretation -- Get the exclusive
@@ -36300,7 +44122,8 @@ HTp HumdrumToken::getExclusiveInterpretation(void) {
 //////////////////////////////
 //
 // HumdrumToken::isDataType -- Returns true if the data type of the token
-//   matches the test data type.
+//   matches the test data type.  The data type can be given as a string
+//   (with or without the leading "**") or as a HumDataType id.
 // @SEEALSO: getDataType getKern
 //
 
@@ -36309,11 +44132,20 @@ bool HumdrumToken::isDataType(const string& dtype) const {
 		bool value = dtype == getDataType();
 		return value;
 	} else {
-		return getDataType().compare(2, string::npos, dtype) == 0;
+		const string& datatype = getDataType();
+		if (datatype.size() < 2) {
+			return false;
+		}
+		return datatype.compare(2, string::npos, dtype) == 0;
 	}
 }
 
 
+bool HumdrumToken::isDataType(int id) const {
+	return getDataTypeId() == id;
+}
+
+
 
 //////////////////////////////
 //
@@ -36359,7 +44191,7 @@ bool HumdrumToken::isDataTypeLike(const string& dtype) const {
 //
 
 bool HumdrumToken::isKern(void) const {
-	return isDataType("**kern");
+	return getDataTypeId() == HumDataType::Kern;
 }
 
 
@@ -36375,15 +44207,7 @@ bool HumdrumToken::isKern(void) const {
 //
 
 bool HumdrumToken::isKernLike(void) const {
-	string dtype = getDataType();
-	if (dtype == "**kern") {
-		return true;
-	} else if (dtype.compare(0, 7, "**kern-") == 0) {
-		return true;
-	} else if (dtype == "**kernyy") {
-		return true;
-	}
-	return false;
+	return HumDataType::isKernLike(getDataTypeId());
 }
 
 
@@ -36396,7 +44220,7 @@ bool HumdrumToken::isKernLike(void) const {
 //
 
 bool HumdrumToken::isMens(void) const {
-	return isDataType("**mens");
+	return getDataTypeId() == HumDataType::Mens;
 }
 
 
@@ -36412,13 +44236,7 @@ bool HumdrumToken::isMens(void) const {
 //
 
 bool HumdrumToken::isMensLike(void) const {
-	string dtype = getDataType();
-	if (dtype == "**mens") {
-		return true;
-	} else if (dtype.compare(0, 7, "**mens-") == 0) {
-		return true;
-	}
-	return false;
+	return HumDataType::isMensLike(getDataTypeId());
 }
 
 
@@ -36674,7 +44492,7 @@ HTp HumdrumToken::getNextToken(int index) const {
 //
 
 vector<HumdrumToken*> HumdrumToken::getNextTokens(void) const {
-	return m_nextTokens;
+	return vector<HumdrumToken*>(m_nextTokens.begin(), m_nextTokens.end());
 }
 
 
@@ -36686,7 +44504,7 @@ vector<HumdrumToken*> HumdrumToken::getNextTokens(void) const {
 //
 
 vector<HumdrumToken*> HumdrumToken::getPreviousTokens(void) const {
-	return m_previousTokens;
+	return vector<HumdrumToken*>(m_previousTokens.begin(), m_previousTokens.end());
 }
 
 
@@ -36777,7 +44595,7 @@ bool HumdrumToken::analyzeDuration(void) {
 					if (strchr(this->c_str(), 'q') != NULL) {
 						m_duration = 0;
 					} else {
-						m_duration = Convert::recipToDuration((string)(*this));
+						m_duration = Convert::recipToDuration(*this);
 					}
 				} else if (isMensLike()) {
 					int rlev = this->getValueInt("auto", "mensuration", "levels");
@@ -36785,7 +44603,7 @@ bool HumdrumToken::analyzeDuration(void) {
 						cerr << "Warning: mensuration levels not analyzed yet" << endl;
 						rlev = 2222;
 					}
-					m_duration = Convert::mensToDuration((string)(*this), rlev);
+					m_duration = Convert::mensToDuration(*this, rlev);
 				}
 			} else {
 				m_duration.setValue(-1);
@@ -37172,16 +44990,7 @@ bool HumdrumToken::hasRhythm(void) const {
 //
 
 bool HumdrumToken::hasBeam(void) const {
-	for (int i=0; i<(int)this->size(); i++) {
-		switch (this->at(i)) {
-			case 'L':
-			case 'J':
-			case 'k':
-			case 'K':
-				return true;
-		}
-	}
-	return false;
+	return getKernRecord().hasBeam();
 }
 
 
@@ -37247,9 +45056,12 @@ bool HumdrumToken::isRest(void) {
 			// token is a chord (rests in chords are used for non-sounding
 			// notes in artificial harmonics).
 			return false;
-		} else if (isNull() && Convert::isKernRest((string)(*resolveNull()))) {
-			return true;
-		} else if (Convert::isKernRest((string)(*this))) {
+		} else if (isNull()) {
+			HTp resolve = resolveNull();
+			if (resolve && resolve->getKernRecord().hasFlag(HumKernNote::Rest)) {
+				return true;
+			}
+		} else if (getKernRecord().hasFlag(HumKernNote::Rest)) {
 			return true;
 		}
 	} else if (isMensLike()) {
@@ -37278,7 +45090,7 @@ bool HumdrumToken::isNote(void) {
 		return false;
 	}
 	if (isKernLike()) {
-		if (Convert::isKernNote((string)(*this))) {
+		if (getKernRecord().isNote()) {
 			return true;
 		}
 	} else if (isMensLike()) {
@@ -37298,10 +45110,9 @@ bool HumdrumToken::isNote(void) {
 
 bool HumdrumToken::isPitched(void) {
 	if (this->isKernLike()) {
-		for (int i=0; i<(int)this->size(); i++) {
-			if ((this->at(i) == 'r') || (this->at(i) == 'R')) {
-				return false;
-			}
+		const HumKernRecord& record = getKernRecord();
+		if (record.hasFlag(HumKernNote::Rest | HumKernNote::Unpitched)) {
+			return false;
 		}
 		return true;
 	}
@@ -37318,11 +45129,7 @@ bool HumdrumToken::isPitched(void) {
 
 bool HumdrumToken::isUnpitched(void) {
 	if (this->isKernLike()) {
-		if (this->find('R') != string::npos) {
-			return 1;
-		} else {
-			return 0;
-		}
+		return getKernRecord().hasFlag(HumKernNote::Unpitched);
 	}
 	// Don't know data type so return false for now:
 	return false;
@@ -37377,7 +45184,7 @@ bool HumdrumToken::isNoteAttack(void) {
 //
 
 bool HumdrumToken::isInvisible(void) {
-	if (!isDataType("**kern")) {
+	if (!isDataType(HumDataType::Kern)) {
 			return false;
 	}
 	if (isBarline()) {
@@ -37385,7 +45192,7 @@ bool HumdrumToken::isInvisible(void) {
 			return true;
 		}
 	} else if (isData()) {
-		if (find("yy") != string::npos) {
+		if (getKernRecord().hasFlag(HumKernNote::Invisible)) {
 			return true;
 		}
 	}
@@ -37401,12 +45208,12 @@ bool HumdrumToken::isInvisible(void) {
 //
 
 bool HumdrumToken::isGrace(void) {
-	if (!isDataType("**kern")) {
+	if (!isDataType(HumDataType::Kern)) {
 			return false;
 	}
 	if (!isData()) {
 		return false;
-	} else if (this->find("q") != string::npos) {
+	} else if (getKernRecord().hasFlag(HumKernNote::Grace)) {
 		return true;
 	}
 
@@ -37905,8 +45712,8 @@ string HumdrumToken::getInstrumentAbbreviation(void) {
 //
 
 bool HumdrumToken::hasSlurStart(void) {
-	if (isDataType("**kern")) {
-		if (Convert::hasKernSlurStart((string)(*this))) {
+	if (isDataType(HumDataType::Kern)) {
+		if (getKernRecord().getSlurStartCount() > 0) {
 			return true;
 		}
 	}
@@ -37922,8 +45729,8 @@ bool HumdrumToken::hasSlurStart(void) {
 //
 
 bool HumdrumToken::hasSlurEnd(void) {
-	if (isDataType("**kern")) {
-		if (Convert::hasKernSlurEnd((string)(*this))) {
+	if (isDataType(HumDataType::Kern)) {
+		if (getKernRecord().getSlurEndCount() > 0) {
 			return true;
 		}
 	}
@@ -38086,6 +45893,48 @@ bool HumdrumToken::allSameBarlineStyle(void) {
 
 
 
+//////////////////////////////
+//
+// HumdrumToken::getKernRecord -- Return the decoded **kern information
+//     for the token.  The record is created on the first call, and is
+//     created again if the text of the token has changed since then
+//     (through setText() or the std::string interface of the token), so
+//     a returned record can only be used until the text is changed.  If
+//     several threads create the record at once, the first one stored is
+//     used.  The data type of the token is not checked.
+//
+
+const HumKernRecord& HumdrumToken::getKernRecord(void) const {
+	HumKernRecord* record = m_kernRecord.load(std::memory_order_acquire);
+	if (record && record->isRecordOf(*this)) {
+		return *record;
+	}
+	HumKernRecord* created = new HumKernRecord(*this);
+	if (m_kernRecord.compare_exchange_strong(record, created,
+			std::memory_order_acq_rel, std::memory_order_acquire)) {
+		// Replaced a missing record or one for an earlier text:
+		delete record;
+		return *created;
+	}
+	// Another thread stored a record first:
+	delete created;
+	return *record;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumToken::clearKernRecord -- Delete the decoded **kern information
+//     for the token (it will be recreated when next needed).
+//
+
+void HumdrumToken::clearKernRecord(void) {
+	delete m_kernRecord.exchange(NULL);
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumToken::hasLigatureEnd --
@@ -38138,8 +45987,8 @@ bool HumdrumToken::hasObliquaLigatureEnd(void) {
 //
 
 bool HumdrumToken::isSecondaryTiedNote(void) {
-	if (isDataType("**kern")) {
-		if (Convert::isKernSecondaryTiedNote((string)(*this))) {
+	if (isDataType(HumDataType::Kern)) {
+		if (getKernRecord().isSecondaryTiedNote()) {
 			return true;
 		}
 	}
@@ -38516,13 +46365,7 @@ string HumdrumToken::getTrackString(void) const {
 //
 
 int HumdrumToken::getSubtokenCount(const string& separator) const {
-	int count = 0;
-	string::size_type start = 0;
-	while ((start = string::find(separator, start)) != string::npos) {
-		count++;
-		start += separator.size();
-	}
-	return count+1;
+	return HumSubtokens(*this, separator).getCount();
 }
 
 
@@ -38538,41 +46381,35 @@ int HumdrumToken::getSubtokenCount(const string& separator) const {
 //
 
 string HumdrumToken::getSubtoken(int index, const string& separator) const {
-    if (index < 0) return "";
+	if (index < 0) {
+		return "";
+	}
 
-    const string& s = *this;
+	// If "separator" is empty, treat "index" as a character index.
+	if (separator.empty()) {
+		if (index < (int)this->size()) {
+			return string(1, (*this)[index]);
+		} else {
+			return "";
+		}
+	}
 
-    // If "separator" is empty, treat "index" as a character index.
-    if (separator.empty()) {
-        if (index >= 0 && static_cast<size_t>(index) < s.size()) {
-            return string(1, s[static_cast<size_t>(index)]);
-        } else {
-            return "";
-        }
-    }
+	return string(HumSubtokens(*this, separator).getSubtoken(index));
+}
 
-    size_t pos = 0;
-    int current = 0;
 
-    while (true) {
-        size_t next = s.find(separator, pos);
 
-        if (current == index) {
-            // We are at the target field: return up to the next separator (or end)
-            if (next == string::npos) {
-                return s.substr(pos);
-            } else {
-                return s.substr(pos, next - pos);
-            }
-        }
-
-        // Not at the target yet: advance to the next field
-        if (next == string::npos) {
-            return "";  // ran out of fields
-        }
-        pos = next + separator.size();
-        ++current;
-    }
+//////////////////////////////
+//
+// HumdrumToken::getSubtokenViews -- Return the sub-tokens as views into
+//     the token text, which can be used in a range-based for loop without
+//     copying the sub-tokens.  The views are invalid after the token text
+//     is changed.  Empty sub-tokens are included as in getSubtokenCount().
+//     default value: separator = " "
+//
+
+HumSubtokens HumdrumToken::getSubtokenViews(std::string_view separator) const {
+	return HumSubtokens(*this, separator);
 }
 
 
@@ -38586,25 +46423,14 @@ string HumdrumToken::getSubtoken(int index, const string& separator) const {
 //
 
 std::vector<std::string> HumdrumToken::getSubtokens(const std::string& separator) const {
-    std::vector<std::string> out;
-    const std::string& s = *this;
-
-    if (separator.empty()) {
-        if (!s.empty()) out.push_back(s);
-        return out;
-    }
-
-    std::string::size_type start = 0;
-    while (true) {
-        auto pos = s.find(separator, start);
-        if (pos == std::string::npos) {
-            if (start < s.size()) out.emplace_back(s.substr(start)); // last piece
-            break;
-        }
-        if (pos > start) out.emplace_back(s.substr(start, pos - start)); // ignore empties
-        start = pos + separator.size();
-    }
-    return out;
+	std::vector<std::string> output;
+	for (std::string_view subtoken : HumSubtokens(*this, separator)) {
+		// ignore empty sub-tokens
+		if (!subtoken.empty()) {
+			output.emplace_back(subtoken);
+		}
+	}
+	return output;
 }
 
 
@@ -38694,11 +46520,21 @@ void HumdrumToken::setParameters(const string& pdata, HumdrumToken* ptok) {
 
 //////////////////////////////
 //
-// HumdrumToken::setText --
+// HumdrumToken::setText -- Change the text of the token.  The file
+//     which owns the token is marked as edited if the text is different
+//     (see HumdrumFileBase::hasEditedTokens()).
 //
 
 void HumdrumToken::setText(const string& text) {
+	if (compare(text) == 0) {
+		return;
+	}
 	string::assign(text);
+	clearKernRecord();
+	HLp line = getOwner();
+	if (line && line->getOwner()) {
+		line->getOwner()->setEditedTokens();
+	}
 }
 
 
@@ -39291,14 +47127,44 @@ std::string HumdrumToken::getLayoutParameterNote(const std::string& category,
 //////////////////////////////
 //
 // HumdrumToken::setOwner -- Sets the HumdrumLine owner of this token.
+//     Analysis values of the token are stored by its file, so they are
+//     changed into text parameters when the token is moved out of the
+//     file.
 //
 
 void HumdrumToken::setOwner(HLp aLine) {
+	HLp owner = getOwner();
+	if ((owner != NULL) && (owner != aLine)) {
+		if ((aLine == NULL) || (aLine->getOwner() != owner->getOwner())) {
+			detachAnalysisValues();
+		}
+	}
 	m_address.setOwner(aLine);
 }
 
 
 
+//////////////////////////////
+//
+// HumdrumToken::requireFileAnalysis -- Run an analysis of the HumdrumFile
+//    that owns this token if it has not been done yet (see HumFileAnalysis
+//    for the list of analysis types).
+//
+
+void HumdrumToken::requireFileAnalysis(int type) {
+	HLp hline = getOwner();
+	if (!hline) {
+		return;
+	}
+	HumdrumFile* infile = hline->getOwner();
+	if (!infile) {
+		return;
+	}
+	infile->requireAnalysis(type);
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumToken::getOwner -- Returns a pointer to the HumdrumLine that
@@ -39869,12 +47735,13 @@ ostream& printSequence(vector<HTp>& sequence, ostream& out) {
 //////////////////////////////
 //
 // HumdrumToken::getSlurStartToken -- Return a pointer to the token
-//     which starts the given slur.  Returns NULL if no start.  Assumes that
-//     HumdrumFileContent::analyzeKernSlurs() has already been run.
+//     which starts the given slur.  Returns NULL if no start.  Slurs are
+//     analyzed in the owning file if that has not been done already.
 //				<parameter key="slurEnd" value="HT_140366146702320" idref=""/>
 //
 
 HTp HumdrumToken::getSlurStartToken(int number) {
+	requireFileAnalysis(HumFileAnalysis::Slurs);
 	string tag = "slurStartId";
 	if (number > 1) {
 		tag += to_string(number);
@@ -39891,6 +47758,7 @@ HTp HumdrumToken::getSlurStartToken(int number) {
 //
 
 int HumdrumToken::getSlurStartNumber(int endnumber) {
+	requireFileAnalysis(HumFileAnalysis::Slurs);
 	string tag = "slurStartNumber";
 	if (endnumber > 1) {
 		tag += to_string(endnumber);
@@ -39904,12 +47772,13 @@ int HumdrumToken::getSlurStartNumber(int endnumber) {
 //////////////////////////////
 //
 // HumdrumToken::getSlurEndToken -- Return a pointer to the token
-//     which ends the given slur.  Returns NULL if no end.  Assumes that
-//     HumdrumFileContent::analyzeKernSlurs() has already been run.
+//     which ends the given slur.  Returns NULL if no end.  Slurs are
+//     analyzed in the owning file if that has not been done already.
 //				<parameter key="slurStart" value="HT_140366146702320" idref=""/>
 //
 
 HTp HumdrumToken::getSlurEndToken(int number) {
+	requireFileAnalysis(HumFileAnalysis::Slurs);
 	string tag = "slurEnd";
 	if (number > 1) {
 		tag += to_string(number);
@@ -39923,12 +47792,13 @@ HTp HumdrumToken::getSlurEndToken(int number) {
 //////////////////////////////
 //
 // HumdrumToken::getPhraseStartToken -- Return a pointer to the token
-//     which starts the given phrase.  Returns NULL if no start.  Assumes that
-//     HumdrumFileContent::analyzeKernPhrasings() has already been run.
+//     which starts the given phrase.  Returns NULL if no start.  Phrases are
+//     analyzed in the owning file if that has not been done already.
 //				<parameter key="phraseEnd" value="HT_140366146702320" idref=""/>
 //
 
 HTp HumdrumToken::getPhraseStartToken(int number) {
+	requireFileAnalysis(HumFileAnalysis::Phrases);
 	string tag = "phraseStart";
 	if (number > 1) {
 		tag += to_string(number);
@@ -39941,12 +47811,13 @@ HTp HumdrumToken::getPhraseStartToken(int number) {
 //////////////////////////////
 //
 // HumdrumToken::getPhraseEndToken -- Return a pointer to the token
-//     which ends the given phrase.  Returns NULL if no end.  Assumes that
-//     HumdrumFileContent::analyzeKernPhrasings() has already been run.
+//     which ends the given phrase.  Returns NULL if no end.  Phrases are
+//     analyzed in the owning file if that has not been done already.
 //				<parameter key="phraseStart" value="HT_140366146702320" idref=""/>
 //
 
 HTp HumdrumToken::getPhraseEndToken(int number) {
+	requireFileAnalysis(HumFileAnalysis::Phrases);
 	string tag = "phraseEnd";
 	if (number > 1) {
 		tag += to_string(number);
@@ -40015,6 +47886,7 @@ void HumdrumToken::copyStructure(HTp token) {
 //
 
 HTp HumdrumToken::getStrophe(void) {
+	requireFileAnalysis(HumFileAnalysis::Strophes);
 	return m_strophe;
 }
 
@@ -40048,6 +47920,7 @@ void HumdrumToken::setStrophe(HTp strophe) {
 //
 
 bool HumdrumToken::hasStrophe(void) {
+	requireFileAnalysis(HumFileAnalysis::Strophes);
 	return m_strophe ? true : false;
 }
 
@@ -49475,7 +57348,7 @@ ostream& operator<<(ostream& out, MuseRecordBasic* aRecord) {
 class MxmlMeasure;
 class MxmlPart;
 
-int MxmlEvent::m_counter = 0;
+std::atomic<int> MxmlEvent::m_counter(0);
 
 ////////////////////////////////////////////////////////////////////////////
 
@@ -49557,8 +57430,7 @@ void MxmlEvent::makeDummyRest(MxmlMeasure* owner, HumNum starttime,
 	// m_node remains null
 	// m_links remains empty
 	m_linked = false;
-	m_sequence = -m_counter;
-	m_counter++;
+	m_sequence = -(m_counter++);
 	m_voice = 1;  // don't know what the original voice number is
 	m_voiceindex = voiceindex;
 	m_staff = staffindex + 1;
@@ -53334,14 +61206,14 @@ string MxmlPart::cleanSpaces(const string& input) {
 
 //////////////////////////////
 //
-// NoteCell::NoteCell -- Constructor.
+// NoteCell::NoteCell -- Constructor.  The cell is a view of the
+//    given voice and slice in the arrays of the owning NoteGrid.
 //
 
-NoteCell::NoteCell(NoteGrid* owner, HTp token) {
-	clear();
+NoteCell::NoteCell(NoteGrid* owner, int voice, int slice) {
 	m_owner = owner;
-	m_token = token;
-	calculateNumericPitches();
+	m_voice = voice;
+	m_timeslice = slice;
 }
 
 
@@ -53353,14 +61225,6 @@ NoteCell::NoteCell(NoteGrid* owner, HTp token) {
 
 void NoteCell::clear(void) {
 	m_owner = NULL;
-	m_token = NULL;
-	m_b7  = 0;
-	m_b12 = 0;
-	m_b40 = 0;
-	m_accidental = 0;
-	m_nextAttackIndex = -1;
-	m_prevAttackIndex = -1;
-	m_currAttackIndex = -1;
 	m_timeslice = -1;
 	m_voice = -1;
 }
@@ -53369,52 +61233,143 @@ void NoteCell::clear(void) {
 
 //////////////////////////////
 //
-// NoteCell::calculateNumericPitches -- Fills in b7, b12, and b40 variables.
-//    0 = rest, negative values for sustained notes.
+// NoteCell::getSgnBase40Pitch -- Return the base-40 pitch of the note:
+//    NaN=rest, negative=sustain.
 //
 
-void NoteCell::calculateNumericPitches(void) {
-	if (!m_token) {
-		m_b40        = NAN;
-		m_b12        = NAN;
-		m_b7         = NAN;
-		m_accidental = NAN;
-		return;
+double NoteCell::getSgnBase40Pitch(void) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
+		return NAN;
 	}
+	return b40;
+}
+
+
 
-	bool sustain = m_token->isNull() || m_token->isSecondaryTiedNote();
-	if (m_token->isRest()) {
-		m_b40 = NAN;
+//////////////////////////////
+//
+// NoteCell::getSgnDiatonicPitch -- Return the diatonic pitch of the note:
+//    NaN=rest, negative=sustain.
+//
+
+double NoteCell::getSgnDiatonicPitch(void) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
+		return NAN;
+	} else if (b40 > 0) {
+		return Convert::base40ToDiatonic(b40);
+	} else if (b40 < 0) {
+		return -Convert::base40ToDiatonic(-b40);
 	} else {
-		HTp resolve = m_token->resolveNull();
-		if (resolve->isRest()) {
-			m_b40 = NAN;
-		} else if (resolve->isNull()) {
-			m_b40 = NAN;
-		} else {
-			m_b40 = Convert::kernToBase40(resolve);
-			m_b40 = (sustain ? -m_b40 : m_b40);
-		}
+		return NAN;
 	}
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getSgnMidiPitch -- Return the MIDI note number of the note:
+//    NaN=rest, negative=sustain.
+//
+
+double NoteCell::getSgnMidiPitch(void) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
+		return NAN;
+	} else if (b40 > 0) {
+		return Convert::base40ToMidiNoteNumber(b40);
+	} else if (b40 < 0) {
+		return -Convert::base40ToMidiNoteNumber(-b40);
+	} else {
+		return NAN;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getSgnAccidental -- Return the chromatic alteration of the
+//    note: NaN=rest, negative=sustain.
+//
 
-	// convert to base-7 (diatonic pitch numbers)
-	if (m_b40 > 0) {
-		m_b7         = Convert::base40ToDiatonic((int)m_b40);
-		m_b12        = Convert::base40ToMidiNoteNumber((int)m_b40);
-		m_accidental = Convert::base40ToAccidental((int)m_b40);
-	} else if (m_b40 < 0) {
-		m_b7         = -Convert::base40ToDiatonic(-(int)m_b40);
-		m_b12        = -Convert::base40ToMidiNoteNumber(-(int)m_b40);
-		m_accidental = -Convert::base40ToAccidental(-(int)m_b40);
+double NoteCell::getSgnAccidental(void) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
+		return NAN;
+	} else if (b40 > 0) {
+		return Convert::base40ToAccidental(b40);
+	} else if (b40 < 0) {
+		return -Convert::base40ToAccidental(-b40);
 	} else {
-		m_b7         = NAN;
-		m_b12        = NAN;
-		m_accidental = NAN;
+		return NAN;
 	}
 }
 
 
 
+//////////////////////////////
+//
+// NoteCell::getToken -- Return the token of the note in the original
+//    Humdrum file.
+//
+
+HTp NoteCell::getToken(void) {
+	return m_owner->m_tokens[m_voice][m_timeslice];
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getNextAttackIndex -- Return the slice index of the next
+//    note attack (or rest), or -1 if none.
+//
+
+int NoteCell::getNextAttackIndex(void) {
+	return m_owner->m_nextattack[m_voice][m_timeslice];
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getPrevAttackIndex -- Return the slice index of the previous
+//    note attack (or rest), or -1 if none.
+//
+
+int NoteCell::getPrevAttackIndex(void) {
+	return m_owner->m_prevattack[m_voice][m_timeslice];
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getCurrAttackIndex -- Return the slice index of the attack
+//    of the note (or first rest) that this cell belongs to.
+//
+
+int NoteCell::getCurrAttackIndex(void) {
+	return m_owner->m_currattack[m_voice][m_timeslice];
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getTiedTokens -- Return the tokens of the tied notes
+//    (and rests) which follow a note attack.
+//
+
+vector<HTp> NoteCell::getTiedTokens(void) {
+	return m_owner->getTiedTokens(m_voice, m_timeslice);
+}
+
+
+
 //////////////////////////////
 //
 // NoteCell::getSgnKernPitch -- Return the **kern representation of the pitch.
@@ -53457,17 +61412,7 @@ string NoteCell::getAbsKernPitch(void) {
 //
 
 bool NoteCell::isSustained(void) {
-	if (m_b40 < 0) {
-		return true;
-	} else if (m_b40 > 0) {
-		return false;
-	}
-	// calculate if rest is a "sustain" or an "attack"
-	if (m_currAttackIndex == m_timeslice) {
-		return false;
-	} else {
-		return true;
-	}
+	return m_owner->m_flags[m_voice][m_timeslice] & NoteGrid::CellSustain;
 }
 
 
@@ -53499,10 +61444,11 @@ double NoteCell::operator-(int B) {
 //
 
 int NoteCell::getLineIndex(void) {
-	if (!m_token) {
+	HTp token = getToken();
+	if (!token) {
 		return -1;
 	}
-	return m_token->getLineIndex();
+	return token->getLineIndex();
 }
 
 
@@ -53514,10 +61460,11 @@ int NoteCell::getLineIndex(void) {
 //
 
 int NoteCell::getFieldIndex(void) {
-	if (!m_token) {
+	HTp token = getToken();
+	if (!token) {
 		return -1;
 	}
-	return m_token->getFieldIndex();
+	return token->getFieldIndex();
 }
 
 
@@ -53586,8 +61533,7 @@ double NoteCell::getDiatonicIntervalToNextAttack(void) {
 //
 
 bool NoteCell::isRest(void) {
-	// bug in GCC requires :: prefix to resolve two different isnan() defs.
-	return Convert::isNaN(m_b40);
+	return m_owner->m_flags[m_voice][m_timeslice] & NoteGrid::CellRest;
 }
 
 
@@ -53612,8 +61558,9 @@ double NoteCell::getMetricLevel(void) {
 //
 
 HumNum NoteCell::getDurationFromStart(void) {
-	if (m_token) {
-		return m_token->getDurationFromStart();
+	HTp token = getToken();
+	if (token) {
+		return token->getDurationFromStart();
 	} else {
 		return -1;
 	}
@@ -53627,9 +61574,6 @@ HumNum NoteCell::getDurationFromStart(void) {
 //
 
 HumNum NoteCell::getDuration(void) {
-	if (!m_owner) {
-		return Convert::recipToDuration(m_token);
-	}
 	return m_owner->getNoteDuration(getVoiceIndex(), getSliceIndex());
 }
 
@@ -53637,34 +61581,24 @@ HumNum NoteCell::getDuration(void) {
 
 //////////////////////////////
 //
-// NoteCell::setMeter --
-//
-
-void NoteCell::setMeter(int topval, HumNum botval) {
-	m_metertop = topval;
-	m_meterbot = botval;
-}
-
-
-
-//////////////////////////////
-//
-// NoteCell::getMeterTop --
+// NoteCell::getMeterTop -- Return the top number of the prevailing
+//    meter signature.
 //
 
 int NoteCell::getMeterTop(void) {
-	return m_metertop;
+	return m_owner->m_meters[m_owner->m_meter[m_voice][m_timeslice]].first;
 }
 
 
 
 //////////////////////////////
 //
-// NoteCell::getMeterBottom --
+// NoteCell::getMeterBottom -- Return the bottom number of the prevailing
+//    meter signature.
 //
 
 HumNum NoteCell::getMeterBottom(void) {
-	return m_meterbot;
+	return m_owner->m_meters[m_owner->m_meter[m_voice][m_timeslice]].second;
 }
 
 
@@ -53675,12 +61609,13 @@ HumNum NoteCell::getMeterBottom(void) {
 //
 
 double NoteCell::getSgnDiatonicPitchClass(void) {
-	if (Convert::isNaN(m_b7)) {
+	double b7 = getSgnDiatonicPitch();
+	if (Convert::isNaN(b7)) {
 		return GRIDREST;
-	} else if (m_b7 < 0) {
-		return -(double)(((int)-m_b7) % 7);
+	} else if (b7 < 0) {
+		return -(double)(((int)-b7) % 7);
 	} else {
-		return (double)(((int)m_b7) % 7);
+		return (double)(((int)b7) % 7);
 	}
 }
 
@@ -53692,10 +61627,11 @@ double NoteCell::getSgnDiatonicPitchClass(void) {
 //
 
 double NoteCell::getAbsDiatonicPitchClass(void) {
-	if (Convert::isNaN(m_b7)) {
+	double b7 = getSgnDiatonicPitch();
+	if (Convert::isNaN(b7)) {
 		return GRIDREST;
 	} else {
-		return (double)(((int)fabs(m_b7)) % 7);
+		return (double)(((int)fabs(b7)) % 7);
 	}
 }
 
@@ -53707,12 +61643,13 @@ double NoteCell::getAbsDiatonicPitchClass(void) {
 //
 
 double NoteCell::getSgnBase40PitchClass(void) {
-	if (Convert::isNaN(m_b40)) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
 		return GRIDREST;
-	} else if (m_b40 < 0) {
-		return -(double)(((int)-m_b40) % 40);
+	} else if (b40 < 0) {
+		return -(double)(-b40 % 40);
 	} else {
-		return (double)(((int)m_b40) % 40);
+		return (double)(b40 % 40);
 	}
 }
 
@@ -53724,10 +61661,11 @@ double NoteCell::getSgnBase40PitchClass(void) {
 //
 
 double NoteCell::getAbsBase40PitchClass(void) {
-	if (Convert::isNaN(m_b40)) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
 		return GRIDREST;
 	} else {
-		return (double)(((int)fabs(m_b40)) % 40);
+		return (double)(abs(b40) % 40);
 	}
 }
 
@@ -53738,10 +61676,7 @@ double NoteCell::getAbsBase40PitchClass(void) {
 //
 
 bool NoteCell::isAttack(void) {
-	if (Convert::isNaN(m_b40)) {
-		return false;
-	}
-	return m_b40>0? true:false;
+	return m_owner->m_flags[m_voice][m_timeslice] & NoteGrid::CellAttack;
 }
 
 
@@ -53777,19 +61712,16 @@ NoteGrid::~NoteGrid() {
 void NoteGrid::clear(void) {
 	m_infile = NULL;
 	m_kernspines.clear();
-
-	vector<vector<NoteCell* > >& grid = m_grid;
-	for (int i=0; i<(int)grid.size(); i++) {
-		for (int j=0; j<(int)grid[i].size(); j++) {
-			if (grid[i][j]) {
-				grid[i][j]->clear();
-				delete grid[i][j];
-				grid[i][j] = NULL;
-			}
-		}
-		grid[i].clear();
-	}
-	grid.clear();
+	m_metriclevels.clear();
+	m_grid.clear();
+	m_tokens.clear();
+	m_base40.clear();
+	m_flags.clear();
+	m_prevattack.clear();
+	m_currattack.clear();
+	m_nextattack.clear();
+	m_meter.clear();
+	m_meters.clear();
 }
 
 
@@ -53800,7 +61732,7 @@ void NoteGrid::clear(void) {
 //
 
 int NoteGrid::getVoiceCount(void) {
-	return (int)m_grid.size();
+	return (int)m_tokens.size();
 }
 
 
@@ -53812,10 +61744,10 @@ int NoteGrid::getVoiceCount(void) {
 //
 
 int NoteGrid::getSliceCount(void) {
-	if (m_grid.size() == 0) {
+	if (m_tokens.size() == 0) {
 		return 0;
 	} else {
-		return (int)m_grid[0].size();
+		return (int)m_tokens[0].size();
 	}
 }
 
@@ -53845,10 +61777,20 @@ bool NoteGrid::load(HumdrumFile& infile) {
 		return false;
 	}
 
-	vector<vector<NoteCell* > >& grid = m_grid;
-	grid.resize(kernspines.size());
-	for (int i=0; i<(int)grid.size(); i++) {
-		grid[i].reserve(infile.getLineCount());
+	int slices = 0;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (infile[i].isData()) {
+			slices++;
+		}
+	}
+	int voices = (int)kernspines.size();
+	m_tokens.resize(voices);
+	m_base40.resize(voices);
+	m_meter.resize(voices);
+	for (int i=0; i<voices; i++) {
+		m_tokens[i].reserve(slices);
+		m_base40[i].reserve(slices);
+		m_meter[i].reserve(slices);
 	}
 
 	//int attack = 0;
@@ -53900,32 +61842,101 @@ bool NoteGrid::load(HumdrumFile& infile) {
 		if (current.size() != kernspines.size()) {
 			cerr << "Error: Unequal vector sizes " << current.size()
 			     << " compared to " << kernspines.size() << endl;
+			// Keep the slices before the error, without attack indexes:
+			buildAttackIndexes(false);
+			buildCellViews();
 			return false;
 		}
 		for (int j=0; j<(int)current.size(); j++) {
-			NoteCell* cell = new NoteCell(this, current[j]);
 			track = current[j]->getTrack();
-			cell->setVoiceIndex(j);
-			cell->setSliceIndex((int)grid[j].size());
-			cell->setMeter(metertops[track], meterbots[track]);
-			grid[j].push_back(cell);
+			addCell(j, current[j], getMeterIndex(metertops[track], meterbots[track]));
 		}
 	}
 
 	buildAttackIndexes();
+	buildCellViews();
 
 	return true;
 }
 
 
 
+//////////////////////////////
+//
+// NoteGrid::addCell -- Append a cell for the token to the arrays of
+//    a voice.  Rests are stored as GRIDREST40, and sustained notes
+//    (null tokens and secondary tied notes) as negative base-40 pitches.
+//
+
+void NoteGrid::addCell(int vindex, HTp token, int meter) {
+	int b40 = GRIDREST40;
+	bool sustain = token->isNull() || token->isSecondaryTiedNote();
+	if (!token->isRest()) {
+		HTp resolve = token->resolveNull();
+		if (!(resolve->isRest() || resolve->isNull())) {
+			// The first note of a chord is stored in the grid:
+			b40 = Convert::kernToBase40(resolve->getSubtokenViews().front());
+			b40 = (sustain ? -b40 : b40);
+			if (b40 > 32767) {
+				b40 = 32767;
+			} else if (b40 < -32767) {
+				b40 = -32767;
+			}
+		}
+	}
+	m_tokens[vindex].push_back(token);
+	m_base40[vindex].push_back((short)b40);
+	m_meter[vindex].push_back((short)meter);
+}
+
+
+
+//////////////////////////////
+//
+// NoteGrid::buildCellViews -- Create the NoteCells for the arrays
+//    of each voice.
+//
+
+void NoteGrid::buildCellViews(void) {
+	int voices = (int)m_tokens.size();
+	m_grid.resize(voices);
+	for (int i=0; i<voices; i++) {
+		int slices = (int)m_tokens[i].size();
+		m_grid[i].clear();
+		m_grid[i].reserve(slices);
+		for (int j=0; j<slices; j++) {
+			m_grid[i].emplace_back(this, i, j);
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// NoteGrid::getMeterIndex -- Return the index of the meter signature
+//    in the list of meters of the grid, adding it if necessary.
+//
+
+int NoteGrid::getMeterIndex(int top, HumNum bot) {
+	for (int i=(int)m_meters.size()-1; i>=0; i--) {
+		if ((m_meters[i].first == top) && (m_meters[i].second == bot)) {
+			return i;
+		}
+	}
+	m_meters.emplace_back(top, bot);
+	return (int)m_meters.size() - 1;
+}
+
+
+
 //////////////////////////////
 //
 // NoteGrid::cell -- Return the given cell in the grid.
 //
 
 NoteCell* NoteGrid::cell(int voiceindex, int sliceindex) {
-	return m_grid.at(voiceindex).at(sliceindex);
+	return &m_grid.at(voiceindex).at(sliceindex);
 }
 
 
@@ -54029,12 +62040,19 @@ void NoteGrid::printKernGrid(ostream& output) {
 //////////////////////////////
 //
 // NoteGrid::buildAttackIndexes -- create forward and backward
-//     note attack indexes for each cell.
+//     note attack indexes for each cell.  If indexes is false,
+//     only the attack/rest flags of the cells are set, and the
+//     attack indexes are -1.
 //
 
-void NoteGrid::buildAttackIndexes(void) {
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		buildAttackIndex(i);
+void NoteGrid::buildAttackIndexes(bool indexes) {
+	int voices = (int)m_tokens.size();
+	m_flags.resize(voices);
+	m_currattack.resize(voices);
+	m_prevattack.resize(voices);
+	m_nextattack.resize(voices);
+	for (int i=0; i<voices; i++) {
+		buildAttackIndex(i, indexes);
 	}
 }
 
@@ -54046,88 +62064,136 @@ void NoteGrid::buildAttackIndexes(void) {
 //     note attack indexes for each cell in a single voice.
 //
 
-void NoteGrid::buildAttackIndex(int vindex) {
-	vector<NoteCell*>& part = m_grid[vindex];
+void NoteGrid::buildAttackIndex(int vindex, bool indexes) {
+	vector<short>& b40  = m_base40[vindex];
+	vector<char>&  flags = m_flags[vindex];
+	vector<int>&   curr = m_currattack[vindex];
+	vector<int>&   prev = m_prevattack[vindex];
+	vector<int>&   next = m_nextattack[vindex];
+	int size = (int)b40.size();
+	flags.assign(size, 0);
+	curr.assign(size, -1);
+	prev.assign(size, -1);
+	next.assign(size, -1);
+
+	for (int i=0; i<size; i++) {
+		if (b40[i] == GRIDREST40) {
+			flags[i] |= CellRest;
+		} else if (b40[i] > 0) {
+			flags[i] |= CellAttack;
+		}
+	}
+
+	if (!indexes) {
+		for (int i=0; i<size; i++) {
+			if ((b40[i] < 0) || (flags[i] & CellRest) || (b40[i] == 0)) {
+				flags[i] |= CellSustain;
+			}
+		}
+		return;
+	}
 
 	// Set the slice index for the attack of the current note.  This
-	// will be the same as the current slice if the NoteCell is an attack.
+	// will be the same as the current slice if the cell is an attack.
 	// Otherwise if the note is a sustain, thie index will be set
-	// to the slice of the attack correspinding to this NoteCell.
+	// to the slice of the attack correspinding to this cell.
 	// For rests, the first rest in a continuous sequence of rests
 	// will be marked as the "attack" of the rest.
-	NoteCell* currentcell = NULL;
-	for (int i=0; i<(int)part.size(); i++) {
+	for (int i=0; i<size; i++) {
 		if (i == 0) {
-			part[0]->setCurrAttackIndex(0);
-			continue;
-		}
-		if (part[i]->isRest()) {
-			// This is a rest, so check for a rest sustain or start
-			// of a rest sequence.
-			if (part[i-1]->isRest()) {
-				// rest "sustain"
-				if (currentcell && !part[i]->getToken()->isNull()) {
-					currentcell->m_tiedtokens.push_back(part[i]->getToken());
-				}
-				part[i]->setCurrAttackIndex(part[i-1]->getCurrAttackIndex());
-			} else {
-				// rest "attack";
-				part[i]->setCurrAttackIndex(i);
-			}
-		} else if (part[i]->isAttack()) {
-			part[i]->setCurrAttackIndex(i);
-			currentcell = part[i];
+			curr[0] = 0;
+		} else if (flags[i] & CellRest) {
+			// rest "sustain" or rest "attack":
+			curr[i] = (flags[i-1] & CellRest) ? curr[i-1] : i;
+		} else if (flags[i] & CellAttack) {
+			curr[i] = i;
 		} else {
 			// This is a sustain, so get the attack index of the
 			// note from the previous slice index.
-			part[i]->setCurrAttackIndex(part[i-1]->getCurrAttackIndex());
-			if (currentcell && !part[i]->getToken()->isNull()) {
-				currentcell->m_tiedtokens.push_back(part[i]->getToken());
+			curr[i] = curr[i-1];
+		}
+		// Rests (and unpitched cells) are sustained unless they are
+		// the first rest in a sequence of rests.
+		if ((flags[i] & CellRest) || (b40[i] == 0)) {
+			if (curr[i] != i) {
+				flags[i] |= CellSustain;
 			}
+		} else if (b40[i] < 0) {
+			flags[i] |= CellSustain;
 		}
 	}
 
 	// start with note attacks marked in the previous and next note slots:
-	for (int i=0; i<(int)part.size(); i++) {
-		if (part[i]->isAttack()) {
-			part[i]->setNextAttackIndex(i);
-			part[i]->setPrevAttackIndex(i);
-		} else if (part[i]->isRest()) {
-			if (part[i]->getCurrAttackIndex() == i) {
-				part[i]->setNextAttackIndex(i);
-				part[i]->setPrevAttackIndex(i);
-			}
+	for (int i=0; i<size; i++) {
+		if ((flags[i] & CellAttack) || ((flags[i] & CellRest) && (curr[i] == i))) {
+			next[i] = i;
+			prev[i] = i;
 		}
 	}
 
 	// Go back and adjust the next note attack index:
 	int value = -1;
 	int temp  = -1;
-	for (int i=(int)part.size()-1; i>=0; i--) {
-		if (!part[i]->isSustained()) {
-			temp = part[i]->getNextAttackIndex();
-			part[i]->setNextAttackIndex(value);
+	for (int i=size-1; i>=0; i--) {
+		if (!(flags[i] & CellSustain)) {
+			temp = next[i];
+			next[i] = value;
 			value = temp;
 		} else {
-			part[i]->setNextAttackIndex(value);
+			next[i] = value;
 		}
 	}
 
 	// Go back and adjust the previous note attack index:
 	value = -1;
 	temp  = -1;
-	for (int i=0; i<(int)part.size(); i++) {
-		if (!part[i]->isSustained()) {
-			temp = part[i]->getPrevAttackIndex();
-			part[i]->setPrevAttackIndex(value);
+	for (int i=0; i<size; i++) {
+		if (!(flags[i] & CellSustain)) {
+			temp = prev[i];
+			prev[i] = value;
 			value = temp;
 		} else {
 			if (i != 0) {
-				part[i]->setPrevAttackIndex(part[i-1]->getPrevAttackIndex());
+				prev[i] = prev[i-1];
 			}
 		}
 	}
+}
 
+
+
+//////////////////////////////
+//
+// NoteGrid::getTiedTokens -- Return the tokens of the tied notes (and
+//    rests) which follow a note attack, up to the next note attack.
+//    Rests which follow a note are included after the first rest.
+//    An attack in the first slice, or in a grid without attack indexes,
+//    has no tied tokens.
+//
+
+vector<HTp> NoteGrid::getTiedTokens(int vindex, int sindex) {
+	vector<HTp> output;
+	vector<char>& flags = m_flags.at(vindex);
+	vector<HTp>& tokens = m_tokens.at(vindex);
+	if ((sindex == 0) || !(flags.at(sindex) & CellAttack)) {
+		return output;
+	}
+	if (m_currattack[vindex][sindex] < 0) {
+		return output;
+	}
+	for (int i=sindex+1; i<(int)flags.size(); i++) {
+		if (flags[i] & CellAttack) {
+			break;
+		}
+		if ((flags[i] & CellRest) && !(flags[i-1] & CellRest)) {
+			// rest "attack"
+			continue;
+		}
+		if (!tokens[i]->isNull()) {
+			output.push_back(tokens[i]);
+		}
+	}
+	return output;
 }
 
 
@@ -54139,7 +62205,7 @@ void NoteGrid::buildAttackIndex(int vindex) {
 //
 
 double NoteGrid::getAbsDiatonicPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getAbsDiatonicPitch();
+	return m_grid.at(vindex).at(sindex).getAbsDiatonicPitch();
 }
 
 
@@ -54151,7 +62217,7 @@ double NoteGrid::getAbsDiatonicPitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getSgnDiatonicPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getSgnDiatonicPitch();
+	return m_grid.at(vindex).at(sindex).getSgnDiatonicPitch();
 }
 
 
@@ -54163,7 +62229,7 @@ double NoteGrid::getSgnDiatonicPitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getAbsMidiPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getAbsMidiPitch();
+	return m_grid.at(vindex).at(sindex).getAbsMidiPitch();
 }
 
 
@@ -54175,7 +62241,7 @@ double NoteGrid::getAbsMidiPitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getSgnMidiPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getSgnMidiPitch();
+	return m_grid.at(vindex).at(sindex).getSgnMidiPitch();
 }
 
 
@@ -54187,7 +62253,7 @@ double NoteGrid::getSgnMidiPitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getAbsBase40Pitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getAbsBase40Pitch();
+	return m_grid.at(vindex).at(sindex).getAbsBase40Pitch();
 }
 
 
@@ -54199,7 +62265,7 @@ double NoteGrid::getAbsBase40Pitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getSgnBase40Pitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getSgnBase40Pitch();
+	return m_grid.at(vindex).at(sindex).getSgnBase40Pitch();
 }
 
 
@@ -54211,7 +62277,7 @@ double NoteGrid::getSgnBase40Pitch(int vindex, int sindex) {
 //
 
 string NoteGrid::getAbsKernPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getAbsKernPitch();
+	return m_grid.at(vindex).at(sindex).getAbsKernPitch();
 }
 
 
@@ -54223,7 +62289,7 @@ string NoteGrid::getAbsKernPitch(int vindex, int sindex) {
 //
 
 string NoteGrid::getSgnKernPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getSgnKernPitch();
+	return m_grid.at(vindex).at(sindex).getSgnKernPitch();
 }
 
 
@@ -54235,7 +62301,7 @@ string NoteGrid::getSgnKernPitch(int vindex, int sindex) {
 //
 
 HTp NoteGrid::getToken(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getToken();
+	return m_grid.at(vindex).at(sindex).getToken();
 }
 
 
@@ -54249,8 +62315,8 @@ HTp NoteGrid::getToken(int vindex, int sindex) {
 //
 
 int NoteGrid::getPrevAttackDiatonic(int vindex, int sindex) {
-	NoteCell*& cell = m_grid.at(vindex).at(sindex);
-	int index = cell->getPrevAttackIndex();
+	NoteCell& cell = m_grid.at(vindex).at(sindex);
+	int index = cell.getPrevAttackIndex();
 	if (index < 0) {
 		return 0;
 	} else {
@@ -54269,8 +62335,8 @@ int NoteGrid::getPrevAttackDiatonic(int vindex, int sindex) {
 //
 
 int NoteGrid::getNextAttackDiatonic(int vindex, int sindex) {
-	NoteCell*& cell = m_grid.at(vindex).at(sindex);
-	int index = cell->getNextAttackIndex();
+	NoteCell& cell = m_grid.at(vindex).at(sindex);
+	int index = cell.getNextAttackIndex();
 	if (index < 0) {
 		return 0;
 	} else {
@@ -54287,10 +62353,10 @@ int NoteGrid::getNextAttackDiatonic(int vindex, int sindex) {
 //
 
 int NoteGrid::getLineIndex(int sindex) {
-	if (m_grid.size() == 0) {
+	if (m_tokens.size() == 0) {
 		return -1;
 	}
-	return m_grid.at(0).at(sindex)->getToken()->getLineIndex();
+	return m_tokens.at(0).at(sindex)->getLineIndex();
 }
 
 
@@ -54302,10 +62368,10 @@ int NoteGrid::getLineIndex(int sindex) {
 //
 
 int NoteGrid::getFieldIndex(int sindex) {
-	if (m_grid.size() == 0) {
+	if (m_tokens.size() == 0) {
 		return -1;
 	}
-	return m_grid.at(0).at(sindex)->getToken()->getFieldIndex();
+	return m_tokens.at(0).at(sindex)->getFieldIndex();
 }
 
 
@@ -54385,6 +62451,29 @@ HumNum NoteGrid::getNoteDuration(int vindex, int sindex) {
 
 
 
+//////////////////////////////
+//
+// NoteGrid::getStorageSize -- Return the number of bytes allocated
+//    for the cells of the grid.
+//
+
+size_t NoteGrid::getStorageSize(void) {
+	size_t output = m_meters.capacity() * sizeof(m_meters[0]);
+	for (int i=0; i<getVoiceCount(); i++) {
+		output += m_grid[i].capacity()       * sizeof(NoteCell);
+		output += m_tokens[i].capacity()     * sizeof(HTp);
+		output += m_base40[i].capacity()     * sizeof(short);
+		output += m_flags[i].capacity()      * sizeof(char);
+		output += m_prevattack[i].capacity() * sizeof(int);
+		output += m_currattack[i].capacity() * sizeof(int);
+		output += m_nextattack[i].capacity() * sizeof(int);
+		output += m_meter[i].capacity()      * sizeof(short);
+	}
+	return output;
+}
+
+
+
 //////////////////////////////
 //
 // NoteGrid::printGridInfo -- for debugging.
@@ -56277,7 +64366,7 @@ PixelColor PixelColor::getColor(const string& colorstring) {
 	int length = (int)colorstring.size();
 	if (length > 128) {
 		cout << "ERROR: color string too long: " << colorstring << endl;
-		exit(1);
+		return output;
 	}
 	if (length == 7) {
 		if (colorstring[0] == '#') {
@@ -60323,8 +68412,7 @@ bool Tool_autobeam::run(HumdrumFile& infile) {
 		addBeams(infile);
 	}
 	// Re-load the text for each line from their tokens.
-	infile.createLinesFromTokens();
-	m_humdrum_text << infile;
+	printEditedFile(infile);
 	return true;
 }
 
@@ -64838,7 +72926,8 @@ void Tool_autostem::getNotePositions(vector<vector<vector<int> > >& notepos,
 
 void Tool_autostem::processKernTokenStems(HumdrumFile& infile,
 		vector<vector<int> >& baseline, int row, int col) {
-	exit(1);
+	// not implemented: see processKernTokenStemsSimpleModel()
+	m_error_text << "Error: processKernTokenStems is not implemented" << endl;
 }
 
 
@@ -65259,8 +73348,8 @@ bool Tool_autostem::getBeamState(vector<vector<string > >& beams,
 				// grace notes;
 				countBeamStuff(infile.token(i, j)->c_str(), start, stop, flagr, flagl);
 				if ((start != 0) && (stop != 0)) {
-					cerr << "Funny error in grace note beam calculation" << endl;
-					exit(1);
+					m_error_text << "Funny error in grace note beam calculation" << endl;
+					return false;
 				}
 				if (start > 7) {
 					cerr << "Too many beam starts" << endl;
@@ -65300,8 +73389,8 @@ bool Tool_autostem::getBeamState(vector<vector<string > >& beams,
 				}
 				len = (int)gbinfo.size();
 				if (len > 6) {
-					cerr << "Error too many grace note beams" << endl;
-					exit(1);
+					m_error_text << "Error too many grace note beams" << endl;
+					return false;
 				}
 				beams.at(i).at(j) = gbinfo;
 				gracestate.at(track).at(curlayer.at(track)) = contin;
@@ -65313,8 +73402,8 @@ bool Tool_autostem::getBeamState(vector<vector<string > >& beams,
 
 				countBeamStuff(infile.token(i, j)->c_str(), start, stop, flagr, flagl);
 				if ((start != 0) && (stop != 0)) {
-					cerr << "Funny error in note beam calculation" << endl;
-					exit(1);
+					m_error_text << "Funny error in note beam calculation" << endl;
+					return false;
 				}
 				if (start > 7) {
 					cerr << "Too many beam starts" << endl;
@@ -68017,8 +76106,7 @@ bool Tool_chord::run(HumdrumFile& infile, ostream& out) {
 bool Tool_chord::run(HumdrumFile& infile) {
 	initialize();
 	processFile(infile, m_direction);
-	infile.createLinesFromTokens();
-	m_humdrum_text << infile;
+	printEditedFile(infile);
 	return true;
 }
 
@@ -68424,7 +76512,7 @@ bool Tool_cint::run(HumdrumFile& infile) {
 		// getAllText(cout);
 	} else {
 		// Re-load the text for each line from their tokens.
-		cout << infile;
+		m_humdrum_text << infile;
 	}
 
 	return true;
@@ -68505,7 +76593,9 @@ string NoteNode::getId(void) {
 
 int Tool_cint::processFile(HumdrumFile& infile) {
 
-   initialize();
+	if (!initialize()) {
+		return 0;
+	}
 
 	vector<vector<NoteNode> > notes;
 	vector<string> names;
@@ -68548,7 +76638,7 @@ int Tool_cint::processFile(HumdrumFile& infile) {
 
 	if (pitchesQ) {
 		printPitchGrid(notes, infile);
-		exit(0);
+		return 0;
 	}
 
 	int count = 0;
@@ -70877,25 +78967,27 @@ void Tool_cint::getNames(vector<string>& names, vector<int>& reverselookup,
 //////////////////////////////
 //
 // Tool_cint::initialize -- validate and process command-line options.
+//     Returns false if the file should not be processed (for options
+//     such as --help).
 //
 
-void Tool_cint::initialize(void) {
+bool Tool_cint::initialize(void) {
 
 	// handle basic options:
 	if (getBoolean("author")) {
 		m_humdrum_text << "Written by Craig Stuart Sapp, "
 			  << "craig@ccrma.stanford.edu, September 2013" << endl;
-		exit(0);
+		return false;
 	} else if (getBoolean("version")) {
 		m_humdrum_text << getCommand() << ", version: 16 March 2022" << endl;
 		m_humdrum_text << "compiled: " << __DATE__ << endl;
-		exit(0);
+		return false;
 	} else if (getBoolean("help")) {
 		usage(getCommand());
-		exit(0);
+		return false;
 	} else if (getBoolean("example")) {
 		example();
-		exit(0);
+		return false;
 	}
 
 	koptionQ = getBoolean("koption");
@@ -70991,6 +79083,7 @@ void Tool_cint::initialize(void) {
 		SearchString = getString("search");
 	}
 
+	return true;
 }
 
 
@@ -72563,9 +80656,9 @@ void Tool_cmr::printVegaPlot(void) {
 		  "description": "A vertical box plot showing median, min, and max CMR count in Josquin.",
 		  "data": {
 		    "values": [)";
-		cout << vegaDataHeader << endl;
+		m_free_text << vegaDataHeader << endl;
 
-		cout << m_vegaData.str() << endl;
+		m_free_text << m_vegaData.str() << endl;
 
 		if (m_vegaCountQ) {
 			string vegaDataFooter = R"(
@@ -72585,7 +80678,7 @@ void Tool_cmr::printVegaPlot(void) {
 			 }
 		 })";
 
-		 cout << vegaDataFooter << endl;
+		 m_free_text << vegaDataFooter << endl;
 	 } else	if (m_vegaStrengthQ) {
 	 			string vegaDataFooter = R"(
 	 			]},
@@ -72604,7 +80697,7 @@ void Tool_cmr::printVegaPlot(void) {
 	 			 }
 	 		 })";
 
-		cout << vegaDataFooter << endl;
+		m_free_text << vegaDataFooter << endl;
 	 	} else {
 			string vegaDataFooter = R"(
 		 ]},
@@ -72622,7 +80715,7 @@ void Tool_cmr::printVegaPlot(void) {
 				}
 			}
 		})";
-			cout << vegaDataFooter << endl;
+			m_free_text << vegaDataFooter << endl;
 	 }
 }
 
@@ -72647,7 +80740,7 @@ void Tool_cmr::printHtmlPlot(void) {
 <div id="plotarea"></div>
 <script type="text/javascript">
 var mydata =)";
-	cout << header << endl;
+	m_free_text << header << endl;
 
 	printVegaPlot();
 
@@ -72655,7 +80748,7 @@ var mydata =)";
 </script>
 </body>
 </html>)";
-	cout << footer << endl;
+	m_free_text << footer << endl;
 }
 
 
@@ -72683,10 +80776,10 @@ void Tool_cmr::finally(void) {
 		double meanCmrNoteDen = Convert::mean(cmrNoteDensities);
 		double stdDevCmrNoteDen = Convert::standardDeviation(cmrNoteDensities);
 
-		cout << "CMR count mean: " << meanCmrCount << endl;
-		cout << "CMR count standard deviation: " << stdDevCmrCount << endl;
-		cout << "CMR note density mean: " << meanCmrNoteDen * 1000 << " permil " << endl;
-		cout << "CMR note density standard deviation: " << stdDevCmrNoteDen * 1000 << " permil " << endl;
+		m_free_text << "CMR count mean: " << meanCmrCount << endl;
+		m_free_text << "CMR count standard deviation: " << stdDevCmrCount << endl;
+		m_free_text << "CMR note density mean: " << meanCmrNoteDen * 1000 << " permil " << endl;
+		m_free_text << "CMR note density standard deviation: " << stdDevCmrNoteDen * 1000 << " permil " << endl;
 	}
 
 }
@@ -86295,11 +94388,7 @@ bool Tool_double::run(HumdrumFile& infile) {
 	processFile(infile);
 
 	// Re-load the text for each line from their tokens.
-	infile.createLinesFromTokens();
-
-	// Need to adjust the line numbers for tokens for later
-	// processing.
-	m_humdrum_text << infile;
+	printEditedFile(infile);
 	return true;
 }
 
@@ -91028,6 +99117,8 @@ Tool_extract::Tool_extract(void) {
 	define("version=b",                 "compilation info");
 	define("example=b",                 "example usages");
 	define("h|help=b",                  "short description");
+
+	setRequiredAnalyses(0);
 }
 
 
@@ -95144,28 +103235,15 @@ const vector<FiguredBassAbbreviationMapping> FiguredBassAbbreviationMapping::s_m
 #define RUNTOOL(NAME, INFILE, COMMAND, STATUS)     \
 	Tool_##NAME *tool = new Tool_##NAME;            \
 	tool->process(COMMAND);                         \
+	startStage(INFILE);                             \
 	tool->run(INFILE);                              \
 	if (tool->hasError()) {                         \
 		status = false;                              \
-		tool->getError(cerr);                        \
-		delete tool;                                 \
-		break;                                       \
-	} else if (tool->hasHumdrumText()) {            \
-		INFILE.readString(tool->getHumdrumText());   \
-	}                                               \
-	delete tool;
-
-#define RUNTOOL2(NAME, INFILE1, INFILE2, COMMAND, STATUS) \
-	Tool_##NAME *tool = new Tool_##NAME;            \
-	tool->process(COMMAND);                         \
-	tool->run(INFILE1, INFILE2);                    \
-	if (tool->hasError()) {                         \
-		status = false;                              \
-		tool->getError(cerr);                        \
+		tool->getError(getStageErrorStream());       \
 		delete tool;                                 \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
-		INFILE1.readString(tool->getHumdrumText());  \
+		finishStage(INFILE, tool->getHumdrumText()); \
 	}                                               \
 	delete tool;
 
@@ -95175,7 +103253,7 @@ const vector<FiguredBassAbbreviationMapping> FiguredBassAbbreviationMapping::s_m
 	tool->run(INFILES);                             \
 	if (tool->hasError()) {                         \
 		status = false;                              \
-		tool->getError(cerr);                        \
+		tool->getError(getStageErrorStream());       \
 		delete tool;                                 \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
@@ -95189,7 +103267,7 @@ const vector<FiguredBassAbbreviationMapping> FiguredBassAbbreviationMapping::s_m
 	tool->run(INFILES);                                \
 	if (tool->hasError()) {                            \
 		status = false;                                 \
-		tool->getError(cerr);                           \
+		tool->getError(getStageErrorStream());          \
 		delete tool;                                    \
 		break;                                          \
 	} else if (tool->hasHumdrumText()) {               \
@@ -95207,6 +103285,8 @@ const vector<FiguredBassAbbreviationMapping> FiguredBassAbbreviationMapping::s_m
 Tool_filter::Tool_filter(void) {
 	define("debug=b",      "print debug statement");
 	define("v|variant=s:", "Run filters labeled with the given variant");
+	define("R|reparse=b",  "Re-read the data after each filter stage");
+	define("j|jobs=i:1",   "Number of files to filter in parallel (0 = all cores)");
 }
 
 
@@ -95276,240 +103356,25 @@ bool Tool_filter::run(HumdrumFileSet& infiles) {
 	bool status = true;
 	vector<pair<string, string> > commands;
 	getCommandList(commands, infile);
+	startAnalyses(infile);
 	for (int i=0; i<(int)commands.size(); i++) {
-		if (commands[i].first == "addic") {
-			RUNTOOL(addic, infile, commands[i].second, status);
-		} else if (commands[i].first == "addkey") {
-			RUNTOOL(addkey, infile, commands[i].second, status);
-		} else if (commands[i].first == "addlabels") {
-			RUNTOOL(addlabels, infile, commands[i].second, status);
-		} else if (commands[i].first == "addtempo") {
-			RUNTOOL(addtempo, infile, commands[i].second, status);
-		} else if (commands[i].first == "autoaccid") {
-			RUNTOOL(autoaccid, infile, commands[i].second, status);
-		} else if (commands[i].first == "autobeam") {
-			RUNTOOL(autobeam, infile, commands[i].second, status);
-		} else if (commands[i].first == "autocadence") {
-			RUNTOOL(autocadence, infile, commands[i].second, status);
-		} else if (commands[i].first == "autostem") {
-			RUNTOOL(autostem, infile, commands[i].second, status);
-		} else if (commands[i].first == "barnum") {
-			RUNTOOL(barnum, infile, commands[i].second, status);
-		} else if (commands[i].first == "bstyle") {
-			RUNTOOL(bstyle, infile, commands[i].second, status);
-		} else if (commands[i].first == "binroll") {
-			RUNTOOL(binroll, infile, commands[i].second, status);
-		} else if (commands[i].first == "chantize") {
-			RUNTOOL(chantize, infile, commands[i].second, status);
-		} else if (commands[i].first == "chint") {
-			RUNTOOL(chint, infile, commands[i].second, status);
-		} else if (commands[i].first == "chord") {
-			RUNTOOL(chord, infile, commands[i].second, status);
-		} else if (commands[i].first == "cint") {
-			RUNTOOL(cint, infile, commands[i].second, status);
-		} else if (commands[i].first == "cmr") {
-			RUNTOOL(cmr, infile, commands[i].second, status);
-		} else if (commands[i].first == "composite") {
-			RUNTOOL(composite, infile, commands[i].second, status);
-		} else if (commands[i].first == "dissonant") {
-			RUNTOOL(dissonant, infile, commands[i].second, status);
-		} else if (commands[i].first == "double") {
-			RUNTOOL(double, infile, commands[i].second, status);
-		} else if (commands[i].first == "extremis") {
-			RUNTOOL(extremis, infile, commands[i].second, status);
-		} else if (commands[i].first == "fb") {
-			RUNTOOL(fb, infile, commands[i].second, status);
-		} else if (commands[i].first == "flipper") {
-			RUNTOOL(flipper, infile, commands[i].second, status);
-		} else if (commands[i].first == "filter") {
-			RUNTOOL(filter, infile, commands[i].second, status);
-		} else if (commands[i].first == "gasparize") {
-			RUNTOOL(gasparize, infile, commands[i].second, status);
-		} else if (commands[i].first == "half") {
-			RUNTOOL(half, infile, commands[i].second, status);
-		} else if (commands[i].first == "hands") {
-			RUNTOOL(hands, infile, commands[i].second, status);
-		} else if (commands[i].first == "homorhythm") {
-			RUNTOOL(homorhythm, infile, commands[i].second, status);
-		} else if (commands[i].first == "homorhythm2") {
-			RUNTOOL(homorhythm2, infile, commands[i].second, status);
-		} else if (commands[i].first == "hproof") {
-			RUNTOOL(hproof, infile, commands[i].second, status);
-		} else if (commands[i].first == "humbreak") {
-			RUNTOOL(humbreak, infile, commands[i].second, status);
-		} else if (commands[i].first == "humsheet") {
-			RUNTOOL(humsheet, infile, commands[i].second, status);
-		} else if (commands[i].first == "humtr") {
-			RUNTOOL(humtr, infile, commands[i].second, status);
-		} else if (commands[i].first == "imitation") {
-			RUNTOOL(imitation, infile, commands[i].second, status);
-		} else if (commands[i].first == "instinfo") {
-			RUNTOOL(instinfo, infile, commands[i].second, status);
-		} else if (commands[i].first == "kern2mens") {
-			RUNTOOL(kern2mens, infile, commands[i].second, status);
-		} else if (commands[i].first == "kernify") {
-			RUNTOOL(kernify, infile, commands[i].second, status);
-		} else if (commands[i].first == "kernview") {
-			RUNTOOL(kernview, infile, commands[i].second, status);
-		} else if (commands[i].first == "melisma") {
-			RUNTOOL(melisma, infile, commands[i].second, status);
-		} else if (commands[i].first == "mens2kern") {
-			RUNTOOL(mens2kern, infile, commands[i].second, status);
-		} else if (commands[i].first == "meter") {
-			RUNTOOL(meter, infile, commands[i].second, status);
-		} else if (commands[i].first == "metlev") {
-			RUNTOOL(metlev, infile, commands[i].second, status);
-		} else if (commands[i].first == "mint") { // humlib version of Humdrum Toolkit mint tool
-			RUNTOOL(mint, infile, commands[i].second, status);
-		} else if (commands[i].first == "mintx") { // humlib cli name
-			RUNTOOL(mint, infile, commands[i].second, status);
-		} else if (commands[i].first == "modori") {
-			RUNTOOL(modori, infile, commands[i].second, status);
-		} else if (commands[i].first == "msearch") {
-			RUNTOOL(msearch, infile, commands[i].second, status);
-		} else if (commands[i].first == "nproof") {
-			RUNTOOL(nproof, infile, commands[i].second, status);
-		} else if (commands[i].first == "ordergps") {
-			RUNTOOL(ordergps, infile, commands[i].second, status);
-		} else if (commands[i].first == "pbar") {
-			RUNTOOL(pbar, infile, commands[i].second, status);
-		} else if (commands[i].first == "phrase") {
-			RUNTOOL(phrase, infile, commands[i].second, status);
-		} else if (commands[i].first == "pline") {
-			RUNTOOL(pline, infile, commands[i].second, status);
-		} else if (commands[i].first == "prange") {
-			RUNTOOL(prange, infile, commands[i].second, status);
-		} else if (commands[i].first == "recip") {
-			RUNTOOL(recip, infile, commands[i].second, status);
-		} else if (commands[i].first == "rmask") {
-			RUNTOOL(rmask, infile, commands[i].second, status);
-		} else if (commands[i].first == "restfill") {
-			RUNTOOL(restfill, infile, commands[i].second, status);
-		} else if (commands[i].first == "rphrase") {
-			RUNTOOL(rphrase, infile, commands[i].second, status);
-		} else if (commands[i].first == "sab2gs") {
-			RUNTOOL(sab2gs, infile, commands[i].second, status);
-		} else if (commands[i].first == "scordatura") {
-			RUNTOOL(scordatura, infile, commands[i].second, status);
-		} else if (commands[i].first == "semitones") {
-			RUNTOOL(semitones, infile, commands[i].second, status);
-		} else if (commands[i].first == "shed") {
-			RUNTOOL(shed, infile, commands[i].second, status);
-		} else if (commands[i].first == "sic") {
-			RUNTOOL(sic, infile, commands[i].second, status);
-		} else if (commands[i].first == "simat") {
-			RUNTOOL2(simat, infile, infile, commands[i].second, status);
-		} else if (commands[i].first == "slurcheck") {
-			RUNTOOL(slurcheck, infile, commands[i].second, status);
-		} else if (commands[i].first == "slur") {
-			RUNTOOL(slurcheck, infile, commands[i].second, status);
-		} else if (commands[i].first == "spinetrace") {
-			RUNTOOL(spinetrace, infile, commands[i].second, status);
-		} else if (commands[i].first == "strophe") {
-			RUNTOOL(strophe, infile, commands[i].second, status);
-		} else if (commands[i].first == "synco") {
-			RUNTOOL(synco, infile, commands[i].second, status);
-		} else if (commands[i].first == "tabber") {
-			RUNTOOL(tabber, infile, commands[i].second, status);
-		} else if (commands[i].first == "tandeminfo") {
-			RUNTOOL(tandeminfo, infile, commands[i].second, status);
-		} else if (commands[i].first == "tassoize") {
-			RUNTOOL(tassoize, infile, commands[i].second, status);
-		} else if (commands[i].first == "tassoise") {
-			RUNTOOL(tassoize, infile, commands[i].second, status);
-		} else if (commands[i].first == "tasso") {
-			RUNTOOL(tassoize, infile, commands[i].second, status);
-		} else if (commands[i].first == "text") {
-			RUNTOOL(text, infile, commands[i].second, status);
-		} else if (commands[i].first == "textdur") {
-			RUNTOOL(textdur, infile, commands[i].second, status);
-		} else if (commands[i].first == "tie") {
-			RUNTOOL(tie, infile, commands[i].second, status);
-		} else if (commands[i].first == "triad") {
-			RUNTOOL(triad, infile, commands[i].second, status);
-		} else if (commands[i].first == "tspos") {
-			RUNTOOL(tspos, infile, commands[i].second, status);
-		} else if (commands[i].first == "transpose") {
-			RUNTOOL(transpose, infile, commands[i].second, status);
-		} else if (commands[i].first == "tremolo") {
-			RUNTOOL(tremolo, infile, commands[i].second, status);
-		} else if (commands[i].first == "trillspell") {
-			RUNTOOL(trillspell, infile, commands[i].second, status);
-		} else if (commands[i].first == "vcross") {
-			RUNTOOL(vcross, infile, commands[i].second, status);
-		} else if (commands[i].first == "1520ify") {
-			RUNTOOL(1520ify, infile, commands[i].second, status);
-
-		// filters with aliases:
-
-		} else if (commands[i].first == "colortriads") {
-			RUNTOOL(colortriads, infile, commands[i].second, status);
-		} else if (commands[i].first == "colourtriads") {
-			// British spelling
-			RUNTOOL(colortriads, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "colorthirds") {
-			RUNTOOL(tspos, infile, commands[i].second, status);
-		} else if (commands[i].first == "colourthirds") {
-			// British spelling
-			RUNTOOL(tspos, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "colorgroups") {
-			RUNTOOL(colorgroups, infile, commands[i].second, status);
-		} else if (commands[i].first == "colourgroups") { // British spelling
-			RUNTOOL(colorgroups, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "deg") { // humlib version of Humdrum Toolkit deg tool
-			RUNTOOL(deg, infile, commands[i].second, status);
-		} else if (commands[i].first == "degx") { // humlib cli name
-			RUNTOOL(deg, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "extract") { // humlib version of Humdrum Toolkit extract tool
-			RUNTOOL(extract, infile, commands[i].second, status);
-		} else if (commands[i].first == "extractx") { // humlib cli name
-			RUNTOOL(extract, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "grep") {
-			RUNTOOL(grep, infile, commands[i].second, status);
-		} else if (commands[i].first == "humgrep") {
-			RUNTOOL(grep, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "myank") { // humlib version of Humdrum Extras myank tool
-			RUNTOOL(myank, infile, commands[i].second, status);
-		} else if (commands[i].first == "myankx") { // humlib cli name
-			RUNTOOL(myank, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "rid") { // humlib version of Humdrum Toolkit deg tool
-			RUNTOOL(rid, infile, commands[i].second, status);
-		} else if (commands[i].first == "ridx") { // Humdrum Extra cli name
-			RUNTOOL(rid, infile, commands[i].second, status);
-		} else if (commands[i].first == "ridxx") { // humlib cli name
-			RUNTOOL(rid, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "satb2gs") { // humlib version of Humdrum Extras satg2gs tool
-			RUNTOOL(satb2gs, infile, commands[i].second, status);
-		} else if (commands[i].first == "satb2gsx") { // humlib cli name
-			RUNTOOL(satb2gs, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "thru") { // humlib version of Humdrum Toolkit thru tool
-			RUNTOOL(thru, infile, commands[i].second, status);
-		} else if (commands[i].first == "thrux") { // Humdrum Extras cli name
-			RUNTOOL(thru, infile, commands[i].second, status);
-		} else if (commands[i].first == "thruxx") { // humlib cli name
-			RUNTOOL(thru, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "timebase") { // humlib version of Humdrum Toolkit timebase tool
-			RUNTOOL(timebase, infile, commands[i].second, status);
-		} else if (commands[i].first == "timebasex") { // humlib cli name
-			RUNTOOL(timebase, infile, commands[i].second, status);
-		} else {
-			cerr << "UNKNOWN FILTER: " << commands[i].first << " OPTIONS: " << commands[i].second << endl;
+		const HumToolRegistry::Entry* entry = HumToolRegistry::getEntry(commands[i].first);
+		if (!entry) {
+			(m_batchQ ? m_warning_text : cerr) << "UNKNOWN FILTER: " << commands[i].first << " OPTIONS: " << commands[i].second << endl;
+			continue;
+		}
+		if (!runStage(*entry, infile, commands[i].second)) {
+			status = false;
+			break;
 		}
-
 	}
 
 	removeGlobalFilterLines(infile);
 
+	// Files filtered by runBatch() are only printed, so they do not
+	// need the analyses which were skipped by the stages:
+	finishAnalyses(infile, !m_batchQ);
+
 	// Re-load the text for each line from their tokens in case any
 	// updates are needed from token changes.
 	infile.createLinesFromTokens();
@@ -95518,6 +103383,480 @@ bool Tool_filter::run(HumdrumFileSet& infiles) {
 
 
 
+//////////////////////////////
+//
+// Tool_filter::runPipeline -- Run a pipeline of tools (such as
+//     "autobeam | transpose -t M2") on a file, as if the pipeline were
+//     given in a !!!filter: line of the file.  The filtered file is
+//     stored in the Humdrum text of the filter, and the JSON and free text
+//     of the last tool are stored in the JSON and free text of the filter
+//     (the filtered file is not stored if the last tool only printed JSON
+//     or free text).  Warnings from all tools are stored in the warning
+//     text of the filter.  As for the files of runBatch(), errors are
+//     stored in the error text rather than being printed, and unknown
+//     tool options are ignored rather than ending the program, so this
+//     function can be used by long-running programs (see HumToolServer).
+//     Returns false if a tool is not found or has an error.
+//
+
+bool Tool_filter::runPipeline(HumdrumFile& infile, const string& pipeline) {
+	initialize(infile);
+	bool batch = m_batchQ;
+	m_batchQ = true;
+
+	bool status = true;
+	bool humdrum = true;
+	string json;
+	string text;
+	vector<string> clist;
+	splitPipeline(clist, pipeline);
+	startAnalyses(infile);
+	HumRegex hre;
+	for (int i=0; i<(int)clist.size(); i++) {
+		if (!hre.search(clist[i], "^\\s*([^\\s]+)")) {
+			continue;
+		}
+		string name = hre.getMatch(1);
+		const HumToolRegistry::Entry* entry = HumToolRegistry::getEntry(name);
+		if (!entry) {
+			m_error_text << "UNKNOWN TOOL: " << name << endl;
+			status = false;
+			break;
+		}
+		status = runStage(*entry, infile, clist[i]);
+		HumTool* tool = m_tools[entry->tool].get();
+		if (tool->hasWarning()) {
+			tool->getWarning(m_warning_text);
+		}
+		if (!status) {
+			break;
+		}
+		json = tool->getJsonText();
+		text = tool->getFreeText();
+		humdrum = tool->hasHumdrumText() || tool->hasInPlaceOutput() ||
+				(json.empty() && text.empty());
+	}
+	m_batchQ = batch;
+	finishAnalyses(infile, true);
+
+	if (!status) {
+		return false;
+	}
+	if (humdrum) {
+		infile.createLinesFromTokens();
+		m_humdrum_text << infile;
+	}
+	m_json_text << json;
+	m_free_text << text;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::runStage -- Run one filter stage on the file.  Returns
+//     false if the tool had an error.
+//
+
+bool Tool_filter::runStage(const HumToolRegistry::Entry& entry,
+		HumdrumFile& infile, const string& command) {
+	HumTool* tool = getStageTool(entry);
+	if (m_batchQ) {
+		// Do not exit on unknown options or --options:
+		tool->process(command, 0, 1);
+	} else {
+		tool->process(command);
+	}
+	tool->setInPlaceOutput(entry.inplace && !m_reparseQ);
+	if (tool->hasRequiredAnalyses()) {
+		infile.requireAnalyses(tool->getRequiredAnalyses());
+	} else {
+		infile.requireAnalyses(m_stageAnalyses);
+	}
+	startStage(infile);
+	entry.run(tool, infile);
+	if (tool->hasError()) {
+		tool->getError(getStageErrorStream());
+		return false;
+	} else if (tool->hasHumdrumText()) {
+		finishStage(infile, tool->getHumdrumText());
+	} else {
+		finishStage(infile);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::getStageTool -- Return the instance of the tool for a filter
+//     stage.  Each tool is created once by the filter and then reset for
+//     later stages and files.
+//
+
+HumTool* Tool_filter::getStageTool(const HumToolRegistry::Entry& entry) {
+	std::unique_ptr<HumTool>& tool = m_tools[entry.tool];
+	if (tool) {
+		entry.reset(tool.get());
+	} else {
+		tool.reset(entry.create());
+	}
+	return tool.get();
+}
+
+
+
+// ToolFilterBatchFile: one file being filtered by runBatch().
+struct ToolFilterBatchFile {
+	HumdrumFile infile;
+	std::string output;
+	std::string error;
+	std::string warning;
+	bool        status = true;
+	bool        done   = false;
+};
+
+
+
+//////////////////////////////
+//
+// Tool_filter::runBatch -- Run the filters of each file read from the
+//     input stream, using a pool of threads to filter up to the given
+//     number of files at the same time (0 = all cores).  Each thread
+//     filters its files with its own Tool_filter object, which has a
+//     copy of the options of this one and keeps its tools for the next
+//     file.  The filtered files are written to the output stream in the
+//     order of the input, and at most "window" files (default four per
+//     thread) are read but not yet written at any time, so memory use
+//     does not depend on the number of files.  Files with errors are not
+//     written: their errors (and any warnings) are printed in file order,
+//     and errors are stored for getBatchErrors().  Returns false if any
+//     file had an error.
+//
+
+bool Tool_filter::runBatch(HumdrumFileStream& instream, ostream& out,
+		int jobs, int window) {
+	m_batchErrors.clear();
+	int threads = jobs;
+	if (threads <= 0) {
+		threads = HumThreadPool::getHardwareThreadCount();
+	}
+	if (window <= 0) {
+		window = 4 * threads;
+	}
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::deque<std::shared_ptr<ToolFilterBatchFile>> files;
+	bool status = true;
+
+	std::unique_ptr<HumThreadPool> pool;
+	if (threads > 1) {
+		pool.reset(new HumThreadPool(threads));
+	}
+
+	// Filters for each worker thread of the pool, with the last one for
+	// files which are filtered in this thread.  Each filter is created
+	// when its thread filters its first file.
+	std::vector<std::unique_ptr<Tool_filter>> filters(threads + 1);
+
+	// Filter a file, storing the results with the file:
+	auto filterFile = [this, &pool, &mutex, &finished, &filters](std::shared_ptr<ToolFilterBatchFile> file) {
+		int index = pool ? pool->getWorkerIndex() : -1;
+		std::unique_ptr<Tool_filter>& pfilter = (index < 0) ? filters.back() : filters[index];
+		if (!pfilter) {
+			pfilter.reset(new Tool_filter);
+			pfilter->Options::operator=(*this);
+			pfilter->m_batchQ = true;
+		}
+		Tool_filter& filter = *pfilter;
+		filter.clearOutput();
+		stringstream output;
+		try {
+			file->status = filter.run(file->infile);
+			if (filter.hasAnyText()) {
+				filter.getAllText(output);
+			} else {
+				output << file->infile;
+			}
+		} catch (const std::exception& e) {
+			file->status = false;
+			filter.setError(e.what());
+		}
+		if (filter.hasWarning()) {
+			file->warning = filter.getWarning();
+		}
+		if (filter.hasError()) {
+			file->status = false;
+			file->error = file->infile.getFilename() + ": " + filter.getError();
+		} else if (!file->status) {
+			file->error = file->infile.getFilename() + ": filter failed";
+		}
+		if (file->status) {
+			file->output = output.str();
+		}
+		file->infile.clear();
+		std::lock_guard<std::mutex> lock(mutex);
+		file->done = true;
+		finished.notify_all();
+	};
+
+	// Write finished files in input order until at most "count" remain:
+	auto writeFiles = [&](int count) {
+		while ((int)files.size() > count) {
+			std::shared_ptr<ToolFilterBatchFile> file = files.front();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				finished.wait(lock, [&file]() { return file->done; });
+			}
+			files.pop_front();
+			out << file->output;
+			cerr << file->warning;
+			if (!file->status) {
+				status = false;
+				cerr << file->error << endl;
+				m_batchErrors.push_back(file->error);
+			}
+		}
+	};
+
+	while (true) {
+		std::shared_ptr<ToolFilterBatchFile> file = std::make_shared<ToolFilterBatchFile>();
+		if (!instream.read(file->infile)) {
+			break;
+		}
+		files.push_back(file);
+		if (pool) {
+			pool->submit([&filterFile, file]() { filterFile(file); });
+		} else {
+			filterFile(file);
+		}
+		writeFiles(window - 1);
+	}
+	writeFiles(0);
+	if (pool) {
+		pool->wait();
+	}
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::getBatchErrors -- Return the error messages for the files
+//     filtered by the last call to runBatch().
+//
+
+const vector<string>& Tool_filter::getBatchErrors(void) const {
+	return m_batchErrors;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::getStageErrorStream -- Return the stream for error messages
+//     from filter stages: the error text of the filter when filtering a
+//     file in runBatch(), or else standard error.
+//
+
+ostream& Tool_filter::getStageErrorStream(void) {
+	if (m_batchQ) {
+		return m_error_text;
+	}
+	return cerr;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::startAnalyses -- Prepare a file for the stages of the
+//     filter.  Files which are read again (or re-analyzed) after a stage
+//     are not analyzed when read, and each stage then does the analyses
+//     which its tool uses: the analyses declared by the tool with
+//     HumTool::setRequiredAnalyses(), or else the analyses of the file
+//     when it is read (see HumdrumFileBase::getReadAnalyses()).
+//
+
+void Tool_filter::startAnalyses(HumdrumFile& infile) {
+	m_fileAnalyses = infile.getReadAnalyses();
+	m_stageAnalyses = 0;
+	infile.setReadAnalyses(0);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::finishAnalyses -- Restore the read analyses of the file
+//     after the filter stages, and do any read analyses which were
+//     skipped by the stages if "analyze" is true.
+//
+
+void Tool_filter::finishAnalyses(HumdrumFile& infile, bool analyze) {
+	infile.setReadAnalyses(m_fileAnalyses);
+	if (analyze) {
+		infile.requireAnalyses(m_stageAnalyses);
+	}
+	m_stageAnalyses = 0;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::startStage -- Store the lines and tokens of the file
+//     before running a filter stage, along with the text of spine
+//     manipulators and exclusive interpretations, so that finishStage()
+//     can check if the spine structure of the file was changed.  The
+//     edited-token mark of the file is cleared, so that finishStage() can
+//     check if the tool changed any tokens.
+//
+
+void Tool_filter::startStage(HumdrumFile& infile) {
+	m_stageLines.clear();
+	m_stageTokens.clear();
+	m_stageSpines.clear();
+	infile.setEditedTokens(false);
+	for (int i=0; i<infile.getLineCount(); i++) {
+		HLp line = &infile[i];
+		m_stageLines.push_back(line);
+		int count = line->getFieldCount();
+		for (int j=0; j<count; j++) {
+			m_stageTokens.push_back(line->token(j));
+		}
+		if (line->isManipulator() || line->isExclusiveInterpretation()) {
+			m_stageSpines.push_back(getTokenText(line));
+		}
+	}
+}
+
+
+void Tool_filter::startStage(HumdrumFileSet& infiles) {
+	// do nothing: sets of files are always re-read.
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::finishStage -- Update the file after a filter stage.  If
+//     the tool printed Humdrum text, the text is parsed into the file.
+//     Otherwise the tool either edited the file in place (for tools
+//     registered as in-place tools, see HumToolRegistry::Entry::inplace
+//     and HumTool::setInPlaceOutput()), or only printed other text, and
+//     the file is used as it is.  If the lines, tokens and spine
+//     structure of the file are unchanged, only the token analyses are
+//     redone, and only when the tool changed the text of a token (see
+//     HumdrumFileBase::hasEditedTokens()).  If lines were added or removed
+//     or the spine structure was changed, the file is parsed again from
+//     its text, which is also done for all edited files when the -R option
+//     is given.
+//
+
+void Tool_filter::finishStage(HumdrumFile& infile, const string& output) {
+	infile.readString(output);
+	m_stageAnalyses = m_fileAnalyses;
+}
+
+
+void Tool_filter::finishStage(HumdrumFile& infile) {
+	if (isStageInPlace(infile)) {
+		if (!infile.hasEditedTokens()) {
+			return;
+		}
+		if (!m_reparseQ) {
+			infile.reanalyzeTokens();
+			m_stageAnalyses = m_fileAnalyses;
+			return;
+		}
+	}
+	infile.createLinesFromTokens();
+	stringstream text;
+	text << infile;
+	infile.readString(text.str());
+	m_stageAnalyses = m_fileAnalyses;
+}
+
+
+void Tool_filter::finishStage(HumdrumFileSet& infiles, const string& output) {
+	infiles.readString(output);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::isStageInPlace -- Returns true if the file has the same
+//     lines, tokens, spine manipulators and exclusive interpretations as
+//     when startStage() was called, and all tokens can be parsed back
+//     from the text of their lines.
+//
+
+bool Tool_filter::isStageInPlace(HumdrumFile& infile) {
+	if (m_stageLines.empty() || !infile.isValid()) {
+		return false;
+	}
+	if (infile.getLineCount() != (int)m_stageLines.size()) {
+		return false;
+	}
+	int index = 0;
+	int spine = 0;
+	int tokencount = (int)m_stageTokens.size();
+	for (int i=0; i<infile.getLineCount(); i++) {
+		HLp line = &infile[i];
+		if (m_stageLines[i] != line) {
+			return false;
+		}
+		int count = line->getFieldCount();
+		for (int j=0; j<count; j++) {
+			HTp token = line->token(j);
+			if ((index >= tokencount) || (m_stageTokens[index++] != token)) {
+				return false;
+			}
+			if (token->empty() && !line->empty()) {
+				return false;
+			}
+			if (token->find_first_of("\t\n") != string::npos) {
+				return false;
+			}
+		}
+		if (line->isManipulator() || line->isExclusiveInterpretation()) {
+			if ((spine >= (int)m_stageSpines.size()) ||
+					(m_stageSpines[spine++] != getTokenText(line))) {
+				return false;
+			}
+		}
+	}
+	return (index == tokencount) && (spine == (int)m_stageSpines.size());
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::getTokenText -- Return the tokens of a line separated by
+//     tabs (the line text may not be updated yet after tokens are edited).
+//
+
+string Tool_filter::getTokenText(HLp line) {
+	string output;
+	int count = line->getFieldCount();
+	for (int i=0; i<count; i++) {
+		if (i > 0) {
+			output += '\t';
+		}
+		output += *line->token(i);
+	}
+	return output;
+}
+
+
+
 //////////////////////////////
 //
 // Tool_filter::removeGlobalFilterLines --
@@ -95789,6 +104128,7 @@ void Tool_filter::getUniversalCommandList(vector<pair<string, string> >& command
 
 void Tool_filter::initialize(HumdrumFile& infile) {
 	m_debugQ = getBoolean("debug");
+	m_reparseQ = getBoolean("reparse");
 	m_variant.clear();
 	if (getBoolean("variant")) {
 		m_variant = getString("variant");
@@ -98250,11 +106590,7 @@ bool Tool_half::run(HumdrumFile& infile) {
 	processFile(infile);
 
 	// Re-load the text for each line from their tokens.
-	infile.createLinesFromTokens();
-
-	// Need to adjust the line numbers for tokens for later
-	// processing.
-	m_humdrum_text << infile;
+	printEditedFile(infile);
 	return true;
 }
 
@@ -99854,6 +108190,8 @@ Tool_humdiff::Tool_humdiff(void) {
 	define("time-points|times=b", "display timepoint lists for each file");
 	define("note-points|notes=b", "display notepoint lists for each file");
 	define("c|color=s:red",       "color for difference markers");
+	define("b|band=i:0",          "half-width of alignment band in time points (0 = automatic)");
+	define("e|edits=b",           "display edit script of differences for each file");
 }
 
 
@@ -99883,15 +108221,6 @@ bool Tool_humdiff::run(HumdrumFileSet& infiles) {
 		cerr << "Usage: " << getCommand() << " files" << endl;
 		return false;
 	} else {
-		HumNum targetdur = infiles[0].getScoreDuration();
-		for (int i=1; i<infiles.getSize(); i++) {
-			HumNum dur = infiles[i].getScoreDuration();
-			if (dur != targetdur) {
-				cerr << "Error: all files must have the same duration" << endl;
-				return false;
-			}
-		}
-
 		for (int i=0; i<infiles.getCount(); i++) {
 			if (i == reference) {
 				continue;
@@ -99899,7 +108228,7 @@ bool Tool_humdiff::run(HumdrumFileSet& infiles) {
 			compareFiles(infiles[reference], infiles[i]);
 		}
 
-		if (!getBoolean("report")) {
+		if (!getBoolean("report") && !getBoolean("edits")) {
 			infiles[reference].createLinesFromTokens();
 			m_humdrum_text << infiles[reference];
 			if (m_marked) {
@@ -99953,69 +108282,147 @@ void Tool_humdiff::printTimePoints(vector<TimePoint>& timepoints) {
 
 //////////////////////////////
 //
-// Tool_humdiff::compareTimePoints --
+// Tool_humdiff::compareTimePoints -- Align the time points of the two
+//     files by the notes that start at them, then compare the notes of
+//     each pair of aligned time points.  Reference notes at time points
+//     which were deleted in the alternate file have no match.
 //
 
 void Tool_humdiff::compareTimePoints(vector<vector<TimePoint>>& timepoints,
 		HumdrumFile& reference, HumdrumFile& alternate) {
-	vector<int> indexes(timepoints.size(), 0);
-	HumNum minval;
-	HumNum value;
-	int found;
-
 	vector<HumdrumFile*> infiles(2, NULL);
 	infiles[0] = &reference;
 	infiles[1] = &alternate;
 
-	vector<int> increment(timepoints.size(), 0);
+	// notes which start at each time point of each file:
+	vector<vector<vector<NotePoint>>> notes(timepoints.size());
+	for (int i=0; i<(int)timepoints.size(); i++) {
+		notes.at(i).resize(timepoints.at(i).size());
+		for (int j=0; j<(int)timepoints.at(i).size(); j++) {
+			getNoteList(notes.at(i).at(j), *infiles.at(i), timepoints.at(i).at(j).index.at(0),
+					timepoints.at(i).at(j).measure, i, j);
+		}
+	}
 
-	while ((1)) {
-		if (indexes.at(0) >= (int)timepoints.at(0).size()) {
-			// at the end of the list of notes for the first file.
-			// break from the comparison for now and figure out how
-			// to report differences of added notes in the other file(s)
-			// later.
-			break;
+	TimePointAlignment alignment;
+	alignment.setBand(getInteger("band"));
+	alignment.setSequences(notes.at(0), notes.at(1));
+	vector<pair<int, int>> path;
+	alignment.align(path);
+
+	bool editsQ = getBoolean("edits");
+	if (editsQ) {
+		m_free_text << "!!!humdiff-reference: " << reference.getFilename() << endl;
+		m_free_text << "!!!humdiff-alternate: " << alternate.getFilename() << endl;
+		m_free_text << "**edit\t**rline\t**aline\t**rnote\t**anote" << endl;
+	}
+
+	vector<vector<NotePoint>> notelist(2);
+	for (int i=0; i<(int)path.size(); i++) {
+		int ref = path[i].first;
+		int alt = path[i].second;
+		if (ref < 0) {
+			if (editsQ) {
+				printEdit("insert", -1, timepoints.at(1).at(alt).index.at(0), NULL,
+						&notes.at(1).at(alt));
+			}
+			continue;
 		}
-		timepoints.at(0).at(indexes.at(0)).index.resize(timepoints.size());
-		for (int i=1; i<(int)timepoints.size(); i++) {
-			timepoints.at(0).at(indexes.at(0)).index.at(i) = -1;
+		TimePoint& tp = timepoints.at(0).at(ref);
+		tp.index.resize(timepoints.size());
+		tp.index.at(1) = (alt < 0) ? -1 : timepoints.at(1).at(alt).index.at(0);
+
+		notelist.at(0).swap(notes.at(0).at(ref));
+		notelist.at(1).clear();
+		if (alt >= 0) {
+			notelist.at(1).swap(notes.at(1).at(alt));
 		}
-		minval = timepoints.at(0).at(indexes.at(0)).timestamp;
-		for (int i=1; i<(int)timepoints.size(); i++) {
-			if (indexes.at(i) >= (int)timepoints.at(i).size()) {
-				continue;
+		compareLines(notelist, infiles, tp.index.at(1));
+		if (!editsQ) {
+			continue;
+		}
+		if (alt < 0) {
+			printEdit("delete", tp.index.at(0), -1, &notelist.at(0), NULL);
+			continue;
+		}
+		bool changed = false;
+		for (int j=0; j<(int)notelist.at(0).size(); j++) {
+			if (notelist.at(0).at(j).matched.at(1) < 0) {
+				changed = true;
 			}
-			value = timepoints.at(i).at(indexes.at(i)).timestamp;
-			if (value < minval) {
-				minval = value;
+		}
+		for (int j=0; j<(int)notelist.at(1).size(); j++) {
+			if (!notelist.at(1).at(j).processed) {
+				changed = true;
 			}
 		}
-		found = 0;
-		fill(increment.begin(), increment.end(), 0);
+		if (changed) {
+			printEdit("change", tp.index.at(0), tp.index.at(1), &notelist.at(0),
+					&notelist.at(1));
+		}
+	}
+
+	if (editsQ) {
+		m_free_text << "*-\t*-\t*-\t*-\t*-" << endl;
+	}
+}
+
+
 
-		for (int i=0; i<(int)timepoints.size(); i++) {
-			if (indexes.at(i) >= (int)timepoints.at(i).size()) {
-				// index is too large for file, so skip checking it.
+//////////////////////////////
+//
+// Tool_humdiff::printEdit -- Print one line of the edit script: the
+//     operation, the line numbers in the reference and alternate files
+//     (or "." if there is no equivalent time point), and the notes
+//     of each file that have no match in the other file.
+//
+
+void Tool_humdiff::printEdit(const string& operation, int refline, int altline,
+		vector<NotePoint>* refnotes, vector<NotePoint>* altnotes) {
+	m_free_text << operation << "\t";
+	if (refline < 0) {
+		m_free_text << ".";
+	} else {
+		m_free_text << refline + 1;
+	}
+	m_free_text << "\t";
+	if (altline < 0) {
+		m_free_text << ".";
+	} else {
+		m_free_text << altline + 1;
+	}
+	m_free_text << "\t" << getUnmatchedNotes(refnotes, true);
+	m_free_text << "\t" << getUnmatchedNotes(altnotes, false);
+	m_free_text << endl;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_humdiff::getUnmatchedNotes -- Return the notes in a list that were
+//     not matched, separated by spaces (or "." if there are none).
+//
+
+string Tool_humdiff::getUnmatchedNotes(vector<NotePoint>* notes, bool reference) {
+	string output;
+	if (notes) {
+		for (int i=0; i<(int)notes->size(); i++) {
+			NotePoint& np = notes->at(i);
+			bool matched = reference ? ((int)np.matched.size() > 1 && np.matched[1] >= 0) : np.processed;
+			if (matched) {
 				continue;
 			}
-			found = 1;
-			value = timepoints.at(i).at(indexes.at(i)).timestamp;
-
-			if (value == minval) {
-				timepoints.at(0).at(indexes.at(0)).index.at(i) = timepoints.at(i).at(indexes.at(i)).index.at(0);
-				increment.at(i)++;
+			if (!output.empty()) {
+				output += " ";
 			}
+			output += np.subtoken;
 		}
-		if (!found) {
-			break;
-		} else {
-			compareLines(minval, indexes, timepoints, infiles);
-		}
-		for (int i=0; i<(int)increment.size(); i++) {
-			indexes.at(i) += increment.at(i);
-		}
 	}
+	if (output.empty()) {
+		output = ".";
+	}
+	return output;
 }
 
 
@@ -100068,34 +108475,18 @@ void Tool_humdiff::markNote(NotePoint& np) {
 
 //////////////////////////////
 //
-// Tool_humdiff::compareLines --
+// Tool_humdiff::compareLines -- Match the notes of a reference time point
+//     (notelist[0]) with the notes of the aligned time point in the other
+//     file (notelist[1], empty if the time point was deleted).  Each note
+//     in the other file can be matched once.  altline is the line of the
+//     aligned time point in the other file (or -1).
 //
 
-void Tool_humdiff::compareLines(HumNum minval, vector<int>& indexes,
-		vector<vector<TimePoint>>& timepoints, vector<HumdrumFile*> infiles) {
+void Tool_humdiff::compareLines(vector<vector<NotePoint>>& notelist,
+		vector<HumdrumFile*>& infiles, int altline) {
 
 	bool reportQ = getBoolean("report");
 
-	// cerr << "COMPARING LINES ====================================" << endl;
-	vector<vector<NotePoint>> notelist(indexes.size());
-
-	// Note: timepoints size must be 2
-	// and infiles size must be 2
-	for (int i=0; i<(int)timepoints.size(); i++) {
-		if (indexes.at(i) >= (int)timepoints.at(i).size()) {
-			continue;
-		}
-		if (timepoints.at(i).at(indexes.at(i)).timestamp != minval) {
-			// not at the same time
-			continue;
-		}
-
-		getNoteList(notelist.at(i), *infiles[i],
-			timepoints.at(i).at(indexes.at(i)).index[0],
-			timepoints.at(i).at(indexes.at(i)).measure, i, indexes.at(i));
-
-
-	}
 	for (int i=0; i<(int)notelist.at(0).size(); i++) {
 		notelist.at(0).at(i).matched.resize(notelist.size());
 		fill(notelist.at(0).at(i).matched.begin(), notelist.at(0).at(i).matched.end(), -1);
@@ -100103,7 +108494,9 @@ void Tool_humdiff::compareLines(HumNum minval, vector<int>& indexes,
 		for (int j=1; j<(int)notelist.size(); j++) {
 			int status = findNoteInList(notelist.at(0).at(i), notelist.at(j));
 			notelist.at(0).at(i).matched.at(j) = status;
-			if ((status < 0) && !reportQ) {
+			if (status >= 0) {
+				notelist.at(j).at(status).processed = 1;
+			} else if (!reportQ) {
 				markNote(notelist.at(0).at(i));
 			}
 		}
@@ -100136,13 +108529,23 @@ void Tool_humdiff::compareLines(HumNum minval, vector<int>& indexes,
 				if (j < 10) {
 					cout << " ";
 				}
-				cout << ":\t" << "X" << endl;
+				cout << ":\t";
+				if (altline < 0) {
+					cout << "X" << endl;
+				} else {
+					cout << altline + 1 << endl;
+				}
 
 				cout << "\tTARGET  " << j << " LINE TEXT";
 				if (j < 10) {
 					cout << " ";
 				}
-				cout << ":\t" << "X" << endl;
+				cout << ":\t";
+				if (altline < 0) {
+					cout << "X" << endl;
+				} else {
+					cout << (*infiles[j])[altline] << endl;
+				}
 
 				cout << endl;
 			}
@@ -100212,7 +108615,7 @@ void Tool_humdiff::getNoteList(vector<NotePoint>& notelist, HumdrumFile& infile,
 			notelist.back().subtoken = subtok;
 			notelist.back().subindex = j;
 			notelist.back().measurequarter = token->getDurationFromBarline();
-			notelist.back().measure =
+			notelist.back().measure = measure;
 			notelist.back().track = track;
 			notelist.back().layer = layer;
 			notelist.back().sourceindex = sourceindex;
@@ -100308,6 +108711,457 @@ ostream& operator<<(ostream& out, NotePoint& np) {
 
 
 
+//////////////////////////////////////////////////////////////////////////
+
+// Cost for cells outside of the alignment band (small enough that sums of
+// several such costs do not overflow):
+static const int TimePointAlignmentInfinity = 1 << 28;
+
+
+//////////////////////////////
+//
+// TimePointAlignment::TimePointAlignment --
+//
+
+TimePointAlignment::TimePointAlignment(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::setBand -- Set the maximum distance (in time points)
+//     of the alignment from the diagonal between the two sequences.  The
+//     default of 0 uses the difference in the sequence lengths plus 64.
+//
+
+void TimePointAlignment::setBand(int band) {
+	m_band = band < 0 ? 0 : band;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::setGapCosts -- Set the cost of starting a gap and
+//     the cost for each time point in the gap.  The cost of substituting
+//     one time point for another is in the range -4 (same notes) to +4
+//     (no common notes).
+//
+
+void TimePointAlignment::setGapCosts(int open, int extend) {
+	m_gapopen = open;
+	m_gapextend = extend;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::setSequences -- Set the notes which start at each
+//     time point of the two files.
+//
+
+void TimePointAlignment::setSequences(vector<vector<NotePoint>>& notes1,
+		vector<vector<NotePoint>>& notes2) {
+	prepareKeys(notes1, m_keys1, m_hashes1);
+	prepareKeys(notes2, m_keys2, m_hashes2);
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::prepareKeys -- Store a sorted list of the pitches
+//     and durations of the notes at each time point.
+//
+
+void TimePointAlignment::prepareKeys(vector<vector<NotePoint>>& notes,
+		vector<vector<long long>>& keys, vector<unsigned long long>& hashes) {
+	keys.resize(notes.size());
+	hashes.resize(notes.size());
+	for (int i=0; i<(int)notes.size(); i++) {
+		keys[i].clear();
+		for (int j=0; j<(int)notes[i].size(); j++) {
+			NotePoint& np = notes[i][j];
+			long long key = ((long long)np.b40 << 42)
+					^ ((long long)(np.duration.getNumerator() & 0x1fffff) << 21)
+					^ (long long)(np.duration.getDenominator() & 0x1fffff);
+			keys[i].push_back(key);
+		}
+		std::sort(keys[i].begin(), keys[i].end());
+		unsigned long long hash = 14695981039346656037ULL;
+		for (int j=0; j<(int)keys[i].size(); j++) {
+			hash = (hash ^ (unsigned long long)keys[i][j]) * 1099511628211ULL;
+		}
+		hashes[i] = hash;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getSubstitutionCost -- Return the cost of aligning
+//     a time point in the first file with a time point in the second
+//     file: -4 if they have the same notes, up to +4 if they have no
+//     notes in common.
+//
+
+int TimePointAlignment::getSubstitutionCost(int index1, int index2) {
+	vector<long long>& keys1 = m_keys1[index1];
+	vector<long long>& keys2 = m_keys2[index2];
+	if ((m_hashes1[index1] == m_hashes2[index2]) && (keys1.size() == keys2.size())) {
+		return -4;
+	}
+	int total = (int)(keys1.size() + keys2.size());
+	if (total == 0) {
+		return -4;
+	}
+	int shared = 0;
+	int i = 0;
+	int j = 0;
+	while ((i < (int)keys1.size()) && (j < (int)keys2.size())) {
+		if (keys1[i] < keys2[j]) {
+			i++;
+		} else if (keys2[j] < keys1[i]) {
+			j++;
+		} else {
+			shared++;
+			i++;
+			j++;
+		}
+	}
+	return 4 - (16 * shared + total / 2) / total;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getGapCost -- Return the cost of a gap of the
+//     given number of time points.
+//
+
+int TimePointAlignment::getGapCost(int length) {
+	if (length <= 0) {
+		return 0;
+	}
+	return m_gapopen + m_gapextend * length;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getBandStart -- Return the first time point of the
+//     second sequence which can be aligned after the given number of time
+//     points in the first sequence.
+//
+
+int TimePointAlignment::getBandStart(int index1) {
+	int size1 = (int)m_keys1.size();
+	int size2 = (int)m_keys2.size();
+	long long center = (long long)index1 * size2 / size1;
+	return (int)std::max(0LL, center - m_width);
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getBandEnd -- Return the last time point of the
+//     second sequence which can be aligned after the given number of time
+//     points in the first sequence.
+//
+
+int TimePointAlignment::getBandEnd(int index1) {
+	int size1 = (int)m_keys1.size();
+	int size2 = (int)m_keys2.size();
+	long long center = (long long)index1 * size2 / size1;
+	return (int)std::min((long long)size2, center + m_width);
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::align -- Align the two sequences.  Each entry in
+//     path is a pair of aligned time points; a time point which is deleted
+//     from the first sequence is paired with -1, and a time point which
+//     is inserted in the second sequence follows -1.  Returns the cost of
+//     the alignment.
+//
+
+int TimePointAlignment::align(vector<pair<int, int>>& path) {
+	int size1 = (int)m_keys1.size();
+	int size2 = (int)m_keys2.size();
+	path.clear();
+	path.reserve(std::max(size1, size2));
+	m_path = &path;
+	if (size1 > 0) {
+		int band = m_band ? m_band : std::abs(size2 - size1) + 64;
+		// The band follows the line between the ends of the two sequences,
+		// so it has to be at least as wide as the slope of the line:
+		m_width = band + (size2 + size1 - 1) / size1 + 1;
+	}
+	m_cc.assign(size2 + 1, 0);
+	m_dd.assign(size2 + 1, 0);
+	m_rr.assign(size2 + 1, 0);
+	m_ss.assign(size2 + 1, 0);
+	int output = alignRange(0, 0, size1, size2, m_gapopen, m_gapopen);
+	m_path = NULL;
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::alignRange -- Align size1 time points of the first
+//     sequence starting at start1 with size2 time points of the second
+//     sequence starting at start2.  gapstart and gapend are the costs of
+//     opening a gap in the second sequence at the start and end of the
+//     range (0 when the gap continues from an adjacent range).  The range
+//     is split at its middle row, at the column where the best path from
+//     the start (forward pass) meets the best path to the end (reverse
+//     pass), so only two rows of the dynamic programming matrix are
+//     stored at once.
+//
+
+int TimePointAlignment::alignRange(int start1, int start2, int size1,
+		int size2, int gapstart, int gapend) {
+	vector<pair<int, int>>& path = *m_path;
+	const int inf = TimePointAlignmentInfinity;
+	int g = m_gapopen;
+	int h = m_gapextend;
+
+	if (size2 <= 0) {
+		for (int i=0; i<size1; i++) {
+			path.emplace_back(start1 + i, -1);
+		}
+		return size1 > 0 ? std::min(gapstart, gapend) + h * size1 : 0;
+	}
+
+	if (size1 <= 1) {
+		if (size1 <= 0) {
+			for (int j=0; j<size2; j++) {
+				path.emplace_back(-1, start2 + j);
+			}
+			return getGapCost(size2);
+		}
+		// delete the single time point, or align it with one of the
+		// time points in the second sequence:
+		int best = std::min(gapstart, gapend) + h + getGapCost(size2);
+		int bestj = 0;
+		for (int j=1; j<=size2; j++) {
+			int cost = getGapCost(j - 1) + getSubstitutionCost(start1, start2 + j - 1)
+					+ getGapCost(size2 - j);
+			if (cost < best) {
+				best = cost;
+				bestj = j;
+			}
+		}
+		if (bestj == 0) {
+			// keep the deletion next to the gap which it continues:
+			if (gapstart <= gapend) {
+				path.emplace_back(start1, -1);
+			}
+			for (int j=0; j<size2; j++) {
+				path.emplace_back(-1, start2 + j);
+			}
+			if (gapstart > gapend) {
+				path.emplace_back(start1, -1);
+			}
+		} else {
+			for (int j=1; j<bestj; j++) {
+				path.emplace_back(-1, start2 + j - 1);
+			}
+			path.emplace_back(start1, start2 + bestj - 1);
+			for (int j=bestj+1; j<=size2; j++) {
+				path.emplace_back(-1, start2 + j - 1);
+			}
+		}
+		return best;
+	}
+
+	int* cc = m_cc.data();
+	int* dd = m_dd.data();
+	int* rr = m_rr.data();
+	int* ss = m_ss.data();
+	int middle = size1 / 2;
+	int c, d, e, s, t;
+
+	// Forward pass: cc[j] is the cost of the best path from the start of
+	// the range to (row, j), and dd[j] the best of those which end with
+	// a gap in the second sequence.
+	int hi = std::min(size2, getBandEnd(start1) - start2);
+	cc[0] = 0;
+	t = g;
+	for (int j=1; j<=size2; j++) {
+		if (j <= hi) {
+			t += h;
+			cc[j] = t;
+			dd[j] = t + g;
+		} else {
+			cc[j] = dd[j] = inf;
+		}
+	}
+	t = gapstart;
+	int lastlo = 0;
+	for (int i=1; i<=middle; i++) {
+		int lo = std::max(0, getBandStart(start1 + i) - start2);
+		hi = std::min(size2, getBandEnd(start1 + i) - start2);
+		int j;
+		if (lo == 0) {
+			s = cc[0];
+			t += h;
+			cc[0] = c = t;
+			e = t + g;
+			j = 1;
+		} else {
+			s = cc[lo - 1];
+			c = e = inf;
+			j = lo;
+		}
+		for (; j<=hi; j++) {
+			e = std::min(e + h, c + g + h);
+			d = std::min(dd[j] + h, cc[j] + g + h);
+			c = s + getSubstitutionCost(start1 + i - 1, start2 + j - 1);
+			c = std::min(c, std::min(d, e));
+			s = cc[j];
+			cc[j] = c;
+			dd[j] = d;
+		}
+		// columns which have left the band:
+		for (j=lastlo; j<lo; j++) {
+			cc[j] = dd[j] = inf;
+		}
+		lastlo = lo;
+	}
+	dd[0] = cc[0];
+
+	// Reverse pass: rr[j] is the cost of the best path from (row, j) to
+	// the end of the range, and ss[j] the best of those which start with
+	// a gap in the second sequence.
+	int lo = std::max(0, getBandStart(start1 + size1) - start2);
+	rr[size2] = 0;
+	t = g;
+	for (int j=size2-1; j>=0; j--) {
+		if (j >= lo) {
+			t += h;
+			rr[j] = t;
+			ss[j] = t + g;
+		} else {
+			rr[j] = ss[j] = inf;
+		}
+	}
+	t = gapend;
+	int lasthi = size2;
+	for (int i=size1-1; i>=middle; i--) {
+		lo = std::max(0, getBandStart(start1 + i) - start2);
+		hi = std::min(size2, getBandEnd(start1 + i) - start2);
+		int j;
+		if (hi == size2) {
+			s = rr[size2];
+			t += h;
+			rr[size2] = c = t;
+			e = t + g;
+			j = size2 - 1;
+		} else {
+			s = rr[hi + 1];
+			c = e = inf;
+			j = hi;
+		}
+		for (; j>=lo; j--) {
+			e = std::min(e + h, c + g + h);
+			d = std::min(ss[j] + h, rr[j] + g + h);
+			c = s + getSubstitutionCost(start1 + i, start2 + j);
+			c = std::min(c, std::min(d, e));
+			s = rr[j];
+			rr[j] = c;
+			ss[j] = d;
+		}
+		for (j=hi+1; j<=lasthi; j++) {
+			rr[j] = ss[j] = inf;
+		}
+		lasthi = hi;
+	}
+	ss[size2] = rr[size2];
+
+	// Find where the best path crosses the middle row, either aligning
+	// a time point there or in the middle of a gap in the second sequence:
+	int best = cc[0] + rr[0];
+	int bestj = 0;
+	bool gapq = false;
+	for (int j=0; j<=size2; j++) {
+		c = cc[j] + rr[j];
+		if ((c < best) || ((c == best) && (cc[j] != dd[j]) && (rr[j] == ss[j]))) {
+			best = c;
+			bestj = j;
+		}
+	}
+	for (int j=size2; j>=0; j--) {
+		c = dd[j] + ss[j] - g;
+		if (c < best) {
+			best = c;
+			bestj = j;
+			gapq = true;
+		}
+	}
+
+	if (!gapq) {
+		alignRange(start1, start2, middle, bestj, gapstart, g);
+		alignRange(start1 + middle, start2 + bestj, size1 - middle, size2 - bestj, g, gapend);
+	} else {
+		alignRange(start1, start2, middle - 1, bestj, gapstart, 0);
+		path.emplace_back(start1 + middle - 1, -1);
+		path.emplace_back(start1 + middle, -1);
+		alignRange(start1 + middle + 1, start2 + bestj, size1 - middle - 1, size2 - bestj, 0, gapend);
+	}
+	return best;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getPathCost -- Return the cost of an alignment
+//     path.
+//
+
+int TimePointAlignment::getPathCost(vector<pair<int, int>>& path) {
+	int output = 0;
+	int deleted = 0;
+	int inserted = 0;
+	for (int i=0; i<=(int)path.size(); i++) {
+		bool deleteq = (i < (int)path.size()) && (path[i].second < 0);
+		bool insertq = (i < (int)path.size()) && (path[i].first < 0);
+		if (!deleteq && deleted) {
+			output += getGapCost(deleted);
+			deleted = 0;
+		}
+		if (!insertq && inserted) {
+			output += getGapCost(inserted);
+			inserted = 0;
+		}
+		if (i == (int)path.size()) {
+			break;
+		}
+		if (deleteq) {
+			deleted++;
+		} else if (insertq) {
+			inserted++;
+		} else {
+			output += getSubstitutionCost(path[i].first, path[i].second);
+		}
+	}
+	return output;
+}
+
+
+
 
 
 /////////////////////////////////
@@ -100324,6 +109178,8 @@ Tool_humsheet::Tool_humsheet(void) {
 	define("X|no-exinterp=b",       "do not embed exclusive interp data");
 	define("J|no-javascript=b",     "do not embed javascript code");
 	define("S|no-style=b",          "do not embed CSS style element");
+
+	setRequiredAnalyses(HumFileAnalysis::getMask(HumFileAnalysis::Strands));
 }
 
 
@@ -101673,8 +110529,7 @@ bool Tool_humtr::run(HumdrumFile& infile) {
 		}
 		return true;
 	} else {
-		infile.createLinesFromTokens();
-		m_humdrum_text << infile;
+		printEditedFile(infile);
 	}
 	return true;
 }
@@ -102305,9 +111160,9 @@ void Tool_imitation::getIntervals(vector<double>& intervals,
 	intervals.back() = NAN;
 
 	if (getBoolean("debug")) {
-		cout << endl;
+		m_free_text << endl;
 		for (int i=0; i<(int)intervals.size(); i++) {
-			cout << "INTERVAL " << i << "\t=\t" << intervals.at(i) << "\tATK "
+			m_free_text << "INTERVAL " << i << "\t=\t" << intervals.at(i) << "\tATK "
 			     << attacks.at(i)->getSgnDiatonicPitch() << "\t" << attacks.at(i)->getToken() << endl;
 		}
 	}
@@ -102622,15 +111477,15 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 					}
 
                if (attacks.at(v1).at(i+z)->isRest() && (z < count - 1) ) {
-						markedTiedNotes(attacks.at(v1).at(i+z)->m_tiedtokens);
+						markedTiedNotes(attacks.at(v1).at(i+z)->getTiedTokens());
 					} else if (!attacks.at(v1).at(i+z)->isRest()) {
-						markedTiedNotes(attacks.at(v1).at(i+z)->m_tiedtokens);
+						markedTiedNotes(attacks.at(v1).at(i+z)->getTiedTokens());
 					}
 
                if (attacks.at(v2).at(j+z)->isRest() && (z < count - 1) ) {
-						markedTiedNotes(attacks.at(v2).at(j+z)->m_tiedtokens);
+						markedTiedNotes(attacks.at(v2).at(j+z)->getTiedTokens());
 					} else if (!attacks.at(v2).at(j+z)->isRest()) {
-						markedTiedNotes(attacks.at(v2).at(j+z)->m_tiedtokens);
+						markedTiedNotes(attacks.at(v2).at(j+z)->getTiedTokens());
 					}
 
 				}
@@ -102649,7 +111504,7 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 // Tool_imitation::markedTiedNotes --
 //
 
-void Tool_imitation::markedTiedNotes(vector<HTp>& tokens) {
+void Tool_imitation::markedTiedNotes(const vector<HTp>& tokens) {
 	for (int i=0; i<(int)tokens.size(); i++) {
 		if (m_single) {
 			if (tokens.at(i)->find(m_marker) == string::npos) {
@@ -113501,6 +122356,938 @@ void MSearchQueryToken::parseHarmonicQuery(void) {
 
 
 
+//////////////////////////////
+//
+// MSearchIndex file layout (integers in the header and tables are
+// stored in little-endian order, so that index files do not depend on
+// byte order):
+//    "HUMMSIX" magic string (8 bytes, including the final null)
+//    version, n-gram length, file count (4 bytes each)
+//    n-gram count (8 bytes)
+//    file keys, in order of file number (8 bytes each)
+//    n-gram table, sorted by key: n-gram key (8 bytes), offset of
+//       its entry list (8 bytes), number of entries (4 bytes)
+//    entry lists: the sorted entries of each n-gram, each stored as
+//       the difference from the previous entry, seven bits per byte.
+//
+// Each entry is (file << 32) | (voice << 20) | position, where position
+// is the index of the first attack of the n-gram in the voice.
+//
+
+// Increase MSearchIndexVersion when the layout or the features change.
+static const int MSearchIndexVersion = 1;
+static const int MSearchIndexHeaderSize = 28;
+static const int MSearchIndexTableSize = 20;
+
+// Kinds of features which are indexed:
+static const int MSearchIndexRhythm    = 0;
+static const int MSearchIndexDiatonic  = 1;
+static const int MSearchIndexChromatic = 2;
+static const int MSearchIndexBase40    = 3;
+static const int MSearchIndexBase12    = 4;
+static const int MSearchIndexBase7     = 5;
+static const int MSearchIndexKinds     = 6;
+
+
+//////////////////////////////
+//
+// MSearchIndex::MSearchIndex -- Constructor.  The n-gram length is
+//     replaced by the length stored in an index that is read.
+//
+
+MSearchIndex::MSearchIndex(int gramlength) {
+	m_gramlength = gramlength < 1 ? 1 : gramlength;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::~MSearchIndex -- Deconstructor.
+//
+
+MSearchIndex::~MSearchIndex() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::clear -- Remove the contents of the index.
+//
+
+void MSearchIndex::clear(void) {
+	m_files.clear();
+	m_grams.clear();
+	unmap();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::unmap -- Release the contents of an index that was read.
+//
+
+void MSearchIndex::unmap(void) {
+#ifdef HUMLIB_MMAP
+	if (m_map) {
+		munmap(m_map, m_size);
+	}
+#endif
+	m_map = NULL;
+	m_buffer.clear();
+	m_data = NULL;
+	m_size = 0;
+	m_gramcount = 0;
+	m_table = NULL;
+	m_entries = NULL;
+	m_lastoffset = 0;
+	m_lastshift = -1;
+	m_candidates.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getGramLength -- Return the number of attacks in each n-gram.
+//
+
+int MSearchIndex::getGramLength(void) {
+	return m_gramlength;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getFileCount -- Return the number of (distinct) files
+//     in the index.
+//
+
+int MSearchIndex::getFileCount(void) {
+	return (int)m_files.size();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getGramCount -- Return the number of distinct n-grams
+//     in the index.
+//
+
+size_t MSearchIndex::getGramCount(void) {
+	return m_data ? (size_t)m_gramcount : m_grams.size();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getFileKey -- Return the key which identifies a file
+//     in the index: a hash of its tokens (which may differ from the
+//     text of the lines if a tool has changed them).
+//
+
+std::uint64_t MSearchIndex::getFileKey(HumdrumFile& infile) {
+	string text;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		HumdrumLine& line = infile[i];
+		if (line.getFieldCount() == 0) {
+			text += line;
+		}
+		for (int j=0; j<line.getFieldCount(); j++) {
+			if (j > 0) {
+				text += '\t';
+			}
+			text += *line.token(j);
+		}
+		text += '\n';
+	}
+	return HumSnapshot::getContentKey(text.data(), text.size());
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::addFile -- Add the n-grams of each voice of a file to
+//     the index.  A file with the same tokens as one already in the
+//     index shares its entries.  Returns false if the file cannot be
+//     indexed (it has no **kern spines, or too many voices or notes),
+//     in which case msearch will check all of its notes.
+//
+
+bool MSearchIndex::addFile(HumdrumFile& infile) {
+	if (m_data) {
+		// cannot add to an index which has been read
+		return false;
+	}
+	std::uint64_t key = getFileKey(infile);
+	if (m_files.find(key) != m_files.end()) {
+		return true;
+	}
+	if ((m_files.size() >= 0xffffffffULL) || infile.getKernSpineStartList().empty()) {
+		return false;
+	}
+
+	NoteGrid grid(infile);
+	if (grid.getVoiceCount() >= (1 << 12)) {
+		return false;
+	}
+	vector<vector<vector<Feature>>> features(grid.getVoiceCount());
+	vector<NoteCell*> attacks;
+	for (int i=0; i<grid.getVoiceCount(); i++) {
+		grid.getNoteAndRestAttacks(attacks, i);
+		if ((int)attacks.size() >= (1 << 20)) {
+			return false;
+		}
+		if (!getNoteFeatures(attacks, features[i])) {
+			return false;
+		}
+	}
+
+	std::uint64_t file = m_files.size();
+	m_files[key] = (std::uint32_t)file;
+	for (int i=0; i<(int)features.size(); i++) {
+		for (int kind=0; kind<MSearchIndexKinds; kind++) {
+			vector<Feature>& list = features[i][kind];
+			for (int j=0; j+m_gramlength<=(int)list.size(); j++) {
+				std::uint64_t entry = (file << 32) | ((std::uint64_t)i << 20) | (std::uint64_t)j;
+				m_grams[getGramKey(kind, &list[j])].push_back(entry);
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getFeatureKinds -- Return the number of kinds of features
+//     (pitch class in three bases, two kinds of interval and duration).
+//
+
+int MSearchIndex::getFeatureKinds(void) {
+	return MSearchIndexKinds;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getNoteFeatures -- Calculate the features of each attack
+//     in a voice which are compared to the query in
+//     Tool_msearch::checkForMusicMatch(), in the same way, so that a note
+//     has the same feature as a query token if and only if it matches the
+//     token.  Returns false if a duration cannot be indexed, or the
+//     diatonic pitch class of a note does not match its base-40 pitch
+//     class.
+//
+
+bool MSearchIndex::getNoteFeatures(vector<NoteCell*>& notes,
+		vector<vector<Feature>>& features) {
+	features.resize(MSearchIndexKinds);
+	for (int i=0; i<(int)features.size(); i++) {
+		features[i].resize(notes.size());
+	}
+	for (int i=0; i<(int)notes.size(); i++) {
+		NoteCell* note = notes[i];
+		NoteCell* next = (i + 1 < (int)notes.size()) ? notes[i+1] : NULL;
+
+		HumNum duration = note->getDuration();
+		if (duration.getDenominator() <= 0) {
+			return false;
+		}
+		features[MSearchIndexRhythm][i] = Feature(duration.getNumerator(),
+				duration.getDenominator());
+
+		double currpitch = note->getAbsDiatonicPitch();
+		double nextpitch = next ? next->getAbsDiatonicPitch() : -123456789.0;
+		features[MSearchIndexDiatonic][i] = Feature(0, (int)(nextpitch - currpitch));
+		currpitch = note->getAbsBase40Pitch();
+		nextpitch = next ? next->getAbsBase40Pitch() : -123456789.0;
+		features[MSearchIndexChromatic][i] = Feature(0, (int)(nextpitch - currpitch));
+
+		if (note->isRest()) {
+			features[MSearchIndexBase40][i] = Feature(1, 0);
+			features[MSearchIndexBase12][i] = Feature(1, 0);
+			features[MSearchIndexBase7][i]  = Feature(1, 0);
+		} else {
+			features[MSearchIndexBase40][i] = Feature(0, (int)note->getAbsBase40PitchClass());
+			features[MSearchIndexBase12][i] = Feature(0, ((int)note->getAbsMidiPitch()) % 12);
+			features[MSearchIndexBase7][i]  = Feature(0, ((int)note->getAbsDiatonicPitch()) % 7);
+			int pc = (int)features[MSearchIndexBase40][i].second;
+			if ((pc >= 0) && (pc < 40) && (Convert::base40ToDiatonic(pc) % 7 !=
+					features[MSearchIndexBase7][i].second)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getQueryFeature -- Calculate the feature which a note
+//     must have to match a query token.  Returns false if the token
+//     does not require a specific value of the feature.
+//
+
+bool MSearchIndex::getQueryFeature(MSearchQueryToken& token, int kind,
+		Feature& feature) {
+	if (token.anything) {
+		return false;
+	}
+	int base = 40;
+	switch (kind) {
+		case MSearchIndexRhythm:
+			if (token.anyrhythm || (token.duration.getDenominator() <= 0)) {
+				return false;
+			}
+			feature = Feature(token.duration.getNumerator(), token.duration.getDenominator());
+			return true;
+
+		case MSearchIndexDiatonic:
+			if (token.dinterval <= -1000) {
+				return false;
+			}
+			feature = Feature(0, token.dinterval);
+			return true;
+
+		case MSearchIndexChromatic:
+			if ((token.dinterval > -1000) || (token.cinterval <= -1000)) {
+				return false;
+			}
+			feature = Feature(0, token.cinterval);
+			return true;
+
+		case MSearchIndexBase12:
+			base = 12;
+			break;
+
+		case MSearchIndexBase7:
+			base = 7;
+			break;
+	}
+
+	if (token.anypitch) {
+		return false;
+	}
+	int tokenbase = ((token.base == 12) || (token.base == 7)) ? token.base : 40;
+	if ((tokenbase != base) && ((tokenbase != 40) || (base != 7))) {
+		return false;
+	}
+	if (Convert::isNaN(token.pc)) {
+		feature = Feature(1, 0);
+		return true;
+	}
+	if ((token.pc != floor(token.pc)) || (fabs(token.pc) > 1000000.0)) {
+		return false;
+	}
+	int pc = (int)token.pc;
+	if (tokenbase == base) {
+		feature = Feature(0, pc);
+		return true;
+	}
+	// A base-40 pitch class also gives the diatonic pitch class, so that
+	// queries which mix the two (such as "e-dc") can use base-7 n-grams
+	// (addFile() checks that this is true for each note of the file).
+	if ((pc < 0) || (pc >= 40)) {
+		return false;
+	}
+	feature = Feature(0, Convert::base40ToDiatonic(pc) % 7);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getGramKey -- Return a 64-bit FNV-1a hash of the kind
+//     and features of an n-gram.
+//
+
+std::uint64_t MSearchIndex::getGramKey(int kind, const Feature* features) {
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	hash ^= (std::uint64_t)kind;
+	hash *= 0x100000001b3ULL;
+	for (int i=0; i<m_gramlength; i++) {
+		std::uint64_t values[2] = {(std::uint64_t)features[i].first,
+				(std::uint64_t)features[i].second};
+		for (int j=0; j<2; j++) {
+			for (int k=0; k<8; k++) {
+				hash ^= (values[j] >> (8 * k)) & 0xff;
+				hash *= 0x100000001b3ULL;
+			}
+		}
+	}
+	return hash;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::write -- Save the index to a file.
+//
+
+bool MSearchIndex::write(const string& filename) {
+	if (m_data) {
+		return false;
+	}
+	vector<std::uint64_t> keys;
+	keys.reserve(m_grams.size());
+	for (auto& it : m_grams) {
+		keys.push_back(it.first);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	string table;
+	string entries;
+	table.reserve(keys.size() * MSearchIndexTableSize);
+	for (int i=0; i<(int)keys.size(); i++) {
+		vector<std::uint64_t>& list = m_grams[keys[i]];
+		// Entries for one file are out of order only for colliding keys:
+		std::sort(list.begin(), list.end());
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+		appendInt(table, keys[i], 8);
+		appendInt(table, entries.size(), 8);
+		appendInt(table, list.size(), 4);
+		std::uint64_t last = 0;
+		for (int j=0; j<(int)list.size(); j++) {
+			std::uint64_t value = list[j] - last;
+			last = list[j];
+			while (value >= 0x80) {
+				entries += (char)((value & 0x7f) | 0x80);
+				value >>= 7;
+			}
+			entries += (char)value;
+		}
+	}
+
+	string header("HUMMSIX", 8);
+	appendInt(header, MSearchIndexVersion, 4);
+	appendInt(header, m_gramlength, 4);
+	appendInt(header, m_files.size(), 4);
+	appendInt(header, keys.size(), 8);
+	vector<std::uint64_t> files(m_files.size());
+	for (auto& it : m_files) {
+		files[it.second] = it.first;
+	}
+	for (int i=0; i<(int)files.size(); i++) {
+		appendInt(header, files[i], 8);
+	}
+
+	std::ofstream output(filename, std::ios::binary);
+	if (!output.is_open()) {
+		return false;
+	}
+	output.write(header.data(), header.size());
+	output.write(table.data(), table.size());
+	output.write(entries.data(), entries.size());
+	output.close();
+	return (bool)output;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::read -- Load an index file, which is memory-mapped if
+//     possible.  Returns false if the file is not a valid index.
+//
+
+bool MSearchIndex::read(const string& filename) {
+	clear();
+#ifdef HUMLIB_MMAP
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode) ||
+			(info.st_size < MSearchIndexHeaderSize)) {
+		::close(fd);
+		return false;
+	}
+	m_size = (size_t)info.st_size;
+	void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		m_size = 0;
+		return false;
+	}
+	m_map = data;
+	m_data = (const char*)data;
+#else
+	std::ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		return false;
+	}
+	stringstream contents;
+	contents << input.rdbuf();
+	m_buffer = contents.str();
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+#endif
+
+	if ((m_size < MSearchIndexHeaderSize) || (memcmp(m_data, "HUMMSIX", 8) != 0) ||
+			(readInt(m_data + 8, 4) != (std::uint64_t)MSearchIndexVersion)) {
+		clear();
+		return false;
+	}
+	int gramlength = (int)readInt(m_data + 12, 4);
+	std::uint64_t filecount = readInt(m_data + 16, 4);
+	m_gramcount = readInt(m_data + 20, 8);
+	std::uint64_t available = m_size - MSearchIndexHeaderSize;
+	if ((gramlength < 1) || (filecount > available / 8) ||
+			(m_gramcount > (available - filecount * 8) / MSearchIndexTableSize)) {
+		clear();
+		return false;
+	}
+	m_gramlength = gramlength;
+	const char* ptr = m_data + MSearchIndexHeaderSize;
+	for (std::uint64_t i=0; i<filecount; i++) {
+		m_files[readInt(ptr, 8)] = (std::uint32_t)i;
+		ptr += 8;
+	}
+	m_table = ptr;
+	m_entries = m_table + m_gramcount * MSearchIndexTableSize;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getCandidates -- Get the voices and attack positions in
+//     a file where the query may match, sorted by voice and position.
+//     The n-gram of the query with the fewest entries in the index is
+//     used.  Returns false if the index cannot be used, because the file
+//     is not in the index, or the query has a harmonic search or no
+//     indexed n-gram.
+//
+
+bool MSearchIndex::getCandidates(HumdrumFile& infile,
+		vector<MSearchQueryToken>& query, vector<pair<int, int>>& candidates) {
+	candidates.clear();
+	if (!m_data || ((int)query.size() < m_gramlength)) {
+		return false;
+	}
+	for (int i=0; i<(int)query.size(); i++) {
+		if (!query[i].harmonic.empty()) {
+			return false;
+		}
+	}
+
+	bool found = false;
+	std::uint64_t bestoffset = 0;
+	std::uint32_t bestcount = 0;
+	int bestshift = 0;
+	vector<Feature> features(query.size());
+	for (int kind=0; kind<MSearchIndexKinds; kind++) {
+		int run = 0;
+		for (int i=0; i<(int)query.size(); i++) {
+			run = getQueryFeature(query[i], kind, features[i]) ? run + 1 : 0;
+			if (run < m_gramlength) {
+				continue;
+			}
+			int shift = i - m_gramlength + 1;
+			std::uint64_t offset = 0;
+			std::uint32_t count = 0;
+			findGram(getGramKey(kind, &features[shift]), offset, count);
+			if (!found || (count < bestcount)) {
+				found = true;
+				bestoffset = offset;
+				bestcount = count;
+				bestshift = shift;
+			}
+		}
+	}
+	if (!found) {
+		return false;
+	}
+
+	auto file = m_files.find(getFileKey(infile));
+	if (file == m_files.end()) {
+		return false;
+	}
+	if (bestcount == 0) {
+		return true;
+	}
+	if ((bestoffset != m_lastoffset) || (bestshift != m_lastshift)) {
+		loadCandidates(bestoffset, bestcount, bestshift);
+	}
+	auto entry = m_candidates.find(file->second);
+	if (entry != m_candidates.end()) {
+		candidates = entry->second;
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::findGram -- Find the entry list of an n-gram.  Returns
+//     false if the n-gram is not in the index.
+//
+
+bool MSearchIndex::findGram(std::uint64_t key, std::uint64_t& offset,
+		std::uint32_t& count) {
+	std::uint64_t low = 0;
+	std::uint64_t high = m_gramcount;
+	while (low < high) {
+		std::uint64_t middle = low + (high - low) / 2;
+		const char* ptr = m_table + middle * MSearchIndexTableSize;
+		std::uint64_t value = readInt(ptr, 8);
+		if (value < key) {
+			low = middle + 1;
+		} else if (value > key) {
+			high = middle;
+		} else {
+			offset = readInt(ptr + 8, 8);
+			count = (std::uint32_t)readInt(ptr + 16, 4);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::loadCandidates -- Decode an entry list into the candidate
+//     positions for each file, where the n-gram is at the given shift
+//     from the start of the query.
+//
+
+void MSearchIndex::loadCandidates(std::uint64_t offset, std::uint32_t count,
+		int shift) {
+	m_candidates.clear();
+	m_lastoffset = offset;
+	m_lastshift = shift;
+	const char* end = m_data + m_size;
+	if (offset >= (std::uint64_t)(end - m_entries)) {
+		return;
+	}
+	const char* ptr = m_entries + offset;
+	std::uint64_t value = 0;
+	for (std::uint32_t i=0; i<count; i++) {
+		std::uint64_t delta = 0;
+		int bits = 0;
+		while ((ptr < end) && (*ptr & 0x80) && (bits < 64)) {
+			delta |= (std::uint64_t)(*ptr & 0x7f) << bits;
+			bits += 7;
+			ptr++;
+		}
+		if ((ptr >= end) || (bits >= 64)) {
+			// truncated index
+			return;
+		}
+		delta |= (std::uint64_t)(*ptr & 0x7f) << bits;
+		ptr++;
+		value += delta;
+		int position = (int)(value & 0xfffff);
+		if (position < shift) {
+			continue;
+		}
+		int voice = (int)((value >> 20) & 0xfff);
+		m_candidates[(std::uint32_t)(value >> 32)].emplace_back(voice, position - shift);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::appendInt -- Append an integer in little-endian order.
+//
+
+void MSearchIndex::appendInt(string& output, std::uint64_t value, int bytes) {
+	for (int i=0; i<bytes; i++) {
+		output += (char)((value >> (8 * i)) & 0xff);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::readInt -- Read an integer in little-endian order.
+//
+
+std::uint64_t MSearchIndex::readInt(const char* data, int bytes) {
+	const unsigned char* ptr = (const unsigned char*)data;
+	std::uint64_t value = 0;
+	for (int i=0; i<bytes; i++) {
+		value |= (std::uint64_t)ptr[i] << (8 * i);
+	}
+	return value;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::MSearchAutomaton -- Constructor.
+//
+
+MSearchAutomaton::MSearchAutomaton(void) {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::clear -- Remove all queries.
+//
+
+void MSearchAutomaton::clear(void) {
+	m_tries.clear();
+	m_tries.resize(MSearchIndex::getFeatureKinds());
+	m_kind.clear();
+	m_length.clear();
+	m_shift.clear();
+	m_built = false;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::getQueryCount -- Return the number of queries added.
+//
+
+int MSearchAutomaton::getQueryCount(void) {
+	return (int)m_kind.size();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::hasPattern -- Returns true if the candidates given
+//     by search() for the query include all of its matches.  If false,
+//     the query must be checked at all positions.
+//
+
+bool MSearchAutomaton::hasPattern(int query) {
+	if ((query < 0) || (query >= (int)m_kind.size())) {
+		return false;
+	}
+	return m_kind[query] >= 0;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::addQuery -- Add the pattern of a query to the automaton
+//     for its kind of feature.  Returns the number of the query, which is
+//     the index of its candidates given by search().  When runs of
+//     features have the same length, pitch classes and intervals are
+//     preferred to durations, since they give fewer candidates.
+//
+
+int MSearchAutomaton::addQuery(vector<MSearchQueryToken>& query) {
+	int index = (int)m_kind.size();
+	m_kind.push_back(-1);
+	m_length.push_back(0);
+	m_shift.push_back(0);
+	m_built = false;
+	for (int i=0; i<(int)query.size(); i++) {
+		if (!query[i].harmonic.empty()) {
+			return index;
+		}
+	}
+
+	static const int kinds[] = { MSearchIndexBase40, MSearchIndexChromatic,
+			MSearchIndexBase12, MSearchIndexDiatonic, MSearchIndexBase7,
+			MSearchIndexRhythm };
+	vector<MSearchIndex::Feature> features(query.size());
+	vector<MSearchIndex::Feature> pattern;
+	for (int k=0; k<MSearchIndexKinds; k++) {
+		int run = 0;
+		for (int i=0; i<=(int)query.size(); i++) {
+			if ((i < (int)query.size()) &&
+					MSearchIndex::getQueryFeature(query[i], kinds[k], features[i])) {
+				run++;
+				continue;
+			}
+			if (run > m_length[index]) {
+				m_kind[index] = kinds[k];
+				m_length[index] = run;
+				m_shift[index] = i - run;
+				pattern.assign(features.begin() + (i - run), features.begin() + i);
+			}
+			run = 0;
+		}
+	}
+	if (m_kind[index] < 0) {
+		return index;
+	}
+
+	Trie& trie = m_tries[m_kind[index]];
+	if (trie.next.empty()) {
+		trie.next.resize(1);
+		trie.output.resize(1);
+	}
+	int state = 0;
+	for (int i=0; i<(int)pattern.size(); i++) {
+		auto symbol = trie.symbols.find(pattern[i]);
+		if (symbol == trie.symbols.end()) {
+			int value = (int)trie.symbols.size();
+			symbol = trie.symbols.insert(make_pair(pattern[i], value)).first;
+		}
+		auto child = trie.next[state].find(symbol->second);
+		if (child != trie.next[state].end()) {
+			state = child->second;
+			continue;
+		}
+		int newstate = (int)trie.next.size();
+		trie.next[state][symbol->second] = newstate;
+		trie.next.resize(newstate + 1);
+		trie.output.resize(newstate + 1);
+		state = newstate;
+	}
+	trie.output[state].push_back(index);
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::build -- Calculate the failure links of each trie,
+//     adding the queries of the failure state to the output of each state.
+//
+
+void MSearchAutomaton::build(void) {
+	for (int k=0; k<(int)m_tries.size(); k++) {
+		Trie& trie = m_tries[k];
+		trie.fail.assign(trie.next.size(), 0);
+		if (trie.next.empty()) {
+			continue;
+		}
+		vector<int> queue;
+		for (auto& it : trie.next[0]) {
+			queue.push_back(it.second);
+		}
+		for (int i=0; i<(int)queue.size(); i++) {
+			int state = queue[i];
+			for (auto& it : trie.next[state]) {
+				int child = it.second;
+				int fail = trie.fail[state];
+				while ((fail > 0) && (trie.next[fail].find(it.first) == trie.next[fail].end())) {
+					fail = trie.fail[fail];
+				}
+				auto target = trie.next[fail].find(it.first);
+				if (target != trie.next[fail].end()) {
+					trie.fail[child] = target->second;
+				}
+				vector<int>& output = trie.output[trie.fail[child]];
+				trie.output[child].insert(trie.output[child].end(), output.begin(), output.end());
+				queue.push_back(child);
+			}
+		}
+	}
+	m_built = true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::advance -- Return the state of the automaton after
+//     the feature of the next note.
+//
+
+int MSearchAutomaton::advance(Trie& trie, int state,
+		const MSearchIndex::Feature& feature) {
+	auto symbol = trie.symbols.find(feature);
+	if (symbol == trie.symbols.end()) {
+		return 0;
+	}
+	while (true) {
+		auto child = trie.next[state].find(symbol->second);
+		if (child != trie.next[state].end()) {
+			return child->second;
+		}
+		if (state == 0) {
+			return 0;
+		}
+		state = trie.fail[state];
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::search -- Find the voices and positions where each
+//     query may match in the note/rest attacks of each voice, in one pass
+//     over the notes of each voice.  The candidates of each query are
+//     sorted by voice and position.  Returns false if the features of the
+//     notes cannot be compared to the patterns, in which case all queries
+//     must be checked at all positions.
+//
+
+bool MSearchAutomaton::search(vector<vector<NoteCell*>>& attacks,
+		vector<vector<pair<int, int>>>& candidates) {
+	if (!m_built) {
+		build();
+	}
+	candidates.resize(m_kind.size());
+	for (int i=0; i<(int)candidates.size(); i++) {
+		candidates[i].clear();
+	}
+	vector<int> kinds;
+	for (int k=0; k<(int)m_tries.size(); k++) {
+		if (!m_tries[k].next.empty()) {
+			kinds.push_back(k);
+		}
+	}
+	if (kinds.empty()) {
+		return true;
+	}
+
+	vector<vector<MSearchIndex::Feature>> features;
+	vector<int> states(kinds.size());
+	for (int v=0; v<(int)attacks.size(); v++) {
+		if (!MSearchIndex::getNoteFeatures(attacks[v], features)) {
+			return false;
+		}
+		fill(states.begin(), states.end(), 0);
+		for (int j=0; j<(int)attacks[v].size(); j++) {
+			for (int k=0; k<(int)kinds.size(); k++) {
+				Trie& trie = m_tries[kinds[k]];
+				states[k] = advance(trie, states[k], features[kinds[k]][j]);
+				vector<int>& output = trie.output[states[k]];
+				for (int i=0; i<(int)output.size(); i++) {
+					int query = output[i];
+					int start = j - m_length[query] + 1 - m_shift[query];
+					if (start >= 0) {
+						candidates[query].emplace_back(v, start);
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+
+
 /////////////////////////////////
 //
 // Tool_msearch::Tool_msearch -- Set the recognized options for the tool.
@@ -113519,6 +123306,8 @@ Tool_msearch::Tool_msearch(void) {
 	define("m|mark|marker=s:@",           "marking character");
 	define("M|no-mark|no-marker=b",       "do not mark matches");
 	define("Q|quiet=b",                   "quiet mode: do not summarize matches");
+	define("index=s",                     "n-gram index of the files (see msearch-index)");
+	define("queries=s",                   "file with the options of a query on each line");
 }
 
 
@@ -113561,22 +123350,21 @@ bool Tool_msearch::run(HumdrumFile& infile, ostream& out) {
 
 
 bool Tool_msearch::run(HumdrumFile& infile) {
-	m_sonorities.resize(infile.getLineCount());
-	m_sonoritiesChecked.resize(infile.getLineCount());
-	fill(m_sonoritiesChecked.begin(), m_sonoritiesChecked.end(), false);
-	m_debugQ = getBoolean("debug");
-	m_quietQ = getBoolean("quiet");
-	m_nooverlapQ = getBoolean("no-overlap");
-	NoteGrid grid(infile);
+	if (getBoolean("queries")) {
+		return doQueryListSearch(infile);
+	}
+	initialize(infile);
+
+	// With an index, the grid is only needed if the index gives
+	// candidates for a match in the file (see doMusicSearch()).
+	NoteGrid grid;
+	if (m_debugQ || !m_text.empty() || !getBoolean("index")) {
+		grid.load(infile);
+	}
 	if (m_debugQ) {
 		grid.printGridInfo(cerr);
 		// return 1;
 	}
-	initialize();
-
-	if (getBoolean("text")) {
-		m_text = getString("text");
-	}
 
 	if (m_text.empty()) {
 		vector<MSearchQueryToken> query;
@@ -113600,10 +123388,20 @@ bool Tool_msearch::run(HumdrumFile& infile) {
 
 //////////////////////////////
 //
-// Tool_msearch::initialize --
+// Tool_msearch::initialize -- Prepare to search a file.
 //
 
-void Tool_msearch::initialize(void) {
+void Tool_msearch::initialize(HumdrumFile& infile) {
+	m_sonorities.resize(infile.getLineCount());
+	m_sonoritiesChecked.resize(infile.getLineCount());
+	fill(m_sonoritiesChecked.begin(), m_sonoritiesChecked.end(), false);
+	m_debugQ = getBoolean("debug");
+	m_quietQ = getBoolean("quiet");
+	m_nooverlapQ = getBoolean("no-overlap");
+	if (getBoolean("text")) {
+		m_text = getString("text");
+	}
+
 	m_marker = getString("marker");
 	// only allowing a single character for now:
 	m_markQ = !getBoolean("no-marker");
@@ -113695,6 +123493,20 @@ void Tool_msearch::fillWordsForTrack(vector<TextInfo*>& words,
 
 void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		vector<MSearchTextQuery>& query) {
+	int tcount = markTextMatches(infile, query);
+	addTextSearchResults(infile, tcount);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::markTextMatches -- Mark the words which match the query,
+//     and return the number of matches.
+//
+
+int Tool_msearch::markTextMatches(HumdrumFile& infile,
+		vector<MSearchTextQuery>& query) {
 
 	vector<TextInfo*> words;
 	words.reserve(10000);
@@ -113711,6 +123523,22 @@ void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		}
 	}
 
+	for (int i=0; i<(int)words.size(); i++) {
+		delete words[i];
+		words[i] = NULL;
+	}
+	return tcount;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::addTextSearchResults -- Add the marker definition and
+//     the summary of the matches to the end of the file.
+//
+
+void Tool_msearch::addTextSearchResults(HumdrumFile& infile, int tcount) {
 	string textinterp = "**text";
 	vector<HTp> interps;
 	infile.getSpineStartList(interps);
@@ -113742,11 +123570,6 @@ void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		infile.createLinesFromTokens();
 	}
 
-	for (int i=0; i<(int)words.size(); i++) {
-		delete words[i];
-		words[i] = NULL;
-	}
-
 	if (!m_quietQ) {
 		addTextSearchSummary(infile, tcount, m_marker);
 	}
@@ -113761,7 +123584,7 @@ void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 
 void Tool_msearch::printQuery(vector<MSearchQueryToken>& query) {
 	for (int i=0; i<(int)query.size(); i++) {
-		cout << query[i];
+		m_free_text << query[i];
 	}
 }
 
@@ -113775,22 +123598,65 @@ void Tool_msearch::printQuery(vector<MSearchQueryToken>& query) {
 void Tool_msearch::doMusicSearch(HumdrumFile& infile, NoteGrid& grid,
 		vector<MSearchQueryToken>& query) {
 
-	m_matches.clear();
-
 	if (m_debugQ) {
 		printQuery(query);
 	}
 
+	// Only check the voices and positions given by the index, if there
+	// is one which can be used for the file and query:
+	vector<pair<int, int>> candidates;
+	bool indexQ = getIndexCandidates(infile, query, candidates);
+	if (getBoolean("index") && !m_debugQ && (!indexQ || !candidates.empty())) {
+		// grid was not loaded in run()
+		grid.load(infile);
+	}
+
 	vector<vector<NoteCell*>> attacks;
 	attacks.resize(grid.getVoiceCount());
 	for (int i=0; i<grid.getVoiceCount(); i++) {
 		grid.getNoteAndRestAttacks(attacks[i], i);
 	}
 
+	int mcount = markMusicMatches(infile, attacks, query, indexQ ? &candidates : NULL);
+	addMusicSearchResults(infile, mcount);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::markMusicMatches -- Mark and store the matches of the query
+//     in the note/rest attacks of each voice, and return the number of
+//     matches.  If candidates is not NULL, only check the given
+//     voice/position pairs (sorted by voice and then position).
+//
+
+int Tool_msearch::markMusicMatches(HumdrumFile& infile,
+		vector<vector<NoteCell*>>& attacks, vector<MSearchQueryToken>& query,
+		vector<pair<int, int>>* candidates) {
+
+	m_matches.clear();
+
 	vector<NoteCell*> match;
 	int mcount = 0;
+	int k = 0;
 	for (int i=0; i<(int)attacks.size(); i++) {
-		for (int j=0; j<(int)attacks[i].size(); j++) {
+		int count = (int)attacks[i].size();
+		if (candidates) {
+			vector<pair<int, int>>& list = *candidates;
+			while ((k < (int)list.size()) && (list[k].first < i)) {
+				k++;
+			}
+			count = 0;
+			while ((k + count < (int)list.size()) && (list[k + count].first == i)) {
+				count++;
+			}
+		}
+		for (int n=0; n<count; n++) {
+			int j = candidates ? (*candidates)[k + n].second : n;
+			if (j >= (int)attacks[i].size()) {
+				break;
+			}
 			m_tomark.clear();
 			bool status = checkForMusicMatch(attacks[i], j, query, match);
 			if (!status) {
@@ -113805,7 +123671,18 @@ void Tool_msearch::doMusicSearch(HumdrumFile& infile, NoteGrid& grid,
 			}
 		}
 	}
+	return mcount;
+}
+
 
+
+//////////////////////////////
+//
+// Tool_msearch::addMusicSearchResults -- Add the marker definition and
+//     the summary of the matches to the end of the file.
+//
+
+void Tool_msearch::addMusicSearchResults(HumdrumFile& infile, int mcount) {
 	if (mcount && m_markQ) {
 		string content = "!!!RDF**kern: " + m_marker + " = marked note";
 		if (getBoolean("color")) {
@@ -113821,6 +123698,144 @@ void Tool_msearch::doMusicSearch(HumdrumFile& infile, NoteGrid& grid,
 
 
 
+//////////////////////////////
+//
+// Tool_msearch::doQueryListSearch -- Search a file for each query in the
+//     list given with the --queries option.  The notes of each voice are
+//     scanned once for the patterns of all queries (see MSearchAutomaton),
+//     and then the matches of each query are marked and summarized in the
+//     order of the list, so that the output is the same as running
+//     msearch with each query in turn.
+//
+
+bool Tool_msearch::doQueryListSearch(HumdrumFile& infile) {
+	string filename = getString("queries");
+	if (filename != m_queryfile) {
+		loadQueryList(filename);
+	}
+	if (hasError()) {
+		return false;
+	}
+
+	NoteGrid grid(infile);
+	vector<vector<NoteCell*>> attacks;
+	attacks.resize(grid.getVoiceCount());
+	for (int i=0; i<grid.getVoiceCount(); i++) {
+		grid.getNoteAndRestAttacks(attacks[i], i);
+	}
+	vector<vector<pair<int, int>>> candidates;
+	bool automatonQ = m_automaton.search(attacks, candidates);
+
+	// Mark the matches of all queries before adding their results to the
+	// end of the file, since durations of notes at the end of the music
+	// would change after lines are added.
+	vector<int> counts(m_querytools.size(), 0);
+	for (int i=0; i<(int)m_querytools.size(); i++) {
+		Tool_msearch& tool = *m_querytools[i];
+		tool.initialize(infile);
+		if (!tool.m_text.empty()) {
+			vector<MSearchTextQuery> query;
+			tool.fillTextQuery(query, tool.m_text);
+			counts[i] = tool.markTextMatches(infile, query);
+		} else if (!m_queries[i].empty()) {
+			bool patternQ = automatonQ && m_automaton.hasPattern(i);
+			counts[i] = tool.markMusicMatches(infile, attacks, m_queries[i],
+					patternQ ? &candidates[i] : NULL);
+		}
+	}
+	for (int i=0; i<(int)m_querytools.size(); i++) {
+		Tool_msearch& tool = *m_querytools[i];
+		if (!tool.m_text.empty()) {
+			tool.addTextSearchResults(infile, counts[i]);
+		} else if (!m_queries[i].empty()) {
+			tool.addMusicSearchResults(infile, counts[i]);
+		}
+	}
+
+	infile.createLinesFromTokens();
+	m_humdrum_text << infile;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::loadQueryList -- Read a file of queries, one per line,
+//     each given as msearch options (such as "-p cdefg" or "-i 2-2 -r 448").
+//     Empty lines and lines starting with "#" are ignored.
+//
+
+bool Tool_msearch::loadQueryList(const string& filename) {
+	m_queryfile = filename;
+	m_querytools.clear();
+	m_queries.clear();
+	m_automaton.clear();
+
+	ifstream input(filename);
+	if (!input.is_open()) {
+		m_error_text << "Error: cannot read query file " << filename << endl;
+		return false;
+	}
+	string line;
+	while (getline(input, line)) {
+		size_t start = line.find_first_not_of(" \t\r");
+		if ((start == string::npos) || (line[start] == '#')) {
+			continue;
+		}
+		auto tool = std::make_shared<Tool_msearch>();
+		if (!tool->process("msearch " + line, 0, 1) || tool->getBoolean("queries")) {
+			m_error_text << "Error: invalid query \"" << line << "\" in " << filename << endl;
+			m_querytools.clear();
+			m_queries.clear();
+			m_automaton.clear();
+			return false;
+		}
+		m_queries.resize(m_queries.size() + 1);
+		if (!tool->getBoolean("text")) {
+			tool->fillMusicQuery(m_queries.back());
+		}
+		m_automaton.addQuery(m_queries.back());
+		m_querytools.push_back(tool);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::getIndexCandidates -- Get the voices and positions
+//     in the file where the query may match from the index given with
+//     the --index option (which is read for the first file searched).
+//     Returns false if the index cannot be used for the file or query,
+//     in which case all positions must be checked.
+//
+
+bool Tool_msearch::getIndexCandidates(HumdrumFile& infile,
+		vector<MSearchQueryToken>& query, vector<pair<int, int>>& candidates) {
+	candidates.clear();
+	if (!getBoolean("index")) {
+		return false;
+	}
+	string filename = getString("index");
+	if (filename != m_indexfile) {
+		m_indexfile = filename;
+		m_index = std::make_shared<MSearchIndex>();
+		if (!m_index->read(filename)) {
+			m_warning_text << "Warning: cannot read index file " << filename
+			               << ", so searching all notes" << endl;
+			m_index.reset();
+		}
+	}
+	if (!m_index) {
+		return false;
+	}
+	return m_index->getCandidates(infile, query, candidates);
+}
+
+
+
 //////////////////////////////
 //
 // Tool_msearch::addMusicSearchSummary --
@@ -121801,6 +131816,9 @@ Tool_myank::Tool_myank(void) {
 	define("h|help=b",                           "short description");
 	define("hide-starting=b",                    "prevent printStarting");
 	define("hide-ending=b",                      "prevent printEnding");
+
+	setRequiredAnalyses(HumFileAnalysis::getMask(HumFileAnalysis::Rhythm) |
+			HumFileAnalysis::getMask(HumFileAnalysis::Nulls));
 }
 
 
@@ -121856,7 +131874,7 @@ bool Tool_myank::run(HumdrumFile& infile) {
 	processFile(infile);
 	// Re-load the text for each line from their tokens.
 	infile.createLinesFromTokens();
-	return true;
+	return !hasError();
 }
 
 
@@ -122037,6 +132055,9 @@ void Tool_myank::processFile(HumdrumFile& infile) {
 	// expand to multiple measures later.
 	expandMeasureOutList(m_measureOutList, m_measureInList, infile,
 			measurestring);
+	if (hasError()) {
+		return;
+	}
 
 	if (m_inlistQ) {
 		m_free_text << "INPUT MEASURE MAP: " << endl;
@@ -122885,8 +132906,8 @@ void Tool_myank::adjustGlobalInterpretations(HumdrumFile& infile, int ii,
 void Tool_myank::adjustGlobalInterpretationsStart(HumdrumFile& infile, int ii,
 		vector<MeasureInfo>& outmeasures, int index) {
 	if (index != 0) {
-		cerr << "Error in adjustGlobalInterpetationsStart" << endl;
-		exit(1);
+		m_error_text << "Error in adjustGlobalInterpetationsStart" << endl;
+		return;
 	}
 
 	int i;
@@ -123902,20 +133923,22 @@ void Tool_myank::expandMeasureOutList(vector<MeasureInfo>& measureout,
 		}
 	}
 	if (maxmeasure <= 0 && !getBoolean("lines")) {
-		cerr << "Error: There are no measure numbers present in the data" << endl;
-		exit(1);
+		m_error_text << "Error: There are no measure numbers present in the data" << endl;
+		return;
 	}
 	if (maxmeasure > 1123123) {
-		cerr << "Error: ridiculusly large measure number: " << maxmeasure << endl;
-		exit(1);
+		m_error_text << "Error: ridiculusly large measure number: " << maxmeasure << endl;
+		return;
 	}
+	// The output list is left empty for --max and --min, so that only
+	// the measure number is printed:
 	if (m_maxQ) {
 		if (measurein.size() == 0) {
 			m_humdrum_text << 0 << endl;
 		} else {
 			m_humdrum_text << maxmeasure << endl;
 		}
-		exit(0);
+		return;
 	} else if (m_minQ) {
 		for (int ii=0; ii<infile.getLineCount(); ii++) {
 			if (infile[ii].isBarline()) {
@@ -123923,12 +133946,12 @@ void Tool_myank::expandMeasureOutList(vector<MeasureInfo>& measureout,
 					break;
 				} else {
 					m_humdrum_text << 0 << endl;
-					exit(0);
+					return;
 				}
 			}
 			if (infile[ii].isData()) {
 				m_humdrum_text << 0 << endl;
-				exit(0);
+				return;
 			}
 		}
 		if (measurein.size() == 0) {
@@ -123936,7 +133959,7 @@ void Tool_myank::expandMeasureOutList(vector<MeasureInfo>& measureout,
 		} else {
 			m_humdrum_text << minmeasure << endl;
 		}
-		exit(0);
+		return;
 	}
 
 	// create reverse-lookup list
@@ -123966,6 +133989,9 @@ void Tool_myank::expandMeasureOutList(vector<MeasureInfo>& measureout,
 		start += value - 1;
 		start += (int)hre.getMatch(1).size();
 		processFieldEntry(range, hre.getMatch(1), infile, maxmeasure, measurein, inmap);
+		if (hasError()) {
+			return;
+		}
 		value = hre.search(ostring, start, searchexp);
 	}
 }
@@ -124358,16 +134384,16 @@ void Tool_myank::processFieldEntry(vector<MeasureInfo>& field,
 		if (lastone  < 0         ) { lastone  = 0         ; }
 
 		if ((firstone < 1) && (firstone != 0)) {
-			cerr << "Error: range token: \"" << str << "\""
+			m_error_text << "Error: range token: \"" << str << "\""
 				  << " contains too small a number at start: " << firstone << endl;
-			cerr << "Minimum number allowed is " << 1 << endl;
-			exit(1);
+			m_error_text << "Minimum number allowed is " << 1 << endl;
+			return;
 		}
 		if ((lastone < 1) && (lastone != 0)) {
-			cerr << "Error: range token: \"" << str << "\""
+			m_error_text << "Error: range token: \"" << str << "\""
 				  << " contains too small a number at end: " << lastone << endl;
-			cerr << "Minimum number allowed is " << 1 << endl;
-			exit(1);
+			m_error_text << "Minimum number allowed is " << 1 << endl;
+			return;
 		}
 
 		if (firstone > lastone) {
@@ -124431,12 +134457,13 @@ void Tool_myank::processFieldEntry(vector<MeasureInfo>& field,
 		// do something with letter later...
 
 		if ((value < 1) && (value != 0)) {
-			cerr << "Error: range token: \"" << str << "\""
+			m_error_text << "Error: range token: \"" << str << "\""
 				  << " contains too small a number at end: " << value << endl;
-			cerr << "Minimum number allowed is " << 1 << endl;
-			exit(1);
+			m_error_text << "Minimum number allowed is " << 1 << endl;
+			return;
 		}
-		if (inmap[value] >= 0) {
+		// Measures after the last one in the file are ignored:
+		if ((value <= maxmeasure) && (inmap[value] >= 0)) {
 			current.clear();
 			current.file = &infile;
 			current.num = value;
@@ -124461,7 +134488,9 @@ void Tool_myank::processFieldEntry(vector<MeasureInfo>& field,
 		}
 	}
 
-	field.back().stopStyle = measureStyling;
+	if (!field.empty()) {
+		field.back().stopStyle = measureStyling;
+	}
 
 }
 
@@ -130198,6 +140227,8 @@ Tool_recip::Tool_recip(void) {
 	define("e|exinterp=s:**recip",   "use the given exinterp for data output");
 	define("n|kern-pitch=s:e",       "note to add for '-e kern' option");
 	define("kern=b",                 "equivalent to '-e kern' option");
+
+	setRequiredAnalyses(HumFileAnalysis::getMask(HumFileAnalysis::Rhythm));
 }
 
 
@@ -130686,6 +140717,8 @@ Tool_rid::Tool_rid(void) {
    define("M|all-barlines=b",              "remove measure lines");
    define("C|all-comments=b",              "remove all comment lines");
    define("c=b",                           "remove global and local comment lines");
+
+	setRequiredAnalyses(0);
 }
 
 
@@ -130971,7 +141004,7 @@ void Tool_rmask::initialize(HumdrumFile& infile) {
 		string klist = getString("kern");
 		infile.makeBooleanTrackList(m_spines, klist);
 		for (int z = 0; z < (int)infile.getMaxTrack(); z++) {
-			cout << "\t" << m_spines.at(z) << endl;
+			m_free_text << "\t" << m_spines.at(z) << endl;
 		}
 	} else {
 		m_spines.resize(infile.getMaxTrack());
@@ -136712,6 +146745,318 @@ double MeasureComparison::getCorrelation7pc(void) {
 	return correlation7pc;
 }
 
+//////////////////////////////////////////////////////////////////////////
+
+// Number of values stored for each histogram (seven pitch classes padded
+// to 64 bytes), and the size of the blocks of the correlation matrix
+// which are calculated together:
+static const int MeasureCorrelationStride      = 8;
+static const int MeasureCorrelationTileRows    = 64;
+static const int MeasureCorrelationTileColumns = 2048;
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::MeasureCorrelationMatrix --
+//
+
+MeasureCorrelationMatrix::MeasureCorrelationMatrix(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::~MeasureCorrelationMatrix --
+//
+
+MeasureCorrelationMatrix::~MeasureCorrelationMatrix() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::clear --
+//
+
+void MeasureCorrelationMatrix::clear(void) {
+	m_rowvalues.clear();
+	m_rowscales.clear();
+	m_rowsums.clear();
+	m_rowstorage.clear();
+	m_rows = NULL;
+	clearColumns();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::clearColumns -- Remove the column measures
+//     (keeping the row measures).
+//
+
+void MeasureCorrelationMatrix::clearColumns(void) {
+	m_columnvalues.clear();
+	m_columnscales.clear();
+	m_columnsums.clear();
+	m_columnstorage.clear();
+	m_columns = NULL;
+	m_matrix.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::setRows -- Set the measures for the rows
+//     of the matrix.
+//
+
+void MeasureCorrelationMatrix::setRows(MeasureDataSet& set) {
+	m_rowvalues.clear();
+	m_rowscales.clear();
+	m_rowsums.clear();
+	addHistograms(set, m_rowvalues, m_rowscales, m_rowsums);
+	m_matrix.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::addColumns -- Append the measures of a set
+//     to the columns of the matrix, so that one set of row measures can
+//     be compared to several files at once.  Returns the index of the
+//     first column for the set.
+//
+
+int MeasureCorrelationMatrix::addColumns(MeasureDataSet& set) {
+	int output = getColumnCount();
+	addHistograms(set, m_columnvalues, m_columnscales, m_columnsums);
+	m_matrix.clear();
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::addHistograms -- Store the pitch-class
+//     histograms of the measures in a set, with the mean of each
+//     histogram subtracted, so that the Pearson correlation of two
+//     measures is the dot product of their values times their scales.
+//
+
+void MeasureCorrelationMatrix::addHistograms(MeasureDataSet& set,
+		vector<double>& values, vector<double>& scales, vector<double>& sums) {
+	for (int i=0; i<set.size(); i++) {
+		vector<double>& hist = set[i].getHistogram7pc();
+		int size = std::min((int)hist.size(), 7);
+		double mean = 0.0;
+		for (int k=0; k<size; k++) {
+			mean += hist[k];
+		}
+		mean = size ? mean / size : 0.0;
+		double length = 0.0;
+		for (int k=0; k<MeasureCorrelationStride; k++) {
+			double value = (k < size) ? hist[k] - mean : 0.0;
+			values.push_back(value);
+			length += value * value;
+		}
+		scales.push_back(1.0 / sqrt(length));
+		sums.push_back(set[i].getSum7pc());
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::alignValues -- Resize the storage so that
+//     it holds count values starting at a 64-byte boundary, and return
+//     a pointer to the first value.
+//
+
+double* MeasureCorrelationMatrix::alignValues(vector<double>& storage, int count) {
+	storage.assign(count + MeasureCorrelationStride, 0.0);
+	uintptr_t address = (uintptr_t)storage.data();
+	int offset = (int)(((64 - address % 64) % 64) / sizeof(double));
+	return storage.data() + offset;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::analyze -- Calculate the correlation of each
+//     row measure with each column measure.  The matrix is divided into
+//     tiles which are calculated by the given number of threads (0 = all
+//     cores).
+//
+
+void MeasureCorrelationMatrix::analyze(int threads) {
+	int rows = getRowCount();
+	int columns = getColumnCount();
+
+	m_rows = alignValues(m_rowstorage, rows * MeasureCorrelationStride);
+	std::copy(m_rowvalues.begin(), m_rowvalues.end(), m_rows);
+	m_columns = alignValues(m_columnstorage, columns * MeasureCorrelationStride);
+	for (int j=0; j<columns; j++) {
+		for (int k=0; k<MeasureCorrelationStride; k++) {
+			m_columns[k * columns + j] = m_columnvalues[j * MeasureCorrelationStride + k];
+		}
+	}
+	m_matrix.assign((size_t)rows * columns, 0.0);
+
+	if (threads <= 0) {
+		threads = HumThreadPool::getHardwareThreadCount();
+	}
+	std::unique_ptr<HumThreadPool> pool;
+	if ((threads > 1) && ((size_t)rows * columns > 4096)) {
+		pool.reset(new HumThreadPool(threads));
+	}
+	for (int i=0; i<rows; i+=MeasureCorrelationTileRows) {
+		int i2 = std::min(i + MeasureCorrelationTileRows, rows);
+		for (int j=0; j<columns; j+=MeasureCorrelationTileColumns) {
+			int j2 = std::min(j + MeasureCorrelationTileColumns, columns);
+			if (pool) {
+				pool->submit([this, i, i2, j, j2]() { analyzeTile(i, i2, j, j2); });
+			} else {
+				analyzeTile(i, i2, j, j2);
+			}
+		}
+	}
+	if (pool) {
+		pool->wait();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::analyzeTile -- Calculate the correlations
+//     for a block of the matrix.  The loop over the columns has no
+//     dependencies between iterations, so the compiler can calculate
+//     several columns at once with SIMD instructions.  The results
+//     are the same as MeasureComparison::compare() within rounding.
+//
+
+void MeasureCorrelationMatrix::analyzeTile(int row1, int row2, int column1,
+		int column2) {
+	int columns = getColumnCount();
+	const double* c0 = m_columns;
+	const double* c1 = c0 + columns;
+	const double* c2 = c1 + columns;
+	const double* c3 = c2 + columns;
+	const double* c4 = c3 + columns;
+	const double* c5 = c4 + columns;
+	const double* c6 = c5 + columns;
+	const double* cscale = m_columnscales.data();
+	for (int i=row1; i<row2; i++) {
+		const double* a = m_rows + i * MeasureCorrelationStride;
+		double rscale = m_rowscales[i];
+		double* out = m_matrix.data() + (size_t)i * columns;
+		for (int j=column1; j<column2; j++) {
+			double dot = a[0] * c0[j] + a[1] * c1[j] + a[2] * c2[j] + a[3] * c3[j]
+					+ a[4] * c4[j] + a[5] * c5[j] + a[6] * c6[j];
+			double correl = dot * rscale * cscale[j];
+			out[j] = (fabs(correl - 1.0) < 0.00000001) ? 1.0 : correl;
+		}
+		// Measures without notes are only similar to each other:
+		if (m_rowsums[i] == 0.0) {
+			for (int j=column1; j<column2; j++) {
+				out[j] = (m_columnsums[j] == 0.0) ? 1.0 : 0.0;
+			}
+			continue;
+		}
+		for (int j=column1; j<column2; j++) {
+			if (m_columnsums[j] == 0.0) {
+				out[j] = 0.0;
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::getCorrelation --
+//
+
+double MeasureCorrelationMatrix::getCorrelation(int row, int column) {
+	return m_matrix.at((size_t)row * getColumnCount() + column);
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::printCorrelation -- Print a correlation
+//     rounded to two decimal places.
+//
+
+ostream& MeasureCorrelationMatrix::printCorrelation(ostream& out, double correl) {
+	if (correl > 0.0) {
+		out << int(correl * 100.0 + 0.5)/100.0;
+	} else {
+		out << -int(-correl * 100.0 + 0.5)/100.0;
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::printGrid -- Print the correlations of
+//     the rows with the given range of columns.
+//
+
+ostream& MeasureCorrelationMatrix::printGrid(ostream& out, int column1,
+		int column2) {
+	for (int i=0; i<getRowCount(); i++) {
+		for (int j=column1; j<column2; j++) {
+			printCorrelation(out, getCorrelation(i, j));
+			if (j < column2 - 1) {
+				out << '\t';
+			}
+		}
+		out << endl;
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::printDiagonal -- Print the correlations of
+//     each row with the column at the same position in the given range
+//     of columns (one line for each row).
+//
+
+ostream& MeasureCorrelationMatrix::printDiagonal(ostream& out, int column1,
+		int column2) {
+	for (int i=0; i<getRowCount(); i++) {
+		if (i < column2 - column1) {
+			printCorrelation(out, getCorrelation(i, column1 + i));
+			if (i < column2 - column1 - 1) {
+				out << '\t';
+			}
+		}
+		out << endl;
+	}
+	return out;
+}
+
+
+
 //////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////
@@ -136752,7 +147097,32 @@ MeasureComparisonGrid::~MeasureComparisonGrid() {
 //
 
 void MeasureComparisonGrid::clear(void) {
-	m_grid.clear();
+	m_matrix.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureComparisonGrid::setThreadCount -- Set the number of threads
+//     used to calculate the grid (0 = all cores).
+//
+
+void MeasureComparisonGrid::setThreadCount(int threads) {
+	m_threads = threads;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureComparisonGrid::getCorrelation7pc -- Return the correlation of
+//     the pitch-class histograms of a measure in the first set and a
+//     measure in the second set.
+//
+
+double MeasureComparisonGrid::getCorrelation7pc(int index1, int index2) {
+	return m_matrix.getCorrelation(index1, index2);
 }
 
 
@@ -136767,15 +147137,10 @@ void MeasureComparisonGrid::analyze(MeasureDataSet* set1, MeasureDataSet* set2)
 }
 
 void MeasureComparisonGrid::analyze(MeasureDataSet& set1, MeasureDataSet& set2) {
-	m_grid.resize(set1.size());
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		m_grid[i].resize(set2.size());
-	}
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		for (int j=0; j<(int)m_grid[i].size(); j++) {
-			m_grid[i][j].compare(set1[i], set2[j]);
-		}
-	}
+	m_matrix.clear();
+	m_matrix.setRows(set1);
+	m_matrix.addColumns(set2);
+	m_matrix.analyze(m_threads);
 	m_set1 = &set1;
 	m_set2 = &set2;
 }
@@ -136789,21 +147154,7 @@ void MeasureComparisonGrid::analyze(MeasureDataSet& set1, MeasureDataSet& set2)
 //
 
 ostream& MeasureComparisonGrid::printCorrelationGrid(ostream& out) {
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		for (int j=0; j<(int)m_grid[i].size(); j++) {
-			double correl = m_grid[i][j].getCorrelation7pc();
-			if (correl > 0.0) {
-				out << int(correl * 100.0 + 0.5)/100.0;
-			} else {
-				out << -int(-correl * 100.0 + 0.5)/100.0;
-			}
-			if (j < (int)m_grid[i].size() - 1) {
-				out << '\t';
-			}
-		}
-		out << endl;
-	}
-	return out;
+	return m_matrix.printGrid(out, 0, m_matrix.getColumnCount());
 }
 
 
@@ -136815,24 +147166,7 @@ ostream& MeasureComparisonGrid::printCorrelationGrid(ostream& out) {
 //
 
 ostream& MeasureComparisonGrid::printCorrelationDiagonal(ostream& out) {
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		for (int j=0; j<(int)m_grid[i].size(); j++) {
-			if (i != j) {
-				continue;
-			}
-			double correl = m_grid[i][j].getCorrelation7pc();
-			if (correl > 0.0) {
-				out << int(correl * 100.0 + 0.5)/100.0;
-			} else {
-				out << -int(-correl * 100.0 + 0.5)/100.0;
-			}
-			if (j < (int)m_grid[i].size() - 1) {
-				out << '\t';
-			}
-		}
-		out << endl;
-	}
-	return out;
+	return m_matrix.printDiagonal(out, 0, m_matrix.getColumnCount());
 }
 
 
@@ -137124,15 +147458,15 @@ ostream& MeasureComparisonGrid::printSvgGrid(ostream& out) {
 	double sdur1 = getScoreDuration1();
 	double sdur2 = getScoreDuration2();
 
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		for (int j=0; j<(int)m_grid[i].size(); j++) {
+	for (int i=0; i<m_matrix.getRowCount(); i++) {
+		for (int j=0; j<m_matrix.getColumnCount(); j++) {
 			width = getDuration2(j) / sdur2 * imagewidth;
 			height = getDuration1(i) / sdur1 * imageheight;
 
 			x = getStartTime2(j)/sdur2 * imageheight;
 			y = getStartTime1(i)/sdur1 * imagewidth;
 
-			getColorMapping(m_grid[i][j].getCorrelation7pc(), hue, saturation, lightness);
+			getColorMapping(getCorrelation7pc(i, j), hue, saturation, lightness);
 			ss << "hsl(" << hue << "," << saturation << "%," << lightness << "%)";
 			crect = grid.append_child("rect");
 			crect.append_attribute("x") = to_string(x).c_str();
@@ -137165,6 +147499,8 @@ ostream& MeasureComparisonGrid::printSvgGrid(ostream& out) {
 Tool_simat::Tool_simat(void) {
 	define("r|raw=b",      "output raw correlation matrix");
 	define("d|diagonal=b", "output diagonal of correlation matrix");
+	define("m|many=b",     "compare the first file to each of the other files");
+	define("j|jobs=i:1",   "number of threads for the correlation matrix (0 = all cores)");
 }
 
 
@@ -137175,6 +147511,9 @@ Tool_simat::Tool_simat(void) {
 //
 
 bool Tool_simat::run(HumdrumFileSet& infiles) {
+	if (getBoolean("many")) {
+		return processManyFiles(infiles);
+	}
 	bool status = true;
 	if (infiles.getCount() == 1) {
 		status = run(infiles[0], infiles[0]);
@@ -137245,8 +147584,11 @@ bool Tool_simat::run(HumdrumFile& infile1, HumdrumFile& infile2) {
 //
 
 void Tool_simat::processFile(HumdrumFile& infile1, HumdrumFile& infile2) {
+	m_data1.clear();
+	m_data2.clear();
 	m_data1.parse(infile1);
 	m_data2.parse(infile2);
+	m_grid.setThreadCount(getInteger("jobs"));
 	m_grid.analyze(m_data1, m_data2);
 	if (getBoolean("raw")) {
 		m_grid.printCorrelationGrid(m_free_text);
@@ -137262,6 +147604,51 @@ void Tool_simat::processFile(HumdrumFile& infile1, HumdrumFile& infile2) {
 
 
 
+//////////////////////////////
+//
+// Tool_simat::processManyFiles -- Compare the measures of the first file
+//     to the measures of each of the other files, calculating all of the
+//     correlations in one matrix.  When the files are given one at a time
+//     (such as from a file stream), the first file is kept for comparing
+//     to the later files.  The raw correlation grid (or its diagonal) is
+//     printed for each file after a line with the filename.
+//
+
+bool Tool_simat::processManyFiles(HumdrumFileSet& infiles) {
+	int start = 0;
+	if (m_many.getRowCount() == 0) {
+		if (infiles.getCount() == 0) {
+			return false;
+		}
+		MeasureDataSet data(infiles[0]);
+		m_many.setRows(data);
+		start = 1;
+	}
+	m_many.clearColumns();
+	vector<int> columns;
+	for (int i=start; i<infiles.getCount(); i++) {
+		MeasureDataSet data(infiles[i]);
+		columns.push_back(m_many.addColumns(data));
+	}
+	columns.push_back(m_many.getColumnCount());
+	m_many.analyze(getInteger("jobs"));
+
+	for (int i=start; i<infiles.getCount(); i++) {
+		int column1 = columns[i - start];
+		int column2 = columns[i - start + 1];
+		m_free_text << "!!file: " << infiles[i].getFilename() << endl;
+		if (getBoolean("diagonal")) {
+			m_many.printDiagonal(m_free_text, column1, column2);
+		} else {
+			m_many.printGrid(m_free_text, column1, column2);
+		}
+	}
+	suppressHumdrumFileOutput();
+	return true;
+}
+
+
+
 
 
 /////////////////////////////////
@@ -137444,6 +147831,8 @@ void Tool_slurcheck::processFile(HumdrumFile& infile) {
 Tool_spinetrace::Tool_spinetrace(void) {
 	define("a|append=b",  "append analysis to input data lines");
 	define("p|prepend=b", "prepend analysis to input data lines");
+
+	setRequiredAnalyses(0);
 }
 
 
@@ -137976,6 +148365,8 @@ void Tool_synco::markNote(HTp token) {
 Tool_tabber::Tool_tabber(void) {
 	// do nothing for now.
 	define("r|remove=b",    "remove any extra tabs");
+
+	setRequiredAnalyses(0);
 }
 
 
@@ -142843,6 +153234,8 @@ Tool_thru::Tool_thru(void) {
 	define("k|keep=b:",              "keep variation interpretations");
 	define("i|info=b:",              "print info list of labels in file");
 	define("r|realization=s:",       "alternate relaization label sequence");
+
+	setRequiredAnalyses(0);
 }
 
 
@@ -143387,8 +153780,7 @@ bool Tool_tie::run(HumdrumFile& infile, ostream& out) {
 bool Tool_tie::run(HumdrumFile& infile) {
 	initialize();
 	processFile(infile);
-	infile.createLinesFromTokens();
-	m_humdrum_text << infile;
+	printEditedFile(infile);
 	return true;
 }
 
@@ -144113,7 +154505,9 @@ bool Tool_transpose::run(HumdrumFile& infile, ostream& out) {
 //
 
 bool Tool_transpose::run(HumdrumFile& infile) {
-	initialize(infile);
+	if (!initialize(infile)) {
+		return !hasError();
+	}
 
 	if (ssettonicQ) {
 		transval = calculateTranspositionFromKey(ssettonic, infile);
@@ -145577,26 +155971,27 @@ void Tool_transpose::addToHistogramDouble(vector<vector<double> >& histogram, in
 
 //////////////////////////////
 //
-// Tool_transpose::initialize --
+// Tool_transpose::initialize -- Returns false if the file should not be
+//     processed (for an error or an option such as --help).
 //
 
-void Tool_transpose::initialize(HumdrumFile& infile) {
+bool Tool_transpose::initialize(HumdrumFile& infile) {
 
 	// handle basic options:
 	if (getBoolean("author")) {
 		m_free_text << "Written by Craig Stuart Sapp, "
 			  << "craig@ccrma.stanford.edu, 12 Apr 2004" << endl;
-		exit(0);
+		return false;
 	} else if (getBoolean("version")) {
 		m_free_text << getArg(0) << ", version: 10 Dec 2016" << endl;
 		m_free_text << "compiled: " << __DATE__ << endl;
-		exit(0);
+		return false;
 	} else if (getBoolean("help")) {
 		usage(getArg(0));
-		exit(0);
+		return false;
 	} else if (getBoolean("example")) {
 		example();
-		exit(0);
+		return false;
 	}
 
 	transval     =  getInteger("base40");
@@ -145613,9 +156008,8 @@ void Tool_transpose::initialize(HumdrumFile& infile) {
 
 	switch (getBoolean("diatonic") + getBoolean("chromatic")) {
 		case 1:
-			cerr << "Error: both -d and -c options must be specified" << endl;
-			exit(1);
-			break;
+			m_error_text << "Error: both -d and -c options must be specified" << endl;
+			return false;
 		case 2:
 			{
 				char buffer[128] = {0};
@@ -145632,6 +156026,7 @@ void Tool_transpose::initialize(HumdrumFile& infile) {
 	}
 
 	transval += 40 * octave;
+	return true;
 }
 
 
@@ -1,7 +1,7 @@
 //
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sat Aug  8 12:24:49 PDT 2015
-// Last Modified: Sat Jul 25 17:02:33 CEST 2026
+// Last Modified: Sat Oct 17 13:07:51 UTC 2026
 // Filename:      min/humlib.h
 // URL:           https://github.com/craigsapp/humlib/blob/master/min/humlib.h
 // Syntax:        C++11
@@ -40,26 +40,46 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _HUMLIB_H_INCLUDED
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cerrno>
 #include <chrono>
+#include <climits>
 #include <cmath>
+#include <condition_variable>
 #include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <list>
 #include <locale>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <numeric>
 #include <random>
 #include <regex>
 #include <set>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -97,6 +117,32 @@ using std::vector;
    #include <sstream>
 #endif
 
+// HUMLIB_MMAP is defined on POSIX systems, where HumdrumFileBase::read()
+// will memory-map regular files rather than reading them line-by-line
+// through an input stream.  Define HUMLIB_NO_MMAP before including
+// this file to disable memory mapping.
+#if !defined(HUMLIB_NO_MMAP) && !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+	#define HUMLIB_MMAP
+#endif
+
+// HUMLIB_SOCKETS is defined on POSIX systems, where HumToolServer can
+// listen for requests on a Unix domain socket.  Define HUMLIB_NO_SOCKETS
+// before including this file to disable sockets.
+#if !defined(HUMLIB_NO_SOCKETS) && !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+	#define HUMLIB_SOCKETS
+#endif
+
+// HUMLIB_SSE2 is defined when compiling for x86 processors with SSE2
+// (all 64-bit x86 processors), and HUMLIB_AVX2 when compiling with
+// AVX2 enabled (such as with -mavx2 or -march=native).  Define
+// HUMLIB_NO_SIMD before including this file to scan one byte at a time.
+#if !defined(HUMLIB_NO_SIMD) && defined(__SSE2__)
+	#define HUMLIB_SSE2
+	#if defined(__AVX2__)
+		#define HUMLIB_AVX2
+	#endif
+#endif
+
 #include "pugiconfig.hpp"
 #include "pugixml.hpp"
 
@@ -126,6 +172,119 @@ class GridVoice;
 class GotScore;
 
 
+class HumAnalysisValue {
+	public:
+		enum Type {
+			Undefined = 0,
+			String,
+			Integer,
+			Fraction,
+			Boolean,
+			Token,
+			Float
+		};
+
+		              HumAnalysisValue (void);
+
+		bool          isDefined        (void) const { return type != Undefined; }
+
+		unsigned char type;
+		union {
+			int        ints[2];  // Integer, Boolean, String index, Fraction
+			HTp        token;
+			double     number;
+		} value;
+};
+
+
+class HumAnalysisStore {
+	public:
+		                 HumAnalysisStore    (void);
+		                ~HumAnalysisStore    ();
+
+		void             clear               (void);
+		int              addRow              (void);
+		int              copyRow             (int row);
+		void             releaseRow          (int row);
+		int              getRowCount         (void) const;
+
+		int              getKeyIndex         (const std::string& ns1,
+		                                      const std::string& ns2,
+		                                      const std::string& key);
+		int              findKeyIndex        (const std::string& ns1,
+		                                      const std::string& ns2,
+		                                      const std::string& key) const;
+		int              getKeyCount         (void) const;
+		const std::string& getNamespace1     (int keyindex) const;
+		const std::string& getNamespace2     (int keyindex) const;
+		const std::string& getKey            (int keyindex) const;
+
+		const HumAnalysisValue* getValue     (int row, int keyindex) const;
+		std::string      getString           (const HumAnalysisValue& value) const;
+
+		void             setValue            (int row, int keyindex,
+		                                      const std::string& value);
+		void             setValue            (int row, int keyindex, int value);
+		void             setValue            (int row, int keyindex,
+		                                      const HumNum& value);
+		void             setValue            (int row, int keyindex, HTp value);
+		void             setValue            (int row, int keyindex, double value);
+		void             setBool             (int row, int keyindex, bool value);
+		void             deleteValue         (int row, int keyindex);
+
+		int              getValueCount       (int row) const;
+		size_t           getMemoryUsage      (void) const;
+
+		static bool      isAnalysisNamespace (const std::string& ns1,
+		                                      const std::string& ns2);
+
+	protected:
+		HumAnalysisValue& getCell            (int row, int keyindex);
+
+	private:
+		// HumAnalysisKey: the namespaces and name of a column.
+		struct HumAnalysisKey {
+			std::string ns1;
+			std::string ns2;
+			std::string key;
+		};
+
+		std::vector<HumAnalysisKey>                 m_keys;
+		std::vector<std::vector<HumAnalysisValue>>  m_columns;
+
+		// m_autoIndex: column index of keys in the "":"auto" namespace.
+		std::unordered_map<std::string, int>        m_autoIndex;
+
+		// m_subIndex: column index of keys in "auto":ns2 namespaces,
+		// stored as "ns2:key".
+		std::unordered_map<std::string, int>        m_subIndex;
+
+		// m_strings: text of values which are not one of the other types.
+		std::vector<std::string>                    m_strings;
+
+		// m_freeRows: rows of deleted tokens which can be reused.
+		std::vector<int>                            m_freeRows;
+		int                                         m_rows;
+};
+
+
+
+class HumParameterName {
+	public:
+		static int                getId        (std::string_view name);
+		static int                findId       (std::string_view name);
+		static const std::string& getName      (int id);
+		static int                getCount     (void);
+
+		// Id of the empty name (no namespace):
+		static const int Empty    = 0;
+
+		// Returned by findId() if the name is not in the table:
+		static const int Unknown  = -1;
+};
+
+
+
 class HumParameter : public std::string {
 	public:
 		HumParameter(void);
@@ -137,11 +296,26 @@ typedef std::map<std::string, std::map<std::string, std::map<std::string, HumPar
 typedef std::map<std::string, std::map<std::string, HumParameter> > MapNKV;
 typedef std::map<std::string, HumParameter> MapKV;
 
+// HumHashEntry: A parameter with its namespaces and key given as
+// HumParameterName ids.
+class HumHashEntry {
+	public:
+		int          ns1;
+		int          ns2;
+		int          key;
+		HumParameter value;
+};
+
+typedef std::vector<HumHashEntry> HumHashEntries;
+
 class HumHash {
 	public:
 		               HumHash             (void);
+		               HumHash             (const HumHash& hash);
 		              ~HumHash             ();
 
+		HumHash&       operator=           (const HumHash& hash);
+
 		std::string    getValue            (const std::string& key) const;
 		std::string    getValue            (const std::string& ns2,
 		                                    const std::string& key) const;
@@ -238,6 +412,7 @@ class HumHash {
 		int            getParameterCount   (const std::string& ns) const;
 		int            getParameterCount   (const std::string& ns1,
 		                                    const std::string& ns2) const;
+		void           clearParameters     (void);
 		void           setPrefix           (const std::string& value);
 		std::string    getPrefix           (void) const;
 		std::ostream&  printXml            (std::ostream& out = std::cout, int level = 0,
@@ -268,15 +443,55 @@ class HumHash {
 		                                    const std::string& parameter) const;
 
 	protected:
+		// Types of objects which contain a HumHash (see m_analysisOwner):
+		enum AnalysisOwnerType {
+			NoAnalysisOwner,
+			TokenAnalysisOwner,
+			LineAnalysisOwner,
+			FileAnalysisOwner
+		};
+
 		void                     initializeParameters  (void);
+		void                     setAnalysisOwner      (int type);
+		HumAnalysisStore*        findAnalysisStore     (bool create) const;
+		void                     detachAnalysisValues  (void);
 		std::vector<std::string> getKeyList            (const std::string& keys) const;
-
-	private:
-		MapNNKV*    parameters;
+		const HumAnalysisValue*  getAnalysisValue      (const std::string& ns1,
+		                                                const std::string& ns2,
+		                                                const std::string& key) const;
+		HumAnalysisStore*        prepareAnalysisValue  (const std::string& ns1,
+		                                                const std::string& ns2,
+		                                                const std::string& key,
+		                                                int& keyindex);
+		void                     deleteAnalysisValues  (void);
+		const HumHashEntries*    getParameterView      (HumHashEntries& storage) const;
+		int                      findParameter         (const std::string& ns1,
+		                                                const std::string& ns2,
+		                                                const std::string& key) const;
+		HumParameter&            insertParameter       (const std::string& ns1,
+		                                                const std::string& ns2,
+		                                                const std::string& key);
+
+	private:
+		// parameters: Entries sorted by the names of the namespaces
+		// and key (the same order as a map of the names), or NULL if no
+		// parameters have been set.
+		HumHashEntries* parameters;
 		std::string prefix;
 
+		// m_analysisRow: The row for the values of this object in the
+		// "auto" namespace in the analysis store of the file (see
+		// findAnalysisStore()), or -1 if none have been stored.
+		int         m_analysisRow;
+
+		// m_analysisOwner: The type of the object which contains this
+		// HumHash (an AnalysisOwnerType), used to find the file with the
+		// analysis store without storing a pointer to it.
+		int         m_analysisOwner;
+
 	friend std::ostream& operator<<(std::ostream& out, const HumHash& hash);
 	friend std::ostream& operator<<(std::ostream& out, HumHash* hash);
+	friend class HumSnapshot;
 };
 
 
@@ -360,14 +575,23 @@ class HumNum {
 		std::ostream& printList          (std::ostream& out) const;
 		std::ostream& printTwoPart  (std::ostream& out, const std::string& spacer = "+") const;
 
+		static bool hasOverflow     (void);
+		static void clearOverflow   (void);
+
 	protected:
 		void     reduce             (void);
+		void     setReduced         (int64_t numerator, int64_t denominator);
 		int      gcdIterative       (int a, int b);
 		int      gcdRecursive       (int a, int b);
+		static int64_t gcd64        (int64_t a, int64_t b);
 
 	private:
 		int top;
 		int bot;
+
+		// m_overflow: Set to true in a thread when a result in that thread
+		// did not fit into 32-bit integers.
+		static thread_local bool m_overflow;
 };
 
 
@@ -378,6 +602,98 @@ std::ostream& operator<<(std::ostream& out, const std::vector<A>& v);
 
 
 
+class HumPool {
+	public:
+		static void*  allocate         (size_t size);
+		static void   deallocate       (void* ptr, size_t size);
+		static size_t trim             (void);
+
+		// statistics:
+		static size_t getSlabCount     (void);
+		static size_t getReservedBytes (void);
+
+		// Requests larger than this are passed on to the system allocator:
+		static const size_t MaxBlockSize = 512;
+
+		// Blocks sizes are rounded up to a multiple of this value:
+		static const size_t Granularity = 16;
+
+		// Size of slabs requested from the system allocator:
+		static const size_t SlabSize = 64 * 1024;
+};
+
+
+// HumPoolAllocator: STL allocator which takes its memory from HumPool.
+
+template <class TYPE>
+class HumPoolAllocator {
+	public:
+		typedef TYPE value_type;
+
+		HumPoolAllocator(void) noexcept {}
+		template <class OTHER>
+		HumPoolAllocator(const HumPoolAllocator<OTHER>& other) noexcept {}
+
+		TYPE* allocate(size_t count) {
+			return static_cast<TYPE*>(HumPool::allocate(count * sizeof(TYPE)));
+		}
+
+		void deallocate(TYPE* ptr, size_t count) noexcept {
+			HumPool::deallocate(ptr, count * sizeof(TYPE));
+		}
+};
+
+template <class TYPE1, class TYPE2>
+bool operator==(const HumPoolAllocator<TYPE1>& a, const HumPoolAllocator<TYPE2>& b) {
+	return true;
+}
+
+template <class TYPE1, class TYPE2>
+bool operator!=(const HumPoolAllocator<TYPE1>& a, const HumPoolAllocator<TYPE2>& b) {
+	return false;
+}
+
+
+
+class HumThreadPool {
+	public:
+		            HumThreadPool          (int threads = 0);
+		           ~HumThreadPool          ();
+
+		void        submit                 (std::function<void(void)> task);
+		void        wait                   (void);
+		int         getThreadCount         (void) const;
+		int         getWorkerIndex         (void) const;
+
+		static int  getHardwareThreadCount (void);
+
+	protected:
+		void        runWorker              (int index);
+		bool        takeTask               (int index, std::function<void(void)>& task);
+		void        runTask                (std::function<void(void)>& task);
+
+	private:
+		// HumThreadPoolQueue: task queue owned by one worker thread.
+		struct HumThreadPoolQueue {
+			std::mutex                              mutex;
+			std::deque<std::function<void(void)>>   tasks;
+		};
+
+		std::vector<std::thread>                         m_threads;
+		std::vector<std::unique_ptr<HumThreadPoolQueue>> m_queues;
+
+		std::mutex                m_mutex;   // protects m_stop and m_exception
+		std::condition_variable   m_wakeup;  // signals new tasks or shutdown
+		std::condition_variable   m_idle;    // signals that m_pending is zero
+		std::atomic<int>          m_queued;  // tasks waiting in queues
+		std::atomic<int>          m_pending; // tasks queued or running
+		std::atomic<unsigned>     m_next;    // queue for next outside submit
+		bool                      m_stop;
+		std::exception_ptr        m_exception;
+};
+
+
+
 #define INVALID_INTERVAL_CLASS -123456789
 
 // Diatonic pitch class integers:
@@ -595,6 +911,37 @@ class HumTransposer {
 
 
 
+class HumRegexPattern {
+	public:
+		HumRegexPattern(const std::string& exp,
+		                std::regex_constants::syntax_option_type flags);
+
+		// m_exp, m_flags: the expression and syntax options used to
+		// construct m_regex (the key for the pattern cache).
+		std::string m_exp;
+		std::regex_constants::syntax_option_type m_flags;
+		std::regex m_regex;
+
+		// m_literal: text which must occur at the start of any match
+		// (empty if unknown).  If m_anchorStart is true, the text must
+		// occur at the start of the searched string.
+		std::string m_literal;
+		bool m_anchorStart = false;
+
+		// m_literalOnly: true if the expression only matches m_literal
+		// (optionally inside of one capture group, and optionally
+		// anchored to the start and/or end of the searched string), so
+		// that std::regex does not need to be used at all.
+		bool m_literalOnly = false;
+		bool m_anchorEnd   = false;
+		bool m_group       = false;
+
+	protected:
+		void analyzeLiteral(void);
+};
+
+
+
 class HumRegex {
 	public:
 		            HumRegex           (void);
@@ -685,22 +1032,39 @@ class HumRegex {
 		                                const std::string& buffer,
 		                                const std::string& separator);
 
+		// compiled expression cache (shared by all HumRegex objects):
+		static void setCacheSize       (int size);
+		static int  getCacheSize       (void);
+		static void clearCache         (void);
+		static void setLiteralMatching (bool state);
+		static bool getLiteralMatching (void);
+
 	protected:
 		std::regex_constants::syntax_option_type
 				getTemporaryRegexFlags(const std::string& sflags);
 		std::regex_constants::match_flag_type
 				getTemporarySearchFlags(const std::string& sflags);
 
+		const std::regex& compile      (const std::string& exp,
+		                                std::regex_constants::syntax_option_type flags);
+		int         searchLiteral      (const std::string& input, int startindex);
+		bool        replaceLiteral     (std::string& output, const std::string& input,
+		                                const std::string& replacement,
+		                                std::regex_constants::match_flag_type flags);
+
+		static std::shared_ptr<const HumRegexPattern> getPattern(
+				const std::string& exp,
+				std::regex_constants::syntax_option_type flags);
+
 
 	private:
 
-		// m_regex: stores the regular expression to use as a default.
+		// m_pattern: stores the regular expression which was last used,
+		// which is shared with the pattern cache.
 		//
 		// http://en.cppreference.com/w/cpp/regex/basic_regex
-		// .assign(string) == set the regular expression.
-		// operator=       == set the regular expression.
 		// .flags()        == return syntax_option_type used to construct.
-		std::regex m_regex;
+		std::shared_ptr<const HumRegexPattern> m_pattern;
 
 		// m_matches: stores the matches from a search:
 		//
@@ -717,6 +1081,17 @@ class HumRegex {
 		// .end()       == end of submatch list.
 		std::smatch m_matches;
 
+		// m_literal*: stores the result of the last search if it was done
+		// without std::regex (when m_literalSearch is true).  Match
+		// positions are relative to m_literalBase in m_literalInput,
+		// like the positions in m_matches.
+		bool               m_literalSearch = false;
+		const std::string* m_literalInput  = NULL;
+		int                m_literalBase   = 0;
+		int                m_literalStart  = 0;
+		int                m_literalLength = 0;
+		int                m_literalCount  = 0;
+
 		// m_regexflags: store default settings for regex processing
 		// http://en.cppreference.com/w/cpp/regex/syntax_option_type
 		// http://en.cppreference.com/w/cpp/regex/basic_regex
@@ -815,6 +1190,32 @@ class HumSignifiers {
 
 
 
+class HumDataType {
+	public:
+		static int                getId        (const std::string& datatype);
+		static const std::string& getName      (int id);
+		static int                getCount     (void);
+		static bool               isKernLike   (int id);
+		static bool               isMensLike   (int id);
+		static bool               isStaffLike  (int id);
+
+		// Ids of data types which are entered into the table first:
+		static const int None     = 0;   // ""
+		static const int Kern     = 1;   // "**kern"
+		static const int Mens     = 2;   // "**mens"
+		static const int Recip    = 3;   // "**recip"
+		static const int Text     = 4;   // "**text"
+		static const int Silbe    = 5;   // "**silbe"
+		static const int Dynam    = 6;   // "**dynam"
+		static const int Harm     = 7;   // "**harm"
+		static const int Fing     = 8;   // "**fing"
+
+		// Returned by getId() if the table is full:
+		static const int Unknown  = -1;
+};
+
+
+
 class HumdrumLine;
 typedef HumdrumLine* HLp;
 
@@ -832,6 +1233,7 @@ class HumAddress {
 		int                 getLineNumber     (void) const;
 		int                 getFieldIndex     (void) const;
 		const HumdrumToken& getDataType       (void) const;
+		int                 getDataTypeId     (void) const;
 		HTp                 getExclusiveInterpretation(void);
 		const std::string&  getSpineInfo      (void) const;
 		int                 getTrack          (void) const;
@@ -850,6 +1252,7 @@ class HumAddress {
 		void                setTrack          (int aTrack);
 		void                setSubtrack       (int aSubtrack);
 		void                setSubtrackCount  (int aSubtrack);
+		void                setDataTypeId     (int id);
 
 	private:
 
@@ -887,12 +1290,18 @@ class HumAddress {
 		// no tokens in the track (such as for global comments).
 		int m_subtrackcount;
 
+		// datatype: The HumDataType id of the exclusive interpretation for
+		// the track.  This is set when the tracks of the file are analyzed,
+		// and is HumDataType::Unknown (-1) before then.
+		int m_datatype;
+
 		// owner: This is the line which manages the given token.
 		HLp          m_owner;
 
 	friend class HumdrumToken;
 	friend class HumdrumLine;
 	friend class HumdrumFile;
+	friend class HumSnapshot;
 };
 
 
@@ -939,6 +1348,238 @@ std::ostream& operator<<(std::ostream& out, HumParamSet& hps);
 
 
 
+class HumKernNote {
+	public:
+		// Flags which describe the contents of a note (or of the
+		// whole token in HumKernRecord):
+		static const unsigned Rest          = 0x0001;  // 'r'
+		static const unsigned Unpitched     = 0x0002;  // 'R'
+		static const unsigned Grace         = 0x0004;  // 'q'
+		static const unsigned Invisible     = 0x0008;  // "yy"
+		static const unsigned TieStart      = 0x0010;  // '['
+		static const unsigned TieContinue   = 0x0020;  // '_'
+		static const unsigned TieEnd        = 0x0040;  // ']'
+		static const unsigned PitchLetter   = 0x0080;  // a-g or A-G
+		static const unsigned PartialBeam   = 0x0100;  // 'k' or 'K'
+
+		bool     isRest          (void) const { return flags & Rest; }
+		bool     isGrace         (void) const { return flags & Grace; }
+		bool     isInvisible     (void) const { return flags & Invisible; }
+		bool     isUnpitched     (void) const { return flags & Unpitched; }
+		bool     isTieStart      (void) const { return flags & TieStart; }
+		bool     isTieContinue   (void) const { return flags & TieContinue; }
+		bool     isTieEnd        (void) const { return flags & TieEnd; }
+		bool     isSecondaryTie  (void) const
+		                            { return flags & (TieContinue | TieEnd); }
+		int      getBase40Pitch  (void) const;
+		int      getMidiPitch    (void) const;
+
+		int           base40       = 0;  // 0 for rests
+		int           midi         = 0;  // 0 for rests
+		HumNum        duration;          // 0 for grace notes
+		unsigned      flags        = 0;
+		unsigned char dots         = 0;
+		unsigned char slurStarts   = 0;
+		unsigned char slurEnds     = 0;
+		unsigned char phraseStarts = 0;
+		unsigned char phraseEnds   = 0;
+		unsigned char beamStarts   = 0;
+		unsigned char beamEnds     = 0;
+};
+
+
+class HumKernRecord {
+	public:
+		                   HumKernRecord       (const std::string& text);
+
+		int                getNoteCount        (void) const
+		                                          { return (int)m_notes.size(); }
+		const HumKernNote& getNote             (int index) const
+		                                          { return m_notes.at(index); }
+
+		// Information about the token as a whole:
+		bool               isChord             (void) const { return m_chord; }
+		bool               hasFlag             (unsigned flag) const
+		                                          { return m_flags & flag; }
+		bool               isNote              (void) const;
+		bool               isSecondaryTiedNote (void) const;
+		int                getSlurStartCount   (void) const { return m_slurStarts; }
+		int                getSlurEndCount     (void) const { return m_slurEnds; }
+		int                getPhraseStartCount (void) const { return m_phraseStarts; }
+		int                getPhraseEndCount   (void) const { return m_phraseEnds; }
+		int                getBeamStartCount   (void) const { return m_beamStarts; }
+		int                getBeamEndCount     (void) const { return m_beamEnds; }
+		bool               hasBeam             (void) const;
+
+		void               getBase40Pitches    (std::vector<int>& output) const;
+		void               getMidiPitches      (std::vector<int>& output) const;
+
+		bool               isRecordOf          (const std::string& text) const;
+
+	protected:
+		static void        parseNote           (HumKernNote& note,
+		                                        const std::string& text);
+		static uint64_t    getTextHash         (const std::string& text);
+
+	private:
+		// m_notes: The subtokens of the token (one for a single note
+		// or rest, more for a chord).
+		std::vector<HumKernNote> m_notes;
+
+		// m_flags: HumKernNote flags for all characters in the token.
+		unsigned m_flags = 0;
+
+		// m_size, m_hash: Length and hash of the text of the token, used
+		// by isRecordOf() to check that the text has not changed.
+		size_t   m_size = 0;
+		uint64_t m_hash = 0;
+
+		bool m_chord        = false;
+		int  m_slurStarts   = 0;
+		int  m_slurEnds     = 0;
+		int  m_phraseStarts = 0;
+		int  m_phraseEnds   = 0;
+		int  m_beamStarts   = 0;
+		int  m_beamEnds     = 0;
+};
+
+
+
+class HumFileAnalysis {
+	public:
+		HumFileAnalysis(void) {}
+		~HumFileAnalysis() { clear(); }
+		void clear(void) {
+			m_analyzed           = 0;
+			m_barlines_different = false;
+		}
+
+		bool isAnalyzed  (int type) const { return m_analyzed & getMask(type); }
+		void setAnalyzed (int type, bool state = true) {
+			if (state) {
+				m_analyzed |= getMask(type);
+			} else {
+				m_analyzed &= ~getMask(type);
+			}
+		}
+
+		static unsigned    getMask         (int type) { return 1u << type; }
+		static unsigned    getDependencies (int type);
+		static const char* getName         (int type);
+
+		// Analysis ids, listed in an order in which each one comes after
+		// the analyses that it depends on:
+		static const int Strands     = 0;   // spine strands
+		static const int Nulls       = 1;   // null token resolution
+		static const int Strophes    = 2;   // *S/ and *strophe markers
+		static const int Structure   = 3;   // parameters, token durations, signifiers
+		static const int Rhythm      = 4;   // line durations and timings
+		static const int Barlines    = 5;   // barline style comparisons
+		static const int Slurs       = 6;
+		static const int Phrases     = 7;
+		static const int Beams       = 8;
+		static const int Ties        = 9;
+		static const int Accidentals = 10;
+		static const int Count       = 11;
+
+		// ReadDefault: Analyses done by HumdrumFileStructure::read() unless
+		// the file has been given a different list with setReadAnalyses().
+		static const unsigned ReadDefault = (1u << Strands) | (1u << Nulls) |
+				(1u << Strophes) | (1u << Structure) | (1u << Rhythm);
+
+		// m_analyzed: bit mask of the analyses which have been done.
+		unsigned m_analyzed = 0;
+
+		// m_barlines_different: Set to true when the file contains
+		// any barlines that are not all of the same at the same
+		// times.
+		bool m_barlines_different = false;
+};
+
+
+
+class HumdrumFileBase;
+class HumdrumToken;
+class HumdrumLine;
+class HumHash;
+class HumNum;
+
+class HumSnapshot {
+	public:
+		                   HumSnapshot       (void);
+		                  ~HumSnapshot       ();
+
+		bool               write             (HumdrumFileBase& infile,
+		                                      const std::string& filename,
+		                                      std::uint64_t key = 0);
+		bool               read              (HumdrumFileBase& infile,
+		                                      const std::string& filename,
+		                                      std::uint64_t key = 0);
+		bool               writeString       (HumdrumFileBase& infile,
+		                                      std::string& data);
+		bool               readString        (HumdrumFileBase& infile,
+		                                      const std::string& data);
+
+		static bool        writeCache        (HumdrumFileBase& infile,
+		                                      std::uint64_t key);
+		static bool        readCache         (HumdrumFileBase& infile,
+		                                      std::uint64_t key);
+		static void        setCacheDirectory (const std::string& directory);
+		static std::string getCacheDirectory (void);
+		static bool        isCacheEnabled    (void);
+		static std::string getCacheFilename  (std::uint64_t key, unsigned analyses);
+		static std::uint64_t getContentKey   (const char* contents, size_t size);
+		static std::uint64_t getContentKey   (const std::vector<std::pair<const char*,
+		                                      size_t>>& lines);
+
+	protected:
+		void               clear             (void);
+		bool               encode            (HumdrumFileBase& infile, std::uint64_t key);
+		bool               decode            (HumdrumFileBase& infile, std::uint64_t key,
+		                                      const char* data, size_t size);
+		bool               applyRecords      (HumdrumFileBase& infile);
+		bool               checkTokens       (HumdrumLine& line);
+		void               resetLines        (HumdrumFileBase& infile);
+
+		void               putInt            (std::int32_t value);
+		void               putString         (const std::string& value);
+		bool               putToken          (HumdrumToken* token);
+		bool               putHash           (HumHash& hash);
+		bool               putAnalysisValues (HumHash& hash);
+		void               putNum            (const HumNum& value);
+
+		bool               getInt            (std::int32_t& value);
+		bool               getString         (std::string& value);
+		bool               getToken          (HumdrumToken*& token);
+		bool               getHash           (HumHash& hash);
+		bool               getAnalysisValues (HumHash& hash);
+		bool               getNum            (HumNum& value);
+
+		static std::string& cacheDirectory   (void);
+
+	private:
+		// m_data: encoded snapshot (when writing).
+		std::string m_data;
+
+		// m_strings: string table (when writing).
+		std::vector<std::string> m_strings;
+		std::unordered_map<std::string, std::int32_t> m_stringIndex;
+
+		// m_tokenIndex: file-order index of each token (when writing).
+		std::unordered_map<HumdrumToken*, std::int32_t> m_tokenIndex;
+
+		// m_readpos, m_readend: position in the encoded records and the
+		// string table entries (when reading).
+		const char* m_readpos = NULL;
+		const char* m_readend = NULL;
+		std::vector<std::pair<const char*, std::int32_t>> m_table;
+
+		// m_tokens: list of tokens in file order (when reading).
+		std::vector<HumdrumToken*> m_tokens;
+};
+
+
+
 class _HumInstrument {
 	public:
 		_HumInstrument    (void) { humdrum = ""; name = ""; gm = 0; }
@@ -967,7 +1608,7 @@ class HumInstrument {
 	private:
 		int                            m_index;
 		static std::vector<_HumInstrument>  m_data;
-		static int                     m_classcount;
+		static std::once_flag          m_initialized;
 
 	protected:
 		void       initialize          (void);
@@ -1227,6 +1868,11 @@ class HumdrumLine : public std::string, public HumHash {
 		            HumdrumLine            (HumdrumLine& line, void* owner);
 		           ~HumdrumLine            ();
 
+		static void* operator new          (size_t size)
+		                                  { return HumPool::allocate(size); }
+		static void  operator delete       (void* ptr, size_t size)
+		                                  { HumPool::deallocate(ptr, size); }
+
 		HumdrumLine& operator=             (HumdrumLine& line);
 		bool        isComment              (void) const;
 		bool        isCommentLocal         (void) const;
@@ -1463,6 +2109,7 @@ class HumdrumLine : public std::string, public HumHash {
 	friend class HumdrumFileStructure;
 	friend class HumdrumFileContent;
 	friend class HumdrumFile;
+	friend class HumSnapshot;
 };
 
 std::ostream& operator<< (std::ostream& out, HumdrumLine& line);
@@ -1470,9 +2117,76 @@ std::ostream& operator<< (std::ostream& out, HLp line);
 
 
 
+class HumFieldScanner {
+	public:
+		static const char*  find              (const char* start, const char* end,
+		                                       char c1);
+		static const char*  find              (const char* start, const char* end,
+		                                       char c1, char c2);
+		static const char*  find              (const char* start, const char* end,
+		                                       char c1, char c2, char c3);
+		static const char*  csvToTsv          (const char* start, const char* end,
+		                                       const std::string& separator,
+		                                       std::string& output);
+		static const char*  getInstructionSet (void);
+};
+
+
+
+class HumSubtokens {
+	public:
+		class iterator {
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef std::string_view          value_type;
+				typedef std::ptrdiff_t            difference_type;
+				typedef const std::string_view*   pointer;
+				typedef const std::string_view&   reference;
+
+				                  iterator    (void);
+				                  iterator    (std::string_view text,
+				                               std::string_view separator);
+				std::string_view  operator*   (void) const { return m_current; }
+				iterator&         operator++  (void);
+				iterator          operator++  (int);
+				bool              operator==  (const iterator& other) const;
+				bool              operator!=  (const iterator& other) const
+				                                 { return !(*this == other); }
+
+			private:
+				void              findEnd     (void);
+
+				std::string_view m_text;
+				std::string_view m_separator;
+				std::string_view m_current;
+				// Offset of the current sub-token in m_text, or npos at end:
+				std::string_view::size_type m_start;
+		};
+
+		                  HumSubtokens  (std::string_view text,
+		                                 std::string_view separator = " ");
+
+		iterator          begin         (void) const;
+		iterator          end           (void) const;
+		int               getCount      (void) const;
+		std::string_view  getSubtoken   (int index) const;
+		std::string_view  front         (void) const;
+
+	private:
+		std::string_view m_text;
+		std::string_view m_separator;
+};
+
+
+
 
 typedef HumdrumToken* HTp;
 
+// HumTokenLinks: list type for the spine links between tokens.  These
+// lists are usually only one or two entries long, so their storage is
+// taken from HumPool rather than the system allocator.
+typedef std::vector<HTp, HumPoolAllocator<HTp>> HumTokenLinks;
+
 class HumdrumToken : public std::string, public HumHash {
 	public:
 		         HumdrumToken              (void);
@@ -1482,8 +2196,14 @@ class HumdrumToken : public std::string, public HumHash {
 		         HumdrumToken              (HumdrumToken* token, HLp owner);
 		         HumdrumToken              (const char* token);
 		         HumdrumToken              (const std::string& token);
+		         HumdrumToken              (const char* token, size_t length);
 		        ~HumdrumToken              ();
 
+		static void* operator new          (size_t size)
+		                                  { return HumPool::allocate(size); }
+		static void  operator delete       (void* ptr, size_t size)
+		                                  { HumPool::deallocate(ptr, size); }
+
 		bool     isNull                    (void) const;
 		bool     isNullToken               (void) const { return isNull(); }
 		bool     isManipulator             (void) const;
@@ -1592,6 +2312,8 @@ class HumdrumToken : public std::string, public HumHash {
 		bool     hasObliquaLigatureEnd     (void);
 		char     hasStemDirection          (void);
 		bool     allSameBarlineStyle       (void);
+		const HumKernRecord& getKernRecord (void) const;
+		void     clearKernRecord           (void);
 
 
 		// pitch-related functions (in HumdrumToken-midi.cpp):
@@ -1676,13 +2398,15 @@ class HumdrumToken : public std::string, public HumHash {
 		int      getTokenNumber            (void) const;
 		const std::string& getDataType     (void) const;
 		const std::string& getExInterp     (void) { return getDataType(); }
+		int      getDataTypeId             (void) const;
 		bool     isDataType                (const std::string& dtype) const;
+		bool     isDataType                (int id) const;
 		bool     isDataTypeLike            (const std::string& dtype) const;
 		bool     isKern                    (void) const;
 		bool     isKernLike                (void) const;
 		bool     isMens                    (void) const;
 		bool     isMensLike                (void) const;
-		bool     isStaffLike               (void) const { return isKernLike() || isMensLike(); }
+		bool     isStaffLike               (void) const { return HumDataType::isStaffLike(getDataTypeId()); }
 		std::string   getSpineInfo         (void) const;
 		int      getTrack                  (void) const;
 		int      getSpineIndex             (void) const;
@@ -1693,6 +2417,7 @@ class HumdrumToken : public std::string, public HumHash {
 		std::string   getSubtoken          (int index,
 		                                    const std::string& separator = " ") const;
 		std::vector<std::string> getSubtokens (const std::string& separator = " ") const;
+		HumSubtokens getSubtokenViews      (std::string_view separator = " ") const;
 		void     replaceSubtoken           (int index, const std::string& newsubtok,
 		                                    const std::string& separator = " ");
 		void     setParameters             (HTp ptok);
@@ -1807,6 +2532,8 @@ class HumdrumToken : public std::string, public HumHash {
 		void     makeForwardLink           (HumdrumToken& nextToken);
 		void     makeBackwardLink          (HumdrumToken& previousToken);
 		void     setOwner                  (HLp aLine);
+		void     requireFileAnalysis       (int type);
+		void     setDataTypeId             (int id);
 		int      getState                  (void) const;
 		void     incrementState            (void);
 		void     setDuration               (const HumNum& dur);
@@ -1841,22 +2568,22 @@ class HumdrumToken : public std::string, public HumHash {
 		// following token, but there can be two tokens if the current
 		// token is *^, and there will be zero following tokens after a
 		// spine terminating token (*-).
-		std::vector<HTp> m_nextTokens;     // link to next token(s) in spine
+		HumTokenLinks m_nextTokens;     // link to next token(s) in spine
 
 		// previousTokens: Simiar to nextTokens, but for the immediately
 		// follow token(s) in the data.  Typically there will be one
 		// preceding token, but there can be multiple tokens when the previous
 		// line has *v merge tokens for the spine.  Exclusive interpretations
 		// have no tokens preceding them.
-		std::vector<HTp> m_previousTokens; // link to last token(s) in spine
+		HumTokenLinks m_previousTokens; // link to last token(s) in spine
 
 		// nextNonNullTokens: This is a list of non-tokens in the spine
 		// that follow this one.
-		std::vector<HTp> m_nextNonNullTokens;
+		HumTokenLinks m_nextNonNullTokens;
 
 		// previousNonNullTokens: This is a list of non-tokens in the spine
 		// that preced this one.
-		std::vector<HTp> m_previousNonNullTokens;
+		HumTokenLinks m_previousNonNullTokens;
 
 		// rhycheck: Used to perfrom HumdrumFileStructure::analyzeRhythm
 		// recursively.
@@ -1887,11 +2614,18 @@ class HumdrumToken : public std::string, public HumHash {
 		// NULL means that it is not in a strophe.
 		HTp m_strophe = NULL;
 
+		// m_kernRecord: Decoded **kern note information, created the
+		// first time it is needed by getKernRecord(), and replaced there
+		// if the text of the token has changed.  The pointer is atomic so
+		// that several threads can read the same token at once.
+		mutable std::atomic<HumKernRecord*> m_kernRecord{NULL};
+
 	friend class HumdrumLine;
 	friend class HumdrumFileBase;
 	friend class HumdrumFileStructure;
 	friend class HumdrumFileContent;
 	friend class HumdrumFile;
+	friend class HumSnapshot;
 };
 
 
@@ -1951,67 +2685,6 @@ class TokenPair {
 };
 
 
-// HumFileAnalysis: class used to manage analysis states for a Humdrum file.
-
-class HumFileAnalysis {
-	public:
-		HumFileAnalysis(void) {}
-		~HumFileAnalysis() { clear(); }
-		void clear(void) {
-			m_structure_analyzed = false;
-			m_rhythm_analyzed    = false;
-			m_strands_analyzed   = false;
-			m_slurs_analyzed     = false;
-			m_beams_analyzed     = false;
-			m_phrases_analyzed   = false;
-			m_nulls_analyzed     = false;
-			m_strophes_analyzed  = false;
-
-			m_barlines_analyzed  = false;
-			m_barlines_different = false;
-		}
-
-		// m_structure_analyzed: Used to keep track of whether or not
-		// file structure has been analyzed.
-		bool m_structure_analyzed = false;
-
-		// m_rhythm_analyzed: Used to keep track of whether or not
-		// rhythm structure has been analyzed.
-		bool m_rhythm_analyzed = false;
-
-		// m_strands_analyzed: Used to keep track of whether or not
-		// file strands have been analyzed.
-		bool m_strands_analyzed = false;
-
-		// m_strophes_analyzed: Used to keep track of whether or not
-		// file strands have been analyzed.
-		bool m_strophes_analyzed = false;
-
-		// m_slurs_analyzed: Used to keep track of whether or not
-		// slur endpoints have been linked or not.
-		bool m_slurs_analyzed = false;
-
-		// m_phrases_analyzed: Used to keep track of whether or not
-		// phrase endpoints have been linked or not.
-		bool m_phrases_analyzed = false;
-
-		// m_beams_analyzed: Used to keep track of whether or not
-		// beam endpoints have been linked or not.
-		bool m_beams_analyzed = false;
-
-		// m_nulls_analyzed: Used to keep track of wheter or not
-		// null tokens have been analyzed yet.
-		bool m_nulls_analyzed = false;
-
-		// m_barlines_analyzed: Used to keep track of wheter or not
-		// barlines have beena analyzed yet.
-		bool m_barlines_analyzed = false;
-		// m_barlines_different: Set to true when the file contains
-		// any barlines that are not all of the same at the same
-		// times.
-		bool m_barlines_different = false;
-};
-
 bool sortTokenPairsByLineIndex(const TokenPair& a, const TokenPair& b);
 
 
@@ -2021,7 +2694,7 @@ class HumdrumFileBase : public HumHash {
 		              HumdrumFileBase          (HumdrumFileBase& infile);
 		              HumdrumFileBase          (const std::string& contents);
 		              HumdrumFileBase          (std::istream& contents);
-		             ~HumdrumFileBase          ();
+		virtual      ~HumdrumFileBase          ();
 
 		HumdrumFileBase& operator=             (HumdrumFileBase& infile);
 		bool          read                     (std::istream& contents);
@@ -2036,6 +2709,13 @@ class HumdrumFileBase : public HumHash {
 
 		bool          readString               (const char* contents);
 		bool          readString               (const std::string& contents);
+		bool          readBuffer               (const char* contents,
+		                                        size_t size);
+		bool          readLines                (const std::vector<std::pair<const char*,
+		                                        size_t>>& lines);
+		bool          readSnapshot             (const std::string& contents,
+		                                        const std::string& snapshot);
+		bool          writeSnapshot            (std::string& snapshot);
 		bool          readStringCsv            (const char* contents,
 		                                        const std::string& separator=",");
 		bool          readStringCsv            (const std::string& contents,
@@ -2050,6 +2730,15 @@ class HumdrumFileBase : public HumHash {
 		bool          isRhythmAnalyzed         (void);
 		bool          areStrandsAnalyzed       (void);
 		bool          areStrophesAnalyzed      (void);
+		bool          isAnalyzed               (int type) const;
+		bool          requireAnalysis          (int type);
+		bool          requireAnalyses          (unsigned mask);
+		void          setReadAnalyses          (unsigned mask);
+		unsigned      getReadAnalyses          (void) const;
+		bool          reanalyzeTokens          (void);
+		bool          hasEditedTokens          (void) const;
+		void          setEditedTokens          (bool state = true);
+		HumAnalysisStore* getAnalysisStore     (bool create = true);
 		void          setFilenameFromSegment   (void);
 
     	template <class TYPE>
@@ -2212,6 +2901,7 @@ class HumdrumFileBase : public HumHash {
 		bool          analyzeSpines             (void);
 		bool          analyzeLinks              (void);
 		bool          analyzeTracks             (void);
+		void          analyzeDataTypes          (void);
 		bool          analyzeLines              (void);
 
 	protected:
@@ -2237,7 +2927,7 @@ class HumdrumFileBase : public HumHash {
 		bool          stitchLinesTogether       (HumdrumLine& previous,
 		                                         HumdrumLine& next);
 		void          addToTrackStarts          (HTp token);
-		void          addUniqueTokens           (std::vector<HTp>& target,
+		void          addUniqueTokens           (HumTokenLinks& target,
 		                                         std::vector<HTp>& source);
 		bool          processNonNullDataTokensForTrackForward(HTp starttoken,
 		                                         std::vector<HTp> ptokens);
@@ -2246,6 +2936,14 @@ class HumdrumFileBase : public HumHash {
 		bool          setParseError             (std::stringstream& err);
 		bool          setParseError             (const std::string& err);
 		bool          setParseError             (const char* format, ...);
+		bool          readMappedFile            (const char* filename);
+		void          splitBuffer               (const char* contents, size_t size);
+		void          splitCsvBuffer            (const char* contents, size_t size,
+		                                         const std::string& separator);
+		bool          analyzeBaseFromCache      (std::uint64_t key);
+		bool          analyzeForRead            (void);
+		virtual bool  runAnalysis               (int type);
+		void          clearAnalysisInfo         (void);
 //		void          fixMerges                 (int linei);
 
 	protected:
@@ -2314,6 +3012,25 @@ class HumdrumFileBase : public HumHash {
 		// m_analysis: Used to keep track of analysis states for the file.
 		HumFileAnalysis m_analyses;
 
+		// m_analysisValues: Typed storage for the "auto" parameters of
+		// the tokens and lines in the file (see getAnalysisStore()).
+		std::unique_ptr<HumAnalysisStore> m_analysisValues;
+
+		// m_readAnalyses: Analyses which are done when reading the file
+		// (others are done later by requireAnalysis() when needed).
+		unsigned m_readAnalyses = HumFileAnalysis::ReadDefault;
+
+		// m_snapshotKey: content key of the file when it was read
+		// while a snapshot cache directory is set, and the file was not
+		// found in the cache.  A snapshot of the file is saved after the
+		// read analyses are done (see HumSnapshot).
+		std::uint64_t m_snapshotKey = 0;
+		bool m_snapshotPending = false;
+
+		// m_editedTokens: true if the text of a token was changed with
+		// HumdrumToken::setText() since the file was read or reanalyzed.
+		bool m_editedTokens = false;
+
 	public:
 		// Dummy functions to allow the HumdrumFile class's inheritance
 		// to be shifted between HumdrumFileContent (the top-level default),
@@ -2340,6 +3057,8 @@ class HumdrumFileBase : public HumHash {
 		// HumdrumFileContent public functions:
 		// to be added later
 
+	friend class HumSnapshot;
+	friend class HumdrumFileStream;
 };
 
 std::ostream& operator<<(std::ostream& out, HumdrumFileBase& infile);
@@ -2474,8 +3193,19 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		std::string   getKernBelowSignifier        (void);
 		std::string   getPartName                  (HTp sstart);
 
+		// incremental editing (located in src/HumdrumFileStructure-edit.cpp)
+		bool          editLines                    (int index, int count,
+		                                            const std::vector<std::string>& lines);
+		bool          editInsertLine               (int index, const std::string& line);
+		bool          editDeleteLine               (int index);
+		bool          editReplaceLine              (int index, const std::string& line);
+		bool          isLastEditIncremental        (void) const;
+		bool          checkAnalysis                (std::ostream& out = std::cerr);
+		bool          compareAnalysis              (HumdrumFileStructure& reference,
+		                                            std::ostream& out = std::cerr);
 
 	protected:
+		virtual bool  runAnalysis                  (int type);
 		bool          analyzeRhythm                (void);
 		bool          assignRhythmFromRecip        (HTp spinestart);
 		bool          analyzeMeter                 (void);
@@ -2484,6 +3214,7 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		bool          analyzeLocalParameters       (void);
 		// bool          analyzeParameters            (void);
 		bool          analyzeDurationsOfNonRhythmicSpines(void);
+		bool          checkDurationOverflow        (void);
 		HumNum        getMinDur                    (std::vector<HumNum>& durs,
 		                                            std::vector<HumNum>& durstate);
 		bool          getTokenDurations            (std::vector<HumNum>& durs,
@@ -2513,6 +3244,42 @@ class HumdrumFileStructure : public HumdrumFileBase {
 		void          analyzeSignifiers            (void);
 		void          setLineRhythmAnalyzed        (void);
 		bool          prepareMensurationInformation(void);
+
+		// incremental editing:
+		bool          editLinesLocally             (int index, int count,
+		                                            std::vector<HLp>& newlines);
+		bool          isLocalEditLine              (HumdrumLine& line);
+		bool          hasLayoutParameterAbove      (int index);
+		bool          reanalyzeEditedFile          (unsigned analyses);
+		HTp           getStrandPredecessor         (HTp token);
+		bool          updateEditedNulls            (HLp next, std::vector<HLp>& newlines);
+		bool          updateEditedStrophes         (HLp next, std::vector<HLp>& newlines,
+		                                            bool interpretations);
+		void          reanalyzeEditedStrophes      (void);
+		bool          getNonNullEditContext        (HTp first, HLp next, int field,
+		                                            std::vector<HLp>& oldlines,
+		                                            std::vector<HLp>& newlines,
+		                                            std::vector<HTp>& before,
+		                                            std::vector<HTp>& after,
+		                                            HTp& previous, HTp& following,
+		                                            bool& reach);
+		void          linkNonNullDataTokens        (std::vector<HTp>& tokens,
+		                                            HTp previous, HTp following,
+		                                            bool reach);
+		bool          isTimedLine                  (HumdrumLine& line);
+		bool          getEditStartTime             (HTp token, HumNum& time);
+		bool          updateEditedRhythm           (int index, int count,
+		                                            HLp next, std::vector<HLp>& newlines,
+		                                            bool spined, bool barlines);
+		void          analyzeMeterRegion           (int first, int last);
+		bool          updateNonRhythmicDurations   (int first, int last);
+		bool          setNonRhythmicDuration       (HTp token);
+		bool          reanalyzeEditedRhythm        (void);
+		std::string   getEditPosition              (HTp token);
+
+		// m_lastEditIncremental: true if the last edit with editLines() was
+		// analyzed without re-analyzing the entire file.
+		bool          m_lastEditIncremental = false;
 };
 
 
@@ -2602,6 +3369,7 @@ class HumdrumFileContent : public HumdrumFileStructure {
 		bool   hasDataStraddle            (int line);
 
 	protected:
+		virtual bool runAnalysis      (int type);
 
 		bool   analyzeKernPhrasings       (HTp spinestart,
 		                                   std::vector<HTp>& linkstarts,
@@ -3040,6 +3808,56 @@ class HumdrumFile : public HUMDRUMFILE_PARENT {
 
 
 
+class HumdrumFile;
+
+class HumFileCache {
+	public:
+		                HumFileCache     (int capacity = 100);
+		               ~HumFileCache     ();
+
+		bool            read             (HumdrumFile& infile,
+		                                  const std::string& filename);
+		void            clear            (void);
+		void            setCapacity      (int capacity);
+		int             getCapacity      (void);
+		int             getSize          (void);
+		std::uint64_t   getHitCount      (void);
+		std::uint64_t   getMissCount     (void);
+
+	protected:
+		class Entry {
+			public:
+				std::string   filename;
+				std::int64_t  mtime    = 0; // modification time in nanoseconds
+				std::int64_t  size     = 0; // size of the file in bytes
+				unsigned      analyses = 0; // read analyses of the snapshot
+				std::string   contents;     // text of the file
+				std::string   snapshot;     // analyses of the file
+		};
+
+		static bool     getFileStatus    (const std::string& filename,
+		                                  std::int64_t& mtime, std::int64_t& size);
+		static bool     readContents     (const std::string& filename,
+		                                  std::string& contents);
+		int             trim             (void);
+
+	private:
+		typedef std::list<std::shared_ptr<Entry>> EntryList;
+
+		// m_entries: cached files, with the most recently used file first.
+		EntryList m_entries;
+
+		// m_index: position of each file in m_entries, by filename.
+		std::unordered_map<std::string, EntryList::iterator> m_index;
+
+		int           m_capacity;
+		std::uint64_t m_hits   = 0;
+		std::uint64_t m_misses = 0;
+		std::mutex    m_mutex;   // protects all of the above
+};
+
+
+
 //////////////////////////////
 //
 // MuseData line types, reference: Beyond Midi, page 410.
@@ -3876,19 +4694,20 @@ std::ostream& operator<<(std::ostream& out, MuseDataSet& musedata);
 
 
 #define GRIDREST NAN
+#define GRIDREST40 (-32768)
 
 class NoteGrid;
 
 
 class NoteCell {
 	public:
-		       NoteCell             (NoteGrid* owner, HTp token);
+		       NoteCell             (NoteGrid* owner, int voice, int slice);
 		      ~NoteCell             (void) { clear();                    }
 
-		double getSgnDiatonicPitch  (void) { return m_b7;                }
-		double getSgnMidiPitch      (void) { return m_b12;               }
-		double getSgnBase40Pitch    (void) { return m_b40;               }
-		double getSgnAccidental     (void) { return m_accidental;        }
+		double getSgnDiatonicPitch  (void);
+		double getSgnMidiPitch      (void);
+		double getSgnBase40Pitch    (void);
+		double getSgnAccidental     (void);
 
 		double getSgnDiatonicPitchClass(void);
 		double getAbsDiatonicPitchClass(void);
@@ -3896,15 +4715,15 @@ class NoteCell {
 		double getSgnBase40PitchClass(void);
 		double getAbsBase40PitchClass(void);
 
-		double getAbsDiatonicPitch  (void) { return fabs(m_b7);          }
-		double getAbsMidiPitch      (void) { return fabs(m_b12);         }
-		double getAbsBase40Pitch    (void) { return fabs(m_b40);         }
-		double getAbsAccidental     (void) { return fabs(m_accidental);  }
+		double getAbsDiatonicPitch  (void) { return fabs(getSgnDiatonicPitch()); }
+		double getAbsMidiPitch      (void) { return fabs(getSgnMidiPitch());     }
+		double getAbsBase40Pitch    (void) { return fabs(getSgnBase40Pitch());   }
+		double getAbsAccidental     (void) { return fabs(getSgnAccidental());    }
 
-		HTp    getToken             (void) { return m_token;             }
-		int    getNextAttackIndex   (void) { return m_nextAttackIndex;   }
-		int    getPrevAttackIndex   (void) { return m_prevAttackIndex;   }
-		int    getCurrAttackIndex   (void) { return m_currAttackIndex;   }
+		HTp    getToken             (void);
+		int    getNextAttackIndex   (void);
+		int    getPrevAttackIndex   (void);
+		int    getCurrAttackIndex   (void);
 		int    getSliceIndex        (void) { return m_timeslice;         }
 		int    getVoiceIndex        (void) { return m_voice;             }
 
@@ -3926,42 +4745,22 @@ class NoteCell {
 		double getMetricLevel       (void);
 		HumNum getDurationFromStart (void);
 		HumNum getDuration          (void);
-		void   setMeter             (int topval, HumNum botval);
 		int    getMeterTop          (void);
 		HumNum getMeterBottom       (void);
-
-		std::vector<HTp> m_tiedtokens;  // list of tied notes/rests after note attack
+		std::vector<HTp> getTiedTokens(void);
 
 	protected:
 		void clear                  (void);
-		void calculateNumericPitches(void);
-		void setVoiceIndex          (int index) { m_voice = index;           }
-		void setSliceIndex          (int index) { m_timeslice = index;       }
-		void setNextAttackIndex     (int index) { m_nextAttackIndex = index; }
-		void setPrevAttackIndex     (int index) { m_prevAttackIndex = index; }
-		void setCurrAttackIndex     (int index) { m_currAttackIndex = index; }
 
 	private:
+		// The note data is stored in the arrays of the owning NoteGrid,
+		// so a cell is only a view of one position in the grid.
 		NoteGrid* m_owner; // the NoteGrid to which this cell belongs.
-		HTp m_token;       // pointer to the note in the origina Humdrum file.
 		int m_voice;       // index of the voice in the score the note belongs
 		                   // 0=bottom voice (HumdrumFile ordering of parts)
 		                   // column in NoteGrid.
 		int m_timeslice;   // index for the row in NoteGrid.
 
-		double m_b7;         // diatonic note number; NaN=rest; negative=sustain.
-		double m_b12;        // MIDI note number; NaN=rest; negative=sustain.
-		double m_b40;        // base-40 note number; NaN=rest; negative=sustain.
-		double m_accidental; // chromatic alteration of a diatonic pitch.
-		                     // NaN=no accidental.
-		int m_nextAttackIndex; // index to next note attack (or rest),
-		                       // -1 for undefined (interpred as rest).
-		int m_prevAttackIndex; // index to previous note attack.
-		int m_currAttackIndex; // index to current note attack (useful for
-		                       // finding the start of a sustained note.
-		int m_metertop = 0;    // top number of prevailing meter signature
-		HumNum m_meterbot = 0; // bottom number of prevailing meter signature
-
 	friend NoteGrid;
 };
 
@@ -4013,16 +4812,36 @@ class NoteGrid {
 		void       getNoteAndRestAttacks (vector<NoteCell*>& attacks, int vindex);
 		double     getMetricLevel        (int sindex);
 		HumNum     getNoteDuration       (int vindex, int sindex);
+		size_t     getStorageSize        (void);
 
 	protected:
-		void       buildAttackIndexes    (void);
-		void       buildAttackIndex      (int vindex);
+		void       buildAttackIndexes    (bool indexes = true);
+		void       buildAttackIndex      (int vindex, bool indexes = true);
+		void       buildCellViews        (void);
+		int        getMeterIndex         (int top, HumNum bot);
+		void       addCell               (int vindex, HTp token, int meter);
+		vector<HTp> getTiedTokens        (int vindex, int sindex);
+
+		// Bits in m_flags:
+		enum { CellAttack = 1, CellRest = 2, CellSustain = 4 };
 
 	private:
-		vector<vector<NoteCell*> > m_grid;
+		// Per-voice arrays with one entry for each slice:
+		vector<vector<NoteCell> >  m_grid;      // views of the cells
+		vector<vector<HTp> >       m_tokens;    // note/rest/null token of cell
+		vector<vector<short> >     m_base40;    // GRIDREST40=rest, negative=sustain
+		vector<vector<char> >      m_flags;     // CellAttack|CellRest|CellSustain
+		vector<vector<int> >       m_prevattack;
+		vector<vector<int> >       m_currattack;
+		vector<vector<int> >       m_nextattack;
+		vector<vector<short> >     m_meter;     // index into m_meters
+
+		vector<pair<int, HumNum> > m_meters;    // distinct meter signatures
 		vector<HTp>                m_kernspines;
 		vector<double>             m_metriclevels;
-		HumdrumFile*               m_infile;
+		HumdrumFile*               m_infile = NULL;
+
+	friend NoteCell;
 };
 
 
@@ -4031,18 +4850,18 @@ class Convert {
 	public:
 
 		// Rhythm processing, defined in Convert-rhythm.cpp
-		static HumNum  recipToDuration      (const std::string& recip,
+		static HumNum  recipToDuration      (std::string_view recip,
 		                                     HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		                                     std::string_view separator = " ");
 		static HumNum  recipToDuration      (std::string* recip,
 		                                     HumNum scale = 4,
-		                                     const std::string& separator = " ");
-		static HumNum  recipToDurationIgnoreGrace(const std::string& recip,
+		                                     std::string_view separator = " ");
+		static HumNum  recipToDurationIgnoreGrace(std::string_view recip,
 		                                     HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		                                     std::string_view separator = " ");
 		static HumNum  recipToDurationIgnoreGrace(std::string* recip,
 		                                     HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		                                     std::string_view separator = " ");
 		static HumNum  recipToDurationNoDots(const std::string& recip,
 		                                     HumNum scale = 4,
 		                                     const std::string& separator = " ");
@@ -4064,42 +4883,42 @@ class Convert {
 		static int     base40ToDiatonic     (int b40);
 		static int     base40ToMidiNoteNumber(int b40);
 		static std::string  base40ToIntervalAbbr (int b40);
-		static int     kernToOctaveNumber   (const std::string& kerndata);
+		static int     kernToOctaveNumber   (std::string_view kerndata);
 		static int     kernToOctaveNumber   (HTp token)
-				{ return kernToOctaveNumber((std::string)*token); }
-		static int     kernToAccidentalCount(const std::string& kerndata);
+				{ return kernToOctaveNumber(std::string_view(*token)); }
+		static int     kernToAccidentalCount(std::string_view kerndata);
 		static int     kernToAccidentalCount(HTp token)
-				{ return kernToAccidentalCount((std::string)*token); }
+				{ return kernToAccidentalCount(std::string_view(*token)); }
 
       static int     kernToStaffLocation  (HTp token, HTp clef = NULL);
       static int     kernToStaffLocation  (HTp token, const std::string& clef);
       static int     kernToStaffLocation  (const std::string& token, const std::string& clef = "");
 
-		static int     kernToDiatonicPC     (const std::string& kerndata);
+		static int     kernToDiatonicPC     (std::string_view kerndata);
 		static int     kernToDiatonicPC     (HTp token)
-				{ return kernToDiatonicPC     ((std::string)*token); }
+				{ return kernToDiatonicPC     (std::string_view(*token)); }
 		static char    kernToDiatonicUC     (const std::string& kerndata);
 		static int     kernToDiatonicUC     (HTp token)
 				{ return kernToDiatonicUC     ((std::string)*token); }
 		static char    kernToDiatonicLC     (const std::string& kerndata);
 		static int     kernToDiatonicLC     (HTp token)
 				{ return kernToDiatonicLC     ((std::string)*token); }
-		static int     kernToBase40PC       (const std::string& kerndata);
+		static int     kernToBase40PC       (std::string_view kerndata);
 		static int     kernToBase40PC       (HTp token)
-				{ return kernToBase40PC       ((std::string)*token); }
-		static int     kernToBase12PC       (const std::string& kerndata);
+				{ return kernToBase40PC       (std::string_view(*token)); }
+		static int     kernToBase12PC       (std::string_view kerndata);
 		static int     kernToBase12PC       (HTp token)
-				{ return kernToBase12PC       ((std::string)*token); }
+				{ return kernToBase12PC       (std::string_view(*token)); }
 		static int     kernToBase7PC        (const std::string& kerndata) {
 		                                     return kernToDiatonicPC(kerndata); }
 		static int     kernToBase7PC        (HTp token)
 				{ return kernToBase7PC        ((std::string)*token); }
-		static int     kernToBase40         (const std::string& kerndata);
+		static int     kernToBase40         (std::string_view kerndata);
 		static int     kernToBase40         (HTp token)
-				{ return kernToBase40         ((std::string)*token); }
-		static int     kernToBase12         (const std::string& kerndata);
+				{ return kernToBase40         (std::string_view(*token)); }
+		static int     kernToBase12         (std::string_view kerndata);
 		static int     kernToBase12         (HTp token)
-				{ return kernToBase12         ((std::string)*token); }
+				{ return kernToBase12         (std::string_view(*token)); }
 		static int     kernToBase7          (const std::string& kerndata);
 		static int     kernToBase7          (HTp token)
 				{ return kernToBase7          ((std::string)*token); }
@@ -4171,12 +4990,12 @@ class Convert {
 		static HumNum mensToDuration        (HTp menstok);
 
 		// older functions to enhance or remove:
-		static HumNum  mensToDuration       (const std::string& mensdata, HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		static HumNum  mensToDuration       (std::string_view mensdata, HumNum scale = 4,
+		                                     std::string_view separator = " ");
 		static std::string  mensToRecip     (const std::string& mensdata, HumNum scale = 4,
 		                                     const std::string& separator = " ");
-		static HumNum  mensToDurationNoDots (const std::string& mensdata, HumNum scale = 4,
-		                                     const std::string& separator = " ");
+		static HumNum  mensToDurationNoDots (std::string_view mensdata, HumNum scale = 4,
+		                                     std::string_view separator = " ");
 
 		// MuseData conversions in Convert-musedata.cpp
       static int         museToBase40                    (const std::string& pitchString);
@@ -5275,7 +6094,7 @@ class MxmlEvent {
 		std::vector<MxmlEvent*> m_links;   // list of secondary chord notes
 		bool               m_linked;       // true if a secondary chord note
 		int                m_sequence;     // ordering of event in XML file
-		static int         m_counter;      // counter for sequence variable
+		static std::atomic<int> m_counter; // counter for sequence variable
 		short              m_staff;        // staff number in part for event
 		short              m_voice;        // voice number in part for event
 		int                m_voiceindex;   // voice index of item (remapping)
@@ -5581,6 +6400,8 @@ class HumTool : public Options {
 		              HumTool         (void);
 		virtual      ~HumTool         ();
 
+		HumTool&      operator=       (const HumTool& tool);
+
 		void          clearOutput     (void);
 
 		bool          hasAnyText      (void);
@@ -5611,7 +6432,17 @@ class HumTool : public Options {
 
 		virtual void  finally         (void) { };
 
+		unsigned      getRequiredAnalyses(void) const { return m_analyses; }
+		void          setRequiredAnalyses(unsigned mask) { m_analyses = mask;
+		                                                   m_analysesQ = true; }
+		bool          hasRequiredAnalyses(void) const { return m_analysesQ; }
+
+		void          setInPlaceOutput(bool state);
+		bool          hasInPlaceOutput(void);
+
 	protected:
+		void          printEditedFile (HumdrumFile& infile);
+
 		std::stringstream m_humdrum_text;  // output text in Humdrum syntax.
 		std::stringstream m_json_text;     // output text in JSON syntax.
 		std::stringstream m_free_text;     // output for plain text content.
@@ -5620,6 +6451,24 @@ class HumTool : public Options {
 
 		bool m_suppress = false;
 
+		// m_analyses: bit mask of HumFileAnalysis types that the tool
+		// uses, so that they can be done when the input files are read.
+		unsigned m_analyses = 0;
+
+		// m_analysesQ: true if the tool has declared the analyses that it
+		// uses with setRequiredAnalyses() (so m_analyses = 0 means that
+		// only the spine structure is needed, rather than unknown).
+		bool m_analysesQ = false;
+
+		// m_inplace: true if the caller of the tool (such as the filter
+		// tool) uses the input file after it is edited by the tool, so
+		// printEditedFile() does not print the file to m_humdrum_text.
+		bool m_inplace = false;
+
+		// m_edited: true if printEditedFile() was called while m_inplace
+		// was set, so the edited input file is the Humdrum output.
+		bool m_edited = false;
+
 };
 
 
@@ -5728,6 +6577,7 @@ int main(int argc, char** argv) {                                          \
 		return -1;                                                           \
 	}                                                                       \
 	hum::HumdrumFileStream instream(static_cast<hum::Options&>(interface)); \
+	instream.setReadAnalyses(interface.getRequiredAnalyses());              \
 	hum::HumdrumFileSet infiles;                                            \
 	bool status = true;                                                     \
 	while (instream.readSingleSegment(infiles)) {                           \
@@ -5850,6 +6700,9 @@ class HumdrumFileStream {
 		int             read               (HumdrumFileSet& infiles);
 		int             readSingleSegment  (HumdrumFileSet& infiles);
 
+		void            setReadAnalyses    (unsigned mask);
+		unsigned        getReadAnalyses    (void) const;
+
 	protected:
 		std::stringstream m_stringbuffer;   // used to read files from a string
 		std::ifstream     m_instream;       // used to read from list of files
@@ -5862,10 +6715,35 @@ class HumdrumFileStream {
 
 		std::vector<std::string>  m_universals;     // storage for universal comments
 
+		unsigned                  m_readAnalyses = 0; // HumFileAnalysis mask
+
+		// Input buffer: data is read from the current input stream in
+		// chunks, and the lines of the segment being read are parsed
+		// directly from this buffer.  The buffer keeps the current segment
+		// plus one chunk of read-ahead, so it grows only to the size of the
+		// largest segment in the input.
+		std::string               m_input;          // input buffer
+		std::istream*             m_inputstream = NULL; // stream feeding m_input
+		size_t                    m_inputstart = 0; // start of current segment
+		size_t                    m_inputpos = 0;   // next line to read
+		size_t                    m_inputend = 0;   // end of data in m_input
+		bool                      m_inputeof = false; // all lines read
+		std::string               m_carry;          // line carried from last segment
+		std::vector<std::pair<size_t, size_t>> m_lineranges; // segment lines
+
+		// Chunk size for reading from the input stream:
+		static const size_t       InputChunkSize = 64 * 1024;
+
 		// Automatic URL downloading of data from internet in read():
 		void     fillUrlBuffer            (std::stringstream& uribuffer,
 		                                   const std::string& uriname);
 
+		void     resetInput               (void);
+		bool     isInputEof               (std::istream& input);
+		bool     fillInput                (std::istream& input);
+		void     readInputLine            (std::istream& input, size_t& start,
+		                                   size_t& length);
+
 };
 
 
@@ -5906,15 +6784,83 @@ class HumdrumFileSet {
       int                   readAppendHumdrum(HumdrumFile& infile);
 		int                   appendHumdrumPointer(HumdrumFile* infile);
 
+      int                   readParallel     (const std::vector<std::string>& filenames);
+      int                   readAppendParallel(const std::vector<std::string>& filenames);
+      void                  setThreadCount   (int count);
+      int                   getThreadCount   (void);
+      void                  setReadAnalyses  (unsigned mask);
+      unsigned              getReadAnalyses  (void) const;
+      std::vector<std::string> getParseErrors(void);
+
    protected:
       std::vector<HumdrumFile*>  m_data;
 
+      // m_threads: number of threads for reading files in parallel.
+      // 1 = read files one at a time; 0 = one thread per hardware thread.
+      int                        m_threads;
+
+      // m_readAnalyses: analyses done on each file after it is read (a bit
+      // mask of HumFileAnalysis types), the same for serial and parallel
+      // reading.
+      unsigned                   m_readAnalyses = 0;
+
+      // m_parseErrors: problems found while reading files in parallel.
+      std::vector<std::string>   m_parseErrors;
+
       void                  appendHumdrumFileContent(const std::string& filename,
                                                std::stringstream& inbuffer);
 };
 
 
 
+class HumdrumFile;
+
+class HumToolRegistry {
+	public:
+		class Entry {
+			public:
+				std::string  name;  // name of the tool or alias
+				std::string  tool;  // name of the tool (Tool_ class name suffix)
+
+				// create: allocate a new instance of the tool.
+				HumTool*     (*create)(void);
+
+				// reset: set a tool to its state after construction.
+				void         (*reset)(HumTool* tool);
+
+				// run: run the tool on a file.
+				bool         (*run)(HumTool* tool, HumdrumFile& infile);
+
+				// inplace: true if the tool only edits tokens of the file
+				// and its Humdrum output is the file itself, printed after
+				// createLinesFromTokens().  The filter tool then does not
+				// need to parse the output (unless the tool changed the
+				// spine structure of the file).
+				bool         inplace;
+		};
+
+		static const Entry*             getEntry     (const std::string& name);
+		static bool                     isTool       (const std::string& name);
+		static HumTool*                 createTool   (const std::string& name);
+		static std::vector<std::string> getToolNames (bool aliases = false);
+		static std::vector<std::string> getAliases   (const std::string& tool);
+
+	protected:
+		static const std::vector<Entry>& getEntries  (void);
+		static const std::unordered_map<std::string, const Entry*>& getIndex(void);
+
+		template <class TOOL>
+		static HumTool* newTool       (void);
+		template <class TOOL>
+		static void     resetTool     (HumTool* tool);
+		template <class TOOL>
+		static bool     runTool       (HumTool* tool, HumdrumFile& infile);
+		template <class TOOL>
+		static bool     runToolOnPair (HumTool* tool, HumdrumFile& infile);
+};
+
+
+
 class Tool_1520ify : public HumTool {
 	public:
 		            Tool_1520ify       (void);
@@ -6700,7 +7646,7 @@ class Tool_cint : public HumTool {
 
 	protected:
 
-		void      initialize           (void);
+		bool      initialize           (void);
 		void      example              (void);
 		void      usage                (const std::string& command);
 		int       processFile          (HumdrumFile& infile);
@@ -8508,11 +9454,19 @@ class Tool_filter : public HumTool {
 		         Tool_filter        (void);
 		        ~Tool_filter        () {};
 
+		// Filters own the tools that they run, so they are not copied:
+		Tool_filter&  operator=     (const Tool_filter& filter) = delete;
+
 		bool     run                (HumdrumFileSet& infiles);
 		bool     run                (HumdrumFile& infile);
 		bool     run                (const std::string& indata);
 
 		bool     runUniversal       (HumdrumFileSet& infiles);
+		bool     runPipeline        (HumdrumFile& infile, const std::string& pipeline);
+
+		bool     runBatch           (HumdrumFileStream& instream, std::ostream& out,
+		                             int jobs = 0, int window = 0);
+		const std::vector<std::string>& getBatchErrors(void) const;
 
 	protected:
 		void     getCommandList     (std::vector<std::pair<std::string, std::string> >& commands,
@@ -8523,10 +9477,57 @@ class Tool_filter : public HumTool {
 		void     removeGlobalFilterLines    (HumdrumFile& infile);
 		void     removeUniversalFilterLines (HumdrumFileSet& infiles);
 		void     splitPipeline      (std::vector<std::string>& clist, const std::string& command);
+		bool     runStage           (const HumToolRegistry::Entry& entry,
+		                             HumdrumFile& infile, const std::string& command);
+		HumTool* getStageTool       (const HumToolRegistry::Entry& entry);
+		void     startAnalyses      (HumdrumFile& infile);
+		void     finishAnalyses     (HumdrumFile& infile, bool analyze);
+		void     startStage         (HumdrumFile& infile);
+		void     startStage         (HumdrumFileSet& infiles);
+		void     finishStage        (HumdrumFile& infile, const std::string& output);
+		void     finishStage        (HumdrumFile& infile);
+		void     finishStage        (HumdrumFileSet& infiles, const std::string& output);
+		bool     isStageInPlace     (HumdrumFile& infile);
+		std::string getTokenText    (HLp line);
+		std::ostream& getStageErrorStream(void);
 
 	private:
 		std::string   m_variant;        // used with -v option.
 		bool     m_debugQ = false; // used with --debug option
+		bool     m_reparseQ = false; // used with -R option
+
+		// m_tools: tools used by the filter stages, by tool name.
+		std::map<std::string, std::unique_ptr<HumTool>> m_tools;
+
+		// m_batchQ: true when filtering one file of runBatch() or running
+		// runPipeline(), so that error messages are stored with the file
+		// rather than printed, and bad tool options do not end the program.
+		bool     m_batchQ = false;
+
+		// m_batchErrors: error messages for the files of runBatch(),
+		// in file order.
+		std::vector<std::string> m_batchErrors;
+
+		// m_stageLines: lines of the file before the current filter stage.
+		std::vector<HLp> m_stageLines;
+
+		// m_stageTokens: tokens of the file before the current filter stage.
+		std::vector<HTp> m_stageTokens;
+
+		// m_stageSpines: text of manipulator and exclusive interpretation
+		// lines before the current filter stage.
+		std::vector<std::string> m_stageSpines;
+
+		// m_fileAnalyses: read analyses of the file being filtered, which
+		// are not done when the file is read again after a stage (see
+		// startAnalyses()).
+		unsigned m_fileAnalyses = 0;
+
+		// m_stageAnalyses: analyses which the next stage does for tools
+		// that have not declared the analyses that they use: none for the
+		// first stage, and m_fileAnalyses after the file has been read
+		// again or re-analyzed.
+		unsigned m_stageAnalyses = 0;
 
 };
 
@@ -8939,6 +9940,56 @@ class NotePoint {
 };
 
 
+// TimePointAlignment aligns the time points of two files by comparing the
+// notes which start at each time point.  Gaps have an affine cost (open +
+// extend * length), and the alignment is calculated in linear memory with
+// the divide-and-conquer method of Myers and Miller (1988), only visiting
+// cells within a band around the diagonal between the two sequences.
+class TimePointAlignment {
+	public:
+		            TimePointAlignment    (void);
+
+		void        setBand               (int band);
+		void        setGapCosts           (int open, int extend);
+		void        setSequences          (std::vector<std::vector<NotePoint>>& notes1,
+		                                   std::vector<std::vector<NotePoint>>& notes2);
+		int         align                 (std::vector<std::pair<int, int>>& path);
+		int         getSubstitutionCost   (int index1, int index2);
+		int         getPathCost           (std::vector<std::pair<int, int>>& path);
+
+	protected:
+		void        prepareKeys           (std::vector<std::vector<NotePoint>>& notes,
+		                                   std::vector<std::vector<long long>>& keys,
+		                                   std::vector<unsigned long long>& hashes);
+		int         alignRange            (int start1, int start2, int size1,
+		                                   int size2, int gapstart, int gapend);
+		int         getGapCost            (int length);
+		int         getBandStart          (int index1);
+		int         getBandEnd            (int index1);
+
+	private:
+		// Sorted pitch/duration keys of the notes at each time point,
+		// and a hash of the keys for quickly finding identical time points:
+		std::vector<std::vector<long long>> m_keys1;
+		std::vector<std::vector<long long>> m_keys2;
+		std::vector<unsigned long long>     m_hashes1;
+		std::vector<unsigned long long>     m_hashes2;
+
+		int m_band      = 0;   // half-width of band (0 = automatic)
+		int m_width     = 0;   // half-width of band used in alignment
+		int m_gapopen   = 6;
+		int m_gapextend = 2;
+
+		// Rows of the forward (m_cc, m_dd) and reverse (m_rr, m_ss) passes:
+		std::vector<int> m_cc;
+		std::vector<int> m_dd;
+		std::vector<int> m_rr;
+		std::vector<int> m_ss;
+
+		std::vector<std::pair<int, int>>* m_path = NULL;
+};
+
+
 // Function declarations:
 
 class Tool_humdiff : public HumTool {
@@ -8953,7 +10004,9 @@ class Tool_humdiff : public HumTool {
 		void     compareTimePoints  (std::vector<std::vector<TimePoint>>& timepoints, HumdrumFile& reference, HumdrumFile& alternate);
 		void     extractTimePoints  (std::vector<TimePoint>& points, HumdrumFile& infile);
 		void     printTimePoints    (std::vector<TimePoint>& timepoints);
-		void     compareLines       (HumNum minval, std::vector<int>& indexes, std::vector<std::vector<TimePoint>>& timepoints, std::vector<HumdrumFile*> infiles);
+		void     compareLines       (std::vector<std::vector<NotePoint>>& notelist, std::vector<HumdrumFile*>& infiles, int altline);
+		void     printEdit          (const std::string& operation, int refline, int altline, std::vector<NotePoint>* refnotes, std::vector<NotePoint>* altnotes);
+		std::string getUnmatchedNotes (std::vector<NotePoint>* notes, bool reference);
 		void     getNoteList        (std::vector<NotePoint>& notelist, HumdrumFile& infile, int line, int measure, int sourceindex, int tpindex);
 		int      findNoteInList     (NotePoint& np, std::vector<NotePoint>& nps);
 		void     printNotePoints    (std::vector<NotePoint>& notelist);
@@ -9106,7 +10159,7 @@ class Tool_imitation : public HumTool {
 		                            vector<double>& seq2, int i2);
 		int     checkForIntervalSequence(vector<int>& m_intervals,
 		                            vector<double>& v1i, int starti, int count);
-		void    markedTiedNotes    (vector<HTp>& tokens);
+		void    markedTiedNotes    (const vector<HTp>& tokens);
 
 	private:
 	 	vector<HTp> m_kernspines;
@@ -10138,6 +11191,132 @@ class TextInfo {
 };
 
 
+//////////////////////////////
+//
+// MSearchIndex -- Inverted index of the melodic n-grams in a set of
+//    files, used by msearch to find the voices and positions where a
+//    query may match, rather than checking every note of every file.
+//    For each voice of a file, the n-grams of consecutive note/rest
+//    attacks are indexed by pitch class (base-40, base-12 and base-7),
+//    by diatonic and chromatic interval to the next attack, and by
+//    duration.  The index only gives candidates: matches must still be
+//    checked, and files which are not in the index must be searched in
+//    full.  Files are identified by a hash of their tokens.
+//
+
+class MSearchIndex {
+	public:
+		                 MSearchIndex      (int gramlength = 3);
+		                ~MSearchIndex      ();
+
+		void             clear             (void);
+		int              getGramLength     (void);
+		int              getFileCount      (void);
+		size_t           getGramCount      (void);
+
+		bool             addFile           (HumdrumFile& infile);
+		bool             write             (const std::string& filename);
+
+		bool             read              (const std::string& filename);
+		bool             getCandidates     (HumdrumFile& infile,
+		                                    std::vector<MSearchQueryToken>& query,
+		                                    std::vector<std::pair<int, int>>& candidates);
+
+		static std::uint64_t getFileKey    (HumdrumFile& infile);
+
+		// Features of notes and query tokens (also used by MSearchAutomaton):
+		typedef std::pair<std::int64_t, std::int64_t> Feature;
+		static int       getFeatureKinds   (void);
+		static bool      getNoteFeatures   (std::vector<NoteCell*>& notes,
+		                                    std::vector<std::vector<Feature>>& features);
+		static bool      getQueryFeature   (MSearchQueryToken& token, int kind,
+		                                    Feature& feature);
+
+	protected:
+		std::uint64_t    getGramKey        (int kind, const Feature* features);
+		bool             findGram          (std::uint64_t key, std::uint64_t& offset,
+		                                    std::uint32_t& count);
+		void             loadCandidates    (std::uint64_t offset, std::uint32_t count,
+		                                    int shift);
+		void             unmap             (void);
+
+		static void      appendInt         (std::string& output, std::uint64_t value,
+		                                    int bytes);
+		static std::uint64_t readInt       (const char* data, int bytes);
+
+	private:
+		int m_gramlength;
+
+		// Index being built: file keys (in order of file number), and
+		// the list of file/voice/position entries for each n-gram key.
+		std::unordered_map<std::uint64_t, std::uint32_t> m_files;
+		std::unordered_map<std::uint64_t, std::vector<std::uint64_t>> m_grams;
+
+		// Index which has been read: the n-gram table and entry lists
+		// are used directly from the (memory-mapped) file contents.
+		std::string  m_buffer;
+		const char*  m_data = NULL;
+		size_t       m_size = 0;
+		void*        m_map  = NULL;
+		std::uint64_t m_gramcount = 0;
+		const char*  m_table = NULL;
+		const char*  m_entries = NULL;
+
+		// Candidates for the last n-gram looked up, for each file number,
+		// since the query is usually the same for each file that is searched.
+		std::uint64_t m_lastoffset = 0;
+		int           m_lastshift = -1;
+		std::unordered_map<std::uint32_t, std::vector<std::pair<int, int>>> m_candidates;
+};
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton -- Find candidate matches for many queries in one
+//    pass over each voice.  For each query, the longest run of tokens
+//    which require specific values of one kind of feature (pitch class,
+//    interval or duration, as in MSearchIndex) is added as a pattern to
+//    an Aho-Corasick automaton for that kind of feature.  The automata
+//    are run together over the notes of a voice, and each pattern found
+//    gives a position where its query may match.  Queries without such
+//    a run (or with a harmonic search) must be checked at all positions.
+//
+
+class MSearchAutomaton {
+	public:
+		                 MSearchAutomaton  (void);
+		                ~MSearchAutomaton  () {}
+
+		void             clear             (void);
+		int              addQuery          (std::vector<MSearchQueryToken>& query);
+		int              getQueryCount     (void);
+		bool             hasPattern        (int query);
+		bool             search            (std::vector<std::vector<NoteCell*>>& attacks,
+		                                    std::vector<std::vector<std::pair<int, int>>>& candidates);
+
+	protected:
+		class Trie {
+			public:
+				std::map<MSearchIndex::Feature, int> symbols;
+				std::vector<std::map<int, int>> next;    // child states for each symbol
+				std::vector<int>                fail;    // longest proper suffix state
+				std::vector<std::vector<int>>   output;  // queries ending at each state
+		};
+
+		void             build             (void);
+		int              advance           (Trie& trie, int state, const MSearchIndex::Feature& feature);
+
+	private:
+		std::vector<Trie> m_tries;     // automaton for each kind of feature
+		std::vector<int>  m_kind;      // kind of feature of each query's pattern (-1 for none)
+		std::vector<int>  m_length;    // number of tokens in each query's pattern
+		std::vector<int>  m_shift;     // index of the pattern in each query
+		bool              m_built = false;
+};
+
+
+
 class Tool_msearch : public HumTool {
 	public:
 		         Tool_msearch      (void);
@@ -10149,12 +11328,22 @@ class Tool_msearch : public HumTool {
 		bool     run               (HumdrumFile& infile, ostream& out);
 
 	protected:
-		void    initialize         (void);
+		void    initialize         (HumdrumFile& infile);
 		void    doMusicSearch      (HumdrumFile& infile, NoteGrid& grid,
 		                            vector<MSearchQueryToken>& query);
+		int     markMusicMatches   (HumdrumFile& infile,
+		                            vector<vector<NoteCell*>>& attacks,
+		                            vector<MSearchQueryToken>& query,
+		                            vector<pair<int, int>>* candidates);
+		void    addMusicSearchResults(HumdrumFile& infile, int mcount);
+		bool    doQueryListSearch  (HumdrumFile& infile);
+		bool    loadQueryList      (const std::string& filename);
 		bool    doHarmonicPitchSearch(MSearchQueryToken& query, HTp token);
 		void    doTextSearch       (HumdrumFile& infile, NoteGrid& grid,
 		                            vector<MSearchTextQuery>& query);
+		int     markTextMatches    (HumdrumFile& infile,
+		                            vector<MSearchTextQuery>& query);
+		void    addTextSearchResults(HumdrumFile& infile, int tcount);
 		void    fillMusicQuery     (vector<MSearchQueryToken>& query);
 		void    fillMusicQueryInterleaved(vector<MSearchQueryToken>& query,
 		                            const std::string& input, bool rhythmQ = false);
@@ -10187,6 +11376,9 @@ class Tool_msearch : public HumTool {
 		int     checkHarmonicPitchMatch (SonorityNoteData& query,
 		                           SonorityDatabase& sonorities, bool suppressQ);
 		bool    checkVerticalOnly  (const std::string& input);
+		bool    getIndexCandidates (HumdrumFile& infile,
+		                            vector<MSearchQueryToken>& query,
+		                            vector<pair<int, int>>& candidates);
 		void    makeLowerCase      (std::string& inout);
 
 	private:
@@ -10203,6 +11395,19 @@ class Tool_msearch : public HumTool {
 		std::vector<SonorityDatabase> m_sonorities;
 		std::vector<bool> m_sonoritiesChecked;
 		std::vector<pair<HTp, int>> m_tomark;
+
+		// m_index: n-gram index given with the --index option, which is
+		// kept for later files searched by the tool.
+		std::shared_ptr<MSearchIndex> m_index;
+		std::string m_indexfile;
+
+		// m_querytools: a tool for the options of each query in the list
+		// given with the --queries option, with the parsed music query in
+		// m_queries, and the patterns of the queries in m_automaton.
+		std::vector<std::shared_ptr<Tool_msearch>> m_querytools;
+		std::vector<std::vector<MSearchQueryToken>> m_queries;
+		MSearchAutomaton m_automaton;
+		std::string      m_queryfile;
 };
 
 
@@ -11644,8 +12849,13 @@ class MeasureDataSet {
 	public:
 		             MeasureDataSet   (void);
 		             MeasureDataSet   (HumdrumFile& infile);
+		             MeasureDataSet   (const MeasureDataSet& set) = delete;
 		            ~MeasureDataSet   ();
 
+		// The measures are owned by the set, so it cannot be copied (this
+		// also keeps HumToolRegistry from resetting Tool_simat by copying):
+		MeasureDataSet& operator=     (const MeasureDataSet& set) = delete;
+
 		void         clear            (void);
 		int          parse            (HumdrumFile& infile);
 		MeasureData& operator[]       (int index);
@@ -11677,16 +12887,81 @@ class MeasureComparison {
 
 
 
+class MeasureCorrelationMatrix {
+	public:
+		             MeasureCorrelationMatrix  (void);
+		             MeasureCorrelationMatrix  (const MeasureCorrelationMatrix& matrix) = delete;
+		            ~MeasureCorrelationMatrix  ();
+
+		// m_rows and m_columns point into the storage of the matrix:
+		MeasureCorrelationMatrix& operator=    (const MeasureCorrelationMatrix& matrix) = delete;
+
+		void         clear                     (void);
+		void         setRows                   (MeasureDataSet& set);
+		int          addColumns                (MeasureDataSet& set);
+		void         clearColumns              (void);
+		void         analyze                   (int threads = 1);
+		int          getRowCount               (void) { return (int)m_rowsums.size(); }
+		int          getColumnCount            (void) { return (int)m_columnsums.size(); }
+		double       getCorrelation            (int row, int column);
+
+		std::ostream& printGrid                (std::ostream& out, int column1,
+		                                        int column2);
+		std::ostream& printDiagonal            (std::ostream& out, int column1,
+		                                        int column2);
+
+	protected:
+		static void  addHistograms             (MeasureDataSet& set,
+		                                        std::vector<double>& values,
+		                                        std::vector<double>& scales,
+		                                        std::vector<double>& sums);
+		static double* alignValues             (std::vector<double>& storage,
+		                                        int count);
+		void         analyzeTile               (int row1, int row2, int column1,
+		                                        int column2);
+		static std::ostream& printCorrelation  (std::ostream& out, double correl);
+
+	private:
+		// Histograms centered on their mean, m_stride values for each
+		// measure (padded with zeros):
+		std::vector<double> m_rowvalues;
+		std::vector<double> m_columnvalues;
+		// One over the length of each centered histogram:
+		std::vector<double> m_rowscales;
+		std::vector<double> m_columnscales;
+		// Sum of each histogram (0.0 for measures without notes):
+		std::vector<double> m_rowsums;
+		std::vector<double> m_columnsums;
+
+		// Aligned copies of the row histograms, and of the column
+		// histograms with the values for each pitch class contiguous:
+		std::vector<double> m_rowstorage;
+		std::vector<double> m_columnstorage;
+		double*             m_rows    = NULL;
+		double*             m_columns = NULL;
+
+		// Correlations, m_columnsums.size() values for each row:
+		std::vector<double> m_matrix;
+};
+
+
+
 class MeasureComparisonGrid {
 	public:
 		             MeasureComparisonGrid     (void);
 		             MeasureComparisonGrid     (MeasureDataSet& set1, MeasureDataSet& set2);
 		             MeasureComparisonGrid     (MeasureDataSet* set1, MeasureDataSet* set2);
+		             MeasureComparisonGrid     (const MeasureComparisonGrid& grid) = delete;
 		            ~MeasureComparisonGrid     ();
 
+		// m_set1 and m_set2 point to the data sets of the owner:
+		MeasureComparisonGrid& operator=       (const MeasureComparisonGrid& grid) = delete;
+
 		void         clear                     (void);
 		void         analyze                   (MeasureDataSet& set1, MeasureDataSet& set2);
 		void         analyze                   (MeasureDataSet* set1, MeasureDataSet* set2);
+		void         setThreadCount            (int threads);
+		double       getCorrelation7pc         (int index1, int index2);
 
 		double       getStartTime1             (int index);
 		double       getStopTime1              (int index);
@@ -11710,7 +12985,8 @@ class MeasureComparisonGrid {
 				 double& lightness);
 
 	private:
-		std::vector<std::vector<MeasureComparison>> m_grid;
+		MeasureCorrelationMatrix m_matrix;
+		int             m_threads = 1;
 		MeasureDataSet* m_set1 = NULL;
 		MeasureDataSet* m_set2 = NULL;
 };
@@ -11730,11 +13006,13 @@ class Tool_simat : public HumTool {
 	protected:
 		void     initialize         (HumdrumFile& infile1, HumdrumFile& infile2);
 		void     processFile        (HumdrumFile& infile1, HumdrumFile& infile2);
+		bool     processManyFiles   (HumdrumFileSet& infiles);
 
 	private:
-		MeasureDataSet        m_data1;
-		MeasureDataSet        m_data2;
-		MeasureComparisonGrid m_grid;
+		MeasureDataSet           m_data1;
+		MeasureDataSet           m_data2;
+		MeasureComparisonGrid    m_grid;
+		MeasureCorrelationMatrix m_many;  // first file against many files
 
 };
 
@@ -12200,7 +13478,7 @@ class Tool_transpose : public HumTool {
 	protected:
 
 		// auto transpose functions:
-		void     initialize             (HumdrumFile& infile);
+		bool     initialize             (HumdrumFile& infile);
 		void     convertScore           (HumdrumFile& infile, int style);
 		void     processFile            (HumdrumFile& infile,
 		                                 std::vector<bool>& spineprocess);
@@ -12510,6 +13788,111 @@ class Tool_vcross : public HumTool {
 };
 
 
+class HumToolServer {
+	public:
+		class Request {
+			public:
+				std::string command;  // "stats", "stop" or empty to run tools
+				std::string tools;    // tool pipeline, such as "autobeam | autostem"
+				std::string options;  // options for the filter tool, such as "-R"
+				std::string filename; // file to process (read through the cache)
+				std::string data;     // Humdrum data to process if no filename
+		};
+
+		class Response {
+			public:
+				bool        status = false;
+				std::string humdrum;
+				std::string json;
+				std::string text;
+				std::string warning;
+				std::string error;
+		};
+
+		// Client: a connection to a server which is kept open for any
+		// number of requests (sendRequest() opens a new connection for
+		// each request).
+		class Client {
+			public:
+				               Client      (void);
+				              ~Client      ();
+				               Client      (const Client&) = delete;
+				Client&        operator=   (const Client&) = delete;
+
+				bool           connect     (const std::string& socketpath,
+				                            std::string& error);
+				bool           isConnected (void) const;
+				void           close       (void);
+				bool           send        (const Request& request, Response& response);
+
+			private:
+				int            m_fd;
+				std::string    m_buffer;   // data read but not used yet
+		};
+
+		               HumToolServer    (int cachesize = 100);
+		              ~HumToolServer    ();
+
+		bool           processRequest   (const Request& request, Response& response);
+		HumFileCache&  getFileCache     (void);
+		std::string    getStatistics    (void);
+
+		bool           serve            (const std::string& socketpath, int jobs = 0);
+		void           stop             (void);
+
+		static bool    sendRequest      (const std::string& socketpath,
+		                                 const Request& request, Response& response);
+		static std::string getDefaultSocket(void);
+
+	protected:
+		// Connection: an open connection to the server, with the data
+		// read from it but not used yet.
+		class Connection {
+			public:
+				int         fd = -1;
+				std::string buffer;
+		};
+
+		std::unique_ptr<Tool_filter> takeFilter(void);
+		void           returnFilter     (std::unique_ptr<Tool_filter> filter);
+		void           serveRequests    (std::shared_ptr<Connection> connection);
+		void           closeConnection  (Connection& connection);
+		void           handleRequest    (const Request& request, Response& response);
+
+		static bool    readMessage      (int fd, std::string& buffer,
+		                                 std::map<std::string, std::string>& fields);
+		static bool    writeMessage     (int fd, const std::vector<std::pair<std::string,
+		                                 std::string>>& fields);
+		static bool    writeData        (int fd, const char* data, size_t size);
+
+	private:
+		// m_cache: files read for requests with a filename.
+		HumFileCache m_cache;
+
+		// m_filters: filters which are not in use by a request.  Each
+		// request takes one and then returns it, so the filters and the
+		// tools that they have created are reused for later requests.
+		std::vector<std::unique_ptr<Tool_filter>> m_filters;
+
+		// m_connections: sockets of open connections, which are shut
+		// down when the server stops.
+		std::set<int> m_connections;
+
+		// m_returned: connections which have been answered and are waiting
+		// for their next request.  The worker threads add them here and
+		// write to m_wakeup so that serve() polls them again.
+		std::vector<std::shared_ptr<Connection>> m_returned;
+		int m_wakeup[2];
+
+		std::mutex             m_mutex;    // protects m_filters, m_connections
+		                                   // and m_returned
+		std::atomic<bool>      m_stop;     // true when serve() should return
+		std::atomic<long long> m_requests; // number of requests processed
+		std::atomic<long long> m_errors;   // number of requests with errors
+};
+
+
+
 } // end of namespace hum
 
 
@@ -658,7 +658,7 @@ HumNum Convert::kernTimeSignatureBottomToDuration (const string& aKernString) {
 	size_t loc = aKernString.find('/');
 	if (loc == std::string::npos) {
 		cerr << "Error: poorly formed time signature: " << aKernString << endl;
-		exit(1);
+		return 0;
 	}
 	string afterslash = aKernString.substr(loc+1);
 	return Convert::kernToDuration(afterslash);
@@ -677,7 +677,7 @@ int Convert::kernTimeSignatureTop (const string& aKernString) {
 	if (aKernString.find('+') != std::string::npos) {
 		cerr << "Error: cannot handle time signature: " << aKernString
 			  << " yet." << endl;
-		exit(1);
+		return 0;
 	} else {
 		int len = (int)aKernString.size();
 		if (len > 2) {
@@ -166,8 +166,8 @@ bool Convert::getMensStemDirection(const string& mensdata) {
 //                separator = " " (space between chord notes)
 //
 
-HumNum Convert::mensToDuration(const string& mensdata, HumNum scale,
-		const string& separator) {
+HumNum Convert::mensToDuration(std::string_view mensdata, HumNum scale,
+		std::string_view separator) {
 	HumNum output(0);
    bool perfect = false;
    // bool imperfect = true;
@@ -215,8 +215,8 @@ HumNum Convert::mensToDuration(const string& mensdata, HumNum scale,
 // Convert::mensToDurationNoDots -- The imperfect duration of the **mens rhythm.
 //
 
-HumNum Convert::mensToDurationNoDots(const string& mensdata, HumNum scale,
-		const string& separator) {
+HumNum Convert::mensToDurationNoDots(std::string_view mensdata, HumNum scale,
+		std::string_view separator) {
 	HumNum output(0);
 
 	for (int i=0; i<(int)mensdata.size(); i++) {
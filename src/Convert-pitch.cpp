@@ -70,7 +70,7 @@ string Convert::kernToScientificPitch(const string& kerndata,
 //    input string. Only the first subtoken in the string is considered.
 //
 
-int Convert::kernToDiatonicPC(const string& kerndata) {
+int Convert::kernToDiatonicPC(std::string_view kerndata) {
 	for (int i=0; i<(int)kerndata.size(); i++) {
 		if (kerndata[i] == ' ') {
 			break;
@@ -143,7 +143,7 @@ char Convert::kernToDiatonicLC(const string& kerndata) {
 //    value will be 0.
 //
 
-int Convert::kernToAccidentalCount(const string& kerndata) {
+int Convert::kernToAccidentalCount(std::string_view kerndata) {
 	int output = 0;
 	for (int i=0; i<(int)kerndata.size(); i++) {
 		if (kerndata[i] == ' ') {
@@ -169,7 +169,7 @@ int Convert::kernToAccidentalCount(const string& kerndata) {
 //    considered.
 //
 
-int Convert::kernToOctaveNumber(const string& kerndata) {
+int Convert::kernToOctaveNumber(std::string_view kerndata) {
 	int uc = 0;
 	int lc = 0;
 	if (kerndata == ".") {
@@ -206,7 +206,7 @@ int Convert::kernToOctaveNumber(const string& kerndata) {
 //    Will ignore subsequent pitches in a chord.
 //
 
-int Convert::kernToBase40PC(const string& kerndata) {
+int Convert::kernToBase40PC(std::string_view kerndata) {
 	int diatonic = Convert::kernToDiatonicPC(kerndata);
 	if (diatonic < 0) {
 		return diatonic;
@@ -234,8 +234,15 @@ int Convert::kernToBase40PC(const string& kerndata) {
 //    Will ignore subsequent pitches in a chord.
 //
 
-int Convert::kernToBase40(const string& kerndata) {
-	string trimmed = Convert::trimWhiteSpace(kerndata);
+int Convert::kernToBase40(std::string_view kerndata) {
+	// Trim whitespace by narrowing the view rather than copying the text:
+	std::string_view trimmed = kerndata;
+	while (!trimmed.empty() && isspace((unsigned char)trimmed.front())) {
+		trimmed.remove_prefix(1);
+	}
+	while (!trimmed.empty() && isspace((unsigned char)trimmed.back())) {
+		trimmed.remove_suffix(1);
+	}
 	int pc = Convert::kernToBase40PC(trimmed);
 	if (pc < 0) {
 		return pc;
@@ -253,7 +260,7 @@ int Convert::kernToBase40(const string& kerndata) {
 //   will return 12 instead of 0 for B#.
 //
 
-int Convert::kernToBase12PC(const string& kerndata) {
+int Convert::kernToBase12PC(std::string_view kerndata) {
 	int diatonic = Convert::kernToDiatonicPC(kerndata);
 	if (diatonic < 0) {
 		return diatonic;
@@ -281,7 +288,7 @@ int Convert::kernToBase12PC(const string& kerndata) {
 //     (middle C = 48).
 //
 
-int Convert::kernToBase12(const string& kerndata) {
+int Convert::kernToBase12(std::string_view kerndata) {
 	int pc = Convert::kernToBase12PC(kerndata);
 	int octave = Convert::kernToOctaveNumber(kerndata);
 	return pc + 12 * octave;
@@ -320,7 +327,7 @@ string Convert::base40ToKern(int b40) {
 	}
 	if (repeat > 12) {
 		cerr << "Error: unreasonable octave value: " << octave << " for " << b40 << endl;
-		exit(1);
+		return "";
 	}
 	string output;
 	output += base;
@@ -41,16 +41,16 @@ namespace hum {
 //
 
 HumNum Convert::recipToDuration(string* recip, HumNum scale,
-		const string& separator) {
+		std::string_view separator) {
 	return Convert::recipToDuration(*recip, scale, separator);
 }
 
 
-HumNum Convert::recipToDuration(const string& recip, HumNum scale,
-		const string& separator) {
+HumNum Convert::recipToDuration(std::string_view recip, HumNum scale,
+		std::string_view separator) {
 	size_t loc;
 	loc = recip.find(separator);
-	string subtok;
+	std::string_view subtok;
 	if (loc != string::npos) {
 		subtok = recip.substr(0, loc);
 	} else {
@@ -141,16 +141,16 @@ HumNum Convert::recipToDuration(const string& recip, HumNum scale,
 //
 
 HumNum Convert::recipToDurationIgnoreGrace(string* recip, HumNum scale,
-		const string& separator) {
+		std::string_view separator) {
 	return Convert::recipToDurationIgnoreGrace(*recip, scale, separator);
 }
 
 
-HumNum Convert::recipToDurationIgnoreGrace(const string& recip, HumNum scale,
-		const string& separator) {
+HumNum Convert::recipToDurationIgnoreGrace(std::string_view recip, HumNum scale,
+		std::string_view separator) {
 	size_t loc;
 	loc = recip.find(separator);
-	string subtok;
+	std::string_view subtok;
 	if (loc != string::npos) {
 		subtok = recip.substr(0, loc);
 	} else {
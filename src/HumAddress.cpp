@@ -11,6 +11,7 @@
 //
 
 #include "HumAddress.h"
+#include "HumDataType.h"
 #include "HumdrumLine.h"
 
 using namespace std;
@@ -30,6 +31,7 @@ HumAddress::HumAddress(void) {
 	m_subtrack      = -1;
 	m_subtrackcount = 0;
 	m_fieldindex    = -1;
+	m_datatype      = HumDataType::Unknown;
 	m_owner         = NULL;
 }
 
@@ -40,6 +42,7 @@ HumAddress::HumAddress(HumAddress& address) {
 	m_subtrack      = address.m_subtrack;
 	m_subtrackcount = address.m_subtrackcount;
 	m_spining       = address.m_spining;
+	m_datatype      = address.m_datatype;
 	m_owner         = address.m_owner;
 }
 
@@ -71,6 +74,7 @@ HumAddress& HumAddress::operator=(const HumAddress& address) {
 	m_subtrack      = address.m_subtrack;
 	m_subtrackcount = address.m_subtrackcount;
 	m_spining       = address.m_spining;
+	m_datatype      = address.m_datatype;
 	m_owner         = address.m_owner;
 	return *this;
 }
@@ -137,6 +141,24 @@ const HumdrumToken& HumAddress::getDataType(void) const {
 
 
 
+//////////////////////////////
+//
+// HumAddress::getDataTypeId -- Return the HumDataType id of the exclusive
+//     interpretation for the token associated with the address.  Returns
+//     HumDataType::None if the token is not owned by a HumdrumLine, or
+//     HumDataType::Unknown if the tracks of the owning file have not been
+//     analyzed since the token was added.
+//
+
+int HumAddress::getDataTypeId(void) const {
+	if (m_owner == NULL) {
+		return HumDataType::None;
+	}
+	return m_datatype;
+}
+
+
+
 //////////////////////////////
 //
 // HumAddress::getExclusiveInterpretation -- Return the exclusive
@@ -315,6 +337,19 @@ void HumAddress::setSpineInfo(const string& spineinfo) {
 
 
 
+//////////////////////////////
+//
+// HumAddress::setDataTypeId -- Store the HumDataType id of the exclusive
+//     interpretation for the associated token.  This function is used by
+//     the HumdrumFileBase class when analyzing tracks.
+//
+
+void HumAddress::setDataTypeId(int id) {
+	m_datatype = id;
+}
+
+
+
 //////////////////////////////
 //
 // HumAddress::setTrack -- Set the track number of the associated token.
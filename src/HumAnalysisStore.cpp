@@ -0,0 +1,475 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 06:21:30 UTC 2026
+// Last Modified: Sat Oct 17 06:21:30 UTC 2026
+// Filename:      HumAnalysisStore.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumAnalysisStore.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Typed storage for the results of the built-in analyses.
+//
+
+#include "HumAnalysisStore.h"
+#include "HumNum.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// HumAnalysisValue::HumAnalysisValue --
+//
+
+HumAnalysisValue::HumAnalysisValue(void) {
+	type = Undefined;
+	value.number = 0.0;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::HumAnalysisStore --
+//
+
+HumAnalysisStore::HumAnalysisStore(void) {
+	m_rows = 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::~HumAnalysisStore --
+//
+
+HumAnalysisStore::~HumAnalysisStore() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::clear -- Remove all rows, keys and values.
+//
+
+void HumAnalysisStore::clear(void) {
+	m_keys.clear();
+	m_columns.clear();
+	m_autoIndex.clear();
+	m_subIndex.clear();
+	m_strings.clear();
+	m_freeRows.clear();
+	m_rows = 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::addRow -- Return a row for a new token, line or file.
+//     Rows released by deleted tokens are reused.  Columns are not
+//     resized until a value is stored in the row.
+//
+
+int HumAnalysisStore::addRow(void) {
+	if (!m_freeRows.empty()) {
+		int row = m_freeRows.back();
+		m_freeRows.pop_back();
+		return row;
+	}
+	return m_rows++;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::copyRow -- Return a new row with the same values as
+//     the given row (used when a token is copied).
+//
+
+int HumAnalysisStore::copyRow(int row) {
+	int output = addRow();
+	for (int i=0; i<(int)m_columns.size(); i++) {
+		const HumAnalysisValue* value = getValue(row, i);
+		if (value == NULL) {
+			continue;
+		}
+		// Copy the value before the column is resized for the new row.
+		HumAnalysisValue copy = *value;
+		if (copy.type == HumAnalysisValue::String) {
+			string text = m_strings.at(copy.value.ints[0]);
+			setValue(output, i, text);
+		} else {
+			getCell(output, i) = copy;
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::releaseRow -- Delete the values in a row, and allow
+//     the row to be reused.
+//
+
+void HumAnalysisStore::releaseRow(int row) {
+	if ((row < 0) || (row >= m_rows)) {
+		return;
+	}
+	for (int i=0; i<(int)m_columns.size(); i++) {
+		deleteValue(row, i);
+	}
+	m_freeRows.push_back(row);
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getRowCount --
+//
+
+int HumAnalysisStore::getRowCount(void) const {
+	return m_rows;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::isAnalysisNamespace -- Returns true if the
+//     namespaces are for analysis values: either "":"auto" (the usual
+//     namespace) or "auto":ns2 (used for values of chord notes, such as
+//     "auto:2:visualAccidental").
+//
+
+bool HumAnalysisStore::isAnalysisNamespace(const string& ns1, const string& ns2) {
+	if (ns1.empty()) {
+		return ns2 == "auto";
+	}
+	return ns1 == "auto";
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::findKeyIndex -- Return the column index of a key, or
+//     -1 if no values have been stored for the key.
+//
+
+int HumAnalysisStore::findKeyIndex(const string& ns1, const string& ns2,
+		const string& key) const {
+	if (ns1.empty()) {
+		auto it = m_autoIndex.find(key);
+		return (it == m_autoIndex.end()) ? -1 : it->second;
+	}
+	if (m_subIndex.empty()) {
+		return -1;
+	}
+	auto it = m_subIndex.find(ns2 + ":" + key);
+	return (it == m_subIndex.end()) ? -1 : it->second;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getKeyIndex -- Return the column index of a key,
+//     adding a column for the key if it is new.  The namespaces must be
+//     analysis namespaces (see isAnalysisNamespace()).
+//
+
+int HumAnalysisStore::getKeyIndex(const string& ns1, const string& ns2,
+		const string& key) {
+	int index = findKeyIndex(ns1, ns2, key);
+	if (index >= 0) {
+		return index;
+	}
+	index = (int)m_keys.size();
+	if (ns1.empty()) {
+		m_autoIndex[key] = index;
+	} else {
+		m_subIndex[ns2 + ":" + key] = index;
+	}
+	m_keys.push_back({ns1, ns2, key});
+	m_columns.resize(m_keys.size());
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getKeyCount --
+//
+
+int HumAnalysisStore::getKeyCount(void) const {
+	return (int)m_keys.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getNamespace1 --
+//
+
+const string& HumAnalysisStore::getNamespace1(int keyindex) const {
+	return m_keys.at(keyindex).ns1;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getNamespace2 --
+//
+
+const string& HumAnalysisStore::getNamespace2(int keyindex) const {
+	return m_keys.at(keyindex).ns2;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getKey --
+//
+
+const string& HumAnalysisStore::getKey(int keyindex) const {
+	return m_keys.at(keyindex).key;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getValue -- Return the value of a key for a row, or
+//     NULL if the value is not defined.
+//
+
+const HumAnalysisValue* HumAnalysisStore::getValue(int row, int keyindex) const {
+	if ((row < 0) || (keyindex < 0) || (keyindex >= (int)m_columns.size())) {
+		return NULL;
+	}
+	const vector<HumAnalysisValue>& column = m_columns[keyindex];
+	if (row >= (int)column.size()) {
+		return NULL;
+	}
+	if (!column[row].isDefined()) {
+		return NULL;
+	}
+	return &column[row];
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getString -- Return the text form of a value, which
+//     is the same as the string stored by HumHash::setValue() for
+//     the type of the value.
+//
+
+string HumAnalysisStore::getString(const HumAnalysisValue& value) const {
+	switch (value.type) {
+		case HumAnalysisValue::String:
+			return m_strings.at(value.value.ints[0]);
+		case HumAnalysisValue::Integer:
+			return to_string(value.value.ints[0]);
+		case HumAnalysisValue::Boolean:
+			return value.value.ints[0] ? "true" : "false";
+		case HumAnalysisValue::Token:
+			return "HT_" + to_string((long long)value.value.token);
+		case HumAnalysisValue::Fraction:
+			if (value.value.ints[1] == 1) {
+				return to_string(value.value.ints[0]);
+			}
+			return to_string(value.value.ints[0]) + "/" + to_string(value.value.ints[1]);
+		case HumAnalysisValue::Float:
+			{
+				stringstream ss;
+				ss << value.value.number;
+				return ss.str();
+			}
+	}
+	return "";
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getCell -- Return the storage for a value, resizing
+//     the column if necessary.
+//
+
+HumAnalysisValue& HumAnalysisStore::getCell(int row, int keyindex) {
+	vector<HumAnalysisValue>& column = m_columns.at(keyindex);
+	if (row >= (int)column.size()) {
+		column.resize(row + 1);
+	}
+	return column[row];
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::setValue -- Store a value.  The strings "true" and
+//     "false" are stored as booleans.
+//
+
+void HumAnalysisStore::setValue(int row, int keyindex, const string& value) {
+	if (value == "true") {
+		setBool(row, keyindex, true);
+		return;
+	} else if (value == "false") {
+		setBool(row, keyindex, false);
+		return;
+	}
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	if (cell.type == HumAnalysisValue::String) {
+		m_strings[cell.value.ints[0]] = value;
+		return;
+	}
+	cell.type = HumAnalysisValue::String;
+	cell.value.ints[0] = (int)m_strings.size();
+	m_strings.push_back(value);
+}
+
+
+void HumAnalysisStore::setValue(int row, int keyindex, int value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Integer;
+	cell.value.ints[0] = value;
+}
+
+
+void HumAnalysisStore::setValue(int row, int keyindex, const HumNum& value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Fraction;
+	cell.value.ints[0] = value.getNumerator();
+	cell.value.ints[1] = value.getDenominator();
+}
+
+
+void HumAnalysisStore::setValue(int row, int keyindex, HTp value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Token;
+	cell.value.token = value;
+}
+
+
+void HumAnalysisStore::setValue(int row, int keyindex, double value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Float;
+	cell.value.number = value;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::setBool --
+//
+
+void HumAnalysisStore::setBool(int row, int keyindex, bool value) {
+	deleteValue(row, keyindex);
+	HumAnalysisValue& cell = getCell(row, keyindex);
+	cell.type = HumAnalysisValue::Boolean;
+	cell.value.ints[0] = value ? 1 : 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::deleteValue -- Remove a value.  The text of string
+//     values is cleared, but its slot is not reused.
+//
+
+void HumAnalysisStore::deleteValue(int row, int keyindex) {
+	if ((row < 0) || (keyindex < 0) || (keyindex >= (int)m_columns.size())) {
+		return;
+	}
+	vector<HumAnalysisValue>& column = m_columns[keyindex];
+	if (row >= (int)column.size()) {
+		return;
+	}
+	HumAnalysisValue& cell = column[row];
+	if (cell.type == HumAnalysisValue::String) {
+		string().swap(m_strings[cell.value.ints[0]]);
+	}
+	cell.type = HumAnalysisValue::Undefined;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getValueCount -- Return the number of values which
+//     are defined for a row.
+//
+
+int HumAnalysisStore::getValueCount(int row) const {
+	int output = 0;
+	for (int i=0; i<(int)m_columns.size(); i++) {
+		if (getValue(row, i)) {
+			output++;
+		}
+	}
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumAnalysisStore::getMemoryUsage -- Return the approximate number of
+//     bytes allocated for the store.
+//
+
+size_t HumAnalysisStore::getMemoryUsage(void) const {
+	size_t output = sizeof(*this);
+	for (int i=0; i<(int)m_columns.size(); i++) {
+		output += m_columns[i].capacity() * sizeof(HumAnalysisValue);
+		output += sizeof(m_columns[i]) + sizeof(m_keys[i]);
+		output += m_keys[i].ns1.capacity() + m_keys[i].ns2.capacity()
+				+ m_keys[i].key.capacity();
+	}
+	for (int i=0; i<(int)m_strings.size(); i++) {
+		output += sizeof(string);
+		if (m_strings[i].capacity() > 15) {
+			output += m_strings[i].capacity();
+		}
+	}
+	output += m_freeRows.capacity() * sizeof(int);
+	output += (m_autoIndex.size() + m_subIndex.size()) * (sizeof(string) + 32);
+	return output;
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
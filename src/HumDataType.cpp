@@ -0,0 +1,242 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 20:42:46 UTC 2026
+// Last Modified: Sat Oct 17 11:46:57 UTC 2026
+// Filename:      HumDataType.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumDataType.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Symbol table for exclusive interpretations.
+//
+
+#include "HumDataType.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+// Definitions of the fixed ids, so that they can be passed by reference:
+const int HumDataType::None;
+const int HumDataType::Kern;
+const int HumDataType::Mens;
+const int HumDataType::Recip;
+const int HumDataType::Text;
+const int HumDataType::Silbe;
+const int HumDataType::Dynam;
+const int HumDataType::Harm;
+const int HumDataType::Fing;
+const int HumDataType::Unknown;
+
+// Entries are stored in fixed-size blocks which are never moved or
+// deleted, so names can be read without locking while other threads
+// add new data types.
+static const int HumDataTypeBlockSize = 256;
+static const int HumDataTypeMaxBlocks = 1024;
+
+static const unsigned HumDataTypeKernLike = 1;
+static const unsigned HumDataTypeMensLike = 2;
+
+struct HumDataTypeEntry {
+	std::string name;
+	unsigned    flags = 0;
+};
+
+struct HumDataTypeTable {
+	std::mutex                         mutex;
+	std::unordered_map<std::string, int> ids;
+	std::atomic<HumDataTypeEntry*>     blocks[HumDataTypeMaxBlocks];
+	std::atomic<int>                   count;
+	HumDataTypeTable(void);
+	int add(const std::string& name);
+};
+
+
+//////////////////////////////
+//
+// HumDataTypeTable::HumDataTypeTable -- Enter the data types which have
+//     fixed ids (see HumDataType.h).
+//
+
+HumDataTypeTable::HumDataTypeTable(void) : count(0) {
+	for (int i=0; i<HumDataTypeMaxBlocks; i++) {
+		blocks[i] = NULL;
+	}
+	add("");
+	add("**kern");
+	add("**mens");
+	add("**recip");
+	add("**text");
+	add("**silbe");
+	add("**dynam");
+	add("**harm");
+	add("**fing");
+}
+
+
+
+//////////////////////////////
+//
+// HumDataTypeTable::add -- Append a new data type to the table.  The
+//     mutex must be held by the caller (except in the constructor).
+//
+
+int HumDataTypeTable::add(const std::string& name) {
+	int id = count;
+	int block = id / HumDataTypeBlockSize;
+	if (block >= HumDataTypeMaxBlocks) {
+		return HumDataType::Unknown;
+	}
+	if (blocks[block] == NULL) {
+		blocks[block] = new HumDataTypeEntry[HumDataTypeBlockSize];
+	}
+	HumDataTypeEntry& entry = blocks[block][id % HumDataTypeBlockSize];
+	entry.name = name;
+	if ((name == "**kern") || (name == "**kernyy") ||
+			(name.compare(0, 7, "**kern-") == 0)) {
+		entry.flags |= HumDataTypeKernLike;
+	}
+	if ((name == "**mens") || (name.compare(0, 7, "**mens-") == 0)) {
+		entry.flags |= HumDataTypeMensLike;
+	}
+	ids[name] = id;
+	count = id + 1;
+	return id;
+}
+
+
+
+//////////////////////////////
+//
+// getHumDataTypeTable -- The table is allocated once and never deleted
+//     so that it can be used during program shutdown.
+//
+
+static HumDataTypeTable& getHumDataTypeTable(void) {
+	static HumDataTypeTable* table = new HumDataTypeTable;
+	return *table;
+}
+
+
+
+//////////////////////////////
+//
+// getHumDataTypeEntry -- Return the entry for an id, or NULL if the
+//     id is not in the table.
+//
+
+static const HumDataTypeEntry* getHumDataTypeEntry(int id) {
+	HumDataTypeTable& table = getHumDataTypeTable();
+	if ((id < 0) || (id >= table.count)) {
+		return NULL;
+	}
+	return &table.blocks[id / HumDataTypeBlockSize][id % HumDataTypeBlockSize];
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getId -- Return the id for a data type string, adding it
+//     to the table if it has not been seen before.  Returns
+//     HumDataType::Unknown if the table is full.
+//
+
+int HumDataType::getId(const std::string& datatype) {
+	HumDataTypeTable& table = getHumDataTypeTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	auto it = table.ids.find(datatype);
+	if (it != table.ids.end()) {
+		return it->second;
+	}
+	return table.add(datatype);
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getName -- Return the data type string for an id, or
+//     an empty string if the id is not in the table.
+//
+
+const std::string& HumDataType::getName(int id) {
+	const HumDataTypeEntry* entry = getHumDataTypeEntry(id);
+	if (entry) {
+		return entry->name;
+	}
+	return getHumDataTypeEntry(None)->name;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::getCount -- Return the number of data types in the table.
+//
+
+int HumDataType::getCount(void) {
+	return getHumDataTypeTable().count;
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::isKernLike -- Returns true if the id is for **kern,
+//     **kern- plus a tag, or **kernyy.
+//
+
+bool HumDataType::isKernLike(int id) {
+	if (id == Kern) {
+		return true;
+	}
+	const HumDataTypeEntry* entry = getHumDataTypeEntry(id);
+	return entry && (entry->flags & HumDataTypeKernLike);
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::isMensLike -- Returns true if the id is for **mens or
+//     **mens- plus a tag.
+//
+
+bool HumDataType::isMensLike(int id) {
+	if (id == Mens) {
+		return true;
+	}
+	const HumDataTypeEntry* entry = getHumDataTypeEntry(id);
+	return entry && (entry->flags & HumDataTypeMensLike);
+}
+
+
+
+//////////////////////////////
+//
+// HumDataType::isStaffLike -- Returns true if the id is for a data type
+//     which is displayed as a staff (kern-like or mens-like).
+//
+
+bool HumDataType::isStaffLike(int id) {
+	if ((id == Kern) || (id == Mens)) {
+		return true;
+	}
+	const HumDataTypeEntry* entry = getHumDataTypeEntry(id);
+	return entry && (entry->flags & (HumDataTypeKernLike | HumDataTypeMensLike));
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -0,0 +1,204 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 07:51:57 UTC 2026
+// Last Modified: Sat Oct 17 07:51:57 UTC 2026
+// Filename:      HumFieldScanner.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumFieldScanner.cpp
+// Syntax:        C++17; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Find field separators, quotes and newlines in text.
+//
+
+#include "HumFieldScanner.h"
+
+#ifdef HUMLIB_AVX2
+	#include <immintrin.h>
+#elif defined(HUMLIB_SSE2)
+	#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// HumFieldScanner::find -- Return a pointer to the first character
+//     between start and end which is one of the given characters, or
+//     end if there is no such character.
+//
+
+const char* HumFieldScanner::find(const char* start, const char* end, char c1) {
+	return HumFieldScanner::find(start, end, c1, c1, c1);
+}
+
+
+const char* HumFieldScanner::find(const char* start, const char* end, char c1,
+		char c2) {
+	return HumFieldScanner::find(start, end, c1, c2, c2);
+}
+
+
+const char* HumFieldScanner::find(const char* start, const char* end, char c1,
+		char c2, char c3) {
+	const char* p = start;
+
+#ifdef HUMLIB_AVX2
+	__m256i v1 = _mm256_set1_epi8(c1);
+	__m256i v2 = _mm256_set1_epi8(c2);
+	__m256i v3 = _mm256_set1_epi8(c3);
+	while (end - p >= 32) {
+		__m256i text = _mm256_loadu_si256((const __m256i*)p);
+		__m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(text, v1),
+				_mm256_or_si256(_mm256_cmpeq_epi8(text, v2), _mm256_cmpeq_epi8(text, v3)));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+		if (mask) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 32;
+	}
+#endif
+
+#ifdef HUMLIB_SSE2
+	__m128i w1 = _mm_set1_epi8(c1);
+	__m128i w2 = _mm_set1_epi8(c2);
+	__m128i w3 = _mm_set1_epi8(c3);
+	while (end - p >= 16) {
+		__m128i text = _mm_loadu_si128((const __m128i*)p);
+		__m128i hits = _mm_or_si128(_mm_cmpeq_epi8(text, w1),
+				_mm_or_si128(_mm_cmpeq_epi8(text, w2), _mm_cmpeq_epi8(text, w3)));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+		if (mask) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 16;
+	}
+#endif
+
+	while (p < end) {
+		if ((*p == c1) || (*p == c2) || (*p == c3)) {
+			return p;
+		}
+		p++;
+	}
+	return end;
+}
+
+
+
+//////////////////////////////
+//
+// HumFieldScanner::csvToTsv -- Convert the CSV record which starts at
+//     start into a tab-delimited line, and return a pointer to the start
+//     of the next record (or end).  Records end at a newline, and a
+//     carriage return before the newline is removed.  Quotes around
+//     text remove the special meaning of separators, and two quotes in
+//     a row inside of quotes give a single quote.  If a field starts
+//     with a quote, the quoted text can also contain newlines, which are
+//     changed into spaces since tokens cannot contain newlines.  Global
+//     comments and reference records (starting with "!!") are copied
+//     literally.  There is no limit to the length of a record.
+// default value: separator = "," (if the separator is empty)
+//
+
+const char* HumFieldScanner::csvToTsv(const char* start, const char* end,
+		const std::string& separator, std::string& output) {
+	output.clear();
+	if ((end - start >= 2) && (start[0] == '!') && (start[1] == '!')) {
+		const char* newline = HumFieldScanner::find(start, end, '\n');
+		output.assign(start, newline - start);
+		if (!output.empty() && (output.back() == 0x0d)) {
+			output.pop_back();
+		}
+		return newline < end ? newline + 1 : end;
+	}
+
+	static const std::string comma = ",";
+	const std::string& sep = separator.empty() ? comma : separator;
+	bool inquote    = false;   // inside of quoted text
+	bool fieldquote = false;   // quoted text started at the start of a field
+	bool fieldstart = true;    // no text in the current field yet
+	const char* p = start;
+	const char* stop = end;  // end of the record text
+	while (p < end) {
+		const char* q = HumFieldScanner::find(p, end, sep[0], '"', '\n');
+		if (q > p) {
+			output.append(p, q - p);
+			fieldstart = false;
+		}
+		if (q == end) {
+			p = end;
+			break;
+		}
+		if (*q == '\n') {
+			p = q + 1;
+			if (!(inquote && fieldquote)) {
+				stop = q;
+				break;
+			}
+			if ((q > start) && (q[-1] == 0x0d) && !output.empty()) {
+				output.pop_back();
+			}
+			output += ' ';
+		} else if (*q == '"') {
+			if (!inquote) {
+				inquote = true;
+				fieldquote = fieldstart;
+				p = q + 1;
+			} else if ((q + 1 < end) && (q[1] == '"')) {
+				output += '"';
+				fieldstart = false;
+				p = q + 2;
+			} else {
+				inquote = false;
+				fieldquote = false;
+				p = q + 1;
+			}
+		} else if (!inquote && ((size_t)(end - q) >= sep.size())
+				&& (sep.compare(0, sep.size(), q, sep.size()) == 0)) {
+			output += '\t';
+			fieldstart = true;
+			p = q + sep.size();
+		} else {
+			output += *q;
+			fieldstart = false;
+			p = q + 1;
+		}
+	}
+	// The carriage return is the last character added to the output,
+	// since it is not a special character:
+	if ((stop > start) && (stop[-1] == 0x0d) && !output.empty()) {
+		output.pop_back();
+	}
+	return p;
+}
+
+
+
+//////////////////////////////
+//
+// HumFieldScanner::getInstructionSet -- Return the name of the
+//     instructions used to scan text: "avx2", "sse2" or "scalar".
+//
+
+const char* HumFieldScanner::getInstructionSet(void) {
+#if defined(HUMLIB_AVX2)
+	return "avx2";
+#elif defined(HUMLIB_SSE2)
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -0,0 +1,74 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 23:15:41 UTC 2026
+// Last Modified: Fri Oct 16 23:15:41 UTC 2026
+// Filename:      HumFileAnalysis.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumFileAnalysis.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Analysis states for a Humdrum file.
+//
+
+#include "HumFileAnalysis.h"
+
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// HumFileAnalysis::getDependencies -- Return a bit mask of the analyses
+//     which have to be done before the given one.  Only the direct
+//     dependencies are listed: HumdrumFileBase::requireAnalysis() follows
+//     them recursively.
+//
+
+unsigned HumFileAnalysis::getDependencies(int type) {
+	switch (type) {
+		case Nulls:       return getMask(Strands);
+		case Strophes:    return getMask(Strands);
+		case Structure:   return getMask(Strands);
+		case Rhythm:      return getMask(Structure);
+		case Slurs:       return getMask(Rhythm);
+		case Phrases:     return getMask(Rhythm);
+		case Beams:       return getMask(Rhythm);
+		case Ties:        return getMask(Rhythm);
+		case Accidentals: return getMask(Rhythm);
+	}
+	return 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileAnalysis::getName -- Return the name of an analysis (for
+//     debugging and error messages).
+//
+
+const char* HumFileAnalysis::getName(int type) {
+	switch (type) {
+		case Strands:     return "strands";
+		case Nulls:       return "nulls";
+		case Strophes:    return "strophes";
+		case Structure:   return "structure";
+		case Rhythm:      return "rhythm";
+		case Barlines:    return "barlines";
+		case Slurs:       return "slurs";
+		case Phrases:     return "phrases";
+		case Beams:       return "beams";
+		case Ties:        return "ties";
+		case Accidentals: return "accidentals";
+	}
+	return "";
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -0,0 +1,325 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:44:01 UTC 2026
+// Last Modified: Sat Oct 17 10:21:28 UTC 2026
+// Filename:      HumFileCache.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumFileCache.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Least-recently-used cache of analyzed Humdrum files.
+//
+
+#include "HumFileCache.h"
+#include "HumPool.h"
+#include "HumdrumFile.h"
+
+#include <fstream>
+#include <sstream>
+
+#ifdef HUMLIB_MMAP
+	#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// HumFileCache::HumFileCache -- Set the maximum number of files in the
+//     cache.
+//
+
+HumFileCache::HumFileCache(int capacity) {
+	m_capacity = capacity < 0 ? 0 : capacity;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::~HumFileCache --
+//
+
+HumFileCache::~HumFileCache() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::read -- Read a file into infile, using the cached copy
+//     of the file if the file has not changed since it was cached.  The
+//     read analyses of infile (see HumdrumFileBase::setReadAnalyses()) are
+//     done on the file, and files in the cache which were read with other
+//     analyses are read again.  Returns false if the file cannot be read
+//     (or is not a regular file) or is not valid Humdrum data.
+//
+
+bool HumFileCache::read(HumdrumFile& infile, const string& filename) {
+	std::int64_t mtime;
+	std::int64_t size;
+	if (!getFileStatus(filename, mtime, size)) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_misses++;
+		}
+#ifdef HUMLIB_MMAP
+		// The file does not exist or is not a regular file:
+		infile.clear();
+		return false;
+#else
+		// The modification time cannot be checked, so do not cache the file:
+		infile.read(filename);
+		infile.setFilename(filename);
+		return infile.isValid();
+#endif
+	}
+
+	unsigned analyses = infile.getReadAnalyses();
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_index.find(filename);
+		if (it != m_index.end()) {
+			Entry& cached = **it->second;
+			if ((cached.mtime == mtime) && (cached.size == size) &&
+					(cached.analyses == analyses)) {
+				m_entries.splice(m_entries.begin(), m_entries, it->second);
+				entry = m_entries.front();
+			}
+		}
+		if (entry) {
+			m_hits++;
+		} else {
+			m_misses++;
+		}
+	}
+
+	if (entry) {
+		// The entry cannot change once it is in the cache, so it can be
+		// read without locking the cache.
+		infile.readSnapshot(entry->contents, entry->snapshot);
+		infile.setFilename(filename);
+		return infile.isValid();
+	}
+
+	entry = std::make_shared<Entry>();
+	entry->filename = filename;
+	entry->mtime    = mtime;
+	entry->size     = size;
+	entry->analyses = analyses;
+	if (!readContents(filename, entry->contents)) {
+		infile.clear();
+		return false;
+	}
+	infile.readString(entry->contents);
+	infile.setFilename(filename);
+	if (!infile.isValid()) {
+		return false;
+	}
+
+	// Do not cache the file if it changed while it was being read:
+	std::int64_t newmtime;
+	std::int64_t newsize;
+	if (!getFileStatus(filename, newmtime, newsize) || (newmtime != mtime) ||
+			(newsize != size) || (newsize != (std::int64_t)entry->contents.size())) {
+		return true;
+	}
+	if (!infile.writeSnapshot(entry->snapshot)) {
+		// The file will be analyzed each time that it is read from the cache.
+		entry->snapshot.clear();
+	}
+
+	int removed = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_capacity == 0) {
+			return true;
+		}
+		auto it = m_index.find(filename);
+		if (it != m_index.end()) {
+			m_entries.erase(it->second);
+		}
+		m_entries.push_front(entry);
+		m_index[filename] = m_entries.begin();
+		removed = trim();
+	}
+	if (removed) {
+		// The set of files being read is changing, so give the memory of
+		// files which have been deleted back to the system:
+		HumPool::trim();
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::clear -- Remove all files from the cache.
+//
+
+void HumFileCache::clear(void) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_entries.clear();
+		m_index.clear();
+	}
+	HumPool::trim();
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::setCapacity -- Set the maximum number of files in the
+//     cache, removing the least recently used files if there are too
+//     many.  A capacity of zero disables the cache.
+//
+
+void HumFileCache::setCapacity(int capacity) {
+	int removed = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_capacity = capacity < 0 ? 0 : capacity;
+		removed = trim();
+	}
+	if (removed) {
+		HumPool::trim();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getCapacity -- Return the maximum number of files in the
+//     cache.
+//
+
+int HumFileCache::getCapacity(void) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_capacity;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getSize -- Return the number of files in the cache.
+//
+
+int HumFileCache::getSize(void) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_entries.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getHitCount -- Return the number of reads which used a
+//     cached file.
+//
+
+std::uint64_t HumFileCache::getHitCount(void) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_hits;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getMissCount -- Return the number of reads which had to
+//     parse the file.
+//
+
+std::uint64_t HumFileCache::getMissCount(void) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_misses;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::trim -- Remove the least recently used files until the
+//     cache is not larger than its capacity.  The cache must be locked.
+//     Returns the number of files removed.
+//
+
+int HumFileCache::trim(void) {
+	int removed = 0;
+	while ((int)m_entries.size() > m_capacity) {
+		m_index.erase(m_entries.back()->filename);
+		m_entries.pop_back();
+		removed++;
+	}
+	return removed;
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::getFileStatus -- Get the modification time (in
+//     nanoseconds) and size of a regular file.  Returns false if the file
+//     does not exist, is not a regular file, or the status of files cannot
+//     be checked on this system.
+//
+
+bool HumFileCache::getFileStatus(const string& filename, std::int64_t& mtime,
+		std::int64_t& size) {
+	mtime = 0;
+	size = 0;
+#ifdef HUMLIB_MMAP
+	struct stat info;
+	if ((stat(filename.c_str(), &info) != 0) || !S_ISREG(info.st_mode)) {
+		return false;
+	}
+	mtime = (std::int64_t)info.st_mtime * 1000000000;
+	#if defined(__APPLE__)
+		mtime += info.st_mtimespec.tv_nsec;
+	#elif defined(__linux__)
+		mtime += info.st_mtim.tv_nsec;
+	#endif
+	size = (std::int64_t)info.st_size;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumFileCache::readContents -- Read the contents of a file into a string.
+//
+
+bool HumFileCache::readContents(const string& filename, string& contents) {
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		return false;
+	}
+	stringstream buffer;
+	buffer << input.rdbuf();
+	contents = buffer.str();
+	return true;
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -102,8 +102,10 @@
 #include "Convert.h"
 #include "HumHash.h"
 #include "HumNum.h"
+#include "HumdrumFile.h"
 #include "HumdrumToken.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -139,6 +141,16 @@ HumParameter::HumParameter(const string& str) : string(str) {
 
 HumHash::HumHash(void) {
 	parameters = NULL;
+	m_analysisRow = -1;
+	m_analysisOwner = NoAnalysisOwner;
+}
+
+
+HumHash::HumHash(const HumHash& hash) {
+	parameters = NULL;
+	m_analysisRow = -1;
+	m_analysisOwner = NoAnalysisOwner;
+	*this = hash;
 }
 
 
@@ -146,7 +158,9 @@ HumHash::HumHash(void) {
 //////////////////////////////
 //
 // HumHash::~HumHash -- The HumHash deconstructor, which removed any
-//    allocated storage before the object dies.
+//    allocated storage before the object dies.  Analysis values have to
+//    be removed by the deconstructor of the containing object, while
+//    the file which stores them can still be found.
 //
 
 HumHash::~HumHash() {
@@ -158,6 +172,322 @@ HumHash::~HumHash() {
 
 
 
+//////////////////////////////
+//
+// HumHash::operator= -- Copy the parameters of another HumHash.  Analysis
+//    values are copied to a new row if both objects are in the same
+//    file, and otherwise are copied as strings like other parameters.
+//
+
+HumHash& HumHash::operator=(const HumHash& hash) {
+	if (this == &hash) {
+		return *this;
+	}
+	clearParameters();
+	prefix = hash.prefix;
+	if (hash.m_analysisRow < 0) {
+		if (hash.parameters != NULL) {
+			parameters = new HumHashEntries(*hash.parameters);
+		}
+		return *this;
+	}
+	HumAnalysisStore* store = hash.findAnalysisStore(false);
+	if (store == findAnalysisStore(false)) {
+		if (hash.parameters != NULL) {
+			parameters = new HumHashEntries(*hash.parameters);
+		}
+		m_analysisRow = store->copyRow(hash.m_analysisRow);
+	} else {
+		HumHashEntries storage;
+		const HumHashEntries* view = hash.getParameterView(storage);
+		if (view != NULL) {
+			parameters = new HumHashEntries(*view);
+		}
+	}
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::clearParameters -- Remove all parameters (in all namespaces).
+//
+
+void HumHash::clearParameters(void) {
+	if (parameters != NULL) {
+		delete parameters;
+		parameters = NULL;
+	}
+	deleteAnalysisValues();
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::deleteAnalysisValues -- Remove the values in the "auto"
+//    namespace which are stored in the analysis store.
+//
+
+void HumHash::deleteAnalysisValues(void) {
+	if (m_analysisRow >= 0) {
+		findAnalysisStore(false)->releaseRow(m_analysisRow);
+		m_analysisRow = -1;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::detachAnalysisValues -- Move the values in the analysis store
+//    into the parameter list as strings.  This is done before a token or
+//    line is moved out of its file, since the values can only be found
+//    in the store of the file.
+//
+
+void HumHash::detachAnalysisValues(void) {
+	if (m_analysisRow < 0) {
+		return;
+	}
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view != parameters) {
+		if (parameters == NULL) {
+			parameters = new HumHashEntries;
+		}
+		parameters->swap(storage);
+	}
+	deleteAnalysisValues();
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::setAnalysisOwner -- Set the type of the object which contains
+//    the HumHash (see AnalysisOwnerType).  Called by the constructors of
+//    HumdrumToken, HumdrumLine and HumdrumFileBase.
+//
+
+void HumHash::setAnalysisOwner(int type) {
+	m_analysisOwner = type;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::findAnalysisStore -- Return the store for values in the "auto"
+//    namespace, which belongs to the file that the token, line or file
+//    containing the HumHash is part of.  The store is created if it does
+//    not exist yet and create is true.  Returns NULL for HumHash objects
+//    which are not part of a file: their analysis values are stored as
+//    strings like other parameters.
+//
+
+HumAnalysisStore* HumHash::findAnalysisStore(bool create) const {
+	HumdrumFileBase* infile = NULL;
+	switch (m_analysisOwner) {
+		case TokenAnalysisOwner:
+			{
+				HLp line = static_cast<const HumdrumToken*>(this)->getOwner();
+				if (line != NULL) {
+					infile = line->getOwner();
+				}
+			}
+			break;
+		case LineAnalysisOwner:
+			infile = const_cast<HumdrumLine*>(static_cast<const HumdrumLine*>(this))->getOwner();
+			break;
+		case FileAnalysisOwner:
+			infile = const_cast<HumdrumFileBase*>(static_cast<const HumdrumFileBase*>(this));
+			break;
+	}
+	if (infile == NULL) {
+		return NULL;
+	}
+	return infile->getAnalysisStore(create);
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::getAnalysisValue -- Return a value from the analysis store,
+//    or NULL if the parameter is not stored there.
+//
+
+const HumAnalysisValue* HumHash::getAnalysisValue(const string& ns1,
+		const string& ns2, const string& key) const {
+	if (m_analysisRow < 0) {
+		return NULL;
+	}
+	if (!HumAnalysisStore::isAnalysisNamespace(ns1, ns2)) {
+		return NULL;
+	}
+	const HumAnalysisStore* store = findAnalysisStore(false);
+	int keyindex = store->findKeyIndex(ns1, ns2, key);
+	return store->getValue(m_analysisRow, keyindex);
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::prepareAnalysisValue -- Returns the analysis store if the
+//    parameter should be stored there (or NULL if not), and sets the
+//    column index for the key.  A row is added to the store for the
+//    first analysis value.
+//
+
+HumAnalysisStore* HumHash::prepareAnalysisValue(const string& ns1, const string& ns2,
+		const string& key, int& keyindex) {
+	if (!HumAnalysisStore::isAnalysisNamespace(ns1, ns2)) {
+		return NULL;
+	}
+	HumAnalysisStore* store = findAnalysisStore(true);
+	if (store == NULL) {
+		return NULL;
+	}
+	if (m_analysisRow < 0) {
+		m_analysisRow = store->addRow();
+	}
+	keyindex = store->getKeyIndex(ns1, ns2, key);
+	return store;
+}
+
+
+
+//////////////////////////////
+//
+// isHumHashEntryLess -- Sort parameters by the names of their namespaces
+//    and key.
+//
+
+static bool isHumHashEntryLess(const HumHashEntry& a, const HumHashEntry& b) {
+	if (a.ns1 != b.ns1) {
+		return HumParameterName::getName(a.ns1) < HumParameterName::getName(b.ns1);
+	}
+	if (a.ns2 != b.ns2) {
+		return HumParameterName::getName(a.ns2) < HumParameterName::getName(b.ns2);
+	}
+	if (a.key != b.key) {
+		return HumParameterName::getName(a.key) < HumParameterName::getName(b.key);
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::getParameterView -- Return the parameters including the values
+//    in the analysis store.  If there are analysis values, the parameters
+//    are copied into the storage list in sorted order; otherwise the
+//    parameter list is returned directly (which may be NULL).
+//
+
+const HumHashEntries* HumHash::getParameterView(HumHashEntries& storage) const {
+	if (m_analysisRow < 0) {
+		return parameters;
+	}
+	const HumAnalysisStore& store = *findAnalysisStore(false);
+	if (store.getValueCount(m_analysisRow) == 0) {
+		return parameters;
+	}
+	if (parameters != NULL) {
+		storage = *parameters;
+	}
+	for (int i=0; i<store.getKeyCount(); i++) {
+		const HumAnalysisValue* value = store.getValue(m_analysisRow, i);
+		if (value == NULL) {
+			continue;
+		}
+		HumHashEntry entry;
+		entry.ns1 = HumParameterName::getId(store.getNamespace1(i));
+		entry.ns2 = HumParameterName::getId(store.getNamespace2(i));
+		entry.key = HumParameterName::getId(store.getKey(i));
+		entry.value = store.getString(*value);
+		bool found = false;
+		for (auto& item : storage) {
+			if ((item.key == entry.key) && (item.ns2 == entry.ns2) && (item.ns1 == entry.ns1)) {
+				item.value = entry.value;
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			storage.push_back(entry);
+		}
+	}
+	std::stable_sort(storage.begin(), storage.end(), isHumHashEntryLess);
+	return &storage;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::findParameter -- Return the index of a parameter in the
+//    parameter list, or -1 if it is not defined.  Analysis values are
+//    not searched.
+//
+
+int HumHash::findParameter(const string& ns1, const string& ns2,
+		const string& key) const {
+	if ((parameters == NULL) || parameters->empty()) {
+		return -1;
+	}
+	int keyid = HumParameterName::findId(key);
+	if (keyid == HumParameterName::Unknown) {
+		return -1;
+	}
+	int ns2id = HumParameterName::findId(ns2);
+	if (ns2id == HumParameterName::Unknown) {
+		return -1;
+	}
+	int ns1id = HumParameterName::findId(ns1);
+	if (ns1id == HumParameterName::Unknown) {
+		return -1;
+	}
+	const HumHashEntries& entries = *parameters;
+	for (int i=0; i<(int)entries.size(); i++) {
+		if ((entries[i].key == keyid) && (entries[i].ns2 == ns2id) && (entries[i].ns1 == ns1id)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumHash::insertParameter -- Return a parameter, adding an empty
+//    parameter in sorted order if it is not defined.
+//
+
+HumParameter& HumHash::insertParameter(const string& ns1, const string& ns2,
+		const string& key) {
+	int index = findParameter(ns1, ns2, key);
+	if (index >= 0) {
+		return (*parameters)[index].value;
+	}
+	initializeParameters();
+	HumHashEntry entry;
+	entry.ns1 = HumParameterName::getId(ns1);
+	entry.ns2 = HumParameterName::getId(ns2);
+	entry.key = HumParameterName::getId(key);
+	auto it = std::upper_bound(parameters->begin(), parameters->end(), entry,
+			isHumHashEntryLess);
+	it = parameters->insert(it, entry);
+	return it->value;
+}
+
+
+
 //////////////////////////////
 //
 // HumHash::getValue -- Returns the value specified by the given key.
@@ -172,7 +502,7 @@ HumHash::~HumHash() {
 //
 
 string HumHash::getValue(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return "";
 	} else {
 		vector<string> keys = getKeyList(key);
@@ -188,7 +518,7 @@ string HumHash::getValue(const string& key) const {
 
 
 string HumHash::getValue(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return "";
 	} else {
 		return getValue("", ns2, key);
@@ -198,23 +528,15 @@ string HumHash::getValue(const string& ns2, const string& key) const {
 
 string HumHash::getValue(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
-		return "";
+	const HumAnalysisValue* value = getAnalysisValue(ns1, ns2, key);
+	if (value != NULL) {
+		return findAnalysisStore(false)->getString(*value);
 	}
-	MapNNKV& p = *parameters;
-	auto it1 = p.find(ns1);
-	if (it1 == p.end()) {
+	int index = findParameter(ns1, ns2, key);
+	if (index < 0) {
 		return "";
 	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return "";
-	}
-	auto it3 = it2->second.find(key);
-	if (it3 == it2->second.end()) {
-		return "";
-	}
-	return it3->second;
+	return (*parameters)[index].value;
 }
 
 
@@ -226,12 +548,12 @@ string HumHash::getValue(const string& ns1, const string& ns2,
 //
 
 HTp HumHash::getValueHTp(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return NULL;
 	}
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return getValueHTp("", "", keys[2]);
+		return getValueHTp("", "", keys[0]);
 	} else if (keys.size() == 2) {
 		return getValueHTp(keys[0], keys[1]);
 	} else {
@@ -241,7 +563,7 @@ HTp HumHash::getValueHTp(const string& key) const {
 
 
 HTp HumHash::getValueHTp(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return NULL;
 	}
 	return getValueHTp("", ns2, key);
@@ -250,7 +572,11 @@ HTp HumHash::getValueHTp(const string& ns2, const string& key) const {
 
 HTp HumHash::getValueHTp(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if ((stored != NULL) && (stored->type == HumAnalysisValue::Token)) {
+		return stored->value.token;
+	}
+	if ((parameters == NULL) && (stored == NULL)) {
 		return NULL;
 	}
 	string value = getValue(ns1, ns2, key);
@@ -282,12 +608,12 @@ HTp HumHash::getValueHTp(const string& ns1, const string& ns2,
 //
 
 int HumHash::getValueInt(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0;
 	}
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return getValueInt("", "", keys[2]);
+		return getValueInt("", "", keys[0]);
 	} else if (keys.size() == 2) {
 		return getValueInt(keys[0], keys[1]);
 	} else {
@@ -297,7 +623,7 @@ int HumHash::getValueInt(const string& key) const {
 
 
 int HumHash::getValueInt(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0;
 	}
 	return getValueInt("", ns2, key);
@@ -306,7 +632,14 @@ int HumHash::getValueInt(const string& ns2, const string& key) const {
 
 int HumHash::getValueInt(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if (stored != NULL) {
+		if (stored->type == HumAnalysisValue::Integer) {
+			return stored->value.ints[0];
+		} else if (stored->type == HumAnalysisValue::Fraction) {
+			return HumNum(stored->value.ints[0], stored->value.ints[1]).getInteger();
+		}
+	} else if (parameters == NULL) {
 		return 0;
 	}
 	string value = getValue(ns1, ns2, key);
@@ -341,7 +674,7 @@ int HumHash::getValueInt(const string& ns1, const string& ns2,
 //
 
 HumNum HumHash::getValueFraction(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0;
 	}
 	vector<string> keys = getKeyList(key);
@@ -356,7 +689,7 @@ HumNum HumHash::getValueFraction(const string& key) const {
 
 
 HumNum HumHash::getValueFraction(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0;
 	}
 	return getValueFraction("", ns2, key);
@@ -365,8 +698,19 @@ HumNum HumHash::getValueFraction(const string& ns2, const string& key) const {
 
 HumNum HumHash::getValueFraction(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (!isDefined(ns1, ns2, key)) {
-		return 0;
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if (stored == NULL) {
+		if (!isDefined(ns1, ns2, key)) {
+			return 0;
+		}
+	} else if ((stored->type == HumAnalysisValue::Fraction)
+			|| (stored->type == HumAnalysisValue::Integer)) {
+		// Negative values are parsed from the text below, since the
+		// string parser for HumNum does not read a minus sign.
+		if (stored->value.ints[0] >= 0) {
+			int bot = (stored->type == HumAnalysisValue::Fraction) ? stored->value.ints[1] : 1;
+			return HumNum(stored->value.ints[0], bot);
+		}
 	}
 	string value = getValue(ns1, ns2, key);
 	HumNum fractionvalue(value);
@@ -387,12 +731,12 @@ HumNum HumHash::getValueFraction(const string& ns1, const string& ns2,
 //
 
 double HumHash::getValueFloat(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0.0;
 	}
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return getValueFloat("", "", keys[2]);
+		return getValueFloat("", "", keys[0]);
 	} else if (keys.size() == 2) {
 		return getValueFloat(keys[0], keys[1]);
 	} else {
@@ -402,16 +746,25 @@ double HumHash::getValueFloat(const string& key) const {
 
 
 double HumHash::getValueFloat(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return 0.0;
 	}
-	return getValueInt("", ns2, key);
+	return getValueFloat("", ns2, key);
 }
 
 
 double HumHash::getValueFloat(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if (stored != NULL) {
+		if (stored->type == HumAnalysisValue::Float) {
+			return stored->value.number;
+		} else if (stored->type == HumAnalysisValue::Integer) {
+			return stored->value.ints[0];
+		} else if (stored->type == HumAnalysisValue::Fraction) {
+			return (double)stored->value.ints[0] / stored->value.ints[1];
+		}
+	} else if (parameters == NULL) {
 		return 0.0;
 	}
 	string value = getValue(ns1, ns2, key);
@@ -446,7 +799,7 @@ double HumHash::getValueFloat(const string& ns1, const string& ns2,
 bool HumHash::getValueBool(const string& key) const {
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return getValueBool("", "", keys[2]);
+		return getValueBool("", "", keys[0]);
 	} else if (keys.size() == 2) {
 		return getValueBool(keys[0], keys[1]);
 	} else {
@@ -462,15 +815,23 @@ bool HumHash::getValueBool(const string& ns2, const string& key) const {
 
 bool HumHash::getValueBool(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
+	const HumAnalysisValue* stored = getAnalysisValue(ns1, ns2, key);
+	if (stored != NULL) {
+		if ((stored->type == HumAnalysisValue::Boolean) ||
+				(stored->type == HumAnalysisValue::Integer)) {
+			return stored->value.ints[0] != 0;
+		} else if (stored->type == HumAnalysisValue::Token) {
+			return true;
+		}
+	} else if (parameters == NULL) {
 		return false;
-	}
-	if (!isDefined(ns1, ns2, key)) {
+	} else if (!isDefined(ns1, ns2, key)) {
 		return false;
 	}
-	if ((*parameters)[ns1][ns2][key] == "false") {
+	string value = getValue(ns1, ns2, key);
+	if (value == "false") {
 		return false;
-	} else if ((*parameters)[ns1][ns2][key] == "0") {
+	} else if (value == "0") {
 		return false;
 	} else {
 		return true;
@@ -511,8 +872,13 @@ void HumHash::setValue(const string& ns2, const string& key,
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, const string& value) {
-	initializeParameters();
-	(*parameters)[ns1][ns2][key] = value;
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
+	insertParameter(ns1, ns2, key) = value;
 }
 
 
@@ -552,10 +918,15 @@ void HumHash::setValue(const string& ns2, const string& key, int value) {
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, int value) {
-	initializeParameters();
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
 	stringstream ss;
 	ss << value;
-	(*parameters)[ns1][ns2][key] = ss.str();
+	insertParameter(ns1, ns2, key) = ss.str();
 }
 
 
@@ -578,10 +949,15 @@ void HumHash::setValue(const string& ns2, const string& key, HTp value) {
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, HTp value) {
-	initializeParameters();
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
 	stringstream ss;
 	ss << "HT_" << ((long long)value);
-	(*parameters)[ns1][ns2][key] = ss.str();
+	insertParameter(ns1, ns2, key) = ss.str();
 }
 
 
@@ -604,10 +980,15 @@ void HumHash::setValue(const string& ns2, const string& key, HumNum value) {
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, HumNum value) {
-	initializeParameters();
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
 	stringstream ss;
 	ss << value;
-	(*parameters)[ns1][ns2][key] = ss.str();
+	insertParameter(ns1, ns2, key) = ss.str();
 }
 
 
@@ -630,10 +1011,15 @@ void HumHash::setValue(const string& ns2, const string& key, double value) {
 
 void HumHash::setValue(const string& ns1, const string& ns2,
 		const string& key, double value) {
-	initializeParameters();
+	int keyindex;
+	HumAnalysisStore* store = prepareAnalysisValue(ns1, ns2, key, keyindex);
+	if (store != NULL) {
+		store->setValue(m_analysisRow, keyindex, value);
+		return;
+	}
 	stringstream ss;
 	ss << value;
-	(*parameters)[ns1][ns2][key] = ss.str();
+	insertParameter(ns1, ns2, key) = ss.str();
 }
 
 
@@ -647,11 +1033,17 @@ void HumHash::setValue(const string& ns1, const string& ns2,
 
 map<string, string> HumHash::getParameters(const string& ns1, const string& ns2) {
 	map<string, string> output;
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return output;
 	}
-	for (auto& it : (*parameters)[ns1][ns2]) {
-		output[it.first] = it.second;
+	int ns1id = HumParameterName::findId(ns1);
+	int ns2id = HumParameterName::findId(ns2);
+	for (auto& entry : *view) {
+		if ((entry.ns1 == ns1id) && (entry.ns2 == ns2id)) {
+			output[HumParameterName::getName(entry.key)] = entry.value;
+		}
 	}
 	return output;
 }
@@ -659,7 +1051,7 @@ map<string, string> HumHash::getParameters(const string& ns1, const string& ns2)
 
 map<string, string> HumHash::getParameters(string& ns) {
 	map<string, string> output;
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return output;
 	}
 	auto loc = ns.find(":");
@@ -688,11 +1080,17 @@ map<string, string> HumHash::getParameters(string& ns) {
 
 vector<string> HumHash::getKeys(const string& ns1, const string& ns2) const {
 	vector<string> output;
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return output;
 	}
-	for (auto& it : (*parameters)[ns1][ns2]) {
-		output.push_back(it.first);
+	int ns1id = HumParameterName::findId(ns1);
+	int ns2id = HumParameterName::findId(ns2);
+	for (auto& entry : *view) {
+		if ((entry.ns1 == ns1id) && (entry.ns2 == ns2id)) {
+			output.push_back(HumParameterName::getName(entry.key));
+		}
 	}
 	return output;
 }
@@ -700,19 +1098,22 @@ vector<string> HumHash::getKeys(const string& ns1, const string& ns2) const {
 
 vector<string> HumHash::getKeys(const string& ns) const {
 	vector<string> output;
-	if (parameters == NULL) {
-		return output;
-	}
 	auto loc = ns.find(":");
 	if (loc != string::npos) {
 		string ns1 = ns.substr(0, loc);
 		string ns2 = ns.substr(loc+1);
 		return getKeys(ns1, ns2);
 	}
-
-	for (auto& it1 : (*parameters)[ns]) {
-		for (auto& it2 : it1.second) {
-			output.push_back(it1.first + ":" + it2.first);
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
+		return output;
+	}
+	int nsid = HumParameterName::findId(ns);
+	for (auto& entry : *view) {
+		if (entry.ns1 == nsid) {
+			output.push_back(HumParameterName::getName(entry.ns2) + ":"
+					+ HumParameterName::getName(entry.key));
 		}
 	}
 	return output;
@@ -721,15 +1122,15 @@ vector<string> HumHash::getKeys(const string& ns) const {
 
 vector<string> HumHash::getKeys(void) const {
 	vector<string> output;
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return output;
 	}
-	for (auto& it1 : (*parameters)) {
-		for (auto& it2 : it1.second) {
-			for (auto it3 : it2.second) {
-				output.push_back(it1.first + ":" + it2.first + ":" + it3.first);
-			}
-		}
+	for (auto& entry : *view) {
+		output.push_back(HumParameterName::getName(entry.ns1) + ":"
+				+ HumParameterName::getName(entry.ns2) + ":"
+				+ HumParameterName::getName(entry.key));
 	}
 	return output;
 }
@@ -747,62 +1148,23 @@ vector<string> HumHash::getKeys(void) const {
 //
 
 bool HumHash::hasParameters(const string& ns1, const string& ns2) const {
-	if (parameters == NULL) {
-		return false;
-	}
-	if (parameters->size() == 0) {
-		return false;
-	}
-	auto it1 = parameters->find(ns1);
-	if (it1 == parameters->end()) {
-		return false;
-	}
-	auto it2 = (*parameters)[ns1].find(ns2);
-	if (it2 == (*parameters)[ns1].end()) {
-		return false;
-	} else {
-		return true;
-	}
+	return getParameterCount(ns1, ns2) > 0;
 }
 
 
 bool HumHash::hasParameters(const string& ns) const {
-	if (parameters == NULL) {
-		return false;
-	}
-	auto loc = ns.find(":");
-	if (loc != string::npos) {
-		string ns1 = ns.substr(0, loc);
-		string ns2 = ns.substr(loc+1);
-		return hasParameters(ns1, ns2);
-	}
-
-	auto it = parameters->find(ns);
-	if (it == parameters->end()) {
-		return false;
-	} else {
-		return true;
-	}
+	return getParameterCount(ns) > 0;
 }
 
 
 bool HumHash::hasParameters(void) const {
-	if (parameters == NULL) {
-		return false;
+	if ((m_analysisRow >= 0) && (findAnalysisStore(false)->getValueCount(m_analysisRow) > 0)) {
+		return true;
 	}
-	if (parameters->size() == 0) {
+	if (parameters == NULL) {
 		return false;
 	}
-	for (auto& it1 : *parameters) {
-		for (auto& it2 : it1.second) {
-			if (it2.second.size() == 0) {
-				continue;
-			} else {
-				return true;
-			}
-		}
-	}
-	return false;
+	return !parameters->empty();
 }
 
 
@@ -819,61 +1181,53 @@ bool HumHash::hasParameters(void) const {
 //
 
 int HumHash::getParameterCount(const string& ns1, const string& ns2) const {
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return 0;
 	}
-	if (parameters->size() == 0) {
-		return 0;
-	}
-	auto it1 = parameters->find(ns1);
-	if (it1 == parameters->end()) {
-		return 0;
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return 0;
+	int ns1id = HumParameterName::findId(ns1);
+	int ns2id = HumParameterName::findId(ns2);
+	int sum = 0;
+	for (auto& entry : *view) {
+		if ((entry.ns1 == ns1id) && (entry.ns2 == ns2id)) {
+			sum++;
+		}
 	}
-	return (int)it2->second.size();
+	return sum;
 }
 
 
 int HumHash::getParameterCount(const string& ns) const {
-	if (parameters == NULL) {
-		return false;
-	}
 	auto loc = ns.find(":");
 	if (loc != string::npos) {
 		string ns1 = ns.substr(0, loc);
 		string ns2 = ns.substr(loc+1);
 		return getParameterCount(ns1, ns2);
 	}
-
-	auto it1 = parameters->find(ns);
-	if (it1 == parameters->end()) {
-		return false;
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
+		return 0;
 	}
+	int nsid = HumParameterName::findId(ns);
 	int sum = 0;
-	for (auto& it2 : it1->second) {
-		sum += (int)it2.second.size();
+	for (auto& entry : *view) {
+		if (entry.ns1 == nsid) {
+			sum++;
+		}
 	}
 	return sum;
 }
 
 
 int HumHash::getParameterCount(void) const {
-	if (parameters == NULL) {
-		return 0;
-	}
-	if (parameters->size() == 0) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return 0;
 	}
-	int sum = 0;
-	for (auto& it1 : (*parameters)) {
-		for (auto& it2 : it1.second) {
-			sum += (int)it2.second.size();
-		}
-	}
-	return sum;
+	return (int)view->size();
 }
 
 
@@ -887,34 +1241,31 @@ int HumHash::getParameterCount(void) const {
 //
 
 bool HumHash::isDefined(const string& key) const {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return false;
 	}
 	vector<string> keys = getKeyList(key);
 	if (keys.size() == 1) {
-		return (*parameters)[""][""].count(keys[0]) ? true : false;
+		return isDefined("", "", keys[0]);
 	} else if (keys.size() == 2) {
-		return (*parameters)[""][keys[0]].count(keys[1]) ? true : false;
+		return isDefined("", keys[0], keys[1]);
 	} else {
-		return (*parameters)[keys[0]][keys[1]].count(keys[2]) ? true : false;
+		return isDefined(keys[0], keys[1], keys[2]);
 	}
 }
 
 
 bool HumHash::isDefined(const string& ns2, const string& key) const {
-	if (parameters == NULL) {
-		return false;
-	}
-	return (*parameters)[""][ns2].count(key) ? true : false;
+	return isDefined("", ns2, key);
 }
 
 
 bool HumHash::isDefined(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
-		return false;
+	if (getAnalysisValue(ns1, ns2, key) != NULL) {
+		return true;
 	}
-	return (*parameters)[ns1][ns2].count(key) ? true : false;
+	return findParameter(ns1, ns2, key) >= 0;
 }
 
 
@@ -927,7 +1278,7 @@ bool HumHash::isDefined(const string& ns1, const string& ns2,
 //
 
 void HumHash::deleteValue(const string& key) {
-	if (parameters == NULL) {
+	if ((parameters == NULL) && (m_analysisRow < 0)) {
 		return;
 	}
 	vector<string> keys = getKeyList(key);
@@ -942,47 +1293,34 @@ void HumHash::deleteValue(const string& key) {
 
 
 void HumHash::deleteValue(const string& ns2, const string& key) {
-	if (parameters == NULL) {
-		return;
-	}
 	deleteValue("", ns2, key);
 }
 
 
 void HumHash::deleteValue(const string& ns1, const string& ns2,
 		const string& key) {
-	if (parameters == NULL) {
-		return;
-	}
-	(*parameters)[ns1][ns2].erase(key);
-
-	MapNNKV& p = *parameters;
-	auto it1 = p.find(ns1);
-	if (it1 == p.end()) {
-		return;
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return;
+	if ((m_analysisRow >= 0) && HumAnalysisStore::isAnalysisNamespace(ns1, ns2)) {
+		HumAnalysisStore* store = findAnalysisStore(false);
+		int keyindex = store->findKeyIndex(ns1, ns2, key);
+		store->deleteValue(m_analysisRow, keyindex);
 	}
-	auto it3 = it2->second.find(key);
-	if (it3 == it2->second.end()) {
-		return;
+	int index = findParameter(ns1, ns2, key);
+	if (index >= 0) {
+		parameters->erase(parameters->begin() + index);
 	}
-	it2->second.erase(key);
 }
 
 
 
 //////////////////////////////
 //
-// HumHash::initializeParameters -- Create the map structure if it does not
-//     already exist.
+// HumHash::initializeParameters -- Create the parameter list if it does
+//     not already exist.
 //
 
 void HumHash::initializeParameters(void) {
 	if (parameters == NULL) {
-		parameters = new MapNNKV;
+		parameters = new HumHashEntries;
 	}
 }
 
@@ -1079,23 +1417,10 @@ void HumHash::setOrigin(const string& ns2, const string& key,
 
 void HumHash::setOrigin(const string& ns1, const string& ns2,
 		const string& key, HumdrumToken* tok) {
-	if (parameters == NULL) {
-		return;
-	}
-	MapNNKV& p = *parameters;
-	auto it1 = p.find(ns1);
-	if (it1 == p.end()) {
-		return;
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
-		return;
-	}
-	auto it3 = it2->second.find(key);
-	if (it3 == it2->second.end()) {
-		return;
+	int index = findParameter(ns1, ns2, key);
+	if (index >= 0) {
+		(*parameters)[index].value.origin = tok;
 	}
-	it3->second.origin = tok;
 }
 
 
@@ -1139,23 +1464,11 @@ HumdrumToken* HumHash::getOrigin(const string& ns2, const string& key) const {
 
 HumdrumToken* HumHash::getOrigin(const string& ns1, const string& ns2,
 		const string& key) const {
-	if (parameters == NULL) {
-		return NULL;
-	}
-	MapNNKV& p = *parameters;
-	auto it1 = p.find(ns1);
-	if (it1 == p.end()) {
-		return NULL;
-	}
-	auto it2 = it1->second.find(ns2);
-	if (it2 == it1->second.end()) {
+	int index = findParameter(ns1, ns2, key);
+	if (index < 0) {
 		return NULL;
 	}
-	auto it3 = it2->second.find(key);
-	if (it3 == it2->second.end()) {
-		return NULL;
-	}
-	return it3->second.origin;
+	return (*parameters)[index].value.origin;
 }
 
 
@@ -1168,41 +1481,42 @@ HumdrumToken* HumHash::getOrigin(const string& ns1, const string& ns2,
 
 ostream& HumHash::printXml(ostream& out, int level, const string& indent) {
 
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return out;
 	}
-	if (parameters->size() == 0) {
+	if (view->size() == 0) {
 		return out;
 	}
+	const HumHashEntries& entries = *view;
 
 	stringstream str;
 	bool found = 0;
 
 	HumdrumToken* ref = NULL;
 	level++;
-	for (auto& it1 : *(parameters)) {
-		if (it1.second.size() == 0) {
-			continue;
-		}
+	int i = 0;
+	while (i < (int)entries.size()) {
+		int ns1 = entries[i].ns1;
 		if (!found) {
 			found = 1;
 		}
 		str << Convert::repeatString(indent, level++);
-		str << "<namespace n=\"1\" name=\"" << it1.first << "\">\n";
-		for (auto& it2 : it1.second) {
-			if (it2.second.size() == 0) {
-				continue;
-			}
+		str << "<namespace n=\"1\" name=\"" << HumParameterName::getName(ns1) << "\">\n";
+		while ((i < (int)entries.size()) && (entries[i].ns1 == ns1)) {
+			int ns2 = entries[i].ns2;
 
 			str << Convert::repeatString(indent, level++);
-			str << "<namespace n=\"2\" name=\"" << it2.first << "\">\n";
+			str << "<namespace n=\"2\" name=\"" << HumParameterName::getName(ns2) << "\">\n";
 
-			for (auto& it3 : it2.second) {
+			for (; (i < (int)entries.size()) && (entries[i].ns1 == ns1) &&
+					(entries[i].ns2 == ns2); i++) {
 				str << Convert::repeatString(indent, level);
-				str << "<parameter key=\"" << it3.first << "\"";
+				str << "<parameter key=\"" << HumParameterName::getName(entries[i].key) << "\"";
 				str << " value=\"";
-				str << Convert::encodeXml(it3.second) << "\"";
-				ref = it3.second.origin;
+				str << Convert::encodeXml(entries[i].value) << "\"";
+				ref = entries[i].value.origin;
 				if (ref != NULL) {
 					str << " idref=\"";
 					str << ref->getXmlId();
@@ -1234,12 +1548,15 @@ ostream& HumHash::printXml(ostream& out, int level, const string& indent) {
 ostream& HumHash::printXmlAsGlobal(ostream& out, int level,
 		const string& indent) {
 
-	if (parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = getParameterView(storage);
+	if (view == NULL) {
 		return out;
 	}
-	if (parameters->size() == 0) {
+	if (view->size() == 0) {
 		return out;
 	}
+	const HumHashEntries& entries = *view;
 
 	stringstream str;
 	stringstream str2;
@@ -1250,48 +1567,48 @@ ostream& HumHash::printXmlAsGlobal(ostream& out, int level,
 
 	HumdrumToken* ref = NULL;
 	level++;
-	for (auto& it1 : *(parameters)) {
-		if (it1.second.size() == 0) {
-			continue;
-		}
+	int i = 0;
+	while (i < (int)entries.size()) {
+		int ns1 = entries[i].ns1;
 		str2.str("");
-		it1str = it1.first;
+		it1str = HumParameterName::getName(ns1);
 		if (!found) {
 			found = 1;
 		}
-		if (it1.first == "") {
+		if (it1str == "") {
 			str2 << Convert::repeatString(indent, level++);
-			str2 << "<namespace n=\"1\" name=\"" << it1.first << "\">\n";
+			str2 << "<namespace n=\"1\" name=\"" << it1str << "\">\n";
 		} else {
 			str << Convert::repeatString(indent, level++);
-			str << "<namespace n=\"1\" name=\"" << it1.first << "\">\n";
+			str << "<namespace n=\"1\" name=\"" << it1str << "\">\n";
 		}
-		for (auto& it2 : it1.second) {
-			if (it2.second.size() == 0) {
-				continue;
-			}
-			it2str = it2.first;
+		while ((i < (int)entries.size()) && (entries[i].ns1 == ns1)) {
+			int ns2 = entries[i].ns2;
+			it2str = HumParameterName::getName(ns2);
 
-			if ((it2.first == "") && (it2.first == "")) {
+			if (it2str == "") {
 				str2 << Convert::repeatString(indent, level++);
-				str2 << "<namespace n=\"2\" name=\"" << it2.first << "\">\n";
+				str2 << "<namespace n=\"2\" name=\"" << it2str << "\">\n";
 			} else {
 				str << Convert::repeatString(indent, level++);
-				str << "<namespace n=\"2\" name=\"" << it2.first << "\">\n";
+				str << "<namespace n=\"2\" name=\"" << it2str << "\">\n";
 			}
 
-			for (auto& it3 : it2.second) {
-				if ((it2.first == "") && (it2.first == "")) {
+			for (; (i < (int)entries.size()) && (entries[i].ns1 == ns1) &&
+					(entries[i].ns2 == ns2); i++) {
+				const string& key = HumParameterName::getName(entries[i].key);
+				const HumParameter& value = entries[i].value;
+				if (it2str == "") {
 
-					if ((it3.first == "global") && (it3.second == "true")) {
+					if ((key == "global") && (value == "true")) {
 						// don't do anything because parameter should be removed
 					} else {
 						str2count++;
 						str2 << Convert::repeatString(indent, level);
-						str2 << "<parameter key=\"" << it3.first << "\"";
+						str2 << "<parameter key=\"" << key << "\"";
 						str2 << " value=\"";
-						str2 << Convert::encodeXml(it3.second) << "\"";
-						ref = it3.second.origin;
+						str2 << Convert::encodeXml(value) << "\"";
+						ref = value.origin;
 						if (ref != NULL) {
 							str2 << " idref=\"";
 							str2 << ref->getXmlId();
@@ -1301,10 +1618,10 @@ ostream& HumHash::printXmlAsGlobal(ostream& out, int level,
 					}
 				} else {
 					str << Convert::repeatString(indent, level);
-					str << "<parameter key=\"" << it3.first << "\"";
+					str << "<parameter key=\"" << key << "\"";
 					str << " value=\"";
-					str << Convert::encodeXml(it3.second) << "\"";
-					ref = it3.second.origin;
+					str << Convert::encodeXml(value) << "\"";
+					ref = value.origin;
 					if (ref != NULL) {
 						str << " idref=\"";
 						str << ref->getXmlId();
@@ -1347,35 +1664,34 @@ ostream& HumHash::printXmlAsGlobal(ostream& out, int level,
 //
 
 ostream& operator<<(ostream& out, const HumHash& hash) {
-	if (hash.parameters == NULL) {
+	HumHashEntries storage;
+	const HumHashEntries* view = hash.getParameterView(storage);
+	if (view == NULL) {
 		return out;
 	}
-	if (hash.parameters->size() == 0) {
+	if (view->size() == 0) {
 		return out;
 	}
+	const HumHashEntries& entries = *view;
 
 	string cleaned;
 
-	for (auto& it1 : *(hash.parameters)) {
-		if (it1.second.size() == 0) {
-			continue;
-		}
-		for (auto& it2 : it1.second) {
-			if (it2.second.size() == 0) {
-				continue;
-			}
-			out << hash.prefix;
-			out << it1.first << ":" << it2.first;
-			for (auto& it3 : it2.second) {
-				out << ":" << it3.first;
-				if (it3.second != "true") {
-					cleaned = it3.second;
-					Convert::replaceOccurrences(cleaned, ":", "&colon;");
-					out << "=" << cleaned;
-				}
+	int i = 0;
+	while (i < (int)entries.size()) {
+		int ns1 = entries[i].ns1;
+		int ns2 = entries[i].ns2;
+		out << hash.prefix;
+		out << HumParameterName::getName(ns1) << ":" << HumParameterName::getName(ns2);
+		for (; (i < (int)entries.size()) && (entries[i].ns1 == ns1) &&
+				(entries[i].ns2 == ns2); i++) {
+			out << ":" << HumParameterName::getName(entries[i].key);
+			if (entries[i].value != "true") {
+				cleaned = entries[i].value;
+				Convert::replaceOccurrences(cleaned, ":", "&colon;");
+				out << "=" << cleaned;
 			}
-			out << endl;
 		}
+		out << endl;
 	}
 
 	return out;
@@ -25,7 +25,7 @@ typedef unsigned long long TEMP64BITFIX;
 
 // declare static variables
 vector<_HumInstrument> HumInstrument::m_data;
-int HumInstrument::m_classcount = 0;
+std::once_flag HumInstrument::m_initialized;
 
 
 //////////////////////////////
@@ -34,10 +34,9 @@ int HumInstrument::m_classcount = 0;
 //
 
 HumInstrument::HumInstrument(void) {
-	if (m_classcount == 0) {
-		initialize();
-	}
-	m_classcount++;
+	// The instrument table is shared by all objects, which may be created
+	// in different threads:
+	std::call_once(m_initialized, &HumInstrument::initialize, this);
 	m_index = -1;
 }
 
@@ -49,9 +48,7 @@ HumInstrument::HumInstrument(void) {
 //
 
 HumInstrument::HumInstrument(const string& Hname) {
-	if (m_classcount == 0) {
-		initialize();
-	}
+	std::call_once(m_initialized, &HumInstrument::initialize, this);
 
 	m_index = find(Hname);
 }
@@ -0,0 +1,299 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 22:43:53 UTC 2026
+// Last Modified: Sat Oct 17 11:47:12 UTC 2026
+// Filename:      HumKernRecord.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumKernRecord.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Decoded contents of a **kern token.
+//
+
+#include "Convert.h"
+#include "HumKernRecord.h"
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// incrementKernCount -- Add one to a marker count, stopping at the
+//     largest value which can be stored.
+//
+
+static void incrementKernCount(unsigned char& count) {
+	if (count < 255) {
+		count++;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKernNote::getBase40Pitch -- Return the base-40 pitch of the note,
+//     0 for a rest, or a negative value for a secondary tied note.
+//
+
+int HumKernNote::getBase40Pitch(void) const {
+	if (isRest()) {
+		return 0;
+	}
+	return isSecondaryTie() ? -base40 : base40;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernNote::getMidiPitch -- Return the MIDI note number of the note,
+//     0 for a rest, or a negative value for a secondary tied note.
+//
+
+int HumKernNote::getMidiPitch(void) const {
+	if (isRest()) {
+		return 0;
+	}
+	return isSecondaryTie() ? -midi : midi;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::HumKernRecord -- Decode the text of a token.  Notes
+//     in a chord are separated by spaces (empty subtokens are ignored
+//     in the same way as HumdrumToken::getSubtokens()).
+//
+
+HumKernRecord::HumKernRecord(const std::string& text) {
+	HumKernNote total;
+	parseNote(total, text);
+	m_flags        = total.flags;
+	m_slurStarts   = total.slurStarts;
+	m_slurEnds     = total.slurEnds;
+	m_phraseStarts = total.phraseStarts;
+	m_phraseEnds   = total.phraseEnds;
+	m_beamStarts   = total.beamStarts;
+	m_beamEnds     = total.beamEnds;
+	m_chord        = text.find(' ') != std::string::npos;
+	m_size         = text.size();
+	m_hash         = getTextHash(text);
+
+	if (!m_chord) {
+		if (!text.empty()) {
+			m_notes.push_back(total);
+			m_notes.back().duration = Convert::recipToDuration(text);
+		}
+		return;
+	}
+
+	std::string::size_type start = 0;
+	while (start < text.size()) {
+		std::string::size_type pos = text.find(' ', start);
+		if (pos == std::string::npos) {
+			pos = text.size();
+		}
+		if (pos > start) {
+			std::string subtoken = text.substr(start, pos - start);
+			m_notes.emplace_back();
+			HumKernNote& note = m_notes.back();
+			parseNote(note, subtoken);
+			note.duration = Convert::recipToDuration(subtoken);
+		}
+		start = pos + 1;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::isRecordOf -- Returns true if the record was made from
+//     the given text (compared by length and hash).
+//
+
+bool HumKernRecord::isRecordOf(const std::string& text) const {
+	return (text.size() == m_size) && (getTextHash(text) == m_hash);
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::getTextHash -- Return the 64-bit FNV-1a hash of a text.
+//
+
+uint64_t HumKernRecord::getTextHash(const std::string& text) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char ch : text) {
+		hash = (hash ^ ch) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::parseNote -- Set the pitch, flags and marker counts of
+//     a note from its text.  The pitch is calculated in the same way
+//     as Convert::kernToBase40() and Convert::kernToMidiNoteNumber(),
+//     but in a single pass.  Duration is filled in by the caller.
+//
+
+void HumKernRecord::parseNote(HumKernNote& note, const std::string& text) {
+	static const int base40pc[7] = { 2, 8, 14, 19, 25, 31, 37 };
+	static const int base12pc[7] = { 0, 2,  4,  5,  7,  9, 11 };
+	int diatonic = -2000;
+	int accid    = 0;
+	int upper    = 0;
+	int lower    = 0;
+	char lastch  = '\0';
+	for (int i=0; i<(int)text.size(); i++) {
+		char ch = text[i];
+		if ((ch >= 'a') && (ch <= 'g')) {
+			lower++;
+			if (diatonic == -2000) {
+				diatonic = (ch - 'a' + 5) % 7;
+			}
+		} else if ((ch >= 'A') && (ch <= 'G')) {
+			upper++;
+			if (diatonic == -2000) {
+				diatonic = (ch - 'A' + 5) % 7;
+			}
+		}
+		switch (ch) {
+			case '#': accid++;                                 break;
+			case '-': accid--;                                 break;
+			case 'r': note.flags |= HumKernNote::Rest;        break;
+			case 'R': note.flags |= HumKernNote::Unpitched;   break;
+			case 'q': note.flags |= HumKernNote::Grace;       break;
+			case '[': note.flags |= HumKernNote::TieStart;    break;
+			case '_': note.flags |= HumKernNote::TieContinue; break;
+			case ']': note.flags |= HumKernNote::TieEnd;      break;
+			case 'k':
+			case 'K': note.flags |= HumKernNote::PartialBeam; break;
+			case '.': incrementKernCount(note.dots);          break;
+			case '(': incrementKernCount(note.slurStarts);    break;
+			case ')': incrementKernCount(note.slurEnds);      break;
+			case '{': incrementKernCount(note.phraseStarts);  break;
+			case '}': incrementKernCount(note.phraseEnds);    break;
+			case 'L': incrementKernCount(note.beamStarts);    break;
+			case 'J': incrementKernCount(note.beamEnds);      break;
+			case 'y':
+				if (lastch == 'y') {
+					note.flags |= HumKernNote::Invisible;
+				}
+				break;
+		}
+		lastch = ch;
+	}
+
+	if (upper || lower) {
+		note.flags |= HumKernNote::PitchLetter;
+	}
+	if (note.isRest()) {
+		return;
+	}
+	int octave = -1000;
+	if (upper && !lower) {
+		octave = 4 - upper;
+	} else if (lower && !upper) {
+		octave = 3 + lower;
+	}
+	if (diatonic < 0) {
+		note.base40 = diatonic;
+		note.midi   = diatonic + 12 * (octave + 1);
+	} else {
+		note.base40 = base40pc[diatonic] + accid + 40 * octave;
+		note.midi   = base12pc[diatonic] + accid + 12 * (octave + 1);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::isNote -- True if the token has a pitch and is not a
+//     rest (same as Convert::isKernNote()).
+//
+
+bool HumKernRecord::isNote(void) const {
+	if (m_flags & HumKernNote::Rest) {
+		return false;
+	}
+	return m_flags & HumKernNote::PitchLetter;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::isSecondaryTiedNote -- True if the token is a note
+//     with a '_' or ']' (same as Convert::isKernSecondaryTiedNote()).
+//
+
+bool HumKernRecord::isSecondaryTiedNote(void) const {
+	if (!isNote()) {
+		return false;
+	}
+	return m_flags & (HumKernNote::TieContinue | HumKernNote::TieEnd);
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::hasBeam -- True if the token has L, J, K, or k.
+//
+
+bool HumKernRecord::hasBeam(void) const {
+	if (m_beamStarts || m_beamEnds) {
+		return true;
+	}
+	return m_flags & HumKernNote::PartialBeam;
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::getBase40Pitches -- Return the base-40 pitch of each
+//     note, with 0 for rests and negative values for secondary tied notes.
+//
+
+void HumKernRecord::getBase40Pitches(std::vector<int>& output) const {
+	output.resize(m_notes.size());
+	for (int i=0; i<(int)m_notes.size(); i++) {
+		output[i] = m_notes[i].getBase40Pitch();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumKernRecord::getMidiPitches -- Return the MIDI note number of each
+//     note, with 0 for rests and negative values for secondary tied notes.
+//
+
+void HumKernRecord::getMidiPitches(std::vector<int>& output) const {
+	output.resize(m_notes.size());
+	for (int i=0; i<(int)m_notes.size(); i++) {
+		output[i] = m_notes[i].getMidiPitch();
+	}
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -16,12 +16,49 @@
 
 #include "HumNum.h"
 
+#include <climits>
+
 using namespace std;
 
 namespace hum {
 
 // START_MERGE
 
+thread_local bool HumNum::m_overflow = false;
+
+
+//////////////////////////////
+//
+// isHumNumPowerOfTwo -- Returns true if the value is a positive power
+//     of two (including 1).
+//
+
+static inline bool isHumNumPowerOfTwo(int64_t value) {
+	return (value > 0) && !(value & (value - 1));
+}
+
+
+
+//////////////////////////////
+//
+// getHumNumTrailingZeros -- Returns the number of trailing zero bits
+//     in a non-zero value.
+//
+
+static inline int getHumNumTrailingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(value);
+#else
+	int count = 0;
+	while (!(value & 1)) {
+		value >>= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+
 //////////////////////////////
 //
 // HumNum::HumNum -- HumNum Constructor.  Set the default value
@@ -222,9 +259,7 @@ void HumNum::setValue(int numerator) {
 
 
 void HumNum::setValue(int numerator, int denominator) {
-	top = numerator;
-	bot = denominator;
-	reduce();
+	setReduced(numerator, denominator);
 }
 
 
@@ -305,24 +340,105 @@ HumNum& HumNum::makeAbs(void) {
 //
 
 void HumNum::reduce(void) {
-	int a = getNumerator();
-	int b = getDenominator();
-	if (a == 1 || b == 1) {
-		return;
+	setReduced(top, bot);
+}
+
+
+
+//////////////////////////////
+//
+// HumNum::setReduced -- Store the reduced form of a fraction which was
+//    calculated with 64-bit integers.  Denominators which are powers of
+//    two (the usual case for durations) are reduced by removing common
+//    factors of two rather than calculating a GCD.  If the reduced
+//    fraction does not fit into 32-bit integers, it is approximated by
+//    dropping low bits of both numbers, and the overflow flag is set
+//    (see hasOverflow()).
+//
+
+void HumNum::setReduced(int64_t a, int64_t b) {
+	if ((a == 1) || (b == 1) || (b == 0)) {
+		// nothing to reduce (infinite values are not reduced)
+	} else if (a == 0) {
+		b = 1;
+	} else if (isHumNumPowerOfTwo(b)) {
+		int shift = getHumNumTrailingZeros((uint64_t)a);
+		int bshift = getHumNumTrailingZeros((uint64_t)b);
+		if (bshift < shift) {
+			shift = bshift;
+		}
+		a >>= shift;
+		b >>= shift;
+	} else {
+		int64_t gcdval = gcd64(a, b);
+		if (gcdval > 1) {
+			a /= gcdval;
+			b /= gcdval;
+		}
 	}
-	if (a == 0) {
-		bot = 1;
-		return;
+	if ((a < INT_MIN) || (a > INT_MAX) || (b < INT_MIN) || (b > INT_MAX)) {
+		m_overflow = true;
+		while ((a < INT_MIN) || (a > INT_MAX) || (b < INT_MIN) || (b > INT_MAX)) {
+			a /= 2;
+			b /= 2;
+		}
 	}
-	if (b == 0) {
-		a = 0;
-		b = 0;
+	top = (int)a;
+	bot = (int)b;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum::hasOverflow -- Returns true if a calculation in the current
+//    thread gave a result which did not fit into 32-bit integers since
+//    the last call to clearOverflow().  File analyses which calculate
+//    durations check this and report overflows as parse errors.
+//
+
+bool HumNum::hasOverflow(void) {
+	return m_overflow;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum::clearOverflow -- Clear the overflow flag of the current thread.
+//
+
+void HumNum::clearOverflow(void) {
+	m_overflow = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumNum::gcd64 -- Returns the (non-negative) greatest common divisor of
+//      two 64-bit numbers, using 32-bit division when both fit.
+//
+
+int64_t HumNum::gcd64(int64_t a, int64_t b) {
+	uint64_t x = a < 0 ? -(uint64_t)a : (uint64_t)a;
+	uint64_t y = b < 0 ? -(uint64_t)b : (uint64_t)b;
+	if ((x | y) <= UINT_MAX) {
+		uint32_t x32 = (uint32_t)x;
+		uint32_t y32 = (uint32_t)y;
+		while (y32) {
+			uint32_t c = x32 % y32;
+			x32 = y32;
+			y32 = c;
+		}
+		return x32;
 	}
-	int gcdval = gcdIterative(a, b);
-	if (gcdval > 1) {
-		top /= gcdval;
-		bot /= gcdval;
+	while (y) {
+		uint64_t c = x % y;
+		x = y;
+		y = c;
 	}
+	return (int64_t)x;
 }
 
 
@@ -436,19 +552,29 @@ bool HumNum::isPowerOfTwo(void) const {
 //
 
 HumNum HumNum::operator+(const HumNum& value) const {
-	int a1  = getNumerator();
-	int b1  = getDenominator();
-	int a2  = value.getNumerator();
-	int b2  = value.getDenominator();
-	int ao = a1*b2 + a2 * b1;
-	int bo = b1*b2;
-	HumNum output(ao, bo);
+	int64_t a1 = top;
+	int64_t b1 = bot;
+	int64_t a2 = value.top;
+	int64_t b2 = value.bot;
+	HumNum output;
+	if ((b1 == b2) && (b1 > 0)) {
+		output.setReduced(a1 + a2, b1);
+	} else if (isHumNumPowerOfTwo(b1) && isHumNumPowerOfTwo(b2)) {
+		if (b1 > b2) {
+			output.setReduced(a1 + a2 * (b1 / b2), b1);
+		} else {
+			output.setReduced(a1 * (b2 / b1) + a2, b2);
+		}
+	} else {
+		output.setReduced(a1 * b2 + a2 * b1, b1 * b2);
+	}
 	return output;
 }
 
 
 HumNum HumNum::operator+(int value) const {
-	HumNum output(value * bot + top, bot);
+	HumNum output;
+	output.setReduced((int64_t)value * bot + top, bot);
 	return output;
 }
 
@@ -462,19 +588,29 @@ HumNum HumNum::operator+(int value) const {
 //
 
 HumNum HumNum::operator-(const HumNum& value) const {
-	int a1  = getNumerator();
-	int b1  = getDenominator();
-	int a2  = value.getNumerator();
-	int b2  = value.getDenominator();
-	int ao = a1*b2 - a2*b1;
-	int bo = b1*b2;
-	HumNum output(ao, bo);
+	int64_t a1 = top;
+	int64_t b1 = bot;
+	int64_t a2 = value.top;
+	int64_t b2 = value.bot;
+	HumNum output;
+	if ((b1 == b2) && (b1 > 0)) {
+		output.setReduced(a1 - a2, b1);
+	} else if (isHumNumPowerOfTwo(b1) && isHumNumPowerOfTwo(b2)) {
+		if (b1 > b2) {
+			output.setReduced(a1 - a2 * (b1 / b2), b1);
+		} else {
+			output.setReduced(a1 * (b2 / b1) - a2, b2);
+		}
+	} else {
+		output.setReduced(a1 * b2 - a2 * b1, b1 * b2);
+	}
 	return output;
 }
 
 
 HumNum HumNum::operator-(int value) const {
-	HumNum output(top - value * bot, bot);
+	HumNum output;
+	output.setReduced(top - (int64_t)value * bot, bot);
 	return output;
 }
 
@@ -487,7 +623,8 @@ HumNum HumNum::operator-(int value) const {
 //
 
 HumNum HumNum::operator-(void) const {
-	HumNum output(-top, bot);
+	HumNum output;
+	output.setReduced(-(int64_t)top, bot);
 	return output;
 }
 
@@ -500,19 +637,15 @@ HumNum HumNum::operator-(void) const {
 //
 
 HumNum HumNum::operator*(const HumNum& value) const {
-	int a1  = getNumerator();
-	int b1  = getDenominator();
-	int a2  = value.getNumerator();
-	int b2  = value.getDenominator();
-	int ao = a1*a2;
-	int bo = b1*b2;
-	HumNum output(ao, bo);
+	HumNum output;
+	output.setReduced((int64_t)top * value.top, (int64_t)bot * value.bot);
 	return output;
 }
 
 
 HumNum HumNum::operator*(int value) const {
-	HumNum output(top * value, bot);
+	HumNum output;
+	output.setReduced((int64_t)top * value, bot);
 	return output;
 }
 
@@ -525,27 +658,23 @@ HumNum HumNum::operator*(int value) const {
 //
 
 HumNum HumNum::operator/(const HumNum& value) const {
-	int a1  = getNumerator();
-	int b1  = getDenominator();
-	int a2  = value.getNumerator();
-	int b2  = value.getDenominator();
-	int ao = a1*b2;
-	int bo = b1*a2;
-	HumNum output(ao, bo);
+	HumNum output;
+	output.setReduced((int64_t)top * value.bot, (int64_t)bot * value.top);
 	return output;
 }
 
 
 HumNum HumNum::operator/(int value) const {
-	int a  = getNumerator();
-	int b  = getDenominator();
+	int64_t a = top;
+	int64_t b = bot;
 	if (value < 0) {
 		a = -a;
-		b *= -value;
+		b *= -(int64_t)value;
 	} else {
 		b *= value;
 	}
-	HumNum output(a, b);
+	HumNum output;
+	output.setReduced(a, b);
 	return output;
 }
 
@@ -558,10 +687,9 @@ HumNum HumNum::operator/(int value) const {
 //
 
 HumNum& HumNum::operator=(const HumNum& value) {
-	if (this == &value) {
-		return *this;
-	}
-	setValue(value.top, value.bot);
+	// HumNums are always stored in reduced form.
+	top = value.top;
+	bot = value.bot;
 	return *this;
 }
 
@@ -655,11 +783,17 @@ bool HumNum::operator<(const HumNum& value) const {
 	if (this == &value) {
 		return false;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot < (int64_t)value.top * bot;
+	}
 	return getFloat() < value.getFloat();
 }
 
 
 bool HumNum::operator<(int value) const {
+	if (bot > 0) {
+		return top < (int64_t)value * bot;
+	}
 	return getFloat() < value;
 }
 
@@ -680,11 +814,17 @@ bool HumNum::operator<=(const HumNum& value) const {
 	if (this == &value) {
 		return true;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot <= (int64_t)value.top * bot;
+	}
 	return getFloat() <= value.getFloat();
 }
 
 
 bool HumNum::operator<=(int value) const {
+	if (bot > 0) {
+		return top <= (int64_t)value * bot;
+	}
 	return getFloat() <= value;
 }
 
@@ -705,11 +845,17 @@ bool HumNum::operator>(const HumNum& value) const {
 	if (this == &value) {
 		return false;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot > (int64_t)value.top * bot;
+	}
 	return getFloat() > value.getFloat();
 }
 
 
 bool HumNum::operator>(int value) const {
+	if (bot > 0) {
+		return top > (int64_t)value * bot;
+	}
 	return getFloat() > value;
 }
 
@@ -730,11 +876,17 @@ bool HumNum::operator>=(const HumNum& value) const {
 	if (this == &value) {
 		return true;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot >= (int64_t)value.top * bot;
+	}
 	return getFloat() >= value.getFloat();
 }
 
 
 bool HumNum::operator>=(int value) const {
+	if (bot > 0) {
+		return top >= (int64_t)value * bot;
+	}
 	return getFloat() >= value;
 }
 
@@ -755,11 +907,17 @@ bool HumNum::operator==(const HumNum& value) const {
 	if (this == &value) {
 		return true;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot == (int64_t)value.top * bot;
+	}
 	return getFloat() == value.getFloat();
 }
 
 
 bool HumNum::operator==(int value) const {
+	if (bot > 0) {
+		return top == (int64_t)value * bot;
+	}
 	return getFloat() == value;
 }
 
@@ -780,11 +938,17 @@ bool HumNum::operator!=(const HumNum& value) const {
 	if (this == &value) {
 		return false;
 	}
+	if ((bot > 0) && (value.bot > 0)) {
+		return (int64_t)top * value.bot != (int64_t)value.top * bot;
+	}
 	return getFloat() != value.getFloat();
 }
 
 
 bool HumNum::operator!=(int value) const {
+	if (bot > 0) {
+		return top != (int64_t)value * bot;
+	}
 	return getFloat() != value;
 }
 
@@ -0,0 +1,264 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 07:03:47 UTC 2026
+// Last Modified: Sat Oct 17 11:47:16 UTC 2026
+// Filename:      HumParameterName.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumParameterName.cpp
+// Syntax:        C++17; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Symbol table for HumHash namespaces and keys.
+//
+
+#include "HumParameterName.h"
+
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+// Names are stored in blocks which are never moved or deleted, so names
+// can be read without locking while other threads add new names.  Each
+// block is twice the size of the previous one, so the blocks can hold
+// any id which fits into an int.
+static const int HumParameterNameBlockSize = 256;  // size of the first block
+static const int HumParameterNameMaxBlocks = 23;
+
+// HumParameterNameIndex: Open-addressing hash table from names to ids.
+// Each slot holds an id plus one, or 0 if the slot is empty.  Slots are
+// only filled (never changed afterwards) while the mutex of the table is
+// held, so they can be searched without locking.  When the index is half
+// full, a larger copy replaces it.  Replaced indexes are not deleted,
+// since other threads may still be searching them.
+struct HumParameterNameIndex {
+	size_t            capacity;   // power of two
+	std::atomic<int>* slots;
+	explicit HumParameterNameIndex(size_t size) : capacity(size),
+			slots(new std::atomic<int>[size]) {
+		for (size_t i=0; i<size; i++) {
+			slots[i] = 0;
+		}
+	}
+};
+
+struct HumParameterNameTable {
+	std::mutex                          mutex;
+	std::atomic<std::string*>           blocks[HumParameterNameMaxBlocks];
+	std::atomic<HumParameterNameIndex*> index;
+	std::atomic<int>                    count;
+	HumParameterNameTable(void);
+	int                add(std::string_view name);
+	int                find(std::string_view name);
+	const std::string& getEntry(int id);
+	void               insert(HumParameterNameIndex* target, int id);
+};
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::HumParameterNameTable -- Enter the empty name
+//     so that it has the id HumParameterName::Empty.
+//
+
+HumParameterNameTable::HumParameterNameTable(void) : count(0) {
+	for (int i=0; i<HumParameterNameMaxBlocks; i++) {
+		blocks[i] = NULL;
+	}
+	index = new HumParameterNameIndex(1024);
+	add("");
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::getEntry -- Return the stored name for an id
+//     which is in the table.
+//
+
+const std::string& HumParameterNameTable::getEntry(int id) {
+	int block = 0;
+	int offset = id;
+	while (offset >= (HumParameterNameBlockSize << block)) {
+		offset -= HumParameterNameBlockSize << block;
+		block++;
+	}
+	return blocks[block].load(std::memory_order_acquire)[offset];
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::find -- Return the id of a name, or
+//     HumParameterName::Unknown if it is not in the table.  No lock is
+//     needed.
+//
+
+int HumParameterNameTable::find(std::string_view name) {
+	HumParameterNameIndex* current = index.load(std::memory_order_acquire);
+	size_t mask = current->capacity - 1;
+	for (size_t i=std::hash<std::string_view>()(name) & mask; ; i=(i+1) & mask) {
+		int slot = current->slots[i].load(std::memory_order_acquire);
+		if (slot == 0) {
+			return HumParameterName::Unknown;
+		}
+		if (getEntry(slot - 1) == name) {
+			return slot - 1;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::insert -- Store an id in the first empty slot
+//     for its name.  The mutex must be held by the caller.
+//
+
+void HumParameterNameTable::insert(HumParameterNameIndex* target, int id) {
+	size_t mask = target->capacity - 1;
+	size_t i = std::hash<std::string_view>()(getEntry(id)) & mask;
+	while (target->slots[i].load(std::memory_order_relaxed) != 0) {
+		i = (i + 1) & mask;
+	}
+	target->slots[i].store(id + 1, std::memory_order_release);
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterNameTable::add -- Append a new name to the table.  The
+//     mutex must be held by the caller (except in the constructor).
+//
+
+int HumParameterNameTable::add(std::string_view name) {
+	int id = count;
+	int block = 0;
+	int offset = id;
+	while ((block < HumParameterNameMaxBlocks) &&
+			(offset >= (HumParameterNameBlockSize << block))) {
+		offset -= HumParameterNameBlockSize << block;
+		block++;
+	}
+	if ((block >= HumParameterNameMaxBlocks) || (id == INT_MAX)) {
+		throw std::length_error("HumParameterName: too many parameter names");
+	}
+	if (blocks[block] == NULL) {
+		blocks[block] = new std::string[HumParameterNameBlockSize << block];
+	}
+	blocks[block].load()[offset].assign(name.data(), name.size());
+
+	HumParameterNameIndex* current = index;
+	if ((size_t)(id + 1) * 2 > current->capacity) {
+		HumParameterNameIndex* larger = new HumParameterNameIndex(current->capacity * 2);
+		for (int i=0; i<=id; i++) {
+			insert(larger, i);
+		}
+		index.store(larger, std::memory_order_release);
+	} else {
+		insert(current, id);
+	}
+	count = id + 1;
+	return id;
+}
+
+
+
+//////////////////////////////
+//
+// getHumParameterNameTable -- The table is allocated once and never
+//     deleted so that it can be used during program shutdown.
+//
+
+static HumParameterNameTable& getHumParameterNameTable(void) {
+	static HumParameterNameTable* table = new HumParameterNameTable;
+	return *table;
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterName::getId -- Return the id for a name, adding it to the
+//     table if it has not been seen before.  Names which are already in
+//     the table are found without locking.
+//
+
+int HumParameterName::getId(std::string_view name) {
+	if (name.empty()) {
+		return Empty;
+	}
+	HumParameterNameTable& table = getHumParameterNameTable();
+	int id = table.find(name);
+	if (id != Unknown) {
+		return id;
+	}
+	std::lock_guard<std::mutex> lock(table.mutex);
+	id = table.find(name);
+	if (id != Unknown) {
+		return id;
+	}
+	return table.add(name);
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterName::findId -- Return the id for a name, or
+//     HumParameterName::Unknown if the name is not in the table.  Use
+//     this function for lookups, since a parameter cannot have a name
+//     which is not in the table.  No lock is needed.
+//
+
+int HumParameterName::findId(std::string_view name) {
+	if (name.empty()) {
+		return Empty;
+	}
+	return getHumParameterNameTable().find(name);
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterName::getName -- Return the name for an id, or an empty
+//     string if the id is not in the table.
+//
+
+const std::string& HumParameterName::getName(int id) {
+	HumParameterNameTable& table = getHumParameterNameTable();
+	if ((id < 0) || (id >= table.count)) {
+		id = Empty;
+	}
+	return table.getEntry(id);
+}
+
+
+
+//////////////////////////////
+//
+// HumParameterName::getCount -- Return the number of names in the table.
+//
+
+int HumParameterName::getCount(void) {
+	return getHumParameterNameTable().count;
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -0,0 +1,328 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 20:11:46 UTC 2026
+// Last Modified: Sat Oct 17 10:21:28 UTC 2026
+// Filename:      HumPool.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumPool.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Slab allocator for small, frequently created objects.
+//
+
+#include "HumPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <new>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+// HumPoolBlock: Link for a free block on a free list.
+struct HumPoolBlock {
+	HumPoolBlock* next;
+};
+
+// HumPoolSizeClass: Shared free list for one block size.  Blocks
+// are moved between this list and the thread caches in batches.
+// The slabs which have been cut into blocks of this size are kept
+// so that HumPool::trim() can release the slabs which are unused.
+struct HumPoolSizeClass {
+	std::mutex          mutex;
+	HumPoolBlock*       freelist = NULL;
+	std::vector<char*>  slabs;
+};
+
+// HumPoolThreadCache: Free blocks which are private to one thread.
+// When the thread exits, its blocks are returned to the shared lists.
+struct HumPoolThreadCache {
+	HumPoolBlock* freelist[HumPool::MaxBlockSize / HumPool::Granularity] = {};
+	size_t        count[HumPool::MaxBlockSize / HumPool::Granularity] = {};
+	void flush(void);
+	~HumPoolThreadCache();
+};
+
+static const int HumPoolClassCount = HumPool::MaxBlockSize / HumPool::Granularity;
+
+// Number of blocks moved between a thread cache and a shared list at once:
+static const size_t HumPoolBatch = 64;
+
+static std::atomic<size_t> HumPoolSlabCount(0);
+static std::atomic<size_t> HumPoolReservedBytes(0);
+
+
+//////////////////////////////
+//
+// getHumPoolSizeClasses -- The shared lists are allocated once and never
+//    deleted so that threads exiting during program shutdown can still
+//    return their cached blocks.
+//
+
+static HumPoolSizeClass* getHumPoolSizeClasses(void) {
+	static HumPoolSizeClass* classes = new HumPoolSizeClass[HumPoolClassCount];
+	return classes;
+}
+
+static thread_local HumPoolThreadCache HumPoolCache;
+
+
+
+//////////////////////////////
+//
+// HumPoolThreadCache::~HumPoolThreadCache --
+//
+
+HumPoolThreadCache::~HumPoolThreadCache() {
+	flush();
+}
+
+
+
+//////////////////////////////
+//
+// HumPoolThreadCache::flush -- Give all cached blocks back to the shared
+//    free lists.
+//
+
+void HumPoolThreadCache::flush(void) {
+	HumPoolSizeClass* classes = getHumPoolSizeClasses();
+	for (int i=0; i<HumPoolClassCount; i++) {
+		if (freelist[i] == NULL) {
+			continue;
+		}
+		HumPoolBlock* last = freelist[i];
+		while (last->next) {
+			last = last->next;
+		}
+		std::lock_guard<std::mutex> lock(classes[i].mutex);
+		last->next = classes[i].freelist;
+		classes[i].freelist = freelist[i];
+		freelist[i] = NULL;
+		count[i] = 0;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// refillHumPoolCache -- Take a batch of blocks from the shared list for
+//    the given size class, or cut up a new slab if the shared list is empty.
+//
+
+static void refillHumPoolCache(HumPoolThreadCache& cache, int index) {
+	HumPoolSizeClass& sizeclass = getHumPoolSizeClasses()[index];
+	{
+		std::lock_guard<std::mutex> lock(sizeclass.mutex);
+		HumPoolBlock* block = sizeclass.freelist;
+		size_t count = 0;
+		while (block && (count < HumPoolBatch)) {
+			HumPoolBlock* next = block->next;
+			block->next = cache.freelist[index];
+			cache.freelist[index] = block;
+			block = next;
+			count++;
+		}
+		sizeclass.freelist = block;
+		cache.count[index] += count;
+		if (count) {
+			return;
+		}
+	}
+
+	size_t blocksize = (index + 1) * HumPool::Granularity;
+	char* slab = static_cast<char*>(::operator new(HumPool::SlabSize));
+	{
+		std::lock_guard<std::mutex> lock(sizeclass.mutex);
+		sizeclass.slabs.push_back(slab);
+	}
+	HumPoolSlabCount++;
+	HumPoolReservedBytes += HumPool::SlabSize;
+	size_t blocks = HumPool::SlabSize / blocksize;
+	// Link the blocks in reverse order so that they are handed out
+	// in increasing address order:
+	for (size_t i=blocks; i-- > 0; ) {
+		HumPoolBlock* block = reinterpret_cast<HumPoolBlock*>(slab + i * blocksize);
+		block->next = cache.freelist[index];
+		cache.freelist[index] = block;
+	}
+	cache.count[index] += blocks;
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::allocate -- Return a block of memory that can hold at
+//     least the given number of bytes.
+//
+
+void* HumPool::allocate(size_t size) {
+#ifdef HUMLIB_NO_POOL
+	return ::operator new(size);
+#else
+	if ((size == 0) || (size > MaxBlockSize)) {
+		return ::operator new(size);
+	}
+	int index = (int)((size - 1) / Granularity);
+	HumPoolThreadCache& cache = HumPoolCache;
+	if (cache.freelist[index] == NULL) {
+		refillHumPoolCache(cache, index);
+	}
+	HumPoolBlock* block = cache.freelist[index];
+	cache.freelist[index] = block->next;
+	cache.count[index]--;
+	return block;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::deallocate -- Return a block to the pool.  The size must be
+//     the same as the one given to HumPool::allocate() for the block.
+//
+
+void HumPool::deallocate(void* ptr, size_t size) {
+	if (ptr == NULL) {
+		return;
+	}
+#ifdef HUMLIB_NO_POOL
+	::operator delete(ptr);
+#else
+	if ((size == 0) || (size > MaxBlockSize)) {
+		::operator delete(ptr);
+		return;
+	}
+	int index = (int)((size - 1) / Granularity);
+	HumPoolThreadCache& cache = HumPoolCache;
+	HumPoolBlock* block = static_cast<HumPoolBlock*>(ptr);
+	block->next = cache.freelist[index];
+	cache.freelist[index] = block;
+	cache.count[index]++;
+
+	if (cache.count[index] < 2 * HumPoolBatch) {
+		return;
+	}
+
+	// Too many cached blocks for this thread: move a batch to the
+	// shared list so that other threads can use them.
+	HumPoolBlock* first = cache.freelist[index];
+	HumPoolBlock* last = first;
+	for (size_t i=1; i<HumPoolBatch; i++) {
+		last = last->next;
+	}
+	cache.freelist[index] = last->next;
+	cache.count[index] -= HumPoolBatch;
+	HumPoolSizeClass& sizeclass = getHumPoolSizeClasses()[index];
+	std::lock_guard<std::mutex> lock(sizeclass.mutex);
+	last->next = sizeclass.freelist;
+	sizeclass.freelist = first;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::trim -- Give the slabs in which all blocks are free back to
+//     the system allocator, after moving the free blocks cached by the
+//     calling thread to the shared lists.  Blocks cached by other threads
+//     are treated as being in use.  Returns the number of slabs released.
+//     This takes time in proportion to the number of free blocks, so it
+//     should be called after large files have been deleted (or when a
+//     program is idle) rather than after each file.
+//
+
+size_t HumPool::trim(void) {
+#ifdef HUMLIB_NO_POOL
+	return 0;
+#else
+	HumPoolCache.flush();
+	size_t released = 0;
+	HumPoolSizeClass* classes = getHumPoolSizeClasses();
+	for (int i=0; i<HumPoolClassCount; i++) {
+		HumPoolSizeClass& sizeclass = classes[i];
+		std::lock_guard<std::mutex> lock(sizeclass.mutex);
+		if ((sizeclass.freelist == NULL) || sizeclass.slabs.empty()) {
+			continue;
+		}
+		vector<char*>& slabs = sizeclass.slabs;
+		std::sort(slabs.begin(), slabs.end(), std::less<char*>());
+		auto getSlab = [&slabs](HumPoolBlock* block) {
+			char* address = reinterpret_cast<char*>(block);
+			auto it = std::upper_bound(slabs.begin(), slabs.end(), address, std::less<char*>());
+			return (size_t)(it - slabs.begin()) - 1;
+		};
+
+		// Count the free blocks in each slab:
+		size_t blocks = SlabSize / ((i + 1) * Granularity);
+		vector<size_t> freecount(slabs.size(), 0);
+		for (HumPoolBlock* block = sizeclass.freelist; block; block = block->next) {
+			freecount[getSlab(block)]++;
+		}
+
+		// Remove the blocks of unused slabs from the free list, then
+		// release the slabs:
+		HumPoolBlock** link = &sizeclass.freelist;
+		while (*link) {
+			if (freecount[getSlab(*link)] == blocks) {
+				*link = (*link)->next;
+			} else {
+				link = &(*link)->next;
+			}
+		}
+		size_t kept = 0;
+		for (size_t j=0; j<slabs.size(); j++) {
+			if (freecount[j] == blocks) {
+				::operator delete(slabs[j]);
+				released++;
+			} else {
+				slabs[kept++] = slabs[j];
+			}
+		}
+		slabs.resize(kept);
+	}
+	HumPoolSlabCount -= released;
+	HumPoolReservedBytes -= released * SlabSize;
+	return released;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::getSlabCount -- Return the number of slabs requested from
+//     the system allocator which have not been released by trim().
+//
+
+size_t HumPool::getSlabCount(void) {
+	return HumPoolSlabCount;
+}
+
+
+
+//////////////////////////////
+//
+// HumPool::getReservedBytes -- Return the total size of all slabs.
+//
+
+size_t HumPool::getReservedBytes(void) {
+	return HumPoolReservedBytes;
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
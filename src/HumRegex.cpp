@@ -18,7 +18,14 @@
 
 #include "HumRegex.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
 #include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 using namespace std;
 
@@ -48,7 +55,7 @@ HumRegex::HumRegex(const string& exp, const string& options) {
 		// explicitly set the default syntax
 		m_regexflags = std::regex_constants::ECMAScript;
 	}
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
+	compile(exp, getTemporaryRegexFlags(options));
 	m_searchflags = (std::regex_constants::match_flag_type)0;
 	m_searchflags = getTemporarySearchFlags(options);
 }
@@ -155,8 +162,12 @@ void HumRegex::unsetGlobal(void) {
 //
 
 int HumRegex::search(const string& input, const string& exp) {
-	m_regex = regex(exp, m_regexflags);
-	bool result = regex_search(input, m_matches, m_regex, m_searchflags);
+	const regex& re = compile(exp, m_regexflags);
+	int status = searchLiteral(input, 0);
+	if (status >= 0) {
+		return status;
+	}
+	bool result = regex_search(input, m_matches, re, m_searchflags);
 	if (!result) {
 		return 0;
 	} else if (m_matches.size() < 1) {
@@ -170,10 +181,14 @@ int HumRegex::search(const string& input, const string& exp) {
 
 int HumRegex::search(const string& input, int startindex,
 		const string& exp) {
-	m_regex = regex(exp, m_regexflags);
+	const regex& re = compile(exp, m_regexflags);
+	int status = searchLiteral(input, startindex);
+	if (status >= 0) {
+		return status;
+	}
 	auto startit = input.begin() + startindex;
 	auto endit   = input.end();
-	bool result = regex_search(startit, endit, m_matches, m_regex, m_searchflags);
+	bool result = regex_search(startit, endit, m_matches, re, m_searchflags);
 	if (!result) {
 		return 0;
 	} else if (m_matches.size() < 1) {
@@ -199,8 +214,12 @@ int HumRegex::search(string* input, int startindex, const string& exp) {
 
 int HumRegex::search(const string& input, const string& exp,
 		const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
-	bool result = regex_search(input, m_matches, m_regex, getTemporarySearchFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
+	int status = searchLiteral(input, 0);
+	if (status >= 0) {
+		return status;
+	}
+	bool result = regex_search(input, m_matches, re, getTemporarySearchFlags(options));
 	if (!result) {
 		return 0;
 	} else if (m_matches.size() < 1) {
@@ -213,10 +232,14 @@ int HumRegex::search(const string& input, const string& exp,
 
 int HumRegex::search(const string& input, int startindex, const string& exp,
 		const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
+	int status = searchLiteral(input, startindex);
+	if (status >= 0) {
+		return status;
+	}
 	auto startit = input.begin() + startindex;
 	auto endit   = input.end();
-	bool result = regex_search(startit, endit, m_matches, m_regex, getTemporarySearchFlags(options));
+	bool result = regex_search(startit, endit, m_matches, re, getTemporarySearchFlags(options));
 	if (!result) {
 		return 0;
 	} else if (m_matches.size() < 1) {
@@ -251,6 +274,9 @@ int HumRegex::search(string* input, int startindex, const string& exp,
 //
 
 int HumRegex::getMatchCount(void) {
+	if (m_literalSearch) {
+		return m_literalCount;
+	}
 	return (int)m_matches.size();
 }
 
@@ -266,9 +292,12 @@ int HumRegex::getMatchCount(void) {
 string HumRegex::getMatch(int index) {
 	if (index < 0) {
 		return "";
-	} if (index >= (int)m_matches.size()) {
+	} if (index >= getMatchCount()) {
 		return "";
 	}
+	if (m_literalSearch) {
+		return m_literalInput->substr(m_literalBase + m_literalStart, m_literalLength);
+	}
 	string output = m_matches.str(index);
 	return output;
 }
@@ -282,7 +311,7 @@ string HumRegex::getMatch(int index) {
 //
 
 int HumRegex::getMatchInt(int index) {
-	string value = m_matches.str(index);
+	string value = m_literalSearch ? getMatch(index) : m_matches.str(index);
 	int output = 0;
 	if (value.size() > 0) {
 		if (isdigit(value[0])) {
@@ -304,7 +333,7 @@ int HumRegex::getMatchInt(int index) {
 //
 
 double HumRegex::getMatchDouble(int index) {
-	string value = m_matches.str(index);
+	string value = m_literalSearch ? getMatch(index) : m_matches.str(index);
 	if (value.size() > 0) {
 		return stod(value);
 	} else {
@@ -321,6 +350,12 @@ double HumRegex::getMatchDouble(int index) {
 //
 
 string HumRegex::getPrefix(void) {
+	if (m_literalSearch) {
+		if (m_literalCount == 0) {
+			return "";
+		}
+		return m_literalInput->substr(m_literalBase, m_literalStart);
+	}
 	return m_matches.prefix().str();
 }
 
@@ -333,6 +368,12 @@ string HumRegex::getPrefix(void) {
 //
 
 string HumRegex::getSuffix(void) {
+	if (m_literalSearch) {
+		if (m_literalCount == 0) {
+			return "";
+		}
+		return m_literalInput->substr(m_literalBase + m_literalStart + m_literalLength);
+	}
 	return m_matches.suffix().str();
 }
 
@@ -345,6 +386,9 @@ string HumRegex::getSuffix(void) {
 //
 
 int HumRegex::getMatchStartIndex(int index) {
+	if (m_literalSearch) {
+		return m_literalStart;
+	}
 	return (int)m_matches.position(index);
 }
 
@@ -369,6 +413,9 @@ int HumRegex::getMatchEndIndex(int index) {
 //
 
 int HumRegex::getMatchLength(int index) {
+	if (m_literalSearch) {
+		return ((index >= 0) && (index < m_literalCount)) ? m_literalLength : 0;
+	}
 	return (int)m_matches.length(index);
 }
 
@@ -385,15 +432,21 @@ int HumRegex::getMatchLength(int index) {
 //
 
 bool HumRegex::match(const string& input, const string& exp) {
-	m_regex = regex(exp, m_regexflags);
-	return regex_match(input, m_regex, m_searchflags);
+	const regex& re = compile(exp, m_regexflags);
+	if (m_pattern->m_literalOnly && getLiteralMatching()) {
+		return input == m_pattern->m_literal;
+	}
+	return regex_match(input, re, m_searchflags);
 }
 
 
 bool HumRegex::match(const string& input, const string& exp,
 		const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
-	return regex_match(input, m_regex, getTemporarySearchFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
+	if (m_pattern->m_literalOnly && getLiteralMatching()) {
+		return input == m_pattern->m_literal;
+	}
+	return regex_match(input, re, getTemporarySearchFlags(options));
 }
 
 
@@ -424,8 +477,13 @@ bool HumRegex::match(const string* input, const string& exp,
 
 string& HumRegex::replaceDestructive(string& input, const string& replacement,
 		const string& exp) {
-	m_regex = regex(exp, m_regexflags);
-	input = regex_replace(input, m_regex, replacement, m_searchflags);
+	const regex& re = compile(exp, m_regexflags);
+	string output;
+	if (replaceLiteral(output, input, replacement, m_searchflags)) {
+		input.swap(output);
+		return input;
+	}
+	input = regex_replace(input, re, replacement, m_searchflags);
 	return input;
 }
 
@@ -441,8 +499,13 @@ string& HumRegex::replaceDestructive(string* input, const string& replacement,
 
 string& HumRegex::replaceDestructive(string& input, const string& replacement,
 		const string& exp, const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
-	input = regex_replace(input, m_regex, replacement, getTemporarySearchFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
+	string output;
+	if (replaceLiteral(output, input, replacement, getTemporarySearchFlags(options))) {
+		input.swap(output);
+		return input;
+	}
+	input = regex_replace(input, re, replacement, getTemporarySearchFlags(options));
 	return input;
 }
 
@@ -462,10 +525,14 @@ string& HumRegex::replaceDestructive (string* input, const string& replacement,
 
 string HumRegex::replaceCopy(const string& input, const string& replacement,
 		const string& exp) {
-	m_regex = regex(exp, m_regexflags);
+	const regex& re = compile(exp, m_regexflags);
 	string output;
+	if (replaceLiteral(output, input, replacement,
+			std::regex_constants::match_default)) {
+		return output;
+	}
 	regex_replace(std::back_inserter(output), input.begin(),
-			input.end(), m_regex, replacement);
+			input.end(), re, replacement);
 	return output;
 }
 
@@ -481,10 +548,13 @@ string HumRegex::replaceCopy(string* input, const string& replacement,
 
 string HumRegex::replaceCopy(const string& input, const string& exp,
 		const string& replacement, const string& options) {
-	m_regex = regex(exp, getTemporaryRegexFlags(options));
+	const regex& re = compile(exp, getTemporaryRegexFlags(options));
 	string output;
+	if (replaceLiteral(output, input, replacement, getTemporarySearchFlags(options))) {
+		return output;
+	}
 	regex_replace(std::back_inserter(output), input.begin(),
-			input.end(), m_regex, replacement, getTemporarySearchFlags(options));
+			input.end(), re, replacement, getTemporarySearchFlags(options));
 	return output;
 }
 
@@ -638,6 +708,398 @@ std::regex_constants::match_flag_type HumRegex::getTemporarySearchFlags(
 	return temp_flags;
 }
 
+
+///////////////////////////////////////////////////////////////////////////
+//
+// Compiled expression cache.
+//
+
+//////////////////////////////
+//
+// HumRegexCache -- Compiled expressions shared by all HumRegex objects,
+//     in least-recently-used order (most recent first).  m_index maps
+//     the syntax options and expression to an entry in m_entries.
+//
+
+struct HumRegexCache {
+	std::mutex m_mutex;
+	std::list<std::shared_ptr<const HumRegexPattern>> m_entries;
+	std::unordered_map<std::string,
+			std::list<std::shared_ptr<const HumRegexPattern>>::iterator> m_index;
+	int m_size = 512;
+	std::atomic<bool> m_literal{true};
+};
+
+static HumRegexCache& getHumRegexCache(void) {
+	static HumRegexCache cache;
+	return cache;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::getPattern -- Return the compiled expression for the given
+//     syntax options, compiling it if it is not in the cache.  This can
+//     be called from multiple threads.
+//
+
+std::shared_ptr<const HumRegexPattern> HumRegex::getPattern(const std::string& exp,
+		std::regex_constants::syntax_option_type flags) {
+	HumRegexCache& cache = getHumRegexCache();
+	std::string key = std::to_string((unsigned)flags);
+	key += ':';
+	key += exp;
+	{
+		std::lock_guard<std::mutex> lock(cache.m_mutex);
+		if (cache.m_size <= 0) {
+			// Cache is disabled.
+		} else {
+			auto found = cache.m_index.find(key);
+			if (found != cache.m_index.end()) {
+				cache.m_entries.splice(cache.m_entries.begin(), cache.m_entries,
+						found->second);
+				return *found->second;
+			}
+		}
+	}
+
+	// Compile outside of the lock (an invalid expression throws
+	// std::regex_error here, as before).
+	auto pattern = std::make_shared<const HumRegexPattern>(exp, flags);
+
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+	if (cache.m_size <= 0) {
+		return pattern;
+	}
+	auto found = cache.m_index.find(key);
+	if (found != cache.m_index.end()) {
+		// Compiled by another thread in the meantime.
+		return *found->second;
+	}
+	cache.m_entries.push_front(pattern);
+	cache.m_index[key] = cache.m_entries.begin();
+	while ((int)cache.m_entries.size() > cache.m_size) {
+		const HumRegexPattern& last = *cache.m_entries.back();
+		std::string lastkey = std::to_string((unsigned)last.m_flags);
+		lastkey += ':';
+		lastkey += last.m_exp;
+		cache.m_index.erase(lastkey);
+		cache.m_entries.pop_back();
+	}
+	return pattern;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::compile -- Set the current expression, reusing the previous
+//     one if it is the same.
+//
+
+const std::regex& HumRegex::compile(const std::string& exp,
+		std::regex_constants::syntax_option_type flags) {
+	if (!m_pattern || (m_pattern->m_flags != flags) || (m_pattern->m_exp != exp)
+			|| (getCacheSize() <= 0)) {
+		m_pattern = getPattern(exp, flags);
+	}
+	return m_pattern->m_regex;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::setCacheSize -- Set the maximum number of compiled expressions
+//     to keep in the cache (default 512).  A size of 0 disables the cache,
+//     so that expressions are compiled for every search.
+//
+
+void HumRegex::setCacheSize(int size) {
+	HumRegexCache& cache = getHumRegexCache();
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+	cache.m_size = size;
+	while ((int)cache.m_entries.size() > std::max(size, 0)) {
+		const HumRegexPattern& last = *cache.m_entries.back();
+		std::string lastkey = std::to_string((unsigned)last.m_flags);
+		lastkey += ':';
+		lastkey += last.m_exp;
+		cache.m_index.erase(lastkey);
+		cache.m_entries.pop_back();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::getCacheSize --
+//
+
+int HumRegex::getCacheSize(void) {
+	HumRegexCache& cache = getHumRegexCache();
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+	return cache.m_size;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::clearCache -- Remove all compiled expressions from the cache.
+//
+
+void HumRegex::clearCache(void) {
+	HumRegexCache& cache = getHumRegexCache();
+	std::lock_guard<std::mutex> lock(cache.m_mutex);
+	cache.m_entries.clear();
+	cache.m_index.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::setLiteralMatching -- Turn on/off searching, matching and
+//     replacing of literal expressions without std::regex (default on).
+//     The results are the same either way.
+//
+
+void HumRegex::setLiteralMatching(bool state) {
+	getHumRegexCache().m_literal = state;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::getLiteralMatching --
+//
+
+bool HumRegex::getLiteralMatching(void) {
+	return getHumRegexCache().m_literal;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::searchLiteral -- Search for the current expression without
+//     using std::regex.  Returns -1 if std::regex is needed; otherwise
+//     returns 0 if there is no match, or the character position + 1 of
+//     the match (relative to startindex), like search().  A search which
+//     fails here is known to fail since m_literal must occur at the start
+//     of any match.
+//
+
+int HumRegex::searchLiteral(const std::string& input, int startindex) {
+	m_literalSearch = false;
+	const HumRegexPattern& pattern = *m_pattern;
+	if (pattern.m_literal.empty() || !getLiteralMatching()) {
+		return -1;
+	}
+	const std::string& literal = pattern.m_literal;
+	size_t length = literal.size();
+	size_t size = input.size() - startindex;
+	const char* text = input.data() + startindex;
+	size_t found = std::string::npos;
+	if (pattern.m_anchorStart) {
+		if ((size >= length) && (memcmp(text, literal.data(), length) == 0)) {
+			found = 0;
+		}
+	} else {
+		found = input.find(literal, startindex);
+		if (found != std::string::npos) {
+			found -= startindex;
+		}
+	}
+	if (pattern.m_literalOnly && pattern.m_anchorEnd && (found != std::string::npos)
+			&& (found + length != size)) {
+		// The match can only be at the end of the input.
+		found = std::string::npos;
+		if (!pattern.m_anchorStart && (size >= length) &&
+				(memcmp(text + size - length, literal.data(), length) == 0)) {
+			found = size - length;
+		}
+	}
+	if ((found != std::string::npos) && !pattern.m_literalOnly) {
+		return -1;
+	}
+
+	m_literalSearch = true;
+	m_literalInput  = &input;
+	m_literalBase   = startindex;
+	if (found == std::string::npos) {
+		m_literalCount  = 0;
+		m_literalStart  = 0;
+		m_literalLength = 0;
+		return 0;
+	}
+	m_literalCount  = pattern.m_group ? 2 : 1;
+	m_literalStart  = (int)found;
+	m_literalLength = (int)length;
+	return (int)found + 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumRegex::replaceLiteral -- Replace the current expression in the input
+//     without using std::regex, storing the result in output.  Returns
+//     false if std::regex is needed (when the expression is not literal,
+//     or the replacement contains $ substitutions).
+//
+
+bool HumRegex::replaceLiteral(std::string& output, const std::string& input,
+		const std::string& replacement,
+		std::regex_constants::match_flag_type flags) {
+	const HumRegexPattern& pattern = *m_pattern;
+	if (!pattern.m_literalOnly || pattern.m_literal.empty() || !getLiteralMatching()) {
+		return false;
+	}
+	if (replacement.find('$') != std::string::npos) {
+		return false;
+	}
+	const std::string& literal = pattern.m_literal;
+	size_t length = literal.size();
+	bool atstart = (input.size() >= length) &&
+			(input.compare(0, length, literal) == 0);
+	bool atend = (input.size() >= length) &&
+			(input.compare(input.size() - length, length, literal) == 0);
+	if (pattern.m_anchorStart && pattern.m_anchorEnd) {
+		output = (atstart && (input.size() == length)) ? replacement : input;
+	} else if (pattern.m_anchorStart) {
+		output = atstart ? replacement + input.substr(length) : input;
+	} else if (pattern.m_anchorEnd) {
+		output = atend ? input.substr(0, input.size() - length) + replacement : input;
+	} else {
+		bool global = !(flags & std::regex_constants::format_first_only);
+		output.clear();
+		output.reserve(input.size());
+		size_t start = 0;
+		size_t found = input.find(literal);
+		while (found != std::string::npos) {
+			output.append(input, start, found - start);
+			output += replacement;
+			start = found + length;
+			if (!global) {
+				break;
+			}
+			found = input.find(literal, start);
+		}
+		output.append(input, start, std::string::npos);
+	}
+	return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// HumRegexPattern -- A compiled expression in the HumRegex cache.
+//
+
+//////////////////////////////
+//
+// HumRegexPattern::HumRegexPattern --
+//
+
+HumRegexPattern::HumRegexPattern(const std::string& exp,
+		std::regex_constants::syntax_option_type flags) :
+		m_exp(exp), m_flags(flags), m_regex(exp, flags) {
+	analyzeLiteral();
+}
+
+
+
+//////////////////////////////
+//
+// HumRegexPattern::analyzeLiteral -- Find the literal text at the start
+//     of the expression, and check if the expression is only that text.
+//     Only plain characters and escaped punctuation are literal (such as
+//     "^\*I" or "\]$").  Expressions containing "|" and anything other
+//     than ECMAScript syntax are not analyzed.
+//
+
+void HumRegexPattern::analyzeLiteral(void) {
+	using namespace std::regex_constants;
+	if (m_flags & (icase | nosubs | basic | extended | awk | grep | egrep)) {
+		return;
+	}
+	const std::string& exp = m_exp;
+	if (exp.find('|') != std::string::npos) {
+		return;
+	}
+	size_t n = exp.size();
+	size_t i = 0;
+	bool anchorStart = false;
+	bool group = false;
+	if ((i < n) && (exp[i] == '^')) {
+		anchorStart = true;
+		i++;
+	}
+	if ((i < n) && (exp[i] == '(') && ((i + 1 >= n) || (exp[i+1] != '?'))) {
+		group = true;
+		i++;
+	}
+	std::string literal;
+	while (i < n) {
+		char ch = exp[i];
+		size_t next = i + 1;
+		if (ch == '\\') {
+			if (i + 1 >= n) {
+				break;
+			}
+			unsigned char escaped = (unsigned char)exp[i+1];
+			if (isalnum(escaped) || (escaped == '_') || (escaped >= 0x80)) {
+				// character class, backreference or special character
+				break;
+			}
+			ch = (char)escaped;
+			next = i + 2;
+		} else if ((ch == '\0') || strchr(".^$|?*+()[]{}", ch)) {
+			break;
+		}
+		if ((next < n) && ((exp[next] == '?') || (exp[next] == '*') ||
+				(exp[next] == '{'))) {
+			// optional character
+			break;
+		}
+		literal += ch;
+		i = next;
+		if ((next < n) && (exp[next] == '+')) {
+			break;
+		}
+	}
+
+	size_t j = i;
+	bool complete = true;
+	if (group) {
+		if ((j < n) && (exp[j] == ')')) {
+			j++;
+		} else {
+			complete = false;
+		}
+	}
+	bool anchorEnd = false;
+	if (complete && (j < n) && (exp[j] == '$')) {
+		anchorEnd = true;
+		j++;
+	}
+	if (complete && (j == n)) {
+		m_literalOnly = true;
+		m_anchorEnd   = anchorEnd;
+		m_group       = group;
+	} else if (group) {
+		// The group may be optional or repeated.
+		return;
+	}
+	m_literal     = literal;
+	m_anchorStart = anchorStart;
+}
+
 // END_MERGE
 
 } // end namespace hum
@@ -0,0 +1,1202 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 01:26:47 UTC 2026
+// Last Modified: Sat Oct 17 07:03:47 UTC 2026
+// Filename:      HumSnapshot.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumSnapshot.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Binary snapshots of the analyses of a HumdrumFile.
+//
+// Snapshot layout (all integers are stored in a variable number of bytes,
+// seven bits per byte, with small negative numbers stored as small
+// positive numbers, so that snapshots do not depend on byte order):
+//    "HUMSNAP" magic string (8 bytes, including the final null)
+//    version, key (two integers), analysis states,
+//    barline-difference flag, line count, token count
+//    string table: count, then length and characters of each string
+//    file records: segment level, ticks per quarter note, id prefix,
+//       track starts/ends, barlines, strands, strophes, signifier lines
+//    for each line: token count, durations, rhythm state, linked
+//       parameters, parameters of the line, then the token records.
+// Parameters are stored as a list of namespace/key/value entries followed
+// by the typed values of the "auto" namespace from the HumAnalysisStore of
+// the file.
+//
+
+#include "HumSnapshot.h"
+#include "HumdrumFileBase.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#ifdef HUMLIB_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+// Increase HumSnapshotVersion when the snapshot layout or the results
+// of any saved analysis change, so that old snapshots are not used.
+static const char         HumSnapshotMagic[8]  = "HUMSNAP";
+static const std::int32_t HumSnapshotVersion   = 3;
+
+// Flags for token records:
+static const std::int32_t HumSnapshotRhythm    = 1;
+static const std::int32_t HumSnapshotParamSet  = 2;
+
+// Marker in hash records for values which are token pointers:
+static const std::int32_t HumSnapshotTokenValue = -2;
+
+
+//////////////////////////////
+//
+// HumSnapshot::HumSnapshot --
+//
+
+HumSnapshot::HumSnapshot(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::~HumSnapshot --
+//
+
+HumSnapshot::~HumSnapshot() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::clear -- Remove any encoding or decoding state.
+//
+
+void HumSnapshot::clear(void) {
+	m_data.clear();
+	m_strings.clear();
+	m_stringIndex.clear();
+	m_tokenIndex.clear();
+	m_readpos = NULL;
+	m_readend = NULL;
+	m_table.clear();
+	m_tokens.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::cacheDirectory -- Storage for the cache directory, which
+//     is initialized from the HUMLIB_SNAPSHOT_DIR environment variable.
+//
+
+string& HumSnapshot::cacheDirectory(void) {
+	static string directory = []() {
+		const char* value = getenv("HUMLIB_SNAPSHOT_DIR");
+		return string(value ? value : "");
+	}();
+	return directory;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::setCacheDirectory -- Set the directory in which snapshots
+//     are saved when reading files.  An empty string disables the cache.
+//     The directory must already exist.  This should be set before files
+//     are read in other threads.
+//
+
+void HumSnapshot::setCacheDirectory(const string& directory) {
+	cacheDirectory() = directory;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getCacheDirectory --
+//
+
+string HumSnapshot::getCacheDirectory(void) {
+	return cacheDirectory();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::isCacheEnabled -- True if a cache directory is set.
+//
+
+bool HumSnapshot::isCacheEnabled(void) {
+	return !cacheDirectory().empty();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getCacheFilename -- Return the name of the snapshot file
+//     in the cache directory for the given content key and list of
+//     analyses done when reading the file.
+//
+
+string HumSnapshot::getCacheFilename(std::uint64_t key, unsigned analyses) {
+	char name[64];
+	snprintf(name, sizeof(name), "%016llx-%x.hsnap", (unsigned long long)key,
+			analyses);
+	string output = cacheDirectory();
+	if (!output.empty() && (output.back() != '/')) {
+		output += '/';
+	}
+	output += name;
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getContentKey -- Return a 64-bit FNV-1a hash of the
+//     contents of a file.  For a list of lines, a newline is added to
+//     the end of each line.
+//
+
+std::uint64_t HumSnapshot::getContentKey(const char* contents, size_t size) {
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	const unsigned char* ptr = (const unsigned char*)contents;
+	for (size_t i=0; i<size; i++) {
+		hash ^= ptr[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+std::uint64_t HumSnapshot::getContentKey(const vector<pair<const char*,
+		size_t>>& lines) {
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	for (int i=0; i<(int)lines.size(); i++) {
+		const unsigned char* ptr = (const unsigned char*)lines[i].first;
+		for (size_t j=0; j<lines[i].second; j++) {
+			hash ^= ptr[j];
+			hash *= 0x100000001b3ULL;
+		}
+		hash ^= '\n';
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::writeCache -- Save a snapshot of the file in the cache
+//     directory.  Returns false if there is no cache directory or the
+//     snapshot could not be saved.
+//
+
+bool HumSnapshot::writeCache(HumdrumFileBase& infile, std::uint64_t key) {
+	if (!isCacheEnabled()) {
+		return false;
+	}
+	HumSnapshot snapshot;
+	return snapshot.write(infile, getCacheFilename(key, infile.m_readAnalyses), key);
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::readCache -- Load the analyses of a file from the cache
+//     directory.  The lines of the file must have been read, but not
+//     split into tokens.  Returns false if there is no snapshot for the
+//     file, in which case the file still has to be analyzed.
+//
+
+bool HumSnapshot::readCache(HumdrumFileBase& infile, std::uint64_t key) {
+	if (!isCacheEnabled()) {
+		return false;
+	}
+	HumSnapshot snapshot;
+	return snapshot.read(infile, getCacheFilename(key, infile.m_readAnalyses), key);
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::write -- Save a snapshot of an analyzed file.  The
+//     snapshot is written to a temporary file which is then renamed, so
+//     that other processes reading the same cache never see a partial
+//     snapshot.  Returns false if the file cannot be stored in a
+//     snapshot (such as when its tokens no longer match the text of the
+//     lines, or parameters point to tokens in another file).
+//
+
+bool HumSnapshot::write(HumdrumFileBase& infile, const string& filename,
+		std::uint64_t key) {
+	if (!infile.isValid() || !encode(infile, key)) {
+		clear();
+		return false;
+	}
+	static std::atomic<int> counter(0);
+	stringstream tempname;
+	tempname << filename << ".tmp";
+#ifdef HUMLIB_MMAP
+	tempname << getpid() << "-";
+#endif
+	tempname << std::hash<std::thread::id>()(std::this_thread::get_id())
+	         << "-" << counter++;
+	std::ofstream output(tempname.str(), std::ios::binary);
+	if (!output.is_open()) {
+		clear();
+		return false;
+	}
+	output.write(m_data.data(), m_data.size());
+	output.close();
+	clear();
+	if (!output) {
+		remove(tempname.str().c_str());
+		return false;
+	}
+	if (rename(tempname.str().c_str(), filename.c_str()) != 0) {
+		remove(tempname.str().c_str());
+		return false;
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::read -- Load the analyses of a file from a snapshot.  The
+//     lines of the file must have been read, but not split into tokens.
+//     The snapshot is memory-mapped if possible.  If the key is not zero,
+//     it must match the key in the snapshot.  Returns false if the
+//     snapshot cannot be used, in which case the lines of the file are
+//     left unanalyzed.
+//
+
+bool HumSnapshot::read(HumdrumFileBase& infile, const string& filename,
+		std::uint64_t key) {
+	bool status = false;
+#ifdef HUMLIB_MMAP
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode) || (info.st_size == 0)) {
+		::close(fd);
+		return false;
+	}
+	size_t size = (size_t)info.st_size;
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	status = decode(infile, key, (const char*)data, size);
+	munmap(data, size);
+#else
+	ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		return false;
+	}
+	stringstream contents;
+	contents << input.rdbuf();
+	string data = contents.str();
+	status = decode(infile, key, data.data(), data.size());
+#endif
+	clear();
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::writeString -- Store a snapshot of an analyzed file in a
+//     string rather than in a file, such as for keeping analyzed files
+//     in memory.  Returns false if the file cannot be stored in a
+//     snapshot.
+//
+
+bool HumSnapshot::writeString(HumdrumFileBase& infile, string& data) {
+	data.clear();
+	if (!infile.isValid() || !encode(infile, 0)) {
+		clear();
+		return false;
+	}
+	data.swap(m_data);
+	clear();
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::readString -- Load the analyses of a file from a snapshot
+//     stored with writeString().  The lines of the file must have been
+//     read, but not split into tokens.
+//
+
+bool HumSnapshot::readString(HumdrumFileBase& infile, const string& data) {
+	bool status = decode(infile, 0, data.data(), data.size());
+	clear();
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::encode -- Store the analyses of a file in m_data.
+//
+
+bool HumSnapshot::encode(HumdrumFileBase& infile, std::uint64_t key) {
+	clear();
+	int tokencount = 0;
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		HumdrumLine& line = *infile.m_lines[i];
+		if ((line.m_lineindex != i) || !checkTokens(line)) {
+			return false;
+		}
+		for (int j=0; j<(int)line.m_tokens.size(); j++) {
+			m_tokenIndex[line.m_tokens[j]] = tokencount++;
+		}
+	}
+
+	// File records:
+	putInt(infile.m_segmentlevel);
+	putInt(infile.m_ticksperquarternote);
+	putString(infile.m_idprefix);
+	putInt((int)infile.m_trackstarts.size());
+	for (int i=0; i<(int)infile.m_trackstarts.size(); i++) {
+		if (!putToken(infile.m_trackstarts[i])) { return false; }
+	}
+	putInt((int)infile.m_trackends.size());
+	for (int i=0; i<(int)infile.m_trackends.size(); i++) {
+		putInt((int)infile.m_trackends[i].size());
+		for (int j=0; j<(int)infile.m_trackends[i].size(); j++) {
+			if (!putToken(infile.m_trackends[i][j])) { return false; }
+		}
+	}
+	putInt((int)infile.m_barlines.size());
+	for (int i=0; i<(int)infile.m_barlines.size(); i++) {
+		HLp barline = infile.m_barlines[i];
+		if ((barline == NULL) || (barline->m_lineindex < 0) ||
+				(barline->m_lineindex >= (int)infile.m_lines.size()) ||
+				(infile.m_lines[barline->m_lineindex] != barline)) {
+			return false;
+		}
+		putInt(barline->m_lineindex);
+	}
+	for (auto pairs : {&infile.m_strand1d, &infile.m_strophes1d}) {
+		putInt((int)pairs->size());
+		for (int i=0; i<(int)pairs->size(); i++) {
+			if (!putToken(pairs->at(i).first)) { return false; }
+			if (!putToken(pairs->at(i).last))  { return false; }
+		}
+	}
+	for (auto pairs : {&infile.m_strand2d, &infile.m_strophes2d}) {
+		putInt((int)pairs->size());
+		for (int i=0; i<(int)pairs->size(); i++) {
+			putInt((int)pairs->at(i).size());
+			for (int j=0; j<(int)pairs->at(i).size(); j++) {
+				if (!putToken(pairs->at(i)[j].first)) { return false; }
+				if (!putToken(pairs->at(i)[j].last))  { return false; }
+			}
+		}
+	}
+	vector<int> signifiers;
+	if (infile.m_analyses.isAnalyzed(HumFileAnalysis::Structure)) {
+		for (int i=0; i<(int)infile.m_lines.size(); i++) {
+			if (infile.m_lines[i]->isSignifier()) {
+				signifiers.push_back(i);
+			}
+		}
+	}
+	putInt((int)signifiers.size());
+	for (int i=0; i<(int)signifiers.size(); i++) {
+		putInt(signifiers[i]);
+	}
+	if (!putHash(infile)) {
+		return false;
+	}
+
+	// Line and token records:
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		HumdrumLine& line = *infile.m_lines[i];
+		putInt((int)line.m_tokens.size());
+		putNum(line.m_duration);
+		putNum(line.m_durationFromStart);
+		putNum(line.m_durationFromBarline);
+		putNum(line.m_durationToBarline);
+		putInt(line.m_rhythm_analyzed);
+		putInt((int)line.m_linkedParameters.size());
+		for (int j=0; j<(int)line.m_linkedParameters.size(); j++) {
+			if (!putToken(line.m_linkedParameters[j])) { return false; }
+		}
+		if (!putHash(line)) {
+			return false;
+		}
+		for (int j=0; j<(int)line.m_tokens.size(); j++) {
+			HumdrumToken& token = *line.m_tokens[j];
+			HumAddress& address = token.m_address;
+			putString(address.m_spining);
+			putInt(address.m_fieldindex);
+			putInt(address.m_track);
+			putInt(address.m_subtrack);
+			putInt(address.m_subtrackcount);
+			if (address.m_datatype < 0) {
+				putInt(-1);
+			} else {
+				putString(HumDataType::getName(address.m_datatype));
+			}
+			putNum(token.m_duration);
+			for (auto links : {&token.m_nextTokens, &token.m_previousTokens,
+					&token.m_nextNonNullTokens, &token.m_previousNonNullTokens}) {
+				putInt((int)links->size());
+				for (int k=0; k<(int)links->size(); k++) {
+					if (!putToken(links->at(k))) { return false; }
+				}
+			}
+			putInt(token.m_rhycheck);
+			putInt(token.m_strand);
+			if (!putToken(token.m_nullresolve)) { return false; }
+			if (!putToken(token.m_strophe))     { return false; }
+			putInt((int)token.m_linkedParameterTokens.size());
+			for (int k=0; k<(int)token.m_linkedParameterTokens.size(); k++) {
+				if (!putToken(token.m_linkedParameterTokens[k])) { return false; }
+			}
+			std::int32_t flags = 0;
+			if (token.m_rhythm_analyzed) {
+				flags |= HumSnapshotRhythm;
+			}
+			if (token.m_parameterSet) {
+				flags |= HumSnapshotParamSet;
+			}
+			putInt(flags);
+			if (!putHash(token)) {
+				return false;
+			}
+		}
+	}
+
+	// Place the header and string table before the records:
+	string records;
+	records.swap(m_data);
+	m_data.reserve(records.size() + 1024);
+	m_data.append(HumSnapshotMagic, sizeof(HumSnapshotMagic));
+	putInt(HumSnapshotVersion);
+	putInt((std::int32_t)(key & 0xffffffffULL));
+	putInt((std::int32_t)(key >> 32));
+	putInt((std::int32_t)infile.m_analyses.m_analyzed);
+	putInt(infile.m_analyses.m_barlines_different);
+	putInt((int)infile.m_lines.size());
+	putInt(tokencount);
+	putInt((int)m_strings.size());
+	for (int i=0; i<(int)m_strings.size(); i++) {
+		putInt((int)m_strings[i].size());
+		m_data += m_strings[i];
+	}
+	m_data += records;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::checkTokens -- Return true if the tokens of a line are
+//     the same as the tokens that are created from the text of the line,
+//     since only the line text is used to create tokens when loading a
+//     snapshot.
+//
+
+bool HumSnapshot::checkTokens(HumdrumLine& line) {
+	if (line.m_tokens.empty() || (line.m_tokens.size() != line.m_tabs.size())) {
+		return false;
+	}
+	if (line.empty() || (line.compare(0, 2, "!!") == 0)) {
+		return (line.m_tokens.size() == 1) &&
+				(line.m_tabs[0] == 0) &&
+				(line.m_tokens[0]->compare(line) == 0);
+	}
+	size_t position = 0;
+	for (int i=0; i<(int)line.m_tokens.size(); i++) {
+		HumdrumToken* token = line.m_tokens[i];
+		if ((token == NULL) || (token->find('\t') != string::npos) ||
+				(line.compare(position, token->size(), *token) != 0)) {
+			return false;
+		}
+		position += token->size();
+		int tabs = line.m_tabs[i];
+		bool last = (i == (int)line.m_tokens.size() - 1);
+		if ((tabs < 0) || (!last && (tabs == 0))) {
+			return false;
+		}
+		for (int j=0; j<tabs; j++) {
+			if ((position >= line.size()) || (line[position] != '\t')) {
+				return false;
+			}
+			position++;
+		}
+		if ((position < line.size()) && (line[position] == '\t')) {
+			return false;
+		}
+	}
+	return position == line.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::decode -- Load the analyses of a file from snapshot data.
+//
+
+bool HumSnapshot::decode(HumdrumFileBase& infile, std::uint64_t key,
+		const char* data, size_t size) {
+	clear();
+	if ((size < sizeof(HumSnapshotMagic)) ||
+			(memcmp(data, HumSnapshotMagic, sizeof(HumSnapshotMagic)) != 0)) {
+		return false;
+	}
+	m_readpos = data + sizeof(HumSnapshotMagic);
+	m_readend = data + size;
+	std::int32_t version;
+	std::int32_t keylow;
+	std::int32_t keyhigh;
+	std::int32_t analyzed;
+	std::int32_t different;
+	std::int32_t linecount;
+	std::int32_t tokencount;
+	std::int32_t stringcount;
+	if (!getInt(version)    || (version != HumSnapshotVersion))    { return false; }
+	if (!getInt(keylow)     || !getInt(keyhigh))                   { return false; }
+	std::uint64_t filekey = ((std::uint64_t)(std::uint32_t)keyhigh << 32) |
+			(std::uint32_t)keylow;
+	if ((key != 0) && (filekey != key)) {
+		return false;
+	}
+	if (!getInt(analyzed)   || !getInt(different))                 { return false; }
+	if (!getInt(linecount)  || (linecount != (int)infile.m_lines.size())) { return false; }
+	if (!getInt(tokencount) || (tokencount < 0))                   { return false; }
+	if (!getInt(stringcount) || (stringcount < 0))                 { return false; }
+	m_table.reserve(stringcount);
+	for (int i=0; i<stringcount; i++) {
+		std::int32_t length;
+		if (!getInt(length) || (length < 0) || (length > m_readend - m_readpos)) {
+			return false;
+		}
+		m_table.emplace_back(m_readpos, length);
+		m_readpos += length;
+	}
+
+	// Split the lines into tokens, then fill in the analyses.  Tokens can
+	// refer to later tokens, so they all have to exist first.
+	m_tokens.reserve(tokencount);
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		HumdrumLine& line = *infile.m_lines[i];
+		line.createTokensFromLine();
+		line.m_lineindex = i;
+		m_tokens.insert(m_tokens.end(), line.m_tokens.begin(), line.m_tokens.end());
+	}
+	if (((int)m_tokens.size() != tokencount) || !applyRecords(infile)) {
+		resetLines(infile);
+		return false;
+	}
+	infile.m_analyses.m_analyzed = (unsigned)analyzed;
+	infile.m_analyses.m_barlines_different = different;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::applyRecords -- Read the file, line and token records
+//     of a snapshot.  Token pointers are restored from the token
+//     indexes stored in the records.
+//
+
+bool HumSnapshot::applyRecords(HumdrumFileBase& infile) {
+	std::int32_t count;
+	std::int32_t subcount;
+	HTp token;
+	HTp other;
+
+	if (!getInt(infile.m_segmentlevel))        { return false; }
+	if (!getInt(infile.m_ticksperquarternote)) { return false; }
+	if (!getString(infile.m_idprefix))         { return false; }
+	if (!getInt(count) || (count < 0))         { return false; }
+	infile.m_trackstarts.resize(count);
+	for (int i=0; i<count; i++) {
+		if (!getToken(infile.m_trackstarts[i])) { return false; }
+	}
+	if (!getInt(count) || (count < 0))         { return false; }
+	infile.m_trackends.resize(count);
+	for (int i=0; i<count; i++) {
+		if (!getInt(subcount) || (subcount < 0)) { return false; }
+		infile.m_trackends[i].resize(subcount);
+		for (int j=0; j<subcount; j++) {
+			if (!getToken(infile.m_trackends[i][j])) { return false; }
+		}
+	}
+	if (!getInt(count) || (count < 0))         { return false; }
+	infile.m_barlines.resize(count);
+	for (int i=0; i<count; i++) {
+		std::int32_t index;
+		if (!getInt(index) || (index < 0) || (index >= (int)infile.m_lines.size())) {
+			return false;
+		}
+		infile.m_barlines[i] = infile.m_lines[index];
+	}
+	for (auto pairs : {&infile.m_strand1d, &infile.m_strophes1d}) {
+		if (!getInt(count) || (count < 0))      { return false; }
+		pairs->resize(count);
+		for (int i=0; i<count; i++) {
+			if (!getToken(pairs->at(i).first))   { return false; }
+			if (!getToken(pairs->at(i).last))    { return false; }
+		}
+	}
+	for (auto pairs : {&infile.m_strand2d, &infile.m_strophes2d}) {
+		if (!getInt(count) || (count < 0))      { return false; }
+		pairs->resize(count);
+		for (int i=0; i<count; i++) {
+			if (!getInt(subcount) || (subcount < 0)) { return false; }
+			pairs->at(i).resize(subcount);
+			for (int j=0; j<subcount; j++) {
+				if (!getToken(pairs->at(i)[j].first)) { return false; }
+				if (!getToken(pairs->at(i)[j].last))  { return false; }
+			}
+		}
+	}
+	vector<int> signifiers;
+	if (!getInt(count) || (count < 0))         { return false; }
+	for (int i=0; i<count; i++) {
+		std::int32_t index;
+		if (!getInt(index) || (index < 0) || (index >= (int)infile.m_lines.size())) {
+			return false;
+		}
+		signifiers.push_back(index);
+	}
+	// Parameters of the file are added after all records are read, since
+	// the file can have parameters from before the snapshot was loaded:
+	HumHash fileparameters;
+	if (!getHash(fileparameters)) {
+		return false;
+	}
+
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		HumdrumLine& line = *infile.m_lines[i];
+		std::int32_t value;
+		if (!getInt(count) || (count != (int)line.m_tokens.size())) { return false; }
+		if (!getNum(line.m_duration))            { return false; }
+		if (!getNum(line.m_durationFromStart))   { return false; }
+		if (!getNum(line.m_durationFromBarline)) { return false; }
+		if (!getNum(line.m_durationToBarline))   { return false; }
+		if (!getInt(value))                      { return false; }
+		line.m_rhythm_analyzed = value;
+		if (!getInt(count) || (count < 0))       { return false; }
+		line.m_linkedParameters.resize(count);
+		for (int j=0; j<count; j++) {
+			if (!getToken(line.m_linkedParameters[j])) { return false; }
+		}
+		if (!getHash(line)) {
+			return false;
+		}
+		for (int j=0; j<(int)line.m_tokens.size(); j++) {
+			token = line.m_tokens[j];
+			HumAddress& address = token->m_address;
+			if (!getString(address.m_spining))    { return false; }
+			if (!getInt(address.m_fieldindex))    { return false; }
+			if (!getInt(address.m_track))         { return false; }
+			if (!getInt(address.m_subtrack))      { return false; }
+			if (!getInt(address.m_subtrackcount)) { return false; }
+			if (!getInt(value) || (value < -1) || (value >= (int)m_table.size())) {
+				return false;
+			}
+			if (value < 0) {
+				address.m_datatype = HumDataType::Unknown;
+			} else {
+				address.m_datatype = HumDataType::getId(string(m_table[value].first,
+						m_table[value].second));
+			}
+			if (!getNum(token->m_duration))       { return false; }
+			for (auto links : {&token->m_nextTokens, &token->m_previousTokens,
+					&token->m_nextNonNullTokens, &token->m_previousNonNullTokens}) {
+				if (!getInt(count) || (count < 0)) { return false; }
+				links->clear();
+				links->reserve(count);
+				for (int k=0; k<count; k++) {
+					if (!getToken(other))           { return false; }
+					links->push_back(other);
+				}
+			}
+			if (!getInt(token->m_rhycheck))       { return false; }
+			if (!getInt(token->m_strand))         { return false; }
+			if (!getToken(token->m_nullresolve))  { return false; }
+			if (!getToken(token->m_strophe))      { return false; }
+			if (!getInt(count) || (count < 0))    { return false; }
+			token->m_linkedParameterTokens.resize(count);
+			for (int k=0; k<count; k++) {
+				if (!getToken(token->m_linkedParameterTokens[k])) { return false; }
+			}
+			if (!getInt(value))                   { return false; }
+			token->m_rhythm_analyzed = value & HumSnapshotRhythm;
+			if (value & HumSnapshotParamSet) {
+				token->storeParameterSet();
+			}
+			if (!getHash(*token)) {
+				return false;
+			}
+		}
+	}
+	if (m_readpos != m_readend) {
+		return false;
+	}
+
+	for (int i=0; i<(int)signifiers.size(); i++) {
+		infile.m_signifiers.addSignifier(infile.m_lines[signifiers[i]]->getText());
+	}
+	infile.prefix = fileparameters.prefix;
+	if (fileparameters.parameters) {
+		for (auto& entry : *fileparameters.parameters) {
+			infile.insertParameter(HumParameterName::getName(entry.ns1),
+					HumParameterName::getName(entry.ns2),
+					HumParameterName::getName(entry.key)) = entry.value;
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::resetLines -- Remove any partially loaded analyses after
+//     an invalid snapshot, leaving the lines of the file as they were
+//     before reading the snapshot.
+//
+
+void HumSnapshot::resetLines(HumdrumFileBase& infile) {
+	vector<string> text(infile.m_lines.size());
+	for (int i=0; i<(int)infile.m_lines.size(); i++) {
+		text[i].swap(*infile.m_lines[i]);
+	}
+	string filename = infile.m_filename;
+	infile.clear();
+	infile.m_filename = filename;
+	infile.m_lines.reserve(text.size());
+	for (int i=0; i<(int)text.size(); i++) {
+		HLp line = new HumdrumLine;
+		line->swap(text[i]);
+		line->setOwner(&infile);
+		infile.m_lines.push_back(line);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putInt -- Append an integer to the snapshot data.  The
+//     sign is moved to the lowest bit, then the number is stored seven
+//     bits at a time, with the high bit of each byte set if more bytes
+//     follow.  Most numbers in a snapshot are stored in one or two bytes.
+//
+
+void HumSnapshot::putInt(std::int32_t value) {
+	std::uint32_t number = ((std::uint32_t)value << 1) ^ (std::uint32_t)(value >> 31);
+	while (number >= 0x80) {
+		m_data += (char)((number & 0x7f) | 0x80);
+		number >>= 7;
+	}
+	m_data += (char)number;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putString -- Append the index of a string in the string
+//     table to the snapshot data, adding the string to the table if
+//     needed.
+//
+
+void HumSnapshot::putString(const string& value) {
+	auto found = m_stringIndex.find(value);
+	if (found != m_stringIndex.end()) {
+		putInt(found->second);
+		return;
+	}
+	std::int32_t index = (std::int32_t)m_strings.size();
+	m_strings.push_back(value);
+	m_stringIndex[value] = index;
+	putInt(index);
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putToken -- Append the index of a token to the snapshot
+//     data (-1 for NULL).  Returns false if the token is not in the file.
+//
+
+bool HumSnapshot::putToken(HumdrumToken* token) {
+	if (token == NULL) {
+		putInt(-1);
+		return true;
+	}
+	auto found = m_tokenIndex.find(token);
+	if (found == m_tokenIndex.end()) {
+		return false;
+	}
+	putInt(found->second);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putNum -- Append a rational number to the snapshot data.
+//
+
+void HumSnapshot::putNum(const HumNum& value) {
+	putInt(value.getNumerator());
+	putInt(value.getDenominator());
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putHash -- Append the parameters of a HumHash to the
+//     snapshot data.  Values which are token pointers (such as slur
+//     and tie endpoints) are stored as token indexes.
+//
+
+bool HumSnapshot::putHash(HumHash& hash) {
+	putString(hash.prefix);
+	if (hash.parameters == NULL) {
+		putInt(-1);
+		return putAnalysisValues(hash);
+	}
+	putInt((int)hash.parameters->size());
+	for (auto& entry : *hash.parameters) {
+		putString(HumParameterName::getName(entry.ns1));
+		putString(HumParameterName::getName(entry.ns2));
+		putString(HumParameterName::getName(entry.key));
+		const HumParameter& value = entry.value;
+		if ((value.compare(0, 3, "HT_") == 0) && (value != "HT_0")) {
+			HumdrumToken* pointer = NULL;
+			try {
+				pointer = (HumdrumToken*)(stoll(value.substr(3)));
+			} catch (std::exception& e) {
+				return false;
+			}
+			putInt(HumSnapshotTokenValue);
+			if (!putToken(pointer)) {
+				return false;
+			}
+		} else {
+			putString(value);
+		}
+		if (!putToken(value.origin)) {
+			return false;
+		}
+	}
+	return putAnalysisValues(hash);
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::putAnalysisValues -- Append the typed "auto" parameters of
+//     a HumHash to the snapshot data.
+//
+
+bool HumSnapshot::putAnalysisValues(HumHash& hash) {
+	if (hash.m_analysisRow < 0) {
+		putInt(0);
+		return true;
+	}
+	const HumAnalysisStore& store = *hash.findAnalysisStore(false);
+	int row = hash.m_analysisRow;
+	putInt(store.getValueCount(row));
+	for (int i=0; i<store.getKeyCount(); i++) {
+		const HumAnalysisValue* value = store.getValue(row, i);
+		if (value == NULL) {
+			continue;
+		}
+		putString(store.getNamespace1(i));
+		putString(store.getNamespace2(i));
+		putString(store.getKey(i));
+		putInt(value->type);
+		switch (value->type) {
+			case HumAnalysisValue::Integer:
+			case HumAnalysisValue::Boolean:
+				putInt(value->value.ints[0]);
+				break;
+			case HumAnalysisValue::Fraction:
+				putInt(value->value.ints[0]);
+				putInt(value->value.ints[1]);
+				break;
+			case HumAnalysisValue::Token:
+				if (!putToken(value->value.token)) {
+					return false;
+				}
+				break;
+			case HumAnalysisValue::Float:
+				{
+					char buffer[32];
+					snprintf(buffer, sizeof(buffer), "%.17g", value->value.number);
+					putString(buffer);
+				}
+				break;
+			default:
+				putString(store.getString(*value));
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getInt -- Read an integer from the snapshot data.
+//
+
+bool HumSnapshot::getInt(std::int32_t& value) {
+	std::uint32_t number = 0;
+	for (int shift=0; shift<35; shift+=7) {
+		if (m_readpos >= m_readend) {
+			return false;
+		}
+		std::uint32_t byte = (unsigned char)*m_readpos++;
+		number |= (byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			value = (std::int32_t)((number >> 1) ^ (0u - (number & 1)));
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getString -- Read a string index from the snapshot data
+//     and return the string.
+//
+
+bool HumSnapshot::getString(string& value) {
+	std::int32_t index;
+	if (!getInt(index) || (index < 0) || (index >= (int)m_table.size())) {
+		return false;
+	}
+	value.assign(m_table[index].first, m_table[index].second);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getToken -- Read a token index from the snapshot data
+//     and return the token.
+//
+
+bool HumSnapshot::getToken(HumdrumToken*& token) {
+	std::int32_t index;
+	if (!getInt(index) || (index < -1) || (index >= (int)m_tokens.size())) {
+		return false;
+	}
+	token = (index < 0) ? NULL : m_tokens[index];
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getNum -- Read a rational number from the snapshot data.
+//
+
+bool HumSnapshot::getNum(HumNum& value) {
+	std::int32_t top;
+	std::int32_t bot;
+	if (!getInt(top) || !getInt(bot) || (bot == 0)) {
+		return false;
+	}
+	value.setValue(top, bot);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getHash -- Read the parameters of a HumHash from the
+//     snapshot data.
+//
+
+bool HumSnapshot::getHash(HumHash& hash) {
+	if (!getString(hash.prefix)) {
+		return false;
+	}
+	std::int32_t count;
+	std::int32_t index;
+	string ns1;
+	string ns2;
+	string key;
+	if (!getInt(count) || (count < -1)) {
+		return false;
+	}
+	if (count < 0) {
+		return getAnalysisValues(hash);
+	}
+	hash.initializeParameters();
+	hash.parameters->reserve(count);
+	for (int i=0; i<count; i++) {
+		if (!getString(ns1) || !getString(ns2) || !getString(key)) {
+			return false;
+		}
+		HumParameter& value = hash.insertParameter(ns1, ns2, key);
+		if (!getInt(index) || (index < HumSnapshotTokenValue) ||
+				(index >= (int)m_table.size())) {
+			return false;
+		}
+		if (index == HumSnapshotTokenValue) {
+			HumdrumToken* pointer;
+			if (!getToken(pointer) || (pointer == NULL)) {
+				return false;
+			}
+			value.assign("HT_" + to_string((long long)pointer));
+		} else if (index >= 0) {
+			value.assign(m_table[index].first, m_table[index].second);
+		} else {
+			return false;
+		}
+		if (!getToken(value.origin)) {
+			return false;
+		}
+	}
+	return getAnalysisValues(hash);
+}
+
+
+
+
+//////////////////////////////
+//
+// HumSnapshot::getAnalysisValues -- Read the typed "auto" parameters of
+//     a HumHash from the snapshot data.
+//
+
+bool HumSnapshot::getAnalysisValues(HumHash& hash) {
+	std::int32_t count;
+	std::int32_t type;
+	std::int32_t number;
+	std::int32_t denominator;
+	string ns1;
+	string ns2;
+	string key;
+	string text;
+	HumdrumToken* pointer;
+	HumNum fraction;
+	if (!getInt(count) || (count < 0)) {
+		return false;
+	}
+	for (int i=0; i<count; i++) {
+		if (!getString(ns1) || !getString(ns2) || !getString(key) || !getInt(type)) {
+			return false;
+		}
+		if (!HumAnalysisStore::isAnalysisNamespace(ns1, ns2)) {
+			return false;
+		}
+		switch (type) {
+			case HumAnalysisValue::Integer:
+				if (!getInt(number)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, (int)number);
+				break;
+			case HumAnalysisValue::Boolean:
+				if (!getInt(number)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, number ? "true" : "false");
+				break;
+			case HumAnalysisValue::Fraction:
+				if (!getInt(number) || !getInt(denominator) || (denominator == 0)) {
+					return false;
+				}
+				fraction.setValue(number, denominator);
+				hash.setValue(ns1, ns2, key, fraction);
+				break;
+			case HumAnalysisValue::Token:
+				if (!getToken(pointer)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, pointer);
+				break;
+			case HumAnalysisValue::Float:
+				if (!getString(text)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, strtod(text.c_str(), NULL));
+				break;
+			case HumAnalysisValue::String:
+				if (!getString(text)) {
+					return false;
+				}
+				hash.setValue(ns1, ns2, key, text);
+				break;
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
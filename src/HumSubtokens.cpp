@@ -0,0 +1,201 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 07:33:05 UTC 2026
+// Last Modified: Sat Oct 17 07:33:05 UTC 2026
+// Filename:      HumSubtokens.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumSubtokens.cpp
+// Syntax:        C++17; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Iterate over the sub-tokens of a token without copying them.
+//
+
+#include "HumSubtokens.h"
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// HumSubtokens::HumSubtokens -- An empty separator gives the whole
+//     text as a single sub-token.
+// default value: separator = " "
+//
+
+HumSubtokens::HumSubtokens(std::string_view text, std::string_view separator) {
+	m_text = text;
+	m_separator = separator;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::begin -- Return an iterator at the first sub-token.
+//
+
+HumSubtokens::iterator HumSubtokens::begin(void) const {
+	return iterator(m_text, m_separator);
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::end -- Return an iterator after the last sub-token.
+//
+
+HumSubtokens::iterator HumSubtokens::end(void) const {
+	return iterator();
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::getCount -- Return the number of sub-tokens.  Separators
+//     at the start or end of the text give empty sub-tokens which are
+//     included in the count.
+//
+
+int HumSubtokens::getCount(void) const {
+	if (m_separator.empty()) {
+		return 1;
+	}
+	int count = 1;
+	std::string_view::size_type start = 0;
+	while ((start = m_text.find(m_separator, start)) != std::string_view::npos) {
+		count++;
+		start += m_separator.size();
+	}
+	return count;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::getSubtoken -- Return the sub-token at the given index,
+//     or an empty view if there is no such sub-token.
+//
+
+std::string_view HumSubtokens::getSubtoken(int index) const {
+	if (index < 0) {
+		return std::string_view();
+	}
+	for (std::string_view subtoken : *this) {
+		if (index-- == 0) {
+			return subtoken;
+		}
+	}
+	return std::string_view();
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::front -- Return the first sub-token.
+//
+
+std::string_view HumSubtokens::front(void) const {
+	return *begin();
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::iterator::iterator -- The default constructor makes an
+//     end iterator.
+//
+
+HumSubtokens::iterator::iterator(void) {
+	m_start = std::string_view::npos;
+}
+
+
+HumSubtokens::iterator::iterator(std::string_view text,
+		std::string_view separator) {
+	m_text = text;
+	m_separator = separator;
+	m_start = 0;
+	findEnd();
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::iterator::findEnd -- Set the current sub-token to the
+//     text from m_start to the next separator.
+//
+
+void HumSubtokens::iterator::findEnd(void) {
+	std::string_view::size_type stop = std::string_view::npos;
+	if (!m_separator.empty()) {
+		stop = m_text.find(m_separator, m_start);
+	}
+	if (stop == std::string_view::npos) {
+		m_current = m_text.substr(m_start);
+	} else {
+		m_current = m_text.substr(m_start, stop - m_start);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::iterator::operator++ -- Move to the next sub-token.
+//
+
+HumSubtokens::iterator& HumSubtokens::iterator::operator++(void) {
+	std::string_view::size_type next = m_start + m_current.size();
+	if (next >= m_text.size()) {
+		m_start = std::string_view::npos;
+		m_current = std::string_view();
+		return *this;
+	}
+	// m_current is followed by a separator:
+	m_start = next + m_separator.size();
+	findEnd();
+	return *this;
+}
+
+
+HumSubtokens::iterator HumSubtokens::iterator::operator++(int) {
+	iterator output = *this;
+	++(*this);
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumSubtokens::iterator::operator== -- Iterators are equal if they
+//     are both at the end, or at the same place in the same text.
+//
+
+bool HumSubtokens::iterator::operator==(const iterator& other) const {
+	if (m_start == std::string_view::npos) {
+		return other.m_start == std::string_view::npos;
+	}
+	if (other.m_start == std::string_view::npos) {
+		return false;
+	}
+	return (m_text.data() == other.m_text.data()) && (m_start == other.m_start);
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -0,0 +1,268 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Fri Oct 16 20:32:53 UTC 2026
+// Last Modified: Fri Oct 16 20:32:53 UTC 2026
+// Filename:      HumThreadPool.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumThreadPool.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Work-stealing thread pool.
+//
+
+#include "HumThreadPool.h"
+
+#include <system_error>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+// The pool and queue index of the worker running in the current thread,
+// so that tasks submitted from inside a task go to the worker's own queue.
+static thread_local HumThreadPool* HumThreadPoolOwner = NULL;
+static thread_local int            HumThreadPoolIndex = -1;
+
+
+//////////////////////////////
+//
+// HumThreadPool::HumThreadPool -- Start the given number of worker
+//     threads.  If the count is zero or less, one thread is started for
+//     each hardware thread.
+//
+
+HumThreadPool::HumThreadPool(int threads) : m_queued(0), m_pending(0),
+		m_next(0), m_stop(false) {
+	if (threads <= 0) {
+		threads = getHardwareThreadCount();
+	}
+	m_queues.reserve(threads);
+	for (int i=0; i<threads; i++) {
+		m_queues.emplace_back(new HumThreadPoolQueue);
+	}
+	m_threads.reserve(threads);
+	for (int i=0; i<threads; i++) {
+		try {
+			m_threads.emplace_back(&HumThreadPool::runWorker, this, i);
+		} catch (const std::system_error&) {
+			// Threads are not available: tasks in queues without a
+			// worker are stolen by the others, or run in submit() if
+			// no workers were started.
+			break;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::~HumThreadPool -- Finish all submitted tasks and then
+//     stop the worker threads.
+//
+
+HumThreadPool::~HumThreadPool() {
+	try {
+		wait();
+	} catch (...) {
+		// Exceptions from tasks are discarded if not collected with wait().
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wakeup.notify_all();
+	for (int i=0; i<(int)m_threads.size(); i++) {
+		m_threads[i].join();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getHardwareThreadCount -- Return the number of threads
+//     that the system can run concurrently (at least one).
+//
+
+int HumThreadPool::getHardwareThreadCount(void) {
+	int count = (int)std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getThreadCount -- Return the number of worker threads.
+//     This will be zero if threads could not be created.
+//
+
+int HumThreadPool::getThreadCount(void) const {
+	return (int)m_threads.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::getWorkerIndex -- Return the index of the worker thread
+//     of the pool which is calling the function (from 0 to one less than
+//     getThreadCount()), or -1 if it is not called from a worker thread
+//     of the pool (such as for tasks run in submit() when no threads
+//     could be created).
+//
+
+int HumThreadPool::getWorkerIndex(void) const {
+	if (HumThreadPoolOwner == this) {
+		return HumThreadPoolIndex;
+	}
+	return -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::submit -- Add a task to the pool.  Tasks submitted from
+//     a worker thread go to the end of that worker's queue; otherwise the
+//     queues are filled in rotation.
+//
+
+void HumThreadPool::submit(std::function<void(void)> task) {
+	if (m_threads.empty()) {
+		m_pending++;
+		runTask(task);
+		return;
+	}
+
+	int index;
+	if (HumThreadPoolOwner == this) {
+		index = HumThreadPoolIndex;
+	} else {
+		index = (int)(m_next++ % (unsigned)m_queues.size());
+	}
+
+	m_pending++;
+	{
+		std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+		m_queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queued++;
+	}
+	m_wakeup.notify_one();
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::wait -- Wait until all submitted tasks have finished.
+//     If any task threw an exception, the first one is thrown again here.
+//     Do not call from inside of a task.
+//
+
+void HumThreadPool::wait(void) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock, [this]() { return m_pending == 0; });
+	if (m_exception) {
+		std::exception_ptr error = m_exception;
+		m_exception = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::takeTask -- Take the newest task from the worker's own
+//     queue, or else the oldest task from another worker's queue.
+//
+
+bool HumThreadPool::takeTask(int index, std::function<void(void)>& task) {
+	{
+		HumThreadPoolQueue& queue = *m_queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			m_queued--;
+			return true;
+		}
+	}
+	int count = (int)m_queues.size();
+	for (int i=1; i<count; i++) {
+		HumThreadPoolQueue& queue = *m_queues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			m_queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::runTask -- Run a task, storing any exception that it
+//     throws for wait(), and signal if it was the last pending task.
+//
+
+void HumThreadPool::runTask(std::function<void(void)>& task) {
+	try {
+		task();
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_exception) {
+			m_exception = std::current_exception();
+		}
+	}
+	task = nullptr;
+	if (--m_pending == 0) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_idle.notify_all();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumThreadPool::runWorker -- Main loop of a worker thread.
+//
+
+void HumThreadPool::runWorker(int index) {
+	HumThreadPoolOwner = this;
+	HumThreadPoolIndex = index;
+	std::function<void(void)> task;
+	while (true) {
+		if (takeTask(index, task)) {
+			runTask(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_wakeup.wait(lock, [this]() { return m_stop || (m_queued > 0); });
+		if (m_stop && (m_queued <= 0)) {
+			break;
+		}
+	}
+	HumThreadPoolOwner = NULL;
+	HumThreadPoolIndex = -1;
+}
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -41,6 +41,29 @@ HumTool::~HumTool() {
 
 
 
+//////////////////////////////
+//
+// HumTool::operator= -- Copy the option definitions and settings of
+//     another tool, and clear the output.  This is used to reset a tool
+//     to its initial state from an unused copy of the tool (see
+//     HumToolRegistry).
+//
+
+HumTool& HumTool::operator=(const HumTool& tool) {
+	if (this == &tool) {
+		return *this;
+	}
+	Options::operator=(tool);
+	clearOutput();
+	m_suppress = tool.m_suppress;
+	m_analyses = tool.m_analyses;
+	m_analysesQ = tool.m_analysesQ;
+	m_inplace = tool.m_inplace;
+	return *this;
+}
+
+
+
 //////////////////////////////
 //
 // HumTool::hasAnyText -- Returns true if the output contains
@@ -274,6 +297,52 @@ void HumTool::clearOutput(void) {
 	m_free_text.str("");
   	m_warning_text.str("");
   	m_error_text.str("");
+	m_edited = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumTool::setInPlaceOutput -- Do not print files edited in place by
+//     the tool (see printEditedFile()), since the caller will use the
+//     edited input file as the output of the tool.
+//
+
+void HumTool::setInPlaceOutput(bool state) {
+	m_inplace = state;
+}
+
+
+
+//////////////////////////////
+//
+// HumTool::hasInPlaceOutput -- Returns true if the output of the tool
+//     is the edited input file, which was not printed to the Humdrum text
+//     because of setInPlaceOutput().
+//
+
+bool HumTool::hasInPlaceOutput(void) {
+	return m_edited;
+}
+
+
+
+//////////////////////////////
+//
+// HumTool::printEditedFile -- Store a file which the tool edited in
+//     place as its Humdrum output.  The text of the lines is updated from
+//     the tokens, and the file is printed unless setInPlaceOutput() was
+//     used.
+//
+
+void HumTool::printEditedFile(HumdrumFile& infile) {
+	infile.createLinesFromTokens();
+	if (m_inplace) {
+		m_edited = true;
+	} else {
+		m_humdrum_text << infile;
+	}
 }
 
 
@@ -0,0 +1,420 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:36:03 UTC 2026
+// Last Modified: Sat Oct 17 09:42:15 UTC 2026
+// Filename:      HumToolRegistry.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumToolRegistry.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Table of the tools which can be run by name.
+//
+
+#include "HumToolRegistry.h"
+#include "HumdrumFile.h"
+
+// tools which can be run by name:
+
+#include "tool-addic.h"
+#include "tool-addkey.h"
+#include "tool-addlabels.h"
+#include "tool-addtempo.h"
+#include "tool-autoaccid.h"
+#include "tool-autobeam.h"
+#include "tool-autocadence.h"
+#include "tool-autostem.h"
+#include "tool-barnum.h"
+#include "tool-binroll.h"
+#include "tool-bstyle.h"
+#include "tool-chantize.h"
+#include "tool-chint.h"
+#include "tool-chooser.h"
+#include "tool-chord.h"
+#include "tool-cint.h"
+#include "tool-cmr.h"
+#include "tool-colorgroups.h"
+#include "tool-colortriads.h"
+#include "tool-composite.h"
+#include "tool-deg.h"
+#include "tool-dissonant.h"
+#include "tool-double.h"
+#include "tool-extract.h"
+#include "tool-extremis.h"
+#include "tool-fb.h"
+#include "tool-filter.h"
+#include "tool-flipper.h"
+#include "tool-gasparize.h"
+#include "tool-grep.h"
+#include "tool-half.h"
+#include "tool-hands.h"
+#include "tool-homorhythm.h"
+#include "tool-homorhythm2.h"
+#include "tool-hproof.h"
+#include "tool-humbreak.h"
+#include "tool-humdiff.h"
+#include "tool-humsheet.h"
+#include "tool-humtr.h"
+#include "tool-imitation.h"
+#include "tool-instinfo.h"
+#include "tool-kern2mens.h"
+#include "tool-kernify.h"
+#include "tool-kernview.h"
+#include "tool-mei2hum.h"
+#include "tool-melisma.h"
+#include "tool-mens2kern.h"
+#include "tool-meter.h"
+#include "tool-metlev.h"
+#include "tool-mint.h"
+#include "tool-modori.h"
+#include "tool-msearch.h"
+#include "tool-myank.h"
+#include "tool-nproof.h"
+#include "tool-ordergps.h"
+#include "tool-pbar.h"
+#include "tool-phrase.h"
+#include "tool-pline.h"
+#include "tool-prange.h"
+#include "tool-recip.h"
+#include "tool-restfill.h"
+#include "tool-rmask.h"
+#include "tool-rid.h"
+#include "tool-rphrase.h"
+#include "tool-sab2gs.h"
+#include "tool-satb2gs.h"
+#include "tool-scordatura.h"
+#include "tool-semitones.h"
+#include "tool-shed.h"
+#include "tool-sic.h"
+#include "tool-simat.h"
+#include "tool-slurcheck.h"
+#include "tool-spinetrace.h"
+#include "tool-strophe.h"
+#include "tool-synco.h"
+#include "tool-tabber.h"
+#include "tool-tandeminfo.h"
+#include "tool-tassoize.h"
+#include "tool-text.h"
+#include "tool-textdur.h"
+#include "tool-thru.h"
+#include "tool-tie.h"
+#include "tool-timebase.h"
+#include "tool-transpose.h"
+#include "tool-tremolo.h"
+#include "tool-trillspell.h"
+#include "tool-triad.h"
+#include "tool-tspos.h"
+#include "tool-vcross.h"
+#include "tool-1520ify.h"
+
+#include <algorithm>
+#include <new>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// HumToolRegistry::newTool -- Allocate a tool.
+//
+
+template <class TOOL>
+HumTool* HumToolRegistry::newTool(void) {
+	return new TOOL;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::resetTool -- Reset a tool by deleting its contents and
+//     constructing a new instance of the tool in the same memory, so that
+//     anything owned by the tool (including memory owned through raw
+//     pointers) is released in the same way as when the tool is deleted.
+//
+
+template <class TOOL>
+void HumToolRegistry::resetTool(HumTool* tool) {
+	TOOL* instance = static_cast<TOOL*>(tool);
+	instance->~TOOL();
+	new (instance) TOOL;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::runTool -- Run a tool on a file.
+//
+
+template <class TOOL>
+bool HumToolRegistry::runTool(HumTool* tool, HumdrumFile& infile) {
+	return static_cast<TOOL*>(tool)->run(infile);
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::runToolOnPair -- Run a tool which compares two files,
+//     giving it the same file twice.
+//
+
+template <class TOOL>
+bool HumToolRegistry::runToolOnPair(HumTool* tool, HumdrumFile& infile) {
+	return static_cast<TOOL*>(tool)->run(infile, infile);
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getEntries -- The list of tools, sorted by tool name
+//     with the primary name of each tool before its aliases.  Add new
+//     tools here to make them available to the filter tool.  Tools which
+//     only edit tokens and print the edited file as their Humdrum output
+//     are listed with HUMTOOL_INPLACE (see Entry::inplace).
+//
+
+#define HUMTOOL(NAME, CLASS) \
+	{ NAME, #CLASS, &newTool<Tool_##CLASS>, &resetTool<Tool_##CLASS>, &runTool<Tool_##CLASS>, false }
+#define HUMTOOL_INPLACE(NAME, CLASS) \
+	{ NAME, #CLASS, &newTool<Tool_##CLASS>, &resetTool<Tool_##CLASS>, &runTool<Tool_##CLASS>, true }
+#define HUMTOOL_PAIR(NAME, CLASS) \
+	{ NAME, #CLASS, &newTool<Tool_##CLASS>, &resetTool<Tool_##CLASS>, &runToolOnPair<Tool_##CLASS>, false }
+
+const vector<HumToolRegistry::Entry>& HumToolRegistry::getEntries(void) {
+	static const vector<Entry> entries = {
+		HUMTOOL("1520ify",       1520ify),
+		HUMTOOL("addic",         addic),
+		HUMTOOL("addkey",        addkey),
+		HUMTOOL("addlabels",     addlabels),
+		HUMTOOL("addtempo",      addtempo),
+		HUMTOOL("autoaccid",     autoaccid),
+		HUMTOOL_INPLACE("autobeam", autobeam),
+		HUMTOOL("autocadence",   autocadence),
+		HUMTOOL("autostem",      autostem),
+		HUMTOOL("barnum",        barnum),
+		HUMTOOL("binroll",       binroll),
+		HUMTOOL("bstyle",        bstyle),
+		HUMTOOL("chantize",      chantize),
+		HUMTOOL("chint",         chint),
+		HUMTOOL_INPLACE("chord", chord),
+		HUMTOOL("cint",          cint),
+		HUMTOOL("cmr",           cmr),
+		HUMTOOL("colorgroups",   colorgroups),
+		HUMTOOL("colourgroups",  colorgroups),
+		HUMTOOL("colortriads",   colortriads),
+		HUMTOOL("colourtriads",  colortriads),
+		HUMTOOL("composite",     composite),
+		HUMTOOL("deg",           deg),
+		HUMTOOL("degx",          deg),
+		HUMTOOL("dissonant",     dissonant),
+		HUMTOOL_INPLACE("double", double),
+		HUMTOOL("extract",       extract),
+		HUMTOOL("extractx",      extract),
+		HUMTOOL("extremis",      extremis),
+		HUMTOOL("fb",            fb),
+		HUMTOOL("filter",        filter),
+		HUMTOOL("flipper",       flipper),
+		HUMTOOL("gasparize",     gasparize),
+		HUMTOOL("grep",          grep),
+		HUMTOOL("humgrep",       grep),
+		HUMTOOL_INPLACE("half",  half),
+		HUMTOOL("hands",         hands),
+		HUMTOOL("homorhythm",    homorhythm),
+		HUMTOOL("homorhythm2",   homorhythm2),
+		HUMTOOL("hproof",        hproof),
+		HUMTOOL("humbreak",      humbreak),
+		HUMTOOL("humsheet",      humsheet),
+		HUMTOOL_INPLACE("humtr", humtr),
+		HUMTOOL("imitation",     imitation),
+		HUMTOOL("instinfo",      instinfo),
+		HUMTOOL("kern2mens",     kern2mens),
+		HUMTOOL("kernify",       kernify),
+		HUMTOOL("kernview",      kernview),
+		HUMTOOL("melisma",       melisma),
+		HUMTOOL("mens2kern",     mens2kern),
+		HUMTOOL("meter",         meter),
+		HUMTOOL("metlev",        metlev),
+		HUMTOOL("mint",          mint),
+		HUMTOOL("mintx",         mint),
+		HUMTOOL("modori",        modori),
+		HUMTOOL("msearch",       msearch),
+		HUMTOOL("myank",         myank),
+		HUMTOOL("myankx",        myank),
+		HUMTOOL("nproof",        nproof),
+		HUMTOOL("ordergps",      ordergps),
+		HUMTOOL("pbar",          pbar),
+		HUMTOOL("phrase",        phrase),
+		HUMTOOL("pline",         pline),
+		HUMTOOL("prange",        prange),
+		HUMTOOL("recip",         recip),
+		HUMTOOL("restfill",      restfill),
+		HUMTOOL("rid",           rid),
+		HUMTOOL("ridx",          rid),
+		HUMTOOL("ridxx",         rid),
+		HUMTOOL("rmask",         rmask),
+		HUMTOOL("rphrase",       rphrase),
+		HUMTOOL("sab2gs",        sab2gs),
+		HUMTOOL("satb2gs",       satb2gs),
+		HUMTOOL("satb2gsx",      satb2gs),
+		HUMTOOL("scordatura",    scordatura),
+		HUMTOOL("semitones",     semitones),
+		HUMTOOL("shed",          shed),
+		HUMTOOL("sic",           sic),
+		HUMTOOL_PAIR("simat",         simat),
+		HUMTOOL("slurcheck",     slurcheck),
+		HUMTOOL("slur",          slurcheck),
+		HUMTOOL("spinetrace",    spinetrace),
+		HUMTOOL("strophe",       strophe),
+		HUMTOOL("synco",         synco),
+		HUMTOOL("tabber",        tabber),
+		HUMTOOL("tandeminfo",    tandeminfo),
+		HUMTOOL("tassoize",      tassoize),
+		HUMTOOL("tasso",         tassoize),
+		HUMTOOL("tassoise",      tassoize),
+		HUMTOOL("text",          text),
+		HUMTOOL("textdur",       textdur),
+		HUMTOOL("thru",          thru),
+		HUMTOOL("thrux",         thru),
+		HUMTOOL("thruxx",        thru),
+		HUMTOOL_INPLACE("tie",   tie),
+		HUMTOOL("timebase",      timebase),
+		HUMTOOL("timebasex",     timebase),
+		HUMTOOL("transpose",     transpose),
+		HUMTOOL("tremolo",       tremolo),
+		HUMTOOL("triad",         triad),
+		HUMTOOL("trillspell",    trillspell),
+		HUMTOOL("tspos",         tspos),
+		HUMTOOL("colorthirds",   tspos),
+		HUMTOOL("colourthirds",  tspos),
+		HUMTOOL("vcross",        vcross),
+	};
+	return entries;
+}
+
+#undef HUMTOOL
+#undef HUMTOOL_INPLACE
+#undef HUMTOOL_PAIR
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getIndex -- Map of tool names and aliases to their
+//     entries in the list of tools.
+//
+
+const std::unordered_map<string, const HumToolRegistry::Entry*>& HumToolRegistry::getIndex(void) {
+	static const std::unordered_map<string, const Entry*> index = []() {
+		std::unordered_map<string, const Entry*> output;
+		const vector<Entry>& entries = getEntries();
+		for (int i=0; i<(int)entries.size(); i++) {
+			output[entries[i].name] = &entries[i];
+		}
+		return output;
+	}();
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getEntry -- Return the entry for a tool name or alias,
+//     or NULL if there is no tool with that name.
+//
+
+const HumToolRegistry::Entry* HumToolRegistry::getEntry(const string& name) {
+	const std::unordered_map<string, const Entry*>& index = getIndex();
+	auto it = index.find(name);
+	if (it == index.end()) {
+		return NULL;
+	}
+	return it->second;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::isTool -- Returns true if the name is a tool name or
+//     alias.
+//
+
+bool HumToolRegistry::isTool(const string& name) {
+	return getEntry(name) != NULL;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::createTool -- Return a new instance of the tool with the
+//     given name or alias, or NULL if there is no tool with that name.
+//     The caller is responsible for deleting the tool.
+//
+
+HumTool* HumToolRegistry::createTool(const string& name) {
+	const Entry* entry = getEntry(name);
+	if (!entry) {
+		return NULL;
+	}
+	return entry->create();
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getToolNames -- Return a sorted list of the tool names,
+//     and also their aliases if the input is true.
+//
+
+vector<string> HumToolRegistry::getToolNames(bool aliases) {
+	vector<string> output;
+	const vector<Entry>& entries = getEntries();
+	for (int i=0; i<(int)entries.size(); i++) {
+		if (aliases || (entries[i].name == entries[i].tool)) {
+			output.push_back(entries[i].name);
+		}
+	}
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolRegistry::getAliases -- Return the other names for the given
+//     tool name or alias.
+//
+
+vector<string> HumToolRegistry::getAliases(const string& tool) {
+	vector<string> output;
+	const Entry* entry = getEntry(tool);
+	if (!entry) {
+		return output;
+	}
+	const vector<Entry>& entries = getEntries();
+	for (int i=0; i<(int)entries.size(); i++) {
+		if ((entries[i].tool == entry->tool) && (entries[i].name != tool)) {
+			output.push_back(entries[i].name);
+		}
+	}
+	return output;
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
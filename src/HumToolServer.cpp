@@ -0,0 +1,761 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 02:44:01 UTC 2026
+// Last Modified: Sat Oct 17 10:21:28 UTC 2026
+// Filename:      HumToolServer.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumToolServer.cpp
+// Syntax:        C++11; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Server which runs pipelines of humlib tools.
+//
+
+#include "HumToolServer.h"
+#include "HumPool.h"
+#include "HumThreadPool.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <sstream>
+
+#ifdef HUMLIB_SOCKETS
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <sys/stat.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+// Flag for send() so that writing to a closed connection returns an
+// error rather than raising SIGPIPE:
+#if defined(HUMLIB_SOCKETS) && defined(MSG_NOSIGNAL)
+	#define HUMTOOLSERVER_SEND_FLAGS MSG_NOSIGNAL
+#else
+	#define HUMTOOLSERVER_SEND_FLAGS 0
+#endif
+
+
+//////////////////////////////
+//
+// HumToolServer::HumToolServer -- Set the maximum number of files in the
+//     file cache.
+//
+
+HumToolServer::HumToolServer(int cachesize) : m_cache(cachesize),
+		m_stop(false), m_requests(0), m_errors(0) {
+	m_wakeup[0] = -1;
+	m_wakeup[1] = -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::~HumToolServer --
+//
+
+HumToolServer::~HumToolServer() {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::getFileCache -- Return the cache of files read for
+//     requests.
+//
+
+HumFileCache& HumToolServer::getFileCache(void) {
+	return m_cache;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::getStatistics -- Return the number of requests and
+//     the state of the file cache.
+//
+
+string HumToolServer::getStatistics(void) {
+	stringstream output;
+	output << "requests=" << m_requests.load()
+	       << "\terrors=" << m_errors.load()
+	       << "\tfiles=" << m_cache.getSize()
+	       << "\thits=" << m_cache.getHitCount()
+	       << "\tmisses=" << m_cache.getMissCount()
+	       << endl;
+	return output.str();
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::processRequest -- Run the tool pipeline of a request on
+//     its file or data.  This function can be called by several threads
+//     at once.  Returns false if the input cannot be read or the tools
+//     had an error.
+//
+
+bool HumToolServer::processRequest(const Request& request, Response& response) {
+	response = Response();
+	m_requests++;
+	HumdrumFile infile;
+	if (!request.filename.empty()) {
+		if (!m_cache.read(infile, request.filename)) {
+			string message = infile.getParseError();
+			if (message.empty()) {
+				message = "cannot read file";
+			}
+			response.error = request.filename + ": " + message + "\n";
+			m_errors++;
+			return false;
+		}
+	} else if (!infile.readString(request.data)) {
+		response.error = "invalid Humdrum data: " + infile.getParseError() + "\n";
+		m_errors++;
+		return false;
+	}
+
+	std::unique_ptr<Tool_filter> filter = takeFilter();
+	filter->process("filter " + request.options, 0, 1);
+	filter->clearOutput();
+	try {
+		response.status = filter->runPipeline(infile, request.tools);
+	} catch (const std::exception& e) {
+		response.status = false;
+		filter->setError(e.what());
+	}
+	response.humdrum = filter->getHumdrumText();
+	response.json    = filter->getJsonText();
+	response.text    = filter->getFreeText();
+	response.warning = filter->getWarning();
+	response.error   = filter->getError();
+	filter->clearOutput();
+	returnFilter(std::move(filter));
+
+	if (!response.error.empty()) {
+		response.status = false;
+	}
+	if (!response.status) {
+		m_errors++;
+	}
+	return response.status;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::takeFilter -- Take an unused filter (or create one if
+//     all filters are in use).
+//
+
+std::unique_ptr<Tool_filter> HumToolServer::takeFilter(void) {
+	std::unique_ptr<Tool_filter> filter;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_filters.empty()) {
+			filter = std::move(m_filters.back());
+			m_filters.pop_back();
+		}
+	}
+	if (!filter) {
+		filter.reset(new Tool_filter);
+	}
+	return filter;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::returnFilter -- Return a filter after use so that it
+//     can be used by another request.
+//
+
+void HumToolServer::returnFilter(std::unique_ptr<Tool_filter> filter) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_filters.push_back(std::move(filter));
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::handleRequest -- Process a request received from a
+//     connection, including the server commands.
+//
+
+void HumToolServer::handleRequest(const Request& request, Response& response) {
+	if (request.command.empty()) {
+		processRequest(request, response);
+	} else if (request.command == "stats") {
+		response = Response();
+		response.status = true;
+		response.text = getStatistics();
+	} else if (request.command == "stop") {
+		response = Response();
+		response.status = true;
+		stop();
+	} else {
+		response = Response();
+		response.error = "unknown command: " + request.command + "\n";
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::serve -- Listen for requests on a Unix domain socket
+//     until stop() is called (or a "stop" command is received).  Each
+//     connection can send any number of requests.  The requests are
+//     answered by the given number of worker threads (one per hardware
+//     thread if jobs is zero or less), which are only used while a
+//     request is being processed, so that open connections waiting for
+//     their next request do not keep other connections from being
+//     answered.  The socket can only be used by the owner of the server
+//     process.  Returns false if the socket cannot be created.
+//
+
+bool HumToolServer::serve(const string& socketpath, int jobs) {
+#ifdef HUMLIB_SOCKETS
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketpath.empty() || (socketpath.size() >= sizeof(address.sun_path))) {
+		cerr << "Error: invalid socket path: " << socketpath << endl;
+		return false;
+	}
+	strncpy(address.sun_path, socketpath.c_str(), sizeof(address.sun_path) - 1);
+
+	// Remove a socket left by a previous server:
+	struct stat info;
+	if ((lstat(socketpath.c_str(), &info) == 0) && S_ISSOCK(info.st_mode)) {
+		unlink(socketpath.c_str());
+	}
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		cerr << "Error: cannot create socket: " << strerror(errno) << endl;
+		return false;
+	}
+	if ((::bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+			(chmod(socketpath.c_str(), 0600) != 0) ||
+			(listen(listener, 64) != 0)) {
+		cerr << "Error: cannot listen on " << socketpath << ": "
+		     << strerror(errno) << endl;
+		::close(listener);
+		return false;
+	}
+
+	// The worker threads write to this pipe when they return a connection,
+	// so that the poll() below includes it without waiting for the timeout:
+	if (pipe(m_wakeup) != 0) {
+		cerr << "Error: cannot create pipe: " << strerror(errno) << endl;
+		::close(listener);
+		unlink(socketpath.c_str());
+		return false;
+	}
+	fcntl(m_wakeup[1], F_SETFL, fcntl(m_wakeup[1], F_GETFL) | O_NONBLOCK);
+
+	m_stop = false;
+	HumThreadPool pool(jobs);
+	// waiting: connections which are waiting for their next request.
+	vector<std::shared_ptr<Connection>> waiting;
+	vector<struct pollfd> polled;
+	// trimmed: the number of requests when the memory pool was last trimmed.
+	long long trimmed = 0;
+	while (!m_stop) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			waiting.insert(waiting.end(), m_returned.begin(), m_returned.end());
+			m_returned.clear();
+		}
+
+		// Check for stop() at least five times a second:
+		polled.resize(waiting.size() + 2);
+		polled[0].fd = listener;
+		polled[1].fd = m_wakeup[0];
+		for (int i=0; i<(int)waiting.size(); i++) {
+			polled[i+2].fd = waiting[i]->fd;
+		}
+		for (auto& item : polled) {
+			item.events = POLLIN;
+			item.revents = 0;
+		}
+		int ready = poll(polled.data(), polled.size(), 200);
+		if ((ready == 0) && (m_requests != trimmed)) {
+			// No requests have arrived for a while, so give the memory of
+			// the files used by earlier requests back to the system:
+			trimmed = m_requests;
+			HumPool::trim();
+		}
+		if (ready <= 0) {
+			continue;
+		}
+		if (polled[1].revents) {
+			char bytes[256];
+			if (read(m_wakeup[0], bytes, sizeof(bytes)) < 0) {
+				// nothing to do: the returned connections are checked anyway
+			}
+		}
+
+		// Answer the connections with a request (or which have been closed)
+		// on a worker thread, and stop polling them until they are returned:
+		int kept = 0;
+		for (int i=0; i<(int)waiting.size(); i++) {
+			if (polled[i+2].revents) {
+				std::shared_ptr<Connection> connection = waiting[i];
+				pool.submit([this, connection]() { serveRequests(connection); });
+			} else {
+				waiting[kept++] = waiting[i];
+			}
+		}
+		waiting.resize(kept);
+
+		if (!polled[0].revents) {
+			continue;
+		}
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0) {
+			continue;
+		}
+		#ifdef SO_NOSIGPIPE
+			int on = 1;
+			setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+		#endif
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_connections.insert(fd);
+		}
+		waiting.push_back(std::make_shared<Connection>());
+		waiting.back()->fd = fd;
+	}
+	::close(listener);
+	unlink(socketpath.c_str());
+
+	// Stop reading requests from open connections, then wait for the
+	// requests in progress to finish:
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (int fd : m_connections) {
+			shutdown(fd, SHUT_RD);
+		}
+	}
+	pool.wait();
+
+	// Close the connections which are waiting for a request:
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		waiting.insert(waiting.end(), m_returned.begin(), m_returned.end());
+		m_returned.clear();
+	}
+	for (auto& connection : waiting) {
+		closeConnection(*connection);
+	}
+	::close(m_wakeup[0]);
+	::close(m_wakeup[1]);
+	m_wakeup[0] = -1;
+	m_wakeup[1] = -1;
+	return true;
+#else
+	cerr << "Error: sockets are not available on this system" << endl;
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::stop -- Make serve() return.  This can be called from
+//     a signal handler.
+//
+
+void HumToolServer::stop(void) {
+	m_stop = true;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::serveRequests -- Answer the request on a connection
+//     which has data to read (and any further requests which have
+//     already been received with it), then return the connection to
+//     serve() to wait for its next request.  The connection is closed
+//     if the client has closed it or the server is stopping.
+//
+
+void HumToolServer::serveRequests(std::shared_ptr<Connection> connection) {
+#ifdef HUMLIB_SOCKETS
+	bool open = true;
+	std::map<string, string> fields;
+	do {
+		open = readMessage(connection->fd, connection->buffer, fields);
+		if (!open) {
+			break;
+		}
+		Request request;
+		request.command  = fields["command"];
+		request.tools    = fields["tools"];
+		request.options  = fields["options"];
+		request.filename = fields["file"];
+		request.data     = fields["data"];
+		Response response;
+		try {
+			handleRequest(request, response);
+		} catch (const std::exception& e) {
+			response = Response();
+			response.error = string(e.what()) + "\n";
+		}
+		vector<pair<string, string>> output = {
+			{ "status",  response.status ? "1" : "0" },
+			{ "humdrum", response.humdrum },
+			{ "json",    response.json },
+			{ "text",    response.text },
+			{ "warning", response.warning },
+			{ "error",   response.error }
+		};
+		open = writeMessage(connection->fd, output);
+	} while (open && !m_stop && !connection->buffer.empty());
+
+	if (!open || m_stop) {
+		closeConnection(*connection);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_returned.push_back(connection);
+	char byte = 0;
+	if (write(m_wakeup[1], &byte, 1) < 0) {
+		// The pipe is full, so serve() will be woken up anyway.
+	}
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::closeConnection -- Close a connection to the server.
+//
+
+void HumToolServer::closeConnection(Connection& connection) {
+#ifdef HUMLIB_SOCKETS
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_connections.erase(connection.fd);
+	}
+	::close(connection.fd);
+	connection.fd = -1;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::sendRequest -- Send a request to a server listening on
+//     the given socket, and wait for the response.  Returns false if the
+//     server cannot be reached, or if the request failed.  Use a Client
+//     to send several requests on the same connection.
+//
+
+bool HumToolServer::sendRequest(const string& socketpath,
+		const Request& request, Response& response) {
+	response = Response();
+	Client client;
+	if (!client.connect(socketpath, response.error)) {
+		return false;
+	}
+	return client.send(request, response);
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::Client --
+//
+
+HumToolServer::Client::Client(void) : m_fd(-1) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::~Client -- Close the connection.
+//
+
+HumToolServer::Client::~Client() {
+	close();
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::connect -- Connect to a server listening on
+//     the given socket (closing any previous connection).  Returns false
+//     and sets the error message if the server cannot be reached.
+//
+
+bool HumToolServer::Client::connect(const string& socketpath, string& error) {
+	close();
+#ifdef HUMLIB_SOCKETS
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketpath.empty() || (socketpath.size() >= sizeof(address.sun_path))) {
+		error = "invalid socket path: " + socketpath + "\n";
+		return false;
+	}
+	strncpy(address.sun_path, socketpath.c_str(), sizeof(address.sun_path) - 1);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		error = string("cannot create socket: ") + strerror(errno) + "\n";
+		return false;
+	}
+	#ifdef SO_NOSIGPIPE
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	#endif
+	if (::connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		error = "cannot connect to " + socketpath + ": " + strerror(errno) + "\n";
+		::close(fd);
+		return false;
+	}
+	m_fd = fd;
+	return true;
+#else
+	error = "sockets are not available on this system\n";
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::isConnected -- Return true if the client has
+//     an open connection.
+//
+
+bool HumToolServer::Client::isConnected(void) const {
+	return m_fd >= 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::close -- Close the connection to the server.
+//
+
+void HumToolServer::Client::close(void) {
+#ifdef HUMLIB_SOCKETS
+	if (m_fd >= 0) {
+		::close(m_fd);
+	}
+#endif
+	m_fd = -1;
+	m_buffer.clear();
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::Client::send -- Send a request on the connection, and
+//     wait for the response.  Returns false if the request failed.  The
+//     connection is closed if the server does not answer.
+//
+
+bool HumToolServer::Client::send(const Request& request, Response& response) {
+	response = Response();
+	if (m_fd < 0) {
+		response.error = "not connected to a server\n";
+		return false;
+	}
+	vector<pair<string, string>> input = {
+		{ "command", request.command },
+		{ "tools",   request.tools },
+		{ "options", request.options },
+		{ "file",    request.filename },
+		{ "data",    request.data }
+	};
+	std::map<string, string> fields;
+	if (!writeMessage(m_fd, input) || !readMessage(m_fd, m_buffer, fields)) {
+		response.error = "no response from server\n";
+		close();
+		return false;
+	}
+	response.status  = fields["status"] == "1";
+	response.humdrum = fields["humdrum"];
+	response.json    = fields["json"];
+	response.text    = fields["text"];
+	response.warning = fields["warning"];
+	response.error   = fields["error"];
+	return response.status;
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::getDefaultSocket -- Return the socket used by the
+//     server and client programs if no socket is given:
+//     $XDG_RUNTIME_DIR/humserver.sock, or else /tmp/humserver-<uid>.sock.
+//
+
+string HumToolServer::getDefaultSocket(void) {
+	const char* directory = getenv("XDG_RUNTIME_DIR");
+	if (directory && directory[0]) {
+		return string(directory) + "/humserver.sock";
+	}
+#ifdef HUMLIB_SOCKETS
+	return "/tmp/humserver-" + to_string((long long)getuid()) + ".sock";
+#else
+	return "humserver.sock";
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::readMessage -- Read the fields of a message.  The
+//     buffer stores data which has been read from the socket but not yet
+//     used, and should be kept between messages on the same connection.
+//     Returns false if the connection was closed or the message is
+//     malformed.
+//
+
+bool HumToolServer::readMessage(int fd, string& buffer,
+		std::map<string, string>& fields) {
+	fields.clear();
+#ifdef HUMLIB_SOCKETS
+	size_t position = 0;
+	char chunk[65536];
+
+	// Make sure that the buffer has "size" bytes after position:
+	auto fill = [&](size_t size) {
+		while (buffer.size() - position < size) {
+			ssize_t count = recv(fd, chunk, sizeof(chunk), 0);
+			if ((count < 0) && (errno == EINTR)) {
+				continue;
+			}
+			if (count <= 0) {
+				return false;
+			}
+			buffer.append(chunk, (size_t)count);
+		}
+		return true;
+	};
+
+	while (true) {
+		// Read the field header:
+		size_t newline;
+		while ((newline = buffer.find('\n', position)) == string::npos) {
+			if ((buffer.size() - position > 1024) || !fill(buffer.size() - position + 1)) {
+				return false;
+			}
+		}
+		string header = buffer.substr(position, newline - position);
+		position = newline + 1;
+		size_t space = header.find(' ');
+		if ((space == string::npos) || (space == 0)) {
+			return false;
+		}
+		string name = header.substr(0, space);
+		char* end = NULL;
+		unsigned long long length = strtoull(header.c_str() + space + 1, &end, 10);
+		if ((end == header.c_str() + space + 1) || (*end != '\0')) {
+			return false;
+		}
+		if (name == "end") {
+			break;
+		}
+		if (!fill((size_t)length)) {
+			return false;
+		}
+		fields[name] = buffer.substr(position, (size_t)length);
+		position += (size_t)length;
+	}
+	buffer.erase(0, position);
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::writeMessage -- Send the fields of a message.
+//
+
+bool HumToolServer::writeMessage(int fd, const vector<pair<string, string>>& fields) {
+	string output;
+	for (auto& field : fields) {
+		output += field.first;
+		output += ' ';
+		output += to_string(field.second.size());
+		output += '\n';
+		output += field.second;
+	}
+	output += "end 0\n";
+	return writeData(fd, output.data(), output.size());
+}
+
+
+
+//////////////////////////////
+//
+// HumToolServer::writeData -- Write all of the data to a socket.
+//
+
+bool HumToolServer::writeData(int fd, const char* data, size_t size) {
+#ifdef HUMLIB_SOCKETS
+	while (size > 0) {
+		ssize_t count = send(fd, data, size, HUMTOOLSERVER_SEND_FLAGS);
+		if ((count < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (count <= 0) {
+			return false;
+		}
+		data += count;
+		size -= (size_t)count;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+// END_MERGE
+
+} // end namespace hum
+
+
+
@@ -16,6 +16,7 @@
 //
 
 #include "Convert.h"
+#include "HumFieldScanner.h"
 #include "HumRegex.h"
 #include "HumdrumFileBase.h"
 
@@ -24,6 +25,13 @@
 #include <fstream>
 #include <sstream>
 
+#ifdef HUMLIB_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
 using namespace std;
 
 namespace hum {
@@ -37,6 +45,7 @@ namespace hum {
 //
 
 HumdrumFileBase::HumdrumFileBase(void) : HumHash() {
+	setAnalysisOwner(FileAnalysisOwner);
 	addToTrackStarts(NULL);
 	m_ticksperquarternote = -1;
 	m_quietParse = false;
@@ -44,6 +53,7 @@ HumdrumFileBase::HumdrumFileBase(void) : HumHash() {
 }
 
 HumdrumFileBase::HumdrumFileBase(const string& filename) : HumHash() {
+	setAnalysisOwner(FileAnalysisOwner);
 	addToTrackStarts(NULL);
 	m_ticksperquarternote = -1;
 	m_quietParse = false;
@@ -52,6 +62,7 @@ HumdrumFileBase::HumdrumFileBase(const string& filename) : HumHash() {
 }
 
 HumdrumFileBase::HumdrumFileBase(istream& contents) : HumHash() {
+	setAnalysisOwner(FileAnalysisOwner);
 	addToTrackStarts(NULL);
 	m_ticksperquarternote = -1;
 	m_quietParse = false;
@@ -65,7 +76,8 @@ HumdrumFileBase::HumdrumFileBase(istream& contents) : HumHash() {
 // using the following constructor:
 //
 
-HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) {
+HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) : HumHash() {
+	setAnalysisOwner(FileAnalysisOwner);
 
 	m_filename = infile.m_filename;
 	m_segmentlevel = infile.m_segmentlevel;
@@ -81,6 +93,7 @@ HumdrumFileBase::HumdrumFileBase(HumdrumFileBase& infile) {
 	m_quietParse = infile.m_quietParse;
 	m_parseError = infile.m_parseError;
 	m_displayError = infile.m_displayError;
+	m_readAnalyses = infile.m_readAnalyses;
 
 	m_lines.resize(infile.m_lines.size());
 	for (int i=0; i<(int)m_lines.size(); i++) {
@@ -119,6 +132,7 @@ HumdrumFileBase& HumdrumFileBase::operator=(HumdrumFileBase& infile) {
 	m_quietParse = infile.m_quietParse;
 	m_parseError = infile.m_parseError;
 	m_displayError = infile.m_displayError;
+	m_readAnalyses = infile.m_readAnalyses;
 
 	m_lines.resize(infile.m_lines.size());
 	for (int i=0; i<(int)m_lines.size(); i++) {
@@ -169,8 +183,31 @@ void HumdrumFileBase::clear(void) {
 	m_strophes1d.clear();
 	m_strophes2d.clear();
 	m_filename.clear();
+	m_parseError.clear();
 	m_segmentlevel = 0;
 	m_analyses.clear();
+	detachAnalysisValues();
+	m_analysisValues.reset();
+	m_snapshotPending = false;
+	m_editedTokens = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getAnalysisStore -- Return the store for "auto"
+//     parameters of the file and of its lines and tokens.  The store is
+//     created when the first value is stored (or returned as NULL before
+//     then if create is false), and deleted when the file is cleared.
+// default value: create = true
+//
+
+HumAnalysisStore* HumdrumFileBase::getAnalysisStore(bool create) {
+	if (!m_analysisValues && create) {
+		m_analysisValues.reset(new HumAnalysisStore);
+	}
+	return m_analysisValues.get();
 }
 
 
@@ -181,7 +218,7 @@ void HumdrumFileBase::clear(void) {
 //
 
 bool HumdrumFileBase::isStructureAnalyzed(void) {
-	return m_analyses.m_structure_analyzed;
+	return m_analyses.isAnalyzed(HumFileAnalysis::Structure);
 }
 
 
@@ -192,7 +229,7 @@ bool HumdrumFileBase::isStructureAnalyzed(void) {
 //
 
 bool HumdrumFileBase::isRhythmAnalyzed(void) {
-	return m_analyses.m_rhythm_analyzed;
+	return m_analyses.isAnalyzed(HumFileAnalysis::Rhythm);
 }
 
 
@@ -203,18 +240,238 @@ bool HumdrumFileBase::isRhythmAnalyzed(void) {
 //
 
 bool HumdrumFileBase::areStrandsAnalyzed(void) {
-	return m_analyses.m_strands_analyzed;
+	return m_analyses.isAnalyzed(HumFileAnalysis::Strands);
 }
 
 
 
 //////////////////////////////
 //
-// HumdrumFileBase::areStrandsAnalyzed --
+// HumdrumFileBase::areStrophesAnalyzed --
 //
 
 bool HumdrumFileBase::areStrophesAnalyzed(void) {
-	return m_analyses.m_strophes_analyzed;
+	return m_analyses.isAnalyzed(HumFileAnalysis::Strophes);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::isAnalyzed -- Returns true if the given analysis
+//     (such as HumFileAnalysis::Slurs) has been done on the file.
+//
+
+bool HumdrumFileBase::isAnalyzed(int type) const {
+	return m_analyses.isAnalyzed(type);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::requireAnalysis -- Run an analysis on the file if it
+//     has not been done yet.  Any analyses that it depends on are run
+//     first.  Files with parse errors are not analyzed, as when they are
+//     read.  Returns false if the file is not valid after the analysis.
+//
+
+bool HumdrumFileBase::requireAnalysis(int type) {
+	if ((type < 0) || (type >= HumFileAnalysis::Count) || !isValid()) {
+		return isValid();
+	}
+	if (m_analyses.isAnalyzed(type)) {
+		return isValid();
+	}
+	unsigned dependencies = HumFileAnalysis::getDependencies(type);
+	for (int i=0; i<HumFileAnalysis::Count; i++) {
+		if (dependencies & HumFileAnalysis::getMask(i)) {
+			if (!requireAnalysis(i)) {
+				return false;
+			}
+		}
+	}
+	if (m_analyses.isAnalyzed(type)) {
+		// done as a side effect of one of the dependencies.
+		return isValid();
+	}
+	bool status = runAnalysis(type);
+	m_analyses.setAnalyzed(type);
+	return status && isValid();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::requireAnalyses -- Run each analysis in a bit mask of
+//     analysis types (see requireAnalysis()).
+//
+
+bool HumdrumFileBase::requireAnalyses(unsigned mask) {
+	for (int i=0; i<HumFileAnalysis::Count; i++) {
+		if (mask & HumFileAnalysis::getMask(i)) {
+			if (!requireAnalysis(i)) {
+				return isValid();
+			}
+		}
+	}
+	return isValid();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::setReadAnalyses -- Set the analyses which are done
+//     when reading data with HumdrumFileStructure::read() and the
+//     similar functions.  The input is a bit mask of analysis types, such
+//     as HumFileAnalysis::getMask(HumFileAnalysis::Rhythm).  Analyses which
+//     are not done when reading are done later, the first time that
+//     they are needed.  The default is HumFileAnalysis::ReadDefault.
+//
+
+void HumdrumFileBase::setReadAnalyses(unsigned mask) {
+	m_readAnalyses = mask;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::getReadAnalyses -- Return the bit mask of analyses
+//     which are done when reading data.
+//
+
+unsigned HumdrumFileBase::getReadAnalyses(void) const {
+	return m_readAnalyses;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::reanalyzeTokens -- Redo the analyses which depend on
+//     the text of the tokens (null resolution, strophes, parameters,
+//     durations, rhythm and any content analyses), keeping the lines,
+//     tokens, spine links, tracks and strands of the file.  This is
+//     for tokens which were changed in place by setText(), with no lines
+//     or tokens added or removed, and no changes to spine manipulators
+//     or exclusive interpretations.  The results are the same as reading
+//     the text of the file again with the analyses in getReadAnalyses().
+//
+
+bool HumdrumFileBase::reanalyzeTokens(void) {
+	clearAnalysisInfo();
+	bool strands = m_analyses.isAnalyzed(HumFileAnalysis::Strands);
+	m_analyses.clear();
+	m_analyses.setAnalyzed(HumFileAnalysis::Strands, strands);
+	m_editedTokens = false;
+	return requireAnalyses(m_readAnalyses);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::hasEditedTokens -- Returns true if the text of any
+//     token was changed with HumdrumToken::setText() since the file was
+//     read, or since the last call to reanalyzeTokens() or
+//     setEditedTokens(false).  The analyses of the file may then be out
+//     of date.
+//
+
+bool HumdrumFileBase::hasEditedTokens(void) const {
+	return m_editedTokens;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::setEditedTokens -- Mark the tokens of the file as
+//     edited (called by HumdrumToken::setText()), or clear the mark.
+//
+
+void HumdrumFileBase::setEditedTokens(bool state) {
+	m_editedTokens = state;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::clearAnalysisInfo -- Remove the results of the analyses
+//     from the lines and tokens of the file (but not the spine links and
+//     tracks), and the lists of barlines, strophes and signifiers.
+//
+
+void HumdrumFileBase::clearAnalysisInfo(void) {
+	for (int i=0; i<(int)m_lines.size(); i++) {
+		HumdrumLine& line = *m_lines[i];
+		line.clearParameters();
+		line.m_linkedParameters.clear();
+		line.m_duration = -1;
+		line.m_durationFromStart = -1;
+		line.m_durationFromBarline = 0;
+		line.m_durationToBarline = 0;
+		line.m_rhythm_analyzed = false;
+		for (int j=0; j<(int)line.m_tokens.size(); j++) {
+			HumdrumToken& token = *line.m_tokens[j];
+			token.clearParameters();
+			token.m_linkedParameterTokens.clear();
+			if (token.m_parameterSet) {
+				delete token.m_parameterSet;
+				token.m_parameterSet = NULL;
+			}
+			token.m_nextNonNullTokens.clear();
+			token.m_previousNonNullTokens.clear();
+			token.m_duration = 0;
+			token.m_rhycheck = 0;
+			token.m_rhythm_analyzed = false;
+			token.m_nullresolve = NULL;
+			token.m_strophe = NULL;
+			token.clearKernRecord();
+		}
+	}
+	m_barlines.clear();
+	m_strophes1d.clear();
+	m_strophes2d.clear();
+	m_signifiers.clear();
+	m_ticksperquarternote = -1;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::analyzeForRead -- Run the analyses which were selected
+//     with setReadAnalyses().  If the file was not found in the snapshot
+//     cache when it was read, a snapshot is saved after the analyses.
+//
+
+bool HumdrumFileBase::analyzeForRead(void) {
+	bool status = requireAnalyses(m_readAnalyses);
+	if (m_snapshotPending) {
+		m_snapshotPending = false;
+		if (status) {
+			HumSnapshot::writeCache(*this, m_snapshotKey);
+		}
+	}
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::runAnalysis -- Do a single analysis on the file.  No
+//     analyses are done at this level: HumdrumFileStructure and
+//     HumdrumFileContent handle the analyses of their data.
+//
+
+bool HumdrumFileBase::runAnalysis(int type) {
+	return true;
 }
 
 
@@ -333,6 +590,8 @@ bool HumdrumFileBase::read(const char* filename) {
 	ifstream infile;
 	if (fname.empty() || (fname ==  "-")) {
 		return HumdrumFileBase::read(cin);
+	} else if (readMappedFile(filename)) {
+		return isValid();
 	} else {
 		infile.open(filename);
 		if (!infile.is_open()) {
@@ -360,6 +619,184 @@ bool HumdrumFileBase::read(istream& contents) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::readBuffer -- Read Humdrum content from a block of
+//    memory, such as a memory-mapped file.  Line boundaries are located
+//    in a single pass over the buffer, and each line's text is copied
+//    only once (directly into the HumdrumLine, which then splits it into
+//    tokens).  Line splitting is identical to std::getline(): a final
+//    line without a trailing newline is kept, and a trailing newline
+//    does not generate an extra empty line.  If a snapshot cache is set,
+//    the analyses may be loaded from the cache (see analyzeBaseFromCache()).
+//
+
+bool HumdrumFileBase::readBuffer(const char* contents, size_t size) {
+	clear();
+	m_displayError = true;
+	if ((contents == NULL) || (size == 0)) {
+		return analyzeBaseFromLines();
+	}
+	std::uint64_t key = 0;
+	if (HumSnapshot::isCacheEnabled()) {
+		key = HumSnapshot::getContentKey(contents, size);
+	}
+	splitBuffer(contents, size);
+	return analyzeBaseFromCache(key);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::splitBuffer -- Add the lines in a block of memory to
+//    the file, without splitting them into tokens (see readBuffer()).
+//
+
+void HumdrumFileBase::splitBuffer(const char* contents, size_t size) {
+	// Rough guess at the line count to avoid repeated reallocation
+	// of the line list:
+	m_lines.reserve(m_lines.size() + size / 40 + 1);
+	const char* start = contents;
+	const char* end = contents + size;
+	HLp s;
+	while (start < end) {
+		const char* newline = (const char*)memchr(start, '\n', end - start);
+		const char* stop = newline ? newline : end;
+		size_t length = stop - start;
+		if ((length > 0) && (start[length-1] == 0x0d)) {
+			length--;
+		}
+		s = new HumdrumLine;
+		s->assign(start, length);
+		s->setOwner(this);
+		m_lines.push_back(s);
+		if (newline == NULL) {
+			break;
+		}
+		start = newline + 1;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readSnapshot -- Read Humdrum content from a string,
+//    loading the analyses from a snapshot of the same content which was
+//    stored with writeSnapshot().  This is faster than reading the
+//    content with readString(), so it is used to keep analyzed files in
+//    memory (such as in HumFileCache) while giving each reader its own
+//    copy of the file which can be changed.  If the snapshot cannot be
+//    used, the content is analyzed as in readString().
+//
+
+bool HumdrumFileBase::readSnapshot(const string& contents,
+		const string& snapshot) {
+	clear();
+	m_displayError = false;
+	m_snapshotPending = false;
+	splitBuffer(contents.data(), contents.size());
+	HumSnapshot reader;
+	if (snapshot.empty() || !reader.readString(*this, snapshot)) {
+		if (!analyzeBaseFromLines()) {
+			return isValid();
+		}
+	}
+	return analyzeForRead();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::writeSnapshot -- Store the analyses of the file in a
+//    string for use with readSnapshot().  Returns false if the file
+//    cannot be stored in a snapshot.
+//
+
+bool HumdrumFileBase::writeSnapshot(string& snapshot) {
+	HumSnapshot writer;
+	return writer.writeString(*this, snapshot);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readLines -- Read Humdrum content from a list of
+//    lines, each given as a pointer to its text and the length of the
+//    text (not including a newline).  This allows a file to be parsed
+//    from pieces of a larger buffer without first copying them into a
+//    single string.
+//
+
+bool HumdrumFileBase::readLines(const vector<pair<const char*, size_t>>& lines) {
+	clear();
+	m_displayError = true;
+	m_lines.reserve(lines.size());
+	HLp s;
+	for (int i=0; i<(int)lines.size(); i++) {
+		size_t length = lines[i].second;
+		if ((length > 0) && (lines[i].first[length-1] == 0x0d)) {
+			length--;
+		}
+		s = new HumdrumLine;
+		s->assign(lines[i].first, length);
+		s->setOwner(this);
+		m_lines.push_back(s);
+	}
+	std::uint64_t key = 0;
+	if (HumSnapshot::isCacheEnabled()) {
+		key = HumSnapshot::getContentKey(lines);
+	}
+	return analyzeBaseFromCache(key);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::readMappedFile -- Memory-map a regular file and
+//    read its contents with readBuffer().  Returns false without
+//    changing the file contents if the file cannot be mapped (such as
+//    for pipes or on systems without mmap), in which case the caller
+//    should fall back to reading the file through an input stream.
+//
+
+bool HumdrumFileBase::readMappedFile(const char* filename) {
+#ifdef HUMLIB_MMAP
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode)) {
+		::close(fd);
+		return false;
+	}
+	size_t size = (size_t)info.st_size;
+	if (size == 0) {
+		::close(fd);
+		readBuffer(NULL, 0);
+		return true;
+	}
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	madvise(data, size, MADV_SEQUENTIAL);
+	readBuffer((const char*)data, size);
+	munmap(data, size);
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::readCsv -- Read a Humdrum file in CSV format
@@ -368,7 +805,7 @@ bool HumdrumFileBase::read(istream& contents) {
 //
 
 bool HumdrumFileBase::readCsv(const string& filename, const string& separator) {
-	return HumdrumFileBase::readCsv(filename.c_str());
+	return HumdrumFileBase::readCsv(filename.c_str(), separator);
 }
 
 
@@ -390,15 +827,33 @@ bool HumdrumFileBase::readCsv(const char* filename, const string& separator) {
 
 bool HumdrumFileBase::readCsv(istream& contents, const string& separator) {
 	m_displayError = true;
-	char buffer[123123] = {0};
+	string buffer((istreambuf_iterator<char>(contents)), istreambuf_iterator<char>());
+	splitCsvBuffer(buffer.data(), buffer.size(), separator);
+	return analyzeBaseFromLines();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileBase::splitCsvBuffer -- Convert the CSV records in a block of
+//    memory into lines of the file (see HumFieldScanner::csvToTsv()).  As
+//    with splitBuffer(), a trailing newline does not generate an extra
+//    empty line.
+//
+
+void HumdrumFileBase::splitCsvBuffer(const char* contents, size_t size,
+		const string& separator) {
+	m_lines.reserve(m_lines.size() + size / 40 + 1);
+	const char* start = contents;
+	const char* end = contents + size;
 	HLp s;
-	while (contents.getline(buffer, sizeof(buffer), '\n')) {
+	while (start < end) {
 		s = new HumdrumLine;
-		s->setLineFromCsv(buffer);
+		start = HumFieldScanner::csvToTsv(start, end, separator, *s);
 		s->setOwner(this);
 		m_lines.push_back(s);
 	}
-	return analyzeBaseFromLines();
 }
 
 
@@ -419,6 +874,31 @@ bool HumdrumFileBase::analyzeBaseFromLines(void)  {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::analyzeBaseFromCache -- Analyze the lines which were
+//     read from contents with the given key.  If a snapshot cache
+//     directory is set (see HumSnapshot::setCacheDirectory()), the
+//     analyses are loaded from the cache when possible, which includes
+//     the read analyses selected with setReadAnalyses().  Otherwise the
+//     lines are analyzed, and analyzeForRead() will save a snapshot.
+//
+
+bool HumdrumFileBase::analyzeBaseFromCache(std::uint64_t key) {
+	m_snapshotPending = false;
+	if (!HumSnapshot::isCacheEnabled()) {
+		return analyzeBaseFromLines();
+	}
+	if (HumSnapshot::readCache(*this, key)) {
+		return isValid();
+	}
+	m_snapshotKey = key;
+	m_snapshotPending = true;
+	return analyzeBaseFromLines();
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::setFilenameFromSegment -- Update filename based on any
@@ -475,17 +955,15 @@ bool HumdrumFileBase::analyzeBaseFromTokens(void) {
 //
 
 bool HumdrumFileBase::readString(const string& contents) {
-	stringstream infile;
-	infile << contents;
-	bool status = read(infile);
-	return status;
+	return readBuffer(contents.data(), contents.size());
 }
 
 
 bool HumdrumFileBase::readString(const char* contents) {
-	stringstream infile;
-	infile << contents;
-	return read(infile);
+	if (contents == NULL) {
+		return readBuffer(NULL, 0);
+	}
+	return readBuffer(contents, strlen(contents));
 }
 
 
@@ -497,17 +975,17 @@ bool HumdrumFileBase::readString(const char* contents) {
 
 bool HumdrumFileBase::readStringCsv(const char* contents,
 		const string& separator) {
-	stringstream infile;
-	infile << contents;
-	return readCsv(infile, separator);
+	m_displayError = true;
+	splitCsvBuffer(contents, strlen(contents), separator);
+	return analyzeBaseFromLines();
 }
 
 
 bool HumdrumFileBase::readStringCsv(const string& contents,
 		const string& separator) {
-	stringstream infile;
-	infile << contents;
-	return readCsv(infile, separator);
+	m_displayError = true;
+	splitCsvBuffer(contents.data(), contents.size(), separator);
+	return analyzeBaseFromLines();
 }
 
 
@@ -899,7 +1377,9 @@ void HumdrumFileBase::insertLine(int index, HLp line) {
 // HumdrumFileBase::deleteLine -- remove a line from the Humdrum file.
 //    Is best used for global comments and reference records for now.
 //    Other line types will cause parsing problems untill further
-//    generalized to stitch previous next lines together.
+//    generalized to stitch previous next lines together (use
+//    HumdrumFileStructure::editDeleteLine() to delete other lines).
+//    The line indexes of the following lines are updated.
 //
 
 void HumdrumFileBase::deleteLine(int index) {
@@ -912,6 +1392,7 @@ void HumdrumFileBase::deleteLine(int index) {
 	delete m_lines[index];
 	for (int i=index+1; i<(int)m_lines.size(); i++) {
 		m_lines[i-1] = m_lines[i];
+		m_lines[i-1]->setLineIndex(i-1);
 	}
 	m_lines.resize(m_lines.size() - 1);
 }
@@ -1533,11 +2014,43 @@ bool HumdrumFileBase::analyzeTracks(void) {
 			return false;
 		}
 	}
+	analyzeDataTypes();
 	return isValid();
 }
 
 
 
+//////////////////////////////
+//
+// HumdrumFileBase::analyzeDataTypes -- Store the HumDataType id of the
+//    exclusive interpretation for each track in the tokens of the track.
+//    Tokens not in a track are given HumDataType::None.
+//
+
+void HumdrumFileBase::analyzeDataTypes(void) {
+	vector<int> ids(m_trackstarts.size(), HumDataType::None);
+	for (int i=1; i<(int)m_trackstarts.size(); i++) {
+		if (m_trackstarts[i]) {
+			ids[i] = HumDataType::getId(*m_trackstarts[i]);
+		}
+	}
+	int trackcount = (int)ids.size();
+	for (int i=0; i<(int)m_lines.size(); i++) {
+		HumdrumLine& line = *m_lines[i];
+		for (int j=0; j<line.getTokenCount(); j++) {
+			HTp token = line.token(j);
+			int track = token->getTrack();
+			if ((track > 0) && (track < trackcount)) {
+				token->setDataTypeId(ids[track]);
+			} else {
+				token->setDataTypeId(HumDataType::None);
+			}
+		}
+	}
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileBase::analyzeLinks -- Generate forward and backwards spine links
@@ -2050,12 +2563,15 @@ bool HumdrumFileBase::analyzeNonNullDataTokens(void) {
 
 	vector<HTp> stops;
 	getSpineStopList(stops);
-	HTp nexts = NULL;
 
 	for (int i=0; i<(int)stops.size(); i++) {
 		if (stops[i] == NULL) {
 			continue;
 		}
+		// Tokens after the last non-null data token in a spine do not
+		// have a next non-null data token (rather than the first one
+		// in the previous spine):
+		HTp nexts = NULL;
 		HTp token = stops[i];
 		if (token->isData() && !token->isNull()) {
 			nexts = token;
@@ -2180,7 +2696,7 @@ bool HumdrumFileBase::processNonNullDataTokensForTrackForward(HTp starttoken,
 //    variable in HumdrumTokens)
 //
 
-void HumdrumFileBase::addUniqueTokens(vector<HTp>& target,
+void HumdrumFileBase::addUniqueTokens(HumTokenLinks& target,
 		vector<HTp>& source) {
 	int i, j;
 	bool found;
@@ -26,6 +26,7 @@ namespace hum {
 //
 
 bool HumdrumFileContent::analyzeAccidentals(void) {
+	m_analyses.setAnalyzed(HumFileAnalysis::Accidentals);
 	bool status = true;
 	status &= analyzeKernAccidentals();
 	status &= analyzeMensAccidentals();
@@ -30,11 +30,11 @@ namespace hum {
 //
 
 void HumdrumFileContent::analyzeBarlines(void) {
-	if (m_analyses.m_barlines_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Barlines)) {
 		// Maybe allow forcing reanalysis.
 		return;
 	}
-	m_analyses.m_barlines_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Barlines);
 	m_analyses.m_barlines_different = false;
 
 	string baseline;
@@ -167,9 +167,7 @@ bool HumdrumFileContent::hasDataStraddle(int line) {
 //
 
 bool HumdrumFileContent::hasDifferentBarlines(void) {
-	if (!m_analyses.m_barlines_analyzed) {
-		analyzeBarlines();
-	}
+	requireAnalysis(HumFileAnalysis::Barlines);
 	return m_analyses.m_barlines_different;
 }
 
@@ -29,10 +29,10 @@ namespace hum {
 //
 
 bool HumdrumFileContent::analyzeBeams(void) {
-	if (m_analyses.m_beams_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Beams)) {
 		return false;
 	}
-	m_analyses.m_beams_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Beams);
 	bool output = true;
 	output &= analyzeKernBeams();
 	output &= analyzeMensBeams();
@@ -279,7 +279,7 @@ bool HumdrumFileContent::analyzeKernBeams(HTp spinestart,
 							// This is a beam closing that does not have a matching opening.
 							token->setValue("auto", "hangingBeam", "true");
 							token->setValue("auto", "beamSide", "stop");
-							token->setValue("auto", "beamOpenIndex", to_string(i));
+							token->setValue("auto", "beamOpenIndex", i);
 							token->setValue("auto", "beamDuration",
 								token->getDurationToEnd());
 						}
@@ -91,7 +91,7 @@ void HumdrumFileContent::analyzeOttavas(void) {
 					// do not exclude rests, since the vertical placement
 					// of the staff may need to be updated by the ottava mark.
 				}
-				token->setValue("auto", "ottava", to_string(octavestate[track]));
+				token->setValue("auto", "ottava", octavestate[track]);
 			}
 		}
 	}
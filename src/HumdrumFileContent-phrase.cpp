@@ -29,10 +29,10 @@ namespace hum {
 //
 
 bool HumdrumFileContent::analyzePhrasings(void) {
-	if (m_analyses.m_phrases_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Phrases)) {
 		return false;
 	}
-	m_analyses.m_phrases_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Phrases);
 	bool output = true;
 	output &= analyzeKernPhrasings();
 	return output;
@@ -206,7 +206,7 @@ bool HumdrumFileContent::analyzeKernPhrasings(HTp spinestart,
 							// This is a phrase closing that does not have a matching opening.
 							token->setValue("auto", "hangingPhrase", "true");
 							token->setValue("auto", "phraseSide", "stop");
-							token->setValue("auto", "phraseOpenIndex", to_string(i));
+							token->setValue("auto", "phraseOpenIndex", i);
 							token->setValue("auto", "phraseDuration",
 								token->getDurationToEnd());
 						}
@@ -362,8 +362,8 @@ void HumdrumFileContent::linkPhraseEndpoints(HTp phrasestart, HTp phraseend) {
 	HumNum duration = phraseend->getDurationFromStart()
 			- phrasestart->getDurationFromStart();
 	phrasestart->setValue("auto", durtag, duration);
-	phrasestart->setValue("auto", "phraseEndCount", to_string(phraseEndCount));
-	phraseend->setValue("auto", "phraseStartCount", to_string(phraseStartCount));
+	phrasestart->setValue("auto", "phraseEndCount", phraseEndCount);
+	phraseend->setValue("auto", "phraseStartCount", phraseStartCount);
 }
 
 
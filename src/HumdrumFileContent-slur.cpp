@@ -29,10 +29,10 @@ namespace hum {
 //
 
 bool HumdrumFileContent::analyzeSlurs(void) {
-	if (m_analyses.m_slurs_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Slurs)) {
 		return false;
 	}
-	m_analyses.m_slurs_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Slurs);
 	bool output = true;
 	output &= analyzeKernSlurs();
 	output &= analyzeMensSlurs();
@@ -279,7 +279,7 @@ bool HumdrumFileContent::analyzeKernSlurs(HTp spinestart,
 							// This is a slur closing that does not have a matching opening.
 							token->setValue("auto", "hangingSlur", "true");
 							token->setValue("auto", "slurSide", "stop");
-							token->setValue("auto", "slurOpenIndex", to_string(i));
+							token->setValue("auto", "slurOpenIndex", i);
 							token->setValue("auto", "slurDuration",
 								token->getDurationToEnd());
 						}
@@ -96,19 +96,19 @@ bool HumdrumFileContent::analyzeKernStemLengths(HTp stok, HTp etok, vector<vecto
 		int diff = b7 - centerlines[track][tok->getLineIndex()];
 		if (subtrack == 1) {
 			if (diff == 1) { // 0.5 stem length adjustment
-				tok->setValue("auto", "stemlen", "6.5");
+				tok->setValue("auto", "stemlen", 6.5);
 			} else if (diff == 2) { // 1.0 stem length adjustment
-				tok->setValue("auto", "stemlen", "6");
+				tok->setValue("auto", "stemlen", 6.0);
 			} else if (diff >= 3) { // 1.5 stem length adjustment
-				tok->setValue("auto", "stemlen", "5.5");
+				tok->setValue("auto", "stemlen", 5.5);
 			}
 		} else if (subtrack == 2) {
 			if (diff == -1) { // 0.5 stem length adjustment
-				tok->setValue("auto", "stemlen", "6.5");
+				tok->setValue("auto", "stemlen", 6.5);
 			} else if (diff == -2) { // 1.0 stem length adjustment
-				tok->setValue("auto", "stemlen", "6");
+				tok->setValue("auto", "stemlen", 6.0);
 			} else if (diff <= -3) { // 1.5 stem length adjustment
-				tok->setValue("auto", "stemlen", "5.5");
+				tok->setValue("auto", "stemlen", 5.5);
 			}
 
 		}
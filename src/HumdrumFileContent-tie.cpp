@@ -28,6 +28,7 @@ namespace hum {
 //
 
 bool HumdrumFileContent::analyzeKernTies(void) {
+	m_analyses.setAnalyzed(HumFileAnalysis::Ties);
 	vector<pair<HTp, int>> linkedtiestarts;
 	vector<pair<HTp, int>> linkedtieends;
 
@@ -92,14 +93,12 @@ bool HumdrumFileContent::analyzeKernTies(
 			if (tok->isRest()) {
 				continue;
 			}
-			int scount = tok->getSubtokenCount();
+			bool chord = tok->isChord();
 			int b40;
-			for (int k=0; k<scount; k++) {
-				int index = k;
-				if (scount == 1) {
-					index = -1;
-				}
-				std::string tstring = tok->getSubtoken(k);
+			int k = 0;
+			for (std::string_view tstring : tok->getSubtokenViews()) {
+				int index = chord ? k : -1;
+				k++;
 				if (tstring.find(lstart) != std::string::npos) {
 					b40 = Convert::kernToBase40(tstring);
 					startdatabase[b40].first  = tok;
@@ -193,13 +192,13 @@ void HumdrumFileContent::linkTieEndpoints(HTp tiestart,
    tiestart->setValue("auto", endtag, tieend);
    tiestart->setValue("auto", "id", tiestart);
 	if (endnumber > 0) {
-		tiestart->setValue("auto", endnum, to_string(endnumber));
+		tiestart->setValue("auto", endnum, endnumber);
 	}
 
    tieend->setValue("auto", starttag, tiestart);
    tieend->setValue("auto", "id", tieend);
 	if (startnumber > 0) {
-		tieend->setValue("auto", startnum, to_string(startnumber));
+		tieend->setValue("auto", startnum, startnumber);
 	}
 
    HumNum duration = tieend->getDurationFromStart()
@@ -54,6 +54,27 @@ HumdrumFileContent::~HumdrumFileContent() {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileContent::runAnalysis -- Do one of the content analyses
+//    for HumdrumFileBase::requireAnalysis().  The analyses that it
+//    depends on have already been done.
+//
+
+bool HumdrumFileContent::runAnalysis(int type) {
+	switch (type) {
+		case HumFileAnalysis::Barlines:    analyzeBarlines(); return true;
+		case HumFileAnalysis::Slurs:       return analyzeSlurs();
+		case HumFileAnalysis::Phrases:     return analyzePhrasings();
+		case HumFileAnalysis::Beams:       return analyzeBeams();
+		case HumFileAnalysis::Ties:        return analyzeKernTies();
+		case HumFileAnalysis::Accidentals: return analyzeAccidentals();
+	}
+	return HumdrumFileStructure::runAnalysis(type);
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileContent::analyzeRScale --
@@ -29,14 +29,16 @@ namespace hum {
 //
 
 HumdrumFileSet::HumdrumFileSet(void) {
-	// do nothing
+	m_threads = 1;
 }
 
 HumdrumFileSet::HumdrumFileSet(Options& options) {
+	m_threads = 1;
 	read(options);
 }
 
 HumdrumFileSet::HumdrumFileSet(const string& contents) {
+	m_threads = 1;
 	readString(contents);
 }
 
@@ -64,6 +66,7 @@ void HumdrumFileSet::clear(void) {
 		m_data[i] = NULL;
 	}
 	m_data.resize(0);
+	m_parseErrors.clear();
 }
 
 
@@ -79,6 +82,7 @@ void HumdrumFileSet::clearNoFree(void) {
 		m_data[i] = NULL;
 	}
 	m_data.resize(0);
+	m_parseErrors.clear();
 }
 
 
@@ -161,6 +165,11 @@ int HumdrumFileSet::read(HumdrumFileStream& instream) {
 	return readAppend(instream);
 }
 
+int HumdrumFileSet::readParallel(const vector<string>& filenames) {
+	clear();
+	return readAppendParallel(filenames);
+}
+
 
 
 
@@ -175,12 +184,14 @@ int HumdrumFileSet::readAppendFile(const string& filename) {
 	indata.open(filename);
 	string contents((istreambuf_iterator<char>(indata)), istreambuf_iterator<char>());
 	HumdrumFileStream instream(contents);
+	instream.setReadAnalyses(m_readAnalyses);
 	return readAppend(instream);
 }
 
 
 int HumdrumFileSet::readAppendString(const string& contents) {
 	HumdrumFileStream instream(contents);
+	instream.setReadAnalyses(m_readAnalyses);
 	return readAppend(instream);
 }
 
@@ -193,12 +204,19 @@ int HumdrumFileSet::readAppendStringCsv(const string& contents) {
 int HumdrumFileSet::readAppend(istream& inStream) {
 	string contents((istreambuf_iterator<char>(inStream)), istreambuf_iterator<char>());
 	HumdrumFileStream instream(contents);
+	instream.setReadAnalyses(m_readAnalyses);
 	return readAppend(instream);
 }
 
 
 int HumdrumFileSet::readAppend(Options& options) {
+	if ((m_threads != 1) && (options.getArgCount() > 1)) {
+		vector<string> filenames;
+		options.getArgList(filenames);
+		return readAppendParallel(filenames);
+	}
 	HumdrumFileStream instream(options);
+	instream.setReadAnalyses(m_readAnalyses);
 	return readAppend(instream);
 }
 
@@ -236,6 +254,160 @@ int HumdrumFileSet::appendHumdrumPointer(HumdrumFile* infile) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileSet::readAppendParallel -- Read and analyze a list of files
+//    using a pool of threads (see setThreadCount()), and then add their
+//    segments to the end of the set in the order of the filenames.
+//    Returns the total number of segments in the set.  Each file is read
+//    with its own HumdrumFileStream, so universal comments in one file are
+//    not applied to the next file as they are when reading sequentially.
+//    A file that cannot be opened or that fails to parse does not stop
+//    the other files from being read: parse errors are printed in file
+//    order after all files have been read, and all problems are stored
+//    for getParseErrors().  Each file is given the analyses selected with
+//    setReadAnalyses(), as when the files are read one at a time.
+//
+
+int HumdrumFileSet::readAppendParallel(const vector<string>& filenames) {
+	int count = (int)filenames.size();
+	vector<vector<HumdrumFile*>> segments(count);
+	vector<string> errors(count);
+
+	unsigned analyses = m_readAnalyses;
+	auto readFile = [&filenames, &segments, &errors, analyses](int index) {
+		vector<HumdrumFile*>& output = segments[index];
+		HumdrumFile* pfile = NULL;
+		try {
+			HumdrumFileStream instream(vector<string>(1, filenames[index]));
+			instream.setReadAnalyses(analyses);
+			pfile = new HumdrumFile;
+			pfile->setQuietParsing();
+			while (instream.read(*pfile)) {
+				output.push_back(pfile);
+				pfile = new HumdrumFile;
+				pfile->setQuietParsing();
+			}
+			delete pfile;
+			if (output.empty()) {
+				errors[index] = filenames[index] + ": cannot read file";
+			}
+		} catch (const std::exception& e) {
+			delete pfile;
+			for (int i=0; i<(int)output.size(); i++) {
+				delete output[i];
+			}
+			output.clear();
+			errors[index] = filenames[index] + ": " + e.what();
+		}
+	};
+
+	int threads = m_threads;
+	if (threads <= 0) {
+		threads = HumThreadPool::getHardwareThreadCount();
+	}
+	if (threads > count) {
+		threads = count;
+	}
+	if (threads <= 1) {
+		for (int i=0; i<count; i++) {
+			readFile(i);
+		}
+	} else {
+		HumThreadPool pool(threads);
+		for (int i=0; i<count; i++) {
+			pool.submit([&readFile, i]() { readFile(i); });
+		}
+		pool.wait();
+	}
+
+	for (int i=0; i<count; i++) {
+		for (int j=0; j<(int)segments[i].size(); j++) {
+			HumdrumFile* pfile = segments[i][j];
+			pfile->setNoisyParsing();
+			if (!pfile->isValid()) {
+				m_parseErrors.push_back(pfile->getFilename() + ": "
+						+ pfile->getParseError());
+			}
+			m_data.push_back(pfile);
+		}
+		if (!errors[i].empty()) {
+			cerr << errors[i] << endl;
+			m_parseErrors.push_back(errors[i]);
+		}
+	}
+	return (int)m_data.size();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::setThreadCount -- Set the number of threads used to
+//    read files with readParallel() and readAppendParallel().  This also
+//    applies to read(Options&) when more than one filename is given.
+//    A count of 1 (the default) reads the files one at a time, and a
+//    count of 0 uses one thread for each hardware thread.
+//
+
+void HumdrumFileSet::setThreadCount(int count) {
+	m_threads = count < 0 ? 0 : count;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::getThreadCount -- Return the number of threads used to
+//    read files in parallel.
+//
+
+int HumdrumFileSet::getThreadCount(void) {
+	return m_threads;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::setReadAnalyses -- Set the analyses (a bit mask of
+//    HumFileAnalysis types) which are done on each file read by the set,
+//    whether the files are read one at a time or in parallel.  The
+//    default is 0, which only reads the spine structure; any other
+//    analysis is then done when it is first needed.  Streams given to
+//    readAppend(HumdrumFileStream&) use their own read analyses.
+//
+
+void HumdrumFileSet::setReadAnalyses(unsigned mask) {
+	m_readAnalyses = mask;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::getReadAnalyses -- Return the analyses which are done
+//    on each file read by the set.
+//
+
+unsigned HumdrumFileSet::getReadAnalyses(void) const {
+	return m_readAnalyses;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileSet::getParseErrors -- Return the problems found in files
+//    read by readParallel() or readAppendParallel(), in file order.
+//
+
+vector<string> HumdrumFileSet::getParseErrors(void) {
+	return m_parseErrors;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileSet::hasFilters -- Returns true if has any
@@ -14,10 +14,10 @@
 //                types of analyses to the HumdrumFileStream class.
 //
 
-#include "HumRegex.h"
 #include "HumdrumFileSet.h"
 #include "HumdrumFileStream.h"
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -76,6 +76,7 @@ void HumdrumFileStream::clear(void) {
 	m_newfilebuffer.resize(0);
 	// m_stringbuffer.clear(0);
 	m_stringbuffer.str("");
+	resetInput();
 }
 
 
@@ -158,6 +159,32 @@ int HumdrumFileStream::readSingleSegment(HumdrumFileSet& infiles) {
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStream::setReadAnalyses -- Set the analyses (a bit mask of
+//     HumFileAnalysis types) which are done on each file after it is
+//     read.  The default is 0, which only reads the spine structure;
+//     any other analysis is then done when it is first needed.
+//
+
+void HumdrumFileStream::setReadAnalyses(unsigned mask) {
+	m_readAnalyses = mask;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::getReadAnalyses -- Return the analyses which are
+//     done on each file after it is read.
+//
+
+unsigned HumdrumFileStream::getReadAnalyses(void) const {
+	return m_readAnalyses;
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumFileStream::eof -- returns true if there is no more segements
@@ -173,7 +200,7 @@ int HumdrumFileStream::eof(void) {
 	// (3) cin if no ifstream open and no filenames
 
 	// (1) Is an ifstream open?, then yes, there is more data to read.
-	if (m_instream.is_open() && !m_instream.eof()) {
+	if (m_instream.is_open() && !isInputEof(m_instream)) {
 		return 0;
 	}
 
@@ -193,7 +220,7 @@ int HumdrumFileStream::eof(void) {
 			// but only read from cin if no files have previously been read
 			newinput = &cin;
 		}
-		if ((newinput != NULL) && newinput->eof()) {
+		if ((newinput != NULL) && isInputEof(*newinput)) {
 			return 1;
 		}
 	}
@@ -217,16 +244,14 @@ int HumdrumFileStream::getFile(HumdrumFile& infile) {
 
 restarting:
 
-	stringstream buffer;
-	string templine;
-	if (!m_newfilebuffer.empty()) {
-		buffer << m_newfilebuffer << endl;
-		m_newfilebuffer = "";
-	}
+	// A line that ended the previous segment and which starts this one:
+	m_carry = m_newfilebuffer;
+	m_newfilebuffer.clear();
+	m_lineranges.clear();
 
 	newinput = NULL;
 
-	if (m_urlbuffer.eof()) {
+	if (isInputEof(m_urlbuffer)) {
 		// If the URL buffer is at its end, clear the buffer.
 		m_urlbuffer.str("");
 	}
@@ -243,7 +268,7 @@ restarting:
 	}
 
 	// (2) Is an ifstream open?
-	else if (m_instream.is_open() && !m_instream.eof()) {
+	else if (m_instream.is_open() && !isInputEof(m_instream)) {
 		newinput = &m_instream;
 	}
 
@@ -261,6 +286,9 @@ restarting:
 		if (m_instream.is_open()) {
 			m_instream.close();
 		}
+		if (m_inputstream == &m_instream) {
+			resetInput();
+		}
 		if (m_filelist[m_curfile].find("://") != string::npos) {
 			// The next file to read is a URL/URI, so buffer the
 			// data from the internet and start reading that instead
@@ -289,29 +317,6 @@ restarting:
 		}
 	}
 
-	// At this point the newinput istream is set to read from the given
-	// file or from standard input, so start reading Humdrum content.
-	// If there is "m_newfilebuffer" content, then set the filename of the
-	// HumdrumFile to that value.
-
-	if (m_newfilebuffer.size() > 0) {
-		// store the filename for the current HumdrumFile being read:
-		HumRegex hre;
-		if (hre.search(m_newfilebuffer, R"(^!!!!SEGMENT\s*([+-]?\d+)?\s*:\s*(.*)\s*$)")) {
-			if (hre.getMatchLength(1) > 0) {
-				infile.setSegmentLevel(hre.getMatchInt(1));
-			} else {
-				infile.setSegmentLevel(0);
-			}
-			infile.setFilename(hre.getMatch(2));
-		} else if ((m_curfile >=0) && (m_curfile < (int)m_filelist.size())
-		      && (m_filelist.size() > 0)) {
-			infile.setFilename(m_filelist[m_curfile]);
-		} else {
-			// reading from standard input, but no name.
-		}
-	}
-
 	if (newinput == NULL) {
 		// something strange happened, or no more files to read.
 		return 0;
@@ -328,11 +333,8 @@ restarting:
 	int dataFoundQ = 0;
 	int starstarFoundQ = 0;
 	int starminusFoundQ = 0;
-	if (m_newfilebuffer.size() < 4) {
-		//searchName = 1;
-	}
 
-	if (newinput->eof()) {
+	if (isInputEof(*newinput)) {
 		if (m_curfile < (int)m_filelist.size()-1) {
 			m_curfile++;
 			goto restarting;
@@ -343,28 +345,32 @@ restarting:
 
 	istream& input = *newinput;
 
-	// if the previous line from the last read starts with "**"
-	// then treat it as part of the current file.
-	if ((m_newfilebuffer.size() > 1) && (m_newfilebuffer.compare(0, 2, "**") == 0)) {
-		buffer << m_newfilebuffer << "\n";
-		m_newfilebuffer = "";
-		starstarFoundQ = 1;
+	// Lines of the segment are stored as offsets from the start of the
+	// segment in m_input, which keeps them until the segment has been
+	// parsed (the segment may be moved to the start of the buffer when
+	// more data is read):
+	if (m_inputstream == &input) {
+		m_inputstart = m_inputpos;
 	}
 
-	while (!input.eof()) {
-		getline(input, templine);
-		if (templine.compare(0, strlen("!!!!SEGMENT"), "!!!!SEGMENT") == 0) {
+	size_t linestart;
+	size_t len;
+	const char* templine;
+	while (!isInputEof(input)) {
+		readInputLine(input, linestart, len);
+		templine = m_input.data() + linestart;
+		if ((len >= 11) && (strncmp(templine, "!!!!SEGMENT", 11) == 0)) {
 			// Store the current segment line in the buffer before breaking.
-			if (!buffer.str().empty()) {
-				m_newfilebuffer = templine;
+			if (!m_carry.empty() || !m_lineranges.empty()) {
+				m_newfilebuffer.assign(templine, len);
 				break;
 			}
-			m_newfilebuffer = templine;
+			m_newfilebuffer.assign(templine, len);
 		}
 
-		if (templine.compare(0, 2, "**") == 0) {
+		if ((len >= 2) && (templine[0] == '*') && (templine[1] == '*')) {
 			if (starstarFoundQ == 1) {
-				m_newfilebuffer = templine;
+				m_newfilebuffer.assign(templine, len);
 				// already found a **, so this one is defined as a file
 				// segment.  Exit from the loop and process the previous
 				// content, waiting until the next read to start with
@@ -374,7 +380,7 @@ restarting:
 			starstarFoundQ = 1;
 		}
 
-		if (input.eof() && templine.empty()) {
+		if (isInputEof(input) && (len == 0)) {
 			// No more data coming from current stream, so this is
 			// the end of the HumdrumFile.  Break from the while loop
 			// and then store the read contents of the stream in the
@@ -382,43 +388,44 @@ restarting:
 			break;
 		}
 
-		int len = (int)templine.length();
-		if ((len > 4) && (templine.compare(0, 4, "!!!!") == 0) &&
+		if ((len > 4) && (strncmp(templine, "!!!!", 4) == 0) &&
 		    (templine[4] != '!') &&
 		    (dataFoundQ == 0) &&
-		    (templine.compare(0, strlen("!!!!filter:"), "!!!!filter:") != 0) &&
-		    (templine.compare(0, strlen("!!!!SEGMENT:"), "!!!!SEGMENT:") != 0)) {
+		    !((len >= 11) && (strncmp(templine, "!!!!filter:", 11) == 0)) &&
+		    !((len >= 12) && (strncmp(templine, "!!!!SEGMENT:", 12) == 0))) {
 			// This is a universal comment.  Should it be appended
 			// to the list or should the current list be erased and
 			// this record placed into the first entry?
 			if (foundUniversalQ) {
 				// already found a previous universal, so append.
-				m_universals.push_back(templine);
+				m_universals.emplace_back(templine, len);
 			} else {
 				// new universal comment, to delete all previous
 				// universal comments and store this one.
 				m_universals.reserve(1000);
 				m_universals.resize(1);
-				m_universals[0] = templine;
+				m_universals[0].assign(templine, len);
 				foundUniversalQ = 1;
 			}
 			continue;
 		}
 
-		if (templine.compare(0, 2, "*-") == 0) {
+		if ((len >= 2) && (templine[0] == '*') && (templine[1] == '-')) {
 			starminusFoundQ = 1;
 		}
 
-		if (((starminusFoundQ == 1) || (starstarFoundQ == 0)) && (templine[0] != '*') && (templine[0] != '!')) {
-			if ((!templine.empty()) && (templine[0] != ' ')) {
+		char first = len ? templine[0] : '\0';
+		if (((starminusFoundQ == 1) || (starstarFoundQ == 0)) && (first != '*') && (first != '!')) {
+			if ((len > 0) && (first != ' ')) {
+				string filename(templine, len);
 				int found = 0;
 				for (int mm = 0; mm < (int)m_filelist.size(); mm++) {
-					if (m_filelist[mm] == templine) {
+					if (m_filelist[mm] == filename) {
 						found = 1;
 					}
 				}
 				if (!found) {
-					m_filelist.push_back(templine);
+					m_filelist.push_back(filename);
 					// addedFilename = 1;
 				}
 				continue;
@@ -428,39 +435,38 @@ restarting:
 		dataFoundQ = 1; // found something other than universal comments
 
 		// store the data line for later parsing into HumdrumFile record:
-		buffer << templine << "\n";
-	}
-
-/*
-	if (dataFoundQ == 0) {
-		// never found anything for some strange reason.
-		if (addedFilename) {
-			goto restarting;
-		}
-		return 0;
+		m_lineranges.emplace_back(linestart - m_inputstart, len);
 	}
-*/
 
 	// Arriving here means that reading of the data stream is complete.
-	// The string stream variable "buffer" contains the HumdrumFile
-	// content, so send it to the HumdrumFile variable.  Also, prepend
-	// Universal comments (demoted into Global comments) at the start
-	// of the data stream (maybe allow for postpending Universal comments
-	// in the future).
-	stringstream contents;
-	contents.str(""); // empty any contents in buffer
-	contents.clear(); // reset error flags in buffer
-
+	// The lines of the segment are parsed directly from the input
+	// buffer into the HumdrumFile.  Universal comments (demoted into
+	// Global comments) are placed at the start of the data (maybe allow
+	// for postpending Universal comments in the future), followed by any
+	// line carried over from the previous segment.
+	vector<pair<const char*, size_t>> lines;
+	lines.reserve(m_universals.size() + 1 + m_lineranges.size());
 	for (int i=0; i < (int)m_universals.size(); i++) {
 		if (m_universals[i].compare(0, 11, "!!!!filter:") == 0) {
 			continue;
 		}
-		contents << &(m_universals[i][1]) << "\n";
+		lines.emplace_back(m_universals[i].data() + 1, m_universals[i].size() - 1);
+	}
+	if (!m_carry.empty()) {
+		lines.emplace_back(m_carry.data(), m_carry.size());
+	}
+	const char* segment = m_input.data() + m_inputstart;
+	for (int i=0; i<(int)m_lineranges.size(); i++) {
+		lines.emplace_back(segment + m_lineranges[i].first,
+				m_lineranges[i].second);
 	}
 
-	contents << buffer.str();
 	string oldfilename = infile.getFilename();
-	infile.readNoRhythm(contents);
+	unsigned analyses = infile.getReadAnalyses();
+	infile.setReadAnalyses(m_readAnalyses);
+	infile.readLines(lines);
+	infile.analyzeForRead();
+	infile.setReadAnalyses(analyses);
 	string newfilename = infile.getFilename();
 	if (newfilename.empty() && !oldfilename.empty()) {
 		infile.setFilename(oldfilename);
@@ -472,6 +478,111 @@ restarting:
 
 
 
+//////////////////////////////
+//
+// HumdrumFileStream::resetInput -- Empty the input buffer, such as when
+//    the input stream is switched to a new file.
+//
+
+void HumdrumFileStream::resetInput(void) {
+	m_inputstream = NULL;
+	m_inputstart  = 0;
+	m_inputpos    = 0;
+	m_inputend    = 0;
+	m_inputeof    = false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::isInputEof -- Returns true if all lines have been
+//    read from the input stream.  The stream itself may reach its end
+//    before then, since data is read from it ahead of the lines which
+//    are parsed.
+//
+
+bool HumdrumFileStream::isInputEof(istream& input) {
+	if (m_inputstream == &input) {
+		return m_inputeof;
+	}
+	return input.eof();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::fillInput -- Read the next chunk of data from the
+//    input stream into the input buffer.  Data before the start of the
+//    current segment is discarded to make room.  Returns false if there is
+//    no more data in the stream.
+//
+
+bool HumdrumFileStream::fillInput(istream& input) {
+	if (!input.good()) {
+		return false;
+	}
+	if (m_inputstart > 0) {
+		size_t count = m_inputend - m_inputstart;
+		if (count > 0) {
+			memmove(&m_input[0], &m_input[m_inputstart], count);
+		}
+		m_inputpos   -= m_inputstart;
+		m_inputend   -= m_inputstart;
+		m_inputstart  = 0;
+	}
+	if (m_input.size() < m_inputend + InputChunkSize) {
+		m_input.resize(std::max(m_inputend + InputChunkSize, 2 * m_input.size()));
+	}
+	input.read(&m_input[m_inputend], InputChunkSize);
+	size_t count = (size_t)input.gcount();
+	m_inputend += count;
+	return count > 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStream::readInputLine -- Read the next line from the input
+//    buffer, refilling it from the input stream when needed.  The line
+//    is returned as an offset into m_input and a length which does not
+//    include the newline.  Line splitting and the end-of-input state
+//    follow std::getline(), where a final line without a newline is
+//    returned and marks the end of the input.
+//
+
+void HumdrumFileStream::readInputLine(istream& input, size_t& start,
+		size_t& length) {
+	if (m_inputstream != &input) {
+		resetInput();
+		m_inputstream = &input;
+	}
+	size_t searchpos = m_inputpos;
+	while (true) {
+		const char* data = m_input.data();
+		const char* newline = (const char*)memchr(data + searchpos, '\n',
+				m_inputend - searchpos);
+		if (newline) {
+			start = m_inputpos;
+			length = (newline - data) - start;
+			m_inputpos = start + length + 1;
+			return;
+		}
+		searchpos = m_inputend - m_inputpos;
+		if (!fillInput(input)) {
+			start = m_inputpos;
+			length = m_inputend - m_inputpos;
+			m_inputpos = m_inputend;
+			m_inputeof = true;
+			return;
+		}
+		searchpos += m_inputpos;
+	}
+}
+
+
 
 //////////////////////////////
 //
@@ -483,6 +594,9 @@ void HumdrumFileStream::fillUrlBuffer(stringstream& uribuffer,
 	#ifdef USING_URI
 		uribuffer.str(""); // empty any contents in buffer
 		uribuffer.clear(); // reset error flags in buffer
+		if (m_inputstream == &uribuffer) {
+			resetInput();
+		}
 		string webaddress = HumdrumFileBase::getUriToUrlMapping(uriname);
 		HumdrumFileBase::readStringFromHttpUri(uribuffer, webaddress);
 	#endif
@@ -0,0 +1,1397 @@
+//
+// Programmer:    agent <agent@local>
+// Creation Date: Sat Oct 17 09:01:00 UTC 2026
+// Last Modified: Sat Oct 17 09:01:00 UTC 2026
+// Filename:      HumdrumFileStructure-edit.cpp
+// URL:           https://github.com/craigsapp/humlib/blob/master/src/HumdrumFileStructure-edit.cpp
+// Syntax:        C++17; humlib
+// vim:           syntax=cpp ts=3 noexpandtab nowrap
+//
+// Description:   Insert, delete and replace lines in an analyzed file,
+//                updating the analyses only around the edited lines when
+//                possible.  Also functions to compare the analyses of a
+//                file with a full analysis of its text.
+//
+
+#include "HumdrumFileStructure.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editLines -- Replace count lines starting at
+//     index with the given lines (a count of 0 inserts lines, and an
+//     empty list of lines deletes them), and update the analyses of the
+//     file.  When the edit does not change the spine structure of the
+//     file, the tokens of the new lines are linked to the lines around
+//     them, and the strand, null-token, strophe, duration, timing and
+//     measure information is updated only around the edit, with the
+//     times of the following lines moved if the edit changes the
+//     duration of the music.  Edits that add or remove exclusive
+//     interpretations or spine manipulators, change the number of
+//     fields on a line, add or remove strophe markers, layout parameters
+//     or RDF signifiers, or are done on files with analyses from
+//     HumdrumFileContent (such as slurs or ties) cause the entire file
+//     to be re-analyzed.  Returns false if the file is not valid after
+//     the edit.
+//
+
+bool HumdrumFileStructure::editLines(int index, int count,
+		const vector<string>& lines) {
+	m_lastEditIncremental = false;
+	if ((index < 0) || (index > getLineCount())) {
+		return isValid();
+	}
+	if (count < 0) {
+		count = 0;
+	}
+	if (index + count > getLineCount()) {
+		count = getLineCount() - index;
+	}
+
+	vector<HLp> newlines(lines.size());
+	for (int i=0; i<(int)lines.size(); i++) {
+		newlines[i] = new HumdrumLine(lines[i]);
+		newlines[i]->setOwner(this);
+	}
+
+	if (editLinesLocally(index, count, newlines)) {
+		m_lastEditIncremental = true;
+		return isValid();
+	}
+
+	// Files with parse errors are analyzed again as when they were read:
+	unsigned analyses = isValid() ? m_analyses.m_analyzed : m_readAnalyses;
+	for (int i=index; i<index+count; i++) {
+		delete m_lines[i];
+	}
+	m_lines.erase(m_lines.begin() + index, m_lines.begin() + index + count);
+	m_lines.insert(m_lines.begin() + index, newlines.begin(), newlines.end());
+	return reanalyzeEditedFile(analyses);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editInsertLine -- Insert a line before the given
+//     line index (or at the end of the file if the index is the line
+//     count) and update the analyses.
+//
+
+bool HumdrumFileStructure::editInsertLine(int index, const string& line) {
+	return editLines(index, 0, vector<string>(1, line));
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editDeleteLine -- Delete a line and update the
+//     analyses.
+//
+
+bool HumdrumFileStructure::editDeleteLine(int index) {
+	if ((index < 0) || (index >= getLineCount())) {
+		m_lastEditIncremental = false;
+		return isValid();
+	}
+	return editLines(index, 1, vector<string>());
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editReplaceLine -- Replace the text of a line
+//     and update the analyses.
+//
+
+bool HumdrumFileStructure::editReplaceLine(int index, const string& line) {
+	if ((index < 0) || (index >= getLineCount())) {
+		m_lastEditIncremental = false;
+		return isValid();
+	}
+	return editLines(index, 1, vector<string>(1, line));
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::isLastEditIncremental -- Returns true if the last
+//     edit was analyzed around the edited lines, or false if the entire
+//     file was re-analyzed.
+//
+
+bool HumdrumFileStructure::isLastEditIncremental(void) const {
+	return m_lastEditIncremental;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::reanalyzeEditedFile -- Analyze the spine structure
+//     of the file from the text of its lines, and then redo the given
+//     analyses.
+//
+
+bool HumdrumFileStructure::reanalyzeEditedFile(unsigned analyses) {
+	clearAnalysisInfo();
+	m_strand1d.clear();
+	m_strand2d.clear();
+	m_parseError.clear();
+	m_analyses.clear();
+	if (!analyzeBaseFromLines()) {
+		return isValid();
+	}
+	return requireAnalyses(analyses);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::isLocalEditLine -- Returns true if the line can
+//     be added to or removed from the file without a full re-analysis.
+//
+
+bool HumdrumFileStructure::isLocalEditLine(HumdrumLine& line) {
+	if (line.isSignifier()) {
+		return false;
+	}
+	if (!line.hasSpines()) {
+		return line.find("!!LO:") == string::npos;
+	}
+	if (line.isManipulator()) {
+		return false;
+	}
+	for (int i=0; i<line.getTokenCount(); i++) {
+		HTp token = line.token(i);
+		if (token->isInterpretation()) {
+			if ((*token == "*strophe") || (*token == "*Xstrophe") ||
+					(*token == "*S-") || (token->compare(0, 3, "*S/") == 0)) {
+				return false;
+			}
+		} else if (token->isCommentLocal()) {
+			if (token->find("!LO:") == 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::hasLayoutParameterAbove -- Returns true if there
+//     is a layout parameter before the given line which applies to the
+//     line (or to a line after it if the line is removed).
+//
+
+bool HumdrumFileStructure::hasLayoutParameterAbove(int index) {
+	for (int i=index-1; i>=0; i--) {
+		HumdrumLine& line = *m_lines[i];
+		if (line.isCommentGlobal()) {
+			if (line.find("!!LO:") != string::npos) {
+				return true;
+			}
+			continue;
+		}
+		if (!line.hasSpines()) {
+			continue;
+		}
+		if (line.isCommentLocal()) {
+			for (int j=0; j<line.getTokenCount(); j++) {
+				if (line.token(j)->find("!LO:") == 0) {
+					return true;
+				}
+			}
+			continue;
+		}
+		if (line.isAllNull()) {
+			continue;
+		}
+		break;
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::editLinesLocally -- Replace lines in the file
+//     without re-analyzing the entire file.  Returns false without
+//     changing the file if the edit cannot be analyzed locally.
+//
+
+bool HumdrumFileStructure::editLinesLocally(int index, int count,
+		vector<HLp>& newlines) {
+	if (m_lines.empty() || !isValid()) {
+		return false;
+	}
+	if (m_analyses.m_analyzed & ~HumFileAnalysis::ReadDefault) {
+		return false;
+	}
+	bool nulls     = m_analyses.isAnalyzed(HumFileAnalysis::Nulls);
+	bool strophes  = m_analyses.isAnalyzed(HumFileAnalysis::Strophes);
+	bool structure = m_analyses.isAnalyzed(HumFileAnalysis::Structure);
+	bool rhythm    = m_analyses.isAnalyzed(HumFileAnalysis::Rhythm);
+
+	// Mensural durations, **recip timings and the timings of spines which
+	// start after the start of the music are not updated locally:
+	if (structure || rhythm) {
+		for (int i=1; i<(int)m_trackstarts.size(); i++) {
+			if (!m_trackstarts[i] || (*m_trackstarts[i] == "**mens")) {
+				return false;
+			}
+			if (rhythm && (m_trackstarts[i]->getLineIndex() !=
+					m_trackstarts[1]->getLineIndex())) {
+				return false;
+			}
+		}
+	}
+	if (rhythm && (m_trackstarts.size() > 1) && m_trackstarts[1] &&
+			(*m_trackstarts[1] == "**recip")) {
+		return false;
+	}
+
+	vector<HLp> oldspined;
+	vector<HLp> newspined;
+	bool barlines = (index == 0);
+	bool data = false;
+	for (int i=index; i<index+count; i++) {
+		if (!isLocalEditLine(*m_lines[i])) {
+			return false;
+		}
+		if (m_lines[i]->hasSpines()) {
+			oldspined.push_back(m_lines[i]);
+		}
+		barlines |= m_lines[i]->isBarline();
+		data |= m_lines[i]->isData();
+	}
+	for (int i=0; i<(int)newlines.size(); i++) {
+		if (!isLocalEditLine(*newlines[i])) {
+			return false;
+		}
+		if (newlines[i]->hasSpines()) {
+			newspined.push_back(newlines[i]);
+		}
+		barlines |= newlines[i]->isBarline();
+		data |= newlines[i]->isData();
+	}
+	if (hasLayoutParameterAbove(index)) {
+		return false;
+	}
+
+	// Data added or removed before the first barline can change the
+	// pickup measure:
+	if (data && !barlines && rhythm) {
+		int firstbar = -1;
+		for (int i=0; i<(int)m_barlines.size(); i++) {
+			if (m_barlines[i]->isBarline()) {
+				firstbar = m_barlines[i]->getLineIndex();
+				break;
+			}
+		}
+		barlines = (firstbar < 0) || (index <= firstbar);
+	}
+
+	bool spined = !(oldspined.empty() && newspined.empty());
+	int pindex = index - 1;
+	while ((pindex >= 0) && !m_lines[pindex]->hasSpines()) {
+		pindex--;
+	}
+	int nindex = index + count;
+	while ((nindex < (int)m_lines.size()) && !m_lines[nindex]->hasSpines()) {
+		nindex++;
+	}
+	HLp next = nindex < (int)m_lines.size() ? m_lines[nindex] : NULL;
+	int width = 0;
+	if (spined) {
+		if ((pindex < 0) || !next) {
+			return false;
+		}
+		width = next->getTokenCount();
+		for (int i=0; i<(int)newspined.size(); i++) {
+			if (newspined[i]->getTokenCount() != width) {
+				return false;
+			}
+		}
+	}
+
+	// Collect the links to the edited lines, and the tokens between the
+	// non-null data tokens before and after the edit in each spine:
+	vector<HTp> oldfirst(width);
+	vector<HTp> newfirst(width);
+	vector<vector<HTp>> previous(width);
+	for (int j=0; j<width; j++) {
+		oldfirst[j] = oldspined.empty() ? next->token(j) : oldspined[0]->token(j);
+		newfirst[j] = newspined.empty() ? next->token(j) : newspined[0]->token(j);
+		previous[j].assign(oldfirst[j]->m_previousTokens.begin(),
+				oldfirst[j]->m_previousTokens.end());
+	}
+	bool fullnonnull = false;
+	vector<vector<HTp>> before(width);
+	vector<vector<HTp>> after(width);
+	vector<HTp> prevnonnull(width, NULL);
+	vector<HTp> nextnonnull(width, NULL);
+	vector<bool> reach(width, false);
+	if (rhythm) {
+		for (int j=0; j<width; j++) {
+			bool state = false;
+			if (!getNonNullEditContext(oldfirst[j], next, j, oldspined, newspined,
+					before[j], after[j], prevnonnull[j], nextnonnull[j], state)) {
+				fullnonnull = true;
+				break;
+			}
+			reach[j] = state;
+		}
+	}
+
+	// Link the new lines into the spines:
+	for (int j=0; j<width; j++) {
+		for (HTp token : previous[j]) {
+			for (int k=0; k<(int)token->m_nextTokens.size(); k++) {
+				if (token->m_nextTokens[k] == oldfirst[j]) {
+					token->m_nextTokens[k] = newfirst[j];
+				}
+			}
+		}
+		newfirst[j]->m_previousTokens.assign(previous[j].begin(), previous[j].end());
+		for (int i=1; i<(int)newspined.size(); i++) {
+			HTp first = newspined[i-1]->token(j);
+			HTp second = newspined[i]->token(j);
+			first->m_nextTokens.assign(1, second);
+			second->m_previousTokens.assign(1, first);
+		}
+		if (!newspined.empty()) {
+			HTp last = newspined.back()->token(j);
+			last->m_nextTokens.assign(1, next->token(j));
+			next->token(j)->m_previousTokens.assign(1, last);
+		}
+		for (int k=0; k<(int)m_strand1d.size(); k++) {
+			if (m_strand1d[k].first == oldfirst[j]) {
+				m_strand1d[k].first = newfirst[j];
+			}
+		}
+		for (int t=0; t<(int)m_strand2d.size(); t++) {
+			for (int k=0; k<(int)m_strand2d[t].size(); k++) {
+				if (m_strand2d[t][k].first == oldfirst[j]) {
+					m_strand2d[t][k].first = newfirst[j];
+				}
+			}
+		}
+	}
+
+	for (int i=index; i<index+count; i++) {
+		delete m_lines[i];
+	}
+	m_lines.erase(m_lines.begin() + index, m_lines.begin() + index + count);
+	m_lines.insert(m_lines.begin() + index, newlines.begin(), newlines.end());
+	int last = (count == (int)newlines.size()) ? index + count : (int)m_lines.size();
+	for (int i=index; i<last; i++) {
+		m_lines[i]->setLineIndex(i);
+	}
+
+	// The new tokens are in the same track, subspine and strand as the
+	// tokens on the next line:
+	for (int i=0; i<(int)newlines.size(); i++) {
+		HumdrumLine& line = *newlines[i];
+		line.m_rhythm_analyzed = rhythm;
+		if (!line.hasSpines()) {
+			line.token(0)->setFieldIndex(0);
+			line.token(0)->setDataTypeId(HumDataType::None);
+			continue;
+		}
+		for (int j=0; j<width; j++) {
+			line.token(j)->copyStructure(next->token(j));
+			line.token(j)->m_rhycheck = next->token(j)->m_rhycheck;
+		}
+		if (structure) {
+			line.analyzeTokenDurations(m_parseError);
+		}
+	}
+
+	if (spined && strophes) {
+		bool interpretations = true;
+		for (HLp line : oldspined) {
+			interpretations &= line->isInterpretation();
+		}
+		for (HLp line : newspined) {
+			interpretations &= line->isInterpretation();
+		}
+		if (!updateEditedStrophes(next, newspined, interpretations)) {
+			reanalyzeEditedStrophes();
+		}
+	}
+
+	if (spined && nulls) {
+		if (!updateEditedNulls(next, newspined)) {
+			for (int i=0; i<(int)m_lines.size(); i++) {
+				for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+					m_lines[i]->token(j)->m_nullresolve = NULL;
+				}
+			}
+			m_analyses.setAnalyzed(HumFileAnalysis::Nulls, false);
+			resolveNullTokens();
+		}
+	}
+
+	if (!rhythm) {
+		return true;
+	}
+	if (!updateEditedRhythm(index, (int)newlines.size(), next, newspined,
+			spined, barlines)) {
+		reanalyzeEditedRhythm();
+		return true;
+	}
+
+	if (fullnonnull) {
+		for (int i=0; i<(int)m_lines.size(); i++) {
+			for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+				m_lines[i]->token(j)->m_previousNonNullTokens.clear();
+				m_lines[i]->token(j)->m_nextNonNullTokens.clear();
+			}
+		}
+		analyzeNonNullDataTokens();
+	} else {
+		for (int j=0; j<width; j++) {
+			vector<HTp> tokens(before[j].rbegin(), before[j].rend());
+			for (HLp line : newspined) {
+				tokens.push_back(line->token(j));
+			}
+			tokens.insert(tokens.end(), after[j].begin(), after[j].end());
+			linkNonNullDataTokens(tokens, prevnonnull[j], nextnonnull[j], reach[j]);
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::getNonNullEditContext -- Find the non-null data
+//     tokens before and after the edited lines in a spine (first is the
+//     first token of the edit, or the token on the next line if lines
+//     are only deleted), and the tokens between them and the edit.
+//     Also find if the non-data tokens between them are linked to the
+//     following non-null data token (reach).  Returns false if the
+//     tokens cannot be found without crossing spine manipulators.
+//
+
+bool HumdrumFileStructure::getNonNullEditContext(HTp first, HLp next,
+		int field, vector<HLp>& oldlines, vector<HLp>& newlines,
+		vector<HTp>& before, vector<HTp>& after, HTp& previous,
+		HTp& following, bool& reach) {
+	before.clear();
+	after.clear();
+	previous = NULL;
+	following = NULL;
+	reach = false;
+	bool known = false;
+
+	if (first->m_previousTokens.size() != 1) {
+		return false;
+	}
+	HTp token = first->m_previousTokens[0];
+	while (token) {
+		if (token->isData() && !token->isNull()) {
+			// After a spine merge the token before a merged spine can also
+			// be linked to the next non-null data token:
+			if (token->m_previousTokens.size() > 1) {
+				return false;
+			}
+			// The tokens before a spine split are also linked to the first
+			// non-null data token after the split and to the token after it:
+			HTp up = token;
+			while (up->m_previousTokens.size() == 1) {
+				up = up->m_previousTokens[0];
+				if (up->isData() && !up->isNull()) {
+					break;
+				}
+				if (up->isManipulator() && !up->isExclusiveInterpretation()) {
+					return false;
+				}
+			}
+			previous = token;
+			break;
+		}
+		if (token->isManipulator()) {
+			if (!token->isExclusiveInterpretation() || !token->m_previousTokens.empty()) {
+				return false;
+			}
+			before.push_back(token);
+			break;
+		}
+		before.push_back(token);
+		if (token->m_previousTokens.size() != 1) {
+			return false;
+		}
+		token = token->m_previousTokens[0];
+	}
+
+	token = next->token(field);
+	while (token) {
+		if (token->isData() && !token->isNull()) {
+			following = token;
+			break;
+		}
+		if (token->isManipulator() || (token->m_nextTokens.size() != 1)) {
+			return false;
+		}
+		after.push_back(token);
+		token = token->m_nextTokens[0];
+	}
+	if (!following) {
+		return false;
+	}
+
+	vector<HTp> tokens(before);
+	tokens.insert(tokens.end(), after.begin(), after.end());
+	for (HLp line : oldlines) {
+		tokens.push_back(line->token(field));
+	}
+	for (HTp tok : tokens) {
+		if (!tok->isData()) {
+			reach = !tok->m_nextNonNullTokens.empty();
+			known = true;
+			break;
+		}
+	}
+	if (!known) {
+		for (HLp line : newlines) {
+			if (!line->token(field)->isData()) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::linkNonNullDataTokens -- Set the previous and
+//     next non-null data tokens of a list of tokens in a spine which
+//     are between two non-null data tokens (previous is NULL if the
+//     list starts with the exclusive interpretation of the spine).
+//     Non-data tokens are linked to the next non-null data token only if
+//     the spine can be followed backwards to them from its end (reach).
+//
+
+void HumdrumFileStructure::linkNonNullDataTokens(vector<HTp>& tokens,
+		HTp previous, HTp following, bool reach) {
+	HTp current = previous;
+	for (HTp token : tokens) {
+		token->m_previousNonNullTokens.clear();
+		if (current) {
+			token->m_previousNonNullTokens.push_back(current);
+		}
+		if (token->isData() && !token->isNull()) {
+			current = token;
+		}
+	}
+	following->m_previousNonNullTokens.clear();
+	if (current) {
+		following->m_previousNonNullTokens.push_back(current);
+	}
+
+	current = following;
+	for (int i=(int)tokens.size()-1; i>=0; i--) {
+		HTp token = tokens[i];
+		token->m_nextNonNullTokens.clear();
+		if (token->isData() || reach) {
+			token->m_nextNonNullTokens.push_back(current);
+		}
+		if (token->isData() && !token->isNull()) {
+			current = token;
+		}
+	}
+	if (previous) {
+		previous->m_nextNonNullTokens.clear();
+		previous->m_nextNonNullTokens.push_back(current);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::getStrandPredecessor -- Return the token before
+//     the given one in its strand, or NULL if the token starts a strand.
+//
+
+HTp HumdrumFileStructure::getStrandPredecessor(HTp token) {
+	int strand = token->getStrandIndex();
+	if ((strand >= 0) && (strand < (int)m_strand1d.size()) &&
+			(m_strand1d[strand].first == token)) {
+		return NULL;
+	}
+	for (HTp previous : token->m_previousTokens) {
+		if (!previous->m_nextTokens.empty() && (previous->m_nextTokens[0] == token)) {
+			return previous;
+		}
+	}
+	return NULL;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::updateEditedNulls -- Resolve the null data tokens
+//     on the new lines and the null tokens after them which resolved to
+//     tokens on the old lines.  Returns false if a full resolution of
+//     null tokens is needed.
+//
+
+bool HumdrumFileStructure::updateEditedNulls(HLp next, vector<HLp>& newlines) {
+	for (int j=0; j<next->getTokenCount(); j++) {
+		HTp first = newlines.empty() ? next->token(j) : newlines[0]->token(j);
+		HTp data = NULL;
+		HTp token = getStrandPredecessor(first);
+		while (token) {
+			if (token->isData()) {
+				data = token->isNull() ? token->m_nullresolve : token;
+				break;
+			}
+			token = getStrandPredecessor(token);
+		}
+		if (!data) {
+			return false;
+		}
+		for (HLp line : newlines) {
+			token = line->token(j);
+			if (!token->isData()) {
+				continue;
+			}
+			if (token->isNull()) {
+				token->setNullResolution(data);
+			} else {
+				data = token;
+			}
+		}
+		token = next->token(j);
+		while (token) {
+			if (token->isManipulator()) {
+				return false;
+			}
+			if (token->isData()) {
+				if (!token->isNull()) {
+					break;
+				}
+				token->setNullResolution(data);
+			}
+			token = token->getNextToken();
+		}
+		if (!token) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::updateEditedStrophes -- Assign the strophes of the
+//     tokens on the new lines.  Returns false if the edit can change
+//     which strophe starts are found at the starts of strands, in which
+//     case the strophes need to be analyzed again.  The interpretations
+//     parameter is true if all of the old and new spined lines are
+//     interpretations.
+//
+
+bool HumdrumFileStructure::updateEditedStrophes(HLp next,
+		vector<HLp>& newlines, bool interpretations) {
+	for (int j=0; j<next->getTokenCount(); j++) {
+		HTp first = newlines.empty() ? next->token(j) : newlines[0]->token(j);
+		if (first->m_previousTokens.empty()) {
+			return false;
+		}
+		if (!interpretations) {
+			HTp token = getStrandPredecessor(first);
+			while (token && token->isInterpretation()) {
+				token = getStrandPredecessor(token);
+			}
+			if (!token) {
+				return false;
+			}
+		}
+		HTp strophe = NULL;
+		bool found = false;
+		for (HTp previous : first->m_previousTokens) {
+			if (previous->m_nextTokens.empty() || (previous->m_nextTokens[0] != first)) {
+				continue;
+			}
+			if ((*previous == "*Xstrophe") || (*previous == "*S-")) {
+				continue;
+			}
+			if (found && (previous->m_strophe != strophe)) {
+				return false;
+			}
+			strophe = previous->m_strophe;
+			found = true;
+		}
+		for (HLp line : newlines) {
+			line->token(j)->setStrophe(strophe);
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::reanalyzeEditedStrophes -- Analyze the strophes
+//     of the file again.
+//
+
+void HumdrumFileStructure::reanalyzeEditedStrophes(void) {
+	for (int i=0; i<(int)m_lines.size(); i++) {
+		for (int j=0; j<m_lines[i]->getTokenCount(); j++) {
+			m_lines[i]->token(j)->setStrophe(NULL);
+		}
+	}
+	m_strophes1d.clear();
+	m_strophes2d.clear();
+	m_analyses.setAnalyzed(HumFileAnalysis::Strophes, false);
+	requireAnalysis(HumFileAnalysis::Strophes);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::isTimedLine -- Returns true if the start time of
+//     the line is set by the rhythm of its tokens rather than by the
+//     lines around it.
+//
+
+bool HumdrumFileStructure::isTimedLine(HumdrumLine& line) {
+	if (!line.hasSpines() || line.isAllRhythmicNull()) {
+		return false;
+	}
+	for (int i=0; i<line.getTokenCount(); i++) {
+		HTp token = line.token(i);
+		if (!token->hasRhythm()) {
+			continue;
+		}
+		if (token->getDuration().isNonNegative()) {
+			return true;
+		}
+		if (token->isTerminateInterpretation() && token->m_nextTokens.empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::getEditStartTime -- Find the start time of a
+//     token in a rhythmic spine from the token with a duration before it.
+//     Returns false if there is no such token, and the spine does not
+//     start at the start of the music.
+//
+
+bool HumdrumFileStructure::getEditStartTime(HTp token, HumNum& time) {
+	HTp current = token;
+	HTp previous = token->m_previousTokens.empty() ? NULL : token->m_previousTokens[0];
+	while (previous) {
+		HumNum duration = previous->getDuration();
+		if (duration.isNonNegative()) {
+			time = previous->getDurationFromStart();
+			if (duration.isPositive()) {
+				time += duration;
+			}
+			return true;
+		}
+		current = previous;
+		previous = current->m_previousTokens.empty() ? NULL : current->m_previousTokens[0];
+	}
+	if ((m_trackstarts.size() > 1) && m_trackstarts[1] &&
+			(current->getLineIndex() == m_trackstarts[1]->getLineIndex())) {
+		time = 0;
+		return true;
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::updateEditedRhythm -- Update the start times and
+//     durations of the lines around the new lines at index (count is the
+//     number of new lines), move the following lines in time if the
+//     duration of the music changed, and update the measure positions of
+//     the lines and the durations of tokens in non-rhythmic spines.
+//     Returns false if the rhythm of the file needs to be analyzed again.
+//
+
+bool HumdrumFileStructure::updateEditedRhythm(int index, int count, HLp next,
+		vector<HLp>& newlines, bool spined, bool barlines) {
+	HumNum delta = 0;
+	vector<HumNum> times(newlines.size(), -1);
+	if (spined) {
+		bool first = true;
+		for (int j=0; j<next->getTokenCount(); j++) {
+			HTp token = next->token(j);
+			if (!token->hasRhythm()) {
+				continue;
+			}
+			HumNum sum;
+			if (!getEditStartTime(newlines.empty() ? token : newlines[0]->token(j), sum)) {
+				return false;
+			}
+			for (int i=0; i<(int)newlines.size(); i++) {
+				HumNum duration = newlines[i]->token(j)->getDuration();
+				if (duration.isNegative()) {
+					continue;
+				}
+				if (times[i].isNegative()) {
+					times[i] = sum;
+				} else if (times[i] != sum) {
+					return false;
+				}
+				if (duration.isPositive()) {
+					sum += duration;
+				}
+			}
+			// Find the next token with a time to measure the change in duration:
+			while (token->getDuration().isNegative()) {
+				if (token->m_nextTokens.empty()) {
+					if (!token->isTerminateInterpretation()) {
+						return false;
+					}
+					break;
+				}
+				token = token->m_nextTokens[0];
+			}
+			HumNum difference = sum - token->getDurationFromStart();
+			if (first) {
+				delta = difference;
+				first = false;
+			} else if (difference != delta) {
+				return false;
+			}
+		}
+		for (int i=0; i<(int)newlines.size(); i++) {
+			if (times[i].isNegative() && newlines[i]->isData() &&
+					!newlines[i]->isAllRhythmicNull()) {
+				return false;
+			}
+		}
+	}
+
+	// The lines with times before and after the new lines:
+	int lo = index - 1;
+	while ((lo >= 0) && !isTimedLine(*m_lines[lo])) {
+		lo--;
+	}
+	bool hasfirst = lo >= 0;
+	if (!hasfirst) {
+		lo = 0;
+	}
+	int hi = index + count;
+	while ((hi < (int)m_lines.size()) && !isTimedLine(*m_lines[hi])) {
+		hi++;
+	}
+	bool haslast = hi < (int)m_lines.size();
+	if (!haslast) {
+		hi = (int)m_lines.size() - 1;
+	}
+
+	vector<HumNum> starts(hi - lo + 1, -1);
+	if (hasfirst) {
+		starts[0] = m_lines[lo]->getDurationFromStart();
+	}
+	for (int i=0; i<(int)newlines.size(); i++) {
+		if (times[i].isNonNegative()) {
+			starts[newlines[i]->getLineIndex() - lo] = times[i];
+		}
+	}
+	if (haslast) {
+		starts.back() = m_lines[hi]->getDurationFromStart() + delta;
+	}
+
+	// Times of null data lines between the lines with times (as in
+	// analyzeNullLineRhythms()):
+	int previous = -1;
+	vector<int> nulllines;
+	for (int i=lo; i<=hi; i++) {
+		HumdrumLine& line = *m_lines[i];
+		if (!line.hasSpines()) {
+			continue;
+		}
+		if (line.isAllRhythmicNull()) {
+			if (line.isData()) {
+				nulllines.push_back(i);
+			}
+			continue;
+		}
+		HumNum start = starts[i - lo];
+		if (start.isNegative()) {
+			if (line.isData()) {
+				return false;
+			}
+			continue;
+		}
+		if (previous >= 0) {
+			HumNum startdur = starts[previous - lo];
+			HumNum nulldur = (start - startdur) / ((int)nulllines.size() + 1);
+			for (int k=0; k<(int)nulllines.size(); k++) {
+				starts[nulllines[k] - lo] = startdur + nulldur * (k+1);
+			}
+		}
+		previous = i;
+		nulllines.clear();
+	}
+
+	// Times of other lines (as in fillInNegativeStartTimes()):
+	HumNum lastdur = -1;
+	for (int i=hi; i>=lo; i--) {
+		HumNum& start = starts[i - lo];
+		if (start.isNegative() && lastdur.isNonNegative()) {
+			start = lastdur;
+		}
+		if (start.isNonNegative()) {
+			lastdur = start;
+		}
+	}
+	lastdur = (lo > 0) ? m_lines[lo-1]->getDurationFromStart() : HumNum(-1);
+	for (int i=lo; i<=hi; i++) {
+		if (starts[i - lo].isNonNegative()) {
+			lastdur = starts[i - lo];
+		} else {
+			starts[i - lo] = lastdur;
+		}
+	}
+
+	for (int i=lo; i<=hi; i++) {
+		m_lines[i]->setDurationFromStart(starts[i - lo]);
+	}
+	if (delta != 0) {
+		for (int i=hi+1; i<(int)m_lines.size(); i++) {
+			m_lines[i]->setDurationFromStart(m_lines[i]->getDurationFromStart() + delta);
+		}
+	}
+	for (int i=(lo > 0 ? lo-1 : 0); i<=hi; i++) {
+		if (i == (int)m_lines.size() - 1) {
+			m_lines[i]->setDuration(0);
+		} else {
+			m_lines[i]->setDuration(m_lines[i+1]->getDurationFromStart() -
+					m_lines[i]->getDurationFromStart());
+		}
+	}
+
+	if (barlines) {
+		m_barlines.clear();
+		bool foundbarline = false;
+		for (int i=0; i<(int)m_lines.size(); i++) {
+			if (m_lines[i]->isBarline()) {
+				foundbarline = true;
+				m_barlines.push_back(m_lines[i]);
+			}
+			if (m_lines[i]->isData() && !foundbarline) {
+				// pickup measure
+				m_barlines.push_back(m_lines[0]);
+				foundbarline = true;
+			}
+		}
+	}
+	analyzeMeterRegion(lo > 0 ? lo-1 : 0, hi);
+
+	if (!updateNonRhythmicDurations(lo, hi)) {
+		analyzeDurationsOfNonRhythmicSpines();
+	}
+	m_ticksperquarternote = -1;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::analyzeMeterRegion -- Set the durations from and
+//     to the barlines for the measures containing the lines from first
+//     to last (as in analyzeMeter()).
+//
+
+void HumdrumFileStructure::analyzeMeterRegion(int first, int last) {
+	int start = first - 1;
+	while ((start >= 0) && !m_lines[start]->isBarline()) {
+		start--;
+	}
+	int stop = last + 1;
+	while ((stop < (int)m_lines.size()) && !m_lines[stop]->isBarline()) {
+		stop++;
+	}
+
+	HumNum sum = 0;
+	for (int i=start+1; i<(int)m_lines.size(); i++) {
+		m_lines[i]->setDurationFromBarline(sum);
+		sum += m_lines[i]->getDuration();
+		if (m_lines[i]->isBarline()) {
+			sum = 0;
+			if (i >= stop) {
+				break;
+			}
+		}
+	}
+
+	sum = 0;
+	for (int i=stop-1; i>=(start > 0 ? start : 0); i--) {
+		sum += m_lines[i]->getDuration();
+		m_lines[i]->setDurationToBarline(sum);
+		if (m_lines[i]->isBarline()) {
+			sum = 0;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::updateNonRhythmicDurations -- Set the durations of
+//     the non-null data tokens in non-rhythmic spines on the lines from
+//     first to last, and of the last such tokens before them.  Returns
+//     false if the durations of the non-rhythmic spines need to be
+//     analyzed again.
+//
+
+bool HumdrumFileStructure::updateNonRhythmicDurations(int first, int last) {
+	for (int i=first; i<=last; i++) {
+		HumdrumLine& line = *m_lines[i];
+		if (!line.hasSpines()) {
+			continue;
+		}
+		for (int j=0; j<line.getTokenCount(); j++) {
+			HTp token = line.token(j);
+			if (token->hasRhythm()) {
+				continue;
+			}
+			if (token->getSpineInfo().find('(') != string::npos) {
+				return false;
+			}
+			if (token->isData() && !token->isNull()) {
+				if (!setNonRhythmicDuration(token)) {
+					return false;
+				}
+			}
+		}
+	}
+
+	int index = first;
+	while ((index <= last) && !m_lines[index]->hasSpines()) {
+		index++;
+	}
+	if (index > last) {
+		return true;
+	}
+	HumdrumLine& line = *m_lines[index];
+	for (int j=0; j<line.getTokenCount(); j++) {
+		HTp token = line.token(j);
+		if (token->hasRhythm()) {
+			continue;
+		}
+		while (!token->m_previousTokens.empty()) {
+			if (token->m_previousTokens.size() != 1) {
+				return false;
+			}
+			token = token->m_previousTokens[0];
+			if (token->isData() && !token->isNull()) {
+				if (!setNonRhythmicDuration(token)) {
+					return false;
+				}
+				break;
+			}
+			if (token->isManipulator() && !token->isExclusiveInterpretation()) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::setNonRhythmicDuration -- Set the duration of a
+//     non-null data token in a non-rhythmic spine to the time until the
+//     next non-null data token or the end of the spine.
+//
+
+bool HumdrumFileStructure::setNonRhythmicDuration(HTp token) {
+	HTp current = token->getNextToken();
+	while (current) {
+		if (current->isData() && !current->isNull()) {
+			break;
+		}
+		if (current->m_nextTokens.empty()) {
+			break;
+		}
+		if (current->isManipulator()) {
+			return false;
+		}
+		current = current->m_nextTokens[0];
+	}
+	if (!current) {
+		return false;
+	}
+	token->setDuration(current->getDurationFromStart() - token->getDurationFromStart());
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::reanalyzeEditedRhythm -- Analyze the rhythm of the
+//     file again.
+//
+
+bool HumdrumFileStructure::reanalyzeEditedRhythm(void) {
+	for (int i=0; i<(int)m_lines.size(); i++) {
+		HumdrumLine& line = *m_lines[i];
+		line.m_duration            = -1;
+		line.m_durationFromStart   = -1;
+		line.m_durationFromBarline = 0;
+		line.m_durationToBarline   = 0;
+		for (int j=0; j<line.getTokenCount(); j++) {
+			line.token(j)->m_rhycheck = 0;
+			line.token(j)->m_previousNonNullTokens.clear();
+			line.token(j)->m_nextNonNullTokens.clear();
+		}
+	}
+	m_barlines.clear();
+	m_ticksperquarternote = -1;
+	m_analyses.setAnalyzed(HumFileAnalysis::Rhythm, false);
+	return requireAnalysis(HumFileAnalysis::Rhythm);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::checkAnalysis -- Compare the analyses of the file
+//     with a full analysis of its text, and print the differences.
+//     Returns true if there are no differences.  Used to test editLines().
+// default value: out = std::cerr
+//
+
+bool HumdrumFileStructure::checkAnalysis(ostream& out) {
+	stringstream text;
+	for (int i=0; i<getLineCount(); i++) {
+		text << (string)*m_lines[i] << '\n';
+	}
+	HumdrumFileStructure reference;
+	reference.setQuietParsing();
+	reference.setReadAnalyses(m_analyses.m_analyzed & HumFileAnalysis::ReadDefault);
+	reference.readString(text.str());
+	return compareAnalysis(reference, out);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::compareAnalysis -- Compare the spine structure
+//     and the analyses done on both files, and print the first
+//     differences.  Tokens are compared by their positions in the files.
+//     Returns true if there are no differences.
+// default value: out = std::cerr
+//
+
+bool HumdrumFileStructure::compareAnalysis(HumdrumFileStructure& reference,
+		ostream& out) {
+	int differences = 0;
+	auto report = [&](int line, int field, const string& message) {
+		if (differences++ < 10) {
+			out << "(" << line + 1 << "," << field + 1 << "): " << message << endl;
+		}
+	};
+	auto positions = [&](const HumTokenLinks& tokens) {
+		string output;
+		for (int i=0; i<(int)tokens.size(); i++) {
+			output += (i ? " " : "") + getEditPosition(tokens[i]);
+		}
+		return output;
+	};
+	auto compare = [&](int line, int field, const string& name,
+			const string& value, const string& expected) {
+		if (value != expected) {
+			report(line, field, name + " \"" + value + "\" instead of \"" + expected + "\"");
+		}
+	};
+	auto number = [](const HumNum& value) {
+		stringstream output;
+		value.printFraction(output);
+		return output.str();
+	};
+
+	if (isValid() != reference.isValid()) {
+		report(-1, -1, string("file is ") + (isValid() ? "" : "not ") + "valid");
+		return false;
+	}
+	if (!isValid()) {
+		return true;
+	}
+	if (getLineCount() != reference.getLineCount()) {
+		compare(-1, -1, "line count", to_string(getLineCount()),
+				to_string(reference.getLineCount()));
+		return false;
+	}
+	unsigned both = m_analyses.m_analyzed & reference.m_analyses.m_analyzed;
+	bool nulls    = both & HumFileAnalysis::getMask(HumFileAnalysis::Nulls);
+	bool strophes = both & HumFileAnalysis::getMask(HumFileAnalysis::Strophes);
+	bool strands  = both & HumFileAnalysis::getMask(HumFileAnalysis::Strands);
+	bool durs     = both & HumFileAnalysis::getMask(HumFileAnalysis::Structure);
+	bool rhythm   = both & HumFileAnalysis::getMask(HumFileAnalysis::Rhythm);
+
+	for (int i=0; i<getLineCount(); i++) {
+		HumdrumLine& line = *m_lines[i];
+		HumdrumLine& refline = *reference.m_lines[i];
+		if ((string)line != (string)refline) {
+			compare(i, -1, "line", line, refline);
+			continue;
+		}
+		compare(i, -1, "line index", to_string(line.getLineIndex()), to_string(i));
+		if (rhythm) {
+			compare(i, -1, "start time", number(line.m_durationFromStart),
+					number(refline.m_durationFromStart));
+			compare(i, -1, "duration", number(line.m_duration),
+					number(refline.m_duration));
+			compare(i, -1, "duration from barline", number(line.m_durationFromBarline),
+					number(refline.m_durationFromBarline));
+			compare(i, -1, "duration to barline", number(line.m_durationToBarline),
+					number(refline.m_durationToBarline));
+		}
+		if (line.getTokenCount() != refline.getTokenCount()) {
+			compare(i, -1, "token count", to_string(line.getTokenCount()),
+					to_string(refline.getTokenCount()));
+			continue;
+		}
+		for (int j=0; j<line.getTokenCount(); j++) {
+			HTp token = line.token(j);
+			HTp reftoken = refline.token(j);
+			compare(i, j, "track", to_string(token->getTrack()) + "." +
+					to_string(token->getSubtrack()), to_string(reftoken->getTrack()) +
+					"." + to_string(reftoken->getSubtrack()));
+			compare(i, j, "spine info", token->getSpineInfo(), reftoken->getSpineInfo());
+			compare(i, j, "field index", to_string(token->getFieldIndex()),
+					to_string(reftoken->getFieldIndex()));
+			compare(i, j, "data type", to_string(token->getDataTypeId()),
+					to_string(reftoken->getDataTypeId()));
+			compare(i, j, "next tokens", positions(token->m_nextTokens),
+					positions(reftoken->m_nextTokens));
+			compare(i, j, "previous tokens", positions(token->m_previousTokens),
+					positions(reftoken->m_previousTokens));
+			if (strands) {
+				compare(i, j, "strand", to_string(token->getStrandIndex()),
+						to_string(reftoken->getStrandIndex()));
+			}
+			if (nulls) {
+				compare(i, j, "null resolution", getEditPosition(token->m_nullresolve),
+						getEditPosition(reftoken->m_nullresolve));
+			}
+			if (strophes) {
+				compare(i, j, "strophe", getEditPosition(token->m_strophe),
+						getEditPosition(reftoken->m_strophe));
+			}
+			if (durs) {
+				compare(i, j, "token duration", number(token->m_duration),
+						number(reftoken->m_duration));
+			}
+			if (rhythm) {
+				compare(i, j, "next non-null tokens",
+						positions(token->m_nextNonNullTokens),
+						positions(reftoken->m_nextNonNullTokens));
+				compare(i, j, "previous non-null tokens",
+						positions(token->m_previousNonNullTokens),
+						positions(reftoken->m_previousNonNullTokens));
+			}
+		}
+	}
+
+	HumTokenLinks tokens;
+	HumTokenLinks reftokens;
+	tokens.assign(m_trackstarts.begin(), m_trackstarts.end());
+	reftokens.assign(reference.m_trackstarts.begin(), reference.m_trackstarts.end());
+	compare(-1, -1, "track starts", positions(tokens), positions(reftokens));
+	tokens.clear();
+	reftokens.clear();
+	for (auto& ends : m_trackends) {
+		tokens.insert(tokens.end(), ends.begin(), ends.end());
+	}
+	for (auto& ends : reference.m_trackends) {
+		reftokens.insert(reftokens.end(), ends.begin(), ends.end());
+	}
+	compare(-1, -1, "track ends", positions(tokens), positions(reftokens));
+	if (strands) {
+		tokens.clear();
+		reftokens.clear();
+		for (auto& strand : m_strand1d) {
+			tokens.push_back(strand.first);
+			tokens.push_back(strand.last);
+		}
+		for (auto& strand : reference.m_strand1d) {
+			reftokens.push_back(strand.first);
+			reftokens.push_back(strand.last);
+		}
+		compare(-1, -1, "strands", positions(tokens), positions(reftokens));
+	}
+	if (rhythm) {
+		string lines;
+		string reflines;
+		for (HLp line : m_barlines) {
+			lines += " " + to_string(line->getLineIndex());
+		}
+		for (HLp line : reference.m_barlines) {
+			reflines += " " + to_string(line->getLineIndex());
+		}
+		compare(-1, -1, "barlines", lines, reflines);
+	}
+	return differences == 0;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::getEditPosition -- Return the line and field
+//     number of a token, or "-" for NULL.
+//
+
+string HumdrumFileStructure::getEditPosition(HTp token) {
+	if (!token) {
+		return "-";
+	}
+	return to_string(token->getLineIndex() + 1) + ":" + to_string(token->getFieldIndex() + 1);
+}
+
+
+// END_MERGE
+
+} // end namespace hum
@@ -26,7 +26,7 @@ namespace hum {
 //
 
 void HumdrumFileStructure::analyzeStropheMarkers(void) {
-	m_analyses.m_strophes_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Strophes);
 
 	m_strophes1d.clear();
 	m_strophes2d.clear();
@@ -96,9 +96,7 @@ void HumdrumFileStructure::analyzeStropheMarkers(void) {
 //
 
 bool HumdrumFileStructure::analyzeStrophes(void) {
-	if (!m_analyses.m_strands_analyzed) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	analyzeStropheMarkers();
 
 	int scount = (int)m_strand1d.size();
@@ -193,11 +191,13 @@ bool HumdrumFileStructure::analyzeStrophes(void) {
 //
 
 int HumdrumFileStructure::getStropheCount(void) {
+	requireAnalysis(HumFileAnalysis::Strophes);
 	return (int)m_strophes1d.size();
 }
 
 
 int HumdrumFileStructure::getStropheCount(int spineindex) {
+	requireAnalysis(HumFileAnalysis::Strophes);
 	if ((spineindex < 0) || (spineindex >= (int)m_strophes2d.size())) {
 		return 0;
 	}
@@ -212,6 +212,7 @@ int HumdrumFileStructure::getStropheCount(int spineindex) {
 //
 
 HTp HumdrumFileStructure::getStropheStart(int index) {
+	requireAnalysis(HumFileAnalysis::Strophes);
 	if ((index < 0) || (index >= (int)m_strophes1d.size())) {
 		return NULL;
 	}
@@ -219,6 +220,7 @@ HTp HumdrumFileStructure::getStropheStart(int index) {
 }
 
 HTp HumdrumFileStructure::getStropheStart(int spine, int index) {
+		requireAnalysis(HumFileAnalysis::Strophes);
 		if ((spine < 0) || (index < 0)) {
 			return NULL;
 		}
@@ -239,6 +241,7 @@ HTp HumdrumFileStructure::getStropheStart(int spine, int index) {
 //
 
 HTp HumdrumFileStructure::getStropheEnd(int index) {
+	requireAnalysis(HumFileAnalysis::Strophes);
 	if ((index < 0) || (index >= (int)m_strophes1d.size())) {
 		return NULL;
 	}
@@ -247,6 +250,7 @@ HTp HumdrumFileStructure::getStropheEnd(int index) {
 
 
 HTp HumdrumFileStructure::getStropheEnd(int spine, int index) {
+		requireAnalysis(HumFileAnalysis::Strophes);
 		if ((spine < 0) || (index < 0)) {
 			return NULL;
 		}
@@ -74,7 +74,7 @@ bool HumdrumFileStructure::read(istream& contents) {
 	if (!readNoRhythm(contents)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -83,7 +83,7 @@ bool HumdrumFileStructure::read(const char* filename) {
 	if (!readNoRhythm(filename)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -92,7 +92,7 @@ bool HumdrumFileStructure::read(const string& filename) {
 	if (!readNoRhythm(filename)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -112,7 +112,7 @@ bool HumdrumFileStructure::readCsv(istream& contents,
 	if (!readNoRhythmCsv(contents, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -122,7 +122,7 @@ bool HumdrumFileStructure::readCsv(const char* filename,
 	if (!readNoRhythmCsv(filename, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -132,7 +132,7 @@ bool HumdrumFileStructure::readCsv(const string& filename,
 	if (!readNoRhythmCsv(filename, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -148,7 +148,7 @@ bool HumdrumFileStructure::readString(const char* contents) {
 	if (!HumdrumFileBase::readString(contents)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -157,7 +157,7 @@ bool HumdrumFileStructure::readString(const string& contents) {
 	if (!HumdrumFileBase::readString(contents)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -175,7 +175,7 @@ bool HumdrumFileStructure::readStringCsv(const char* contents,
 	if (!HumdrumFileBase::readStringCsv(contents, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
 }
 
 
@@ -185,7 +185,27 @@ bool HumdrumFileStructure::readStringCsv(const string& contents,
 	if (!HumdrumFileBase::readStringCsv(contents, separator)) {
 		return isValid();
 	}
-	return analyzeStructure();
+	return analyzeForRead();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::runAnalysis -- Do one of the structural analyses
+//    for HumdrumFileBase::requireAnalysis().  The analyses that it
+//    depends on have already been done.
+//
+
+bool HumdrumFileStructure::runAnalysis(int type) {
+	switch (type) {
+		case HumFileAnalysis::Strands:   return analyzeStrands();
+		case HumFileAnalysis::Nulls:     resolveNullTokens(); return isValid();
+		case HumFileAnalysis::Strophes:  return analyzeStrophes();
+		case HumFileAnalysis::Structure: return analyzeStructureNoRhythm();
+		case HumFileAnalysis::Rhythm:    return analyzeRhythmStructure();
+	}
+	return HumdrumFileBase::runAnalysis(type);
 }
 
 
@@ -197,17 +217,8 @@ bool HumdrumFileStructure::readStringCsv(const string& contents,
 //
 
 bool HumdrumFileStructure::analyzeStructure(void) {
-	m_analyses.m_structure_analyzed = false;
-	if (!m_analyses.m_strands_analyzed) {
-		if (!analyzeStrands()       ) { return isValid(); }
-	}
-	if (!analyzeGlobalParameters() ) { return isValid(); }
-	if (!analyzeLocalParameters()  ) { return isValid(); }
-	if (!analyzeTokenDurations()   ) { return isValid(); }
-	if (!analyzeTokenDurations()   ) { return isValid(); }
-	m_analyses.m_structure_analyzed = true;
+	if (!analyzeStructureNoRhythm()) { return isValid(); }
 	if (!analyzeRhythmStructure()  ) { return isValid(); }
-	analyzeSignifiers();
 	return isValid();
 }
 
@@ -220,15 +231,14 @@ bool HumdrumFileStructure::analyzeStructure(void) {
 //
 
 bool HumdrumFileStructure::analyzeStructureNoRhythm(void) {
-	m_analyses.m_structure_analyzed = true;
-	if (!m_analyses.m_strands_analyzed) {
-		if (!analyzeStrands()          ) { return isValid(); }
-	}
+	m_analyses.setAnalyzed(HumFileAnalysis::Structure);
+	if (!requireAnalysis(HumFileAnalysis::Strands)) { return isValid(); }
 	if (!analyzeGlobalParameters() ) { return isValid(); }
 	if (!analyzeLocalParameters()  ) { return isValid(); }
-	if (!analyzeTokenDurations()   ) { return isValid(); }
+	HumNum::clearOverflow();
+	if (!analyzeTokenDurations()   ) { return checkDurationOverflow(); }
 	analyzeSignifiers();
-	return isValid();
+	return checkDurationOverflow();
 }
 
 
@@ -239,18 +249,36 @@ bool HumdrumFileStructure::analyzeStructureNoRhythm(void) {
 //
 
 bool HumdrumFileStructure::analyzeRhythmStructure(void) {
-	m_analyses.m_rhythm_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Rhythm);
 	setLineRhythmAnalyzed();
-	if (!isStructureAnalyzed()) {
-		if (!analyzeStructureNoRhythm()) { return isValid(); }
-	}
+	if (!requireAnalysis(HumFileAnalysis::Structure)) { return isValid(); }
 
+	HumNum::clearOverflow();
 	HTp firstspine = getSpineStart(0);
 	if (firstspine && firstspine->isDataType("**recip")) {
 		assignRhythmFromRecip(firstspine);
 	} else {
-		if (!analyzeRhythm()           ) { return isValid(); }
-		if (!analyzeDurationsOfNonRhythmicSpines()) { return isValid(); }
+		if (!analyzeRhythm()           ) { return checkDurationOverflow(); }
+		if (!analyzeDurationsOfNonRhythmicSpines()) { return checkDurationOverflow(); }
+	}
+	return checkDurationOverflow();
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumFileStructure::checkDurationOverflow -- Set a parse error if
+//    a duration calculated since HumNum::clearOverflow() was called did
+//    not fit into a HumNum.  Returns false if the file is not valid.
+//
+
+bool HumdrumFileStructure::checkDurationOverflow(void) {
+	if (HumNum::hasOverflow()) {
+		HumNum::clearOverflow();
+		if (isValid()) {
+			return setParseError("Error: durations in file are too large or too small to be calculated.");
+		}
 	}
 	return isValid();
 }
@@ -338,19 +366,19 @@ bool HumdrumFileStructure::readNoRhythm(const string& filename) {
 
 bool HumdrumFileStructure::readNoRhythmCsv(istream& infile,
 		const string& seperator) {
-	return HumdrumFileBase::readCsv(infile);
+	return HumdrumFileBase::readCsv(infile, seperator);
 }
 
 
 bool HumdrumFileStructure::readNoRhythmCsv(const char* filename,
 		const string& seperator) {
-	return HumdrumFileBase::readCsv(filename);
+	return HumdrumFileBase::readCsv(filename, seperator);
 }
 
 
 bool HumdrumFileStructure::readNoRhythmCsv(const string& filename,
 		const string& seperator) {
-	return HumdrumFileBase::readCsv(filename);
+	return HumdrumFileBase::readCsv(filename, seperator);
 }
 
 
@@ -383,13 +411,13 @@ bool HumdrumFileStructure::readStringNoRhythm(const string& contents) {
 
 bool HumdrumFileStructure::readStringNoRhythmCsv(const char* contents,
 		const string& separator) {
-	return HumdrumFileBase::readStringCsv(contents);
+	return HumdrumFileBase::readStringCsv(contents, separator);
 }
 
 
 bool HumdrumFileStructure::readStringNoRhythmCsv(const string& contents,
 		const string& separator) {
-	return HumdrumFileBase::readStringCsv(contents);
+	return HumdrumFileBase::readStringCsv(contents, separator);
 }
 
 
@@ -1459,7 +1487,7 @@ void HumdrumFileStructure::checkForLocalParameters(HTp token,
 //
 
 bool HumdrumFileStructure::analyzeStrands(void) {
-	m_analyses.m_strands_analyzed = true;
+	m_analyses.setAnalyzed(HumFileAnalysis::Strands);
 	int spines = getSpineCount();
 	m_strand1d.clear();
 	m_strand2d.clear();
@@ -1480,12 +1508,6 @@ bool HumdrumFileStructure::analyzeStrands(void) {
 
 	assignStrandsToTokens();
 
-	resolveNullTokens();
-
-	analyzeLocalParameters();
-
-	analyzeStrophes();
-
 	return isValid();
 }
 
@@ -1497,13 +1519,11 @@ bool HumdrumFileStructure::analyzeStrands(void) {
 //
 
 void HumdrumFileStructure::resolveNullTokens(void) {
-	if (m_analyses.m_nulls_analyzed) {
+	if (m_analyses.isAnalyzed(HumFileAnalysis::Nulls)) {
 		return;
 	}
-	m_analyses.m_nulls_analyzed = true;
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	m_analyses.setAnalyzed(HumFileAnalysis::Nulls);
+	requireAnalysis(HumFileAnalysis::Strands);
 
 	HTp token;
 	HTp data = NULL;
@@ -1608,17 +1628,13 @@ void HumdrumFileStructure::analyzeSpineStrands(vector<TokenPair>& ends,
 //
 
 int HumdrumFileStructure::getStrandCount(void) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return (int)m_strand1d.size();
 }
 
 
 int HumdrumFileStructure::getStrandCount(int spineindex) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	if (spineindex < 0) {
 		return 0;
 	}
@@ -1637,34 +1653,26 @@ int HumdrumFileStructure::getStrandCount(int spineindex) {
 //
 
 HTp HumdrumFileStructure::getStrandStart(int index) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return m_strand1d[index].first;
 }
 
 
 HTp HumdrumFileStructure::getStrandEnd(int index) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return m_strand1d[index].last;
 }
 
 
 HTp HumdrumFileStructure::getStrandStart(int sindex,
 		int index) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return m_strand2d[sindex][index].first;
 }
 
 
 HTp HumdrumFileStructure::getStrandEnd(int sindex, int index) {
-	if (!areStrandsAnalyzed()) {
-		analyzeStrands();
-	}
+	requireAnalysis(HumFileAnalysis::Strands);
 	return m_strand2d[sindex][index].last;
 }
 
@@ -12,11 +12,13 @@
 //
 
 #include "Convert.h"
+#include "HumFieldScanner.h"
 #include "HumNum.h"
 #include "HumdrumFile.h"
 #include "HumdrumLine.h"
 
 #include <algorithm>
+#include <cstring>
 #include <sstream>
 
 using namespace std;
@@ -31,6 +33,7 @@ namespace hum {
 //
 
 HumdrumLine::HumdrumLine(void) : string() {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_owner = NULL;
 	m_duration = -1;
 	m_durationFromStart = -1;
@@ -39,6 +42,7 @@ HumdrumLine::HumdrumLine(void) : string() {
 
 
 HumdrumLine::HumdrumLine(const string& aString) : string(aString) {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_owner = NULL;
 	if ((this->size() > 0) && (this->back() == 0x0d)) {
 		this->resize(this->size() - 1);
@@ -51,6 +55,7 @@ HumdrumLine::HumdrumLine(const string& aString) : string(aString) {
 
 
 HumdrumLine::HumdrumLine(const char* aString) : string(aString) {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_owner = NULL;
 	if ((this->size() > 0) && (this->back() == 0x0d)) {
 		this->resize(this->size() - 1);
@@ -62,7 +67,8 @@ HumdrumLine::HumdrumLine(const char* aString) : string(aString) {
 }
 
 
-HumdrumLine::HumdrumLine(HumdrumLine& line)  : string((string)line) {
+HumdrumLine::HumdrumLine(HumdrumLine& line) : string((string)line), HumHash() {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_lineindex           = line.m_lineindex;
 	m_duration            = line.m_duration;
 	m_durationFromStart   = line.m_durationFromStart;
@@ -80,7 +86,8 @@ HumdrumLine::HumdrumLine(HumdrumLine& line)  : string((string)line) {
 }
 
 
-HumdrumLine::HumdrumLine(HumdrumLine& line, void* owner) : string((string)line) {
+HumdrumLine::HumdrumLine(HumdrumLine& line, void* owner) : string((string)line), HumHash() {
+	setAnalysisOwner(LineAnalysisOwner);
 	m_lineindex           = line.m_lineindex;
 	m_duration            = line.m_duration;
 	m_durationFromStart   = line.m_durationFromStart;
@@ -137,6 +144,7 @@ HumdrumLine::~HumdrumLine() {
 			m_tokens[i] = NULL;
 		}
 	}
+	deleteAnalysisValues();
 }
 
 
@@ -148,8 +156,11 @@ HumdrumLine::~HumdrumLine() {
 //
 
 void HumdrumLine::setLineFromCsv(const char* csv, const string& separator) {
-	string temp = csv;
-	setLineFromCsv(temp);
+	size_t length = strlen(csv);
+	if (length < 1) {
+		return;
+	}
+	HumFieldScanner::csvToTsv(csv, csv + length, separator, *this);
 }
 
 
@@ -158,45 +169,8 @@ void HumdrumLine::setLineFromCsv(const string& csv, const string& separator) {
 	if (csv.size() < 1) {
 		return;
 	}
-	string newcsv = csv;
-	if ((newcsv.size() > 0) && (newcsv.back() == 0x0d)) {
-		newcsv.resize(newcsv.size() - 1);
-	}
-	// construct tab-delimited string
-	string output;
-	bool inquote = false;
-
-	if ((newcsv.size() >= 2) && (newcsv[0] == '!') && (newcsv[1] == '!')) {
-		// Global commands and reference records which do not start with a
-		// quote are considered to be literal.
-		this->setText(newcsv);
-		return;
-	}
-
-	for (int i=0; i<(int)newcsv.size(); i++) {
-		if ((newcsv[i] == '"') && !inquote) {
-			inquote = true;
-			continue;
-		}
-		if (inquote && (newcsv[i] == '"') && (newcsv[i+1] == '"')
-				&& (i < (int)newcsv.length()-1)) {
-			output += '"';
-			i++;
-			continue;
-		}
-		if (newcsv[i] == '"') {
-			inquote = false;
-			continue;
-		}
-		if ((!inquote) && (newcsv.substr(i, separator.size()) == separator)) {
-			output += '\t';
-			i += (int)separator.size() - 1;
-			continue;
-		}
-		output += newcsv[i];
-	}
-	string& value = *this;
-	value = output;
+	const char* start = csv.data();
+	HumFieldScanner::csvToTsv(start, start + csv.size(), separator, *this);
 }
 
 
@@ -1279,7 +1253,9 @@ string HumdrumLine::getTokenString(int index) const {
 //////////////////////////////
 //
 // HumdrumLine::createTokensFromLine -- Chop up a HumdrumLine string into
-//     individual tokens.
+//     individual tokens.  Fields are copied directly from the line text
+//     between tab boundaries (found with HumFieldScanner) rather than
+//     being built up one character at a time.
 //
 
 int HumdrumLine::createTokensFromLine(void) {
@@ -1292,9 +1268,6 @@ int HumdrumLine::createTokensFromLine(void) {
 	m_tokens.clear();
 	m_tabs.clear();
 	HTp token;
-	char ch = 0;
-	char lastch = 0;
-	string tstring;
 
 	if (this->size() == 0) {
 		token = new HumdrumToken();
@@ -1307,35 +1280,30 @@ int HumdrumLine::createTokensFromLine(void) {
 		m_tokens.push_back(token);
 		m_tabs.push_back(0);
 	} else {
-		for (int i=0; i<(int)size(); i++) {
-			lastch = ch;
-			ch = getChar(i);
-			if (ch == '\t') {
-				// Parser now allows multiple tab characters in a
-				// row to represent a single tab.
-				if (lastch != '\t') {
-					token = new HumdrumToken(tstring);
-					token->setOwner(this);
-					m_tokens.push_back(token);
-					m_tabs.push_back(1);
-					tstring.clear();
-				} else {
-					if (m_tabs.size() > 0) {
-						m_tabs.back()++;
-					}
-				}
-			} else {
-				tstring += ch;
+		const char* field = this->data();
+		const char* end = field + this->size();
+		while (field < end) {
+			const char* tab = HumFieldScanner::find(field, end, '\t');
+			if (tab == end) {
+				token = new HumdrumToken(field, end - field);
+				token->setOwner(this);
+				m_tokens.push_back(token);
+				m_tabs.push_back(0);
+				break;
+			}
+			token = new HumdrumToken(field, tab - field);
+			token->setOwner(this);
+			m_tokens.push_back(token);
+			m_tabs.push_back(1);
+			field = tab + 1;
+			// Parser now allows multiple tab characters in a
+			// row to represent a single tab.
+			while ((field < end) && (*field == '\t')) {
+				m_tabs.back()++;
+				field++;
 			}
 		}
 	}
-	if (tstring.size() > 0) {
-		token = new HumdrumToken(tstring);
-		token->setOwner(this);
-		m_tokens.push_back(token);
-		m_tabs.push_back(0);
-		tstring.clear();
-	}
 
 	return (int)m_tokens.size();
 }
@@ -1948,10 +1916,18 @@ ostream& HumdrumLine::printTrackInfo(ostream& out) {
 //////////////////////////////
 //
 // HumdrumLine::setOwner -- store a pointer to the HumdrumFile which
-//    manages (owns) this object.
+//    manages (owns) this object.  Analysis values of the line and its
+//    tokens are stored by the file, so they are changed into text
+//    parameters when the line is moved out of a file.
 //
 
 void HumdrumLine::setOwner(void* hfile) {
+	if ((m_owner != NULL) && (m_owner != hfile)) {
+		detachAnalysisValues();
+		for (int i=0; i<(int)m_tokens.size(); i++) {
+			m_tokens[i]->detachAnalysisValues();
+		}
+	}
 	m_owner = hfile;
 }
 
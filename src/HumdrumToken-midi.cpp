@@ -37,21 +37,7 @@ void HumdrumToken::getMidiPitches(vector<int>& output) {
 		output.clear();
 		return;
 	}
-	vector<string> pieces = this->getSubtokens();
-	output.resize(pieces.size());
-	for (int i=0; i<(int)pieces.size(); i++) {
-		if (pieces[i].find("r") != string::npos) {
-			output[i] = 0;
-		} else {
-			output[i] = Convert::kernToMidiNoteNumber(pieces[i]);
-			// sustained notes are negative values:
-			if (pieces[i].find("_") != string::npos) {
-				output[i] = -output[i];
-			} else if (pieces[i].find("]") != string::npos) {
-				output[i] = -output[i];
-			}
-		}
-	}
+	getKernRecord().getMidiPitches(output);
 }
 
 
@@ -63,12 +49,14 @@ vector<int> HumdrumToken::getMidiPitches(void) {
 
 
 int HumdrumToken::getMidiPitch(void) {
-	vector<int> pitches = getMidiPitches();
-	if (pitches.size() > 0) {
-		return pitches[0];
-	} else {
+	if (*this == ".") {
+		return 0;
+	}
+	const HumKernRecord& record = getKernRecord();
+	if (record.getNoteCount() == 0) {
 		return 0;
 	}
+	return record.getNote(0).getMidiPitch();
 }
 
 
@@ -47,6 +47,7 @@ namespace hum {
 //
 
 HumdrumToken::HumdrumToken(void) : string() {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_rhycheck = 0;
 	setPrefix("!");
 	m_strand = -1;
@@ -56,6 +57,7 @@ HumdrumToken::HumdrumToken(void) : string() {
 
 
 HumdrumToken::HumdrumToken(const string& aString) : string(aString) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_rhycheck = 0;
 	setPrefix("!");
 	m_strand = -1;
@@ -65,6 +67,18 @@ HumdrumToken::HumdrumToken(const string& aString) : string(aString) {
 
 
 HumdrumToken::HumdrumToken(const char* aString) : string(aString) {
+	setAnalysisOwner(TokenAnalysisOwner);
+	m_rhycheck = 0;
+	setPrefix("!");
+	m_strand = -1;
+	m_nullresolve = NULL;
+	m_strophe     = NULL;
+}
+
+
+HumdrumToken::HumdrumToken(const char* aString, size_t length) :
+		string(aString, length) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_rhycheck = 0;
 	setPrefix("!");
 	m_strand = -1;
@@ -74,7 +88,8 @@ HumdrumToken::HumdrumToken(const char* aString) : string(aString) {
 
 
 HumdrumToken::HumdrumToken(const HumdrumToken& token) :
-		string((string)token), HumHash((HumHash)token) {
+		string((string)token), HumHash(token) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_address         = token.m_address;
 	m_address.m_owner = NULL;
 	m_duration        = token.m_duration;
@@ -91,7 +106,8 @@ HumdrumToken::HumdrumToken(const HumdrumToken& token) :
 
 
 HumdrumToken::HumdrumToken(HumdrumToken* token) :
-		string((string)(*token)), HumHash((HumHash)(*token)) {
+		string((string)(*token)), HumHash(*token) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_address         = token->m_address;
 	m_address.m_owner = NULL;
 	m_duration        = token->m_duration;
@@ -109,7 +125,8 @@ HumdrumToken::HumdrumToken(HumdrumToken* token) :
 
 
 HumdrumToken::HumdrumToken(const HumdrumToken& token, HLp owner) :
-		string((string)token), HumHash((HumHash)token) {
+		string((string)token), HumHash(token) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_address         = token.m_address;
 	m_address.m_owner = owner;
 	m_duration        = token.m_duration;
@@ -126,7 +143,8 @@ HumdrumToken::HumdrumToken(const HumdrumToken& token, HLp owner) :
 
 
 HumdrumToken::HumdrumToken(HumdrumToken* token, HLp owner) :
-		string((string)(*token)), HumHash((HumHash)(*token)) {
+		string((string)(*token)), HumHash(*token) {
+	setAnalysisOwner(TokenAnalysisOwner);
 	m_address         = token->m_address;
 	m_address.m_owner = owner;
 	m_duration        = token->m_duration;
@@ -153,10 +171,12 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 		return *this;
 	}
 	(string)(*this)   = (string)token;
-	(HumHash)(*this)  = (HumHash)token;
 
+	// Remove analysis values while the file which stores them is known:
+	clearParameters();
 	m_address         = token.m_address;
 	m_address.m_owner = NULL;
+	HumHash::operator=(token);
 	m_duration        = token.m_duration;
 	m_nextTokens      = token.m_nextTokens;
 	m_previousTokens.clear();
@@ -167,6 +187,7 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 	m_nullresolve     = NULL;
 	m_strophe         = NULL;
 	setPrefix(token.getPrefix());
+	clearKernRecord();
 
 	return *this;
 }
@@ -175,6 +196,7 @@ HumdrumToken& HumdrumToken::operator=(HumdrumToken& token) {
 HumdrumToken& HumdrumToken::operator=(const string& token) {
 	(string)(*this) = token;
 
+	detachAnalysisValues();
 	m_address.m_owner = NULL;
 	m_duration        = 0;
 	m_nextTokens.clear();
@@ -186,6 +208,7 @@ HumdrumToken& HumdrumToken::operator=(const string& token) {
 	m_nullresolve     = NULL;
 	m_strophe         = NULL;
 	setPrefix("!");
+	clearKernRecord();
 
 	return *this;
 }
@@ -194,6 +217,7 @@ HumdrumToken& HumdrumToken::operator=(const string& token) {
 HumdrumToken& HumdrumToken::operator=(const char* token) {
 	(string)(*this) = token;
 
+	detachAnalysisValues();
 	m_address.m_owner = NULL;
 	m_duration        = 0;
 	m_nextTokens.clear();
@@ -205,6 +229,7 @@ HumdrumToken& HumdrumToken::operator=(const char* token) {
 	m_nullresolve     = NULL;
 	m_strophe         = NULL;
 	setPrefix("!");
+	clearKernRecord();
 
 	return *this;
 }
@@ -221,6 +246,8 @@ HumdrumToken::~HumdrumToken() {
 		delete m_parameterSet;
 		m_parameterSet = NULL;
 	}
+	clearKernRecord();
+	deleteAnalysisValues();
 }
 
 
@@ -386,6 +413,41 @@ const string& HumdrumToken::getDataType(void) const {
 }
 
 
+
+//////////////////////////////
+//
+// HumdrumToken::getDataTypeId -- Get the HumDataType id of the exclusive
+//     interpretation for the token.  The id is stored for each token when
+//     the tracks of the file are analyzed, and is used if it is still the
+//     id of the text of the exclusive interpretation.  Otherwise (for
+//     tokens added to the file after the analysis, or in tracks whose
+//     exclusive interpretation has been changed since then), the data
+//     type is looked up in the symbol table.
+// @SEEALSO: getDataType isDataType
+//
+
+int HumdrumToken::getDataTypeId(void) const {
+	int id = m_address.getDataTypeId();
+	const string& datatype = m_address.getDataType();
+	if ((id != HumDataType::Unknown) && (HumDataType::getName(id) == datatype)) {
+		return id;
+	}
+	return HumDataType::getId(datatype);
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumToken::setDataTypeId -- Store the HumDataType id of the
+//     exclusive interpretation for the token (used by HumdrumFileBase).
+//
+
+void HumdrumToken::setDataTypeId(int id) {
+	m_address.setDataTypeId(id);
+}
+
+
 /////////////////////////////
 //
 // HumdrumToken::getExclusiveInterpretation -- Get the exclusive
@@ -400,7 +462,8 @@ HTp HumdrumToken::getExclusiveInterpretation(void) {
 //////////////////////////////
 //
 // HumdrumToken::isDataType -- Returns true if the data type of the token
-//   matches the test data type.
+//   matches the test data type.  The data type can be given as a string
+//   (with or without the leading "**") or as a HumDataType id.
 // @SEEALSO: getDataType getKern
 //
 
@@ -409,11 +472,20 @@ bool HumdrumToken::isDataType(const string& dtype) const {
 		bool value = dtype == getDataType();
 		return value;
 	} else {
-		return getDataType().compare(2, string::npos, dtype) == 0;
+		const string& datatype = getDataType();
+		if (datatype.size() < 2) {
+			return false;
+		}
+		return datatype.compare(2, string::npos, dtype) == 0;
 	}
 }
 
 
+bool HumdrumToken::isDataType(int id) const {
+	return getDataTypeId() == id;
+}
+
+
 
 //////////////////////////////
 //
@@ -459,7 +531,7 @@ bool HumdrumToken::isDataTypeLike(const string& dtype) const {
 //
 
 bool HumdrumToken::isKern(void) const {
-	return isDataType("**kern");
+	return getDataTypeId() == HumDataType::Kern;
 }
 
 
@@ -475,15 +547,7 @@ bool HumdrumToken::isKern(void) const {
 //
 
 bool HumdrumToken::isKernLike(void) const {
-	string dtype = getDataType();
-	if (dtype == "**kern") {
-		return true;
-	} else if (dtype.compare(0, 7, "**kern-") == 0) {
-		return true;
-	} else if (dtype == "**kernyy") {
-		return true;
-	}
-	return false;
+	return HumDataType::isKernLike(getDataTypeId());
 }
 
 
@@ -496,7 +560,7 @@ bool HumdrumToken::isKernLike(void) const {
 //
 
 bool HumdrumToken::isMens(void) const {
-	return isDataType("**mens");
+	return getDataTypeId() == HumDataType::Mens;
 }
 
 
@@ -512,13 +576,7 @@ bool HumdrumToken::isMens(void) const {
 //
 
 bool HumdrumToken::isMensLike(void) const {
-	string dtype = getDataType();
-	if (dtype == "**mens") {
-		return true;
-	} else if (dtype.compare(0, 7, "**mens-") == 0) {
-		return true;
-	}
-	return false;
+	return HumDataType::isMensLike(getDataTypeId());
 }
 
 
@@ -774,7 +832,7 @@ HTp HumdrumToken::getNextToken(int index) const {
 //
 
 vector<HumdrumToken*> HumdrumToken::getNextTokens(void) const {
-	return m_nextTokens;
+	return vector<HumdrumToken*>(m_nextTokens.begin(), m_nextTokens.end());
 }
 
 
@@ -786,7 +844,7 @@ vector<HumdrumToken*> HumdrumToken::getNextTokens(void) const {
 //
 
 vector<HumdrumToken*> HumdrumToken::getPreviousTokens(void) const {
-	return m_previousTokens;
+	return vector<HumdrumToken*>(m_previousTokens.begin(), m_previousTokens.end());
 }
 
 
@@ -877,7 +935,7 @@ bool HumdrumToken::analyzeDuration(void) {
 					if (strchr(this->c_str(), 'q') != NULL) {
 						m_duration = 0;
 					} else {
-						m_duration = Convert::recipToDuration((string)(*this));
+						m_duration = Convert::recipToDuration(*this);
 					}
 				} else if (isMensLike()) {
 					int rlev = this->getValueInt("auto", "mensuration", "levels");
@@ -885,7 +943,7 @@ bool HumdrumToken::analyzeDuration(void) {
 						cerr << "Warning: mensuration levels not analyzed yet" << endl;
 						rlev = 2222;
 					}
-					m_duration = Convert::mensToDuration((string)(*this), rlev);
+					m_duration = Convert::mensToDuration(*this, rlev);
 				}
 			} else {
 				m_duration.setValue(-1);
@@ -1272,16 +1330,7 @@ bool HumdrumToken::hasRhythm(void) const {
 //
 
 bool HumdrumToken::hasBeam(void) const {
-	for (int i=0; i<(int)this->size(); i++) {
-		switch (this->at(i)) {
-			case 'L':
-			case 'J':
-			case 'k':
-			case 'K':
-				return true;
-		}
-	}
-	return false;
+	return getKernRecord().hasBeam();
 }
 
 
@@ -1347,9 +1396,12 @@ bool HumdrumToken::isRest(void) {
 			// token is a chord (rests in chords are used for non-sounding
 			// notes in artificial harmonics).
 			return false;
-		} else if (isNull() && Convert::isKernRest((string)(*resolveNull()))) {
-			return true;
-		} else if (Convert::isKernRest((string)(*this))) {
+		} else if (isNull()) {
+			HTp resolve = resolveNull();
+			if (resolve && resolve->getKernRecord().hasFlag(HumKernNote::Rest)) {
+				return true;
+			}
+		} else if (getKernRecord().hasFlag(HumKernNote::Rest)) {
 			return true;
 		}
 	} else if (isMensLike()) {
@@ -1378,7 +1430,7 @@ bool HumdrumToken::isNote(void) {
 		return false;
 	}
 	if (isKernLike()) {
-		if (Convert::isKernNote((string)(*this))) {
+		if (getKernRecord().isNote()) {
 			return true;
 		}
 	} else if (isMensLike()) {
@@ -1398,10 +1450,9 @@ bool HumdrumToken::isNote(void) {
 
 bool HumdrumToken::isPitched(void) {
 	if (this->isKernLike()) {
-		for (int i=0; i<(int)this->size(); i++) {
-			if ((this->at(i) == 'r') || (this->at(i) == 'R')) {
-				return false;
-			}
+		const HumKernRecord& record = getKernRecord();
+		if (record.hasFlag(HumKernNote::Rest | HumKernNote::Unpitched)) {
+			return false;
 		}
 		return true;
 	}
@@ -1418,11 +1469,7 @@ bool HumdrumToken::isPitched(void) {
 
 bool HumdrumToken::isUnpitched(void) {
 	if (this->isKernLike()) {
-		if (this->find('R') != string::npos) {
-			return 1;
-		} else {
-			return 0;
-		}
+		return getKernRecord().hasFlag(HumKernNote::Unpitched);
 	}
 	// Don't know data type so return false for now:
 	return false;
@@ -1477,7 +1524,7 @@ bool HumdrumToken::isNoteAttack(void) {
 //
 
 bool HumdrumToken::isInvisible(void) {
-	if (!isDataType("**kern")) {
+	if (!isDataType(HumDataType::Kern)) {
 			return false;
 	}
 	if (isBarline()) {
@@ -1485,7 +1532,7 @@ bool HumdrumToken::isInvisible(void) {
 			return true;
 		}
 	} else if (isData()) {
-		if (find("yy") != string::npos) {
+		if (getKernRecord().hasFlag(HumKernNote::Invisible)) {
 			return true;
 		}
 	}
@@ -1501,12 +1548,12 @@ bool HumdrumToken::isInvisible(void) {
 //
 
 bool HumdrumToken::isGrace(void) {
-	if (!isDataType("**kern")) {
+	if (!isDataType(HumDataType::Kern)) {
 			return false;
 	}
 	if (!isData()) {
 		return false;
-	} else if (this->find("q") != string::npos) {
+	} else if (getKernRecord().hasFlag(HumKernNote::Grace)) {
 		return true;
 	}
 
@@ -2005,8 +2052,8 @@ string HumdrumToken::getInstrumentAbbreviation(void) {
 //
 
 bool HumdrumToken::hasSlurStart(void) {
-	if (isDataType("**kern")) {
-		if (Convert::hasKernSlurStart((string)(*this))) {
+	if (isDataType(HumDataType::Kern)) {
+		if (getKernRecord().getSlurStartCount() > 0) {
 			return true;
 		}
 	}
@@ -2022,8 +2069,8 @@ bool HumdrumToken::hasSlurStart(void) {
 //
 
 bool HumdrumToken::hasSlurEnd(void) {
-	if (isDataType("**kern")) {
-		if (Convert::hasKernSlurEnd((string)(*this))) {
+	if (isDataType(HumDataType::Kern)) {
+		if (getKernRecord().getSlurEndCount() > 0) {
 			return true;
 		}
 	}
@@ -2186,6 +2233,48 @@ bool HumdrumToken::allSameBarlineStyle(void) {
 
 
 
+//////////////////////////////
+//
+// HumdrumToken::getKernRecord -- Return the decoded **kern information
+//     for the token.  The record is created on the first call, and is
+//     created again if the text of the token has changed since then
+//     (through setText() or the std::string interface of the token), so
+//     a returned record can only be used until the text is changed.  If
+//     several threads create the record at once, the first one stored is
+//     used.  The data type of the token is not checked.
+//
+
+const HumKernRecord& HumdrumToken::getKernRecord(void) const {
+	HumKernRecord* record = m_kernRecord.load(std::memory_order_acquire);
+	if (record && record->isRecordOf(*this)) {
+		return *record;
+	}
+	HumKernRecord* created = new HumKernRecord(*this);
+	if (m_kernRecord.compare_exchange_strong(record, created,
+			std::memory_order_acq_rel, std::memory_order_acquire)) {
+		// Replaced a missing record or one for an earlier text:
+		delete record;
+		return *created;
+	}
+	// Another thread stored a record first:
+	delete created;
+	return *record;
+}
+
+
+
+//////////////////////////////
+//
+// HumdrumToken::clearKernRecord -- Delete the decoded **kern information
+//     for the token (it will be recreated when next needed).
+//
+
+void HumdrumToken::clearKernRecord(void) {
+	delete m_kernRecord.exchange(NULL);
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumToken::hasLigatureEnd --
@@ -2238,8 +2327,8 @@ bool HumdrumToken::hasObliquaLigatureEnd(void) {
 //
 
 bool HumdrumToken::isSecondaryTiedNote(void) {
-	if (isDataType("**kern")) {
-		if (Convert::isKernSecondaryTiedNote((string)(*this))) {
+	if (isDataType(HumDataType::Kern)) {
+		if (getKernRecord().isSecondaryTiedNote()) {
 			return true;
 		}
 	}
@@ -2616,13 +2705,7 @@ string HumdrumToken::getTrackString(void) const {
 //
 
 int HumdrumToken::getSubtokenCount(const string& separator) const {
-	int count = 0;
-	string::size_type start = 0;
-	while ((start = string::find(separator, start)) != string::npos) {
-		count++;
-		start += separator.size();
-	}
-	return count+1;
+	return HumSubtokens(*this, separator).getCount();
 }
 
 
@@ -2638,41 +2721,35 @@ int HumdrumToken::getSubtokenCount(const string& separator) const {
 //
 
 string HumdrumToken::getSubtoken(int index, const string& separator) const {
-    if (index < 0) return "";
+	if (index < 0) {
+		return "";
+	}
 
-    const string& s = *this;
+	// If "separator" is empty, treat "index" as a character index.
+	if (separator.empty()) {
+		if (index < (int)this->size()) {
+			return string(1, (*this)[index]);
+		} else {
+			return "";
+		}
+	}
 
-    // If "separator" is empty, treat "index" as a character index.
-    if (separator.empty()) {
-        if (index >= 0 && static_cast<size_t>(index) < s.size()) {
-            return string(1, s[static_cast<size_t>(index)]);
-        } else {
-            return "";
-        }
-    }
+	return string(HumSubtokens(*this, separator).getSubtoken(index));
+}
 
-    size_t pos = 0;
-    int current = 0;
 
-    while (true) {
-        size_t next = s.find(separator, pos);
 
-        if (current == index) {
-            // We are at the target field: return up to the next separator (or end)
-            if (next == string::npos) {
-                return s.substr(pos);
-            } else {
-                return s.substr(pos, next - pos);
-            }
-        }
+//////////////////////////////
+//
+// HumdrumToken::getSubtokenViews -- Return the sub-tokens as views into
+//     the token text, which can be used in a range-based for loop without
+//     copying the sub-tokens.  The views are invalid after the token text
+//     is changed.  Empty sub-tokens are included as in getSubtokenCount().
+//     default value: separator = " "
+//
 
-        // Not at the target yet: advance to the next field
-        if (next == string::npos) {
-            return "";  // ran out of fields
-        }
-        pos = next + separator.size();
-        ++current;
-    }
+HumSubtokens HumdrumToken::getSubtokenViews(std::string_view separator) const {
+	return HumSubtokens(*this, separator);
 }
 
 
@@ -2686,25 +2763,14 @@ string HumdrumToken::getSubtoken(int index, const string& separator) const {
 //
 
 std::vector<std::string> HumdrumToken::getSubtokens(const std::string& separator) const {
-    std::vector<std::string> out;
-    const std::string& s = *this;
-
-    if (separator.empty()) {
-        if (!s.empty()) out.push_back(s);
-        return out;
-    }
-
-    std::string::size_type start = 0;
-    while (true) {
-        auto pos = s.find(separator, start);
-        if (pos == std::string::npos) {
-            if (start < s.size()) out.emplace_back(s.substr(start)); // last piece
-            break;
-        }
-        if (pos > start) out.emplace_back(s.substr(start, pos - start)); // ignore empties
-        start = pos + separator.size();
-    }
-    return out;
+	std::vector<std::string> output;
+	for (std::string_view subtoken : HumSubtokens(*this, separator)) {
+		// ignore empty sub-tokens
+		if (!subtoken.empty()) {
+			output.emplace_back(subtoken);
+		}
+	}
+	return output;
 }
 
 
@@ -2794,11 +2860,21 @@ void HumdrumToken::setParameters(const string& pdata, HumdrumToken* ptok) {
 
 //////////////////////////////
 //
-// HumdrumToken::setText --
+// HumdrumToken::setText -- Change the text of the token.  The file
+//     which owns the token is marked as edited if the text is different
+//     (see HumdrumFileBase::hasEditedTokens()).
 //
 
 void HumdrumToken::setText(const string& text) {
+	if (compare(text) == 0) {
+		return;
+	}
 	string::assign(text);
+	clearKernRecord();
+	HLp line = getOwner();
+	if (line && line->getOwner()) {
+		line->getOwner()->setEditedTokens();
+	}
 }
 
 
@@ -3391,14 +3467,44 @@ std::string HumdrumToken::getLayoutParameterNote(const std::string& category,
 //////////////////////////////
 //
 // HumdrumToken::setOwner -- Sets the HumdrumLine owner of this token.
+//     Analysis values of the token are stored by its file, so they are
+//     changed into text parameters when the token is moved out of the
+//     file.
 //
 
 void HumdrumToken::setOwner(HLp aLine) {
+	HLp owner = getOwner();
+	if ((owner != NULL) && (owner != aLine)) {
+		if ((aLine == NULL) || (aLine->getOwner() != owner->getOwner())) {
+			detachAnalysisValues();
+		}
+	}
 	m_address.setOwner(aLine);
 }
 
 
 
+//////////////////////////////
+//
+// HumdrumToken::requireFileAnalysis -- Run an analysis of the HumdrumFile
+//    that owns this token if it has not been done yet (see HumFileAnalysis
+//    for the list of analysis types).
+//
+
+void HumdrumToken::requireFileAnalysis(int type) {
+	HLp hline = getOwner();
+	if (!hline) {
+		return;
+	}
+	HumdrumFile* infile = hline->getOwner();
+	if (!infile) {
+		return;
+	}
+	infile->requireAnalysis(type);
+}
+
+
+
 //////////////////////////////
 //
 // HumdrumToken::getOwner -- Returns a pointer to the HumdrumLine that
@@ -3969,12 +4075,13 @@ ostream& printSequence(vector<HTp>& sequence, ostream& out) {
 //////////////////////////////
 //
 // HumdrumToken::getSlurStartToken -- Return a pointer to the token
-//     which starts the given slur.  Returns NULL if no start.  Assumes that
-//     HumdrumFileContent::analyzeKernSlurs() has already been run.
+//     which starts the given slur.  Returns NULL if no start.  Slurs are
+//     analyzed in the owning file if that has not been done already.
 //				<parameter key="slurEnd" value="HT_140366146702320" idref=""/>
 //
 
 HTp HumdrumToken::getSlurStartToken(int number) {
+	requireFileAnalysis(HumFileAnalysis::Slurs);
 	string tag = "slurStartId";
 	if (number > 1) {
 		tag += to_string(number);
@@ -3991,6 +4098,7 @@ HTp HumdrumToken::getSlurStartToken(int number) {
 //
 
 int HumdrumToken::getSlurStartNumber(int endnumber) {
+	requireFileAnalysis(HumFileAnalysis::Slurs);
 	string tag = "slurStartNumber";
 	if (endnumber > 1) {
 		tag += to_string(endnumber);
@@ -4004,12 +4112,13 @@ int HumdrumToken::getSlurStartNumber(int endnumber) {
 //////////////////////////////
 //
 // HumdrumToken::getSlurEndToken -- Return a pointer to the token
-//     which ends the given slur.  Returns NULL if no end.  Assumes that
-//     HumdrumFileContent::analyzeKernSlurs() has already been run.
+//     which ends the given slur.  Returns NULL if no end.  Slurs are
+//     analyzed in the owning file if that has not been done already.
 //				<parameter key="slurStart" value="HT_140366146702320" idref=""/>
 //
 
 HTp HumdrumToken::getSlurEndToken(int number) {
+	requireFileAnalysis(HumFileAnalysis::Slurs);
 	string tag = "slurEnd";
 	if (number > 1) {
 		tag += to_string(number);
@@ -4023,12 +4132,13 @@ HTp HumdrumToken::getSlurEndToken(int number) {
 //////////////////////////////
 //
 // HumdrumToken::getPhraseStartToken -- Return a pointer to the token
-//     which starts the given phrase.  Returns NULL if no start.  Assumes that
-//     HumdrumFileContent::analyzeKernPhrasings() has already been run.
+//     which starts the given phrase.  Returns NULL if no start.  Phrases are
+//     analyzed in the owning file if that has not been done already.
 //				<parameter key="phraseEnd" value="HT_140366146702320" idref=""/>
 //
 
 HTp HumdrumToken::getPhraseStartToken(int number) {
+	requireFileAnalysis(HumFileAnalysis::Phrases);
 	string tag = "phraseStart";
 	if (number > 1) {
 		tag += to_string(number);
@@ -4041,12 +4151,13 @@ HTp HumdrumToken::getPhraseStartToken(int number) {
 //////////////////////////////
 //
 // HumdrumToken::getPhraseEndToken -- Return a pointer to the token
-//     which ends the given phrase.  Returns NULL if no end.  Assumes that
-//     HumdrumFileContent::analyzeKernPhrasings() has already been run.
+//     which ends the given phrase.  Returns NULL if no end.  Phrases are
+//     analyzed in the owning file if that has not been done already.
 //				<parameter key="phraseStart" value="HT_140366146702320" idref=""/>
 //
 
 HTp HumdrumToken::getPhraseEndToken(int number) {
+	requireFileAnalysis(HumFileAnalysis::Phrases);
 	string tag = "phraseEnd";
 	if (number > 1) {
 		tag += to_string(number);
@@ -4115,6 +4226,7 @@ void HumdrumToken::copyStructure(HTp token) {
 //
 
 HTp HumdrumToken::getStrophe(void) {
+	requireFileAnalysis(HumFileAnalysis::Strophes);
 	return m_strophe;
 }
 
@@ -4148,6 +4260,7 @@ void HumdrumToken::setStrophe(HTp strophe) {
 //
 
 bool HumdrumToken::hasStrophe(void) {
+	requireFileAnalysis(HumFileAnalysis::Strophes);
 	return m_strophe ? true : false;
 }
 
@@ -23,14 +23,14 @@ namespace hum {
 
 //////////////////////////////
 //
-// NoteCell::NoteCell -- Constructor.
+// NoteCell::NoteCell -- Constructor.  The cell is a view of the
+//    given voice and slice in the arrays of the owning NoteGrid.
 //
 
-NoteCell::NoteCell(NoteGrid* owner, HTp token) {
-	clear();
+NoteCell::NoteCell(NoteGrid* owner, int voice, int slice) {
 	m_owner = owner;
-	m_token = token;
-	calculateNumericPitches();
+	m_voice = voice;
+	m_timeslice = slice;
 }
 
 
@@ -42,14 +42,6 @@ NoteCell::NoteCell(NoteGrid* owner, HTp token) {
 
 void NoteCell::clear(void) {
 	m_owner = NULL;
-	m_token = NULL;
-	m_b7  = 0;
-	m_b12 = 0;
-	m_b40 = 0;
-	m_accidental = 0;
-	m_nextAttackIndex = -1;
-	m_prevAttackIndex = -1;
-	m_currAttackIndex = -1;
 	m_timeslice = -1;
 	m_voice = -1;
 }
@@ -58,52 +50,143 @@ void NoteCell::clear(void) {
 
 //////////////////////////////
 //
-// NoteCell::calculateNumericPitches -- Fills in b7, b12, and b40 variables.
-//    0 = rest, negative values for sustained notes.
+// NoteCell::getSgnBase40Pitch -- Return the base-40 pitch of the note:
+//    NaN=rest, negative=sustain.
 //
 
-void NoteCell::calculateNumericPitches(void) {
-	if (!m_token) {
-		m_b40        = NAN;
-		m_b12        = NAN;
-		m_b7         = NAN;
-		m_accidental = NAN;
-		return;
+double NoteCell::getSgnBase40Pitch(void) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
+		return NAN;
 	}
+	return b40;
+}
+
 
-	bool sustain = m_token->isNull() || m_token->isSecondaryTiedNote();
-	if (m_token->isRest()) {
-		m_b40 = NAN;
+
+//////////////////////////////
+//
+// NoteCell::getSgnDiatonicPitch -- Return the diatonic pitch of the note:
+//    NaN=rest, negative=sustain.
+//
+
+double NoteCell::getSgnDiatonicPitch(void) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
+		return NAN;
+	} else if (b40 > 0) {
+		return Convert::base40ToDiatonic(b40);
+	} else if (b40 < 0) {
+		return -Convert::base40ToDiatonic(-b40);
 	} else {
-		HTp resolve = m_token->resolveNull();
-		if (resolve->isRest()) {
-			m_b40 = NAN;
-		} else if (resolve->isNull()) {
-			m_b40 = NAN;
-		} else {
-			m_b40 = Convert::kernToBase40(resolve);
-			m_b40 = (sustain ? -m_b40 : m_b40);
-		}
+		return NAN;
 	}
+}
 
-	// convert to base-7 (diatonic pitch numbers)
-	if (m_b40 > 0) {
-		m_b7         = Convert::base40ToDiatonic((int)m_b40);
-		m_b12        = Convert::base40ToMidiNoteNumber((int)m_b40);
-		m_accidental = Convert::base40ToAccidental((int)m_b40);
-	} else if (m_b40 < 0) {
-		m_b7         = -Convert::base40ToDiatonic(-(int)m_b40);
-		m_b12        = -Convert::base40ToMidiNoteNumber(-(int)m_b40);
-		m_accidental = -Convert::base40ToAccidental(-(int)m_b40);
+
+
+//////////////////////////////
+//
+// NoteCell::getSgnMidiPitch -- Return the MIDI note number of the note:
+//    NaN=rest, negative=sustain.
+//
+
+double NoteCell::getSgnMidiPitch(void) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
+		return NAN;
+	} else if (b40 > 0) {
+		return Convert::base40ToMidiNoteNumber(b40);
+	} else if (b40 < 0) {
+		return -Convert::base40ToMidiNoteNumber(-b40);
 	} else {
-		m_b7         = NAN;
-		m_b12        = NAN;
-		m_accidental = NAN;
+		return NAN;
 	}
 }
 
 
 
+//////////////////////////////
+//
+// NoteCell::getSgnAccidental -- Return the chromatic alteration of the
+//    note: NaN=rest, negative=sustain.
+//
+
+double NoteCell::getSgnAccidental(void) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
+		return NAN;
+	} else if (b40 > 0) {
+		return Convert::base40ToAccidental(b40);
+	} else if (b40 < 0) {
+		return -Convert::base40ToAccidental(-b40);
+	} else {
+		return NAN;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getToken -- Return the token of the note in the original
+//    Humdrum file.
+//
+
+HTp NoteCell::getToken(void) {
+	return m_owner->m_tokens[m_voice][m_timeslice];
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getNextAttackIndex -- Return the slice index of the next
+//    note attack (or rest), or -1 if none.
+//
+
+int NoteCell::getNextAttackIndex(void) {
+	return m_owner->m_nextattack[m_voice][m_timeslice];
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getPrevAttackIndex -- Return the slice index of the previous
+//    note attack (or rest), or -1 if none.
+//
+
+int NoteCell::getPrevAttackIndex(void) {
+	return m_owner->m_prevattack[m_voice][m_timeslice];
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getCurrAttackIndex -- Return the slice index of the attack
+//    of the note (or first rest) that this cell belongs to.
+//
+
+int NoteCell::getCurrAttackIndex(void) {
+	return m_owner->m_currattack[m_voice][m_timeslice];
+}
+
+
+
+//////////////////////////////
+//
+// NoteCell::getTiedTokens -- Return the tokens of the tied notes
+//    (and rests) which follow a note attack.
+//
+
+vector<HTp> NoteCell::getTiedTokens(void) {
+	return m_owner->getTiedTokens(m_voice, m_timeslice);
+}
+
+
+
 //////////////////////////////
 //
 // NoteCell::getSgnKernPitch -- Return the **kern representation of the pitch.
@@ -146,17 +229,7 @@ string NoteCell::getAbsKernPitch(void) {
 //
 
 bool NoteCell::isSustained(void) {
-	if (m_b40 < 0) {
-		return true;
-	} else if (m_b40 > 0) {
-		return false;
-	}
-	// calculate if rest is a "sustain" or an "attack"
-	if (m_currAttackIndex == m_timeslice) {
-		return false;
-	} else {
-		return true;
-	}
+	return m_owner->m_flags[m_voice][m_timeslice] & NoteGrid::CellSustain;
 }
 
 
@@ -188,10 +261,11 @@ double NoteCell::operator-(int B) {
 //
 
 int NoteCell::getLineIndex(void) {
-	if (!m_token) {
+	HTp token = getToken();
+	if (!token) {
 		return -1;
 	}
-	return m_token->getLineIndex();
+	return token->getLineIndex();
 }
 
 
@@ -203,10 +277,11 @@ int NoteCell::getLineIndex(void) {
 //
 
 int NoteCell::getFieldIndex(void) {
-	if (!m_token) {
+	HTp token = getToken();
+	if (!token) {
 		return -1;
 	}
-	return m_token->getFieldIndex();
+	return token->getFieldIndex();
 }
 
 
@@ -275,8 +350,7 @@ double NoteCell::getDiatonicIntervalToNextAttack(void) {
 //
 
 bool NoteCell::isRest(void) {
-	// bug in GCC requires :: prefix to resolve two different isnan() defs.
-	return Convert::isNaN(m_b40);
+	return m_owner->m_flags[m_voice][m_timeslice] & NoteGrid::CellRest;
 }
 
 
@@ -301,8 +375,9 @@ double NoteCell::getMetricLevel(void) {
 //
 
 HumNum NoteCell::getDurationFromStart(void) {
-	if (m_token) {
-		return m_token->getDurationFromStart();
+	HTp token = getToken();
+	if (token) {
+		return token->getDurationFromStart();
 	} else {
 		return -1;
 	}
@@ -316,9 +391,6 @@ HumNum NoteCell::getDurationFromStart(void) {
 //
 
 HumNum NoteCell::getDuration(void) {
-	if (!m_owner) {
-		return Convert::recipToDuration(m_token);
-	}
 	return m_owner->getNoteDuration(getVoiceIndex(), getSliceIndex());
 }
 
@@ -326,34 +398,24 @@ HumNum NoteCell::getDuration(void) {
 
 //////////////////////////////
 //
-// NoteCell::setMeter --
-//
-
-void NoteCell::setMeter(int topval, HumNum botval) {
-	m_metertop = topval;
-	m_meterbot = botval;
-}
-
-
-
-//////////////////////////////
-//
-// NoteCell::getMeterTop --
+// NoteCell::getMeterTop -- Return the top number of the prevailing
+//    meter signature.
 //
 
 int NoteCell::getMeterTop(void) {
-	return m_metertop;
+	return m_owner->m_meters[m_owner->m_meter[m_voice][m_timeslice]].first;
 }
 
 
 
 //////////////////////////////
 //
-// NoteCell::getMeterBottom --
+// NoteCell::getMeterBottom -- Return the bottom number of the prevailing
+//    meter signature.
 //
 
 HumNum NoteCell::getMeterBottom(void) {
-	return m_meterbot;
+	return m_owner->m_meters[m_owner->m_meter[m_voice][m_timeslice]].second;
 }
 
 
@@ -364,12 +426,13 @@ HumNum NoteCell::getMeterBottom(void) {
 //
 
 double NoteCell::getSgnDiatonicPitchClass(void) {
-	if (Convert::isNaN(m_b7)) {
+	double b7 = getSgnDiatonicPitch();
+	if (Convert::isNaN(b7)) {
 		return GRIDREST;
-	} else if (m_b7 < 0) {
-		return -(double)(((int)-m_b7) % 7);
+	} else if (b7 < 0) {
+		return -(double)(((int)-b7) % 7);
 	} else {
-		return (double)(((int)m_b7) % 7);
+		return (double)(((int)b7) % 7);
 	}
 }
 
@@ -381,10 +444,11 @@ double NoteCell::getSgnDiatonicPitchClass(void) {
 //
 
 double NoteCell::getAbsDiatonicPitchClass(void) {
-	if (Convert::isNaN(m_b7)) {
+	double b7 = getSgnDiatonicPitch();
+	if (Convert::isNaN(b7)) {
 		return GRIDREST;
 	} else {
-		return (double)(((int)fabs(m_b7)) % 7);
+		return (double)(((int)fabs(b7)) % 7);
 	}
 }
 
@@ -396,12 +460,13 @@ double NoteCell::getAbsDiatonicPitchClass(void) {
 //
 
 double NoteCell::getSgnBase40PitchClass(void) {
-	if (Convert::isNaN(m_b40)) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
 		return GRIDREST;
-	} else if (m_b40 < 0) {
-		return -(double)(((int)-m_b40) % 40);
+	} else if (b40 < 0) {
+		return -(double)(-b40 % 40);
 	} else {
-		return (double)(((int)m_b40) % 40);
+		return (double)(b40 % 40);
 	}
 }
 
@@ -413,10 +478,11 @@ double NoteCell::getSgnBase40PitchClass(void) {
 //
 
 double NoteCell::getAbsBase40PitchClass(void) {
-	if (Convert::isNaN(m_b40)) {
+	int b40 = m_owner->m_base40[m_voice][m_timeslice];
+	if (b40 == GRIDREST40) {
 		return GRIDREST;
 	} else {
-		return (double)(((int)fabs(m_b40)) % 40);
+		return (double)(abs(b40) % 40);
 	}
 }
 
@@ -427,10 +493,7 @@ double NoteCell::getAbsBase40PitchClass(void) {
 //
 
 bool NoteCell::isAttack(void) {
-	if (Convert::isNaN(m_b40)) {
-		return false;
-	}
-	return m_b40>0? true:false;
+	return m_owner->m_flags[m_voice][m_timeslice] & NoteGrid::CellAttack;
 }
 
 
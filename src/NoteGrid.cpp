@@ -11,6 +11,7 @@
 //                in the Humdrum file score.
 //
 
+#include "Convert.h"
 #include "NoteGrid.h"
 #include "HumRegex.h"
 
@@ -51,19 +52,16 @@ NoteGrid::~NoteGrid() {
 void NoteGrid::clear(void) {
 	m_infile = NULL;
 	m_kernspines.clear();
-
-	vector<vector<NoteCell* > >& grid = m_grid;
-	for (int i=0; i<(int)grid.size(); i++) {
-		for (int j=0; j<(int)grid[i].size(); j++) {
-			if (grid[i][j]) {
-				grid[i][j]->clear();
-				delete grid[i][j];
-				grid[i][j] = NULL;
-			}
-		}
-		grid[i].clear();
-	}
-	grid.clear();
+	m_metriclevels.clear();
+	m_grid.clear();
+	m_tokens.clear();
+	m_base40.clear();
+	m_flags.clear();
+	m_prevattack.clear();
+	m_currattack.clear();
+	m_nextattack.clear();
+	m_meter.clear();
+	m_meters.clear();
 }
 
 
@@ -74,7 +72,7 @@ void NoteGrid::clear(void) {
 //
 
 int NoteGrid::getVoiceCount(void) {
-	return (int)m_grid.size();
+	return (int)m_tokens.size();
 }
 
 
@@ -86,10 +84,10 @@ int NoteGrid::getVoiceCount(void) {
 //
 
 int NoteGrid::getSliceCount(void) {
-	if (m_grid.size() == 0) {
+	if (m_tokens.size() == 0) {
 		return 0;
 	} else {
-		return (int)m_grid[0].size();
+		return (int)m_tokens[0].size();
 	}
 }
 
@@ -119,10 +117,20 @@ bool NoteGrid::load(HumdrumFile& infile) {
 		return false;
 	}
 
-	vector<vector<NoteCell* > >& grid = m_grid;
-	grid.resize(kernspines.size());
-	for (int i=0; i<(int)grid.size(); i++) {
-		grid[i].reserve(infile.getLineCount());
+	int slices = 0;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (infile[i].isData()) {
+			slices++;
+		}
+	}
+	int voices = (int)kernspines.size();
+	m_tokens.resize(voices);
+	m_base40.resize(voices);
+	m_meter.resize(voices);
+	for (int i=0; i<voices; i++) {
+		m_tokens[i].reserve(slices);
+		m_base40[i].reserve(slices);
+		m_meter[i].reserve(slices);
 	}
 
 	//int attack = 0;
@@ -174,32 +182,101 @@ bool NoteGrid::load(HumdrumFile& infile) {
 		if (current.size() != kernspines.size()) {
 			cerr << "Error: Unequal vector sizes " << current.size()
 			     << " compared to " << kernspines.size() << endl;
+			// Keep the slices before the error, without attack indexes:
+			buildAttackIndexes(false);
+			buildCellViews();
 			return false;
 		}
 		for (int j=0; j<(int)current.size(); j++) {
-			NoteCell* cell = new NoteCell(this, current[j]);
 			track = current[j]->getTrack();
-			cell->setVoiceIndex(j);
-			cell->setSliceIndex((int)grid[j].size());
-			cell->setMeter(metertops[track], meterbots[track]);
-			grid[j].push_back(cell);
+			addCell(j, current[j], getMeterIndex(metertops[track], meterbots[track]));
 		}
 	}
 
 	buildAttackIndexes();
+	buildCellViews();
 
 	return true;
 }
 
 
 
+//////////////////////////////
+//
+// NoteGrid::addCell -- Append a cell for the token to the arrays of
+//    a voice.  Rests are stored as GRIDREST40, and sustained notes
+//    (null tokens and secondary tied notes) as negative base-40 pitches.
+//
+
+void NoteGrid::addCell(int vindex, HTp token, int meter) {
+	int b40 = GRIDREST40;
+	bool sustain = token->isNull() || token->isSecondaryTiedNote();
+	if (!token->isRest()) {
+		HTp resolve = token->resolveNull();
+		if (!(resolve->isRest() || resolve->isNull())) {
+			// The first note of a chord is stored in the grid:
+			b40 = Convert::kernToBase40(resolve->getSubtokenViews().front());
+			b40 = (sustain ? -b40 : b40);
+			if (b40 > 32767) {
+				b40 = 32767;
+			} else if (b40 < -32767) {
+				b40 = -32767;
+			}
+		}
+	}
+	m_tokens[vindex].push_back(token);
+	m_base40[vindex].push_back((short)b40);
+	m_meter[vindex].push_back((short)meter);
+}
+
+
+
+//////////////////////////////
+//
+// NoteGrid::buildCellViews -- Create the NoteCells for the arrays
+//    of each voice.
+//
+
+void NoteGrid::buildCellViews(void) {
+	int voices = (int)m_tokens.size();
+	m_grid.resize(voices);
+	for (int i=0; i<voices; i++) {
+		int slices = (int)m_tokens[i].size();
+		m_grid[i].clear();
+		m_grid[i].reserve(slices);
+		for (int j=0; j<slices; j++) {
+			m_grid[i].emplace_back(this, i, j);
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// NoteGrid::getMeterIndex -- Return the index of the meter signature
+//    in the list of meters of the grid, adding it if necessary.
+//
+
+int NoteGrid::getMeterIndex(int top, HumNum bot) {
+	for (int i=(int)m_meters.size()-1; i>=0; i--) {
+		if ((m_meters[i].first == top) && (m_meters[i].second == bot)) {
+			return i;
+		}
+	}
+	m_meters.emplace_back(top, bot);
+	return (int)m_meters.size() - 1;
+}
+
+
+
 //////////////////////////////
 //
 // NoteGrid::cell -- Return the given cell in the grid.
 //
 
 NoteCell* NoteGrid::cell(int voiceindex, int sliceindex) {
-	return m_grid.at(voiceindex).at(sliceindex);
+	return &m_grid.at(voiceindex).at(sliceindex);
 }
 
 
@@ -303,12 +380,19 @@ void NoteGrid::printKernGrid(ostream& output) {
 //////////////////////////////
 //
 // NoteGrid::buildAttackIndexes -- create forward and backward
-//     note attack indexes for each cell.
-//
-
-void NoteGrid::buildAttackIndexes(void) {
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		buildAttackIndex(i);
+//     note attack indexes for each cell.  If indexes is false,
+//     only the attack/rest flags of the cells are set, and the
+//     attack indexes are -1.
+//
+
+void NoteGrid::buildAttackIndexes(bool indexes) {
+	int voices = (int)m_tokens.size();
+	m_flags.resize(voices);
+	m_currattack.resize(voices);
+	m_prevattack.resize(voices);
+	m_nextattack.resize(voices);
+	for (int i=0; i<voices; i++) {
+		buildAttackIndex(i, indexes);
 	}
 }
 
@@ -320,88 +404,136 @@ void NoteGrid::buildAttackIndexes(void) {
 //     note attack indexes for each cell in a single voice.
 //
 
-void NoteGrid::buildAttackIndex(int vindex) {
-	vector<NoteCell*>& part = m_grid[vindex];
+void NoteGrid::buildAttackIndex(int vindex, bool indexes) {
+	vector<short>& b40  = m_base40[vindex];
+	vector<char>&  flags = m_flags[vindex];
+	vector<int>&   curr = m_currattack[vindex];
+	vector<int>&   prev = m_prevattack[vindex];
+	vector<int>&   next = m_nextattack[vindex];
+	int size = (int)b40.size();
+	flags.assign(size, 0);
+	curr.assign(size, -1);
+	prev.assign(size, -1);
+	next.assign(size, -1);
+
+	for (int i=0; i<size; i++) {
+		if (b40[i] == GRIDREST40) {
+			flags[i] |= CellRest;
+		} else if (b40[i] > 0) {
+			flags[i] |= CellAttack;
+		}
+	}
+
+	if (!indexes) {
+		for (int i=0; i<size; i++) {
+			if ((b40[i] < 0) || (flags[i] & CellRest) || (b40[i] == 0)) {
+				flags[i] |= CellSustain;
+			}
+		}
+		return;
+	}
 
 	// Set the slice index for the attack of the current note.  This
-	// will be the same as the current slice if the NoteCell is an attack.
+	// will be the same as the current slice if the cell is an attack.
 	// Otherwise if the note is a sustain, thie index will be set
-	// to the slice of the attack correspinding to this NoteCell.
+	// to the slice of the attack correspinding to this cell.
 	// For rests, the first rest in a continuous sequence of rests
 	// will be marked as the "attack" of the rest.
-	NoteCell* currentcell = NULL;
-	for (int i=0; i<(int)part.size(); i++) {
+	for (int i=0; i<size; i++) {
 		if (i == 0) {
-			part[0]->setCurrAttackIndex(0);
-			continue;
-		}
-		if (part[i]->isRest()) {
-			// This is a rest, so check for a rest sustain or start
-			// of a rest sequence.
-			if (part[i-1]->isRest()) {
-				// rest "sustain"
-				if (currentcell && !part[i]->getToken()->isNull()) {
-					currentcell->m_tiedtokens.push_back(part[i]->getToken());
-				}
-				part[i]->setCurrAttackIndex(part[i-1]->getCurrAttackIndex());
-			} else {
-				// rest "attack";
-				part[i]->setCurrAttackIndex(i);
-			}
-		} else if (part[i]->isAttack()) {
-			part[i]->setCurrAttackIndex(i);
-			currentcell = part[i];
+			curr[0] = 0;
+		} else if (flags[i] & CellRest) {
+			// rest "sustain" or rest "attack":
+			curr[i] = (flags[i-1] & CellRest) ? curr[i-1] : i;
+		} else if (flags[i] & CellAttack) {
+			curr[i] = i;
 		} else {
 			// This is a sustain, so get the attack index of the
 			// note from the previous slice index.
-			part[i]->setCurrAttackIndex(part[i-1]->getCurrAttackIndex());
-			if (currentcell && !part[i]->getToken()->isNull()) {
-				currentcell->m_tiedtokens.push_back(part[i]->getToken());
+			curr[i] = curr[i-1];
+		}
+		// Rests (and unpitched cells) are sustained unless they are
+		// the first rest in a sequence of rests.
+		if ((flags[i] & CellRest) || (b40[i] == 0)) {
+			if (curr[i] != i) {
+				flags[i] |= CellSustain;
 			}
+		} else if (b40[i] < 0) {
+			flags[i] |= CellSustain;
 		}
 	}
 
 	// start with note attacks marked in the previous and next note slots:
-	for (int i=0; i<(int)part.size(); i++) {
-		if (part[i]->isAttack()) {
-			part[i]->setNextAttackIndex(i);
-			part[i]->setPrevAttackIndex(i);
-		} else if (part[i]->isRest()) {
-			if (part[i]->getCurrAttackIndex() == i) {
-				part[i]->setNextAttackIndex(i);
-				part[i]->setPrevAttackIndex(i);
-			}
+	for (int i=0; i<size; i++) {
+		if ((flags[i] & CellAttack) || ((flags[i] & CellRest) && (curr[i] == i))) {
+			next[i] = i;
+			prev[i] = i;
 		}
 	}
 
 	// Go back and adjust the next note attack index:
 	int value = -1;
 	int temp  = -1;
-	for (int i=(int)part.size()-1; i>=0; i--) {
-		if (!part[i]->isSustained()) {
-			temp = part[i]->getNextAttackIndex();
-			part[i]->setNextAttackIndex(value);
+	for (int i=size-1; i>=0; i--) {
+		if (!(flags[i] & CellSustain)) {
+			temp = next[i];
+			next[i] = value;
 			value = temp;
 		} else {
-			part[i]->setNextAttackIndex(value);
+			next[i] = value;
 		}
 	}
 
 	// Go back and adjust the previous note attack index:
 	value = -1;
 	temp  = -1;
-	for (int i=0; i<(int)part.size(); i++) {
-		if (!part[i]->isSustained()) {
-			temp = part[i]->getPrevAttackIndex();
-			part[i]->setPrevAttackIndex(value);
+	for (int i=0; i<size; i++) {
+		if (!(flags[i] & CellSustain)) {
+			temp = prev[i];
+			prev[i] = value;
 			value = temp;
 		} else {
 			if (i != 0) {
-				part[i]->setPrevAttackIndex(part[i-1]->getPrevAttackIndex());
+				prev[i] = prev[i-1];
 			}
 		}
 	}
+}
 
+
+
+//////////////////////////////
+//
+// NoteGrid::getTiedTokens -- Return the tokens of the tied notes (and
+//    rests) which follow a note attack, up to the next note attack.
+//    Rests which follow a note are included after the first rest.
+//    An attack in the first slice, or in a grid without attack indexes,
+//    has no tied tokens.
+//
+
+vector<HTp> NoteGrid::getTiedTokens(int vindex, int sindex) {
+	vector<HTp> output;
+	vector<char>& flags = m_flags.at(vindex);
+	vector<HTp>& tokens = m_tokens.at(vindex);
+	if ((sindex == 0) || !(flags.at(sindex) & CellAttack)) {
+		return output;
+	}
+	if (m_currattack[vindex][sindex] < 0) {
+		return output;
+	}
+	for (int i=sindex+1; i<(int)flags.size(); i++) {
+		if (flags[i] & CellAttack) {
+			break;
+		}
+		if ((flags[i] & CellRest) && !(flags[i-1] & CellRest)) {
+			// rest "attack"
+			continue;
+		}
+		if (!tokens[i]->isNull()) {
+			output.push_back(tokens[i]);
+		}
+	}
+	return output;
 }
 
 
@@ -413,7 +545,7 @@ void NoteGrid::buildAttackIndex(int vindex) {
 //
 
 double NoteGrid::getAbsDiatonicPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getAbsDiatonicPitch();
+	return m_grid.at(vindex).at(sindex).getAbsDiatonicPitch();
 }
 
 
@@ -425,7 +557,7 @@ double NoteGrid::getAbsDiatonicPitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getSgnDiatonicPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getSgnDiatonicPitch();
+	return m_grid.at(vindex).at(sindex).getSgnDiatonicPitch();
 }
 
 
@@ -437,7 +569,7 @@ double NoteGrid::getSgnDiatonicPitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getAbsMidiPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getAbsMidiPitch();
+	return m_grid.at(vindex).at(sindex).getAbsMidiPitch();
 }
 
 
@@ -449,7 +581,7 @@ double NoteGrid::getAbsMidiPitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getSgnMidiPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getSgnMidiPitch();
+	return m_grid.at(vindex).at(sindex).getSgnMidiPitch();
 }
 
 
@@ -461,7 +593,7 @@ double NoteGrid::getSgnMidiPitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getAbsBase40Pitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getAbsBase40Pitch();
+	return m_grid.at(vindex).at(sindex).getAbsBase40Pitch();
 }
 
 
@@ -473,7 +605,7 @@ double NoteGrid::getAbsBase40Pitch(int vindex, int sindex) {
 //
 
 double NoteGrid::getSgnBase40Pitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getSgnBase40Pitch();
+	return m_grid.at(vindex).at(sindex).getSgnBase40Pitch();
 }
 
 
@@ -485,7 +617,7 @@ double NoteGrid::getSgnBase40Pitch(int vindex, int sindex) {
 //
 
 string NoteGrid::getAbsKernPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getAbsKernPitch();
+	return m_grid.at(vindex).at(sindex).getAbsKernPitch();
 }
 
 
@@ -497,7 +629,7 @@ string NoteGrid::getAbsKernPitch(int vindex, int sindex) {
 //
 
 string NoteGrid::getSgnKernPitch(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getSgnKernPitch();
+	return m_grid.at(vindex).at(sindex).getSgnKernPitch();
 }
 
 
@@ -509,7 +641,7 @@ string NoteGrid::getSgnKernPitch(int vindex, int sindex) {
 //
 
 HTp NoteGrid::getToken(int vindex, int sindex) {
-	return m_grid.at(vindex).at(sindex)->getToken();
+	return m_grid.at(vindex).at(sindex).getToken();
 }
 
 
@@ -523,8 +655,8 @@ HTp NoteGrid::getToken(int vindex, int sindex) {
 //
 
 int NoteGrid::getPrevAttackDiatonic(int vindex, int sindex) {
-	NoteCell*& cell = m_grid.at(vindex).at(sindex);
-	int index = cell->getPrevAttackIndex();
+	NoteCell& cell = m_grid.at(vindex).at(sindex);
+	int index = cell.getPrevAttackIndex();
 	if (index < 0) {
 		return 0;
 	} else {
@@ -543,8 +675,8 @@ int NoteGrid::getPrevAttackDiatonic(int vindex, int sindex) {
 //
 
 int NoteGrid::getNextAttackDiatonic(int vindex, int sindex) {
-	NoteCell*& cell = m_grid.at(vindex).at(sindex);
-	int index = cell->getNextAttackIndex();
+	NoteCell& cell = m_grid.at(vindex).at(sindex);
+	int index = cell.getNextAttackIndex();
 	if (index < 0) {
 		return 0;
 	} else {
@@ -561,10 +693,10 @@ int NoteGrid::getNextAttackDiatonic(int vindex, int sindex) {
 //
 
 int NoteGrid::getLineIndex(int sindex) {
-	if (m_grid.size() == 0) {
+	if (m_tokens.size() == 0) {
 		return -1;
 	}
-	return m_grid.at(0).at(sindex)->getToken()->getLineIndex();
+	return m_tokens.at(0).at(sindex)->getLineIndex();
 }
 
 
@@ -576,10 +708,10 @@ int NoteGrid::getLineIndex(int sindex) {
 //
 
 int NoteGrid::getFieldIndex(int sindex) {
-	if (m_grid.size() == 0) {
+	if (m_tokens.size() == 0) {
 		return -1;
 	}
-	return m_grid.at(0).at(sindex)->getToken()->getFieldIndex();
+	return m_tokens.at(0).at(sindex)->getFieldIndex();
 }
 
 
@@ -659,6 +791,29 @@ HumNum NoteGrid::getNoteDuration(int vindex, int sindex) {
 
 
 
+//////////////////////////////
+//
+// NoteGrid::getStorageSize -- Return the number of bytes allocated
+//    for the cells of the grid.
+//
+
+size_t NoteGrid::getStorageSize(void) {
+	size_t output = m_meters.capacity() * sizeof(m_meters[0]);
+	for (int i=0; i<getVoiceCount(); i++) {
+		output += m_grid[i].capacity()       * sizeof(NoteCell);
+		output += m_tokens[i].capacity()     * sizeof(HTp);
+		output += m_base40[i].capacity()     * sizeof(short);
+		output += m_flags[i].capacity()      * sizeof(char);
+		output += m_prevattack[i].capacity() * sizeof(int);
+		output += m_currattack[i].capacity() * sizeof(int);
+		output += m_nextattack[i].capacity() * sizeof(int);
+		output += m_meter[i].capacity()      * sizeof(short);
+	}
+	return output;
+}
+
+
+
 //////////////////////////////
 //
 // NoteGrid::printGridInfo -- for debugging.
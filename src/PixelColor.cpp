@@ -515,7 +515,7 @@ PixelColor PixelColor::getColor(const string& colorstring) {
 	int length = (int)colorstring.size();
 	if (length > 128) {
 		cout << "ERROR: color string too long: " << colorstring << endl;
-		exit(1);
+		return output;
 	}
 	if (length == 7) {
 		if (colorstring[0] == '#') {
@@ -100,8 +100,7 @@ bool Tool_autobeam::run(HumdrumFile& infile) {
 		addBeams(infile);
 	}
 	// Re-load the text for each line from their tokens.
-	infile.createLinesFromTokens();
-	m_humdrum_text << infile;
+	printEditedFile(infile);
 	return true;
 }
 
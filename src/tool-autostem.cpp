@@ -745,7 +745,8 @@ void Tool_autostem::getNotePositions(vector<vector<vector<int> > >& notepos,
 
 void Tool_autostem::processKernTokenStems(HumdrumFile& infile,
 		vector<vector<int> >& baseline, int row, int col) {
-	exit(1);
+	// not implemented: see processKernTokenStemsSimpleModel()
+	m_error_text << "Error: processKernTokenStems is not implemented" << endl;
 }
 
 
@@ -1166,8 +1167,8 @@ bool Tool_autostem::getBeamState(vector<vector<string > >& beams,
 				// grace notes;
 				countBeamStuff(infile.token(i, j)->c_str(), start, stop, flagr, flagl);
 				if ((start != 0) && (stop != 0)) {
-					cerr << "Funny error in grace note beam calculation" << endl;
-					exit(1);
+					m_error_text << "Funny error in grace note beam calculation" << endl;
+					return false;
 				}
 				if (start > 7) {
 					cerr << "Too many beam starts" << endl;
@@ -1207,8 +1208,8 @@ bool Tool_autostem::getBeamState(vector<vector<string > >& beams,
 				}
 				len = (int)gbinfo.size();
 				if (len > 6) {
-					cerr << "Error too many grace note beams" << endl;
-					exit(1);
+					m_error_text << "Error too many grace note beams" << endl;
+					return false;
 				}
 				beams.at(i).at(j) = gbinfo;
 				gracestate.at(track).at(curlayer.at(track)) = contin;
@@ -1220,8 +1221,8 @@ bool Tool_autostem::getBeamState(vector<vector<string > >& beams,
 
 				countBeamStuff(infile.token(i, j)->c_str(), start, stop, flagr, flagl);
 				if ((start != 0) && (stop != 0)) {
-					cerr << "Funny error in note beam calculation" << endl;
-					exit(1);
+					m_error_text << "Funny error in note beam calculation" << endl;
+					return false;
 				}
 				if (start > 7) {
 					cerr << "Too many beam starts" << endl;
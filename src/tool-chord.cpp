@@ -83,8 +83,7 @@ bool Tool_chord::run(HumdrumFile& infile, ostream& out) {
 bool Tool_chord::run(HumdrumFile& infile) {
 	initialize();
 	processFile(infile, m_direction);
-	infile.createLinesFromTokens();
-	m_humdrum_text << infile;
+	printEditedFile(infile);
 	return true;
 }
 
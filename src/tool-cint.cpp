@@ -140,7 +140,7 @@ bool Tool_cint::run(HumdrumFile& infile) {
 		// getAllText(cout);
 	} else {
 		// Re-load the text for each line from their tokens.
-		cout << infile;
+		m_humdrum_text << infile;
 	}
 
 	return true;
@@ -221,7 +221,9 @@ string NoteNode::getId(void) {
 
 int Tool_cint::processFile(HumdrumFile& infile) {
 
-   initialize();
+	if (!initialize()) {
+		return 0;
+	}
 
 	vector<vector<NoteNode> > notes;
 	vector<string> names;
@@ -264,7 +266,7 @@ int Tool_cint::processFile(HumdrumFile& infile) {
 
 	if (pitchesQ) {
 		printPitchGrid(notes, infile);
-		exit(0);
+		return 0;
 	}
 
 	int count = 0;
@@ -2593,25 +2595,27 @@ void Tool_cint::getNames(vector<string>& names, vector<int>& reverselookup,
 //////////////////////////////
 //
 // Tool_cint::initialize -- validate and process command-line options.
+//     Returns false if the file should not be processed (for options
+//     such as --help).
 //
 
-void Tool_cint::initialize(void) {
+bool Tool_cint::initialize(void) {
 
 	// handle basic options:
 	if (getBoolean("author")) {
 		m_humdrum_text << "Written by Craig Stuart Sapp, "
 			  << "craig@ccrma.stanford.edu, September 2013" << endl;
-		exit(0);
+		return false;
 	} else if (getBoolean("version")) {
 		m_humdrum_text << getCommand() << ", version: 16 March 2022" << endl;
 		m_humdrum_text << "compiled: " << __DATE__ << endl;
-		exit(0);
+		return false;
 	} else if (getBoolean("help")) {
 		usage(getCommand());
-		exit(0);
+		return false;
 	} else if (getBoolean("example")) {
 		example();
-		exit(0);
+		return false;
 	}
 
 	koptionQ = getBoolean("koption");
@@ -2707,6 +2711,7 @@ void Tool_cint::initialize(void) {
 		SearchString = getString("search");
 	}
 
+	return true;
 }
 
 
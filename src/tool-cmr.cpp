@@ -1575,9 +1575,9 @@ void Tool_cmr::printVegaPlot(void) {
 		  "description": "A vertical box plot showing median, min, and max CMR count in Josquin.",
 		  "data": {
 		    "values": [)";
-		cout << vegaDataHeader << endl;
+		m_free_text << vegaDataHeader << endl;
 
-		cout << m_vegaData.str() << endl;
+		m_free_text << m_vegaData.str() << endl;
 
 		if (m_vegaCountQ) {
 			string vegaDataFooter = R"(
@@ -1597,7 +1597,7 @@ void Tool_cmr::printVegaPlot(void) {
 			 }
 		 })";
 
-		 cout << vegaDataFooter << endl;
+		 m_free_text << vegaDataFooter << endl;
 	 } else	if (m_vegaStrengthQ) {
 	 			string vegaDataFooter = R"(
 	 			]},
@@ -1616,7 +1616,7 @@ void Tool_cmr::printVegaPlot(void) {
 	 			 }
 	 		 })";
 
-		cout << vegaDataFooter << endl;
+		m_free_text << vegaDataFooter << endl;
 	 	} else {
 			string vegaDataFooter = R"(
 		 ]},
@@ -1634,7 +1634,7 @@ void Tool_cmr::printVegaPlot(void) {
 				}
 			}
 		})";
-			cout << vegaDataFooter << endl;
+			m_free_text << vegaDataFooter << endl;
 	 }
 }
 
@@ -1659,7 +1659,7 @@ void Tool_cmr::printHtmlPlot(void) {
 <div id="plotarea"></div>
 <script type="text/javascript">
 var mydata =)";
-	cout << header << endl;
+	m_free_text << header << endl;
 
 	printVegaPlot();
 
@@ -1667,7 +1667,7 @@ var mydata =)";
 </script>
 </body>
 </html>)";
-	cout << footer << endl;
+	m_free_text << footer << endl;
 }
 
 
@@ -1695,10 +1695,10 @@ void Tool_cmr::finally(void) {
 		double meanCmrNoteDen = Convert::mean(cmrNoteDensities);
 		double stdDevCmrNoteDen = Convert::standardDeviation(cmrNoteDensities);
 
-		cout << "CMR count mean: " << meanCmrCount << endl;
-		cout << "CMR count standard deviation: " << stdDevCmrCount << endl;
-		cout << "CMR note density mean: " << meanCmrNoteDen * 1000 << " permil " << endl;
-		cout << "CMR note density standard deviation: " << stdDevCmrNoteDen * 1000 << " permil " << endl;
+		m_free_text << "CMR count mean: " << meanCmrCount << endl;
+		m_free_text << "CMR count standard deviation: " << stdDevCmrCount << endl;
+		m_free_text << "CMR note density mean: " << meanCmrNoteDen * 1000 << " permil " << endl;
+		m_free_text << "CMR note density standard deviation: " << stdDevCmrNoteDen * 1000 << " permil " << endl;
 	}
 
 }
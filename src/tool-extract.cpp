@@ -65,6 +65,8 @@ Tool_extract::Tool_extract(void) {
 	define("version=b",                 "compilation info");
 	define("example=b",                 "example usages");
 	define("h|help=b",                  "short description");
+
+	setRequiredAnalyses(0);
 }
 
 
@@ -12,102 +12,22 @@
 
 #include "tool-filter.h"
 
-// tools which filter can process:
-
-#include "tool-addic.h"
-#include "tool-addkey.h"
-#include "tool-addlabels.h"
-#include "tool-addtempo.h"
-#include "tool-autoaccid.h"
-#include "tool-autobeam.h"
-#include "tool-autocadence.h"
-#include "tool-autostem.h"
-#include "tool-barnum.h"
-#include "tool-binroll.h"
-#include "tool-bstyle.h"
-#include "tool-chantize.h"
-#include "tool-chint.h"
+#include "HumToolRegistry.h"
+
+// tools which filter can process on sets of files:
+
 #include "tool-chooser.h"
-#include "tool-chord.h"
-#include "tool-cint.h"
-#include "tool-cmr.h"
-#include "tool-colorgroups.h"
-#include "tool-colortriads.h"
-#include "tool-composite.h"
-#include "tool-deg.h"
-#include "tool-dissonant.h"
-#include "tool-double.h"
-#include "tool-extract.h"
-#include "tool-extremis.h"
-#include "tool-fb.h"
-#include "tool-flipper.h"
-#include "tool-gasparize.h"
-#include "tool-grep.h"
-#include "tool-half.h"
-#include "tool-hands.h"
-#include "tool-homorhythm.h"
-#include "tool-homorhythm2.h"
-#include "tool-hproof.h"
-#include "tool-humbreak.h"
 #include "tool-humdiff.h"
-#include "tool-humsheet.h"
-#include "tool-humtr.h"
-#include "tool-imitation.h"
-#include "tool-instinfo.h"
-#include "tool-kern2mens.h"
-#include "tool-kernify.h"
-#include "tool-kernview.h"
-#include "tool-mei2hum.h"
-#include "tool-melisma.h"
-#include "tool-mens2kern.h"
-#include "tool-meter.h"
-#include "tool-metlev.h"
-#include "tool-mint.h"
-#include "tool-modori.h"
-#include "tool-msearch.h"
 #include "tool-myank.h"
-#include "tool-nproof.h"
-#include "tool-ordergps.h"
-#include "tool-pbar.h"
-#include "tool-phrase.h"
-#include "tool-pline.h"
-#include "tool-prange.h"
-#include "tool-recip.h"
-#include "tool-restfill.h"
-#include "tool-rmask.h"
-#include "tool-rid.h"
-#include "tool-rphrase.h"
-#include "tool-sab2gs.h"
-#include "tool-satb2gs.h"
-#include "tool-scordatura.h"
-#include "tool-semitones.h"
-#include "tool-shed.h"
-#include "tool-sic.h"
-#include "tool-simat.h"
-#include "tool-slurcheck.h"
-#include "tool-spinetrace.h"
-#include "tool-strophe.h"
-#include "tool-synco.h"
-#include "tool-tabber.h"
-#include "tool-tandeminfo.h"
-#include "tool-tassoize.h"
-#include "tool-text.h"
-#include "tool-textdur.h"
-#include "tool-thru.h"
-#include "tool-tie.h"
-#include "tool-timebase.h"
-#include "tool-transpose.h"
-#include "tool-tremolo.h"
-#include "tool-trillspell.h"
-#include "tool-triad.h"
-#include "tool-tspos.h"
-#include "tool-vcross.h"
-#include "tool-1520ify.h"
 
 #include "HumRegex.h"
 
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 
 
 using namespace std;
@@ -120,28 +40,15 @@ namespace hum {
 #define RUNTOOL(NAME, INFILE, COMMAND, STATUS)     \
 	Tool_##NAME *tool = new Tool_##NAME;            \
 	tool->process(COMMAND);                         \
+	startStage(INFILE);                             \
 	tool->run(INFILE);                              \
 	if (tool->hasError()) {                         \
 		status = false;                              \
-		tool->getError(cerr);                        \
+		tool->getError(getStageErrorStream());       \
 		delete tool;                                 \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
-		INFILE.readString(tool->getHumdrumText());   \
-	}                                               \
-	delete tool;
-
-#define RUNTOOL2(NAME, INFILE1, INFILE2, COMMAND, STATUS) \
-	Tool_##NAME *tool = new Tool_##NAME;            \
-	tool->process(COMMAND);                         \
-	tool->run(INFILE1, INFILE2);                    \
-	if (tool->hasError()) {                         \
-		status = false;                              \
-		tool->getError(cerr);                        \
-		delete tool;                                 \
-		break;                                       \
-	} else if (tool->hasHumdrumText()) {            \
-		INFILE1.readString(tool->getHumdrumText());  \
+		finishStage(INFILE, tool->getHumdrumText()); \
 	}                                               \
 	delete tool;
 
@@ -151,7 +58,7 @@ namespace hum {
 	tool->run(INFILES);                             \
 	if (tool->hasError()) {                         \
 		status = false;                              \
-		tool->getError(cerr);                        \
+		tool->getError(getStageErrorStream());       \
 		delete tool;                                 \
 		break;                                       \
 	} else if (tool->hasHumdrumText()) {            \
@@ -165,7 +72,7 @@ namespace hum {
 	tool->run(INFILES);                                \
 	if (tool->hasError()) {                            \
 		status = false;                                 \
-		tool->getError(cerr);                           \
+		tool->getError(getStageErrorStream());          \
 		delete tool;                                    \
 		break;                                          \
 	} else if (tool->hasHumdrumText()) {               \
@@ -183,6 +90,8 @@ namespace hum {
 Tool_filter::Tool_filter(void) {
 	define("debug=b",      "print debug statement");
 	define("v|variant=s:", "Run filters labeled with the given variant");
+	define("R|reparse=b",  "Re-read the data after each filter stage");
+	define("j|jobs=i:1",   "Number of files to filter in parallel (0 = all cores)");
 }
 
 
@@ -252,240 +161,25 @@ bool Tool_filter::run(HumdrumFileSet& infiles) {
 	bool status = true;
 	vector<pair<string, string> > commands;
 	getCommandList(commands, infile);
+	startAnalyses(infile);
 	for (int i=0; i<(int)commands.size(); i++) {
-		if (commands[i].first == "addic") {
-			RUNTOOL(addic, infile, commands[i].second, status);
-		} else if (commands[i].first == "addkey") {
-			RUNTOOL(addkey, infile, commands[i].second, status);
-		} else if (commands[i].first == "addlabels") {
-			RUNTOOL(addlabels, infile, commands[i].second, status);
-		} else if (commands[i].first == "addtempo") {
-			RUNTOOL(addtempo, infile, commands[i].second, status);
-		} else if (commands[i].first == "autoaccid") {
-			RUNTOOL(autoaccid, infile, commands[i].second, status);
-		} else if (commands[i].first == "autobeam") {
-			RUNTOOL(autobeam, infile, commands[i].second, status);
-		} else if (commands[i].first == "autocadence") {
-			RUNTOOL(autocadence, infile, commands[i].second, status);
-		} else if (commands[i].first == "autostem") {
-			RUNTOOL(autostem, infile, commands[i].second, status);
-		} else if (commands[i].first == "barnum") {
-			RUNTOOL(barnum, infile, commands[i].second, status);
-		} else if (commands[i].first == "bstyle") {
-			RUNTOOL(bstyle, infile, commands[i].second, status);
-		} else if (commands[i].first == "binroll") {
-			RUNTOOL(binroll, infile, commands[i].second, status);
-		} else if (commands[i].first == "chantize") {
-			RUNTOOL(chantize, infile, commands[i].second, status);
-		} else if (commands[i].first == "chint") {
-			RUNTOOL(chint, infile, commands[i].second, status);
-		} else if (commands[i].first == "chord") {
-			RUNTOOL(chord, infile, commands[i].second, status);
-		} else if (commands[i].first == "cint") {
-			RUNTOOL(cint, infile, commands[i].second, status);
-		} else if (commands[i].first == "cmr") {
-			RUNTOOL(cmr, infile, commands[i].second, status);
-		} else if (commands[i].first == "composite") {
-			RUNTOOL(composite, infile, commands[i].second, status);
-		} else if (commands[i].first == "dissonant") {
-			RUNTOOL(dissonant, infile, commands[i].second, status);
-		} else if (commands[i].first == "double") {
-			RUNTOOL(double, infile, commands[i].second, status);
-		} else if (commands[i].first == "extremis") {
-			RUNTOOL(extremis, infile, commands[i].second, status);
-		} else if (commands[i].first == "fb") {
-			RUNTOOL(fb, infile, commands[i].second, status);
-		} else if (commands[i].first == "flipper") {
-			RUNTOOL(flipper, infile, commands[i].second, status);
-		} else if (commands[i].first == "filter") {
-			RUNTOOL(filter, infile, commands[i].second, status);
-		} else if (commands[i].first == "gasparize") {
-			RUNTOOL(gasparize, infile, commands[i].second, status);
-		} else if (commands[i].first == "half") {
-			RUNTOOL(half, infile, commands[i].second, status);
-		} else if (commands[i].first == "hands") {
-			RUNTOOL(hands, infile, commands[i].second, status);
-		} else if (commands[i].first == "homorhythm") {
-			RUNTOOL(homorhythm, infile, commands[i].second, status);
-		} else if (commands[i].first == "homorhythm2") {
-			RUNTOOL(homorhythm2, infile, commands[i].second, status);
-		} else if (commands[i].first == "hproof") {
-			RUNTOOL(hproof, infile, commands[i].second, status);
-		} else if (commands[i].first == "humbreak") {
-			RUNTOOL(humbreak, infile, commands[i].second, status);
-		} else if (commands[i].first == "humsheet") {
-			RUNTOOL(humsheet, infile, commands[i].second, status);
-		} else if (commands[i].first == "humtr") {
-			RUNTOOL(humtr, infile, commands[i].second, status);
-		} else if (commands[i].first == "imitation") {
-			RUNTOOL(imitation, infile, commands[i].second, status);
-		} else if (commands[i].first == "instinfo") {
-			RUNTOOL(instinfo, infile, commands[i].second, status);
-		} else if (commands[i].first == "kern2mens") {
-			RUNTOOL(kern2mens, infile, commands[i].second, status);
-		} else if (commands[i].first == "kernify") {
-			RUNTOOL(kernify, infile, commands[i].second, status);
-		} else if (commands[i].first == "kernview") {
-			RUNTOOL(kernview, infile, commands[i].second, status);
-		} else if (commands[i].first == "melisma") {
-			RUNTOOL(melisma, infile, commands[i].second, status);
-		} else if (commands[i].first == "mens2kern") {
-			RUNTOOL(mens2kern, infile, commands[i].second, status);
-		} else if (commands[i].first == "meter") {
-			RUNTOOL(meter, infile, commands[i].second, status);
-		} else if (commands[i].first == "metlev") {
-			RUNTOOL(metlev, infile, commands[i].second, status);
-		} else if (commands[i].first == "mint") { // humlib version of Humdrum Toolkit mint tool
-			RUNTOOL(mint, infile, commands[i].second, status);
-		} else if (commands[i].first == "mintx") { // humlib cli name
-			RUNTOOL(mint, infile, commands[i].second, status);
-		} else if (commands[i].first == "modori") {
-			RUNTOOL(modori, infile, commands[i].second, status);
-		} else if (commands[i].first == "msearch") {
-			RUNTOOL(msearch, infile, commands[i].second, status);
-		} else if (commands[i].first == "nproof") {
-			RUNTOOL(nproof, infile, commands[i].second, status);
-		} else if (commands[i].first == "ordergps") {
-			RUNTOOL(ordergps, infile, commands[i].second, status);
-		} else if (commands[i].first == "pbar") {
-			RUNTOOL(pbar, infile, commands[i].second, status);
-		} else if (commands[i].first == "phrase") {
-			RUNTOOL(phrase, infile, commands[i].second, status);
-		} else if (commands[i].first == "pline") {
-			RUNTOOL(pline, infile, commands[i].second, status);
-		} else if (commands[i].first == "prange") {
-			RUNTOOL(prange, infile, commands[i].second, status);
-		} else if (commands[i].first == "recip") {
-			RUNTOOL(recip, infile, commands[i].second, status);
-		} else if (commands[i].first == "rmask") {
-			RUNTOOL(rmask, infile, commands[i].second, status);
-		} else if (commands[i].first == "restfill") {
-			RUNTOOL(restfill, infile, commands[i].second, status);
-		} else if (commands[i].first == "rphrase") {
-			RUNTOOL(rphrase, infile, commands[i].second, status);
-		} else if (commands[i].first == "sab2gs") {
-			RUNTOOL(sab2gs, infile, commands[i].second, status);
-		} else if (commands[i].first == "scordatura") {
-			RUNTOOL(scordatura, infile, commands[i].second, status);
-		} else if (commands[i].first == "semitones") {
-			RUNTOOL(semitones, infile, commands[i].second, status);
-		} else if (commands[i].first == "shed") {
-			RUNTOOL(shed, infile, commands[i].second, status);
-		} else if (commands[i].first == "sic") {
-			RUNTOOL(sic, infile, commands[i].second, status);
-		} else if (commands[i].first == "simat") {
-			RUNTOOL2(simat, infile, infile, commands[i].second, status);
-		} else if (commands[i].first == "slurcheck") {
-			RUNTOOL(slurcheck, infile, commands[i].second, status);
-		} else if (commands[i].first == "slur") {
-			RUNTOOL(slurcheck, infile, commands[i].second, status);
-		} else if (commands[i].first == "spinetrace") {
-			RUNTOOL(spinetrace, infile, commands[i].second, status);
-		} else if (commands[i].first == "strophe") {
-			RUNTOOL(strophe, infile, commands[i].second, status);
-		} else if (commands[i].first == "synco") {
-			RUNTOOL(synco, infile, commands[i].second, status);
-		} else if (commands[i].first == "tabber") {
-			RUNTOOL(tabber, infile, commands[i].second, status);
-		} else if (commands[i].first == "tandeminfo") {
-			RUNTOOL(tandeminfo, infile, commands[i].second, status);
-		} else if (commands[i].first == "tassoize") {
-			RUNTOOL(tassoize, infile, commands[i].second, status);
-		} else if (commands[i].first == "tassoise") {
-			RUNTOOL(tassoize, infile, commands[i].second, status);
-		} else if (commands[i].first == "tasso") {
-			RUNTOOL(tassoize, infile, commands[i].second, status);
-		} else if (commands[i].first == "text") {
-			RUNTOOL(text, infile, commands[i].second, status);
-		} else if (commands[i].first == "textdur") {
-			RUNTOOL(textdur, infile, commands[i].second, status);
-		} else if (commands[i].first == "tie") {
-			RUNTOOL(tie, infile, commands[i].second, status);
-		} else if (commands[i].first == "triad") {
-			RUNTOOL(triad, infile, commands[i].second, status);
-		} else if (commands[i].first == "tspos") {
-			RUNTOOL(tspos, infile, commands[i].second, status);
-		} else if (commands[i].first == "transpose") {
-			RUNTOOL(transpose, infile, commands[i].second, status);
-		} else if (commands[i].first == "tremolo") {
-			RUNTOOL(tremolo, infile, commands[i].second, status);
-		} else if (commands[i].first == "trillspell") {
-			RUNTOOL(trillspell, infile, commands[i].second, status);
-		} else if (commands[i].first == "vcross") {
-			RUNTOOL(vcross, infile, commands[i].second, status);
-		} else if (commands[i].first == "1520ify") {
-			RUNTOOL(1520ify, infile, commands[i].second, status);
-
-		// filters with aliases:
-
-		} else if (commands[i].first == "colortriads") {
-			RUNTOOL(colortriads, infile, commands[i].second, status);
-		} else if (commands[i].first == "colourtriads") {
-			// British spelling
-			RUNTOOL(colortriads, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "colorthirds") {
-			RUNTOOL(tspos, infile, commands[i].second, status);
-		} else if (commands[i].first == "colourthirds") {
-			// British spelling
-			RUNTOOL(tspos, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "colorgroups") {
-			RUNTOOL(colorgroups, infile, commands[i].second, status);
-		} else if (commands[i].first == "colourgroups") { // British spelling
-			RUNTOOL(colorgroups, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "deg") { // humlib version of Humdrum Toolkit deg tool
-			RUNTOOL(deg, infile, commands[i].second, status);
-		} else if (commands[i].first == "degx") { // humlib cli name
-			RUNTOOL(deg, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "extract") { // humlib version of Humdrum Toolkit extract tool
-			RUNTOOL(extract, infile, commands[i].second, status);
-		} else if (commands[i].first == "extractx") { // humlib cli name
-			RUNTOOL(extract, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "grep") {
-			RUNTOOL(grep, infile, commands[i].second, status);
-		} else if (commands[i].first == "humgrep") {
-			RUNTOOL(grep, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "myank") { // humlib version of Humdrum Extras myank tool
-			RUNTOOL(myank, infile, commands[i].second, status);
-		} else if (commands[i].first == "myankx") { // humlib cli name
-			RUNTOOL(myank, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "rid") { // humlib version of Humdrum Toolkit deg tool
-			RUNTOOL(rid, infile, commands[i].second, status);
-		} else if (commands[i].first == "ridx") { // Humdrum Extra cli name
-			RUNTOOL(rid, infile, commands[i].second, status);
-		} else if (commands[i].first == "ridxx") { // humlib cli name
-			RUNTOOL(rid, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "satb2gs") { // humlib version of Humdrum Extras satg2gs tool
-			RUNTOOL(satb2gs, infile, commands[i].second, status);
-		} else if (commands[i].first == "satb2gsx") { // humlib cli name
-			RUNTOOL(satb2gs, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "thru") { // humlib version of Humdrum Toolkit thru tool
-			RUNTOOL(thru, infile, commands[i].second, status);
-		} else if (commands[i].first == "thrux") { // Humdrum Extras cli name
-			RUNTOOL(thru, infile, commands[i].second, status);
-		} else if (commands[i].first == "thruxx") { // humlib cli name
-			RUNTOOL(thru, infile, commands[i].second, status);
-
-		} else if (commands[i].first == "timebase") { // humlib version of Humdrum Toolkit timebase tool
-			RUNTOOL(timebase, infile, commands[i].second, status);
-		} else if (commands[i].first == "timebasex") { // humlib cli name
-			RUNTOOL(timebase, infile, commands[i].second, status);
-		} else {
-			cerr << "UNKNOWN FILTER: " << commands[i].first << " OPTIONS: " << commands[i].second << endl;
+		const HumToolRegistry::Entry* entry = HumToolRegistry::getEntry(commands[i].first);
+		if (!entry) {
+			(m_batchQ ? m_warning_text : cerr) << "UNKNOWN FILTER: " << commands[i].first << " OPTIONS: " << commands[i].second << endl;
+			continue;
+		}
+		if (!runStage(*entry, infile, commands[i].second)) {
+			status = false;
+			break;
 		}
-
 	}
 
 	removeGlobalFilterLines(infile);
 
+	// Files filtered by runBatch() are only printed, so they do not
+	// need the analyses which were skipped by the stages:
+	finishAnalyses(infile, !m_batchQ);
+
 	// Re-load the text for each line from their tokens in case any
 	// updates are needed from token changes.
 	infile.createLinesFromTokens();
@@ -494,6 +188,480 @@ bool Tool_filter::run(HumdrumFileSet& infiles) {
 
 
 
+//////////////////////////////
+//
+// Tool_filter::runPipeline -- Run a pipeline of tools (such as
+//     "autobeam | transpose -t M2") on a file, as if the pipeline were
+//     given in a !!!filter: line of the file.  The filtered file is
+//     stored in the Humdrum text of the filter, and the JSON and free text
+//     of the last tool are stored in the JSON and free text of the filter
+//     (the filtered file is not stored if the last tool only printed JSON
+//     or free text).  Warnings from all tools are stored in the warning
+//     text of the filter.  As for the files of runBatch(), errors are
+//     stored in the error text rather than being printed, and unknown
+//     tool options are ignored rather than ending the program, so this
+//     function can be used by long-running programs (see HumToolServer).
+//     Returns false if a tool is not found or has an error.
+//
+
+bool Tool_filter::runPipeline(HumdrumFile& infile, const string& pipeline) {
+	initialize(infile);
+	bool batch = m_batchQ;
+	m_batchQ = true;
+
+	bool status = true;
+	bool humdrum = true;
+	string json;
+	string text;
+	vector<string> clist;
+	splitPipeline(clist, pipeline);
+	startAnalyses(infile);
+	HumRegex hre;
+	for (int i=0; i<(int)clist.size(); i++) {
+		if (!hre.search(clist[i], "^\\s*([^\\s]+)")) {
+			continue;
+		}
+		string name = hre.getMatch(1);
+		const HumToolRegistry::Entry* entry = HumToolRegistry::getEntry(name);
+		if (!entry) {
+			m_error_text << "UNKNOWN TOOL: " << name << endl;
+			status = false;
+			break;
+		}
+		status = runStage(*entry, infile, clist[i]);
+		HumTool* tool = m_tools[entry->tool].get();
+		if (tool->hasWarning()) {
+			tool->getWarning(m_warning_text);
+		}
+		if (!status) {
+			break;
+		}
+		json = tool->getJsonText();
+		text = tool->getFreeText();
+		humdrum = tool->hasHumdrumText() || tool->hasInPlaceOutput() ||
+				(json.empty() && text.empty());
+	}
+	m_batchQ = batch;
+	finishAnalyses(infile, true);
+
+	if (!status) {
+		return false;
+	}
+	if (humdrum) {
+		infile.createLinesFromTokens();
+		m_humdrum_text << infile;
+	}
+	m_json_text << json;
+	m_free_text << text;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::runStage -- Run one filter stage on the file.  Returns
+//     false if the tool had an error.
+//
+
+bool Tool_filter::runStage(const HumToolRegistry::Entry& entry,
+		HumdrumFile& infile, const string& command) {
+	HumTool* tool = getStageTool(entry);
+	if (m_batchQ) {
+		// Do not exit on unknown options or --options:
+		tool->process(command, 0, 1);
+	} else {
+		tool->process(command);
+	}
+	tool->setInPlaceOutput(entry.inplace && !m_reparseQ);
+	if (tool->hasRequiredAnalyses()) {
+		infile.requireAnalyses(tool->getRequiredAnalyses());
+	} else {
+		infile.requireAnalyses(m_stageAnalyses);
+	}
+	startStage(infile);
+	entry.run(tool, infile);
+	if (tool->hasError()) {
+		tool->getError(getStageErrorStream());
+		return false;
+	} else if (tool->hasHumdrumText()) {
+		finishStage(infile, tool->getHumdrumText());
+	} else {
+		finishStage(infile);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::getStageTool -- Return the instance of the tool for a filter
+//     stage.  Each tool is created once by the filter and then reset for
+//     later stages and files.
+//
+
+HumTool* Tool_filter::getStageTool(const HumToolRegistry::Entry& entry) {
+	std::unique_ptr<HumTool>& tool = m_tools[entry.tool];
+	if (tool) {
+		entry.reset(tool.get());
+	} else {
+		tool.reset(entry.create());
+	}
+	return tool.get();
+}
+
+
+
+// ToolFilterBatchFile: one file being filtered by runBatch().
+struct ToolFilterBatchFile {
+	HumdrumFile infile;
+	std::string output;
+	std::string error;
+	std::string warning;
+	bool        status = true;
+	bool        done   = false;
+};
+
+
+
+//////////////////////////////
+//
+// Tool_filter::runBatch -- Run the filters of each file read from the
+//     input stream, using a pool of threads to filter up to the given
+//     number of files at the same time (0 = all cores).  Each thread
+//     filters its files with its own Tool_filter object, which has a
+//     copy of the options of this one and keeps its tools for the next
+//     file.  The filtered files are written to the output stream in the
+//     order of the input, and at most "window" files (default four per
+//     thread) are read but not yet written at any time, so memory use
+//     does not depend on the number of files.  Files with errors are not
+//     written: their errors (and any warnings) are printed in file order,
+//     and errors are stored for getBatchErrors().  Returns false if any
+//     file had an error.
+//
+
+bool Tool_filter::runBatch(HumdrumFileStream& instream, ostream& out,
+		int jobs, int window) {
+	m_batchErrors.clear();
+	int threads = jobs;
+	if (threads <= 0) {
+		threads = HumThreadPool::getHardwareThreadCount();
+	}
+	if (window <= 0) {
+		window = 4 * threads;
+	}
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::deque<std::shared_ptr<ToolFilterBatchFile>> files;
+	bool status = true;
+
+	std::unique_ptr<HumThreadPool> pool;
+	if (threads > 1) {
+		pool.reset(new HumThreadPool(threads));
+	}
+
+	// Filters for each worker thread of the pool, with the last one for
+	// files which are filtered in this thread.  Each filter is created
+	// when its thread filters its first file.
+	std::vector<std::unique_ptr<Tool_filter>> filters(threads + 1);
+
+	// Filter a file, storing the results with the file:
+	auto filterFile = [this, &pool, &mutex, &finished, &filters](std::shared_ptr<ToolFilterBatchFile> file) {
+		int index = pool ? pool->getWorkerIndex() : -1;
+		std::unique_ptr<Tool_filter>& pfilter = (index < 0) ? filters.back() : filters[index];
+		if (!pfilter) {
+			pfilter.reset(new Tool_filter);
+			pfilter->Options::operator=(*this);
+			pfilter->m_batchQ = true;
+		}
+		Tool_filter& filter = *pfilter;
+		filter.clearOutput();
+		stringstream output;
+		try {
+			file->status = filter.run(file->infile);
+			if (filter.hasAnyText()) {
+				filter.getAllText(output);
+			} else {
+				output << file->infile;
+			}
+		} catch (const std::exception& e) {
+			file->status = false;
+			filter.setError(e.what());
+		}
+		if (filter.hasWarning()) {
+			file->warning = filter.getWarning();
+		}
+		if (filter.hasError()) {
+			file->status = false;
+			file->error = file->infile.getFilename() + ": " + filter.getError();
+		} else if (!file->status) {
+			file->error = file->infile.getFilename() + ": filter failed";
+		}
+		if (file->status) {
+			file->output = output.str();
+		}
+		file->infile.clear();
+		std::lock_guard<std::mutex> lock(mutex);
+		file->done = true;
+		finished.notify_all();
+	};
+
+	// Write finished files in input order until at most "count" remain:
+	auto writeFiles = [&](int count) {
+		while ((int)files.size() > count) {
+			std::shared_ptr<ToolFilterBatchFile> file = files.front();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				finished.wait(lock, [&file]() { return file->done; });
+			}
+			files.pop_front();
+			out << file->output;
+			cerr << file->warning;
+			if (!file->status) {
+				status = false;
+				cerr << file->error << endl;
+				m_batchErrors.push_back(file->error);
+			}
+		}
+	};
+
+	while (true) {
+		std::shared_ptr<ToolFilterBatchFile> file = std::make_shared<ToolFilterBatchFile>();
+		if (!instream.read(file->infile)) {
+			break;
+		}
+		files.push_back(file);
+		if (pool) {
+			pool->submit([&filterFile, file]() { filterFile(file); });
+		} else {
+			filterFile(file);
+		}
+		writeFiles(window - 1);
+	}
+	writeFiles(0);
+	if (pool) {
+		pool->wait();
+	}
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::getBatchErrors -- Return the error messages for the files
+//     filtered by the last call to runBatch().
+//
+
+const vector<string>& Tool_filter::getBatchErrors(void) const {
+	return m_batchErrors;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::getStageErrorStream -- Return the stream for error messages
+//     from filter stages: the error text of the filter when filtering a
+//     file in runBatch(), or else standard error.
+//
+
+ostream& Tool_filter::getStageErrorStream(void) {
+	if (m_batchQ) {
+		return m_error_text;
+	}
+	return cerr;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::startAnalyses -- Prepare a file for the stages of the
+//     filter.  Files which are read again (or re-analyzed) after a stage
+//     are not analyzed when read, and each stage then does the analyses
+//     which its tool uses: the analyses declared by the tool with
+//     HumTool::setRequiredAnalyses(), or else the analyses of the file
+//     when it is read (see HumdrumFileBase::getReadAnalyses()).
+//
+
+void Tool_filter::startAnalyses(HumdrumFile& infile) {
+	m_fileAnalyses = infile.getReadAnalyses();
+	m_stageAnalyses = 0;
+	infile.setReadAnalyses(0);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::finishAnalyses -- Restore the read analyses of the file
+//     after the filter stages, and do any read analyses which were
+//     skipped by the stages if "analyze" is true.
+//
+
+void Tool_filter::finishAnalyses(HumdrumFile& infile, bool analyze) {
+	infile.setReadAnalyses(m_fileAnalyses);
+	if (analyze) {
+		infile.requireAnalyses(m_stageAnalyses);
+	}
+	m_stageAnalyses = 0;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::startStage -- Store the lines and tokens of the file
+//     before running a filter stage, along with the text of spine
+//     manipulators and exclusive interpretations, so that finishStage()
+//     can check if the spine structure of the file was changed.  The
+//     edited-token mark of the file is cleared, so that finishStage() can
+//     check if the tool changed any tokens.
+//
+
+void Tool_filter::startStage(HumdrumFile& infile) {
+	m_stageLines.clear();
+	m_stageTokens.clear();
+	m_stageSpines.clear();
+	infile.setEditedTokens(false);
+	for (int i=0; i<infile.getLineCount(); i++) {
+		HLp line = &infile[i];
+		m_stageLines.push_back(line);
+		int count = line->getFieldCount();
+		for (int j=0; j<count; j++) {
+			m_stageTokens.push_back(line->token(j));
+		}
+		if (line->isManipulator() || line->isExclusiveInterpretation()) {
+			m_stageSpines.push_back(getTokenText(line));
+		}
+	}
+}
+
+
+void Tool_filter::startStage(HumdrumFileSet& infiles) {
+	// do nothing: sets of files are always re-read.
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::finishStage -- Update the file after a filter stage.  If
+//     the tool printed Humdrum text, the text is parsed into the file.
+//     Otherwise the tool either edited the file in place (for tools
+//     registered as in-place tools, see HumToolRegistry::Entry::inplace
+//     and HumTool::setInPlaceOutput()), or only printed other text, and
+//     the file is used as it is.  If the lines, tokens and spine
+//     structure of the file are unchanged, only the token analyses are
+//     redone, and only when the tool changed the text of a token (see
+//     HumdrumFileBase::hasEditedTokens()).  If lines were added or removed
+//     or the spine structure was changed, the file is parsed again from
+//     its text, which is also done for all edited files when the -R option
+//     is given.
+//
+
+void Tool_filter::finishStage(HumdrumFile& infile, const string& output) {
+	infile.readString(output);
+	m_stageAnalyses = m_fileAnalyses;
+}
+
+
+void Tool_filter::finishStage(HumdrumFile& infile) {
+	if (isStageInPlace(infile)) {
+		if (!infile.hasEditedTokens()) {
+			return;
+		}
+		if (!m_reparseQ) {
+			infile.reanalyzeTokens();
+			m_stageAnalyses = m_fileAnalyses;
+			return;
+		}
+	}
+	infile.createLinesFromTokens();
+	stringstream text;
+	text << infile;
+	infile.readString(text.str());
+	m_stageAnalyses = m_fileAnalyses;
+}
+
+
+void Tool_filter::finishStage(HumdrumFileSet& infiles, const string& output) {
+	infiles.readString(output);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::isStageInPlace -- Returns true if the file has the same
+//     lines, tokens, spine manipulators and exclusive interpretations as
+//     when startStage() was called, and all tokens can be parsed back
+//     from the text of their lines.
+//
+
+bool Tool_filter::isStageInPlace(HumdrumFile& infile) {
+	if (m_stageLines.empty() || !infile.isValid()) {
+		return false;
+	}
+	if (infile.getLineCount() != (int)m_stageLines.size()) {
+		return false;
+	}
+	int index = 0;
+	int spine = 0;
+	int tokencount = (int)m_stageTokens.size();
+	for (int i=0; i<infile.getLineCount(); i++) {
+		HLp line = &infile[i];
+		if (m_stageLines[i] != line) {
+			return false;
+		}
+		int count = line->getFieldCount();
+		for (int j=0; j<count; j++) {
+			HTp token = line->token(j);
+			if ((index >= tokencount) || (m_stageTokens[index++] != token)) {
+				return false;
+			}
+			if (token->empty() && !line->empty()) {
+				return false;
+			}
+			if (token->find_first_of("\t\n") != string::npos) {
+				return false;
+			}
+		}
+		if (line->isManipulator() || line->isExclusiveInterpretation()) {
+			if ((spine >= (int)m_stageSpines.size()) ||
+					(m_stageSpines[spine++] != getTokenText(line))) {
+				return false;
+			}
+		}
+	}
+	return (index == tokencount) && (spine == (int)m_stageSpines.size());
+}
+
+
+
+//////////////////////////////
+//
+// Tool_filter::getTokenText -- Return the tokens of a line separated by
+//     tabs (the line text may not be updated yet after tokens are edited).
+//
+
+string Tool_filter::getTokenText(HLp line) {
+	string output;
+	int count = line->getFieldCount();
+	for (int i=0; i<count; i++) {
+		if (i > 0) {
+			output += '\t';
+		}
+		output += *line->token(i);
+	}
+	return output;
+}
+
+
+
 //////////////////////////////
 //
 // Tool_filter::removeGlobalFilterLines --
@@ -765,6 +933,7 @@ void Tool_filter::getUniversalCommandList(vector<pair<string, string> >& command
 
 void Tool_filter::initialize(HumdrumFile& infile) {
 	m_debugQ = getBoolean("debug");
+	m_reparseQ = getBoolean("reparse");
 	m_variant.clear();
 	if (getBoolean("variant")) {
 		m_variant = getString("variant");
@@ -14,6 +14,7 @@
 #include "HumRegex.h"
 #include "Convert.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
@@ -34,6 +35,8 @@ Tool_humdiff::Tool_humdiff(void) {
 	define("time-points|times=b", "display timepoint lists for each file");
 	define("note-points|notes=b", "display notepoint lists for each file");
 	define("c|color=s:red",       "color for difference markers");
+	define("b|band=i:0",          "half-width of alignment band in time points (0 = automatic)");
+	define("e|edits=b",           "display edit script of differences for each file");
 }
 
 
@@ -63,15 +66,6 @@ bool Tool_humdiff::run(HumdrumFileSet& infiles) {
 		cerr << "Usage: " << getCommand() << " files" << endl;
 		return false;
 	} else {
-		HumNum targetdur = infiles[0].getScoreDuration();
-		for (int i=1; i<infiles.getSize(); i++) {
-			HumNum dur = infiles[i].getScoreDuration();
-			if (dur != targetdur) {
-				cerr << "Error: all files must have the same duration" << endl;
-				return false;
-			}
-		}
-
 		for (int i=0; i<infiles.getCount(); i++) {
 			if (i == reference) {
 				continue;
@@ -79,7 +73,7 @@ bool Tool_humdiff::run(HumdrumFileSet& infiles) {
 			compareFiles(infiles[reference], infiles[i]);
 		}
 
-		if (!getBoolean("report")) {
+		if (!getBoolean("report") && !getBoolean("edits")) {
 			infiles[reference].createLinesFromTokens();
 			m_humdrum_text << infiles[reference];
 			if (m_marked) {
@@ -133,69 +127,147 @@ void Tool_humdiff::printTimePoints(vector<TimePoint>& timepoints) {
 
 //////////////////////////////
 //
-// Tool_humdiff::compareTimePoints --
+// Tool_humdiff::compareTimePoints -- Align the time points of the two
+//     files by the notes that start at them, then compare the notes of
+//     each pair of aligned time points.  Reference notes at time points
+//     which were deleted in the alternate file have no match.
 //
 
 void Tool_humdiff::compareTimePoints(vector<vector<TimePoint>>& timepoints,
 		HumdrumFile& reference, HumdrumFile& alternate) {
-	vector<int> indexes(timepoints.size(), 0);
-	HumNum minval;
-	HumNum value;
-	int found;
-
 	vector<HumdrumFile*> infiles(2, NULL);
 	infiles[0] = &reference;
 	infiles[1] = &alternate;
 
-	vector<int> increment(timepoints.size(), 0);
+	// notes which start at each time point of each file:
+	vector<vector<vector<NotePoint>>> notes(timepoints.size());
+	for (int i=0; i<(int)timepoints.size(); i++) {
+		notes.at(i).resize(timepoints.at(i).size());
+		for (int j=0; j<(int)timepoints.at(i).size(); j++) {
+			getNoteList(notes.at(i).at(j), *infiles.at(i), timepoints.at(i).at(j).index.at(0),
+					timepoints.at(i).at(j).measure, i, j);
+		}
+	}
+
+	TimePointAlignment alignment;
+	alignment.setBand(getInteger("band"));
+	alignment.setSequences(notes.at(0), notes.at(1));
+	vector<pair<int, int>> path;
+	alignment.align(path);
+
+	bool editsQ = getBoolean("edits");
+	if (editsQ) {
+		m_free_text << "!!!humdiff-reference: " << reference.getFilename() << endl;
+		m_free_text << "!!!humdiff-alternate: " << alternate.getFilename() << endl;
+		m_free_text << "**edit\t**rline\t**aline\t**rnote\t**anote" << endl;
+	}
 
-	while ((1)) {
-		if (indexes.at(0) >= (int)timepoints.at(0).size()) {
-			// at the end of the list of notes for the first file.
-			// break from the comparison for now and figure out how
-			// to report differences of added notes in the other file(s)
-			// later.
-			break;
+	vector<vector<NotePoint>> notelist(2);
+	for (int i=0; i<(int)path.size(); i++) {
+		int ref = path[i].first;
+		int alt = path[i].second;
+		if (ref < 0) {
+			if (editsQ) {
+				printEdit("insert", -1, timepoints.at(1).at(alt).index.at(0), NULL,
+						&notes.at(1).at(alt));
+			}
+			continue;
 		}
-		timepoints.at(0).at(indexes.at(0)).index.resize(timepoints.size());
-		for (int i=1; i<(int)timepoints.size(); i++) {
-			timepoints.at(0).at(indexes.at(0)).index.at(i) = -1;
+		TimePoint& tp = timepoints.at(0).at(ref);
+		tp.index.resize(timepoints.size());
+		tp.index.at(1) = (alt < 0) ? -1 : timepoints.at(1).at(alt).index.at(0);
+
+		notelist.at(0).swap(notes.at(0).at(ref));
+		notelist.at(1).clear();
+		if (alt >= 0) {
+			notelist.at(1).swap(notes.at(1).at(alt));
 		}
-		minval = timepoints.at(0).at(indexes.at(0)).timestamp;
-		for (int i=1; i<(int)timepoints.size(); i++) {
-			if (indexes.at(i) >= (int)timepoints.at(i).size()) {
-				continue;
+		compareLines(notelist, infiles, tp.index.at(1));
+		if (!editsQ) {
+			continue;
+		}
+		if (alt < 0) {
+			printEdit("delete", tp.index.at(0), -1, &notelist.at(0), NULL);
+			continue;
+		}
+		bool changed = false;
+		for (int j=0; j<(int)notelist.at(0).size(); j++) {
+			if (notelist.at(0).at(j).matched.at(1) < 0) {
+				changed = true;
 			}
-			value = timepoints.at(i).at(indexes.at(i)).timestamp;
-			if (value < minval) {
-				minval = value;
+		}
+		for (int j=0; j<(int)notelist.at(1).size(); j++) {
+			if (!notelist.at(1).at(j).processed) {
+				changed = true;
 			}
 		}
-		found = 0;
-		fill(increment.begin(), increment.end(), 0);
+		if (changed) {
+			printEdit("change", tp.index.at(0), tp.index.at(1), &notelist.at(0),
+					&notelist.at(1));
+		}
+	}
+
+	if (editsQ) {
+		m_free_text << "*-\t*-\t*-\t*-\t*-" << endl;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// Tool_humdiff::printEdit -- Print one line of the edit script: the
+//     operation, the line numbers in the reference and alternate files
+//     (or "." if there is no equivalent time point), and the notes
+//     of each file that have no match in the other file.
+//
+
+void Tool_humdiff::printEdit(const string& operation, int refline, int altline,
+		vector<NotePoint>* refnotes, vector<NotePoint>* altnotes) {
+	m_free_text << operation << "\t";
+	if (refline < 0) {
+		m_free_text << ".";
+	} else {
+		m_free_text << refline + 1;
+	}
+	m_free_text << "\t";
+	if (altline < 0) {
+		m_free_text << ".";
+	} else {
+		m_free_text << altline + 1;
+	}
+	m_free_text << "\t" << getUnmatchedNotes(refnotes, true);
+	m_free_text << "\t" << getUnmatchedNotes(altnotes, false);
+	m_free_text << endl;
+}
+
+
 
-		for (int i=0; i<(int)timepoints.size(); i++) {
-			if (indexes.at(i) >= (int)timepoints.at(i).size()) {
-				// index is too large for file, so skip checking it.
+//////////////////////////////
+//
+// Tool_humdiff::getUnmatchedNotes -- Return the notes in a list that were
+//     not matched, separated by spaces (or "." if there are none).
+//
+
+string Tool_humdiff::getUnmatchedNotes(vector<NotePoint>* notes, bool reference) {
+	string output;
+	if (notes) {
+		for (int i=0; i<(int)notes->size(); i++) {
+			NotePoint& np = notes->at(i);
+			bool matched = reference ? ((int)np.matched.size() > 1 && np.matched[1] >= 0) : np.processed;
+			if (matched) {
 				continue;
 			}
-			found = 1;
-			value = timepoints.at(i).at(indexes.at(i)).timestamp;
-
-			if (value == minval) {
-				timepoints.at(0).at(indexes.at(0)).index.at(i) = timepoints.at(i).at(indexes.at(i)).index.at(0);
-				increment.at(i)++;
+			if (!output.empty()) {
+				output += " ";
 			}
+			output += np.subtoken;
 		}
-		if (!found) {
-			break;
-		} else {
-			compareLines(minval, indexes, timepoints, infiles);
-		}
-		for (int i=0; i<(int)increment.size(); i++) {
-			indexes.at(i) += increment.at(i);
-		}
 	}
+	if (output.empty()) {
+		output = ".";
+	}
+	return output;
 }
 
 
@@ -248,34 +320,18 @@ void Tool_humdiff::markNote(NotePoint& np) {
 
 //////////////////////////////
 //
-// Tool_humdiff::compareLines --
+// Tool_humdiff::compareLines -- Match the notes of a reference time point
+//     (notelist[0]) with the notes of the aligned time point in the other
+//     file (notelist[1], empty if the time point was deleted).  Each note
+//     in the other file can be matched once.  altline is the line of the
+//     aligned time point in the other file (or -1).
 //
 
-void Tool_humdiff::compareLines(HumNum minval, vector<int>& indexes,
-		vector<vector<TimePoint>>& timepoints, vector<HumdrumFile*> infiles) {
+void Tool_humdiff::compareLines(vector<vector<NotePoint>>& notelist,
+		vector<HumdrumFile*>& infiles, int altline) {
 
 	bool reportQ = getBoolean("report");
 
-	// cerr << "COMPARING LINES ====================================" << endl;
-	vector<vector<NotePoint>> notelist(indexes.size());
-
-	// Note: timepoints size must be 2
-	// and infiles size must be 2
-	for (int i=0; i<(int)timepoints.size(); i++) {
-		if (indexes.at(i) >= (int)timepoints.at(i).size()) {
-			continue;
-		}
-		if (timepoints.at(i).at(indexes.at(i)).timestamp != minval) {
-			// not at the same time
-			continue;
-		}
-
-		getNoteList(notelist.at(i), *infiles[i],
-			timepoints.at(i).at(indexes.at(i)).index[0],
-			timepoints.at(i).at(indexes.at(i)).measure, i, indexes.at(i));
-
-
-	}
 	for (int i=0; i<(int)notelist.at(0).size(); i++) {
 		notelist.at(0).at(i).matched.resize(notelist.size());
 		fill(notelist.at(0).at(i).matched.begin(), notelist.at(0).at(i).matched.end(), -1);
@@ -283,7 +339,9 @@ void Tool_humdiff::compareLines(HumNum minval, vector<int>& indexes,
 		for (int j=1; j<(int)notelist.size(); j++) {
 			int status = findNoteInList(notelist.at(0).at(i), notelist.at(j));
 			notelist.at(0).at(i).matched.at(j) = status;
-			if ((status < 0) && !reportQ) {
+			if (status >= 0) {
+				notelist.at(j).at(status).processed = 1;
+			} else if (!reportQ) {
 				markNote(notelist.at(0).at(i));
 			}
 		}
@@ -316,13 +374,23 @@ void Tool_humdiff::compareLines(HumNum minval, vector<int>& indexes,
 				if (j < 10) {
 					cout << " ";
 				}
-				cout << ":\t" << "X" << endl;
+				cout << ":\t";
+				if (altline < 0) {
+					cout << "X" << endl;
+				} else {
+					cout << altline + 1 << endl;
+				}
 
 				cout << "\tTARGET  " << j << " LINE TEXT";
 				if (j < 10) {
 					cout << " ";
 				}
-				cout << ":\t" << "X" << endl;
+				cout << ":\t";
+				if (altline < 0) {
+					cout << "X" << endl;
+				} else {
+					cout << (*infiles[j])[altline] << endl;
+				}
 
 				cout << endl;
 			}
@@ -392,7 +460,7 @@ void Tool_humdiff::getNoteList(vector<NotePoint>& notelist, HumdrumFile& infile,
 			notelist.back().subtoken = subtok;
 			notelist.back().subindex = j;
 			notelist.back().measurequarter = token->getDurationFromBarline();
-			notelist.back().measure =
+			notelist.back().measure = measure;
 			notelist.back().track = track;
 			notelist.back().layer = layer;
 			notelist.back().sourceindex = sourceindex;
@@ -488,6 +556,457 @@ ostream& operator<<(ostream& out, NotePoint& np) {
 
 
 
+//////////////////////////////////////////////////////////////////////////
+
+// Cost for cells outside of the alignment band (small enough that sums of
+// several such costs do not overflow):
+static const int TimePointAlignmentInfinity = 1 << 28;
+
+
+//////////////////////////////
+//
+// TimePointAlignment::TimePointAlignment --
+//
+
+TimePointAlignment::TimePointAlignment(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::setBand -- Set the maximum distance (in time points)
+//     of the alignment from the diagonal between the two sequences.  The
+//     default of 0 uses the difference in the sequence lengths plus 64.
+//
+
+void TimePointAlignment::setBand(int band) {
+	m_band = band < 0 ? 0 : band;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::setGapCosts -- Set the cost of starting a gap and
+//     the cost for each time point in the gap.  The cost of substituting
+//     one time point for another is in the range -4 (same notes) to +4
+//     (no common notes).
+//
+
+void TimePointAlignment::setGapCosts(int open, int extend) {
+	m_gapopen = open;
+	m_gapextend = extend;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::setSequences -- Set the notes which start at each
+//     time point of the two files.
+//
+
+void TimePointAlignment::setSequences(vector<vector<NotePoint>>& notes1,
+		vector<vector<NotePoint>>& notes2) {
+	prepareKeys(notes1, m_keys1, m_hashes1);
+	prepareKeys(notes2, m_keys2, m_hashes2);
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::prepareKeys -- Store a sorted list of the pitches
+//     and durations of the notes at each time point.
+//
+
+void TimePointAlignment::prepareKeys(vector<vector<NotePoint>>& notes,
+		vector<vector<long long>>& keys, vector<unsigned long long>& hashes) {
+	keys.resize(notes.size());
+	hashes.resize(notes.size());
+	for (int i=0; i<(int)notes.size(); i++) {
+		keys[i].clear();
+		for (int j=0; j<(int)notes[i].size(); j++) {
+			NotePoint& np = notes[i][j];
+			long long key = ((long long)np.b40 << 42)
+					^ ((long long)(np.duration.getNumerator() & 0x1fffff) << 21)
+					^ (long long)(np.duration.getDenominator() & 0x1fffff);
+			keys[i].push_back(key);
+		}
+		std::sort(keys[i].begin(), keys[i].end());
+		unsigned long long hash = 14695981039346656037ULL;
+		for (int j=0; j<(int)keys[i].size(); j++) {
+			hash = (hash ^ (unsigned long long)keys[i][j]) * 1099511628211ULL;
+		}
+		hashes[i] = hash;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getSubstitutionCost -- Return the cost of aligning
+//     a time point in the first file with a time point in the second
+//     file: -4 if they have the same notes, up to +4 if they have no
+//     notes in common.
+//
+
+int TimePointAlignment::getSubstitutionCost(int index1, int index2) {
+	vector<long long>& keys1 = m_keys1[index1];
+	vector<long long>& keys2 = m_keys2[index2];
+	if ((m_hashes1[index1] == m_hashes2[index2]) && (keys1.size() == keys2.size())) {
+		return -4;
+	}
+	int total = (int)(keys1.size() + keys2.size());
+	if (total == 0) {
+		return -4;
+	}
+	int shared = 0;
+	int i = 0;
+	int j = 0;
+	while ((i < (int)keys1.size()) && (j < (int)keys2.size())) {
+		if (keys1[i] < keys2[j]) {
+			i++;
+		} else if (keys2[j] < keys1[i]) {
+			j++;
+		} else {
+			shared++;
+			i++;
+			j++;
+		}
+	}
+	return 4 - (16 * shared + total / 2) / total;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getGapCost -- Return the cost of a gap of the
+//     given number of time points.
+//
+
+int TimePointAlignment::getGapCost(int length) {
+	if (length <= 0) {
+		return 0;
+	}
+	return m_gapopen + m_gapextend * length;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getBandStart -- Return the first time point of the
+//     second sequence which can be aligned after the given number of time
+//     points in the first sequence.
+//
+
+int TimePointAlignment::getBandStart(int index1) {
+	int size1 = (int)m_keys1.size();
+	int size2 = (int)m_keys2.size();
+	long long center = (long long)index1 * size2 / size1;
+	return (int)std::max(0LL, center - m_width);
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getBandEnd -- Return the last time point of the
+//     second sequence which can be aligned after the given number of time
+//     points in the first sequence.
+//
+
+int TimePointAlignment::getBandEnd(int index1) {
+	int size1 = (int)m_keys1.size();
+	int size2 = (int)m_keys2.size();
+	long long center = (long long)index1 * size2 / size1;
+	return (int)std::min((long long)size2, center + m_width);
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::align -- Align the two sequences.  Each entry in
+//     path is a pair of aligned time points; a time point which is deleted
+//     from the first sequence is paired with -1, and a time point which
+//     is inserted in the second sequence follows -1.  Returns the cost of
+//     the alignment.
+//
+
+int TimePointAlignment::align(vector<pair<int, int>>& path) {
+	int size1 = (int)m_keys1.size();
+	int size2 = (int)m_keys2.size();
+	path.clear();
+	path.reserve(std::max(size1, size2));
+	m_path = &path;
+	if (size1 > 0) {
+		int band = m_band ? m_band : std::abs(size2 - size1) + 64;
+		// The band follows the line between the ends of the two sequences,
+		// so it has to be at least as wide as the slope of the line:
+		m_width = band + (size2 + size1 - 1) / size1 + 1;
+	}
+	m_cc.assign(size2 + 1, 0);
+	m_dd.assign(size2 + 1, 0);
+	m_rr.assign(size2 + 1, 0);
+	m_ss.assign(size2 + 1, 0);
+	int output = alignRange(0, 0, size1, size2, m_gapopen, m_gapopen);
+	m_path = NULL;
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::alignRange -- Align size1 time points of the first
+//     sequence starting at start1 with size2 time points of the second
+//     sequence starting at start2.  gapstart and gapend are the costs of
+//     opening a gap in the second sequence at the start and end of the
+//     range (0 when the gap continues from an adjacent range).  The range
+//     is split at its middle row, at the column where the best path from
+//     the start (forward pass) meets the best path to the end (reverse
+//     pass), so only two rows of the dynamic programming matrix are
+//     stored at once.
+//
+
+int TimePointAlignment::alignRange(int start1, int start2, int size1,
+		int size2, int gapstart, int gapend) {
+	vector<pair<int, int>>& path = *m_path;
+	const int inf = TimePointAlignmentInfinity;
+	int g = m_gapopen;
+	int h = m_gapextend;
+
+	if (size2 <= 0) {
+		for (int i=0; i<size1; i++) {
+			path.emplace_back(start1 + i, -1);
+		}
+		return size1 > 0 ? std::min(gapstart, gapend) + h * size1 : 0;
+	}
+
+	if (size1 <= 1) {
+		if (size1 <= 0) {
+			for (int j=0; j<size2; j++) {
+				path.emplace_back(-1, start2 + j);
+			}
+			return getGapCost(size2);
+		}
+		// delete the single time point, or align it with one of the
+		// time points in the second sequence:
+		int best = std::min(gapstart, gapend) + h + getGapCost(size2);
+		int bestj = 0;
+		for (int j=1; j<=size2; j++) {
+			int cost = getGapCost(j - 1) + getSubstitutionCost(start1, start2 + j - 1)
+					+ getGapCost(size2 - j);
+			if (cost < best) {
+				best = cost;
+				bestj = j;
+			}
+		}
+		if (bestj == 0) {
+			// keep the deletion next to the gap which it continues:
+			if (gapstart <= gapend) {
+				path.emplace_back(start1, -1);
+			}
+			for (int j=0; j<size2; j++) {
+				path.emplace_back(-1, start2 + j);
+			}
+			if (gapstart > gapend) {
+				path.emplace_back(start1, -1);
+			}
+		} else {
+			for (int j=1; j<bestj; j++) {
+				path.emplace_back(-1, start2 + j - 1);
+			}
+			path.emplace_back(start1, start2 + bestj - 1);
+			for (int j=bestj+1; j<=size2; j++) {
+				path.emplace_back(-1, start2 + j - 1);
+			}
+		}
+		return best;
+	}
+
+	int* cc = m_cc.data();
+	int* dd = m_dd.data();
+	int* rr = m_rr.data();
+	int* ss = m_ss.data();
+	int middle = size1 / 2;
+	int c, d, e, s, t;
+
+	// Forward pass: cc[j] is the cost of the best path from the start of
+	// the range to (row, j), and dd[j] the best of those which end with
+	// a gap in the second sequence.
+	int hi = std::min(size2, getBandEnd(start1) - start2);
+	cc[0] = 0;
+	t = g;
+	for (int j=1; j<=size2; j++) {
+		if (j <= hi) {
+			t += h;
+			cc[j] = t;
+			dd[j] = t + g;
+		} else {
+			cc[j] = dd[j] = inf;
+		}
+	}
+	t = gapstart;
+	int lastlo = 0;
+	for (int i=1; i<=middle; i++) {
+		int lo = std::max(0, getBandStart(start1 + i) - start2);
+		hi = std::min(size2, getBandEnd(start1 + i) - start2);
+		int j;
+		if (lo == 0) {
+			s = cc[0];
+			t += h;
+			cc[0] = c = t;
+			e = t + g;
+			j = 1;
+		} else {
+			s = cc[lo - 1];
+			c = e = inf;
+			j = lo;
+		}
+		for (; j<=hi; j++) {
+			e = std::min(e + h, c + g + h);
+			d = std::min(dd[j] + h, cc[j] + g + h);
+			c = s + getSubstitutionCost(start1 + i - 1, start2 + j - 1);
+			c = std::min(c, std::min(d, e));
+			s = cc[j];
+			cc[j] = c;
+			dd[j] = d;
+		}
+		// columns which have left the band:
+		for (j=lastlo; j<lo; j++) {
+			cc[j] = dd[j] = inf;
+		}
+		lastlo = lo;
+	}
+	dd[0] = cc[0];
+
+	// Reverse pass: rr[j] is the cost of the best path from (row, j) to
+	// the end of the range, and ss[j] the best of those which start with
+	// a gap in the second sequence.
+	int lo = std::max(0, getBandStart(start1 + size1) - start2);
+	rr[size2] = 0;
+	t = g;
+	for (int j=size2-1; j>=0; j--) {
+		if (j >= lo) {
+			t += h;
+			rr[j] = t;
+			ss[j] = t + g;
+		} else {
+			rr[j] = ss[j] = inf;
+		}
+	}
+	t = gapend;
+	int lasthi = size2;
+	for (int i=size1-1; i>=middle; i--) {
+		lo = std::max(0, getBandStart(start1 + i) - start2);
+		hi = std::min(size2, getBandEnd(start1 + i) - start2);
+		int j;
+		if (hi == size2) {
+			s = rr[size2];
+			t += h;
+			rr[size2] = c = t;
+			e = t + g;
+			j = size2 - 1;
+		} else {
+			s = rr[hi + 1];
+			c = e = inf;
+			j = hi;
+		}
+		for (; j>=lo; j--) {
+			e = std::min(e + h, c + g + h);
+			d = std::min(ss[j] + h, rr[j] + g + h);
+			c = s + getSubstitutionCost(start1 + i, start2 + j);
+			c = std::min(c, std::min(d, e));
+			s = rr[j];
+			rr[j] = c;
+			ss[j] = d;
+		}
+		for (j=hi+1; j<=lasthi; j++) {
+			rr[j] = ss[j] = inf;
+		}
+		lasthi = hi;
+	}
+	ss[size2] = rr[size2];
+
+	// Find where the best path crosses the middle row, either aligning
+	// a time point there or in the middle of a gap in the second sequence:
+	int best = cc[0] + rr[0];
+	int bestj = 0;
+	bool gapq = false;
+	for (int j=0; j<=size2; j++) {
+		c = cc[j] + rr[j];
+		if ((c < best) || ((c == best) && (cc[j] != dd[j]) && (rr[j] == ss[j]))) {
+			best = c;
+			bestj = j;
+		}
+	}
+	for (int j=size2; j>=0; j--) {
+		c = dd[j] + ss[j] - g;
+		if (c < best) {
+			best = c;
+			bestj = j;
+			gapq = true;
+		}
+	}
+
+	if (!gapq) {
+		alignRange(start1, start2, middle, bestj, gapstart, g);
+		alignRange(start1 + middle, start2 + bestj, size1 - middle, size2 - bestj, g, gapend);
+	} else {
+		alignRange(start1, start2, middle - 1, bestj, gapstart, 0);
+		path.emplace_back(start1 + middle - 1, -1);
+		path.emplace_back(start1 + middle, -1);
+		alignRange(start1 + middle + 1, start2 + bestj, size1 - middle - 1, size2 - bestj, 0, gapend);
+	}
+	return best;
+}
+
+
+
+//////////////////////////////
+//
+// TimePointAlignment::getPathCost -- Return the cost of an alignment
+//     path.
+//
+
+int TimePointAlignment::getPathCost(vector<pair<int, int>>& path) {
+	int output = 0;
+	int deleted = 0;
+	int inserted = 0;
+	for (int i=0; i<=(int)path.size(); i++) {
+		bool deleteq = (i < (int)path.size()) && (path[i].second < 0);
+		bool insertq = (i < (int)path.size()) && (path[i].first < 0);
+		if (!deleteq && deleted) {
+			output += getGapCost(deleted);
+			deleted = 0;
+		}
+		if (!insertq && inserted) {
+			output += getGapCost(inserted);
+			inserted = 0;
+		}
+		if (i == (int)path.size()) {
+			break;
+		}
+		if (deleteq) {
+			deleted++;
+		} else if (insertq) {
+			inserted++;
+		} else {
+			output += getSubstitutionCost(path[i].first, path[i].second);
+		}
+	}
+	return output;
+}
+
+
+
 // END_MERGE
 
 } // end namespace hum
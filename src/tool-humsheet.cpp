@@ -34,6 +34,8 @@ Tool_humsheet::Tool_humsheet(void) {
 	define("X|no-exinterp=b",       "do not embed exclusive interp data");
 	define("J|no-javascript=b",     "do not embed javascript code");
 	define("S|no-style=b",          "do not embed CSS style element");
+
+	setRequiredAnalyses(HumFileAnalysis::getMask(HumFileAnalysis::Strands));
 }
 
 
@@ -159,8 +159,7 @@ bool Tool_humtr::run(HumdrumFile& infile) {
 		}
 		return true;
 	} else {
-		infile.createLinesFromTokens();
-		m_humdrum_text << infile;
+		printEditedFile(infile);
 	}
 	return true;
 }
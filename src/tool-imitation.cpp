@@ -294,9 +294,9 @@ void Tool_imitation::getIntervals(vector<double>& intervals,
 	intervals.back() = NAN;
 
 	if (getBoolean("debug")) {
-		cout << endl;
+		m_free_text << endl;
 		for (int i=0; i<(int)intervals.size(); i++) {
-			cout << "INTERVAL " << i << "\t=\t" << intervals.at(i) << "\tATK "
+			m_free_text << "INTERVAL " << i << "\t=\t" << intervals.at(i) << "\tATK "
 			     << attacks.at(i)->getSgnDiatonicPitch() << "\t" << attacks.at(i)->getToken() << endl;
 		}
 	}
@@ -611,15 +611,15 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 					}
 
                if (attacks.at(v1).at(i+z)->isRest() && (z < count - 1) ) {
-						markedTiedNotes(attacks.at(v1).at(i+z)->m_tiedtokens);
+						markedTiedNotes(attacks.at(v1).at(i+z)->getTiedTokens());
 					} else if (!attacks.at(v1).at(i+z)->isRest()) {
-						markedTiedNotes(attacks.at(v1).at(i+z)->m_tiedtokens);
+						markedTiedNotes(attacks.at(v1).at(i+z)->getTiedTokens());
 					}
 
                if (attacks.at(v2).at(j+z)->isRest() && (z < count - 1) ) {
-						markedTiedNotes(attacks.at(v2).at(j+z)->m_tiedtokens);
+						markedTiedNotes(attacks.at(v2).at(j+z)->getTiedTokens());
 					} else if (!attacks.at(v2).at(j+z)->isRest()) {
-						markedTiedNotes(attacks.at(v2).at(j+z)->m_tiedtokens);
+						markedTiedNotes(attacks.at(v2).at(j+z)->getTiedTokens());
 					}
 
 				}
@@ -638,7 +638,7 @@ void Tool_imitation::analyzeImitation(vector<vector<string>>& results,
 // Tool_imitation::markedTiedNotes --
 //
 
-void Tool_imitation::markedTiedNotes(vector<HTp>& tokens) {
+void Tool_imitation::markedTiedNotes(const vector<HTp>& tokens) {
 	for (int i=0; i<(int)tokens.size(); i++) {
 		if (m_single) {
 			if (tokens.at(i)->find(m_marker) == string::npos) {
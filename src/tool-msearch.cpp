@@ -13,106 +13,1052 @@
 #include "tool-msearch.h"
 #include "Convert.h"
 #include "HumRegex.h"
+#include "HumSnapshot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef HUMLIB_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
 
 using namespace std;
 
-namespace hum {
+namespace hum {
+
+// START_MERGE
+
+
+//////////////////////////////
+//
+// SonorityDatabase::buildDatabase --
+//
+
+void SonorityDatabase::buildDatabase(HLp line) {
+	clear();
+	if (line == NULL) {
+		return;
+	}
+	m_line = line;
+	bool nullQ = false;
+	if (!line->isData()) {
+		return;
+	}
+	int lowesti = 0;
+	int lowest12 = 1000;
+
+	for (int i=0; i<line->getFieldCount(); i++) {
+		HTp token = m_line->token(i);
+		if (!token->isKern()) {
+			continue;
+		}
+		if (token->isRest()) {
+			// ignoring rests, at least for now
+			continue;
+		}
+		if (token->isNull()) {
+			nullQ = true;
+			token = token->resolveNull();
+		}
+		if (token->isNull()) {
+			continue;
+		}
+		int scount = token->getSubtokenCount();
+		for (int j=0; j<scount; j++) {
+			expandList();
+			m_notes.back().setToken(token, nullQ, j);
+			if (m_notes.back().getBase12() < lowest12) {
+				lowesti = (int)m_notes.size() - 1;
+				lowest12 = m_notes.back().getBase12();
+			}
+		}
+	}
+	if (!m_notes.empty()) {
+		m_lowest = m_notes[lowesti];
+	}
+}
+
+
+
+//////////////////////////////
+//
+// SonorityDatabase::addNote --
+//
+
+void SonorityDatabase::addNote(const std::string& text) {
+	expandList();
+	m_notes.back().setString(text);
+	// not dealing with lowest note
+}
+
+
+
+//////////////////////////////
+//
+// MSearchQueryToken::parseHarmonicQuery --
+//
+
+void MSearchQueryToken::parseHarmonicQuery(void) {
+	if (!hpieces.empty()) {
+		// do not reparse
+		return;
+	}
+	for (int i=0; i<(int)harmonic.size(); i++) {
+		char ch = tolower(harmonic[i]);
+		if (ch >= 'a' && ch <= 'g') {
+			hpieces.resize(hpieces.size() + 1);
+			hpieces.back() += harmonic[i];
+		} else if (ch == '-') {
+			hpieces.back() += ch;
+		} else if (ch == 'n') {
+			hpieces.back() += ch;
+		} else if (ch == '#') {
+			hpieces.back() += ch;
+		}
+	}
+
+	hquery.resize(hpieces.size());
+	for (int i=0; i<(int)hpieces.size(); i++) {
+		hquery[i].setString(hpieces[i]);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex file layout (integers in the header and tables are
+// stored in little-endian order, so that index files do not depend on
+// byte order):
+//    "HUMMSIX" magic string (8 bytes, including the final null)
+//    version, n-gram length, file count (4 bytes each)
+//    n-gram count (8 bytes)
+//    file keys, in order of file number (8 bytes each)
+//    n-gram table, sorted by key: n-gram key (8 bytes), offset of
+//       its entry list (8 bytes), number of entries (4 bytes)
+//    entry lists: the sorted entries of each n-gram, each stored as
+//       the difference from the previous entry, seven bits per byte.
+//
+// Each entry is (file << 32) | (voice << 20) | position, where position
+// is the index of the first attack of the n-gram in the voice.
+//
+
+// Increase MSearchIndexVersion when the layout or the features change.
+static const int MSearchIndexVersion = 1;
+static const int MSearchIndexHeaderSize = 28;
+static const int MSearchIndexTableSize = 20;
+
+// Kinds of features which are indexed:
+static const int MSearchIndexRhythm    = 0;
+static const int MSearchIndexDiatonic  = 1;
+static const int MSearchIndexChromatic = 2;
+static const int MSearchIndexBase40    = 3;
+static const int MSearchIndexBase12    = 4;
+static const int MSearchIndexBase7     = 5;
+static const int MSearchIndexKinds     = 6;
+
+
+//////////////////////////////
+//
+// MSearchIndex::MSearchIndex -- Constructor.  The n-gram length is
+//     replaced by the length stored in an index that is read.
+//
+
+MSearchIndex::MSearchIndex(int gramlength) {
+	m_gramlength = gramlength < 1 ? 1 : gramlength;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::~MSearchIndex -- Deconstructor.
+//
+
+MSearchIndex::~MSearchIndex() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::clear -- Remove the contents of the index.
+//
+
+void MSearchIndex::clear(void) {
+	m_files.clear();
+	m_grams.clear();
+	unmap();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::unmap -- Release the contents of an index that was read.
+//
+
+void MSearchIndex::unmap(void) {
+#ifdef HUMLIB_MMAP
+	if (m_map) {
+		munmap(m_map, m_size);
+	}
+#endif
+	m_map = NULL;
+	m_buffer.clear();
+	m_data = NULL;
+	m_size = 0;
+	m_gramcount = 0;
+	m_table = NULL;
+	m_entries = NULL;
+	m_lastoffset = 0;
+	m_lastshift = -1;
+	m_candidates.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getGramLength -- Return the number of attacks in each n-gram.
+//
+
+int MSearchIndex::getGramLength(void) {
+	return m_gramlength;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getFileCount -- Return the number of (distinct) files
+//     in the index.
+//
+
+int MSearchIndex::getFileCount(void) {
+	return (int)m_files.size();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getGramCount -- Return the number of distinct n-grams
+//     in the index.
+//
+
+size_t MSearchIndex::getGramCount(void) {
+	return m_data ? (size_t)m_gramcount : m_grams.size();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getFileKey -- Return the key which identifies a file
+//     in the index: a hash of its tokens (which may differ from the
+//     text of the lines if a tool has changed them).
+//
+
+std::uint64_t MSearchIndex::getFileKey(HumdrumFile& infile) {
+	string text;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		HumdrumLine& line = infile[i];
+		if (line.getFieldCount() == 0) {
+			text += line;
+		}
+		for (int j=0; j<line.getFieldCount(); j++) {
+			if (j > 0) {
+				text += '\t';
+			}
+			text += *line.token(j);
+		}
+		text += '\n';
+	}
+	return HumSnapshot::getContentKey(text.data(), text.size());
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::addFile -- Add the n-grams of each voice of a file to
+//     the index.  A file with the same tokens as one already in the
+//     index shares its entries.  Returns false if the file cannot be
+//     indexed (it has no **kern spines, or too many voices or notes),
+//     in which case msearch will check all of its notes.
+//
+
+bool MSearchIndex::addFile(HumdrumFile& infile) {
+	if (m_data) {
+		// cannot add to an index which has been read
+		return false;
+	}
+	std::uint64_t key = getFileKey(infile);
+	if (m_files.find(key) != m_files.end()) {
+		return true;
+	}
+	if ((m_files.size() >= 0xffffffffULL) || infile.getKernSpineStartList().empty()) {
+		return false;
+	}
+
+	NoteGrid grid(infile);
+	if (grid.getVoiceCount() >= (1 << 12)) {
+		return false;
+	}
+	vector<vector<vector<Feature>>> features(grid.getVoiceCount());
+	vector<NoteCell*> attacks;
+	for (int i=0; i<grid.getVoiceCount(); i++) {
+		grid.getNoteAndRestAttacks(attacks, i);
+		if ((int)attacks.size() >= (1 << 20)) {
+			return false;
+		}
+		if (!getNoteFeatures(attacks, features[i])) {
+			return false;
+		}
+	}
+
+	std::uint64_t file = m_files.size();
+	m_files[key] = (std::uint32_t)file;
+	for (int i=0; i<(int)features.size(); i++) {
+		for (int kind=0; kind<MSearchIndexKinds; kind++) {
+			vector<Feature>& list = features[i][kind];
+			for (int j=0; j+m_gramlength<=(int)list.size(); j++) {
+				std::uint64_t entry = (file << 32) | ((std::uint64_t)i << 20) | (std::uint64_t)j;
+				m_grams[getGramKey(kind, &list[j])].push_back(entry);
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getFeatureKinds -- Return the number of kinds of features
+//     (pitch class in three bases, two kinds of interval and duration).
+//
+
+int MSearchIndex::getFeatureKinds(void) {
+	return MSearchIndexKinds;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getNoteFeatures -- Calculate the features of each attack
+//     in a voice which are compared to the query in
+//     Tool_msearch::checkForMusicMatch(), in the same way, so that a note
+//     has the same feature as a query token if and only if it matches the
+//     token.  Returns false if a duration cannot be indexed, or the
+//     diatonic pitch class of a note does not match its base-40 pitch
+//     class.
+//
+
+bool MSearchIndex::getNoteFeatures(vector<NoteCell*>& notes,
+		vector<vector<Feature>>& features) {
+	features.resize(MSearchIndexKinds);
+	for (int i=0; i<(int)features.size(); i++) {
+		features[i].resize(notes.size());
+	}
+	for (int i=0; i<(int)notes.size(); i++) {
+		NoteCell* note = notes[i];
+		NoteCell* next = (i + 1 < (int)notes.size()) ? notes[i+1] : NULL;
+
+		HumNum duration = note->getDuration();
+		if (duration.getDenominator() <= 0) {
+			return false;
+		}
+		features[MSearchIndexRhythm][i] = Feature(duration.getNumerator(),
+				duration.getDenominator());
+
+		double currpitch = note->getAbsDiatonicPitch();
+		double nextpitch = next ? next->getAbsDiatonicPitch() : -123456789.0;
+		features[MSearchIndexDiatonic][i] = Feature(0, (int)(nextpitch - currpitch));
+		currpitch = note->getAbsBase40Pitch();
+		nextpitch = next ? next->getAbsBase40Pitch() : -123456789.0;
+		features[MSearchIndexChromatic][i] = Feature(0, (int)(nextpitch - currpitch));
+
+		if (note->isRest()) {
+			features[MSearchIndexBase40][i] = Feature(1, 0);
+			features[MSearchIndexBase12][i] = Feature(1, 0);
+			features[MSearchIndexBase7][i]  = Feature(1, 0);
+		} else {
+			features[MSearchIndexBase40][i] = Feature(0, (int)note->getAbsBase40PitchClass());
+			features[MSearchIndexBase12][i] = Feature(0, ((int)note->getAbsMidiPitch()) % 12);
+			features[MSearchIndexBase7][i]  = Feature(0, ((int)note->getAbsDiatonicPitch()) % 7);
+			int pc = (int)features[MSearchIndexBase40][i].second;
+			if ((pc >= 0) && (pc < 40) && (Convert::base40ToDiatonic(pc) % 7 !=
+					features[MSearchIndexBase7][i].second)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getQueryFeature -- Calculate the feature which a note
+//     must have to match a query token.  Returns false if the token
+//     does not require a specific value of the feature.
+//
+
+bool MSearchIndex::getQueryFeature(MSearchQueryToken& token, int kind,
+		Feature& feature) {
+	if (token.anything) {
+		return false;
+	}
+	int base = 40;
+	switch (kind) {
+		case MSearchIndexRhythm:
+			if (token.anyrhythm || (token.duration.getDenominator() <= 0)) {
+				return false;
+			}
+			feature = Feature(token.duration.getNumerator(), token.duration.getDenominator());
+			return true;
+
+		case MSearchIndexDiatonic:
+			if (token.dinterval <= -1000) {
+				return false;
+			}
+			feature = Feature(0, token.dinterval);
+			return true;
+
+		case MSearchIndexChromatic:
+			if ((token.dinterval > -1000) || (token.cinterval <= -1000)) {
+				return false;
+			}
+			feature = Feature(0, token.cinterval);
+			return true;
+
+		case MSearchIndexBase12:
+			base = 12;
+			break;
+
+		case MSearchIndexBase7:
+			base = 7;
+			break;
+	}
+
+	if (token.anypitch) {
+		return false;
+	}
+	int tokenbase = ((token.base == 12) || (token.base == 7)) ? token.base : 40;
+	if ((tokenbase != base) && ((tokenbase != 40) || (base != 7))) {
+		return false;
+	}
+	if (Convert::isNaN(token.pc)) {
+		feature = Feature(1, 0);
+		return true;
+	}
+	if ((token.pc != floor(token.pc)) || (fabs(token.pc) > 1000000.0)) {
+		return false;
+	}
+	int pc = (int)token.pc;
+	if (tokenbase == base) {
+		feature = Feature(0, pc);
+		return true;
+	}
+	// A base-40 pitch class also gives the diatonic pitch class, so that
+	// queries which mix the two (such as "e-dc") can use base-7 n-grams
+	// (addFile() checks that this is true for each note of the file).
+	if ((pc < 0) || (pc >= 40)) {
+		return false;
+	}
+	feature = Feature(0, Convert::base40ToDiatonic(pc) % 7);
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getGramKey -- Return a 64-bit FNV-1a hash of the kind
+//     and features of an n-gram.
+//
+
+std::uint64_t MSearchIndex::getGramKey(int kind, const Feature* features) {
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	hash ^= (std::uint64_t)kind;
+	hash *= 0x100000001b3ULL;
+	for (int i=0; i<m_gramlength; i++) {
+		std::uint64_t values[2] = {(std::uint64_t)features[i].first,
+				(std::uint64_t)features[i].second};
+		for (int j=0; j<2; j++) {
+			for (int k=0; k<8; k++) {
+				hash ^= (values[j] >> (8 * k)) & 0xff;
+				hash *= 0x100000001b3ULL;
+			}
+		}
+	}
+	return hash;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::write -- Save the index to a file.
+//
+
+bool MSearchIndex::write(const string& filename) {
+	if (m_data) {
+		return false;
+	}
+	vector<std::uint64_t> keys;
+	keys.reserve(m_grams.size());
+	for (auto& it : m_grams) {
+		keys.push_back(it.first);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	string table;
+	string entries;
+	table.reserve(keys.size() * MSearchIndexTableSize);
+	for (int i=0; i<(int)keys.size(); i++) {
+		vector<std::uint64_t>& list = m_grams[keys[i]];
+		// Entries for one file are out of order only for colliding keys:
+		std::sort(list.begin(), list.end());
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+		appendInt(table, keys[i], 8);
+		appendInt(table, entries.size(), 8);
+		appendInt(table, list.size(), 4);
+		std::uint64_t last = 0;
+		for (int j=0; j<(int)list.size(); j++) {
+			std::uint64_t value = list[j] - last;
+			last = list[j];
+			while (value >= 0x80) {
+				entries += (char)((value & 0x7f) | 0x80);
+				value >>= 7;
+			}
+			entries += (char)value;
+		}
+	}
+
+	string header("HUMMSIX", 8);
+	appendInt(header, MSearchIndexVersion, 4);
+	appendInt(header, m_gramlength, 4);
+	appendInt(header, m_files.size(), 4);
+	appendInt(header, keys.size(), 8);
+	vector<std::uint64_t> files(m_files.size());
+	for (auto& it : m_files) {
+		files[it.second] = it.first;
+	}
+	for (int i=0; i<(int)files.size(); i++) {
+		appendInt(header, files[i], 8);
+	}
+
+	std::ofstream output(filename, std::ios::binary);
+	if (!output.is_open()) {
+		return false;
+	}
+	output.write(header.data(), header.size());
+	output.write(table.data(), table.size());
+	output.write(entries.data(), entries.size());
+	output.close();
+	return (bool)output;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::read -- Load an index file, which is memory-mapped if
+//     possible.  Returns false if the file is not a valid index.
+//
+
+bool MSearchIndex::read(const string& filename) {
+	clear();
+#ifdef HUMLIB_MMAP
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode) ||
+			(info.st_size < MSearchIndexHeaderSize)) {
+		::close(fd);
+		return false;
+	}
+	m_size = (size_t)info.st_size;
+	void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		m_size = 0;
+		return false;
+	}
+	m_map = data;
+	m_data = (const char*)data;
+#else
+	std::ifstream input(filename, std::ios::binary);
+	if (!input.is_open()) {
+		return false;
+	}
+	stringstream contents;
+	contents << input.rdbuf();
+	m_buffer = contents.str();
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+#endif
+
+	if ((m_size < MSearchIndexHeaderSize) || (memcmp(m_data, "HUMMSIX", 8) != 0) ||
+			(readInt(m_data + 8, 4) != (std::uint64_t)MSearchIndexVersion)) {
+		clear();
+		return false;
+	}
+	int gramlength = (int)readInt(m_data + 12, 4);
+	std::uint64_t filecount = readInt(m_data + 16, 4);
+	m_gramcount = readInt(m_data + 20, 8);
+	std::uint64_t available = m_size - MSearchIndexHeaderSize;
+	if ((gramlength < 1) || (filecount > available / 8) ||
+			(m_gramcount > (available - filecount * 8) / MSearchIndexTableSize)) {
+		clear();
+		return false;
+	}
+	m_gramlength = gramlength;
+	const char* ptr = m_data + MSearchIndexHeaderSize;
+	for (std::uint64_t i=0; i<filecount; i++) {
+		m_files[readInt(ptr, 8)] = (std::uint32_t)i;
+		ptr += 8;
+	}
+	m_table = ptr;
+	m_entries = m_table + m_gramcount * MSearchIndexTableSize;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::getCandidates -- Get the voices and attack positions in
+//     a file where the query may match, sorted by voice and position.
+//     The n-gram of the query with the fewest entries in the index is
+//     used.  Returns false if the index cannot be used, because the file
+//     is not in the index, or the query has a harmonic search or no
+//     indexed n-gram.
+//
+
+bool MSearchIndex::getCandidates(HumdrumFile& infile,
+		vector<MSearchQueryToken>& query, vector<pair<int, int>>& candidates) {
+	candidates.clear();
+	if (!m_data || ((int)query.size() < m_gramlength)) {
+		return false;
+	}
+	for (int i=0; i<(int)query.size(); i++) {
+		if (!query[i].harmonic.empty()) {
+			return false;
+		}
+	}
+
+	bool found = false;
+	std::uint64_t bestoffset = 0;
+	std::uint32_t bestcount = 0;
+	int bestshift = 0;
+	vector<Feature> features(query.size());
+	for (int kind=0; kind<MSearchIndexKinds; kind++) {
+		int run = 0;
+		for (int i=0; i<(int)query.size(); i++) {
+			run = getQueryFeature(query[i], kind, features[i]) ? run + 1 : 0;
+			if (run < m_gramlength) {
+				continue;
+			}
+			int shift = i - m_gramlength + 1;
+			std::uint64_t offset = 0;
+			std::uint32_t count = 0;
+			findGram(getGramKey(kind, &features[shift]), offset, count);
+			if (!found || (count < bestcount)) {
+				found = true;
+				bestoffset = offset;
+				bestcount = count;
+				bestshift = shift;
+			}
+		}
+	}
+	if (!found) {
+		return false;
+	}
+
+	auto file = m_files.find(getFileKey(infile));
+	if (file == m_files.end()) {
+		return false;
+	}
+	if (bestcount == 0) {
+		return true;
+	}
+	if ((bestoffset != m_lastoffset) || (bestshift != m_lastshift)) {
+		loadCandidates(bestoffset, bestcount, bestshift);
+	}
+	auto entry = m_candidates.find(file->second);
+	if (entry != m_candidates.end()) {
+		candidates = entry->second;
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::findGram -- Find the entry list of an n-gram.  Returns
+//     false if the n-gram is not in the index.
+//
+
+bool MSearchIndex::findGram(std::uint64_t key, std::uint64_t& offset,
+		std::uint32_t& count) {
+	std::uint64_t low = 0;
+	std::uint64_t high = m_gramcount;
+	while (low < high) {
+		std::uint64_t middle = low + (high - low) / 2;
+		const char* ptr = m_table + middle * MSearchIndexTableSize;
+		std::uint64_t value = readInt(ptr, 8);
+		if (value < key) {
+			low = middle + 1;
+		} else if (value > key) {
+			high = middle;
+		} else {
+			offset = readInt(ptr + 8, 8);
+			count = (std::uint32_t)readInt(ptr + 16, 4);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::loadCandidates -- Decode an entry list into the candidate
+//     positions for each file, where the n-gram is at the given shift
+//     from the start of the query.
+//
+
+void MSearchIndex::loadCandidates(std::uint64_t offset, std::uint32_t count,
+		int shift) {
+	m_candidates.clear();
+	m_lastoffset = offset;
+	m_lastshift = shift;
+	const char* end = m_data + m_size;
+	if (offset >= (std::uint64_t)(end - m_entries)) {
+		return;
+	}
+	const char* ptr = m_entries + offset;
+	std::uint64_t value = 0;
+	for (std::uint32_t i=0; i<count; i++) {
+		std::uint64_t delta = 0;
+		int bits = 0;
+		while ((ptr < end) && (*ptr & 0x80) && (bits < 64)) {
+			delta |= (std::uint64_t)(*ptr & 0x7f) << bits;
+			bits += 7;
+			ptr++;
+		}
+		if ((ptr >= end) || (bits >= 64)) {
+			// truncated index
+			return;
+		}
+		delta |= (std::uint64_t)(*ptr & 0x7f) << bits;
+		ptr++;
+		value += delta;
+		int position = (int)(value & 0xfffff);
+		if (position < shift) {
+			continue;
+		}
+		int voice = (int)((value >> 20) & 0xfff);
+		m_candidates[(std::uint32_t)(value >> 32)].emplace_back(voice, position - shift);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::appendInt -- Append an integer in little-endian order.
+//
+
+void MSearchIndex::appendInt(string& output, std::uint64_t value, int bytes) {
+	for (int i=0; i<bytes; i++) {
+		output += (char)((value >> (8 * i)) & 0xff);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MSearchIndex::readInt -- Read an integer in little-endian order.
+//
+
+std::uint64_t MSearchIndex::readInt(const char* data, int bytes) {
+	const unsigned char* ptr = (const unsigned char*)data;
+	std::uint64_t value = 0;
+	for (int i=0; i<bytes; i++) {
+		value |= (std::uint64_t)ptr[i] << (8 * i);
+	}
+	return value;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::MSearchAutomaton -- Constructor.
+//
+
+MSearchAutomaton::MSearchAutomaton(void) {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::clear -- Remove all queries.
+//
+
+void MSearchAutomaton::clear(void) {
+	m_tries.clear();
+	m_tries.resize(MSearchIndex::getFeatureKinds());
+	m_kind.clear();
+	m_length.clear();
+	m_shift.clear();
+	m_built = false;
+}
 
-// START_MERGE
 
 
 //////////////////////////////
 //
-// SonorityDatabase::buildDatabase --
+// MSearchAutomaton::getQueryCount -- Return the number of queries added.
 //
 
-void SonorityDatabase::buildDatabase(HLp line) {
-	clear();
-	if (line == NULL) {
-		return;
+int MSearchAutomaton::getQueryCount(void) {
+	return (int)m_kind.size();
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::hasPattern -- Returns true if the candidates given
+//     by search() for the query include all of its matches.  If false,
+//     the query must be checked at all positions.
+//
+
+bool MSearchAutomaton::hasPattern(int query) {
+	if ((query < 0) || (query >= (int)m_kind.size())) {
+		return false;
 	}
-	m_line = line;
-	bool nullQ = false;
-	if (!line->isData()) {
-		return;
+	return m_kind[query] >= 0;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::addQuery -- Add the pattern of a query to the automaton
+//     for its kind of feature.  Returns the number of the query, which is
+//     the index of its candidates given by search().  When runs of
+//     features have the same length, pitch classes and intervals are
+//     preferred to durations, since they give fewer candidates.
+//
+
+int MSearchAutomaton::addQuery(vector<MSearchQueryToken>& query) {
+	int index = (int)m_kind.size();
+	m_kind.push_back(-1);
+	m_length.push_back(0);
+	m_shift.push_back(0);
+	m_built = false;
+	for (int i=0; i<(int)query.size(); i++) {
+		if (!query[i].harmonic.empty()) {
+			return index;
+		}
 	}
-	int lowesti = 0;
-	int lowest12 = 1000;
 
-	for (int i=0; i<line->getFieldCount(); i++) {
-		HTp token = m_line->token(i);
-		if (!token->isKern()) {
-			continue;
+	static const int kinds[] = { MSearchIndexBase40, MSearchIndexChromatic,
+			MSearchIndexBase12, MSearchIndexDiatonic, MSearchIndexBase7,
+			MSearchIndexRhythm };
+	vector<MSearchIndex::Feature> features(query.size());
+	vector<MSearchIndex::Feature> pattern;
+	for (int k=0; k<MSearchIndexKinds; k++) {
+		int run = 0;
+		for (int i=0; i<=(int)query.size(); i++) {
+			if ((i < (int)query.size()) &&
+					MSearchIndex::getQueryFeature(query[i], kinds[k], features[i])) {
+				run++;
+				continue;
+			}
+			if (run > m_length[index]) {
+				m_kind[index] = kinds[k];
+				m_length[index] = run;
+				m_shift[index] = i - run;
+				pattern.assign(features.begin() + (i - run), features.begin() + i);
+			}
+			run = 0;
 		}
-		if (token->isRest()) {
-			// ignoring rests, at least for now
-			continue;
+	}
+	if (m_kind[index] < 0) {
+		return index;
+	}
+
+	Trie& trie = m_tries[m_kind[index]];
+	if (trie.next.empty()) {
+		trie.next.resize(1);
+		trie.output.resize(1);
+	}
+	int state = 0;
+	for (int i=0; i<(int)pattern.size(); i++) {
+		auto symbol = trie.symbols.find(pattern[i]);
+		if (symbol == trie.symbols.end()) {
+			int value = (int)trie.symbols.size();
+			symbol = trie.symbols.insert(make_pair(pattern[i], value)).first;
 		}
-		if (token->isNull()) {
-			nullQ = true;
-			token = token->resolveNull();
+		auto child = trie.next[state].find(symbol->second);
+		if (child != trie.next[state].end()) {
+			state = child->second;
+			continue;
 		}
-		if (token->isNull()) {
+		int newstate = (int)trie.next.size();
+		trie.next[state][symbol->second] = newstate;
+		trie.next.resize(newstate + 1);
+		trie.output.resize(newstate + 1);
+		state = newstate;
+	}
+	trie.output[state].push_back(index);
+	return index;
+}
+
+
+
+//////////////////////////////
+//
+// MSearchAutomaton::build -- Calculate the failure links of each trie,
+//     adding the queries of the failure state to the output of each state.
+//
+
+void MSearchAutomaton::build(void) {
+	for (int k=0; k<(int)m_tries.size(); k++) {
+		Trie& trie = m_tries[k];
+		trie.fail.assign(trie.next.size(), 0);
+		if (trie.next.empty()) {
 			continue;
 		}
-		int scount = token->getSubtokenCount();
-		for (int j=0; j<scount; j++) {
-			expandList();
-			m_notes.back().setToken(token, nullQ, j);
-			if (m_notes.back().getBase12() < lowest12) {
-				lowesti = (int)m_notes.size() - 1;
-				lowest12 = m_notes.back().getBase12();
+		vector<int> queue;
+		for (auto& it : trie.next[0]) {
+			queue.push_back(it.second);
+		}
+		for (int i=0; i<(int)queue.size(); i++) {
+			int state = queue[i];
+			for (auto& it : trie.next[state]) {
+				int child = it.second;
+				int fail = trie.fail[state];
+				while ((fail > 0) && (trie.next[fail].find(it.first) == trie.next[fail].end())) {
+					fail = trie.fail[fail];
+				}
+				auto target = trie.next[fail].find(it.first);
+				if (target != trie.next[fail].end()) {
+					trie.fail[child] = target->second;
+				}
+				vector<int>& output = trie.output[trie.fail[child]];
+				trie.output[child].insert(trie.output[child].end(), output.begin(), output.end());
+				queue.push_back(child);
 			}
 		}
 	}
-	if (!m_notes.empty()) {
-		m_lowest = m_notes[lowesti];
-	}
+	m_built = true;
 }
 
 
 
 //////////////////////////////
 //
-// SonorityDatabase::addNote --
+// MSearchAutomaton::advance -- Return the state of the automaton after
+//     the feature of the next note.
 //
 
-void SonorityDatabase::addNote(const std::string& text) {
-	expandList();
-	m_notes.back().setString(text);
-	// not dealing with lowest note
+int MSearchAutomaton::advance(Trie& trie, int state,
+		const MSearchIndex::Feature& feature) {
+	auto symbol = trie.symbols.find(feature);
+	if (symbol == trie.symbols.end()) {
+		return 0;
+	}
+	while (true) {
+		auto child = trie.next[state].find(symbol->second);
+		if (child != trie.next[state].end()) {
+			return child->second;
+		}
+		if (state == 0) {
+			return 0;
+		}
+		state = trie.fail[state];
+	}
 }
 
 
 
 //////////////////////////////
 //
-// MSearchQueryToken::parseHarmonicQuery --
+// MSearchAutomaton::search -- Find the voices and positions where each
+//     query may match in the note/rest attacks of each voice, in one pass
+//     over the notes of each voice.  The candidates of each query are
+//     sorted by voice and position.  Returns false if the features of the
+//     notes cannot be compared to the patterns, in which case all queries
+//     must be checked at all positions.
 //
 
-void MSearchQueryToken::parseHarmonicQuery(void) {
-	if (!hpieces.empty()) {
-		// do not reparse
-		return;
+bool MSearchAutomaton::search(vector<vector<NoteCell*>>& attacks,
+		vector<vector<pair<int, int>>>& candidates) {
+	if (!m_built) {
+		build();
 	}
-	for (int i=0; i<(int)harmonic.size(); i++) {
-		char ch = tolower(harmonic[i]);
-		if (ch >= 'a' && ch <= 'g') {
-			hpieces.resize(hpieces.size() + 1);
-			hpieces.back() += harmonic[i];
-		} else if (ch == '-') {
-			hpieces.back() += ch;
-		} else if (ch == 'n') {
-			hpieces.back() += ch;
-		} else if (ch == '#') {
-			hpieces.back() += ch;
+	candidates.resize(m_kind.size());
+	for (int i=0; i<(int)candidates.size(); i++) {
+		candidates[i].clear();
+	}
+	vector<int> kinds;
+	for (int k=0; k<(int)m_tries.size(); k++) {
+		if (!m_tries[k].next.empty()) {
+			kinds.push_back(k);
 		}
 	}
+	if (kinds.empty()) {
+		return true;
+	}
 
-	hquery.resize(hpieces.size());
-	for (int i=0; i<(int)hpieces.size(); i++) {
-		hquery[i].setString(hpieces[i]);
+	vector<vector<MSearchIndex::Feature>> features;
+	vector<int> states(kinds.size());
+	for (int v=0; v<(int)attacks.size(); v++) {
+		if (!MSearchIndex::getNoteFeatures(attacks[v], features)) {
+			return false;
+		}
+		fill(states.begin(), states.end(), 0);
+		for (int j=0; j<(int)attacks[v].size(); j++) {
+			for (int k=0; k<(int)kinds.size(); k++) {
+				Trie& trie = m_tries[kinds[k]];
+				states[k] = advance(trie, states[k], features[kinds[k]][j]);
+				vector<int>& output = trie.output[states[k]];
+				for (int i=0; i<(int)output.size(); i++) {
+					int query = output[i];
+					int start = j - m_length[query] + 1 - m_shift[query];
+					if (start >= 0) {
+						candidates[query].emplace_back(v, start);
+					}
+				}
+			}
+		}
 	}
+	return true;
 }
 
 
@@ -135,6 +1081,8 @@ Tool_msearch::Tool_msearch(void) {
 	define("m|mark|marker=s:@",           "marking character");
 	define("M|no-mark|no-marker=b",       "do not mark matches");
 	define("Q|quiet=b",                   "quiet mode: do not summarize matches");
+	define("index=s",                     "n-gram index of the files (see msearch-index)");
+	define("queries=s",                   "file with the options of a query on each line");
 }
 
 
@@ -177,22 +1125,21 @@ bool Tool_msearch::run(HumdrumFile& infile, ostream& out) {
 
 
 bool Tool_msearch::run(HumdrumFile& infile) {
-	m_sonorities.resize(infile.getLineCount());
-	m_sonoritiesChecked.resize(infile.getLineCount());
-	fill(m_sonoritiesChecked.begin(), m_sonoritiesChecked.end(), false);
-	m_debugQ = getBoolean("debug");
-	m_quietQ = getBoolean("quiet");
-	m_nooverlapQ = getBoolean("no-overlap");
-	NoteGrid grid(infile);
+	if (getBoolean("queries")) {
+		return doQueryListSearch(infile);
+	}
+	initialize(infile);
+
+	// With an index, the grid is only needed if the index gives
+	// candidates for a match in the file (see doMusicSearch()).
+	NoteGrid grid;
+	if (m_debugQ || !m_text.empty() || !getBoolean("index")) {
+		grid.load(infile);
+	}
 	if (m_debugQ) {
 		grid.printGridInfo(cerr);
 		// return 1;
 	}
-	initialize();
-
-	if (getBoolean("text")) {
-		m_text = getString("text");
-	}
 
 	if (m_text.empty()) {
 		vector<MSearchQueryToken> query;
@@ -216,10 +1163,20 @@ bool Tool_msearch::run(HumdrumFile& infile) {
 
 //////////////////////////////
 //
-// Tool_msearch::initialize --
+// Tool_msearch::initialize -- Prepare to search a file.
 //
 
-void Tool_msearch::initialize(void) {
+void Tool_msearch::initialize(HumdrumFile& infile) {
+	m_sonorities.resize(infile.getLineCount());
+	m_sonoritiesChecked.resize(infile.getLineCount());
+	fill(m_sonoritiesChecked.begin(), m_sonoritiesChecked.end(), false);
+	m_debugQ = getBoolean("debug");
+	m_quietQ = getBoolean("quiet");
+	m_nooverlapQ = getBoolean("no-overlap");
+	if (getBoolean("text")) {
+		m_text = getString("text");
+	}
+
 	m_marker = getString("marker");
 	// only allowing a single character for now:
 	m_markQ = !getBoolean("no-marker");
@@ -311,6 +1268,20 @@ void Tool_msearch::fillWordsForTrack(vector<TextInfo*>& words,
 
 void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		vector<MSearchTextQuery>& query) {
+	int tcount = markTextMatches(infile, query);
+	addTextSearchResults(infile, tcount);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::markTextMatches -- Mark the words which match the query,
+//     and return the number of matches.
+//
+
+int Tool_msearch::markTextMatches(HumdrumFile& infile,
+		vector<MSearchTextQuery>& query) {
 
 	vector<TextInfo*> words;
 	words.reserve(10000);
@@ -327,6 +1298,22 @@ void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		}
 	}
 
+	for (int i=0; i<(int)words.size(); i++) {
+		delete words[i];
+		words[i] = NULL;
+	}
+	return tcount;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::addTextSearchResults -- Add the marker definition and
+//     the summary of the matches to the end of the file.
+//
+
+void Tool_msearch::addTextSearchResults(HumdrumFile& infile, int tcount) {
 	string textinterp = "**text";
 	vector<HTp> interps;
 	infile.getSpineStartList(interps);
@@ -358,11 +1345,6 @@ void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 		infile.createLinesFromTokens();
 	}
 
-	for (int i=0; i<(int)words.size(); i++) {
-		delete words[i];
-		words[i] = NULL;
-	}
-
 	if (!m_quietQ) {
 		addTextSearchSummary(infile, tcount, m_marker);
 	}
@@ -377,7 +1359,7 @@ void Tool_msearch::doTextSearch(HumdrumFile& infile, NoteGrid& grid,
 
 void Tool_msearch::printQuery(vector<MSearchQueryToken>& query) {
 	for (int i=0; i<(int)query.size(); i++) {
-		cout << query[i];
+		m_free_text << query[i];
 	}
 }
 
@@ -391,22 +1373,65 @@ void Tool_msearch::printQuery(vector<MSearchQueryToken>& query) {
 void Tool_msearch::doMusicSearch(HumdrumFile& infile, NoteGrid& grid,
 		vector<MSearchQueryToken>& query) {
 
-	m_matches.clear();
-
 	if (m_debugQ) {
 		printQuery(query);
 	}
 
+	// Only check the voices and positions given by the index, if there
+	// is one which can be used for the file and query:
+	vector<pair<int, int>> candidates;
+	bool indexQ = getIndexCandidates(infile, query, candidates);
+	if (getBoolean("index") && !m_debugQ && (!indexQ || !candidates.empty())) {
+		// grid was not loaded in run()
+		grid.load(infile);
+	}
+
 	vector<vector<NoteCell*>> attacks;
 	attacks.resize(grid.getVoiceCount());
 	for (int i=0; i<grid.getVoiceCount(); i++) {
 		grid.getNoteAndRestAttacks(attacks[i], i);
 	}
 
+	int mcount = markMusicMatches(infile, attacks, query, indexQ ? &candidates : NULL);
+	addMusicSearchResults(infile, mcount);
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::markMusicMatches -- Mark and store the matches of the query
+//     in the note/rest attacks of each voice, and return the number of
+//     matches.  If candidates is not NULL, only check the given
+//     voice/position pairs (sorted by voice and then position).
+//
+
+int Tool_msearch::markMusicMatches(HumdrumFile& infile,
+		vector<vector<NoteCell*>>& attacks, vector<MSearchQueryToken>& query,
+		vector<pair<int, int>>* candidates) {
+
+	m_matches.clear();
+
 	vector<NoteCell*> match;
 	int mcount = 0;
+	int k = 0;
 	for (int i=0; i<(int)attacks.size(); i++) {
-		for (int j=0; j<(int)attacks[i].size(); j++) {
+		int count = (int)attacks[i].size();
+		if (candidates) {
+			vector<pair<int, int>>& list = *candidates;
+			while ((k < (int)list.size()) && (list[k].first < i)) {
+				k++;
+			}
+			count = 0;
+			while ((k + count < (int)list.size()) && (list[k + count].first == i)) {
+				count++;
+			}
+		}
+		for (int n=0; n<count; n++) {
+			int j = candidates ? (*candidates)[k + n].second : n;
+			if (j >= (int)attacks[i].size()) {
+				break;
+			}
 			m_tomark.clear();
 			bool status = checkForMusicMatch(attacks[i], j, query, match);
 			if (!status) {
@@ -421,7 +1446,18 @@ void Tool_msearch::doMusicSearch(HumdrumFile& infile, NoteGrid& grid,
 			}
 		}
 	}
+	return mcount;
+}
+
+
 
+//////////////////////////////
+//
+// Tool_msearch::addMusicSearchResults -- Add the marker definition and
+//     the summary of the matches to the end of the file.
+//
+
+void Tool_msearch::addMusicSearchResults(HumdrumFile& infile, int mcount) {
 	if (mcount && m_markQ) {
 		string content = "!!!RDF**kern: " + m_marker + " = marked note";
 		if (getBoolean("color")) {
@@ -437,6 +1473,144 @@ void Tool_msearch::doMusicSearch(HumdrumFile& infile, NoteGrid& grid,
 
 
 
+//////////////////////////////
+//
+// Tool_msearch::doQueryListSearch -- Search a file for each query in the
+//     list given with the --queries option.  The notes of each voice are
+//     scanned once for the patterns of all queries (see MSearchAutomaton),
+//     and then the matches of each query are marked and summarized in the
+//     order of the list, so that the output is the same as running
+//     msearch with each query in turn.
+//
+
+bool Tool_msearch::doQueryListSearch(HumdrumFile& infile) {
+	string filename = getString("queries");
+	if (filename != m_queryfile) {
+		loadQueryList(filename);
+	}
+	if (hasError()) {
+		return false;
+	}
+
+	NoteGrid grid(infile);
+	vector<vector<NoteCell*>> attacks;
+	attacks.resize(grid.getVoiceCount());
+	for (int i=0; i<grid.getVoiceCount(); i++) {
+		grid.getNoteAndRestAttacks(attacks[i], i);
+	}
+	vector<vector<pair<int, int>>> candidates;
+	bool automatonQ = m_automaton.search(attacks, candidates);
+
+	// Mark the matches of all queries before adding their results to the
+	// end of the file, since durations of notes at the end of the music
+	// would change after lines are added.
+	vector<int> counts(m_querytools.size(), 0);
+	for (int i=0; i<(int)m_querytools.size(); i++) {
+		Tool_msearch& tool = *m_querytools[i];
+		tool.initialize(infile);
+		if (!tool.m_text.empty()) {
+			vector<MSearchTextQuery> query;
+			tool.fillTextQuery(query, tool.m_text);
+			counts[i] = tool.markTextMatches(infile, query);
+		} else if (!m_queries[i].empty()) {
+			bool patternQ = automatonQ && m_automaton.hasPattern(i);
+			counts[i] = tool.markMusicMatches(infile, attacks, m_queries[i],
+					patternQ ? &candidates[i] : NULL);
+		}
+	}
+	for (int i=0; i<(int)m_querytools.size(); i++) {
+		Tool_msearch& tool = *m_querytools[i];
+		if (!tool.m_text.empty()) {
+			tool.addTextSearchResults(infile, counts[i]);
+		} else if (!m_queries[i].empty()) {
+			tool.addMusicSearchResults(infile, counts[i]);
+		}
+	}
+
+	infile.createLinesFromTokens();
+	m_humdrum_text << infile;
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::loadQueryList -- Read a file of queries, one per line,
+//     each given as msearch options (such as "-p cdefg" or "-i 2-2 -r 448").
+//     Empty lines and lines starting with "#" are ignored.
+//
+
+bool Tool_msearch::loadQueryList(const string& filename) {
+	m_queryfile = filename;
+	m_querytools.clear();
+	m_queries.clear();
+	m_automaton.clear();
+
+	ifstream input(filename);
+	if (!input.is_open()) {
+		m_error_text << "Error: cannot read query file " << filename << endl;
+		return false;
+	}
+	string line;
+	while (getline(input, line)) {
+		size_t start = line.find_first_not_of(" \t\r");
+		if ((start == string::npos) || (line[start] == '#')) {
+			continue;
+		}
+		auto tool = std::make_shared<Tool_msearch>();
+		if (!tool->process("msearch " + line, 0, 1) || tool->getBoolean("queries")) {
+			m_error_text << "Error: invalid query \"" << line << "\" in " << filename << endl;
+			m_querytools.clear();
+			m_queries.clear();
+			m_automaton.clear();
+			return false;
+		}
+		m_queries.resize(m_queries.size() + 1);
+		if (!tool->getBoolean("text")) {
+			tool->fillMusicQuery(m_queries.back());
+		}
+		m_automaton.addQuery(m_queries.back());
+		m_querytools.push_back(tool);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// Tool_msearch::getIndexCandidates -- Get the voices and positions
+//     in the file where the query may match from the index given with
+//     the --index option (which is read for the first file searched).
+//     Returns false if the index cannot be used for the file or query,
+//     in which case all positions must be checked.
+//
+
+bool Tool_msearch::getIndexCandidates(HumdrumFile& infile,
+		vector<MSearchQueryToken>& query, vector<pair<int, int>>& candidates) {
+	candidates.clear();
+	if (!getBoolean("index")) {
+		return false;
+	}
+	string filename = getString("index");
+	if (filename != m_indexfile) {
+		m_indexfile = filename;
+		m_index = std::make_shared<MSearchIndex>();
+		if (!m_index->read(filename)) {
+			m_warning_text << "Warning: cannot read index file " << filename
+			               << ", so searching all notes" << endl;
+			m_index.reset();
+		}
+	}
+	if (!m_index) {
+		return false;
+	}
+	return m_index->getCandidates(infile, query, candidates);
+}
+
+
+
 //////////////////////////////
 //
 // Tool_msearch::addMusicSearchSummary --
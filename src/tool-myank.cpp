@@ -52,6 +52,9 @@ Tool_myank::Tool_myank(void) {
 	define("h|help=b",                           "short description");
 	define("hide-starting=b",                    "prevent printStarting");
 	define("hide-ending=b",                      "prevent printEnding");
+
+	setRequiredAnalyses(HumFileAnalysis::getMask(HumFileAnalysis::Rhythm) |
+			HumFileAnalysis::getMask(HumFileAnalysis::Nulls));
 }
 
 
@@ -107,7 +110,7 @@ bool Tool_myank::run(HumdrumFile& infile) {
 	processFile(infile);
 	// Re-load the text for each line from their tokens.
 	infile.createLinesFromTokens();
-	return true;
+	return !hasError();
 }
 
 
@@ -288,6 +291,9 @@ void Tool_myank::processFile(HumdrumFile& infile) {
 	// expand to multiple measures later.
 	expandMeasureOutList(m_measureOutList, m_measureInList, infile,
 			measurestring);
+	if (hasError()) {
+		return;
+	}
 
 	if (m_inlistQ) {
 		m_free_text << "INPUT MEASURE MAP: " << endl;
@@ -1136,8 +1142,8 @@ void Tool_myank::adjustGlobalInterpretations(HumdrumFile& infile, int ii,
 void Tool_myank::adjustGlobalInterpretationsStart(HumdrumFile& infile, int ii,
 		vector<MeasureInfo>& outmeasures, int index) {
 	if (index != 0) {
-		cerr << "Error in adjustGlobalInterpetationsStart" << endl;
-		exit(1);
+		m_error_text << "Error in adjustGlobalInterpetationsStart" << endl;
+		return;
 	}
 
 	int i;
@@ -2153,20 +2159,22 @@ void Tool_myank::expandMeasureOutList(vector<MeasureInfo>& measureout,
 		}
 	}
 	if (maxmeasure <= 0 && !getBoolean("lines")) {
-		cerr << "Error: There are no measure numbers present in the data" << endl;
-		exit(1);
+		m_error_text << "Error: There are no measure numbers present in the data" << endl;
+		return;
 	}
 	if (maxmeasure > 1123123) {
-		cerr << "Error: ridiculusly large measure number: " << maxmeasure << endl;
-		exit(1);
+		m_error_text << "Error: ridiculusly large measure number: " << maxmeasure << endl;
+		return;
 	}
+	// The output list is left empty for --max and --min, so that only
+	// the measure number is printed:
 	if (m_maxQ) {
 		if (measurein.size() == 0) {
 			m_humdrum_text << 0 << endl;
 		} else {
 			m_humdrum_text << maxmeasure << endl;
 		}
-		exit(0);
+		return;
 	} else if (m_minQ) {
 		for (int ii=0; ii<infile.getLineCount(); ii++) {
 			if (infile[ii].isBarline()) {
@@ -2174,12 +2182,12 @@ void Tool_myank::expandMeasureOutList(vector<MeasureInfo>& measureout,
 					break;
 				} else {
 					m_humdrum_text << 0 << endl;
-					exit(0);
+					return;
 				}
 			}
 			if (infile[ii].isData()) {
 				m_humdrum_text << 0 << endl;
-				exit(0);
+				return;
 			}
 		}
 		if (measurein.size() == 0) {
@@ -2187,7 +2195,7 @@ void Tool_myank::expandMeasureOutList(vector<MeasureInfo>& measureout,
 		} else {
 			m_humdrum_text << minmeasure << endl;
 		}
-		exit(0);
+		return;
 	}
 
 	// create reverse-lookup list
@@ -2217,6 +2225,9 @@ void Tool_myank::expandMeasureOutList(vector<MeasureInfo>& measureout,
 		start += value - 1;
 		start += (int)hre.getMatch(1).size();
 		processFieldEntry(range, hre.getMatch(1), infile, maxmeasure, measurein, inmap);
+		if (hasError()) {
+			return;
+		}
 		value = hre.search(ostring, start, searchexp);
 	}
 }
@@ -2609,16 +2620,16 @@ void Tool_myank::processFieldEntry(vector<MeasureInfo>& field,
 		if (lastone  < 0         ) { lastone  = 0         ; }
 
 		if ((firstone < 1) && (firstone != 0)) {
-			cerr << "Error: range token: \"" << str << "\""
+			m_error_text << "Error: range token: \"" << str << "\""
 				  << " contains too small a number at start: " << firstone << endl;
-			cerr << "Minimum number allowed is " << 1 << endl;
-			exit(1);
+			m_error_text << "Minimum number allowed is " << 1 << endl;
+			return;
 		}
 		if ((lastone < 1) && (lastone != 0)) {
-			cerr << "Error: range token: \"" << str << "\""
+			m_error_text << "Error: range token: \"" << str << "\""
 				  << " contains too small a number at end: " << lastone << endl;
-			cerr << "Minimum number allowed is " << 1 << endl;
-			exit(1);
+			m_error_text << "Minimum number allowed is " << 1 << endl;
+			return;
 		}
 
 		if (firstone > lastone) {
@@ -2682,12 +2693,13 @@ void Tool_myank::processFieldEntry(vector<MeasureInfo>& field,
 		// do something with letter later...
 
 		if ((value < 1) && (value != 0)) {
-			cerr << "Error: range token: \"" << str << "\""
+			m_error_text << "Error: range token: \"" << str << "\""
 				  << " contains too small a number at end: " << value << endl;
-			cerr << "Minimum number allowed is " << 1 << endl;
-			exit(1);
+			m_error_text << "Minimum number allowed is " << 1 << endl;
+			return;
 		}
-		if (inmap[value] >= 0) {
+		// Measures after the last one in the file are ignored:
+		if ((value <= maxmeasure) && (inmap[value] >= 0)) {
 			current.clear();
 			current.file = &infile;
 			current.num = value;
@@ -2712,7 +2724,9 @@ void Tool_myank::processFieldEntry(vector<MeasureInfo>& field,
 		}
 	}
 
-	field.back().stopStyle = measureStyling;
+	if (!field.empty()) {
+		field.back().stopStyle = measureStyling;
+	}
 
 }
 
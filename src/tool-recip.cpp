@@ -43,6 +43,8 @@ Tool_recip::Tool_recip(void) {
 	define("e|exinterp=s:**recip",   "use the given exinterp for data output");
 	define("n|kern-pitch=s:e",       "note to add for '-e kern' option");
 	define("kern=b",                 "equivalent to '-e kern' option");
+
+	setRequiredAnalyses(HumFileAnalysis::getMask(HumFileAnalysis::Rhythm));
 }
 
 
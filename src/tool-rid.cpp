@@ -46,6 +46,8 @@ Tool_rid::Tool_rid(void) {
    define("M|all-barlines=b",              "remove measure lines");
    define("C|all-comments=b",              "remove all comment lines");
    define("c=b",                           "remove global and local comment lines");
+
+	setRequiredAnalyses(0);
 }
 
 
@@ -90,7 +90,7 @@ void Tool_rmask::initialize(HumdrumFile& infile) {
 		string klist = getString("kern");
 		infile.makeBooleanTrackList(m_spines, klist);
 		for (int z = 0; z < (int)infile.getMaxTrack(); z++) {
-			cout << "\t" << m_spines.at(z) << endl;
+			m_free_text << "\t" << m_spines.at(z) << endl;
 		}
 	} else {
 		m_spines.resize(infile.getMaxTrack());
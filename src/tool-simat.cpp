@@ -13,10 +13,14 @@
 #include "tool-simat.h"
 #include "Convert.h"
 #include "HumRegex.h"
+#include "HumThreadPool.h"
 
 #include "pugixml.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
 #include <sstream>
 
 using namespace std;
@@ -536,6 +540,318 @@ double MeasureComparison::getCorrelation7pc(void) {
 	return correlation7pc;
 }
 
+//////////////////////////////////////////////////////////////////////////
+
+// Number of values stored for each histogram (seven pitch classes padded
+// to 64 bytes), and the size of the blocks of the correlation matrix
+// which are calculated together:
+static const int MeasureCorrelationStride      = 8;
+static const int MeasureCorrelationTileRows    = 64;
+static const int MeasureCorrelationTileColumns = 2048;
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::MeasureCorrelationMatrix --
+//
+
+MeasureCorrelationMatrix::MeasureCorrelationMatrix(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::~MeasureCorrelationMatrix --
+//
+
+MeasureCorrelationMatrix::~MeasureCorrelationMatrix() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::clear --
+//
+
+void MeasureCorrelationMatrix::clear(void) {
+	m_rowvalues.clear();
+	m_rowscales.clear();
+	m_rowsums.clear();
+	m_rowstorage.clear();
+	m_rows = NULL;
+	clearColumns();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::clearColumns -- Remove the column measures
+//     (keeping the row measures).
+//
+
+void MeasureCorrelationMatrix::clearColumns(void) {
+	m_columnvalues.clear();
+	m_columnscales.clear();
+	m_columnsums.clear();
+	m_columnstorage.clear();
+	m_columns = NULL;
+	m_matrix.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::setRows -- Set the measures for the rows
+//     of the matrix.
+//
+
+void MeasureCorrelationMatrix::setRows(MeasureDataSet& set) {
+	m_rowvalues.clear();
+	m_rowscales.clear();
+	m_rowsums.clear();
+	addHistograms(set, m_rowvalues, m_rowscales, m_rowsums);
+	m_matrix.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::addColumns -- Append the measures of a set
+//     to the columns of the matrix, so that one set of row measures can
+//     be compared to several files at once.  Returns the index of the
+//     first column for the set.
+//
+
+int MeasureCorrelationMatrix::addColumns(MeasureDataSet& set) {
+	int output = getColumnCount();
+	addHistograms(set, m_columnvalues, m_columnscales, m_columnsums);
+	m_matrix.clear();
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::addHistograms -- Store the pitch-class
+//     histograms of the measures in a set, with the mean of each
+//     histogram subtracted, so that the Pearson correlation of two
+//     measures is the dot product of their values times their scales.
+//
+
+void MeasureCorrelationMatrix::addHistograms(MeasureDataSet& set,
+		vector<double>& values, vector<double>& scales, vector<double>& sums) {
+	for (int i=0; i<set.size(); i++) {
+		vector<double>& hist = set[i].getHistogram7pc();
+		int size = std::min((int)hist.size(), 7);
+		double mean = 0.0;
+		for (int k=0; k<size; k++) {
+			mean += hist[k];
+		}
+		mean = size ? mean / size : 0.0;
+		double length = 0.0;
+		for (int k=0; k<MeasureCorrelationStride; k++) {
+			double value = (k < size) ? hist[k] - mean : 0.0;
+			values.push_back(value);
+			length += value * value;
+		}
+		scales.push_back(1.0 / sqrt(length));
+		sums.push_back(set[i].getSum7pc());
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::alignValues -- Resize the storage so that
+//     it holds count values starting at a 64-byte boundary, and return
+//     a pointer to the first value.
+//
+
+double* MeasureCorrelationMatrix::alignValues(vector<double>& storage, int count) {
+	storage.assign(count + MeasureCorrelationStride, 0.0);
+	uintptr_t address = (uintptr_t)storage.data();
+	int offset = (int)(((64 - address % 64) % 64) / sizeof(double));
+	return storage.data() + offset;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::analyze -- Calculate the correlation of each
+//     row measure with each column measure.  The matrix is divided into
+//     tiles which are calculated by the given number of threads (0 = all
+//     cores).
+//
+
+void MeasureCorrelationMatrix::analyze(int threads) {
+	int rows = getRowCount();
+	int columns = getColumnCount();
+
+	m_rows = alignValues(m_rowstorage, rows * MeasureCorrelationStride);
+	std::copy(m_rowvalues.begin(), m_rowvalues.end(), m_rows);
+	m_columns = alignValues(m_columnstorage, columns * MeasureCorrelationStride);
+	for (int j=0; j<columns; j++) {
+		for (int k=0; k<MeasureCorrelationStride; k++) {
+			m_columns[k * columns + j] = m_columnvalues[j * MeasureCorrelationStride + k];
+		}
+	}
+	m_matrix.assign((size_t)rows * columns, 0.0);
+
+	if (threads <= 0) {
+		threads = HumThreadPool::getHardwareThreadCount();
+	}
+	std::unique_ptr<HumThreadPool> pool;
+	if ((threads > 1) && ((size_t)rows * columns > 4096)) {
+		pool.reset(new HumThreadPool(threads));
+	}
+	for (int i=0; i<rows; i+=MeasureCorrelationTileRows) {
+		int i2 = std::min(i + MeasureCorrelationTileRows, rows);
+		for (int j=0; j<columns; j+=MeasureCorrelationTileColumns) {
+			int j2 = std::min(j + MeasureCorrelationTileColumns, columns);
+			if (pool) {
+				pool->submit([this, i, i2, j, j2]() { analyzeTile(i, i2, j, j2); });
+			} else {
+				analyzeTile(i, i2, j, j2);
+			}
+		}
+	}
+	if (pool) {
+		pool->wait();
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::analyzeTile -- Calculate the correlations
+//     for a block of the matrix.  The loop over the columns has no
+//     dependencies between iterations, so the compiler can calculate
+//     several columns at once with SIMD instructions.  The results
+//     are the same as MeasureComparison::compare() within rounding.
+//
+
+void MeasureCorrelationMatrix::analyzeTile(int row1, int row2, int column1,
+		int column2) {
+	int columns = getColumnCount();
+	const double* c0 = m_columns;
+	const double* c1 = c0 + columns;
+	const double* c2 = c1 + columns;
+	const double* c3 = c2 + columns;
+	const double* c4 = c3 + columns;
+	const double* c5 = c4 + columns;
+	const double* c6 = c5 + columns;
+	const double* cscale = m_columnscales.data();
+	for (int i=row1; i<row2; i++) {
+		const double* a = m_rows + i * MeasureCorrelationStride;
+		double rscale = m_rowscales[i];
+		double* out = m_matrix.data() + (size_t)i * columns;
+		for (int j=column1; j<column2; j++) {
+			double dot = a[0] * c0[j] + a[1] * c1[j] + a[2] * c2[j] + a[3] * c3[j]
+					+ a[4] * c4[j] + a[5] * c5[j] + a[6] * c6[j];
+			double correl = dot * rscale * cscale[j];
+			out[j] = (fabs(correl - 1.0) < 0.00000001) ? 1.0 : correl;
+		}
+		// Measures without notes are only similar to each other:
+		if (m_rowsums[i] == 0.0) {
+			for (int j=column1; j<column2; j++) {
+				out[j] = (m_columnsums[j] == 0.0) ? 1.0 : 0.0;
+			}
+			continue;
+		}
+		for (int j=column1; j<column2; j++) {
+			if (m_columnsums[j] == 0.0) {
+				out[j] = 0.0;
+			}
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::getCorrelation --
+//
+
+double MeasureCorrelationMatrix::getCorrelation(int row, int column) {
+	return m_matrix.at((size_t)row * getColumnCount() + column);
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::printCorrelation -- Print a correlation
+//     rounded to two decimal places.
+//
+
+ostream& MeasureCorrelationMatrix::printCorrelation(ostream& out, double correl) {
+	if (correl > 0.0) {
+		out << int(correl * 100.0 + 0.5)/100.0;
+	} else {
+		out << -int(-correl * 100.0 + 0.5)/100.0;
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::printGrid -- Print the correlations of
+//     the rows with the given range of columns.
+//
+
+ostream& MeasureCorrelationMatrix::printGrid(ostream& out, int column1,
+		int column2) {
+	for (int i=0; i<getRowCount(); i++) {
+		for (int j=column1; j<column2; j++) {
+			printCorrelation(out, getCorrelation(i, j));
+			if (j < column2 - 1) {
+				out << '\t';
+			}
+		}
+		out << endl;
+	}
+	return out;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureCorrelationMatrix::printDiagonal -- Print the correlations of
+//     each row with the column at the same position in the given range
+//     of columns (one line for each row).
+//
+
+ostream& MeasureCorrelationMatrix::printDiagonal(ostream& out, int column1,
+		int column2) {
+	for (int i=0; i<getRowCount(); i++) {
+		if (i < column2 - column1) {
+			printCorrelation(out, getCorrelation(i, column1 + i));
+			if (i < column2 - column1 - 1) {
+				out << '\t';
+			}
+		}
+		out << endl;
+	}
+	return out;
+}
+
+
+
 //////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////
@@ -576,7 +892,32 @@ MeasureComparisonGrid::~MeasureComparisonGrid() {
 //
 
 void MeasureComparisonGrid::clear(void) {
-	m_grid.clear();
+	m_matrix.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MeasureComparisonGrid::setThreadCount -- Set the number of threads
+//     used to calculate the grid (0 = all cores).
+//
+
+void MeasureComparisonGrid::setThreadCount(int threads) {
+	m_threads = threads;
+}
+
+
+
+//////////////////////////////
+//
+// MeasureComparisonGrid::getCorrelation7pc -- Return the correlation of
+//     the pitch-class histograms of a measure in the first set and a
+//     measure in the second set.
+//
+
+double MeasureComparisonGrid::getCorrelation7pc(int index1, int index2) {
+	return m_matrix.getCorrelation(index1, index2);
 }
 
 
@@ -591,15 +932,10 @@ void MeasureComparisonGrid::analyze(MeasureDataSet* set1, MeasureDataSet* set2)
 }
 
 void MeasureComparisonGrid::analyze(MeasureDataSet& set1, MeasureDataSet& set2) {
-	m_grid.resize(set1.size());
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		m_grid[i].resize(set2.size());
-	}
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		for (int j=0; j<(int)m_grid[i].size(); j++) {
-			m_grid[i][j].compare(set1[i], set2[j]);
-		}
-	}
+	m_matrix.clear();
+	m_matrix.setRows(set1);
+	m_matrix.addColumns(set2);
+	m_matrix.analyze(m_threads);
 	m_set1 = &set1;
 	m_set2 = &set2;
 }
@@ -613,21 +949,7 @@ void MeasureComparisonGrid::analyze(MeasureDataSet& set1, MeasureDataSet& set2)
 //
 
 ostream& MeasureComparisonGrid::printCorrelationGrid(ostream& out) {
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		for (int j=0; j<(int)m_grid[i].size(); j++) {
-			double correl = m_grid[i][j].getCorrelation7pc();
-			if (correl > 0.0) {
-				out << int(correl * 100.0 + 0.5)/100.0;
-			} else {
-				out << -int(-correl * 100.0 + 0.5)/100.0;
-			}
-			if (j < (int)m_grid[i].size() - 1) {
-				out << '\t';
-			}
-		}
-		out << endl;
-	}
-	return out;
+	return m_matrix.printGrid(out, 0, m_matrix.getColumnCount());
 }
 
 
@@ -639,24 +961,7 @@ ostream& MeasureComparisonGrid::printCorrelationGrid(ostream& out) {
 //
 
 ostream& MeasureComparisonGrid::printCorrelationDiagonal(ostream& out) {
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		for (int j=0; j<(int)m_grid[i].size(); j++) {
-			if (i != j) {
-				continue;
-			}
-			double correl = m_grid[i][j].getCorrelation7pc();
-			if (correl > 0.0) {
-				out << int(correl * 100.0 + 0.5)/100.0;
-			} else {
-				out << -int(-correl * 100.0 + 0.5)/100.0;
-			}
-			if (j < (int)m_grid[i].size() - 1) {
-				out << '\t';
-			}
-		}
-		out << endl;
-	}
-	return out;
+	return m_matrix.printDiagonal(out, 0, m_matrix.getColumnCount());
 }
 
 
@@ -948,15 +1253,15 @@ ostream& MeasureComparisonGrid::printSvgGrid(ostream& out) {
 	double sdur1 = getScoreDuration1();
 	double sdur2 = getScoreDuration2();
 
-	for (int i=0; i<(int)m_grid.size(); i++) {
-		for (int j=0; j<(int)m_grid[i].size(); j++) {
+	for (int i=0; i<m_matrix.getRowCount(); i++) {
+		for (int j=0; j<m_matrix.getColumnCount(); j++) {
 			width = getDuration2(j) / sdur2 * imagewidth;
 			height = getDuration1(i) / sdur1 * imageheight;
 
 			x = getStartTime2(j)/sdur2 * imageheight;
 			y = getStartTime1(i)/sdur1 * imagewidth;
 
-			getColorMapping(m_grid[i][j].getCorrelation7pc(), hue, saturation, lightness);
+			getColorMapping(getCorrelation7pc(i, j), hue, saturation, lightness);
 			ss << "hsl(" << hue << "," << saturation << "%," << lightness << "%)";
 			crect = grid.append_child("rect");
 			crect.append_attribute("x") = to_string(x).c_str();
@@ -989,6 +1294,8 @@ ostream& MeasureComparisonGrid::printSvgGrid(ostream& out) {
 Tool_simat::Tool_simat(void) {
 	define("r|raw=b",      "output raw correlation matrix");
 	define("d|diagonal=b", "output diagonal of correlation matrix");
+	define("m|many=b",     "compare the first file to each of the other files");
+	define("j|jobs=i:1",   "number of threads for the correlation matrix (0 = all cores)");
 }
 
 
@@ -999,6 +1306,9 @@ Tool_simat::Tool_simat(void) {
 //
 
 bool Tool_simat::run(HumdrumFileSet& infiles) {
+	if (getBoolean("many")) {
+		return processManyFiles(infiles);
+	}
 	bool status = true;
 	if (infiles.getCount() == 1) {
 		status = run(infiles[0], infiles[0]);
@@ -1069,8 +1379,11 @@ bool Tool_simat::run(HumdrumFile& infile1, HumdrumFile& infile2) {
 //
 
 void Tool_simat::processFile(HumdrumFile& infile1, HumdrumFile& infile2) {
+	m_data1.clear();
+	m_data2.clear();
 	m_data1.parse(infile1);
 	m_data2.parse(infile2);
+	m_grid.setThreadCount(getInteger("jobs"));
 	m_grid.analyze(m_data1, m_data2);
 	if (getBoolean("raw")) {
 		m_grid.printCorrelationGrid(m_free_text);
@@ -1086,6 +1399,51 @@ void Tool_simat::processFile(HumdrumFile& infile1, HumdrumFile& infile2) {
 
 
 
+//////////////////////////////
+//
+// Tool_simat::processManyFiles -- Compare the measures of the first file
+//     to the measures of each of the other files, calculating all of the
+//     correlations in one matrix.  When the files are given one at a time
+//     (such as from a file stream), the first file is kept for comparing
+//     to the later files.  The raw correlation grid (or its diagonal) is
+//     printed for each file after a line with the filename.
+//
+
+bool Tool_simat::processManyFiles(HumdrumFileSet& infiles) {
+	int start = 0;
+	if (m_many.getRowCount() == 0) {
+		if (infiles.getCount() == 0) {
+			return false;
+		}
+		MeasureDataSet data(infiles[0]);
+		m_many.setRows(data);
+		start = 1;
+	}
+	m_many.clearColumns();
+	vector<int> columns;
+	for (int i=start; i<infiles.getCount(); i++) {
+		MeasureDataSet data(infiles[i]);
+		columns.push_back(m_many.addColumns(data));
+	}
+	columns.push_back(m_many.getColumnCount());
+	m_many.analyze(getInteger("jobs"));
+
+	for (int i=start; i<infiles.getCount(); i++) {
+		int column1 = columns[i - start];
+		int column2 = columns[i - start + 1];
+		m_free_text << "!!file: " << infiles[i].getFilename() << endl;
+		if (getBoolean("diagonal")) {
+			m_many.printDiagonal(m_free_text, column1, column2);
+		} else {
+			m_many.printGrid(m_free_text, column1, column2);
+		}
+	}
+	suppressHumdrumFileOutput();
+	return true;
+}
+
+
+
 // END_MERGE
 
 } // end namespace hum
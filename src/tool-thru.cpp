@@ -35,6 +35,8 @@ Tool_thru::Tool_thru(void) {
 	define("k|keep=b:",              "keep variation interpretations");
 	define("i|info=b:",              "print info list of labels in file");
 	define("r|realization=s:",       "alternate relaization label sequence");
+
+	setRequiredAnalyses(0);
 }
 
 
@@ -87,8 +87,7 @@ bool Tool_tie::run(HumdrumFile& infile, ostream& out) {
 bool Tool_tie::run(HumdrumFile& infile) {
 	initialize();
 	processFile(infile);
-	infile.createLinesFromTokens();
-	m_humdrum_text << infile;
+	printEditedFile(infile);
 	return true;
 }
 
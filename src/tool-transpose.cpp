@@ -109,7 +109,9 @@ bool Tool_transpose::run(HumdrumFile& infile, ostream& out) {
 //
 
 bool Tool_transpose::run(HumdrumFile& infile) {
-	initialize(infile);
+	if (!initialize(infile)) {
+		return !hasError();
+	}
 
 	if (ssettonicQ) {
 		transval = calculateTranspositionFromKey(ssettonic, infile);
@@ -1573,26 +1575,27 @@ void Tool_transpose::addToHistogramDouble(vector<vector<double> >& histogram, in
 
 //////////////////////////////
 //
-// Tool_transpose::initialize --
+// Tool_transpose::initialize -- Returns false if the file should not be
+//     processed (for an error or an option such as --help).
 //
 
-void Tool_transpose::initialize(HumdrumFile& infile) {
+bool Tool_transpose::initialize(HumdrumFile& infile) {
 
 	// handle basic options:
 	if (getBoolean("author")) {
 		m_free_text << "Written by Craig Stuart Sapp, "
 			  << "craig@ccrma.stanford.edu, 12 Apr 2004" << endl;
-		exit(0);
+		return false;
 	} else if (getBoolean("version")) {
 		m_free_text << getArg(0) << ", version: 10 Dec 2016" << endl;
 		m_free_text << "compiled: " << __DATE__ << endl;
-		exit(0);
+		return false;
 	} else if (getBoolean("help")) {
 		usage(getArg(0));
-		exit(0);
+		return false;
 	} else if (getBoolean("example")) {
 		example();
-		exit(0);
+		return false;
 	}
 
 	transval     =  getInteger("base40");
@@ -1609,9 +1612,8 @@ void Tool_transpose::initialize(HumdrumFile& infile) {
 
 	switch (getBoolean("diatonic") + getBoolean("chromatic")) {
 		case 1:
-			cerr << "Error: both -d and -c options must be specified" << endl;
-			exit(1);
-			break;
+			m_error_text << "Error: both -d and -c options must be specified" << endl;
+			return false;
 		case 2:
 			{
 				char buffer[128] = {0};
@@ -1628,6 +1630,7 @@ void Tool_transpose::initialize(HumdrumFile& infile) {
 	}
 
 	transval += 40 * octave;
+	return true;
 }
 
 
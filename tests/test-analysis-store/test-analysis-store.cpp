@@ -0,0 +1,221 @@
+// Description: Check that "auto" parameters stored in the typed analysis
+//              store of a file read back the same way as parameters stored
+//              as strings in a HumHash which is not in a file, that values
+//              survive token copies, moves and snapshots, and that slur
+//              and beam links are correct.  The time and store memory of
+//              the slur and beam analyses of a generated score are
+//              printed, along with the size of a HumHash.
+//
+// Usage:       test-analysis-store [-m measures]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// generateFile: Return a four-voice file with slurred and beamed eighth
+//     notes, some of which are tied.
+static string generateFile(mt19937& random, int measures) {
+	static vector<string> pitches = {"c", "d", "e", "f", "g", "a", "b", "cc"};
+	stringstream output;
+	output << makeLine("**kern", 4) << "\n" << makeLine("*M4/4", 4) << "\n";
+	for (int m=1; m<=measures; m++) {
+		output << makeLine("=" + to_string(m), 4) << "\n";
+		for (int i=0; i<8; i++) {
+			bool tie = (i % 2 == 0) && (random() % 4 == 0);
+			string pitch = pick(random, pitches);
+			string token = (i % 2 == 0) ? "(8" + pitch : "8" + pitch;
+			if (i % 2 == 0) {
+				token += tie ? "[L" : "L";
+			} else {
+				token += "J)";
+			}
+			output << makeLine(token, 4) << "\n";
+			if (tie) {
+				pitch = pitch + "]";
+			}
+			if (tie) {
+				output << makeLine("8" + pitch + "J)", 4) << "\n";
+				i++;
+			}
+		}
+	}
+	output << makeLine("==", 4) << "\n" << makeLine("*-", 4) << "\n";
+	return output.str();
+}
+
+
+// describe: Print all of the parameters of a HumHash through its
+//     public interface.
+static string describe(HumHash& hash) {
+	stringstream output;
+	output << hash;
+	vector<string> keys = hash.getKeys();
+	output << keys.size() << ":" << hash.getParameterCount() << ":"
+	       << hash.getParameterCount("auto") << ":" << hash.hasParameters() << "\n";
+	for (auto& key : hash.getKeys("", "auto")) {
+		string value = hash.getValue("auto", key);
+		// getValueFloat() prints an error for text which is not a number
+		bool numeric = isdigit(value[0]) || (value[0] == '-');
+		output << key << "=" << value
+		       << "|" << hash.getValueInt("auto", key)
+		       << "|" << hash.getValueFraction("auto", key)
+		       << "|" << (numeric ? hash.getValueFloat("auto", key) : 0.0)
+		       << "|" << hash.getValueBool("auto", key)
+		       << "|" << hash.getValueHTp("auto", key)
+		       << "|" << hash.isDefined("auto", key) << "\n";
+	}
+	for (auto& item : hash.getParameters("", "auto")) {
+		output << item.first << ":" << item.second << "\n";
+	}
+	return output.str();
+}
+
+
+// setValues: Store values of each type in a HumHash.
+static void setValues(HumHash& hash, HTp token) {
+	hash.setValue("auto", "int", 12);
+	hash.setValue("auto", "negative", -3);
+	hash.setValue("auto", "fraction", HumNum(7, 3));
+	hash.setValue("auto", "whole", HumNum(4));
+	hash.setValue("auto", "float", 6.5);
+	hash.setValue("auto", "token", token);
+	hash.setValue("auto", "null", (HTp)NULL);
+	hash.setValue("auto", "yes", "true");
+	hash.setValue("auto", "no", "false");
+	hash.setValue("auto", "text", "stop");
+	hash.setValue("auto", "numeric", "5/2");
+	hash.setValue("auto", "changed", 1);
+	hash.setValue("auto", "changed", "start");
+	hash.setValue("auto", "removed", 4);
+	hash.deleteValue("auto", "removed");
+	hash.setValue("auto", "2", "visualAccidental", "true");
+	hash.setValue("LO", "N", "vis", "4");
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("m|measures=i:2000", "number of measures in generated score");
+	options.process(argc, argv);
+
+	mt19937 random(1);
+	HumdrumFile infile;
+	infile.readString(generateFile(random, 8));
+
+	// Values stored in the file's analysis store look the same as values
+	// stored as strings:
+	HTp token = infile.token(3, 0);
+	HumHash plain;
+	plain.setPrefix("!");
+	setValues(plain, token);
+	setValues(*token, token);
+	check(describe(plain) == describe(*token), "typed values differ from strings");
+	check(token->getValue("auto", "fraction") == "7/3", "fraction text");
+	check(token->getValue("auto", "float") == "6.5", "float text");
+	check(token->getValue("auto", "yes") == "true", "boolean text");
+	check(token->getValueHTp("auto", "token") == token, "token pointer");
+	check(!token->isDefined("auto", "removed"), "deleted value still defined");
+	check(token->getValue("LO", "N", "vis") == "4", "layout parameter");
+
+	// A copy of a token has its own copy of the values:
+	HumdrumToken* copy = new HumdrumToken(*token);
+	check(describe(*copy) == describe(*token), "copy differs");
+	copy->setValue("auto", "int", 99);
+	check(token->getValueInt("auto", "int") == 12, "copy changed original");
+	delete copy;
+	check(token->getValueInt("auto", "int") == 12, "deleting copy changed original");
+
+	// A token which is no longer part of the file after it is assigned
+	// new text keeps its values as text:
+	HTp moved = infile.token(4, 0);
+	setValues(*moved, token);
+	string values = describe(*moved);
+	*moved = "4d";
+	check(moved->getOwner() == NULL, "assigned token still in the file");
+	check(describe(*moved) == values, "values changed when token left the file");
+
+	token->clearParameters();
+	check(!token->hasParameters(), "parameters not cleared");
+	check(token->getValueInt("auto", "int") == 0, "value not cleared");
+
+	// Slur and beam links in an analyzed file:
+	HumdrumFile score;
+	score.readString(generateFile(random, 40));
+	score.analyzeSlurs();
+	score.analyzeBeams();
+	int slurs = 0;
+	int beams = 0;
+	for (int i=0; i<score.getLineCount(); i++) {
+		for (int j=0; j<score[i].getFieldCount(); j++) {
+			HTp tok = score.token(i, j);
+			HTp end = tok->getValueHTp("auto", "slurEndId");
+			if (end) {
+				slurs++;
+				check(end->getSlurStartToken() == tok, "slur start and end do not match");
+				check(tok->getValueFraction("auto", "slurDuration") == HumNum(1, 2),
+						"slur duration");
+			}
+			HTp beamend = tok->getValueHTp("auto", "beamEndId");
+			if (beamend) {
+				beams++;
+				check(beamend->getValueHTp("auto", "beamStartId") == tok,
+						"beam start and end do not match");
+			}
+		}
+	}
+	check(slurs == 40 * 4 * 4, "expected " + to_string(40 * 4 * 4) + " slurs, found "
+			+ to_string(slurs));
+	check(beams == slurs, "expected a beam for each slur");
+
+	// Snapshots keep the typed values:
+	string snapshot;
+	check(score.writeSnapshot(snapshot), "cannot write snapshot");
+	stringstream text;
+	text << score;
+	HumdrumFile loaded;
+	check(loaded.readSnapshot(text.str(), snapshot), "cannot read snapshot");
+	for (int i=0; i<score.getLineCount(); i++) {
+		for (int j=0; j<score[i].getFieldCount(); j++) {
+			HTp tok1 = score.token(i, j);
+			HTp tok2 = loaded.token(i, j);
+			for (auto& key : tok1->getKeys("", "auto")) {
+				HTp link1 = tok1->getValueHTp("auto", key);
+				HTp link2 = tok2->getValueHTp("auto", key);
+				if (link1) {
+					check(link2 && (link1->getLineIndex() == link2->getLineIndex())
+							&& (link1->getFieldIndex() == link2->getFieldIndex()),
+							"snapshot link " + key + " differs");
+				} else {
+					check(tok1->getValue("auto", key) == tok2->getValue("auto", key),
+							"snapshot value " + key + " differs");
+				}
+			}
+			check(tok1->getParameterCount() == tok2->getParameterCount(),
+					"snapshot parameter count differs");
+		}
+	}
+
+	// Time the analyses of a large score:
+	HumdrumFile large;
+	large.readString(generateFile(random, options.getInteger("measures")));
+	auto start = chrono::steady_clock::now();
+	large.analyzeSlurs();
+	auto middle = chrono::steady_clock::now();
+	large.analyzeBeams();
+	auto stop = chrono::steady_clock::now();
+	HumAnalysisStore& store = *large.getAnalysisStore();
+
+	cout << "tokens=" << large.getLineCount() * 4
+	     << "\trows=" << store.getRowCount()
+	     << "\tkeys=" << store.getKeyCount()
+	     << "\tstoreKb=" << store.getMemoryUsage() / 1024
+	     << "\tslurMs=" << chrono::duration<double, milli>(middle - start).count()
+	     << "\tbeamMs=" << chrono::duration<double, milli>(stop - middle).count()
+	     << "\thashBytes=" << sizeof(HumHash)
+	     << endl;
+	return status;
+}
@@ -0,0 +1,131 @@
+// Description: Check that analyses of a HumdrumFile are done on demand and
+//              in dependency order, and that the results match a file read
+//              with the default analyses.  Also time the parts of the
+//              default read that are skipped when only rhythm is needed.
+//
+// Usage:       test-analysis [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// timeAnalyses: Average time in milliseconds to read the file without any
+//     analyses (times[0]), then to do the rhythm analysis and the analyses
+//     it depends on (times[1]), and then the rest of the default read
+//     analyses (times[2]).  All three are measured on the same file so
+//     that they are not biased by the state of the memory allocator.
+static void timeAnalyses(const string& filename, int count, vector<double>& times) {
+	times.assign(3, 0.0);
+	for (int i=0; i<count; i++) {
+		HumdrumFile infile;
+		infile.setReadAnalyses(0);
+		auto t0 = chrono::steady_clock::now();
+		infile.read(filename);
+		auto t1 = chrono::steady_clock::now();
+		infile.requireAnalysis(HumFileAnalysis::Rhythm);
+		auto t2 = chrono::steady_clock::now();
+		infile.requireAnalyses(HumFileAnalysis::ReadDefault);
+		auto t3 = chrono::steady_clock::now();
+		times[0] += chrono::duration<double, milli>(t1 - t0).count() / count;
+		times[1] += chrono::duration<double, milli>(t2 - t1).count() / count;
+		times[2] += chrono::duration<double, milli>(t3 - t2).count() / count;
+	}
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:5", "number of reads for timing");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+
+		HumdrumFile full(filename);
+		for (int type : {HumFileAnalysis::Strands, HumFileAnalysis::Nulls,
+				HumFileAnalysis::Strophes, HumFileAnalysis::Structure,
+				HumFileAnalysis::Rhythm}) {
+			check(full.isAnalyzed(type), filename, string("default read did not do ")
+					+ HumFileAnalysis::getName(type) + " analysis");
+		}
+
+		HumdrumFile lazy;
+		lazy.setReadAnalyses(0);
+		lazy.read(filename);
+		for (int type=0; type<HumFileAnalysis::Count; type++) {
+			check(!lazy.isAnalyzed(type), filename, string("empty read did ")
+					+ HumFileAnalysis::getName(type) + " analysis");
+		}
+
+		// Rhythm requires structure and strands, but not nulls or strophes:
+		check(lazy.getScoreDuration() == full.getScoreDuration(), filename,
+				"score durations do not match");
+		check(lazy.isAnalyzed(HumFileAnalysis::Rhythm) &&
+				lazy.isAnalyzed(HumFileAnalysis::Structure) &&
+				lazy.isAnalyzed(HumFileAnalysis::Strands), filename,
+				"rhythm did not trigger its dependencies");
+		check(!lazy.isAnalyzed(HumFileAnalysis::Nulls) &&
+				!lazy.isAnalyzed(HumFileAnalysis::Strophes) &&
+				!lazy.isAnalyzed(HumFileAnalysis::Slurs), filename,
+				"rhythm triggered unrelated analyses");
+
+		// Null resolution is done by the first token which needs it:
+		for (int j=0; j<lazy.getLineCount(); j++) {
+			if (!lazy[j].isData()) {
+				continue;
+			}
+			for (int k=0; k<lazy[j].getFieldCount(); k++) {
+				HTp resolved = lazy.token(j, k)->resolveNull();
+				HTp expected = full.token(j, k)->resolveNull();
+				check(resolved->getLineIndex() == expected->getLineIndex(),
+						filename, "null resolution does not match on line "
+						+ to_string(j+1));
+			}
+		}
+		check(lazy.isAnalyzed(HumFileAnalysis::Nulls), filename,
+				"resolveNull() did not mark nulls as analyzed");
+
+		// Slurs are linked by the first query for a slur endpoint:
+		full.analyzeSlurs();
+		for (int j=0; j<lazy.getLineCount(); j++) {
+			for (int k=0; k<lazy[j].getFieldCount(); k++) {
+				HTp token = lazy.token(j, k);
+				if (!token->isKern() || !token->hasSlurStart()) {
+					continue;
+				}
+				HTp end = token->getSlurEndToken();
+				HTp expected = full.token(j, k)->getSlurEndToken();
+				check((end == NULL) == (expected == NULL), filename,
+						"slur link does not match on line " + to_string(j+1));
+				if (end && expected) {
+					check(end->getLineIndex() == expected->getLineIndex(), filename,
+							"slur end does not match on line " + to_string(j+1));
+				}
+			}
+		}
+
+		// requireAnalysis() runs an analysis only once:
+		HumdrumFile once;
+		once.setReadAnalyses(HumFileAnalysis::getMask(HumFileAnalysis::Slurs));
+		once.read(filename);
+		check(once.isAnalyzed(HumFileAnalysis::Slurs) &&
+				once.isAnalyzed(HumFileAnalysis::Rhythm), filename,
+				"slur read analysis did not run with its dependencies");
+		check(once.requireAnalysis(HumFileAnalysis::Slurs), filename,
+				"second request for slur analysis failed");
+
+		vector<double> times;
+		timeAnalyses(filename, count, times);
+		cout << filename
+		     << "\treadMs=" << times[0]
+		     << "\trhythmMs=" << times[1]
+		     << "\tnullsStrophesMs=" << times[2]
+		     << endl;
+	}
+	return status;
+}
@@ -0,0 +1,86 @@
+// Description: Functions shared by the test programs in the tests
+//              directory: reporting failed checks, and generating random
+//              **kern data for comparing the output of humlib classes
+//              with reference implementations.
+//
+// Usage:       #include "../test-common.h" in a test program, and return
+//              status from main().
+
+#ifndef _TEST_COMMON_H_INCLUDED
+#define _TEST_COMMON_H_INCLUDED
+
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// status: Exit status of the test program, set to 1 by a failed check.
+static int status = 0;
+
+
+// check: Print an error message if the test fails.
+inline void check(bool test, const std::string& message) {
+	if (!test) {
+		std::cerr << message << std::endl;
+		status = 1;
+	}
+}
+
+
+// check: Print an error message for a file if the test fails.
+inline void check(bool test, const std::string& filename, const std::string& message) {
+	if (!test) {
+		std::cerr << filename << ": " << message << std::endl;
+		status = 1;
+	}
+}
+
+
+// pick: Return a random element of a list.
+template <class TYPE>
+const TYPE& pick(std::mt19937& random, const std::vector<TYPE>& list) {
+	return list[random() % list.size()];
+}
+
+
+// makeLine: Return a line with the same token in each field.
+inline std::string makeLine(const std::string& token, int fields) {
+	std::string output = token;
+	for (int i=1; i<fields; i++) {
+		output += "\t" + token;
+	}
+	return output;
+}
+
+
+// generateKern: Return a random score with the given number of voices
+//     and data lines, with the same rhythm in all voices.  Each data line
+//     takes its duration from the list of durations, and a pitch (or rest)
+//     for each voice from the list of pitches.  Barlines are added before
+//     every "measure" data lines, or not at all if measure is zero.
+inline std::string generateKern(std::mt19937& random, int voices, int length,
+		int measure, const std::vector<std::string>& pitches,
+		const std::vector<std::string>& durations) {
+	std::stringstream output;
+	output << makeLine("**kern", voices) << "\n";
+	output << makeLine("*M4/4", voices) << "\n";
+	for (int i=0; i<length; i++) {
+		if ((measure > 0) && (i % measure == 0)) {
+			output << makeLine("=" + std::to_string(i / measure + 1), voices) << "\n";
+		}
+		const std::string& duration = pick(random, durations);
+		for (int v=0; v<voices; v++) {
+			output << (v ? "\t" : "") << duration << pick(random, pitches);
+		}
+		output << "\n";
+	}
+	output << makeLine("*-", voices) << "\n";
+	return output.str();
+}
+
+
+#endif /* _TEST_COMMON_H_INCLUDED */
+
+
+
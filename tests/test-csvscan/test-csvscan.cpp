@@ -0,0 +1,208 @@
+// Description: Check HumFieldScanner::find() against a simple loop at all
+//              alignments, and check that CSV records are converted into
+//              the same TSV lines as the previous character-by-character
+//              converter.  Also check quoted fields which contain newlines,
+//              lines longer than the previous 123123-byte buffer and the
+//              separator option of readStringCsv().  The conversion speed
+//              of a generated CSV score is printed for both converters.
+//
+// Usage:       test-csvscan [-n records] [-m measures]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// oldCsvToTsv: The previous HumdrumLine::setLineFromCsv() conversion.
+static string oldCsvToTsv(const string& csv, const string& separator = ",") {
+	string newcsv = csv;
+	if ((newcsv.size() > 0) && (newcsv.back() == 0x0d)) {
+		newcsv.resize(newcsv.size() - 1);
+	}
+	if ((newcsv.size() >= 2) && (newcsv[0] == '!') && (newcsv[1] == '!')) {
+		return newcsv;
+	}
+	string output;
+	bool inquote = false;
+	for (int i=0; i<(int)newcsv.size(); i++) {
+		if ((newcsv[i] == '"') && !inquote) {
+			inquote = true;
+			continue;
+		}
+		if (inquote && (newcsv[i] == '"') && (newcsv[i+1] == '"')
+				&& (i < (int)newcsv.length()-1)) {
+			output += '"';
+			i++;
+			continue;
+		}
+		if (newcsv[i] == '"') {
+			inquote = false;
+			continue;
+		}
+		if ((!inquote) && (newcsv.substr(i, separator.size()) == separator)) {
+			output += '\t';
+			i += (int)separator.size() - 1;
+			continue;
+		}
+		output += newcsv[i];
+	}
+	return output;
+}
+
+
+// convertCsv: Convert CSV text into TSV text with HumFieldScanner.
+static string convertCsv(const string& csv, const string& separator = ",") {
+	string output;
+	string line;
+	const char* start = csv.data();
+	const char* end = start + csv.size();
+	while (start < end) {
+		start = HumFieldScanner::csvToTsv(start, end, separator, line);
+		output += line;
+		output += '\n';
+	}
+	return output;
+}
+
+
+// generateCsv: Return a CSV version of a two-voice score with lyrics,
+//     with quoted fields and some lines ending in carriage returns.
+static string generateCsv(mt19937& random, int measures) {
+	static vector<string> notes = {"4c", "4dL", "4eJ", "4f#", "4gg-", "\"4r;\"",
+			"\"4a,\"\"b\"\"\"", "4cc 4ee"};
+	stringstream output;
+	output << "!!!COM: Composer, Anonymous\n**kern,**kern,**text\n*M4/4,*M4/4,*\n";
+	for (int m=1; m<=measures; m++) {
+		output << "=" << m << ",=" << m << ",=" << m << "\n";
+		for (int i=0; i<8; i++) {
+			output << pick(random, notes) << ","
+			       << pick(random, notes) << ",\"syl, " << i << "\"\r\n";
+		}
+	}
+	output << "==,==,==\n*-,*-,*-\n";
+	return output.str();
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|records=i:20000", "number of random records to check");
+	options.define("m|measures=i:20000", "number of measures in generated score");
+	options.process(argc, argv);
+
+	// find() at all alignments and lengths:
+	mt19937 random(1);
+	string text(300, 'x');
+	for (int i=0; i<(int)text.size(); i++) {
+		text[i] = "ab\t,\"\n"[random() % 6];
+	}
+	for (int i=0; i<(int)text.size(); i++) {
+		for (int j=i; j<=(int)text.size(); j+=7) {
+			const char* start = text.data() + i;
+			const char* end = text.data() + j;
+			const char* expected = end;
+			const char* expected1 = end;
+			for (const char* p=start; p<end; p++) {
+				if ((expected == end) && ((*p == ',') || (*p == '"') || (*p == '\n'))) {
+					expected = p;
+				}
+				if ((expected1 == end) && (*p == '\t')) {
+					expected1 = p;
+				}
+			}
+			check(HumFieldScanner::find(start, end, ',', '"', '\n') == expected,
+					"find() wrong at " + to_string(i) + ":" + to_string(j));
+			check(HumFieldScanner::find(start, end, '\t') == expected1,
+					"find() of tab wrong at " + to_string(i) + ":" + to_string(j));
+		}
+	}
+
+	// Single records are converted as before:
+	string alphabet = "ab,\"\"\" \t\r!;";
+	for (int k=0; k<options.getInteger("records"); k++) {
+		string record;
+		int length = random() % 80;
+		for (int i=0; i<length; i++) {
+			record += alphabet[random() % alphabet.size()];
+		}
+		if (random() % 8 == 0) {
+			record = "!!" + record;
+		}
+		string separator = (k % 3 == 0) ? ";" : ((k % 3 == 1) ? "," : ";;");
+		HumdrumLine line;
+		line.setLineFromCsv(record, separator);
+		string expected = record.empty() ? "" : oldCsvToTsv(record, separator);
+		check((string)line == expected, "record \"" + record + "\" converted to \""
+				+ (string)line + "\" rather than \"" + expected + "\"");
+	}
+
+	// Quoted fields can contain newlines:
+	check(convertCsv("a,\"b\nc\",d\ne,f\n") == "a\tb c\td\ne\tf\n", "quoted newline");
+	check(convertCsv("a,\"b\r\nc\",d\r\ne\n") == "a\tb c\td\ne\n", "quoted CR/LF");
+	check(convertCsv("a,b\"c\nd\"\n") == "a\tbc\nd\n", "quote inside of field");
+	check(convertCsv("a,b\n\n!!x,\"y\nz\n") == "a\tb\n\n!!x,\"y\nz\n", "empty line and global");
+
+	// Lines longer than the previous read buffer:
+	string longtoken(200000, 'c');
+	HumdrumFile longfile;
+	longfile.readStringCsv("**kern,**kern\n4" + longtoken + ",4d\n*-,*-\n");
+	check(longfile.getLineCount() == 3, "wrong line count for long line");
+	check(longfile.token(1, 0)->size() == longtoken.size() + 1, "long token truncated");
+	check(*longfile.token(1, 1) == "4d", "token after long token");
+
+	// Separators other than commas:
+	HumdrumFile semicolon;
+	semicolon.readStringCsv("**kern;**kern\n4c;\"4d;\"\n*-;*-\n", ";");
+	check((semicolon.getLineCount() == 3) && (*semicolon.token(1, 1) == "4d;"),
+			"semicolon separator");
+
+	// Whole score read through a stream and a string:
+	string csv = generateCsv(random, 8);
+	HumdrumFile fromstring;
+	HumdrumFile fromstream;
+	fromstring.readStringCsv(csv);
+	stringstream csvstream;
+	csvstream << csv;
+	fromstream.readCsv(csvstream);
+	stringstream printed1;
+	stringstream printed2;
+	printed1 << fromstring;
+	printed2 << fromstream;
+	check(fromstring.isValid(), "generated CSV score is not valid");
+	check(printed1.str() == printed2.str(), "stream and string reading differ");
+	check(*fromstring.token(0, 0) == "!!!COM: Composer, Anonymous", "reference record");
+
+	// Conversion speed:
+	csv = generateCsv(random, options.getInteger("measures"));
+	auto time1 = chrono::steady_clock::now();
+	stringstream oldinput;
+	oldinput << csv;
+	string oldoutput;
+	string buffer;
+	while (getline(oldinput, buffer)) {
+		oldoutput += oldCsvToTsv(buffer);
+		oldoutput += '\n';
+	}
+	auto time2 = chrono::steady_clock::now();
+	string newoutput = convertCsv(csv);
+	auto time3 = chrono::steady_clock::now();
+	check(newoutput == oldoutput, "converted score differs");
+	HumdrumFile infile;
+	infile.readStringCsv(csv);
+	auto time4 = chrono::steady_clock::now();
+
+	double megabytes = csv.size() / 1000000.0;
+	cout << "scanner=" << HumFieldScanner::getInstructionSet()
+	     << "\tmegabytes=" << megabytes
+	     << "\toldMBps=" << megabytes / chrono::duration<double>(time2 - time1).count()
+	     << "\tnewMBps=" << megabytes / chrono::duration<double>(time3 - time2).count()
+	     << "\treadCsvMs=" << chrono::duration<double, milli>(time4 - time3).count()
+	     << endl;
+	return status;
+}
+
+
+
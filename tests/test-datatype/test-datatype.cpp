@@ -0,0 +1,104 @@
+// Description: Verify that the interned data type ids stored in tokens
+//              agree with the exclusive interpretation strings of their
+//              tracks (also after exclusive interpretations are changed
+//              with setText() or through the std::string interface), and
+//              time isKern()/isKernLike()/isDataType() over all tokens in
+//              the input files.
+//
+// Usage:       test-datatype [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// checkDataTypes: Check the data type of each token against the exclusive
+//     interpretation of its track, and return the number of tokens.
+static int checkDataTypes(HumdrumFile& infile, const string& filename, int& status) {
+	int tokens = 0;
+	for (int j=0; j<infile.getLineCount(); j++) {
+		for (int k=0; k<infile[j].getTokenCount(); k++) {
+			HTp token = infile.token(j, k);
+			HTp start = infile.getTrackStart(token->getTrack());
+			string expected = start ? *start : "";
+			if ((token->getDataType() != expected) ||
+					(HumDataType::getName(token->getDataTypeId()) != expected) ||
+					(token->isKern() != (expected == "**kern")) ||
+					(token->isDataType("kern") != (expected == "**kern"))) {
+				cerr << filename << ": line " << (j+1) << " field " << (k+1)
+				     << ": data type " << token->getDataType()
+				     << " expected " << expected << endl;
+				status = 1;
+			}
+			tokens++;
+		}
+	}
+	return tokens;
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:100", "number of passes over the tokens");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	int status = 0;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		HumdrumFile infile(filename);
+
+		int tokens = checkDataTypes(infile, filename, status);
+
+		// Data types follow exclusive interpretations changed with setText()
+		// (as done by kernview and restfill):
+		vector<HTp> starts;
+		infile.getKernSpineStartList(starts);
+		for (auto& start : starts) {
+			start->setText("**kernyy");
+		}
+		checkDataTypes(infile, filename + " (**kernyy)", status);
+		for (auto& start : starts) {
+			start->setText("**kern");
+		}
+		checkDataTypes(infile, filename + " (**kern)", status);
+
+		// Also when they are changed through the std::string interface
+		// (as done by autobeam for other tokens):
+		for (auto& start : starts) {
+			start->append("-tag");
+		}
+		checkDataTypes(infile, filename + " (**kern-tag)", status);
+		for (auto& start : starts) {
+			start->resize(6);
+		}
+		checkDataTypes(infile, filename + " (**kern again)", status);
+
+		int found = 0;
+		auto start = chrono::steady_clock::now();
+		for (int n=0; n<count; n++) {
+			for (int j=0; j<infile.getLineCount(); j++) {
+				for (int k=0; k<infile[j].getTokenCount(); k++) {
+					HTp token = infile.token(j, k);
+					found += token->isKern();
+					found += token->isKernLike();
+					found += token->isStaffLike();
+					found += token->isDataType("**recip");
+				}
+			}
+		}
+		auto stop = chrono::steady_clock::now();
+		double ns = chrono::duration<double, nano>(stop - start).count();
+		cout << filename
+		     << "\ttokens=" << tokens
+		     << "\tfound=" << found
+		     << "\tnsPerToken=" << ns / count / (tokens ? tokens : 1)
+		     << endl;
+	}
+	return status;
+}
+
+
+
@@ -0,0 +1,109 @@
+// Description: Check that Tool_filter::runBatch() gives the same output
+//              when files are filtered in parallel as when they are
+//              filtered one at a time, and time both methods.  Each input
+//              file is given a filter pipeline and stored as a segment of
+//              a single data stream (repeated to make a larger batch).
+//
+// Usage:       test-filter-batch [-j jobs] [-r repeat] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// Pipelines given to the segments in rotation:
+static vector<string> pipelines = {
+	"autobeam | autostem",
+	"transpose -t M2 | autobeam",
+	"autostem | tie -s",
+	"recip",
+	"thru | autobeam"
+};
+
+
+// runBatch: Filter all segments of the data and return the output, the
+//     number of errors and the time in milliseconds that it took.
+static string runBatch(const string& data, int jobs, int& errors, double& ms,
+		const string& command = "filter") {
+	HumdrumFileStream instream(data);
+	Tool_filter filter;
+	filter.process(command);
+	stringstream output;
+	auto start = chrono::steady_clock::now();
+	filter.runBatch(instream, output, jobs);
+	auto stop = chrono::steady_clock::now();
+	ms = chrono::duration<double, milli>(stop - start).count();
+	errors = (int)filter.getBatchErrors().size();
+	return output.str();
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("j|jobs=i:0", "number of parallel jobs (0 = all cores)");
+	options.define("r|repeat=i:20", "number of times to repeat the input files");
+	options.process(argc, argv);
+	int jobs = options.getInteger("jobs");
+	int repeat = options.getInteger("repeat");
+
+	stringstream data;
+	int count = 0;
+	for (int r=0; r<repeat; r++) {
+		for (int i=1; i<=options.getArgCount(); i++) {
+			HumdrumFile infile(options.getArg(i));
+			data << "!!!!SEGMENT: " << options.getArg(i) << "-" << r << "\n";
+			data << infile;
+			data << "!!!filter-my variant: " << pipelines[count % pipelines.size()] << "\n";
+			data << "!!!filter: " << pipelines[count++ % pipelines.size()] << "\n";
+		}
+	}
+
+	int serialErrors;
+	double serialMs;
+	string expected = runBatch(data.str(), 1, serialErrors, serialMs);
+	int parallelErrors;
+	double parallelMs;
+	string result = runBatch(data.str(), jobs, parallelErrors, parallelMs);
+
+	check(!expected.empty(), "no output from serial batch");
+	check(result == expected, "parallel batch output differs from serial output");
+	check(parallelErrors == serialErrors, "parallel batch errors differ from serial errors");
+
+	// The output of the window-limited batch is the same as filtering
+	// the segments one at a time with Tool_filter::run():
+	stringstream single;
+	HumdrumFileStream instream(data.str());
+	while (true) {
+		HumdrumFile infile;
+		if (!instream.read(infile)) {
+			break;
+		}
+		Tool_filter filter;
+		filter.process("filter");
+		if (filter.run(infile) && !filter.hasError()) {
+			single << infile;
+		}
+	}
+	check(single.str() == expected, "batch output differs from single-file filtering");
+
+	// The workers get the parsed options of the batch filter, so a variant
+	// name containing a space selects the same filters in parallel:
+	string command = "filter -v 'my variant'";
+	int variantErrors;
+	double variantMs;
+	string variantExpected = runBatch(data.str(), 1, variantErrors, variantMs, command);
+	string variantResult = runBatch(data.str(), jobs, variantErrors, variantMs, command);
+	check(!variantExpected.empty(), "no output from serial variant batch");
+	check(variantExpected != expected, "variant filters were not applied");
+	check(variantResult == variantExpected, "parallel variant output differs from serial output");
+
+	cout << "segments=" << count
+	     << "\tserialMs=" << serialMs
+	     << "\tparallelMs=" << parallelMs
+	     << "\tthreads=" << (jobs > 0 ? jobs : HumThreadPool::getHardwareThreadCount())
+	     << endl;
+	return status;
+}
@@ -0,0 +1,109 @@
+// Description: Check that the filter tool gives the same results when the
+//              stages of a pipeline update the file in memory as when the
+//              file is re-read after each stage (-R option), and time
+//              both methods.  Also check that the file is marked as edited
+//              only when the text of a token changes.
+//
+// Usage:       test-filter-pipeline [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// Pipelines with stages which change tokens in place (including tools
+// registered as in-place tools), add or remove lines, and change the
+// spine structure:
+static vector<string> pipelines = {
+	"autobeam | autostem",
+	"transpose -t M2 | transpose -t m7 | autobeam",
+	"autostem | tie -s | thru",
+	"autobeam | extract -f 1 | autostem",
+	"recip | autostem",
+	"restfill | autobeam | autostem | tie -m",
+	"thru | transpose -t P4 | autostem | autobeam -r",
+	"half | chord | autobeam | autostem",
+	"double | tie -s | autobeam | thru",
+	"autobeam | autobeam | extract -f 1 | thru | autostem",
+	"transpose -t M2 | rid -G | humtr | recip"
+};
+
+
+// runFilter: Run a pipeline on a copy of the file and return the resulting
+//     data (or the exception message if a stage cannot process the file).
+static string runFilter(const string& text, const string& pipeline,
+		const string& command) {
+	HumdrumFile infile;
+	infile.readString(text + "!!!filter: " + pipeline + "\n");
+	Tool_filter filter;
+	filter.process(command);
+	stringstream output;
+	try {
+		filter.run(infile);
+	} catch (exception& e) {
+		return pipeline + ": " + e.what() + "\n";
+	}
+	output << infile;
+	infile.printDurationInfo(output);
+	return output.str();
+}
+
+
+// runFilters: Run all pipelines on the file, returning the output and the
+//     time in milliseconds that it took.
+static string runFilters(const string& text, const string& command,
+		int count, double& ms) {
+	string output;
+	auto start = chrono::steady_clock::now();
+	for (int i=0; i<count; i++) {
+		output.clear();
+		for (auto& pipeline : pipelines) {
+			output += runFilter(text, pipeline, command);
+		}
+	}
+	auto stop = chrono::steady_clock::now();
+	ms = chrono::duration<double, milli>(stop - start).count() / count;
+	return output;
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:3", "number of runs for timing");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		HumdrumFile infile(filename);
+		stringstream text;
+		text << infile;
+
+		double reparseMs;
+		string expected = runFilters(text.str(), "filter -R", count, reparseMs);
+		double memoryMs;
+		string result = runFilters(text.str(), "filter", count, memoryMs);
+		check(result == expected, filename,
+				"in-memory pipeline output differs from re-read output");
+		cout << filename
+		     << "\treparseMs=" << reparseMs
+		     << "\tinMemoryMs=" << memoryMs
+		     << endl;
+	}
+
+	// setText() marks the file as edited only when the text changes:
+	HumdrumFile edited;
+	edited.readString("**kern\n4c\n*-\n");
+	HTp token = edited.token(1, 0);
+	token->setText("4c");
+	check(!edited.hasEditedTokens(), "unchanged token text marked the file as edited");
+	token->setText("4d");
+	check(edited.hasEditedTokens(), "changed token text did not mark the file as edited");
+	edited.reanalyzeTokens();
+	check(!edited.hasEditedTokens(), "reanalyzeTokens() did not clear the edited mark");
+
+	return status;
+}
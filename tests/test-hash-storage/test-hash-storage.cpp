@@ -0,0 +1,254 @@
+// Description: Check HumHash parameters against a map of maps for random
+//              sequences of setValue() and deleteValue() calls, and names
+//              added to the parameter name table from several threads,
+//              then read a generated score with many layout parameters,
+//              store the linked layout parameters of each token in its
+//              HumHash and check them.  The time to read the score and to
+//              store the parameters is printed, along with the peak memory
+//              use.
+//
+// Usage:       test-hash-storage [-g count] [-m measures]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+#include <thread>
+
+#include <sys/resource.h>
+
+using namespace hum;
+using namespace std;
+
+typedef map<string, map<string, map<string, string>>> Reference;
+
+
+// printReference: Print the reference parameters in the same format as
+//     operator<< for HumHash.
+static string printReference(Reference& reference) {
+	stringstream output;
+	for (auto& it1 : reference) {
+		for (auto& it2 : it1.second) {
+			if (it2.second.empty()) {
+				continue;
+			}
+			output << it1.first << ":" << it2.first;
+			for (auto& it3 : it2.second) {
+				output << ":" << it3.first;
+				if (it3.second != "true") {
+					output << "=" << it3.second;
+				}
+			}
+			output << "\n";
+		}
+	}
+	return output.str();
+}
+
+
+// compare: Check the parameters of a HumHash against the reference.
+static void compare(HumHash& hash, Reference& reference, const string& name) {
+	stringstream printed;
+	printed << hash;
+	check(printed.str() == printReference(reference), name + ": printed parameters differ");
+	vector<string> allkeys;
+	int count = 0;
+	for (auto& it1 : reference) {
+		int count1 = 0;
+		for (auto& it2 : it1.second) {
+			vector<string> keys;
+			for (auto& it3 : it2.second) {
+				keys.push_back(it3.first);
+				allkeys.push_back(it1.first + ":" + it2.first + ":" + it3.first);
+				check(hash.getValue(it1.first, it2.first, it3.first) == it3.second,
+						name + ": wrong value for " + it3.first);
+				check(hash.isDefined(it1.first, it2.first, it3.first),
+						name + ": " + it3.first + " not defined");
+			}
+			check(hash.getKeys(it1.first, it2.first) == keys, name + ": wrong keys in "
+					+ it1.first + ":" + it2.first);
+			check(hash.getParameterCount(it1.first, it2.first) == (int)keys.size(),
+					name + ": wrong count in " + it1.first + ":" + it2.first);
+			count1 += (int)keys.size();
+		}
+		check(hash.getParameterCount(it1.first) == count1, name + ": wrong count in " + it1.first);
+		count += count1;
+	}
+	check(hash.getKeys() == allkeys, name + ": wrong list of keys");
+	check(hash.getParameterCount() == count, name + ": wrong parameter count");
+	check(hash.hasParameters() == (count > 0), name + ": wrong hasParameters()");
+}
+
+
+// layoutFile: Return a two-voice score with local layout parameters
+//     before most notes and a global layout parameter in each measure.
+static string layoutFile(mt19937& random, int measures) {
+	static vector<string> pitches = {"c", "d", "e", "f", "g", "a", "b", "cc"};
+	stringstream output;
+	output << "**kern\t**kern\n*M4/4\t*M4/4\n";
+	for (int m=1; m<=measures; m++) {
+		output << "=" << m << "\t=" << m << "\n";
+		output << "!!LO:MM:t=measure " << m << "\n";
+		for (int i=0; i<4; i++) {
+			output << "!LO:N:vis=2:stem=" << (random() % 3) << "\t";
+			output << "!LO:TX:b:t=text&colon;" << i << "\n";
+			output << "!LO:N:xoff=" << (random() % 9) << "\t!\n";
+			output << "4" << pick(random, pitches) << "\t";
+			output << "4" << pick(random, pitches) << "\n";
+		}
+	}
+	output << "==\t==\n*-\t*-\n";
+	return output.str();
+}
+
+
+// storeLayoutParameters: Store the linked layout parameters of each token
+//     in its HumHash (as a notation converter would), returning the number
+//     of parameters stored.
+static int storeLayoutParameters(HumdrumFile& infile) {
+	int count = 0;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		for (int j=0; j<infile[i].getFieldCount(); j++) {
+			HTp token = infile.token(i, j);
+			for (int k=0; k<token->getLinkedParameterSetCount(); k++) {
+				HumParamSet* pset = token->getLinkedParameterSet(k);
+				if (pset == NULL) {
+					continue;
+				}
+				HTp ptoken = pset->getToken();
+				if (ptoken->isCommentGlobal()) {
+					token->setParameters(ptoken->substr(2), ptoken);
+				} else {
+					token->setParameters(ptoken);
+				}
+				count += pset->getCount();
+			}
+		}
+	}
+	return count;
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("g|generate=i:200", "number of random parameter sequences");
+	options.define("m|measures=i:4000", "number of measures in layout score");
+	options.process(argc, argv);
+
+	mt19937 random(1);
+	vector<string> ns1s = {"", "LO", "LO", "group", "Z"};
+	vector<string> ns2s = {"", "N", "TX", "R", "a"};
+	vector<string> keys = {"vis", "t", "x", "stem", "global", "a", "zz", "b2"};
+	HumdrumFile infile;
+	infile.readString("**kern\n4c\n*-\n");
+
+	for (int k=0; k<options.getInteger("generate"); k++) {
+		string name = "sequence " + to_string(k + 1);
+		HumHash hash;
+		Reference reference;
+		for (int i=0; i<30; i++) {
+			string ns1 = pick(random, ns1s);
+			string ns2 = pick(random, ns2s);
+			string key = pick(random, keys);
+			if (random() % 4 == 0) {
+				hash.deleteValue(ns1, ns2, key);
+				auto it1 = reference.find(ns1);
+				if (it1 != reference.end()) {
+					auto it2 = it1->second.find(ns2);
+					if (it2 != it1->second.end()) {
+						it2->second.erase(key);
+						if (it2->second.empty()) {
+							it1->second.erase(it2);
+						}
+					}
+					if (it1->second.empty()) {
+						reference.erase(it1);
+					}
+				}
+				check(!hash.isDefined(ns1, ns2, key), name + ": deleted value is defined");
+			} else {
+				string value = (random() % 3 == 0) ? "true" : to_string(random() % 100);
+				hash.setValue(ns1, ns2, key, value);
+				reference[ns1][ns2][key] = value;
+			}
+		}
+		compare(hash, reference, name);
+
+		// copies have their own parameters:
+		HumHash copy = hash;
+		compare(copy, reference, name + " copy");
+		copy.setValue("LO", "N", "vis", "copy");
+		check(hash.getValue("LO", "N", "vis") == reference["LO"]["N"]["vis"],
+				name + ": copy changed the original");
+		check(!hash.isDefined("no", "such", "name"), name + ": unknown name defined");
+	}
+
+	// names added from several threads at once (enough to grow the name
+	// table) are all found again with the same ids:
+	vector<vector<int>> ids(4);
+	vector<std::thread> threads;
+	for (int t=0; t<(int)ids.size(); t++) {
+		threads.emplace_back([&ids, t]() {
+			for (int i=0; i<5000; i++) {
+				string name = "name" + to_string((i * 7 + t * 1000) % 5000);
+				ids[t].push_back(HumParameterName::getId(name));
+				HumParameterName::findId("LO");
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (int t=0; t<(int)ids.size(); t++) {
+		for (int i=0; i<(int)ids[t].size(); i++) {
+			string name = "name" + to_string((i * 7 + t * 1000) % 5000);
+			check(HumParameterName::findId(name) == ids[t][i], "wrong id for " + name);
+			check(HumParameterName::getName(ids[t][i]) == name, "wrong name for " + name);
+		}
+	}
+
+	// origins:
+	HumHash hash;
+	hash.setValue("LO", "N", "vis", "4");
+	hash.setOrigin("LO", "N", "vis", infile.token(1, 0));
+	check(hash.getOrigin("LO:N:vis") == infile.token(1, 0), "wrong origin");
+	hash.setValue("LO", "N", "t", "x");
+	check(hash.getOrigin("LO", "N", "vis") == infile.token(1, 0), "origin lost");
+	hash.setValue("LO", "N", "vis", "2");
+	check(hash.getOrigin("LO", "N", "vis") == NULL, "origin not cleared");
+
+	// layout-heavy score:
+	string text = layoutFile(random, options.getInteger("measures"));
+	auto start = chrono::steady_clock::now();
+	HumdrumFile layout;
+	layout.readString(text);
+	auto middle = chrono::steady_clock::now();
+	int count = storeLayoutParameters(layout);
+	auto stop = chrono::steady_clock::now();
+	int found = 0;
+	for (int i=0; i<layout.getLineCount(); i++) {
+		for (int j=0; j<layout[i].getFieldCount(); j++) {
+			HTp token = layout.token(i, j);
+			if (token->isData() && (token->getFieldIndex() == 0)) {
+				check(token->getValue("LO", "N", "vis") == "2", "missing layout parameter");
+				check(token->getOrigin("LO", "N", "vis") != NULL, "missing layout origin");
+				check(token->isDefined("LO:N:xoff"), "missing second layout parameter");
+			} else if (token->isData()) {
+				check(token->getValue("LO", "TX", "t") == "text:" + to_string(found % 4),
+						"wrong text parameter");
+				found++;
+			}
+		}
+	}
+	check(found == 4 * options.getInteger("measures"), "wrong number of text parameters");
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	cout << "tokens=" << layout.getLineCount() * 2
+	     << "\tparameters=" << count
+	     << "\treadMs=" << chrono::duration<double, milli>(middle - start).count()
+	     << "\tstoreMs=" << chrono::duration<double, milli>(stop - middle).count()
+	     << "\tpeakRSS=" << usage.ru_maxrss << "kB"
+	     << endl;
+	return status;
+}
@@ -0,0 +1,225 @@
+// Description: Check the TimePointAlignment used by humdiff against a full
+//              dynamic-programming alignment for random short sequences,
+//              then run humdiff on generated scores with changed, deleted
+//              and inserted measures, checking the marked notes and the
+//              edit script.  The time to diff a long score is printed.
+//
+// Usage:       test-humdiff [-g count] [-m measures]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// randomNotes: Return a list of time points, each with up to three notes
+//     chosen from a small set of pitches and durations.
+static vector<vector<NotePoint>> randomNotes(mt19937& random, int count) {
+	vector<vector<NotePoint>> output(count);
+	for (int i=0; i<count; i++) {
+		int notes = random() % 4;
+		for (int j=0; j<notes; j++) {
+			NotePoint np;
+			np.b40 = 100 + random() % 5;
+			np.duration = HumNum(1 + random() % 2, 2);
+			output[i].push_back(np);
+		}
+	}
+	return output;
+}
+
+
+// optimalCost: Return the cost of the best alignment calculated with a
+//     full dynamic-programming matrix (Gotoh's algorithm).
+static int optimalCost(TimePointAlignment& alignment, int size1, int size2,
+		int open, int extend) {
+	const int inf = 1 << 28;
+	vector<vector<int>> cc(size1 + 1, vector<int>(size2 + 1, inf));
+	vector<vector<int>> dd = cc;
+	vector<vector<int>> ii = cc;
+	cc[0][0] = 0;
+	for (int i=1; i<=size1; i++) {
+		cc[i][0] = dd[i][0] = open + extend * i;
+	}
+	for (int j=1; j<=size2; j++) {
+		cc[0][j] = ii[0][j] = open + extend * j;
+	}
+	for (int i=1; i<=size1; i++) {
+		for (int j=1; j<=size2; j++) {
+			dd[i][j] = min(dd[i-1][j] + extend, cc[i-1][j] + open + extend);
+			ii[i][j] = min(ii[i][j-1] + extend, cc[i][j-1] + open + extend);
+			int diagonal = cc[i-1][j-1] + alignment.getSubstitutionCost(i - 1, j - 1);
+			cc[i][j] = min(diagonal, min(dd[i][j], ii[i][j]));
+		}
+	}
+	return cc[size1][size2];
+}
+
+
+// checkPath: Check that each time point occurs once in the path, in order.
+static void checkPath(vector<pair<int, int>>& path, int size1, int size2,
+		const string& name) {
+	int next1 = 0;
+	int next2 = 0;
+	for (int i=0; i<(int)path.size(); i++) {
+		if (path[i].first >= 0) {
+			check(path[i].first == next1++, name + ": first sequence out of order");
+		}
+		if (path[i].second >= 0) {
+			check(path[i].second == next2++, name + ": second sequence out of order");
+		}
+		check((path[i].first >= 0) || (path[i].second >= 0), name + ": empty step");
+	}
+	check((next1 == size1) && (next2 == size2), name + ": incomplete path");
+}
+
+
+// generateMeasure: Return a random two-voice measure.
+static string generateMeasure(mt19937& random, int number) {
+	static vector<string> pitches = {"c", "d", "e", "f", "g", "a", "b", "cc",
+			"e-", "f#", "B", "A", "G"};
+	stringstream output;
+	output << "=" << number << "\t=" << number << "\n";
+	for (int i=0; i<4; i++) {
+		output << "4" << pick(random, pitches) << "\t";
+		output << "4" << pick(random, pitches) << "\n";
+	}
+	return output.str();
+}
+
+
+// makeFile: Return a file from a list of measures.
+static string makeFile(vector<string>& measures) {
+	string output = "**kern\t**kern\n*M4/4\t*M4/4\n";
+	for (int i=0; i<(int)measures.size(); i++) {
+		output += measures[i];
+	}
+	output += "==\t==\n*-\t*-\n";
+	return output;
+}
+
+
+// runHumdiff: Run humdiff on two files with the given options.
+static string runHumdiff(const string& reference, const string& alternate,
+		const string& options) {
+	HumdrumFileSet infiles;
+	infiles.readAppendString(reference);
+	infiles.readAppendString(alternate);
+	Tool_humdiff humdiff;
+	humdiff.process("humdiff " + options);
+	humdiff.run(infiles);
+	return humdiff.getAllText();
+}
+
+
+// countLines: Count the lines of the edit script which start with a string.
+static int countLines(const string& text, const string& start) {
+	int output = 0;
+	stringstream input(text);
+	string line;
+	while (getline(input, line)) {
+		if (line.compare(0, start.size(), start) == 0) {
+			output++;
+		}
+	}
+	return output;
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("g|generate=i:300", "number of random sequences to align");
+	options.define("m|measures=i:4000", "number of measures in long score");
+	options.process(argc, argv);
+
+	mt19937 random(1);
+
+	// Alignments in linear memory should have the same cost as the
+	// full matrix when the band covers it:
+	for (int k=0; k<options.getInteger("generate"); k++) {
+		int size1 = random() % 40;
+		int size2 = random() % 40;
+		vector<vector<NotePoint>> notes1 = randomNotes(random, size1);
+		vector<vector<NotePoint>> notes2 = randomNotes(random, size2);
+		string name = "sequence " + to_string(k + 1);
+		TimePointAlignment alignment;
+		alignment.setSequences(notes1, notes2);
+		alignment.setBand(100);
+		vector<pair<int, int>> path;
+		alignment.align(path);
+		checkPath(path, size1, size2, name);
+		int cost = alignment.getPathCost(path);
+		int best = optimalCost(alignment, size1, size2, 6, 2);
+		check(cost == best, name + ": cost " + to_string(cost) + " is not optimal " + to_string(best));
+
+		// A narrow band still gives a valid path:
+		alignment.setBand(1);
+		alignment.align(path);
+		checkPath(path, size1, size2, name + " (narrow band)");
+	}
+
+	vector<string> measures;
+	for (int m=1; m<=40; m++) {
+		measures.push_back(generateMeasure(random, m));
+	}
+	string reference = makeFile(measures);
+
+	// identical files: nothing marked, empty edit script
+	string output = runHumdiff(reference, reference, "");
+	check(output.find('@') == string::npos, "identical: notes marked");
+	output = runHumdiff(reference, reference, "-e");
+	check(countLines(output, "change") + countLines(output, "insert")
+			+ countLines(output, "delete") == 0, "identical: edits found");
+
+	// one changed note: one mark, one change
+	vector<string> changed = measures;
+	size_t position = changed[10].find("\n4") + 1;
+	changed[10].replace(position, changed[10].find('\t', position) - position, "4GG");
+	output = runHumdiff(reference, makeFile(changed), "");
+	check(count(output.begin(), output.end(), '@') == 2, "changed: expected one marked note");
+	output = runHumdiff(reference, makeFile(changed), "-e");
+	check(countLines(output, "change") == 1, "changed: expected one change");
+
+	// measure inserted in the alternate file: nothing marked in the
+	// reference, four inserted time points
+	vector<string> inserted = measures;
+	inserted.insert(inserted.begin() + 20, generateMeasure(random, 99));
+	output = runHumdiff(reference, makeFile(inserted), "");
+	check(output.find('@') == string::npos, "inserted: notes marked");
+	output = runHumdiff(reference, makeFile(inserted), "-e");
+	check(countLines(output, "insert") == 4, "inserted: expected four insertions");
+	check(countLines(output, "change") + countLines(output, "delete") == 0,
+			"inserted: unexpected edits");
+
+	// measure deleted from the alternate file: its eight notes are marked
+	vector<string> deleted = measures;
+	deleted.erase(deleted.begin() + 5);
+	output = runHumdiff(reference, makeFile(deleted), "");
+	check(count(output.begin(), output.end(), '@') == 9, "deleted: expected eight marked notes");
+	output = runHumdiff(reference, makeFile(deleted), "-e");
+	check(countLines(output, "delete") == 4, "deleted: expected four deletions");
+
+	// long score with an inserted and a deleted measure:
+	vector<string> longmeasures;
+	for (int m=1; m<=options.getInteger("measures"); m++) {
+		longmeasures.push_back(generateMeasure(random, m));
+	}
+	vector<string> longalternate = longmeasures;
+	longalternate.insert(longalternate.begin() + longalternate.size() / 3,
+			generateMeasure(random, 0));
+	longalternate.erase(longalternate.begin() + 2 * longalternate.size() / 3);
+	string longreference = makeFile(longmeasures);
+	string longother = makeFile(longalternate);
+	auto start = chrono::steady_clock::now();
+	output = runHumdiff(longreference, longother, "-e");
+	auto stop = chrono::steady_clock::now();
+	check(countLines(output, "insert") == 4, "long: expected four insertions");
+	check(countLines(output, "delete") == 4, "long: expected four deletions");
+	check(countLines(output, "change") == 0, "long: unexpected changes");
+
+	cout << "timepoints=" << 4 * longmeasures.size()
+	     << "\tms=" << chrono::duration<double, milli>(stop - start).count() << endl;
+	return status;
+}
@@ -0,0 +1,158 @@
+// Description: Check HumNum arithmetic and comparisons against a
+//              reference calculation with 64-bit integers and GCD
+//              reduction, and time HumdrumFileStructure::analyzeStructure()
+//              (which includes analyzeRhythmStructure()) on the input files.
+//
+// Usage:       test-humnum [-n count] [file.krn ...]
+
+#include "humlib.h"
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <random>
+
+using namespace hum;
+using namespace std;
+
+// reference: the original HumNum reduction with 64-bit values.
+static void reference(int64_t a, int64_t b, int64_t& ra, int64_t& rb) {
+	ra = a;
+	rb = b;
+	if ((a == 1) || (b == 1) || (b == 0)) {
+		return;
+	}
+	if (a == 0) {
+		rb = 1;
+		return;
+	}
+	int64_t x = a < 0 ? -a : a;
+	int64_t y = b < 0 ? -b : b;
+	while (y) {
+		int64_t c = x % y;
+		x = y;
+		y = c;
+	}
+	ra /= x;
+	rb /= x;
+}
+
+static bool check(const HumNum& value, int64_t a, int64_t b, const string& op,
+		const HumNum& x, const HumNum& y) {
+	int64_t ra, rb;
+	reference(a, b, ra, rb);
+	if ((value.getNumerator() != ra) || (value.getDenominator() != rb)) {
+		cerr << "Error: " << x << " " << op << " " << y << " = " << value
+		     << " but expected " << ra << "/" << rb << endl;
+		return false;
+	}
+	return true;
+}
+
+static int testArithmetic(void) {
+	mt19937 generator(1);
+	uniform_int_distribution<int> numerators(-200, 200);
+	uniform_int_distribution<int> denominators(1, 96);
+	int errors = 0;
+	for (int i=0; i<200000; i++) {
+		int a1 = numerators(generator);
+		int b1 = denominators(generator);
+		int a2 = numerators(generator);
+		int b2 = denominators(generator);
+		if (i % 3 == 0) {
+			b1 = 1 << (b1 % 7);
+			b2 = 1 << (b2 % 7);
+		}
+		HumNum x(a1, b1);
+		HumNum y(a2, b2);
+		int64_t xa = x.getNumerator();
+		int64_t xb = x.getDenominator();
+		int64_t ya = y.getNumerator();
+		int64_t yb = y.getDenominator();
+		errors += !check(x + y, xa * yb + ya * xb, xb * yb, "+", x, y);
+		errors += !check(x - y, xa * yb - ya * xb, xb * yb, "-", x, y);
+		errors += !check(x * y, xa * ya, xb * yb, "*", x, y);
+		if (ya != 0) {
+			errors += !check(x / y, xa * yb, xb * ya, "/", x, y);
+		}
+		double fx = x.getFloat();
+		double fy = y.getFloat();
+		if (((x < y) != (fx < fy)) || ((x <= y) != (fx <= fy)) ||
+				((x > y) != (fx > fy)) || ((x >= y) != (fx >= fy)) ||
+				((x == y) != (fx == fy)) || ((x != y) != (fx != fy)) ||
+				((x < a2) != (fx < a2)) || ((x == a2) != (fx == a2))) {
+			cerr << "Error: comparison of " << x << " and " << y << endl;
+			errors++;
+		}
+	}
+
+	// Intermediate values larger than 32 bits which reduce to valid values:
+	HumNum big(1, 46341);
+	HumNum product = big * HumNum(46341, 1);
+	if (product != 1) {
+		cerr << "Error: 1/46341 * 46341 = " << product << endl;
+		errors++;
+	}
+	if (HumNum::hasOverflow()) {
+		cerr << "Error: overflow flag set without an overflow" << endl;
+		errors++;
+	}
+	HumNum overflow = HumNum(INT_MAX) + HumNum(1);
+	if (!HumNum::hasOverflow()) {
+		cerr << "Error: missing overflow for " << overflow << endl;
+		errors++;
+	}
+	HumNum::clearOverflow();
+
+	// Durations which overflow are a parse error rather than an exception
+	// (the start times of these notes have a denominator of 3*5*7*...*31):
+	HumdrumFile infile;
+	infile.setQuietParsing();
+	infile.readString("**kern\n3c\n5c\n7c\n11c\n13c\n17c\n19c\n23c\n29c\n31c\n*-\n");
+	if (infile.isValid()) {
+		cerr << "Error: no parse error for overflowing durations" << endl;
+		errors++;
+	}
+	if (HumNum::hasOverflow()) {
+		cerr << "Error: overflow flag not cleared by the analysis" << endl;
+		errors++;
+	}
+	return errors;
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:5", "number of times to analyze each file");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	int errors = testArithmetic();
+	cout << "arithmetic errors=" << errors << endl;
+
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		double best = 0.0;
+		HumNum duration;
+		for (int j=0; j<count; j++) {
+			HumdrumFile infile;
+			infile.readNoRhythm(filename);
+			auto start = chrono::steady_clock::now();
+			infile.analyzeStructure();
+			auto stop = chrono::steady_clock::now();
+			double ms = chrono::duration<double, milli>(stop - start).count();
+			if ((j == 0) || (ms < best)) {
+				best = ms;
+			}
+			duration = infile.getScoreDuration();
+		}
+		cout << filename
+		     << "\tduration=" << duration
+		     << "\tanalyzeStructure=" << best << "ms"
+		     << endl;
+	}
+	return errors ? 1 : 0;
+}
+
+
+
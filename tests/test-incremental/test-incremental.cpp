@@ -0,0 +1,325 @@
+// Description: Check that the analyses of a file after inserting, deleting
+//              and replacing lines with editLines() are the same as those
+//              of a full reading of the edited text.  Random edits are made
+//              to a generated score with lyrics and a divided voice, and
+//              the lines of a score with strophes and of the files given on
+//              the command line are deleted and inserted again.  The time
+//              for an edit of a large score is printed for the incremental
+//              update and for a full reading of the score.
+//
+// Usage:       test-incremental [-e edits] [-m measures] [files...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+static vector<string> rhythms = {"4", "8", "2", "16", "4.", "8."};
+static vector<string> pitches = {"c", "d", "e-", "f#", "g", "a", "b", "cc", "r"};
+
+static string strophes =
+	"**kern\t**text\n"
+	"*M3/4\t*\n"
+	"*\t*strophe\n"
+	"*\t*^\n"
+	"*\t*S/1\t*S/2\n"
+	"=1\t=1\t=1\n"
+	"4c\tone\tuno\n"
+	"!LO:N:vis=1\t!\t!\n"
+	"4d\ttwo\tdos\n"
+	".\t.\t.\n"
+	"4e\tthree\ttres\n"
+	"=2\t=2\t=2\n"
+	"!\t!\t!\n"
+	"2f\tfour\tcuatro\n"
+	"4g\t.\t.\n"
+	"*\t*v\t*v\n"
+	"*\t*Xstrophe\n"
+	"=3\t=3\n"
+	"!!LO:TX:t=fin\n"
+	"2.g\tfive\n"
+	"==\t==\n"
+	"*-\t*-\n";
+
+
+// makeDataLine: Return a data line with the same rhythm in all voices
+//     (fields - 1 **kern tokens followed by a **text token).
+static string makeDataLine(mt19937& random, const string& rhythm, int fields = 3) {
+	string output;
+	for (int i=0; i<fields-1; i++) {
+		output += rhythm + pick(random, pitches) + "\t";
+	}
+	return output + "la" + to_string(random() % 100);
+}
+
+
+// generateFile: Return a two-voice score with lyrics, comments and null
+//     data lines.  The second voice is divided in every fifth measure.
+static string generateFile(mt19937& random, int measures) {
+	stringstream output;
+	output << "!!!COM: Anonymous\n**kern\t**kern\t**text\n*M4/4\t*M4/4\t*\n";
+	for (int m=1; m<=measures; m++) {
+		output << "=" << m << "\t=" << m << "\t=" << m << "\n";
+		int fields = 3;
+		if (m % 5 == 3) {
+			output << "*\t*^\t*\n";
+			fields = 4;
+		}
+		for (int i=0; i<4; i++) {
+			output << makeDataLine(random, "4", fields) << "\n";
+			if (random() % 4 == 0) {
+				output << makeLine("!", fields) << "\n";
+			}
+			if (random() % 5 == 0) {
+				output << makeLine(".", fields) << "\n";
+			}
+		}
+		if (fields == 4) {
+			output << "*\t*v\t*v\t*\n";
+		}
+		if (random() % 6 == 0) {
+			output << "!! measure " << m << "\n";
+		}
+	}
+	output << "==\t==\t==\n*-\t*-\t*-\n";
+	return output.str();
+}
+
+
+// findLine: Return the index of a random line in the music for which
+//     test() is true, or -1 if there is no such line.
+template <class TEST>
+static int findLine(mt19937& random, HumdrumFile& infile, TEST test) {
+	int start = 3;
+	int stop = infile.getLineCount() - 1;
+	int offset = random() % (stop - start);
+	for (int k=0; k<stop-start; k++) {
+		int i = start + (offset + k) % (stop - start);
+		if (test(infile[i])) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+// getRhythm: Return the rhythm of the first non-null token on a line.
+static string getRhythm(HumdrumLine& line) {
+	HTp token = line.token(0)->isNull() ? line.token(1) : line.token(0);
+	return token->substr(0, token->find_first_not_of("0123456789."));
+}
+
+
+// editRandomly: Make a random edit to the generated score.
+static void editRandomly(mt19937& random, HumdrumFile& infile) {
+	// Place to insert a line, and the number of fields in the line:
+	int insert = 3 + random() % (infile.getLineCount() - 3);
+	int next = insert;
+	while (!infile[next].hasSpines()) {
+		next++;
+	}
+	int fields = infile[next].getFieldCount();
+
+	auto isdata    = [](HumdrumLine& line) { return line.isData() && !line.isAllNull(); };
+	auto isnull    = [](HumdrumLine& line) { return line.isData() && line.isAllNull(); };
+	auto iscomment = [](HumdrumLine& line) { return line.isComment(); };
+	auto isbarline = [](HumdrumLine& line) { return line.isBarline() && (line.token(0)->compare("==") != 0); };
+	int i;
+	switch (random() % 14) {
+		case 0:
+			infile.editInsertLine(insert, makeLine("!", fields));
+			break;
+		case 1:
+			infile.editInsertLine(insert, "!! new global comment");
+			break;
+		case 2:
+			if ((i = findLine(random, infile, iscomment)) >= 0) {
+				infile.editDeleteLine(i);
+			}
+			break;
+		case 3:
+			infile.editInsertLine(insert, makeLine("*", fields));
+			break;
+		case 4:
+			// same rhythm:
+			if ((i = findLine(random, infile, isdata)) >= 0) {
+				infile.editReplaceLine(i, makeDataLine(random, getRhythm(infile[i]),
+						infile[i].getFieldCount()));
+			}
+			break;
+		case 5:
+		case 6:
+			// different rhythm:
+			if ((i = findLine(random, infile, isdata)) >= 0) {
+				infile.editReplaceLine(i, makeDataLine(random, pick(random, rhythms),
+						infile[i].getFieldCount()));
+			}
+			break;
+		case 7:
+			infile.editInsertLine(insert, makeDataLine(random, pick(random, rhythms),
+					fields));
+			break;
+		case 8:
+			infile.editInsertLine(insert, makeLine(".", fields));
+			break;
+		case 9:
+			if ((i = findLine(random, infile, isnull)) >= 0) {
+				infile.editDeleteLine(i);
+			}
+			break;
+		case 10:
+			if (random() % 2) {
+				infile.editInsertLine(insert, makeLine("=", fields));
+			} else if ((i = findLine(random, infile, isbarline)) >= 0) {
+				infile.editDeleteLine(i);
+			}
+			break;
+		case 11:
+			// different rhythms in the two voices:
+			if (((i = findLine(random, infile, isdata)) >= 0) && (getRhythm(infile[i]) == "4")
+					&& (infile[i].getFieldCount() == 3)) {
+				infile.editLines(i, 1, {"8g\t4a\tx", "8b\t.\t."});
+			}
+			break;
+		case 12:
+			if ((i = findLine(random, infile, isdata)) >= 0) {
+				infile.editDeleteLine(i);
+			}
+			break;
+		case 13:
+			// spine manipulators:
+			if (fields == 3) {
+				infile.editLines(insert, 0, {"*^\t*\t*", "*\t*\t*\t*", "*v\t*v\t*\t*"});
+			}
+			break;
+	}
+}
+
+
+// checkLines: Delete each line of a file and insert it again (or replace
+//     spine manipulators and strophe markers with themselves), comparing
+//     the analyses after each edit with a full analysis.
+static void checkLines(HumdrumFile& infile, const string& name) {
+	stringstream original;
+	original << infile;
+	for (int i=1; i<infile.getLineCount()-1; i++) {
+		string line = infile[i];
+		if (infile[i].isManipulator() || (line.find("strophe") != string::npos)) {
+			// Lines which cannot be deleted without making the file
+			// invalid are replaced by themselves:
+			infile.editReplaceLine(i, line);
+			stringstream differences;
+			check(infile.checkAnalysis(differences), name + ": replacing line "
+					+ to_string(i+1) + ":\n" + differences.str());
+			continue;
+		}
+		infile.editDeleteLine(i);
+		stringstream differences;
+		check(infile.checkAnalysis(differences), name + ": deleting line "
+				+ to_string(i+1) + ":\n" + differences.str());
+		infile.editInsertLine(i, line);
+		differences.str("");
+		check(infile.checkAnalysis(differences), name + ": inserting line "
+				+ to_string(i+1) + ":\n" + differences.str());
+	}
+	stringstream edited;
+	edited << infile;
+	check(edited.str() == original.str(), name + ": text changed");
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("e|edits=i:3000", "number of random edits to check");
+	options.define("m|measures=i:4000", "number of measures in timed score");
+	options.process(argc, argv);
+
+	// Random edits of a generated score:
+	mt19937 random(1);
+	HumdrumFile infile;
+	infile.setQuietParsing();
+	infile.readString(generateFile(random, 12));
+	check(infile.checkAnalysis(), "generated score differs from itself");
+	int incremental = 0;
+	for (int k=0; k<options.getInteger("edits"); k++) {
+		editRandomly(random, infile);
+		incremental += infile.isLastEditIncremental();
+		stringstream differences;
+		if (!infile.checkAnalysis(differences)) {
+			check(false, "edit " + to_string(k) + " differs from full analysis:\n" +
+					differences.str());
+			break;
+		}
+		if (!infile.isValid() || (infile.getLineCount() > 400)) {
+			infile.readString(generateFile(random, 12));
+		}
+	}
+	check(incremental > options.getInteger("edits") / 2,
+			"only " + to_string(incremental) + " edits were incremental");
+
+	// Edits of a file which has been read without rhythm:
+	HumdrumFile norhythm;
+	norhythm.readStringNoRhythm(generateFile(random, 4));
+	norhythm.editInsertLine(6, makeDataLine(random, "8"));
+	check(norhythm.isLastEditIncremental(), "edit without rhythm is not incremental");
+	check(!norhythm.isAnalyzed(HumFileAnalysis::Rhythm), "rhythm analyzed after edit");
+	check(norhythm.checkAnalysis(), "edit without rhythm differs from full analysis");
+
+	// Strophes and layout parameters:
+	HumdrumFile strophefile;
+	strophefile.setQuietParsing();
+	strophefile.readString(strophes);
+	check(strophefile.getStropheCount() > 0, "strophes not found");
+	checkLines(strophefile, "strophes");
+
+	// Lines of other files deleted and inserted again:
+	for (int f=1; f<=options.getArgCount(); f++) {
+		HumdrumFile file;
+		file.setQuietParsing();
+		file.read(options.getArg(f));
+		checkLines(file, options.getArg(f));
+	}
+
+	// Time of an edit in a large score:
+	string text = generateFile(random, options.getInteger("measures"));
+	HumdrumFile large;
+	large.readString(text);
+	int line = large.getLineCount() / 2;
+	while (!large[line].isData() || large[line].isAllNull()) {
+		line++;
+	}
+	string original = large[line];
+	int fields = large[line].getFieldCount();
+	int edits = 200;
+	auto time1 = chrono::steady_clock::now();
+	for (int k=0; k<edits; k++) {
+		large.editLines(line, 1, {makeDataLine(random, "8", fields),
+				makeDataLine(random, "8", fields)});
+		large.editLines(line, 2, {original});
+	}
+	auto time2 = chrono::steady_clock::now();
+	check(large.isLastEditIncremental(), "edit of large score is not incremental");
+	check(large.checkAnalysis(), "edit of large score differs from full analysis");
+	int reads = 10;
+	for (int k=0; k<reads; k++) {
+		HumdrumFile full;
+		full.readString(text);
+	}
+	auto time3 = chrono::steady_clock::now();
+
+	double incrementalus = chrono::duration<double, micro>(time2 - time1).count() / (2 * edits);
+	double fullus = chrono::duration<double, micro>(time3 - time2).count() / reads;
+	cout << "lines=" << large.getLineCount()
+	     << "\tincrementalEdits=" << incremental << "/" << options.getInteger("edits")
+	     << "\tincrementalUs=" << incrementalus
+	     << "\tfullUs=" << fullus
+	     << "\tspeedup=" << fullus / incrementalus
+	     << endl;
+	return status;
+}
+
+
+
@@ -0,0 +1,187 @@
+// Description: Check that the HumdrumToken accessors which read from the
+//              cached HumKernRecord agree with the text-scanning Convert
+//              functions (also when several threads read the same tokens),
+//              and time both over all **kern tokens in the input files.
+//
+// Usage:       test-kernrecord [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace hum;
+using namespace std;
+
+// scanBase40: Base-40 pitches calculated from the text of the token.
+static void scanBase40(HTp token, vector<int>& output) {
+	vector<string> pieces = token->getSubtokens();
+	output.resize(pieces.size());
+	for (int i=0; i<(int)pieces.size(); i++) {
+		if (pieces[i].find("r") != string::npos) {
+			output[i] = 0;
+		} else {
+			output[i] = Convert::kernToBase40(pieces[i]);
+			if ((pieces[i].find("_") != string::npos) ||
+					(pieces[i].find("]") != string::npos)) {
+				output[i] = -output[i];
+			}
+		}
+	}
+}
+
+
+// scanToken: Query the token by scanning its text each time.
+static int scanToken(HTp token, vector<int>& pitches) {
+	string text = *token;
+	int sum = 0;
+	scanBase40(token, pitches);
+	sum += pitches.empty() ? 0 : pitches[0];
+	sum += Convert::isKernRest(text);
+	sum += Convert::isKernNote(text);
+	sum += Convert::isKernSecondaryTiedNote(text);
+	sum += Convert::hasKernSlurStart(text);
+	sum += Convert::recipToDuration(text).getNumerator();
+	return sum;
+}
+
+
+// readToken: Query the token through its cached record (isRest() differs
+//     from Convert::isKernRest() for chords, which are not used here).
+static int readToken(HTp token, vector<int>& pitches) {
+	int sum = 0;
+	sum += token->getBase40Pitch();
+	sum += token->isRest();
+	sum += token->isNote();
+	sum += token->isSecondaryTiedNote();
+	sum += token->hasSlurStart();
+	sum += token->getDuration().getNumerator();
+	return sum;
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:20", "number of passes over the tokens");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	int status = 0;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		HumdrumFile infile(filename);
+
+		vector<HTp> tokens;
+		vector<int> expected;
+		vector<int> actual;
+		for (int j=0; j<infile.getLineCount(); j++) {
+			if (!infile[j].isData()) {
+				continue;
+			}
+			for (int k=0; k<infile[j].getTokenCount(); k++) {
+				HTp token = infile.token(j, k);
+				if (!token->isKern() || token->isNull() || token->empty()) {
+					continue;
+				}
+				tokens.push_back(token);
+				string text = *token;
+				scanBase40(token, expected);
+				token->getBase40Pitches(actual);
+				HumNum duration = Convert::recipToDuration(text);
+				if ((expected != actual) ||
+						(!token->isChord() &&
+							(token->isRest() != Convert::isKernRest(text))) ||
+						(token->isNote() != Convert::isKernNote(text)) ||
+						(token->isSecondaryTiedNote() !=
+							Convert::isKernSecondaryTiedNote(text)) ||
+						(token->hasSlurStart() != Convert::hasKernSlurStart(text)) ||
+						(token->hasSlurEnd() != Convert::hasKernSlurEnd(text)) ||
+						(token->getDuration() != duration)) {
+					cerr << filename << ": line " << (j+1) << " field " << (k+1)
+					     << ": record does not match token " << text << endl;
+					status = 1;
+				}
+				token->setText("4r");
+				if (!token->isRest() || (token->getBase40Pitch() != 0)) {
+					cerr << filename << ": line " << (j+1) << " field " << (k+1)
+					     << ": record not updated after setText()" << endl;
+					status = 1;
+				}
+				token->setText(text);
+
+				// Also when the text is changed through std::string:
+				string beamed = "8ccL";
+				token->swap(beamed);
+				if (!token->hasBeam() || token->isRest() || (token->getBase40Pitch() != 202)) {
+					cerr << filename << ": line " << (j+1) << " field " << (k+1)
+					     << ": record not updated after swap()" << endl;
+					status = 1;
+				}
+				token->swap(beamed);
+				token->getBase40Pitches(actual);
+				if (actual != expected) {
+					cerr << filename << ": line " << (j+1) << " field " << (k+1)
+					     << ": record not restored after swap()" << endl;
+					status = 1;
+				}
+			}
+		}
+
+		vector<int> pitches;
+		int scanned = 0;
+		auto start = chrono::steady_clock::now();
+		for (int n=0; n<count; n++) {
+			for (int j=0; j<(int)tokens.size(); j++) {
+				scanned += scanToken(tokens[j], pitches);
+			}
+		}
+		auto middle = chrono::steady_clock::now();
+		int cached = 0;
+		for (int n=0; n<count; n++) {
+			for (int j=0; j<(int)tokens.size(); j++) {
+				cached += readToken(tokens[j], pitches);
+			}
+		}
+		auto stop = chrono::steady_clock::now();
+		if (scanned != cached) {
+			cerr << filename << ": checksum " << cached
+			     << " expected " << scanned << endl;
+			status = 1;
+		}
+
+		// Several threads can create the records of the same tokens at once:
+		for (auto& token : tokens) {
+			token->clearKernRecord();
+		}
+		vector<int> sums(4, 0);
+		vector<std::thread> threads;
+		for (int t=0; t<(int)sums.size(); t++) {
+			threads.emplace_back([&tokens, &sums, t]() {
+				vector<int> pitches;
+				for (int j=0; j<(int)tokens.size(); j++) {
+					sums[t] += readToken(tokens[j], pitches);
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		for (int sum : sums) {
+			if (count && (sum * count != scanned)) {
+				cerr << filename << ": checksum from threads " << sum * count
+				     << " expected " << scanned << endl;
+				status = 1;
+			}
+		}
+
+		double total = (double)count * (tokens.empty() ? 1 : tokens.size());
+		double scan = chrono::duration<double, nano>(middle - start).count();
+		double read = chrono::duration<double, nano>(stop - middle).count();
+		cout << filename
+		     << "\ttokens=" << tokens.size()
+		     << "\tscanNsPerToken=" << scan / total
+		     << "\tcachedNsPerToken=" << read / total
+		     << endl;
+	}
+	return status;
+}
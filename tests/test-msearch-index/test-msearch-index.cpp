@@ -0,0 +1,144 @@
+// Description: Check that msearch gives the same output when candidate
+//              matches are taken from an n-gram index (MSearchIndex) as
+//              when every note is checked, for pitch, interval, rhythm
+//              and combined queries, and for files that are not in the
+//              index.  The input files are searched together with
+//              randomly generated files, and the time of both methods is
+//              printed, along with the time to parse the files.
+//
+// Usage:       test-msearch-index [-g count] [-n length] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace hum;
+using namespace std;
+
+// Queries searched in all files:
+static vector<string> queries = {
+	"-p cde",
+	"-p ccc",
+	"-p gfed",
+	"-p e-dc",
+	"-p c#de",
+	"-i 22",
+	"-i 2-2",
+	"-i 111",
+	"-r 448",
+	"-r 4444",
+	"-q 4c4d4e",
+	"-q 8c8d4e",
+	"-q 4c4r4e",
+	"-q 4c4d4e4f",
+	"-p cdefg -O",
+	"-p cd",
+	"-t the"
+};
+
+
+// generateFile: Return a random two-voice file.
+static string generateFile(mt19937& random, int length) {
+	static vector<string> pitches = {"c", "d", "e", "f", "g", "a", "b", "cc",
+			"dd", "e-", "f#", "B", "A", "G", "r"};
+	static vector<string> durations = {"4", "4", "4", "8", "8", "2", "4."};
+	return generateKern(random, 2, length, 0, pitches, durations);
+}
+
+
+// search: Run msearch on each file and return the output.
+static string search(const vector<string>& files, const string& query,
+		const string& indexfile, double& ms) {
+	Tool_msearch msearch;
+	msearch.process("msearch " + query + (indexfile.empty() ? "" : " --index " + indexfile));
+	stringstream output;
+	auto start = chrono::steady_clock::now();
+	for (int i=0; i<(int)files.size(); i++) {
+		HumdrumFile infile;
+		infile.readString(files[i]);
+		msearch.run(infile);
+		msearch.getAllText(output);
+		msearch.clearOutput();
+	}
+	auto stop = chrono::steady_clock::now();
+	ms += chrono::duration<double, milli>(stop - start).count();
+	return output.str();
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("g|generate=i:500", "number of random files to generate");
+	options.define("n|length=i:3", "number of notes in each n-gram");
+	options.process(argc, argv);
+
+	vector<string> files;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		HumdrumFile infile(options.getArg(i));
+		stringstream text;
+		text << infile;
+		files.push_back(text.str());
+	}
+	mt19937 random(1);
+	for (int i=0; i<options.getInteger("generate"); i++) {
+		files.push_back(generateFile(random, 200));
+	}
+
+	MSearchIndex index(options.getInteger("length"));
+	for (int i=0; i<(int)files.size(); i++) {
+		HumdrumFile infile;
+		infile.readString(files[i]);
+		index.addFile(infile);
+	}
+	string indexfile = "/tmp/test-msearch-index-" + to_string((long long)getpid()) + ".index";
+	check(index.write(indexfile), "cannot write index file");
+
+	// Files that are not in the index are searched in full:
+	for (int i=0; i<3; i++) {
+		files.push_back(generateFile(random, 50));
+	}
+
+	double bruteMs = 0.0;
+	double indexMs = 0.0;
+	double parseMs = 0.0;
+	for (auto& query : queries) {
+		string expected = search(files, query, "", bruteMs);
+		string output = search(files, query, indexfile, indexMs);
+		check(output == expected, "\"" + query + "\" output differs with index");
+		auto start = chrono::steady_clock::now();
+		for (int i=0; i<(int)files.size(); i++) {
+			HumdrumFile infile;
+			infile.readString(files[i]);
+		}
+		auto stop = chrono::steady_clock::now();
+		parseMs += chrono::duration<double, milli>(stop - start).count();
+	}
+
+	// A missing index gives a warning, and all notes are searched:
+	Tool_msearch msearch;
+	msearch.process("msearch -p cde --index /no/such/file.index");
+	HumdrumFile infile;
+	infile.readString(files.back());
+	msearch.run(infile);
+	check(msearch.hasWarning(), "no warning for missing index file");
+
+	MSearchIndex readindex;
+	check(readindex.read(indexfile), "cannot read index file");
+	check(readindex.getFileCount() == index.getFileCount(), "wrong file count in index file");
+	check(readindex.getGramCount() == index.getGramCount(), "wrong n-gram count in index file");
+	remove(indexfile.c_str());
+
+	cout << "files=" << files.size()
+	     << "\tqueries=" << queries.size()
+	     << "\tgrams=" << index.getGramCount()
+	     << "\tbruteMs=" << bruteMs
+	     << "\tindexMs=" << indexMs
+	     << "\tparseMs=" << parseMs << endl;
+	return status;
+}
+
+
+
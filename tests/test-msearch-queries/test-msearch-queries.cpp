@@ -0,0 +1,160 @@
+// Description: Check that msearch with a list of queries (--queries) gives
+//              the same output as running msearch with each query in
+//              turn on the output of the previous query, and time both
+//              methods.  The queries are a fixed list together with
+//              random pitch, interval and rhythm queries, which are
+//              searched for in the input files and in randomly
+//              generated files.
+//
+// Usage:       test-msearch-queries [-g count] [-q count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+using namespace hum;
+using namespace std;
+
+// Queries searched in all files (before the random queries):
+static vector<string> queries = {
+	"-p cde",
+	"-p e-dc -m x",
+	"-i 2-2",
+	"-i 22",
+	"-r 448 -Q",
+	"-q 4c4r4e",
+	"-p cd -M",
+	"-p gfed -c red",
+	"-t the",
+	"-p ccc"
+};
+
+
+// generateFile: Return a random two-voice file.
+static string generateFile(mt19937& random, int length) {
+	static vector<string> pitches = {"c", "d", "e", "f", "g", "a", "b", "cc",
+			"dd", "e-", "f#", "B", "A", "G", "r"};
+	static vector<string> durations = {"4", "4", "4", "8", "8", "2", "4."};
+	return generateKern(random, 2, length, 8, pitches, durations);
+}
+
+
+// generateQuery: Return a random pitch, interval or rhythm query.
+static string generateQuery(mt19937& random) {
+	static vector<string> pitches = {"c", "d", "e", "f", "g", "a", "b", "e-", "f#"};
+	static vector<string> intervals = {"1", "2", "-2", "3", "-3", "4", "-5"};
+	static vector<string> durations = {"4", "8", "2"};
+	int length = 3 + random() % 3;
+	string query;
+	switch (random() % 4) {
+		case 0:
+			for (int i=0; i<length; i++) {
+				query += pick(random, pitches);
+			}
+			return "-p " + query;
+		case 1:
+			for (int i=0; i<length; i++) {
+				query += (i ? " " : "") + pick(random, intervals);
+			}
+			return "-i \"" + query + "\"";
+		case 2:
+			for (int i=0; i<length; i++) {
+				query += pick(random, durations);
+			}
+			return "-r " + query;
+		default:
+			for (int i=0; i<length; i++) {
+				query += pick(random, durations);
+				query += pick(random, pitches);
+			}
+			return "-q " + query;
+	}
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("g|generate=i:100", "number of random files to generate");
+	options.define("q|queries=i:100", "number of random queries to generate");
+	options.process(argc, argv);
+
+	vector<string> files;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		HumdrumFile infile(options.getArg(i));
+		stringstream text;
+		text << infile;
+		files.push_back(text.str());
+	}
+	mt19937 random(1);
+	for (int i=0; i<options.getInteger("generate"); i++) {
+		files.push_back(generateFile(random, 200));
+	}
+	for (int i=0; i<options.getInteger("queries"); i++) {
+		queries.push_back(generateQuery(random));
+	}
+
+	string queryfile = "/tmp/test-msearch-queries-" + to_string((long long)getpid()) + ".txt";
+	ofstream output(queryfile);
+	output << "# queries for test-msearch-queries\n\n";
+	for (auto& query : queries) {
+		output << query << "\n";
+	}
+	output.close();
+
+	vector<Tool_msearch> tools(queries.size());
+	for (int i=0; i<(int)queries.size(); i++) {
+		check(tools[i].process("msearch " + queries[i], 0, 1), "cannot parse query " + queries[i]);
+	}
+	Tool_msearch batch;
+	batch.process("msearch --queries " + queryfile);
+
+	double singleMs = 0.0;
+	double batchMs = 0.0;
+	for (int i=0; i<(int)files.size(); i++) {
+		// Run each query on the output of the previous one:
+		auto start = chrono::steady_clock::now();
+		string expected = files[i];
+		for (int j=0; j<(int)tools.size(); j++) {
+			HumdrumFile infile;
+			infile.readString(expected);
+			tools[j].run(infile);
+			stringstream text;
+			tools[j].getAllText(text);
+			tools[j].clearOutput();
+			expected = text.str();
+		}
+		auto middle = chrono::steady_clock::now();
+		HumdrumFile infile;
+		infile.readString(files[i]);
+		batch.run(infile);
+		stringstream text;
+		batch.getAllText(text);
+		batch.clearOutput();
+		auto stop = chrono::steady_clock::now();
+		singleMs += chrono::duration<double, milli>(middle - start).count();
+		batchMs += chrono::duration<double, milli>(stop - middle).count();
+		check(text.str() == expected, "file " + to_string(i + 1) + " output differs for query list");
+	}
+
+	remove(queryfile.c_str());
+
+	// A missing query file is an error:
+	Tool_msearch missing;
+	missing.process("msearch --queries " + queryfile);
+	HumdrumFile infile;
+	infile.readString(files.back());
+	check(!missing.run(infile) && missing.hasError(), "no error for missing query file");
+
+	cout << "files=" << files.size()
+	     << "\tqueries=" << queries.size()
+	     << "\tsingleMs=" << singleMs
+	     << "\tbatchMs=" << batchMs << endl;
+	return status;
+}
+
+
+
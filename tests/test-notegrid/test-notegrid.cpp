@@ -0,0 +1,259 @@
+// Description: Check the pitches, attack indexes, tied tokens and meters
+//              of the cells in a NoteGrid against values calculated
+//              directly from the tokens of the score, and time loading
+//              the grid and reading all of its cells.  The storage used
+//              for each slice of the grid is also printed.
+//
+// Usage:       test-notegrid [-g count] [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+#include <cmath>
+
+using namespace hum;
+using namespace std;
+
+// same: Return true if two values are equal, or both NaN.
+static bool same(double a, double b) {
+	return (a == b) || (std::isnan(a) && std::isnan(b));
+}
+
+
+// generateFile: Return a random file with tied notes, rests and a
+//     meter change.
+static string generateFile(mt19937& random, int voices, int length) {
+	static vector<string> pitches = {"c", "d", "e", "f", "g", "a", "b", "cc",
+			"e-", "f#", "B", "A", "G", "r", "r"};
+	stringstream output;
+	for (int v=0; v<voices; v++) {
+		output << (v ? "\t" : "") << "**kern";
+	}
+	output << "\n";
+	for (int v=0; v<voices; v++) {
+		output << (v ? "\t" : "") << "*M4/4";
+	}
+	output << "\n";
+	vector<string> last(voices);
+	vector<bool> held(voices, false);
+	for (int i=0; i<length; i++) {
+		if (i == length / 2) {
+			for (int v=0; v<voices; v++) {
+				output << (v ? "\t" : "") << "*M3/8";
+			}
+			output << "\n";
+		}
+		for (int v=0; v<voices; v++) {
+			string token;
+			int choice = random() % 8;
+			if (held[v]) {
+				// second half of a quarter note
+				token = ".";
+				held[v] = false;
+			} else if ((choice == 1) && !last[v].empty() && (last[v] != "r")) {
+				token = "8" + last[v] + "]";
+				last[v].clear();
+			} else {
+				last[v] = pick(random, pitches);
+				held[v] = (choice == 0) && (i < length - 1);
+				token = (held[v] ? "4" : "8") + last[v];
+				if ((last[v] != "r") && (random() % 4 == 0)) {
+					token = "[" + token;
+				}
+			}
+			output << (v ? "\t" : "") << token;
+		}
+		output << "\n";
+	}
+	for (int v=0; v<voices; v++) {
+		output << (v ? "\t" : "") << "*-";
+	}
+	output << "\n";
+	return output.str();
+}
+
+
+// checkGrid: Compare the cells of the grid to the tokens of the score.
+static void checkGrid(NoteGrid& grid, HumdrumFile& infile, const string& name) {
+	int voices = grid.getVoiceCount();
+	int slices = grid.getSliceCount();
+	check(voices == (int)infile.getKernSpineStartList().size(), name + ": wrong voice count");
+	for (int v=0; v<voices; v++) {
+		// Base-40 pitches: NaN=rest, negative=sustain.
+		vector<double> b40(slices);
+		for (int s=0; s<slices; s++) {
+			HTp token = grid.cell(v, s)->getToken();
+			HTp resolve = token->resolveNull();
+			bool sustain = token->isNull() || token->isSecondaryTiedNote();
+			if (token->isRest() || resolve->isRest() || resolve->isNull()) {
+				b40[s] = NAN;
+			} else {
+				b40[s] = Convert::kernToBase40(resolve) * (sustain ? -1 : 1);
+			}
+		}
+		// Attack indexes and tied tokens:
+		vector<int> curr(slices, -1);
+		vector<vector<HTp>> tied(slices);
+		int attack = -1;
+		for (int s=0; s<slices; s++) {
+			HTp token = grid.cell(v, s)->getToken();
+			if (s == 0) {
+				curr[s] = 0;
+			} else if (std::isnan(b40[s])) {
+				curr[s] = std::isnan(b40[s-1]) ? curr[s-1] : s;
+				if (std::isnan(b40[s-1]) && (attack >= 0) && !token->isNull()) {
+					tied[attack].push_back(token);
+				}
+			} else if (b40[s] > 0) {
+				curr[s] = s;
+				attack = s;
+			} else {
+				curr[s] = curr[s-1];
+				if ((attack >= 0) && !token->isNull()) {
+					tied[attack].push_back(token);
+				}
+			}
+		}
+		for (int s=0; s<slices; s++) {
+			NoteCell* cell = grid.cell(v, s);
+			string where = name + ": voice " + to_string(v) + " slice " + to_string(s);
+			bool sustained = (b40[s] < 0) || (!(b40[s] > 0) && (curr[s] != s));
+			int next = -1;
+			for (int k=s+1; k<slices; k++) {
+				if (!((b40[k] < 0) || (!(b40[k] > 0) && (curr[k] != k)))) {
+					next = k;
+					break;
+				}
+			}
+			int prev = -1;
+			for (int k=curr[s]-1; k>=0; k--) {
+				if (curr[k] == k) {
+					prev = k;
+					break;
+				}
+			}
+			int ib40 = (int)fabs(b40[s]);
+			double b7 = NAN;
+			double b12 = NAN;
+			if (b40[s] != 0 && !std::isnan(b40[s])) {
+				b7 = Convert::base40ToDiatonic(ib40) * (b40[s] < 0 ? -1 : 1);
+				b12 = Convert::base40ToMidiNoteNumber(ib40) * (b40[s] < 0 ? -1 : 1);
+			}
+			check(same(cell->getSgnBase40Pitch(), b40[s]), where + ": wrong base-40 pitch");
+			check(same(cell->getSgnDiatonicPitch(), b7), where + ": wrong diatonic pitch");
+			check(same(cell->getSgnMidiPitch(), b12), where + ": wrong MIDI pitch");
+			check(same(grid.getAbsBase40Pitch(v, s), fabs(b40[s])), where + ": wrong grid pitch");
+			check(cell->isRest() == (bool)std::isnan(b40[s]), where + ": wrong rest");
+			check(cell->isAttack() == (b40[s] > 0), where + ": wrong attack");
+			check(cell->isSustained() == sustained, where + ": wrong sustain");
+			check(cell->getCurrAttackIndex() == curr[s], where + ": wrong current attack");
+			check(cell->getNextAttackIndex() == next, where + ": wrong next attack");
+			check(cell->getPrevAttackIndex() == prev, where + ": wrong previous attack");
+			check(cell->getTiedTokens() == tied[s], where + ": wrong tied tokens");
+			check(cell->getVoiceIndex() == v && cell->getSliceIndex() == s, where + ": wrong index");
+			check(cell->getDurationFromStart() == cell->getToken()->getDurationFromStart(),
+					where + ": wrong start time");
+		}
+	}
+	// Meters, for the first voice:
+	if (voices == 0) {
+		return;
+	}
+	int track = grid.cell(0, 0)->getToken()->getTrack();
+	int top = 0;
+	HumNum bot = 0;
+	HumRegex hre;
+	for (int i=0, s=0; i<infile.getLineCount(); i++) {
+		for (int j=0; j<infile[i].getFieldCount(); j++) {
+			HTp token = infile.token(i, j);
+			if (token->getTrack() != track) {
+				continue;
+			}
+			if (token->isTimeSignature() && hre.search(*token, "^\\*M(\\d+)/(\\d+)$")) {
+				top = hre.getMatchInt(1);
+				bot = hre.getMatchInt(2);
+			}
+			break;
+		}
+		if (infile[i].isData()) {
+			check(grid.cell(0, s)->getMeterTop() == top, name + ": wrong meter top");
+			check(grid.cell(0, s)->getMeterBottom() == bot, name + ": wrong meter bottom");
+			s++;
+		}
+	}
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("g|generate=i:50", "number of random files to generate");
+	options.define("n|count=i:10", "number of times to load each grid for timing");
+	options.process(argc, argv);
+
+	vector<string> files;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		HumdrumFile infile(options.getArg(i));
+		stringstream text;
+		text << infile;
+		files.push_back(text.str());
+	}
+	mt19937 random(1);
+	for (int i=0; i<options.getInteger("generate"); i++) {
+		files.push_back(generateFile(random, 1 + i % 5, 400));
+	}
+
+	double loadMs = 0.0;
+	double readMs = 0.0;
+	double sum = 0.0;
+	size_t bytes = 0;
+	long long cells = 0;
+	long long slices = 0;
+	for (int i=0; i<(int)files.size(); i++) {
+		HumdrumFile infile;
+		infile.readString(files[i]);
+		if (infile.getKernSpineStartList().empty()) {
+			continue;
+		}
+		NoteGrid grid;
+		bool loaded = true;
+		auto start = chrono::steady_clock::now();
+		for (int j=0; j<options.getInteger("count"); j++) {
+			loaded = grid.load(infile);
+		}
+		if (!loaded) {
+			// for example, a file with spine splits
+			continue;
+		}
+		auto middle = chrono::steady_clock::now();
+		for (int j=0; j<options.getInteger("count"); j++) {
+			for (int v=0; v<grid.getVoiceCount(); v++) {
+				for (int s=0; s<grid.getSliceCount(); s++) {
+					NoteCell* cell = grid.cell(v, s);
+					if (!cell->isRest()) {
+						sum += cell->getAbsDiatonicPitch() + cell->getNextAttackIndex();
+					}
+				}
+			}
+		}
+		auto stop = chrono::steady_clock::now();
+		loadMs += chrono::duration<double, milli>(middle - start).count();
+		readMs += chrono::duration<double, milli>(stop - middle).count();
+		checkGrid(grid, infile, "file " + to_string(i + 1));
+		bytes += grid.getStorageSize();
+		cells += (long long)grid.getVoiceCount() * grid.getSliceCount();
+		slices += grid.getSliceCount();
+	}
+
+	cout << "files=" << files.size()
+	     << "\tslices=" << slices
+	     << "\tbytesPerCell=" << (cells ? (double)bytes / cells : 0.0)
+	     << "\tbytesPerSlice=" << (slices ? (double)bytes / slices : 0.0)
+	     << "\tloadMs=" << loadMs
+	     << "\treadMs=" << readMs
+	     << "\tsum=" << sum << endl;
+	return status;
+}
+
+
+
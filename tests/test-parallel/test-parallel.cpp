@@ -0,0 +1,77 @@
+// Description: Read a list of files one at a time and then in parallel
+//              with HumdrumFileSet, verifying that both sets contain the
+//              same segments in the same order with the same analyses
+//              done, and timing both methods.
+//
+// Usage:       test-parallel [-j threads] file.krn [file2.krn ...]
+
+#include "humlib.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("j|threads=i:0", "number of threads (0 = all cores)");
+	options.process(argc, argv);
+
+	vector<string> filenames;
+	options.getArgList(filenames);
+
+	HumdrumFileSet serial;
+	serial.setReadAnalyses(HumFileAnalysis::ReadDefault);
+	auto start = chrono::steady_clock::now();
+	serial.read(options);
+	auto middle = chrono::steady_clock::now();
+
+	HumdrumFileSet parallel;
+	parallel.setThreadCount(options.getInteger("threads"));
+	parallel.setReadAnalyses(HumFileAnalysis::ReadDefault);
+	parallel.readParallel(filenames);
+	auto stop = chrono::steady_clock::now();
+
+	int status = 0;
+	if (serial.getSize() != parallel.getSize()) {
+		cerr << "Segment counts differ: " << serial.getSize()
+		     << " serial, " << parallel.getSize() << " parallel" << endl;
+		status = 1;
+	}
+	int count = min(serial.getSize(), parallel.getSize());
+	for (int i=0; i<count; i++) {
+		stringstream a;
+		stringstream b;
+		a << serial[i];
+		b << parallel[i];
+		for (int type=0; type<HumFileAnalysis::Count; type++) {
+			if (serial[i].isAnalyzed(type) != parallel[i].isAnalyzed(type)) {
+				cerr << "Segment " << i << " analysis " << HumFileAnalysis::getName(type)
+				     << " differs (" << serial[i].getFilename() << ")" << endl;
+				status = 1;
+			}
+		}
+		if ((a.str() != b.str()) ||
+				(serial[i].getScoreDuration() != parallel[i].getScoreDuration())) {
+			cerr << "Segment " << i << " differs (" << serial[i].getFilename()
+			     << ")" << endl;
+			status = 1;
+		}
+	}
+	vector<string> errors = parallel.getParseErrors();
+	for (int i=0; i<(int)errors.size(); i++) {
+		cerr << "Error: " << errors[i] << endl;
+	}
+
+	cout << "files=" << filenames.size()
+	     << "\tsegments=" << parallel.getSize()
+	     << "\tserialTime="
+	     << chrono::duration<double, milli>(middle - start).count() << "ms"
+	     << "\tparallelTime="
+	     << chrono::duration<double, milli>(stop - middle).count() << "ms"
+	     << endl;
+	return status;
+}
+
+
+
@@ -0,0 +1,97 @@
+// Description: Count memory allocations and peak memory use while
+//              reading and clearing Humdrum files, in order to measure
+//              the effect of HumPool on HumdrumLine and HumdrumToken
+//              storage, and the slabs released by HumPool::trim()
+//              afterwards.  Compile src/HumPool.cpp with HUMLIB_NO_POOL
+//              to compare with the system allocator.
+//
+// Usage:       test-pool [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include <sys/resource.h>
+
+using namespace hum;
+using namespace std;
+
+static atomic<size_t> Allocations(0);
+static atomic<size_t> Deallocations(0);
+
+void* operator new(size_t size) {
+	Allocations++;
+	void* ptr = malloc(size ? size : 1);
+	if (!ptr) {
+		throw bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+	if (ptr) {
+		Deallocations++;
+	}
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t size) noexcept {
+	if (ptr) {
+		Deallocations++;
+	}
+	free(ptr);
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:3", "number of times to read each file");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		HumdrumFile infile;
+		size_t readAllocations = 0;
+		size_t clearDeallocations = 0;
+		double readTime = 0.0;
+		double clearTime = 0.0;
+		for (int j=0; j<count; j++) {
+			size_t a = Allocations;
+			auto start = chrono::steady_clock::now();
+			infile.read(filename);
+			auto middle = chrono::steady_clock::now();
+			readAllocations = Allocations - a;
+			size_t d = Deallocations;
+			infile.clear();
+			auto stop = chrono::steady_clock::now();
+			clearDeallocations = Deallocations - d;
+			readTime += chrono::duration<double, milli>(middle - start).count();
+			clearTime += chrono::duration<double, milli>(stop - middle).count();
+		}
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		cout << filename
+		     << "\treadAllocations=" << readAllocations
+		     << "\tclearDeallocations=" << clearDeallocations
+		     << "\treadTime=" << readTime / count << "ms"
+		     << "\tclearTime=" << clearTime / count << "ms"
+		     << "\tpeakRSS=" << usage.ru_maxrss << "kB"
+		     << "\tslabs=" << HumPool::getSlabCount()
+		     << endl;
+	}
+
+	// All files have been deleted, so their slabs can be released:
+	size_t slabs = HumPool::getSlabCount();
+	size_t released = HumPool::trim();
+	cout << "trim"
+	     << "\treleased=" << released
+	     << "\tslabs=" << HumPool::getSlabCount()
+	     << endl;
+	return ((slabs > 0) && (released == 0)) ? 1 : 0;
+}
+
+
@@ -0,0 +1,122 @@
+// Description: Compare HumdrumFileBase::read() through an input stream
+//              (std::getline) with the memory-mapped/buffer read path,
+//              verifying that both produce identical lines and tokens
+//              and timing the two methods.
+//
+// Usage:       test-readbuffer [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+bool   compareFiles     (HumdrumFileBase& a, HumdrumFileBase& b);
+double timeStreamRead   (const string& filename, int count);
+double timeMappedRead   (const string& filename, int count);
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:10", "number of times to read each file");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	int status = 0;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		ifstream input(filename);
+		HumdrumFileBase streamfile;
+		streamfile.read(input);
+		HumdrumFileBase mappedfile;
+		mappedfile.read(filename);
+		bool same = compareFiles(streamfile, mappedfile);
+		if (!same) {
+			status = 1;
+		}
+		double streamtime = timeStreamRead(filename, count);
+		double mappedtime = timeMappedRead(filename, count);
+		cout << filename << "\t" << (same ? "SAME" : "DIFFERENT")
+		     << "\tlines=" << mappedfile.getLineCount()
+		     << "\tgetline=" << streamtime << "ms"
+		     << "\tmmap=" << mappedtime << "ms"
+		     << "\tspeedup=" << (mappedtime > 0.0 ? streamtime / mappedtime : 0.0)
+		     << endl;
+	}
+	return status;
+}
+
+
+
+//////////////////////////////
+//
+// compareFiles -- Check that lines and tokens match between two files.
+//
+
+bool compareFiles(HumdrumFileBase& a, HumdrumFileBase& b) {
+	if (a.getLineCount() != b.getLineCount()) {
+		cerr << "Line counts differ: " << a.getLineCount() << " vs. "
+		     << b.getLineCount() << endl;
+		return false;
+	}
+	for (int i=0; i<a.getLineCount(); i++) {
+		if (a[i].getText() != b[i].getText()) {
+			cerr << "Line " << i+1 << " differs" << endl;
+			return false;
+		}
+		if (a[i].getFieldCount() != b[i].getFieldCount()) {
+			cerr << "Field counts on line " << i+1 << " differ" << endl;
+			return false;
+		}
+		for (int j=0; j<a[i].getFieldCount(); j++) {
+			if (*a.token(i, j) != *b.token(i, j)) {
+				cerr << "Token " << j+1 << " on line " << i+1 << " differs" << endl;
+				return false;
+			}
+			if (a.token(i, j)->getSpineInfo() != b.token(i, j)->getSpineInfo()) {
+				cerr << "Spine info of token " << j+1 << " on line " << i+1
+				     << " differs" << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// timeStreamRead -- Average milliseconds to read a file through std::getline.
+//
+
+double timeStreamRead(const string& filename, int count) {
+	auto start = chrono::steady_clock::now();
+	for (int i=0; i<count; i++) {
+		ifstream input(filename);
+		HumdrumFileBase infile;
+		infile.read(input);
+	}
+	auto stop = chrono::steady_clock::now();
+	return chrono::duration<double, milli>(stop - start).count() / count;
+}
+
+
+
+//////////////////////////////
+//
+// timeMappedRead -- Average milliseconds to read a file by memory mapping.
+//
+
+double timeMappedRead(const string& filename, int count) {
+	auto start = chrono::steady_clock::now();
+	for (int i=0; i<count; i++) {
+		HumdrumFileBase infile;
+		infile.read(filename);
+	}
+	auto stop = chrono::steady_clock::now();
+	return chrono::duration<double, milli>(stop - start).count() / count;
+}
+
+
@@ -0,0 +1,169 @@
+// Description: Check that HumRegex gives the same results with literal
+//              matching and the compiled-expression cache as with plain
+//              std::regex, and time tools which make heavy use of HumRegex
+//              (tandeminfo, myank, modori, gasparize) with and without the
+//              cache.
+//
+// Usage:       test-regexcache [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// Expressions taken from tools (literal, anchored-literal and general ones):
+static vector<string> patterns = {
+	"^\\*I", "^\\*IC", "^\\*I([a-z].*)", "^\\*M", "^\\*k\\[", "\\]$", "^\\[",
+	"^\\*", ":$", ":", "^!!!", "^=", "=", "(=)", "^(=)$", "^\\*\\*kern$",
+	"^\\*bstyle:", "stop", "n", "#", "-", "X(?!X)", "[-#n][Xy]", "q", "qq",
+	"L", "J", "\\[", "\\(", "^\\.$", "\\.", "^\\s*$", "r",
+	"([a-g]+)([-#n]*)", "^\\*>", "\\d+", "^\\*\\^$", "4", "^4", "4$", "",
+	"^$", "^!", "^!LO:", "!LO:TX", "x", "^\\*v$"
+};
+
+// Replacement strings for the replace tests:
+static vector<string> replacements = { "", "Z", "$&$&", "[$1]", "ab" };
+
+
+// describeSearch: The results of a search in a form that can be compared.
+static string describeSearch(HumRegex& hre, int result) {
+	stringstream out;
+	out << result;
+	if (!result) {
+		return out.str();
+	}
+	out << "|" << hre.getMatchCount() << "|" << hre.getPrefix() << "|"
+	    << hre.getSuffix();
+	for (int i=0; i<hre.getMatchCount(); i++) {
+		out << "|" << hre.getMatch(i) << "@" << hre.getMatchStartIndex(i)
+		    << ":" << hre.getMatchLength(i) << ":" << hre.getMatchEndIndex(i);
+	}
+	return out.str();
+}
+
+
+// describeRegex: The results of searching, matching and replacing the
+//     expression in the input string.
+static string describeRegex(const string& input, const string& exp) {
+	stringstream out;
+	HumRegex hre;
+	out << describeSearch(hre, hre.search(input, exp)) << "\n";
+	out << describeSearch(hre, hre.search(input, exp, "g")) << "\n";
+	if (input.size() > 1) {
+		out << describeSearch(hre, hre.search(input, 1, exp)) << "\n";
+	}
+	out << hre.match(input, exp) << "\n";
+	for (auto& replacement : replacements) {
+		string copy = input;
+		out << hre.replaceDestructive(copy, replacement, exp) << "\n";
+		copy = input;
+		out << hre.replaceDestructive(copy, replacement, exp, "g") << "\n";
+		out << hre.replaceCopy(input, replacement, exp) << "\n";
+	}
+	return out.str();
+}
+
+
+// runTool: Run a tool on a copy of the file and return all of its output
+//     (or the exception message if the tool cannot process the file).
+template <class TOOL>
+static string runTool(HumdrumFile& infile, const string& command) {
+	stringstream text;
+	text << infile;
+	HumdrumFile copy;
+	copy.readString(text.str());
+	TOOL tool;
+	tool.process(command);
+	try {
+		tool.run(copy);
+	} catch (exception& e) {
+		return command + ": " + e.what() + "\n";
+	}
+	return tool.getAllText() + tool.getError();
+}
+
+
+// runTools: Run the tools which use HumRegex the most, returning their
+//     output and the time in milliseconds that it took.  myank is only
+//     run on files with measure numbers (otherwise it exits).
+static string runTools(HumdrumFile& infile, int count, double& ms) {
+	int measures = 0;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (infile[i].isBarline() && (infile[i].getBarNumber() > 0)) {
+			measures++;
+		}
+	}
+	string output;
+	auto start = chrono::steady_clock::now();
+	for (int i=0; i<count; i++) {
+		output  = runTool<Tool_tandeminfo>(infile, "tandeminfo");
+		if (measures > 1) {
+			output += runTool<Tool_myank>(infile, "myank -m 1-4");
+		}
+		output += runTool<Tool_modori>(infile, "modori");
+		output += runTool<Tool_gasparize>(infile, "gasparize");
+	}
+	auto stop = chrono::steady_clock::now();
+	ms = chrono::duration<double, milli>(stop - start).count() / count;
+	return output;
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:5", "number of runs for timing");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		HumdrumFile infile(filename);
+
+		// Every line and token against every expression:
+		vector<string> inputs;
+		for (int j=0; j<infile.getLineCount(); j++) {
+			inputs.push_back(infile[j].getText());
+			for (int k=0; k<infile[j].getFieldCount(); k++) {
+				inputs.push_back(*infile.token(j, k));
+			}
+		}
+		inputs.push_back("");
+		int differences = 0;
+		for (auto& input : inputs) {
+			for (auto& exp : patterns) {
+				HumRegex::setLiteralMatching(false);
+				HumRegex::setCacheSize(0);
+				string expected = describeRegex(input, exp);
+				HumRegex::setLiteralMatching(true);
+				HumRegex::setCacheSize(512);
+				string result = describeRegex(input, exp);
+				if (result != expected) {
+					if (differences++ < 5) {
+						check(false, filename, "different results for \"" + exp +
+								"\" on \"" + input + "\":\n" + expected + "--\n" + result);
+					}
+				}
+			}
+		}
+		check(differences == 0, filename, to_string(differences) +
+				" expression results differ");
+
+		HumRegex::setLiteralMatching(false);
+		HumRegex::setCacheSize(0);
+		double plainMs;
+		string expected = runTools(infile, count, plainMs);
+		HumRegex::setLiteralMatching(true);
+		HumRegex::setCacheSize(512);
+		double cachedMs;
+		string result = runTools(infile, count, cachedMs);
+		check(result == expected, filename, "tool output differs with cache");
+		cout << filename
+		     << "\tstdRegexMs=" << plainMs
+		     << "\tcachedMs=" << cachedMs
+		     << endl;
+	}
+	return status;
+}
@@ -0,0 +1,267 @@
+// Description: Check that HumToolServer gives the same output for requests
+//              sent on a socket (by filename and with inline data, from
+//              several client threads at once) as the filter tool gives
+//              for the same pipelines, that changed files are not read
+//              from the file cache, that tools do not print to the
+//              standard output of the server, and time requests to the
+//              server compared to reading and filtering each file in the
+//              client.
+//
+// Usage:       test-server [-c clients] [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace hum;
+using namespace std;
+
+// Pipelines run on each file:
+static vector<string> pipelines = {
+	"autobeam | autostem",
+	"transpose -t M2 | autobeam",
+	"recip",
+	"thru",
+	""
+};
+
+
+// filterText: Return the output of the filter tool for a pipeline,
+//     without the (disabled) filter line.
+static string filterText(const string& text, const string& pipeline) {
+	HumdrumFile infile;
+	infile.readString(text + "!!!filter: " + pipeline + "\n");
+	Tool_filter filter;
+	filter.process("filter");
+	filter.run(infile);
+	stringstream output;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		if (infile[i].getText().compare(0, 10, "!!!Xfilter") != 0) {
+			output << infile[i] << "\n";
+		}
+	}
+	return output.str();
+}
+
+
+// readText: Return the contents of a file.
+static string readText(const string& filename) {
+	ifstream input(filename);
+	stringstream text;
+	text << input.rdbuf();
+	return text.str();
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("c|clients=i:4", "number of client threads");
+	options.define("n|count=i:20", "number of requests per file for timing");
+	options.process(argc, argv);
+	int clients = options.getInteger("clients");
+	int count = options.getInteger("count");
+
+	string socketpath = "/tmp/test-server-" + to_string((long long)getpid()) + ".sock";
+	HumToolServer server;
+	std::thread serving([&server, &socketpath]() { server.serve(socketpath, 0); });
+
+	// Wait for the server to start listening:
+	HumToolServer::Request request;
+	HumToolServer::Response response;
+	request.command = "stats";
+	for (int i=0; i<100; i++) {
+		if (HumToolServer::sendRequest(socketpath, request, response)) {
+			break;
+		}
+		this_thread::sleep_for(chrono::milliseconds(20));
+	}
+	check(response.status, "cannot connect to the server: " + response.error);
+
+	// Requests for each file and pipeline, with the expected output:
+	vector<HumToolServer::Request> requests;
+	vector<string> expected;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		string text = readText(filename);
+		for (auto& pipeline : pipelines) {
+			HumToolServer::Request request;
+			request.tools = pipeline;
+			request.filename = filename;
+			requests.push_back(request);
+			expected.push_back(filterText(text, pipeline));
+			request.filename.clear();
+			request.data = text;
+			requests.push_back(request);
+			expected.push_back(expected.back());
+		}
+	}
+
+	// Send the requests from several threads at once (twice, so that the
+	// second requests for each file use the file cache):
+	vector<string> results(requests.size());
+	vector<std::thread> threads;
+	for (int c=0; c<clients; c++) {
+		threads.emplace_back([&requests, &results, &socketpath, c, clients]() {
+			for (int r=0; r<2; r++) {
+				for (int i=c; i<(int)requests.size(); i+=clients) {
+					HumToolServer::Response response;
+					HumToolServer::sendRequest(socketpath, requests[i], response);
+					results[i] = response.humdrum + response.error;
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (int i=0; i<(int)requests.size(); i++) {
+		string source = requests[i].filename.empty() ? "data" : requests[i].filename;
+		check(results[i] == expected[i], source + ": \"" + requests[i].tools +
+				"\" output differs from filter output");
+	}
+	check(server.getFileCache().getHitCount() > 0, "no files read from the cache");
+
+	// Free text is returned separately from the Humdrum data:
+	if (options.getArgCount() > 0) {
+		HumdrumFile infile(options.getArg(1));
+		Tool_tandeminfo tandeminfo;
+		tandeminfo.process("tandeminfo");
+		tandeminfo.run(infile);
+		request = HumToolServer::Request();
+		request.tools = "tandeminfo";
+		request.filename = options.getArg(1);
+		HumToolServer::sendRequest(socketpath, request, response);
+		check(response.humdrum.empty(), "tandeminfo returned Humdrum data");
+		check(response.text == tandeminfo.getFreeText(), "tandeminfo text differs");
+	}
+
+	// Errors are returned rather than ending the server:
+	request = HumToolServer::Request();
+	request.tools = "autobeam | no-such-tool";
+	request.data = "**kern\n4c\n*-\n";
+	check(!HumToolServer::sendRequest(socketpath, request, response), "unknown tool succeeded");
+	check(response.error.find("no-such-tool") != string::npos, "no error for unknown tool");
+	request.tools = "autobeam --no-such-option";
+	check(HumToolServer::sendRequest(socketpath, request, response), "unknown option failed");
+	request.filename = "/no/such/file.krn";
+	check(!HumToolServer::sendRequest(socketpath, request, response), "missing file succeeded");
+
+	// Tool errors which used to exit the program:
+	request = HumToolServer::Request();
+	for (string tools : {"myank -m 1", "transpose -d 1", "myank -m 99", "transpose --help"}) {
+		request.tools = tools;
+		request.data = (tools == "myank -m 99") ? "**kern\n=1\n4c\n=2\n4d\n*-\n" : "**kern\n4c\n4d\n*-\n";
+		HumToolServer::sendRequest(socketpath, request, response);
+		HumToolServer::Request stats;
+		stats.command = "stats";
+		HumToolServer::Response answer;
+		check(HumToolServer::sendRequest(socketpath, stats, answer),
+				"server stopped answering after \"" + tools + "\"");
+	}
+	request.tools = "myank -m 1";
+	check(!HumToolServer::sendRequest(socketpath, request, response), "myank without measures succeeded");
+	check(response.error.find("no measure numbers") != string::npos, "no error for myank without measures");
+
+	// Tools print their output into the response rather than to the
+	// standard output of the server:
+	stringstream console;
+	streambuf* consolebuf = cout.rdbuf(console.rdbuf());
+	request = HumToolServer::Request();
+	request.data = "**kern\t**kern\n4c\t4e\n4d\t4f\n*-\t*-\n";
+	for (string tools : {"cint", "rmask -k 1", "msearch -p c --debug", "cmr"}) {
+		request.tools = tools;
+		HumToolServer::sendRequest(socketpath, request, response);
+	}
+	cout.rdbuf(consolebuf);
+	check(console.str().empty(), "tools printed to the standard output: " + console.str());
+
+	// Connections which are kept open do not keep other connections from
+	// being answered, even when there are more of them than worker threads
+	// (end the test if a request is not answered):
+	std::atomic<bool> answered(false);
+	std::thread watchdog([&answered]() {
+		for (int i=0; (i<1000) && !answered; i++) {
+			this_thread::sleep_for(chrono::milliseconds(20));
+		}
+		if (!answered) {
+			cerr << "request on an open connection was not answered" << endl;
+			_exit(1);
+		}
+	});
+	int connections = HumThreadPool::getHardwareThreadCount() + 2;
+	vector<std::unique_ptr<HumToolServer::Client>> persistent;
+	request = HumToolServer::Request();
+	request.tools = "recip";
+	request.data = "**kern\n4c\n*-\n";
+	string recip = filterText(request.data, request.tools);
+	for (int r=0; r<3; r++) {
+		for (int i=0; i<connections; i++) {
+			if (r == 0) {
+				persistent.emplace_back(new HumToolServer::Client);
+				string error;
+				check(persistent.back()->connect(socketpath, error), "cannot connect: " + error);
+			}
+			persistent[i]->send(request, response);
+			check(response.humdrum == recip, "wrong output on open connection " + to_string(i));
+		}
+	}
+	persistent.clear();
+	answered = true;
+	watchdog.join();
+
+	// A changed file is read again rather than taken from the cache:
+	string tempname = socketpath + ".krn";
+	request = HumToolServer::Request();
+	request.filename = tempname;
+	ofstream(tempname) << "**kern\n4c\n*-\n";
+	HumToolServer::sendRequest(socketpath, request, response);
+	check(response.humdrum == "**kern\n4c\n*-\n", "wrong output for temporary file");
+	ofstream(tempname) << "**kern\n4dd\n*-\n";
+	HumToolServer::sendRequest(socketpath, request, response);
+	check(response.humdrum == "**kern\n4dd\n*-\n", "changed file read from the cache");
+	remove(tempname.c_str());
+
+	// Time requests to the server and reading/filtering in the client:
+	double serverMs = 0.0;
+	double clientMs = 0.0;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		request = HumToolServer::Request();
+		request.tools = pipelines[0];
+		request.filename = options.getArg(i);
+		auto start = chrono::steady_clock::now();
+		for (int j=0; j<count; j++) {
+			HumToolServer::sendRequest(socketpath, request, response);
+		}
+		auto middle = chrono::steady_clock::now();
+		for (int j=0; j<count; j++) {
+			HumdrumFile infile(options.getArg(i));
+			Tool_filter filter;
+			filter.process("filter");
+			filter.runPipeline(infile, pipelines[0]);
+		}
+		auto stop = chrono::steady_clock::now();
+		serverMs += chrono::duration<double, milli>(middle - start).count();
+		clientMs += chrono::duration<double, milli>(stop - middle).count();
+	}
+
+	request = HumToolServer::Request();
+	request.command = "stop";
+	HumToolServer::sendRequest(socketpath, request, response);
+	serving.join();
+
+	int files = options.getArgCount() > 0 ? options.getArgCount() : 1;
+	cout << "requests=" << requests.size() * 2
+	     << "\tserverMs=" << serverMs / count / files
+	     << "\tclientMs=" << clientMs / count / files
+	     << "\t" << server.getStatistics();
+	return status;
+}
+
+
+
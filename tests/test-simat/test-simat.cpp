@@ -0,0 +1,179 @@
+// Description: Check the correlations calculated by MeasureCorrelationMatrix
+//              against MeasureComparison::compare() for every pair of
+//              measures in generated scores, with one thread and with
+//              several threads, and for one file compared to many files.
+//              The time for the old and new calculation is also printed.
+//
+// Usage:       test-simat [-g count] [-m measures] [-j threads] [file.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+#include <cmath>
+
+using namespace hum;
+using namespace std;
+
+// close: Return true if two correlations are equal within rounding,
+//     or both NaN.
+static bool close(double a, double b) {
+	if (std::isnan(a) || std::isnan(b)) {
+		return std::isnan(a) && std::isnan(b);
+	}
+	return fabs(a - b) < 1e-9;
+}
+
+
+// generateFile: Return a random two-voice file with the given number of
+//     measures, some of which contain only rests.
+static string generateFile(mt19937& random, int measures) {
+	static vector<string> pitches = {"c", "d", "e", "f", "g", "a", "b", "cc",
+			"e-", "f#", "B", "A", "G", "r"};
+	stringstream output;
+	output << "**kern\t**kern\n*M4/4\t*M4/4\n";
+	for (int m=1; m<=measures; m++) {
+		output << "=" << m << "\t=" << m << "\n";
+		bool rests = random() % 10 == 0;
+		for (int i=0; i<4; i++) {
+			for (int v=0; v<2; v++) {
+				output << (v ? "\t" : "") << "4";
+				output << (rests ? "r" : pick(random, pitches));
+			}
+			output << "\n";
+		}
+	}
+	output << "==\t==\n*-\t*-\n";
+	return output.str();
+}
+
+
+// checkGrid: Compare each correlation of two sets with the value from
+//     MeasureComparison.
+static void checkGrid(MeasureCorrelationMatrix& matrix, int column,
+		MeasureDataSet& set1, MeasureDataSet& set2, const string& name) {
+	MeasureComparison comparison;
+	for (int i=0; i<set1.size(); i++) {
+		for (int j=0; j<set2.size(); j++) {
+			comparison.compare(set1[i], set2[j]);
+			double expected = comparison.getCorrelation7pc();
+			double actual = matrix.getCorrelation(i, column + j);
+			if (!close(expected, actual)) {
+				check(false, name + ": measures " + to_string(i) + "," + to_string(j)
+						+ " expected " + to_string(expected) + " got " + to_string(actual));
+				return;
+			}
+		}
+	}
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("g|generate=i:8", "number of random files to generate");
+	options.define("m|measures=i:300", "number of measures in each random file");
+	options.define("j|jobs=i:4", "number of threads for the parallel matrix");
+	options.process(argc, argv);
+
+	vector<string> files;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		HumdrumFile infile(options.getArg(i));
+		stringstream text;
+		text << infile;
+		files.push_back(text.str());
+	}
+	mt19937 random(1);
+	for (int i=0; i<options.getInteger("generate"); i++) {
+		files.push_back(generateFile(random, options.getInteger("measures")));
+	}
+
+	vector<HumdrumFile> infiles(files.size());
+	vector<MeasureDataSet> sets(files.size());
+	for (int i=0; i<(int)files.size(); i++) {
+		infiles[i].readString(files[i]);
+		sets[i].parse(infiles[i]);
+	}
+
+	double oldMs = 0.0;
+	double newMs = 0.0;
+	double parallelMs = 0.0;
+	long long cells = 0;
+	for (int i=0; i<(int)files.size(); i++) {
+		string name = "file " + to_string(i + 1);
+		MeasureCorrelationMatrix matrix;
+		matrix.setRows(sets[i]);
+		matrix.addColumns(sets[i]);
+
+		auto start = chrono::steady_clock::now();
+		MeasureComparison comparison;
+		double sum = 0.0;
+		for (int r=0; r<sets[i].size(); r++) {
+			for (int c=0; c<sets[i].size(); c++) {
+				comparison.compare(sets[i][r], sets[i][c]);
+				sum += comparison.getCorrelation7pc();
+			}
+		}
+		auto middle = chrono::steady_clock::now();
+		matrix.analyze(1);
+		auto stop = chrono::steady_clock::now();
+		checkGrid(matrix, 0, sets[i], sets[i], name);
+		check(!(sum > 1e300), name + ": overflow");
+
+		auto pstart = chrono::steady_clock::now();
+		matrix.analyze(options.getInteger("jobs"));
+		auto pstop = chrono::steady_clock::now();
+		checkGrid(matrix, 0, sets[i], sets[i], name + " (parallel)");
+
+		oldMs += chrono::duration<double, milli>(middle - start).count();
+		newMs += chrono::duration<double, milli>(stop - middle).count();
+		parallelMs += chrono::duration<double, milli>(pstop - pstart).count();
+		cells += (long long)sets[i].size() * sets[i].size();
+	}
+
+	// The first file compared to all files in one matrix:
+	if (!sets.empty()) {
+		MeasureCorrelationMatrix many;
+		many.setRows(sets[0]);
+		vector<int> columns;
+		for (int i=0; i<(int)sets.size(); i++) {
+			columns.push_back(many.addColumns(sets[i]));
+		}
+		many.analyze(options.getInteger("jobs"));
+		for (int i=0; i<(int)sets.size(); i++) {
+			checkGrid(many, columns[i], sets[0], sets[i], "many " + to_string(i + 1));
+		}
+	}
+
+	// The grid printed by simat should match MeasureComparison (values
+	// exactly halfway between two hundredths may round differently, and
+	// measures with a flat histogram have no correlation):
+	if (!files.empty()) {
+		Tool_simat simat;
+		simat.process("simat -r");
+		simat.run(infiles[0], infiles[0]);
+		stringstream text(simat.getAllText());
+		MeasureComparison comparison;
+		int count = 0;
+		for (int r=0; r<sets[0].size(); r++) {
+			for (int c=0; c<sets[0].size(); c++) {
+				double value = 0.0;
+				if (!(text >> value)) {
+					break;
+				}
+				comparison.compare(sets[0][r], sets[0][c]);
+				double correl = comparison.getCorrelation7pc();
+				if (std::isnan(correl) || (fabs(value - correl) <= 0.005 + 1e-9)) {
+					count++;
+				}
+			}
+		}
+		check(count == sets[0].size() * sets[0].size(), "simat -r: output differs");
+	}
+
+	cout << "files=" << files.size()
+	     << "\tcells=" << cells
+	     << "\toldMs=" << oldMs
+	     << "\tnewMs=" << newMs
+	     << "\tparallelMs=" << parallelMs << endl;
+	return status;
+}
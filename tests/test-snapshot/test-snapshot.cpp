@@ -0,0 +1,181 @@
+// Description: Check that a file loaded from a snapshot in the cache
+//              directory has the same structure, rhythm and slur/tie
+//              analyses as the file parsed from its text, and time
+//              parsing the file against loading it from the snapshot.
+//
+// Usage:       test-snapshot [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace hum;
+using namespace std;
+
+// location: Line and field of a token, for comparing links between files.
+static string location(HTp token) {
+	if (token == NULL) {
+		return "null";
+	}
+	return to_string(token->getLineIndex()) + ":" + to_string(token->getFieldIndex());
+}
+
+
+// describeToken: The analyses of a token in a form that can be compared
+//     between two files.
+static string describeToken(HTp token) {
+	stringstream out;
+	out << *token << "|" << token->getSpineInfo() << "|" << token->getTrack()
+	    << "." << token->getSubtrack()
+	    << "|" << token->getDataType() << "|" << token->getDuration()
+	    << "|" << token->getStrandIndex() << "|" << location(token->resolveNull());
+	for (int i=0; i<token->getNextTokenCount(); i++) {
+		out << "|n" << location(token->getNextToken(i));
+	}
+	for (int i=0; i<token->getPreviousTokenCount(); i++) {
+		out << "|p" << location(token->getPreviousToken(i));
+	}
+	for (int i=0; i<token->getNextNonNullDataTokenCount(); i++) {
+		out << "|N" << location(token->getNextNonNullDataToken(i));
+	}
+	if (token->isKern()) {
+		out << "|s" << location(token->getSlurEndToken())
+		    << "|t" << location(token->getValueHTp("auto", "tieEnd"))
+		    << "|b" << location(token->getValueHTp("auto", "beamStartId"));
+	}
+	return out.str();
+}
+
+
+// describeFile: The analyses of a file in a form that can be compared
+//     between two files.
+static string describeFile(HumdrumFile& infile) {
+	stringstream out;
+	out << infile;
+	out << infile.getScoreDuration() << "\t" << infile.getMaxTrack() << "\t"
+	    << infile.getStrandCount() << "\t" << infile.tpq() << "\n";
+	for (int i=0; i<infile.getLineCount(); i++) {
+		out << infile[i].getDurationFromStart() << "\t"
+		    << infile[i].getDuration() << "\t" << infile[i].getBeat() << "\n";
+		for (int j=0; j<infile[i].getFieldCount(); j++) {
+			out << describeToken(infile.token(i, j)) << "\n";
+		}
+	}
+	return out.str();
+}
+
+
+// averageReadTime: Average time in milliseconds to read the file.
+static double averageReadTime(const string& filename, unsigned analyses, int count) {
+	double total = 0.0;
+	for (int i=0; i<count; i++) {
+		HumdrumFile infile;
+		infile.setReadAnalyses(analyses);
+		auto start = chrono::steady_clock::now();
+		infile.read(filename);
+		auto stop = chrono::steady_clock::now();
+		total += chrono::duration<double, milli>(stop - start).count();
+	}
+	return total / count;
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:5", "number of reads for timing");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	char directory[] = "/tmp/test-snapshot-XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		cerr << "Cannot create cache directory" << endl;
+		return 1;
+	}
+
+	unsigned analyses = HumFileAnalysis::ReadDefault |
+			HumFileAnalysis::getMask(HumFileAnalysis::Slurs) |
+			HumFileAnalysis::getMask(HumFileAnalysis::Ties) |
+			HumFileAnalysis::getMask(HumFileAnalysis::Beams);
+
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		ifstream input(filename);
+		stringstream contents;
+		contents << input.rdbuf();
+
+		HumSnapshot::setCacheDirectory("");
+		HumdrumFile parsed;
+		parsed.setReadAnalyses(analyses);
+		parsed.read(filename);
+		vector<bool> states(HumFileAnalysis::Count);
+		for (int type=0; type<HumFileAnalysis::Count; type++) {
+			states[type] = parsed.isAnalyzed(type);
+		}
+		string expected = describeFile(parsed);
+
+		// The first read saves the snapshot, and the second one loads it:
+		HumSnapshot::setCacheDirectory(directory);
+		HumdrumFile first;
+		first.setReadAnalyses(analyses);
+		first.read(filename);
+		uint64_t key = HumSnapshot::getContentKey(contents.str().data(),
+				contents.str().size());
+		string snapshot = HumSnapshot::getCacheFilename(key, analyses);
+		check(ifstream(snapshot).good(), filename, "snapshot was not saved");
+		check(describeFile(first) == expected, filename,
+				"file which saved the snapshot does not match");
+
+		HumdrumFile loaded;
+		loaded.setReadAnalyses(analyses);
+		loaded.read(filename);
+		for (int type=0; type<HumFileAnalysis::Count; type++) {
+			check(loaded.isAnalyzed(type) == states[type], filename,
+					string("analysis state does not match for ")
+					+ HumFileAnalysis::getName(type));
+		}
+		check(describeFile(loaded) == expected, filename,
+				"file loaded from snapshot does not match");
+
+		// A snapshot is not used for a different list of read analyses:
+		HumdrumFile other;
+		other.setReadAnalyses(HumFileAnalysis::ReadDefault);
+		other.read(filename);
+		check(!other.isAnalyzed(HumFileAnalysis::Slurs), filename,
+				"snapshot used for a different list of analyses");
+
+		// A damaged snapshot is ignored and the file is parsed instead:
+		string data;
+		{
+			ifstream saved(snapshot, ios::binary);
+			stringstream buffer;
+			buffer << saved.rdbuf();
+			data = buffer.str();
+		}
+		ofstream damaged(snapshot, ios::binary | ios::trunc);
+		damaged.write(data.data(), data.size() / 2);
+		damaged.close();
+		HumdrumFile reparsed;
+		reparsed.setReadAnalyses(analyses);
+		reparsed.read(filename);
+		check(describeFile(reparsed) == expected, filename,
+				"file read after damaged snapshot does not match");
+
+		HumSnapshot::setCacheDirectory("");
+		double parseMs = averageReadTime(filename, analyses, count);
+		HumSnapshot::setCacheDirectory(directory);
+		double loadMs = averageReadTime(filename, analyses, count);
+		cout << filename
+		     << "\tparseMs=" << parseMs
+		     << "\tsnapshotMs=" << loadMs
+		     << "\tsnapshotBytes=" << data.size()
+		     << endl;
+		remove(snapshot.c_str());
+		remove(HumSnapshot::getCacheFilename(key, HumFileAnalysis::ReadDefault).c_str());
+	}
+	remove(directory);
+	return status;
+}
@@ -0,0 +1,97 @@
+// Description: Check that HumdrumFileStream splits input files with
+//              !!!!SEGMENT: lines into the same files as reading each
+//              segment separately with HumdrumFile::readString(), and
+//              time reading the segments through the stream.
+//
+// Usage:       test-stream file.krn [file2.krn ...]
+
+#include "humlib.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+using namespace hum;
+using namespace std;
+
+
+// splitSegments: Split file contents at lines starting with !!!!SEGMENT:
+//     (the segment line is kept at the start of its segment).  Lines which
+//     are not Humdrum records, such as before the first exclusive
+//     interpretation or after a spine terminator, are file names for
+//     HumdrumFileStream, so they are not part of the segment.
+static void splitSegments(const string& contents, vector<string>& segments) {
+	segments.clear();
+	istringstream input(contents);
+	string line;
+	bool starstar = false;
+	bool starminus = false;
+	while (getline(input, line)) {
+		if ((line.compare(0, 12, "!!!!SEGMENT:") == 0) || segments.empty()) {
+			segments.emplace_back();
+			starstar = false;
+			starminus = false;
+		}
+		if (line.compare(0, 2, "**") == 0) {
+			starstar = true;
+		} else if (line.compare(0, 2, "*-") == 0) {
+			starminus = true;
+		}
+		if ((starminus || !starstar) && !line.empty() && (line[0] != '*') &&
+				(line[0] != '!') && (line[0] != ' ')) {
+			continue;
+		}
+		segments.back() += line;
+		segments.back() += "\n";
+	}
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.process(argc, argv);
+
+	int status = 0;
+	for (int i=1; i<=options.getArgCount(); i++) {
+		string filename = options.getArg(i);
+		ifstream input(filename);
+		stringstream contents;
+		contents << input.rdbuf();
+		vector<string> segments;
+		splitSegments(contents.str(), segments);
+
+		vector<string> list(1, filename);
+		HumdrumFileStream instream(list);
+		HumdrumFile infile;
+		int count = 0;
+		auto start = chrono::steady_clock::now();
+		while (instream.read(infile)) {
+			if (count < (int)segments.size()) {
+				HumdrumFile expected;
+				expected.readString(segments[count]);
+				stringstream actualtext;
+				stringstream expectedtext;
+				actualtext << infile;
+				expectedtext << expected;
+				if (actualtext.str() != expectedtext.str()) {
+					cerr << filename << ": segment " << (count+1)
+					     << " does not match" << endl;
+					status = 1;
+				}
+			}
+			count++;
+		}
+		auto stop = chrono::steady_clock::now();
+		if (count != (int)segments.size()) {
+			cerr << filename << ": read " << count << " segments, expected "
+			     << segments.size() << endl;
+			status = 1;
+		}
+
+		cout << filename
+		     << "\tsegments=" << count
+		     << "\tms=" << chrono::duration<double, milli>(stop - start).count()
+		     << endl;
+	}
+	return status;
+}
@@ -0,0 +1,185 @@
+// Description: Check that HumSubtokens gives the same sub-tokens as
+//              HumdrumToken::getSubtoken() and that the string_view
+//              versions of the Convert pitch and rhythm functions give the
+//              same results as before, then decode the notes of a
+//              generated score of chords by copying sub-tokens into strings
+//              and by using views.  The number of memory allocations and
+//              the time per decoded note are printed for each method.
+//
+// Usage:       test-subtokens [-m measures]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+#include <cstdlib>
+
+using namespace hum;
+using namespace std;
+
+static long allocations = 0;
+
+
+// Count all memory allocations made by the program.
+void* operator new(size_t size) {
+	allocations++;
+	void* output = malloc(size ? size : 1);
+	if (!output) {
+		throw bad_alloc();
+	}
+	return output;
+}
+
+void operator delete(void* pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	free(pointer);
+}
+
+
+// generateFile: Return a two-voice score of chords with between one
+//     and five notes which have articulations and beams.  Both voices
+//     have the same rhythm on each line.
+static string generateFile(mt19937& random, int measures) {
+	static vector<string> pitches = {"C", "E-", "G", "c", "d#", "f", "a-", "b",
+			"cc", "ee", "gg#", "ccc"};
+	static vector<string> rhythms = {"4", "8", "4.", "16", "2", "8."};
+	static vector<string> suffixes = {"", "'", "L", "J", "^/", "`LL", "';/"};
+	stringstream output;
+	output << "**kern\t**kern\n*M4/4\t*M4/4\n";
+	for (int m=1; m<=measures; m++) {
+		output << "=" << m << "\t=" << m << "\n";
+		for (int i=0; i<4; i++) {
+			string rhythm = pick(random, rhythms);
+			for (int v=0; v<2; v++) {
+				int count = 1 + random() % 5;
+				string suffix = pick(random, suffixes);
+				output << (v ? "\t" : "");
+				for (int k=0; k<count; k++) {
+					output << (k ? " " : "") << rhythm
+					       << pick(random, pitches) << suffix;
+				}
+			}
+			output << "\n";
+		}
+	}
+	output << "==\t==\n*-\t*-\n";
+	return output.str();
+}
+
+
+// checkSubtokens: Compare HumSubtokens with HumdrumToken::getSubtoken().
+static void checkSubtokens(const string& text, const string& separator) {
+	HumdrumToken token(text);
+	HumSubtokens subtokens(token, separator);
+	int count = token.getSubtokenCount(separator);
+	check(subtokens.getCount() == count, "wrong count for \"" + text + "\"");
+	int index = 0;
+	for (string_view subtoken : subtokens) {
+		check(string(subtoken) == token.getSubtoken(index, separator),
+				"wrong sub-token " + to_string(index) + " for \"" + text + "\"");
+		check(subtokens.getSubtoken(index) == subtoken,
+				"wrong indexed sub-token for \"" + text + "\"");
+		index++;
+	}
+	check(index == count, "wrong number of iterations for \"" + text + "\"");
+	check(subtokens.getSubtoken(count).empty(), "sub-token after end for \"" + text + "\"");
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("m|measures=i:4000", "number of measures in generated score");
+	options.process(argc, argv);
+
+	vector<string> texts = {"", " ", "4c", "4c 4e 4g", " 4c", "4c ", "4c  4e",
+			"4c;4e", "4cc#L 8.dd-J"};
+	for (auto& text : texts) {
+		checkSubtokens(text, " ");
+		checkSubtokens(text, ";");
+		checkSubtokens(text, "  ");
+	}
+	HumdrumToken chord("4c 4e 4g");
+	check(chord.getSubtokens() == vector<string>({"4c", "4e", "4g"}), "wrong getSubtokens()");
+	check(HumSubtokens("4c").front() == "4c", "wrong front()");
+
+	// Convert functions:
+	check(Convert::kernToBase40("4c") == 162, "kernToBase40(\"4c\")");
+	check(Convert::kernToBase40("  4cc#L \n") == 203, "kernToBase40 with spaces");
+	check(Convert::kernToBase40("4c 4e") == 162, "kernToBase40 of chord");
+	check(Convert::kernToBase40("4r") == -1000, "kernToBase40 of rest");
+	check(Convert::kernToBase12("4B-") == 46, "kernToBase12(\"4B-\")");
+	check(Convert::kernToDiatonicPC("8.a") == 5, "kernToDiatonicPC");
+	check(Convert::kernToAccidentalCount("4e--") == -2, "kernToAccidentalCount");
+	check(Convert::kernToOctaveNumber("4CC") == 2, "kernToOctaveNumber");
+	check(Convert::kernToOctaveNumber(".") == -1000, "kernToOctaveNumber of null");
+	check(Convert::recipToDuration("4.c 8d") == HumNum(3, 2), "recipToDuration of chord");
+	check(Convert::recipToDuration("3%2") == HumNum(8, 3), "recipToDuration(\"3%2\")");
+	check(Convert::recipToDuration("00") == 16, "recipToDuration(\"00\")");
+	check(Convert::recipToDuration("8qc") == 0, "recipToDuration of grace note");
+	check(Convert::recipToDuration("4;8", 1, ";") == HumNum(1, 4), "recipToDuration separator");
+	check(Convert::mensToDuration("Sp") == 12, "mensToDuration(\"Sp\")");
+	check(Convert::mensToDurationNoDots("Sp") == 8, "mensToDurationNoDots(\"Sp\")");
+	HTp token = &chord;
+	check(Convert::kernToBase40(token) == 162, "kernToBase40 of token");
+
+	// Decode the notes of a score:
+	mt19937 random(1);
+	HumdrumFile infile;
+	infile.readString(generateFile(random, options.getInteger("measures")));
+	vector<HTp> tokens;
+	for (int i=0; i<infile.getLineCount(); i++) {
+		for (int j=0; j<infile[i].getFieldCount(); j++) {
+			if (infile.token(i, j)->isData()) {
+				tokens.push_back(infile.token(i, j));
+			}
+		}
+	}
+
+	// Sub-tokens copied into strings:
+	long copysum = 0;
+	int notes = 0;
+	long start = allocations;
+	auto time1 = chrono::steady_clock::now();
+	for (HTp tok : tokens) {
+		for (auto& note : tok->getSubtokens()) {
+			copysum += Convert::kernToBase40(Convert::trimWhiteSpace(note));
+			copysum += Convert::recipToDuration(note.substr(0, note.find(' '))).getNumerator();
+			notes++;
+		}
+	}
+	auto time2 = chrono::steady_clock::now();
+	long copyallocs = allocations - start;
+
+	// Sub-tokens as views:
+	long viewsum = 0;
+	int viewnotes = 0;
+	start = allocations;
+	for (HTp tok : tokens) {
+		for (string_view note : tok->getSubtokenViews()) {
+			viewsum += Convert::kernToBase40(note);
+			viewsum += Convert::recipToDuration(note).getNumerator();
+			viewnotes++;
+		}
+	}
+	auto time3 = chrono::steady_clock::now();
+	long viewallocs = allocations - start;
+
+	check(viewsum == copysum, "views and copies decode different notes");
+	check(viewnotes == notes, "views and copies find different numbers of notes");
+	check(viewallocs == 0, "decoding views allocated memory " + to_string(viewallocs)
+			+ " times");
+
+	cout << "notes=" << notes
+	     << "\tcopyAllocsPerNote=" << (double)copyallocs / notes
+	     << "\tviewAllocsPerNote=" << (double)viewallocs / notes
+	     << "\tcopyNsPerNote=" << chrono::duration<double, nano>(time2 - time1).count() / notes
+	     << "\tviewNsPerNote=" << chrono::duration<double, nano>(time3 - time2).count() / notes
+	     << endl;
+	return status;
+}
+
+
+
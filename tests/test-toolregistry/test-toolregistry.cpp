@@ -0,0 +1,130 @@
+// Description: Check the list of tools in HumToolRegistry, check that a
+//              tool which is reset after running on one file gives the same
+//              results on a second file as a new instance of the tool, and
+//              time creating tools compared to resetting them.
+//
+// Usage:       test-toolregistry [-n count] file.krn [file2.krn ...]
+
+#include "humlib.h"
+#include "../test-common.h"
+
+#include <chrono>
+
+using namespace hum;
+using namespace std;
+
+// Commands run first (to leave options and data in the tool), followed by
+// the commands which are compared between reset and new tools:
+static vector<pair<string, string>> commands = {
+	{ "autobeam -r",       "autobeam" },
+	{ "autostem -r",       "autostem" },
+	{ "transpose -t M2",   "transpose -t m3" },
+	{ "extract -f 1",      "extract -s 1" },
+	{ "recip -c",          "recip" },
+	{ "thru -v x",         "thru" },
+	{ "tie -s",            "tie -m" },
+	{ "deg -t",            "deg" },
+	{ "tandeminfo -c",     "tandeminfo" },
+	{ "filter -R",         "filter" }
+};
+
+
+// runTool: Run a tool on a copy of the file and return all of its output.
+static string runTool(const HumToolRegistry::Entry& entry, HumTool* tool,
+		const string& text, const string& command) {
+	HumdrumFile infile;
+	infile.readString(text);
+	tool->process(command);
+	try {
+		entry.run(tool, infile);
+	} catch (exception& e) {
+		return command + ": " + e.what() + "\n";
+	}
+	return tool->getAllText() + tool->getError();
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	options.define("n|count=i:1000", "number of runs for timing");
+	options.process(argc, argv);
+	int count = options.getInteger("count");
+
+	// Every name in the list is found, and aliases point to their tools:
+	vector<string> names = HumToolRegistry::getToolNames();
+	vector<string> allnames = HumToolRegistry::getToolNames(true);
+	check(names.size() > 50, "too few tools in the registry");
+	check(allnames.size() > names.size(), "no aliases in the registry");
+	for (auto& name : allnames) {
+		const HumToolRegistry::Entry* entry = HumToolRegistry::getEntry(name);
+		check(entry != NULL, "missing entry for " + name);
+		if (entry) {
+			HumTool* tool = entry->create();
+			check(tool != NULL, "cannot create " + name);
+			delete tool;
+		}
+	}
+	check(!HumToolRegistry::isTool("no-such-tool"), "unknown tool found");
+	check(HumToolRegistry::getEntry("thruxx")->tool == "thru", "thruxx is not thru");
+	check(HumToolRegistry::getAliases("thru").size() == 2, "thru should have two aliases");
+
+	// Tools which own memory through pointers can be reset:
+	const HumToolRegistry::Entry& simatEntry = *HumToolRegistry::getEntry("simat");
+	string simatData = "**kern\t**kern\n=1\t=1\n4c\t4e\n=2\t=2\n4d\t4f\n*-\t*-\n";
+	HumTool* simat = simatEntry.create();
+	string simatOutput = runTool(simatEntry, simat, simatData, "simat");
+	simatEntry.reset(simat);
+	check(runTool(simatEntry, simat, simatData, "simat") == simatOutput,
+			"simat output differs after reset");
+	delete simat;
+
+	// A reset tool gives the same output as a new tool:
+	for (int i=1; i<=options.getArgCount(); i++) {
+		HumdrumFile infile(options.getArg(i));
+		stringstream text;
+		text << infile;
+		for (auto& command : commands) {
+			string name = command.first.substr(0, command.first.find(' '));
+			const HumToolRegistry::Entry* entry = HumToolRegistry::getEntry(name);
+			HumTool* tool = entry->create();
+			runTool(*entry, tool, text.str(), command.first);
+			entry->reset(tool);
+			string result = runTool(*entry, tool, text.str(), command.second);
+			delete tool;
+			HumTool* newtool = entry->create();
+			string expected = runTool(*entry, newtool, text.str(), command.second);
+			delete newtool;
+			check(result == expected, options.getArg(i) + ": \"" + command.second +
+					"\" output differs after reset");
+		}
+	}
+
+	// Time creating and resetting each tool:
+	double createMs = 0.0;
+	double resetMs = 0.0;
+	for (auto& name : names) {
+		const HumToolRegistry::Entry* entry = HumToolRegistry::getEntry(name);
+		auto start = chrono::steady_clock::now();
+		for (int i=0; i<count; i++) {
+			HumTool* tool = entry->create();
+			tool->process(name);
+			delete tool;
+		}
+		auto middle = chrono::steady_clock::now();
+		HumTool* tool = entry->create();
+		for (int i=0; i<count; i++) {
+			entry->reset(tool);
+			tool->process(name);
+		}
+		delete tool;
+		auto stop = chrono::steady_clock::now();
+		createMs += chrono::duration<double, milli>(middle - start).count();
+		resetMs += chrono::duration<double, milli>(stop - middle).count();
+	}
+	cout << "tools=" << names.size()
+	     << "\tnames=" << allnames.size()
+	     << "\tcreateUs=" << 1000.0 * createMs / count / names.size()
+	     << "\tresetUs=" << 1000.0 * resetMs / count / names.size()
+	     << endl;
+	return status;
+}